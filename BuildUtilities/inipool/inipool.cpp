@@ -52,14 +52,20 @@ int main(int argc, char* argv[])
  *   %s %s %s\n\
  */\n\
 \n\
-#include <string.h>\n\
+#include <algorithm>\n\
 #include \"%s\"\n\
 \n\
 \n\
 extern %s %s;\n\
 #define PROG %s\n\
 \n\
-static const char* poolfilearr[] = {\n",
+struct PoolString\n\
+{\n\
+  const char* chars;\n\
+  int length;\n\
+};\n\
+\n\
+static constexpr PoolString poolStrings[] = {\n",
         argv[0],
         filename,
         headername,
@@ -68,6 +74,7 @@ static const char* poolfilearr[] = {\n",
         progname,
         progname);
     char data[1024];
+    int totalLength = 0;
     while (fgets(data, 1024, fh))
     {
         int len = strlen(data);
@@ -89,7 +96,7 @@ static const char* poolfilearr[] = {\n",
         {
             o = 2;
         }
-        printf("  \"");
+        printf("  { \"");
         for (int i = o; i < len; i++)
         {
             if (data[i] == '"' || data[i] == '\\')
@@ -102,42 +109,39 @@ static const char* poolfilearr[] = {\n",
             }
             putchar(data[i]);
         }
-        printf("\",\n");
+        printf("\", %d },\n", len - o);
+        totalLength += len - o;
     }
     fclose(fh);
+    // the lengths are known here: loading the strings is a matter of
+    // copying them into the pool
     printf("\
-  nullptr\n\
+  { \"\", -1 }\n\
 };\n\
 \n\
+constexpr int poolTotalLength = %d;\n\
+\n\
 int miktexloadpoolstrings(int poolSize)\n\
 {\n\
-  const char* lpsz;\n\
-  int g = 0;\n\
-  int size = 0;\n\
-  for (int idx = 0; (lpsz = poolfilearr[idx]) != nullptr; ++idx)\n\
+  if (poolTotalLength >= poolSize)\n\
   {\n\
-    int len = strlen(lpsz);\n\
-    size += len;\n\
-    if (size >= poolSize)\n\
-    {\n\
-      return 0;\n\
-    }\n");
+    return 0;\n\
+  }\n\
+  int g = 0;\n\
+  for (const PoolString* ps = poolStrings; ps->length >= 0; ++ps)\n\
+  {\n", totalLength);
     if (is_luatex)
     {
         printf("\
-    while (len-- > 0)\n\
-    {\n\
-      PROG.str_pool[PROG.pool_ptr++] = *lpsz++;\n\
-    }\n\
+    std::copy(ps->chars, ps->chars + ps->length, &PROG.str_pool[PROG.pool_ptr]);\n\
+    PROG.pool_ptr += ps->length;\n\
     g = PROG.make_string();\n");
     }
     else
     {
         printf("\
-    while (len-- > 0)\n\
-    {\n\
-      PROG.strpool[PROG.poolptr++] = *lpsz++;\n\
-    }\n\
+    std::copy(ps->chars, ps->chars + ps->length, &PROG.strpool[PROG.poolptr]);\n\
+    PROG.poolptr += ps->length;\n\
     g = PROG.makestring();\n");
     }
     if (is_metapost || is_metafont)
@@ -41,6 +41,7 @@
 #include <windows.h>
 #endif
 
+#include <algorithm>
 #include <future>
 #include <iomanip>
 #include <iostream>
@@ -48,6 +49,8 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <unordered_map>
 
@@ -265,10 +268,12 @@ void FindDuplicateFiles(const set<string>& setstr)
     {
         return;
     }
+    vector<PathName> paths(setstr.begin(), setstr.end());
+    vector<MD5> digests = MD5::FromFiles(paths, max(thread::hardware_concurrency(), 1u));
     MD5ToFileName mapMd5sumToFn;
-    for (const string& s : setstr)
+    for (size_t idx = 0; idx < paths.size(); ++idx)
     {
-        mapMd5sumToFn.insert(make_pair(MD5::FromFile(PathName(s)), s));
+        mapMd5sumToFn.insert(make_pair(digests[idx], paths[idx].ToString()));
     }
     MD5 md5Last;
     set<string> setstrFiles;
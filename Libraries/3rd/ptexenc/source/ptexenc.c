@@ -645,6 +645,20 @@ int fputs2(const char *s, FILE *fp)
 }
 
 
+#if defined(MIKTEX)
+/* input_line2() locks the stream once per line; getc4() reads straight from
+   the stdio buffer */
+#if defined(_MSC_VER)
+#define LOCK_STREAM(fp) _lock_file(fp)
+#define UNLOCK_STREAM(fp) _unlock_file(fp)
+#define GETC_UNLOCKED(fp) _getc_nolock(fp)
+#else
+#define LOCK_STREAM(fp) flockfile(fp)
+#define UNLOCK_STREAM(fp) funlockfile(fp)
+#define GETC_UNLOCKED(fp) getc_unlocked(fp)
+#endif
+#endif
+
 static struct unget_st {
     int size;
     int buff[4];
@@ -694,8 +708,12 @@ static int getc4(FILE *fp)
         if (BYTE2(c) != 0) p->buff[p->size++]=BYTE2(c);
         if (BYTE1(c) != 0) p->buff[p->size++]=BYTE1(c);
     }
+#else
+#if defined(MIKTEX)
+        return GETC_UNLOCKED(fp);
 #else
         return getc(fp);
+#endif
 #endif
     return p->buff[--p->size];
 }
@@ -1134,6 +1152,10 @@ long input_line2(FILE *fp, unsigned char *buff, unsigned char *buff2,
     buffer = buff;
     first = last = pos;
 
+#if defined(MIKTEX)
+    LOCK_STREAM(fp);
+#endif
+
     if (infile_enc[fd] == ENC_UNKNOWN) { /* just after opened */
         ungetbuff[fd].size = 0;
         if (isUTF8Nstream(fp)) {
@@ -1238,6 +1260,10 @@ long input_line2(FILE *fp, unsigned char *buff, unsigned char *buff2,
         }
     }
 
+#if defined(MIKTEX)
+    UNLOCK_STREAM(fp);
+#endif
+
     if (i != EOF || first != last) buffer[last] = '\0';
     if (i == EOF || i == '\n' || i == '\r') injis = false;
     if (lastchar != NULL) *lastchar = i;
@@ -255,7 +255,11 @@ int JIStoUCS2(int jis)
 }
 
 /* convert a UCS-2 char to JIS X 0208 */
+#if defined(MIKTEX)
+static int UCS2toJISscan(int ucs2)
+#else
 int UCS2toJIS(int ucs2)
+#endif
 {
     int i, j;
 
@@ -270,6 +274,23 @@ int UCS2toJIS(int ucs2)
     return UCS2toJISnative(ucs2);
 }
 
+#if defined(MIKTEX)
+/* both tables are scanned linearly for each character: the results are
+   memoized */
+int UCS2toJIS(int ucs2)
+{
+    static unsigned short jis[0x10000];
+    static unsigned char known[0x10000 / 8];
+
+    if (ucs2 < 0 || ucs2 >= 0x10000) return UCS2toJISscan(ucs2);
+    if ((known[ucs2 >> 3] & (1 << (ucs2 & 7))) == 0) {
+        jis[ucs2] = (unsigned short)UCS2toJISscan(ucs2);
+        known[ucs2 >> 3] |= 1 << (ucs2 & 7);
+    }
+    return jis[ucs2];
+}
+#endif
+
 
 /* for U+3099 or U+309A */
 int get_voiced_sound(int ucs2, boolean semi)
@@ -51,6 +51,7 @@ set(liblzma_sources
     ${CMAKE_CURRENT_SOURCE_DIR}/source/src/liblzma/common/stream_buffer_decoder.c
     ${CMAKE_CURRENT_SOURCE_DIR}/source/src/liblzma/common/stream_buffer_encoder.c
     ${CMAKE_CURRENT_SOURCE_DIR}/source/src/liblzma/common/stream_decoder.c
+    ${CMAKE_CURRENT_SOURCE_DIR}/source/src/liblzma/common/stream_decoder_mt.c
     ${CMAKE_CURRENT_SOURCE_DIR}/source/src/liblzma/common/stream_encoder.c
     ${CMAKE_CURRENT_SOURCE_DIR}/source/src/liblzma/common/stream_encoder_mt.c
     ${CMAKE_CURRENT_SOURCE_DIR}/source/src/liblzma/common/stream_flags_common.c
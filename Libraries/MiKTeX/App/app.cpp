@@ -13,6 +13,7 @@
 
 #include "config.h"
 
+#include <chrono>
 #include <csignal>
 #include <cstdlib>
 #include <ctime>
@@ -42,6 +43,8 @@
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Cfg>
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/Directory>
+#include <miktex/Core/Environment>
 #include <miktex/Core/Exceptions>
 #include <miktex/Core/File>
 #include <miktex/Core/FileType>
@@ -126,6 +129,7 @@ public:
     bool initialized = false;
     shared_ptr<PackageInstaller> installer;
     log4cxx::LoggerPtr logger;
+    bool maintenanceWorker = false;
     TriState mpmAutoAdmin = TriState::Undetermined;
     shared_ptr<PackageManager> packageManager;
     vector<TraceCallback::TraceMessage> pendingTraceMessages;
@@ -225,6 +229,18 @@ template<typename T> void ExamineArgs(vector<T>& args, Session::InitInfo& initIn
         {
             pimpl->enableDiagnose = TriState::True;
         }
+        else if (strcmp(*it, "--miktex-maintenance-worker") == 0)
+        {
+            pimpl->maintenanceWorker = true;
+        }
+        else if (strcmp(*it, "--miktex-io-report") == 0 || strncmp(*it, "--miktex-io-report=", 19) == 0)
+        {
+            // the sessions of this process and of the child processes append
+            // their I/O statistics to the report file
+            PathName reportFile((*it)[18] == '=' ? *it + 19 : "miktex-io-report.jsonl");
+            reportFile.MakeFullyQualified();
+            Utils::SetEnvironmentString(MIKTEX_ENV_IO_REPORT_FILE, reportFile.ToString());
+        }
         else
         {
             keepArgument = true;
@@ -321,6 +337,12 @@ void Application::AutoMaintenance()
         throw 1;
     }
 
+    if (!pimpl->maintenanceWorker && pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_BACKGROUND_MAINTENANCE, ConfigValue(false)).GetBool())
+    {
+        StartMaintenanceWorker();
+        return;
+    }
+
     // must refresh FNDB if:
     //   (1) it doesn't exist
     //   (2) in user mode and an admin just modified the MiKTeX configuration
@@ -426,6 +448,74 @@ void Application::AutoMaintenance()
 constexpr time_t ONE_DAY = 86400;
 constexpr time_t ONE_WEEK = 7 * ONE_DAY;
 
+void Application::StartMaintenanceWorker()
+{
+    // the stamp file records the last check: until the check interval has
+    // elapsed (or an admin has done maintenance), a program only looks at the
+    // time stamp of this file
+    time_t now = time(nullptr);
+    time_t lastAdminMaintenance = pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE, ConfigValue("0")).GetTimeT();
+    time_t checkInterval = pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_MAINTENANCE_CHECK_INTERVAL, ConfigValue(static_cast<int>(ONE_DAY / 24))).GetInt();
+    PathName stampFile = pimpl->session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_AUTO_MAINTENANCE_STAMP;
+    if (File::Exists(stampFile))
+    {
+        time_t lastCheck = File::GetLastWriteTime(stampFile);
+        if (lastCheck <= now && now < lastCheck + checkInterval && lastCheck >= lastAdminMaintenance)
+        {
+            return;
+        }
+    }
+    try
+    {
+        PathName stampDir = stampFile;
+        stampDir.RemoveFileSpec();
+        if (!Directory::Exists(stampDir))
+        {
+            Directory::Create(stampDir);
+        }
+        File::WriteBytes(stampFile, {});
+        // the worker does what AutoMaintenance() and AutoDiagnose() would do;
+        // the auto-maintenance lock keeps concurrent workers from doing the
+        // same work
+        PathName myProgramFile = pimpl->session->GetMyProgramFile(true);
+        vector<string> args{ myProgramFile.GetFileNameWithoutExtension().ToString(), "--miktex-maintenance-worker" };
+        switch (pimpl->enableInstaller)
+        {
+        case TriState::False:
+            args.push_back("--miktex-disable-installer");
+            break;
+        case TriState::True:
+            args.push_back("--miktex-enable-installer");
+            break;
+        case TriState::Undetermined:
+            break;
+        }
+        if (pimpl->session->IsAdminMode())
+        {
+            args.push_back("--miktex-admin");
+        }
+        LOG4CXX_INFO(pimpl->logger, "starting background maintenance: " << CommandLineBuilder(args).ToString());
+        Process::Start(myProgramFile, args);
+    }
+    catch (const MiKTeXException& ex)
+    {
+        LogWarn("background maintenance could not be started: " + ex.GetErrorMessage());
+    }
+}
+
+void Application::RunMaintenanceWorker()
+{
+    pimpl->beQuiet = true;
+    AutoMaintenance();
+    time_t now = time(nullptr);
+    PathName issuesJson = pimpl->session->GetSpecialPath(SpecialPath::ConfigRoot) / MIKTEX_PATH_ISSUES_JSON;
+    if (!File::Exists(issuesJson) || now > File::GetLastWriteTime(issuesJson) + ONE_WEEK)
+    {
+        LOG4CXX_INFO(pimpl->logger, "looking for issues");
+        MiKTeX::Setup::SetupService::Create()->FindIssues(false, false);
+    }
+}
+
 void Application::AutoDiagnose()
 {
     time_t now = time(nullptr);
@@ -434,7 +524,17 @@ void Application::AutoDiagnose()
     auto setupService = MiKTeX::Setup::SetupService::Create();
     if (!File::Exists(issuesJson) || now > File::GetLastWriteTime(issuesJson) + ONE_WEEK)
     {
-        issues = setupService->FindIssues(false, false);
+        if (pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_BACKGROUND_MAINTENANCE, ConfigValue(false)).GetBool())
+        {
+            // report what has been found last time, and let the worker look
+            // for issues
+            issues = setupService->GetIssues();
+            StartMaintenanceWorker();
+        }
+        else
+        {
+            issues = setupService->FindIssues(false, false);
+        }
     }
     else
     {
@@ -524,6 +624,11 @@ void Application::Init(const Session::InitInfo& initInfoArg)
     {
         SecurityRisk(T_("running with elevated privileges"));
     }
+    if (pimpl->maintenanceWorker)
+    {
+        RunMaintenanceWorker();
+        throw 0;
+    }
     if (pimpl->enableMaintenance == TriState::True)
     {
         AutoMaintenance();
@@ -707,6 +812,7 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
     {
         pimpl->session->SetAdminMode(true);
     }
+    auto start = chrono::system_clock::now();
     try
     {
         pimpl->installer->InstallRemove(PackageInstaller::Role::Application);
@@ -722,6 +828,7 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
         LOG4CXX_FATAL(pimpl->logger, "Source: " << ex.GetSourceFile());
         LOG4CXX_FATAL(pimpl->logger, "Line: " << ex.GetSourceLine());
     }
+    pimpl->session->AddBuildTraceSpan("install", packageId, start, chrono::system_clock::now());
     if (switchToAdminMode)
     {
         pimpl->session->SetAdminMode(false);
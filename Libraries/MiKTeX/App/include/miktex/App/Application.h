@@ -256,6 +256,8 @@ private:
     void ConfigureLogging();
     void AutoMaintenance();
     void AutoDiagnose();
+    void StartMaintenanceWorker();
+    void RunMaintenanceWorker();
 
     class impl;
     std::unique_ptr<impl> pimpl;
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX configuration file parsing
  *
- * @copyright Copyright © 1996-2023 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -14,13 +14,17 @@
 #include "config.h"
 
 #include <fstream>
+#include <iterator>
+#include <string_view>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/Cfg>
+#include <miktex/Core/File>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/MemoryMappedFile>
 #include <miktex/Trace/StopWatch>
 #include <miktex/Trace/Trace>
 #include <miktex/Util/PathName>
@@ -45,25 +49,22 @@ constexpr const char* COMMENT2 = ";;";
 constexpr const char* COMMENT3 = ";;;";
 constexpr const char* COMMENT4 = ";;;;";
 
-MIKTEXSTATICFUNC(string) Trim(const string& str)
+MIKTEXSTATICFUNC(string_view) TrimView(string_view str)
 {
-    string result = str;
     constexpr const char* WHITESPACE = " \t\r\n";
-    size_t pos = result.find_last_not_of(WHITESPACE);
-    if (pos != string::npos)
-    {
-        result.erase(pos + 1);
-    }
-    pos = result.find_first_not_of(WHITESPACE);
-    if (pos == string::npos)
-    {
-        result.erase();
-    }
-    else if (pos != 0)
+    size_t pos = str.find_first_not_of(WHITESPACE);
+    if (pos == string_view::npos)
     {
-        result.erase(0, pos);
+        return string_view();
     }
-    return result;
+    str.remove_prefix(pos);
+    str.remove_suffix(str.length() - str.find_last_not_of(WHITESPACE) - 1);
+    return str;
+}
+
+MIKTEXSTATICFUNC(string) Trim(const string& str)
+{
+    return string(TrimView(str));
 }
 
 Cfg::Value::~Value() noexcept
@@ -89,6 +90,15 @@ public:
     {
     }
 
+    CfgValue(string&& name, const string& lookupName, string&& value, string&& documentation, bool isCommentedOut) :
+        commentedOut(isCommentedOut),
+        documentation(std::move(documentation)),
+        lookupName(lookupName),
+        name(std::move(name))
+    {
+        this->value.push_back(std::move(value));
+    }
+
     ~CfgValue() noexcept override
     {
     }
@@ -585,6 +595,7 @@ private:
 
     void Read(const PathName& path, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
     void Read(std::istream& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
+    void Parse(string_view text, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
 
     enum PutMode {
         None,
@@ -592,7 +603,7 @@ private:
         SearchPathAppend
     };
 
-    bool ParseValueDefinition(const string& line, string& valueName, string& value, PutMode& putMode);
+    bool ParseValueDefinition(string_view line, string& valueName, string& value, PutMode& putMode);
 
     void Walk(WalkCallback* callback) const;
 
@@ -602,7 +613,9 @@ private:
 
     void WriteKeys(ostream& stream);
 
-    void PutValue(const string& keyName, const string& valueName, string&& value, PutMode putMode, string&& documentation, bool commentedOut);
+    CfgKey& GetOrCreateKey(const string& keyName);
+
+    void PutValue(CfgKey& key, string&& valueName, string&& value, PutMode putMode, string&& documentation, bool commentedOut);
 
     PathName currentFile;
     KeyMap keyMap;
@@ -765,7 +778,7 @@ bool CfgImpl::TryGetValueAsStringVector(const string& keyName, const string& val
     return true;
 }
 
-void CfgImpl::PutValue(const string& keyName_, const string& valueName, string&& value, CfgImpl::PutMode putMode, string&& documentation, bool commentedOut)
+CfgKey& CfgImpl::GetOrCreateKey(const string& keyName_)
 {
     string keyName = keyName_.empty() ? GetDefaultKeyName() : keyName_;
     if (keyName.empty())
@@ -773,64 +786,71 @@ void CfgImpl::PutValue(const string& keyName_, const string& valueName, string&&
         MIKTEX_UNEXPECTED();
     }
     string lookupKeyName = Utils::MakeLower(keyName);
-    pair<KeyMap::iterator, bool> pair1 = keyMap.insert(make_pair(lookupKeyName, make_shared<CfgKey>(keyName, lookupKeyName)));
-
-    KeyMap::iterator itKey = pair1.first;
-    MIKTEX_ASSERT(itKey != keyMap.end());
+    KeyMap::iterator itKey = keyMap.find(lookupKeyName);
+    if (itKey == keyMap.end())
+    {
+        shared_ptr<CfgKey> key = make_shared<CfgKey>(keyName, lookupKeyName);
+        itKey = keyMap.emplace(std::move(lookupKeyName), std::move(key)).first;
+    }
+    return *itKey->second;
+}
 
+void CfgImpl::PutValue(CfgKey& key, string&& valueName, string&& value, CfgImpl::PutMode putMode, string&& documentation, bool commentedOut)
+{
     string lookupValueName = Utils::MakeLower(valueName);
-    if (options[Option::NoOverwriteValues] && itKey->second->valueMap.find(lookupValueName) != itKey->second->valueMap.end())
+    ValueMap::iterator itVal = key.valueMap.find(lookupValueName);
+    if (itVal == key.valueMap.end())
     {
+        shared_ptr<CfgValue> cfgValue = make_shared<CfgValue>(std::move(valueName), lookupValueName, std::move(value), std::move(documentation), commentedOut);
+        key.valueMap.emplace(std::move(lookupValueName), std::move(cfgValue));
         return;
     }
-    pair<ValueMap::iterator, bool> pair2 = itKey->second->valueMap.insert(make_pair(lookupValueName, make_shared<CfgValue>(valueName, lookupValueName, value, documentation, commentedOut)));
-
-    if (!pair2.second)
+    if (options[Option::NoOverwriteValues])
     {
-        // modify existing value
-        ValueMap::iterator itVal = pair2.first;
-        if (itVal->second->IsMultiValue() && putMode != None)
-        {
-            MIKTEX_UNEXPECTED();
-        }
-        itVal->second->documentation = std::move(documentation);
-        itVal->second->commentedOut = commentedOut;
-        if (putMode == Append)
+        return;
+    }
+    // modify existing value
+    if (itVal->second->IsMultiValue() && putMode != None)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    itVal->second->documentation = std::move(documentation);
+    itVal->second->commentedOut = commentedOut;
+    if (putMode == Append)
+    {
+        if (itVal->second->value.empty())
         {
-            if (itVal->second->value.empty())
-            {
-                itVal->second->value.push_back(std::move(value));
-            }
-            else
-            {
-                itVal->second->value.front() += std::move(value);
-            }
+            itVal->second->value.push_back(std::move(value));
         }
-        else if (putMode == SearchPathAppend)
+        else
         {
-            if (itVal->second->value.empty())
-            {
-                itVal->second->value.push_back(std::move(value));
-            }
-            else
-            {
-                if (!itVal->second->value.front().empty())
-                {
-                    itVal->second->value.front() += PathNameUtil::PathNameDelimiter;
-                }
-                itVal->second->value.front() += std::move(value);
-            }
+            itVal->second->value.front() += std::move(value);
         }
-        else if (itVal->second->IsMultiValue())
+    }
+    else if (putMode == SearchPathAppend)
+    {
+        if (itVal->second->value.empty())
         {
             itVal->second->value.push_back(std::move(value));
         }
         else
         {
-            itVal->second->value.clear();
-            itVal->second->value.push_back(std::move(value));
+            if (!itVal->second->value.front().empty())
+            {
+                itVal->second->value.front() += PathNameUtil::PathNameDelimiter;
+            }
+            itVal->second->value.front() += std::move(value);
         }
     }
+    else if (itVal->second->IsMultiValue())
+    {
+        itVal->second->value.push_back(std::move(value));
+    }
+    else
+    {
+        itVal->second->value.clear();
+        itVal->second->value.push_back(std::move(value));
+    }
 }
 
 bool CfgImpl::ClearValue(const string& keyName_, const string& valueName)
@@ -858,12 +878,12 @@ bool CfgImpl::ClearValue(const string& keyName_, const string& valueName)
 
 void CfgImpl::PutValue(const string& keyName, const string& valueName, const string& value)
 {
-    return PutValue(keyName, valueName, string(value), None, "", false);
+    return PutValue(GetOrCreateKey(keyName), string(valueName), string(value), None, "", false);
 }
 
 void CfgImpl::PutValue(const string& keyName, const string& valueName, const string& value, const string& documentation, bool commentedOut)
 {
-    return PutValue(keyName, valueName, string(value), None, string(documentation), commentedOut);
+    return PutValue(GetOrCreateKey(keyName), string(valueName), string(value), None, string(documentation), commentedOut);
 }
 
 void CfgImpl::Read(const PathName& path, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
@@ -872,12 +892,46 @@ void CfgImpl::Read(const PathName& path, const string& defaultKeyName, int level
     traceStream->WriteLine("core", fmt::format(T_("parsing: {0}..."), path.ToDisplayString()));
     AutoRestore<int> autoRestore1(lineno);
     AutoRestore<PathName> autoRestore(currentFile);
-    std::ifstream reader = File::CreateInputStream(path);
-    Read(reader, defaultKeyName, level, mustBeSigned, publicKeyFile);
-    reader.close();
+    // parse the file in place; mapping an empty file is an error
+    unique_ptr<MemoryMappedFile> mapping;
+    const char* data = nullptr;
+    if (File::Exists(path) && File::GetSize(path) > 0)
+    {
+        try
+        {
+            mapping.reset(MemoryMappedFile::Create());
+            data = static_cast<const char*>(mapping->Open(path, false));
+        }
+        catch (const MiKTeXException& e)
+        {
+            traceStream->WriteLine("core", TraceLevel::Warning, fmt::format(T_("{0} cannot be mapped into memory: {1}"), Q_(path), e.GetErrorMessage()));
+            data = nullptr;
+        }
+    }
+    if (data == nullptr)
+    {
+        std::ifstream reader = File::CreateInputStream(path);
+        Read(reader, defaultKeyName, level, mustBeSigned, publicKeyFile);
+        reader.close();
+        return;
+    }
+    Parse(string_view(data, mapping->GetSize()), defaultKeyName, level, mustBeSigned, publicKeyFile);
+    mapping->Close();
 }
 
 void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
+{
+    string text{ istreambuf_iterator<char>(reader), istreambuf_iterator<char>() };
+    if (reader.bad())
+    {
+        lineno = 0;
+        currentFile = path;
+        FATAL_CFG_ERROR(T_("error reading the configuration file"));
+    }
+    Parse(text, defaultKeyName, level, mustBeSigned, publicKeyFile);
+}
+
+void CfgImpl::Parse(string_view text, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
 {
     MIKTEX_ASSERT(!(level > 0 && mustBeSigned));
 
@@ -889,7 +943,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
     bool wasEmpty = Empty();
 
     string keyName = defaultKeyName;
-    string lookupKeyName = Utils::MakeLower(keyName);
+    CfgKey* key = nullptr;
     bool ignoreKey = false;
 
     lineno = 0;
@@ -897,10 +951,16 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
 
     string documentation;
 
-    for (string line; std::getline(reader, line); )
+    for (size_t pos = 0; pos < text.length(); )
     {
+        size_t endOfLine = text.find('\n', pos);
+        if (endOfLine == string_view::npos)
+        {
+            endOfLine = text.length();
+        }
+        string_view line = TrimView(text.substr(pos, endOfLine - pos));
+        pos = endOfLine + 1;
         ++lineno;
-        line = Trim(line);
         if (line.empty())
         {
             documentation = "";
@@ -908,7 +968,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         else if (line[0] == '!')
         {
             documentation = "";
-            Tokenizer tok(line.substr(1), " \t");
+            Tokenizer tok(string(line.substr(1)), " \t");
             if (!tok)
             {
                 FATAL_CFG_ERROR(T_("invalid cfg directive"));
@@ -943,14 +1003,14 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         else if (line[0] == '[')
         {
             documentation = "";
-            Tokenizer tok(line.substr(1), "]");
-            if (!tok)
+            size_t start = line.find_first_not_of(']', 1);
+            if (start == string_view::npos)
             {
                 FATAL_CFG_ERROR(T_("incomplete secion name"));
             }
-            keyName = *tok;
-            lookupKeyName = Utils::MakeLower(keyName);
-            ignoreKey = options[Option::NoOverwriteKeys] && keyMap.find(lookupKeyName) != keyMap.end();
+            keyName = string(line.substr(start, line.find(']', start) - start));
+            key = nullptr;
+            ignoreKey = options[Option::NoOverwriteKeys] && keyMap.find(Utils::MakeLower(keyName)) != keyMap.end();
         }
         else if (line.length() >= 3 && line[0] == COMMENT_CHAR && line[1] == COMMENT_CHAR && line[2] == ' ')
         {
@@ -958,7 +1018,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
             {
                 documentation += '\n';
             }
-            documentation += &line[3];
+            documentation += line.substr(3);
         }
         else if ((line.length() >= 2 && line[0] == COMMENT_CHAR && (IsAlphaNumericAScii(line[1]) || line[1] == '.')) || IsAlphaNumericAScii(line[0]) || line[0] == '.')
         {
@@ -971,13 +1031,18 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
                 {
                     FATAL_CFG_ERROR(T_("invalid value definition"));
                 }
-                PutValue(keyName, valueName, std::move(value), putMode, std::move(documentation), line[0] == COMMENT_CHAR);
+                if (key == nullptr)
+                {
+                    key = &GetOrCreateKey(keyName);
+                }
+                PutValue(*key, std::move(valueName), std::move(value), putMode, std::move(documentation), line[0] == COMMENT_CHAR);
+                documentation.clear();
             }
         }
         else if (line.length() >= 4 && line[0] == COMMENT_CHAR && line[1] == COMMENT_CHAR && line[2] == COMMENT_CHAR && line[3] == COMMENT_CHAR)
         {
             documentation = "";
-            Tokenizer tok(line.substr(4), " \t");
+            Tokenizer tok(string(line.substr(4)), " \t");
             if (tok)
             {
                 if (*tok == "signature/miktex:")
@@ -992,11 +1057,6 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         }
     }
 
-    if (reader.bad() || (reader.fail() && !reader.eof()))
-    {
-        FATAL_CFG_ERROR(T_("error reading the configuration file"));
-    }
-
     if (mustBeSigned && signature.empty())
     {
         FATAL_CFG_ERROR(T_("the configuration file is not signed"));
@@ -1058,7 +1118,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
     }
 }
 
-bool CfgImpl::ParseValueDefinition(const string& line, string& valueName, string& value, CfgImpl::PutMode& putMode)
+bool CfgImpl::ParseValueDefinition(string_view line, string& valueName, string& value, CfgImpl::PutMode& putMode)
 {
     MIKTEX_ASSERT(!line.empty() && (isalnum(line[0]) || line[0] == '.'));
 
@@ -1066,13 +1126,12 @@ bool CfgImpl::ParseValueDefinition(const string& line, string& valueName, string
 
     putMode = None;
 
-    if (posEqual == string::npos || posEqual == 0)
+    if (posEqual == string_view::npos || posEqual == 0)
     {
         return false;
     }
 
-    value = line.substr(posEqual + 1);
-    value = Trim(value);
+    value = TrimView(line.substr(posEqual + 1));
 
     if (line[posEqual - 1] == '+')
     {
@@ -1085,8 +1144,7 @@ bool CfgImpl::ParseValueDefinition(const string& line, string& valueName, string
         posEqual -= 1;
     }
 
-    valueName = line.substr(0, posEqual);
-    valueName = Trim(valueName);
+    valueName = TrimView(line.substr(0, posEqual));
 
     return true;
 }
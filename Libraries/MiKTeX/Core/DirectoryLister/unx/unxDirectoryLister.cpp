@@ -22,7 +22,15 @@
 #include "config.h"
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
 
 #include <miktex/Core/DirectoryLister>
 
@@ -170,3 +178,87 @@ bool unxDirectoryLister::GetNext(DirectoryEntry2& direntry2, bool simple)
   }
   return true;
 }
+
+#if defined(__linux__) && defined(SYS_getdents64)
+struct linux_dirent64
+{
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[1];
+};
+#endif
+
+void DirectoryLister::ReadAll(const PathName& directory, int options, DirectoryListing& listing)
+{
+  listing.Clear();
+#if defined(__linux__) && defined(SYS_getdents64)
+  int fd = open(directory.GetData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("open", "dir", directory.ToString());
+  }
+  // getdents64() returns as many entries as fit into the buffer
+  vector<char> buf(64 * 1024);
+  while (true)
+  {
+    long n = syscall(SYS_getdents64, fd, &buf[0], buf.size());
+    if (n < 0)
+    {
+      int err = errno;
+      close(fd);
+      errno = err;
+      MIKTEX_FATAL_CRT_ERROR_2("getdents64", "dir", directory.ToString());
+    }
+    if (n == 0)
+    {
+      break;
+    }
+    for (long pos = 0; pos < n; )
+    {
+      const linux_dirent64* dent = reinterpret_cast<const linux_dirent64*>(&buf[pos]);
+      pos += dent->d_reclen;
+      if (IsDotDirectory(dent->d_name) && (options & (int)Options::IncludeDotAndDotDot) == 0)
+      {
+        continue;
+      }
+      bool isDirectory;
+      if (dent->d_type != DT_UNKNOWN)
+      {
+        isDirectory = dent->d_type == DT_DIR;
+      }
+      else
+      {
+        struct stat statbuf;
+        if (fstatat(fd, dent->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+          int err = errno;
+          close(fd);
+          errno = err;
+          MIKTEX_FATAL_CRT_ERROR_2("fstatat", "path", (directory / dent->d_name).ToString());
+        }
+        isDirectory = S_ISDIR(statbuf.st_mode) != 0;
+      }
+      if (((options & (int)Options::DirectoriesOnly) != 0 && !isDirectory)
+        || ((options & (int)Options::FilesOnly) != 0 && isDirectory))
+      {
+        continue;
+      }
+      listing.Add(dent->d_name, strlen(dent->d_name), isDirectory);
+    }
+  }
+  if (close(fd) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("close", "dir", directory.ToString());
+  }
+#else
+  unxDirectoryLister lister(directory, nullptr, options);
+  DirectoryEntry entry;
+  while (lister.GetNext(entry))
+  {
+    listing.Add(entry.name.c_str(), entry.name.length(), entry.isDirectory);
+  }
+  lister.Close();
+#endif
+}
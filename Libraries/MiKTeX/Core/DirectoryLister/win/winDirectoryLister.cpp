@@ -158,3 +158,16 @@ bool winDirectoryLister::GetNext(DirectoryEntry2& direntry2)
     }
     return true;
 }
+
+void DirectoryLister::ReadAll(const PathName& directory, int options, DirectoryListing& listing)
+{
+    // FindFirstFileExW() already fetches many entries at a time
+    listing.Clear();
+    winDirectoryLister lister(directory, nullptr, options);
+    DirectoryEntry2 entry;
+    while (lister.GetNext(entry))
+    {
+        listing.Add(entry.name.c_str(), entry.name.length(), entry.isDirectory);
+    }
+    lister.Close();
+}
@@ -426,6 +426,16 @@ bool File::IsSymbolicLink(const PathName& path)
   return S_ISLNK(statbuf.st_mode);
 }
 
+bool File::IsSameFile(const PathName& path1, const PathName& path2)
+{
+  struct stat statbuf1;
+  struct stat statbuf2;
+  return stat(path1.GetData(), &statbuf1) == 0
+    && stat(path2.GetData(), &statbuf2) == 0
+    && statbuf1.st_dev == statbuf2.st_dev
+    && statbuf1.st_ino == statbuf2.st_ino;
+}
+
 PathName File::ReadSymbolicLink(const PathName& path)
 {
   PathName result;
@@ -419,6 +419,28 @@ bool File::IsSymbolicLink(const PathName& path)
   UNIMPLEMENTED();
 }
 
+MIKTEXSTATICFUNC(bool) GetFileInformation(const PathName& path, BY_HANDLE_FILE_INFORMATION& info)
+{
+  HANDLE h = CreateFileW(path.ToExtendedLengthPathName().ToWideCharString().c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (h == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  AutoHANDLE autoClose(h);
+  return GetFileInformationByHandle(h, &info) ? true : false;
+}
+
+bool File::IsSameFile(const PathName& path1, const PathName& path2)
+{
+  BY_HANDLE_FILE_INFORMATION info1;
+  BY_HANDLE_FILE_INFORMATION info2;
+  return GetFileInformation(path1, info1)
+    && GetFileInformation(path2, info2)
+    && info1.dwVolumeSerialNumber == info2.dwVolumeSerialNumber
+    && info1.nFileIndexHigh == info2.nFileIndexHigh
+    && info1.nFileIndexLow == info2.nFileIndexLow;
+}
+
 PathName File::ReadSymbolicLink(const PathName& path)
 {
   UNIMPLEMENTED();
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <miktex/Core/AutoResource>
@@ -35,6 +37,11 @@ using namespace std;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Util;
 
+bool FileSystemWatcherBase::IsWatchingAll()
+{
+  return !incomplete;
+}
+
 void FileSystemWatcherBase::Subscribe(MiKTeX::Core::FileSystemWatcherCallback *callback)
 {
   lock_guard<shared_mutex> l(mutex);
@@ -118,9 +125,13 @@ void FileSystemWatcherBase::NotifySubscribers()
   {
     unique_lock<std::mutex> l(notifyMutex);
     notifyCondition.wait(l, [this] { return done || !pendingNotifications.empty(); });
-    vector<FileSystemChangeEvent> notifications;
-    std::swap(notifications, pendingNotifications);
+    // give a burst of changes (e.g., a package installation) the chance to
+    // settle, so that subscribers see the burst as one batch
+    notifyCondition.wait_for(l, COALESCING_DELAY, [this] { return done.load(); });
+    vector<FileSystemChangeEvent> notifications = CoalesceNotifications(pendingNotifications);
+    pendingNotifications.clear();
     l.unlock();
+    shared_lock<shared_mutex> l2(mutex);
     for (const auto &ev : notifications)
     {
       for (auto &c : callbacks)
@@ -130,3 +141,20 @@ void FileSystemWatcherBase::NotifySubscribers()
     }
   }
 }
+
+vector<FileSystemChangeEvent> FileSystemWatcherBase::CoalesceNotifications(const vector<FileSystemChangeEvent>& notifications)
+{
+  // drop repeated events (e.g., a file being written in chunks), but keep the
+  // order of the first occurrences: an "added" followed by "modified" must
+  // not be folded into one event
+  vector<FileSystemChangeEvent> result;
+  unordered_set<string> seen;
+  for (const auto &ev : notifications)
+  {
+    if (seen.insert(FileSystemChangeActionToString(ev.action) + ev.fileName.ToString()).second)
+    {
+      result.push_back(ev);
+    }
+  }
+  return result;
+}
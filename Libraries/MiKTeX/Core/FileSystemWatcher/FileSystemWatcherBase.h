@@ -22,11 +22,13 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <set>
 #include <shared_mutex>
+#include <vector>
 
 #include <miktex/Core/FileSystemWatcher>
 #include <miktex/Trace/Trace>
@@ -37,6 +39,9 @@ CORE_INTERNAL_BEGIN_NAMESPACE;
 class FileSystemWatcherBase :
   public MiKTeX::Core::FileSystemWatcher
 {
+public:
+  bool MIKTEXTHISCALL IsWatchingAll() override;
+
 public:
   void MIKTEXTHISCALL Subscribe(MiKTeX::Core::FileSystemWatcherCallback* callback) override;
 
@@ -46,6 +51,12 @@ public:
 private:
   void NotifySubscribers();
 
+private:
+  static std::vector<MiKTeX::Core::FileSystemChangeEvent> CoalesceNotifications(const std::vector<MiKTeX::Core::FileSystemChangeEvent>& notifications);
+
+private:
+  static constexpr std::chrono::milliseconds COALESCING_DELAY{ 50 };
+
 protected:
   void NotifyThreadFunction();
 
@@ -65,6 +76,8 @@ protected:
   std::set<MiKTeX::Core::FileSystemWatcherCallback*> callbacks;
   std::atomic_bool done{ false };
   bool failure = false;
+  // a directory could not be watched
+  std::atomic_bool incomplete{ false };
   std::shared_mutex mutex;
   std::condition_variable notifyCondition;
   std::mutex notifyMutex;
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief File system watcher (macOS)
  *
- * @copyright Copyright © 2021-2023 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -13,9 +13,13 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/Utils>
+
 #include "internal.h"
 
 #include "macFileSystemWatcher.h"
@@ -43,12 +47,30 @@ macFileSystemWatcher::~macFileSystemWatcher()
 
 void macFileSystemWatcher::AddDirectories(const vector<PathName>& directories)
 {
+    // FSEvents streams watch directory trees: a directory below a watched
+    // directory does not need a path of its own, and the stream (which has
+    // to be recreated) is left alone
+    vector<PathName> newDirectories;
+    shared_lock sl(mutex);
+    for (const PathName &p : directories)
+    {
+        if (!IsWatched(p) && find(newDirectories.begin(), newDirectories.end(), p) == newDirectories.end())
+        {
+            newDirectories.push_back(p);
+        }
+    }
+    sl.unlock();
+    if (newDirectories.empty())
+    {
+        return;
+    }
     bool wasRunning = Stop();
     unique_lock l(mutex);
-    for (const PathName &p : directories)
+    for (const PathName &p : newDirectories)
     {
         trace_files->WriteLine("core", fmt::format("adding directory to watch list: {0}", Q_(p.ToDisplayString())));
         this->directories.push_back(CFStringCreateWithCString(nullptr, p.ToString().c_str(), kCFStringEncodingUTF8));
+        watchedPaths.push_back(p);
     }
     l.unlock();
     if (wasRunning)
@@ -57,6 +79,18 @@ void macFileSystemWatcher::AddDirectories(const vector<PathName>& directories)
     }
 }
 
+bool macFileSystemWatcher::IsWatched(const PathName& dir) const
+{
+    for (const PathName& watched : watchedPaths)
+    {
+        if (dir == watched || Utils::IsParentDirectoryOf(watched, dir))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool macFileSystemWatcher::Start()
 {
     bool runningExpected = false;
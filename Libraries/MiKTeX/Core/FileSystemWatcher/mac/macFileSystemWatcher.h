@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief File system watcher (macOS)
  *
- * @copyright Copyright © 2021-2023 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -38,6 +38,7 @@ private:
     bool MIKTEXTHISCALL Stop() override;
     void MIKTEXTHISCALL WatchDirectories() override;
     void HandleDirectoryChange(const char* path, FSEventStreamEventFlags flags);
+    bool IsWatched(const MiKTeX::Util::PathName& dir) const;
 
     static void Callback(ConstFSEventStreamRef streamRef, void* clientCallBackInfo, size_t numEvents, void* eventPaths, const FSEventStreamEventFlags* eventFlags, const FSEventStreamEventId* eventIds);
 
@@ -48,6 +49,7 @@ private:
     CFRunLoopRef runLoop = nullptr;
     bool runLoopRunning = false;
     FSEventStreamRef stream = nullptr;
+    std::vector<MiKTeX::Util::PathName> watchedPaths;
 };
 
 CORE_INTERNAL_END_NAMESPACE;
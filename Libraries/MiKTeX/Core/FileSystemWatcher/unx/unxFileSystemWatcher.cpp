@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief File system watcher (Linux)
  *
- * @copyright Copyright © 2021-2023 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -13,8 +13,18 @@
 
 #include "config.h"
 
+#include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
 #include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#if defined(HAVE_SYS_FANOTIFY_H)
+#include <sys/fanotify.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -23,11 +33,36 @@
 
 #include "unxFileSystemWatcher.h"
 
+#if defined(HAVE_SYS_FANOTIFY_H) && defined(FAN_REPORT_DFID_NAME)
+#define USE_FANOTIFY 1
+#endif
+
 using namespace std;
 
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
+constexpr uint32_t INOTIFY_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO;
+
+#if defined(USE_FANOTIFY)
+// a filesystem mark sees every write on the filesystem: FAN_MODIFY would
+// flood the queue, so the filesystem mark reports added and removed files
+constexpr uint64_t FANOTIFY_MASK = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_ONDIR;
+
+// modified files are reported by a mark on each watched directory
+constexpr uint64_t FANOTIFY_DIRECTORY_MASK = FAN_MODIFY | FAN_EVENT_ON_CHILD;
+
+// a filesystem mark reports events for all directories: most of the file
+// handles we see belong to directories we are not interested in
+constexpr size_t MAX_HANDLE_CACHE_SIZE = 16384;
+
+inline uint64_t MakeFsidKey(int val0, int val1)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(val0)) << 32) | static_cast<uint32_t>(val1);
+}
+#endif
+
 unique_ptr<FileSystemWatcher> FileSystemWatcher::Create()
 {
     return make_unique<unxFileSystemWatcher>();
@@ -40,6 +75,14 @@ unxFileSystemWatcher::unxFileSystemWatcher()
     {
         MIKTEX_FATAL_CRT_ERROR("inotify_init");
     }
+#if defined(USE_FANOTIFY)
+    // fails with EPERM, unless we have CAP_SYS_ADMIN
+    fanotifyFd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_CLOEXEC, O_RDONLY | O_LARGEFILE);
+    if (fanotifyFd >= 0)
+    {
+        trace_files->WriteLine("core", "watching directories with fanotify");
+    }
+#endif
 }
 
 unxFileSystemWatcher::~unxFileSystemWatcher()
@@ -47,6 +90,14 @@ unxFileSystemWatcher::~unxFileSystemWatcher()
     try
     {
         Stop();
+        for (const auto& fs : fanotifyFileSystems)
+        {
+            close(fs.second);
+        }
+        if (fanotifyFd >= 0 && close(fanotifyFd) < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("close");
+        }
         if (close(watchFd) < 0)
         {
             MIKTEX_FATAL_CRT_ERROR("close");
@@ -62,18 +113,95 @@ void unxFileSystemWatcher::AddDirectories(const vector<PathName>& directories)
     unique_lock<shared_mutex> l(mutex);
     for (const auto& dir : directories)
     {
-        int wd = inotify_add_watch(watchFd, dir.GetData(), IN_ALL_EVENTS);
-        if (wd < 0)
+        if (!TryAddFanotifyDirectory(dir))
+        {
+            AddInotifyDirectory(dir);
+        }
+    }
+}
+
+bool unxFileSystemWatcher::TryAddFanotifyDirectory(const PathName& dir)
+{
+#if defined(USE_FANOTIFY)
+    if (fanotifyFd < 0)
+    {
+        return false;
+    }
+    struct stat statbuf;
+    if (stat(dir.GetData(), &statbuf) != 0 || unmarkableDevices.find(statbuf.st_dev) != unmarkableDevices.end())
+    {
+        return false;
+    }
+    if (fanotifyDevices.find(statbuf.st_dev) == fanotifyDevices.end())
+    {
+        int dirFd = open(dir.GetData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd < 0)
         {
-            MIKTEX_FATAL_CRT_ERROR_2("inotify_add_Watch", "path", dir.ToString());
+            return false;
         }
-        if (this->directories.find(wd) != this->directories.end())
+        struct statfs statfsbuf;
+        if (fstatfs(dirFd, &statfsbuf) != 0 || fanotify_mark(fanotifyFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, FANOTIFY_MASK, dirFd, nullptr) != 0)
         {
-            continue;
+            // e.g., the filesystem cannot encode file handles
+            int errorCode = errno;
+            close(dirFd);
+            trace_files->WriteLine("core", fmt::format("cannot mark the filesystem of {0}: {1}", Q_(dir.ToDisplayString()), strerror(errorCode)));
+            unmarkableDevices.insert(statbuf.st_dev);
+            return false;
         }
-        trace_files->WriteLine("core", fmt::format("watching directory: {0}", Q_(dir.ToDisplayString())));
-        this->directories[wd] = dir;
+        trace_files->WriteLine("core", fmt::format("marked the filesystem of {0}", Q_(dir.ToDisplayString())));
+        fanotifyFileSystems[MakeFsidKey(statfsbuf.f_fsid.__val[0], statfsbuf.f_fsid.__val[1])] = dirFd;
+        fanotifyDevices.insert(statbuf.st_dev);
+    }
+    // events report resolved paths
+    char realPath[PATH_MAX];
+    if (realpath(dir.GetData(), realPath) == nullptr)
+    {
+        return false;
+    }
+    if (fanotifyDirectories.find(realPath) != fanotifyDirectories.end())
+    {
+        return true;
+    }
+    if (fanotify_mark(fanotifyFd, FAN_MARK_ADD, FANOTIFY_DIRECTORY_MASK, AT_FDCWD, realPath) != 0)
+    {
+        // inotify reports the modified files of this directory
+        trace_files->WriteLine("core", fmt::format("cannot mark the directory {0}: {1}", Q_(dir.ToDisplayString()), strerror(errno)));
+        return false;
     }
+    fanotifyDirectories.emplace(realPath, dir);
+    trace_files->WriteLine("core", fmt::format("watching directory: {0}", Q_(dir.ToDisplayString())));
+    return true;
+#else
+    return false;
+#endif
+}
+
+void unxFileSystemWatcher::AddInotifyDirectory(const PathName& dir)
+{
+    if (incomplete || inotifyDirectories.find(dir.ToString()) != inotifyDirectories.end())
+    {
+        return;
+    }
+    int wd = inotify_add_watch(watchFd, dir.GetData(), INOTIFY_MASK);
+    if (wd < 0)
+    {
+        if (errno == ENOSPC)
+        {
+            // max_user_watches is exhausted; further changes will go unnoticed
+            trace_error->WriteLine("core", TraceLevel::Error, fmt::format("cannot watch directory {0}: the inotify watch limit has been reached", Q_(dir.ToDisplayString())));
+            incomplete = true;
+            return;
+        }
+        MIKTEX_FATAL_CRT_ERROR_2("inotify_add_watch", "path", dir.ToString());
+    }
+    inotifyDirectories.insert(dir.ToString());
+    if (this->directories.find(wd) != this->directories.end())
+    {
+        return;
+    }
+    trace_files->WriteLine("core", fmt::format("watching directory: {0}", Q_(dir.ToDisplayString())));
+    this->directories[wd] = dir;
 }
 
 bool unxFileSystemWatcher::Start()
@@ -118,7 +246,7 @@ bool unxFileSystemWatcher::Stop()
 void unxFileSystemWatcher::WatchDirectories()
 {
     vector<unsigned char> buffer;
-    buffer.resize(4096);
+    buffer.resize(64 * 1024);
     while (true)
     {
         int maxFd = -1;
@@ -134,6 +262,14 @@ void unxFileSystemWatcher::WatchDirectories()
         {
             maxFd = watchFd;
         }
+        if (fanotifyFd >= 0)
+        {
+            FD_SET(fanotifyFd, &readfds);
+            if (fanotifyFd > maxFd)
+            {
+                maxFd = fanotifyFd;
+            }
+        }
         if (select(maxFd + 1, &readfds, nullptr, nullptr, nullptr) < 0)
         {
             MIKTEX_FATAL_CRT_ERROR("select");
@@ -153,6 +289,11 @@ void unxFileSystemWatcher::WatchDirectories()
             }
             notifyCondition.notify_all();
         }
+        if (fanotifyFd >= 0 && FD_ISSET(fanotifyFd, &readfds))
+        {
+            ReadFanotifyEvents(buffer);
+            notifyCondition.notify_all();
+        }
         if (FD_ISSET(cancelEventPipe[0], &readfds))
         {
             return;
@@ -162,12 +303,17 @@ void unxFileSystemWatcher::WatchDirectories()
 
 void unxFileSystemWatcher::HandleDirectoryChange(const inotify_event* evt)
 {
+    if ((evt->mask & IN_Q_OVERFLOW) != 0)
+    {
+        trace_error->WriteLine("core", TraceLevel::Error, "inotify event queue overflow");
+        return;
+    }
     FileSystemChangeEvent ev;
-    if ((evt->mask & IN_CREATE) != 0)
+    if ((evt->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
     {
         ev.action = FileSystemChangeAction::Added;
     }
-    else if ((evt->mask & IN_DELETE) != 0)
+    else if ((evt->mask & (IN_DELETE | IN_MOVED_FROM)) != 0)
     {
         ev.action = FileSystemChangeAction::Removed;
     }
@@ -192,3 +338,129 @@ void unxFileSystemWatcher::HandleDirectoryChange(const inotify_event* evt)
     lock_guard<std::mutex> l2(notifyMutex);
     pendingNotifications.push_back(ev);
 }
+
+void unxFileSystemWatcher::ReadFanotifyEvents(vector<unsigned char>& buffer)
+{
+#if defined(USE_FANOTIFY)
+    auto n = read(fanotifyFd, &buffer[0], buffer.size());
+    if (n < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("read");
+    }
+    // the same event can report more than one change
+    static const pair<uint64_t, FileSystemChangeAction> actions[] = {
+        { FAN_CREATE | FAN_MOVED_TO, FileSystemChangeAction::Added },
+        { FAN_DELETE | FAN_MOVED_FROM, FileSystemChangeAction::Removed },
+        { FAN_MODIFY, FileSystemChangeAction::Modified },
+    };
+    vector<FileSystemChangeEvent> events;
+    unique_lock<shared_mutex> l(mutex);
+    for (struct fanotify_event_metadata* md = reinterpret_cast<struct fanotify_event_metadata*>(&buffer[0]); FAN_EVENT_OK(md, n); md = FAN_EVENT_NEXT(md, n))
+    {
+        if (md->vers != FANOTIFY_METADATA_VERSION)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        if (md->fd >= 0)
+        {
+            close(md->fd);
+        }
+        if ((md->mask & FAN_Q_OVERFLOW) != 0)
+        {
+            trace_error->WriteLine("core", TraceLevel::Error, "fanotify event queue overflow");
+            continue;
+        }
+        if ((md->mask & FAN_ONDIR) != 0 && (md->mask & (FAN_DELETE | FAN_MOVED_FROM)) != 0)
+        {
+            // a directory has been removed or renamed: cached paths may be stale
+            fanotifyHandleCache.clear();
+        }
+        const unsigned char* info = reinterpret_cast<const unsigned char*>(md) + md->metadata_len;
+        const unsigned char* end = reinterpret_cast<const unsigned char*>(md) + md->event_len;
+        while (info + sizeof(struct fanotify_event_info_header) <= end)
+        {
+            const struct fanotify_event_info_header* header = reinterpret_cast<const struct fanotify_event_info_header*>(info);
+            if (header->len == 0)
+            {
+                break;
+            }
+            if (header->info_type == FAN_EVENT_INFO_TYPE_DFID_NAME)
+            {
+                const struct fanotify_event_info_fid* fid = reinterpret_cast<const struct fanotify_event_info_fid*>(info);
+                const struct file_handle* fileHandle = reinterpret_cast<const struct file_handle*>(fid->handle);
+                const char* name = reinterpret_cast<const char*>(fileHandle->f_handle + fileHandle->handle_bytes);
+                PathName dir;
+                if (TryGetFanotifyDirectory(MakeFsidKey(fid->fsid.val[0], fid->fsid.val[1]), fileHandle, dir))
+                {
+                    for (const auto& action : actions)
+                    {
+                        if ((md->mask & action.first) != 0)
+                        {
+                            FileSystemChangeEvent ev;
+                            ev.action = action.second;
+                            ev.fileName = dir;
+                            ev.fileName /= name;
+                            events.push_back(ev);
+                        }
+                    }
+                }
+            }
+            info += header->len;
+        }
+    }
+    l.unlock();
+    if (!events.empty())
+    {
+        lock_guard<std::mutex> l2(notifyMutex);
+        pendingNotifications.insert(pendingNotifications.end(), events.begin(), events.end());
+    }
+#endif
+}
+
+bool unxFileSystemWatcher::TryGetFanotifyDirectory(uint64_t fsid, const void* fileHandle, PathName& dir)
+{
+#if defined(USE_FANOTIFY)
+    auto fs = fanotifyFileSystems.find(fsid);
+    if (fs == fanotifyFileSystems.end())
+    {
+        return false;
+    }
+    const struct file_handle* handle = static_cast<const struct file_handle*>(fileHandle);
+    string key = fmt::format("{0}:", fsid);
+    key.append(reinterpret_cast<const char*>(handle), sizeof(struct file_handle) + handle->handle_bytes);
+    auto it = fanotifyHandleCache.find(key);
+    if (it == fanotifyHandleCache.end())
+    {
+        string realPath;
+        // open_by_handle_at() requires CAP_DAC_READ_SEARCH; so does fanotify_init()
+        vector<unsigned char> handleCopy(sizeof(struct file_handle) + handle->handle_bytes);
+        memcpy(&handleCopy[0], handle, handleCopy.size());
+        int fd = open_by_handle_at(fs->second, reinterpret_cast<struct file_handle*>(&handleCopy[0]), O_PATH | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            char buf[PATH_MAX];
+            auto len = readlink(fmt::format("/proc/self/fd/{0}", fd).c_str(), buf, sizeof(buf));
+            close(fd);
+            if (len > 0)
+            {
+                realPath.assign(buf, len);
+            }
+        }
+        if (fanotifyHandleCache.size() >= MAX_HANDLE_CACHE_SIZE)
+        {
+            fanotifyHandleCache.clear();
+        }
+        // unresolvable handles (e.g., of removed directories) are cached, too
+        it = fanotifyHandleCache.emplace(key, realPath).first;
+    }
+    auto watched = fanotifyDirectories.find(it->second);
+    if (watched == fanotifyDirectories.end())
+    {
+        return false;
+    }
+    dir = watched->second;
+    return true;
+#else
+    return false;
+#endif
+}
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief File system watcher (Linux)
  *
- * @copyright Copyright © 2021-2023 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -14,13 +14,24 @@
 #pragma once
 
 #include <sys/inotify.h>
+#include <sys/types.h>
 
+#include <cstdint>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "../FileSystemWatcherBase.h"
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
 
+/// Watches directories with inotify, or, if permitted, with fanotify.
+///
+/// inotify needs one watch per directory; the number of watches is limited
+/// (`max_user_watches`).  A fanotify filesystem mark covers all directories
+/// on a filesystem, so that adding a directory is a matter of remembering
+/// its path.  Marking filesystems requires `CAP_SYS_ADMIN`;
+/// directories on filesystems which cannot be marked are watched with inotify.
 class unxFileSystemWatcher :
   public FileSystemWatcherBase
 {
@@ -43,9 +54,28 @@ private:
 
     void HandleDirectoryChange(const struct inotify_event* evt);
 
+    bool TryAddFanotifyDirectory(const MiKTeX::Util::PathName& dir);
+
+    void AddInotifyDirectory(const MiKTeX::Util::PathName& dir);
+
+    void ReadFanotifyEvents(std::vector<unsigned char>& buffer);
+
+    bool TryGetFanotifyDirectory(std::uint64_t fsid, const void* fileHandle, MiKTeX::Util::PathName& dir);
+
     int cancelEventPipe[2];
     std::unordered_map<int, MiKTeX::Util::PathName> directories;
+    std::unordered_set<std::string> inotifyDirectories;
     int watchFd;
+
+    int fanotifyFd = -1;
+    // real path => watched path
+    std::unordered_map<std::string, MiKTeX::Util::PathName> fanotifyDirectories;
+    // fsid => directory file descriptor (needed by open_by_handle_at())
+    std::unordered_map<std::uint64_t, int> fanotifyFileSystems;
+    std::unordered_set<dev_t> fanotifyDevices;
+    std::unordered_set<dev_t> unmarkableDevices;
+    // file handle => real path
+    std::unordered_map<std::string, std::string> fanotifyHandleCache;
 };
 
 CORE_INTERNAL_END_NAMESPACE;
@@ -1,6 +1,6 @@
 /* winFileSystemWatcher.cpp: file system watcher (Windows specials)
 
-   Copyright (C) 2021-2022 Christian Schenk
+   Copyright (C) 2021-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -24,10 +24,12 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <algorithm>
 #include <vector>
 
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Directory>
+#include <miktex/Core/Utils>
 
 #include "internal.h"
 
@@ -56,25 +58,38 @@ winFileSystemWatcher::~winFileSystemWatcher()
 
 void winFileSystemWatcher::AddDirectories(const vector<PathName>& directories)
 {
-  bool wasRunning = Stop();
+  // directories are watched recursively: a directory below a watched
+  // directory does not need a handle of its own
   vector<PathName> newDirectories;
-  unique_lock l(mutex);
+  shared_lock sl(mutex);
   for (const auto& dir : directories)
   {
-    bool dup = false;
-    for (auto& d : this->directories)
-      if (d.path == dir)
-      {
-        dup = true;
-        break;
-      }
-      if (!dup)
-      {
-        newDirectories.push_back(dir);
-      }
+    if (!IsWatched(dir) && find(newDirectories.begin(), newDirectories.end(), dir) == newDirectories.end())
+    {
+      newDirectories.push_back(dir);
+    }
+  }
+  sl.unlock();
+  if (newDirectories.empty())
+  {
+    return;
   }
+  bool wasRunning = Stop();
+  unique_lock l(mutex);
   for (const auto& dir : newDirectories)
   {
+    if (IsWatched(dir))
+    {
+      continue;
+    }
+    // the new directory replaces the watched directories below it
+    this->directories.erase(remove_if(this->directories.begin(), this->directories.end(), [&dir](const DirectoryWatchInfo& dwi) { return Utils::IsParentDirectoryOf(dir, dwi.path); }), this->directories.end());
+    // WaitForMultipleObjects() also waits for the cancel event
+    if (this->directories.size() + 1 >= MAXIMUM_WAIT_OBJECTS)
+    {
+      trace_error->WriteLine("core", MiKTeX::Trace::TraceLevel::Error, fmt::format("cannot watch directory {0}: too many directories", dir.ToDisplayString()));
+      continue;
+    }
     trace_files->WriteLine("core", fmt::format("watching directory: {0}", dir.ToDisplayString()));
     this->directories.push_back(dir);
   }
@@ -85,6 +100,18 @@ void winFileSystemWatcher::AddDirectories(const vector<PathName>& directories)
   }
 }
 
+bool winFileSystemWatcher::IsWatched(const PathName& dir) const
+{
+  for (const auto& dwi : directories)
+  {
+    if (dwi.path == dir || Utils::IsParentDirectoryOf(dwi.path, dir))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool winFileSystemWatcher::Start()
 {
   bool runningExpected = false;
@@ -145,7 +172,7 @@ void winFileSystemWatcher::WatchDirectories()
       handles.push_back(dwi.overlapped->hEvent);
       if (!dwi.pending)
       {
-        if (!ReadDirectoryChangesW(dwi.directoryHandle, dwi.buffer, static_cast<DWORD>(dwi.bufferSize), FALSE, notifyFilter, nullptr, dwi.overlapped, nullptr))
+        if (!ReadDirectoryChangesW(dwi.directoryHandle, dwi.buffer, static_cast<DWORD>(dwi.bufferSize), TRUE, notifyFilter, nullptr, dwi.overlapped, nullptr))
         {
           MIKTEX_FATAL_WINDOWS_ERROR_2("ReadDirectoryChangesW", "path", dwi.path.ToString());
         }
@@ -236,17 +263,14 @@ winFileSystemWatcher::DirectoryWatchInfo::DirectoryWatchInfo(DirectoryWatchInfo&
 
 winFileSystemWatcher::DirectoryWatchInfo& winFileSystemWatcher::DirectoryWatchInfo::operator=(winFileSystemWatcher::DirectoryWatchInfo&& other)
 {
+  // swap, so that other releases our resources (erase() move-assigns)
   if (this != &other)
   {
-    buffer = other.buffer;
-    other.buffer = nullptr;
-    directoryHandle = other.directoryHandle;
-    other.directoryHandle = INVALID_HANDLE_VALUE;
-    overlapped = other.overlapped;
-    other.overlapped = nullptr;
-    path = std::move(other.path);
-    pending = other.pending;
-    other.pending = false;
+    std::swap(buffer, other.buffer);
+    std::swap(directoryHandle, other.directoryHandle);
+    std::swap(overlapped, other.overlapped);
+    std::swap(path, other.path);
+    std::swap(pending, other.pending);
   }
   return *this;
 }
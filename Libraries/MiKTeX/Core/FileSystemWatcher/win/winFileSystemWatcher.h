@@ -1,6 +1,6 @@
 /* winFileSystemWatcher.h: file system watcher (Windows specials)
 
-   Copyright (C) 2021 Christian Schenk
+   Copyright (C) 2021-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -46,6 +46,9 @@ private:
 private:
   void MIKTEXTHISCALL WatchDirectories() override;
 
+private:
+  bool IsWatched(const MiKTeX::Util::PathName& dir) const;
+
 private:
   void HandleDirectoryChanges(const MiKTeX::Util::PathName& dir, const FILE_NOTIFY_INFORMATION* fni);
 
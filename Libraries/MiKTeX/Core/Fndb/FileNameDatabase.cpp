@@ -41,11 +41,13 @@
 #include <miktex/Trace/Trace>
 #include <miktex/Util/PathNameParser>
 #include <miktex/Util/PathNameUtil>
+#include <miktex/Util/StringUtil>
 #include <miktex/Util/Tokenizer>
 
 #include "internal.h"
 
 #include "FileNameDatabase.h"
+#include "FndbChangeFile.h"
 #include "Utils/CoreStopWatch.h"
 #include "Utils/inliners.h"
 
@@ -55,9 +57,6 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
-#define FNDB_DAMAGED_2(description, ...) \
-  ThrowFndbDamaged(description, MiKTeXException::KVMAP(__VA_ARGS__), MIKTEX_SOURCE_LOCATION())
-
 void MIKTEXNORETURN ThrowFndbDamaged(const string& description, const MiKTeXException::KVMAP& info, const SourceLocation& sourceLocation)
 {
   Session::FatalMiKTeXError(T_("The file name database is damaged."), description, T_("Delete the file name database files. Then run 'initexmf -u' to recreate the FNDB."), "fndb-damaged", info, sourceLocation);
@@ -104,6 +103,8 @@ bool IsComparable(const PathName& path)
 }
 
 
+const FndbWord NO_DIRECTORY = static_cast<FndbWord>(-1);
+
 // FIXME: not UTF-8 safe
 MIKTEXSTATICFUNC(bool) Match(const char* pathPattern, const char* path)
 {
@@ -147,39 +148,112 @@ MIKTEXSTATICFUNC(bool) Match(const char* pathPattern, const char* path)
   return (*pathPattern == 0 || strcmp(pathPattern, RECURSION_INDICATOR) == 0 || strcmp(pathPattern, "/") == 0) && *path == 0;
 }
 
-bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPattern_, bool all, vector<Fndb::Record>& result)
+bool FileNameDatabase::IsKey(const char* fileName, const string& key) const
+{
+#if defined(MIKTEX_WINDOWS)
+  size_t len = strlen(fileName);
+  if (len == key.length() && StringUtil::IsAscii(fileName, len))
+  {
+    // the key has been folded already
+    return StringUtil::MismatchIgnoreCaseAscii(fileName, key.c_str(), len) == len;
+  }
+  return MakeKey(fileName) == key;
+#else
+  return key == fileName;
+#endif
+}
+
+template<typename Func> void FileNameDatabase::ForEachMappedRecord(const string& key, Func f) const
+{
+  const FileNameDatabaseHashSlot* hashTable = GetHashTable();
+  const FileNameDatabaseRecord* table = GetTable();
+  FndbWord mask = fndbHeader->hashTableSize - 1;
+  FndbWord hash = FndbHash(key.c_str(), key.length());
+  for (FndbWord slot = hash & mask; hashTable[slot].recordNumber != 0; slot = (slot + 1) & mask)
+  {
+    if (hashTable[slot].hash != hash)
+    {
+      continue;
+    }
+    FndbWord idx = hashTable[slot].recordNumber - 1;
+    if (idx >= fndbHeader->numFiles)
+    {
+      FNDB_DAMAGED_2(T_("Invalid hash index record number."), "recordNumber", std::to_string(idx + 1));
+    }
+    if (!removedRecords.empty() && removedRecords.find(idx) != removedRecords.end())
+    {
+      continue;
+    }
+    const FileNameDatabaseRecord& rec = table[idx];
+    if (!IsKey(GetString(rec.foFileName), key))
+    {
+      continue;
+    }
+    if (!f(idx, rec))
+    {
+      return;
+    }
+  }
+}
+
+template<typename Func> void FileNameDatabase::ForEachRecord(const string& key, Func f) const
+{
+  bool cont = true;
+  ForEachMappedRecord(key, [this, &f, &cont](FndbWord idx, const FileNameDatabaseRecord& rec)
+  {
+    cont = f(GetString(rec.foDirectory), GetString(rec.foInfo));
+    return cont;
+  });
+  if (!cont || fileNames.empty())
+  {
+    return;
+  }
+  auto range = fileNames.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if (!f(it->second.GetDirectory().c_str(), it->second.GetInfo().c_str()))
+    {
+      return;
+    }
+  }
+}
+
+bool FileNameDatabase::Search(PathNameView relativePath, const string& pathPattern_, bool all, vector<Fndb::Record>& result)
 {
   string pathPattern = pathPattern_;
 
   ApplyChangeFile();
 
-  trace_fndb->WriteLine("core", fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern)));
+  MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", TraceLevel::Trace, fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath.GetData()), Q_(pathPattern)));
 
   MIKTEX_ASSERT(result.size() == 0);
   MIKTEX_ASSERT(!PathNameUtil::IsAbsolutePath(relativePath.GetData()));
   MIKTEX_ASSERT(!IsExplicitlyRelativePath(relativePath.GetData()));
 
-  PathName dir = relativePath.GetDirectoryName();
-  PathName fileName = relativePath.GetFileName();
-
-  PathName scratch1;
+  PathNameView fileName = relativePath.GetFileName();
 
-  if (!dir.Empty())
+  if (fileName.GetLength() < relativePath.GetLength())
   {
-    size_t l = dir.GetLength();
-    if (dir.EndsWithDirectoryDelimiter())
+    string dir(relativePath.GetData(), relativePath.GetLength() - fileName.GetLength());
+    if (PathNameUtil::IsDirectoryDelimiter(dir.back()))
     {
-      dir[l - 1] = 0;
-      --l;
+      dir.pop_back();
     }
-    scratch1 = pathPattern;
-    scratch1 /= dir.ToString();
+    PathName scratch1(pathPattern);
+    scratch1 /= dir;
     pathPattern = scratch1.ToString();
   }
 
+  string key = MakeKey(fileName.ToString());
+
   // check to see whether we have this file name
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
-  if (range.first == range.second)
+  bool haveFileName = false;
+  ForEachRecord(key, [&haveFileName](const char* directory, const char* info)
+  {
+    haveFileName = true;
+    return false;
+  });
+  if (!haveFileName)
   {
     return false;
   }
@@ -198,21 +272,83 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
   PathName comparablePathPattern(pathPattern);
   comparablePathPattern.TransformForComparison();
 
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  return SearchRecords(key, fileName, comparablePathPattern.GetData(), all, result);
+}
+
+bool FileNameDatabase::Search(PathNameView relativePath, const CompiledPathPattern& pathPattern, bool all, vector<Fndb::Record>& result)
+{
+  PathNameView fileName = relativePath.GetFileName();
+
+  if (fileName.GetLength() < relativePath.GetLength() || pathPattern.rootDirectory.Empty() || pathPattern.rootDirectory != rootDirectory)
+  {
+    return Search(relativePath, pathPattern.path.ToString(), all, result);
+  }
+
+  ApplyChangeFile();
+
+  MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", TraceLevel::Trace, fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath.GetData()), Q_(pathPattern.comparableRelativePath)));
+
+  MIKTEX_ASSERT(result.size() == 0);
+
+  return SearchRecords(MakeKey(fileName.ToString()), fileName, pathPattern.comparableRelativePath.c_str(), all, result);
+}
+
+bool FileNameDatabase::SearchRecords(const string& key, PathNameView fileName, const char* comparablePathPattern, bool all, vector<Fndb::Record>& result)
+{
+  auto matchDirectory = [comparablePathPattern](const char* directory)
   {
-    PathName relativeDirectory;
-    relativeDirectory = it->second.GetDirectory();
-    if (Match(comparablePathPattern.GetData(), PathName(relativeDirectory).TransformForComparison().GetData()))
+#if defined(MIKTEX_WINDOWS)
+    PathName comparableDirectory(directory);
+    comparableDirectory.TransformForComparison();
+    return Match(comparablePathPattern, comparableDirectory.GetData());
+#else
+    return Match(comparablePathPattern, directory);
+#endif
+  };
+
+  auto found = [&](const char* directory, const char* info)
+  {
+    PathName path(rootDirectory);
+    path /= directory;
+    path /= fileName.GetData();
+    MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", TraceLevel::Trace, fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(info)));
+    result.push_back({ std::move(path), info });
+    return all;
+  };
+
+  // mapped records carry the number of their directory record: the
+  // pattern is resolved once instead of matching each directory string
+  DirectoryMatcher matcher = MakeDirectoryMatcher(comparablePathPattern);
+
+  bool cont = true;
+  ForEachMappedRecord(key, [&](FndbWord idx, const FileNameDatabaseRecord& rec)
+  {
+    bool matches;
+    if (matcher.kind == DirectoryMatcher::Kind::String || rec.directoryNumber == 0)
+    {
+      matches = matchDirectory(GetString(rec.foDirectory));
+    }
+    else
+    {
+      FndbWord directoryIndex = rec.directoryNumber - 1;
+      matches = matcher.kind != DirectoryMatcher::Kind::None && directoryIndex >= matcher.first && directoryIndex <= matcher.last;
+    }
+    if (matches)
+    {
+      cont = found(GetString(rec.foDirectory), GetString(rec.foInfo));
+    }
+    return cont;
+  });
+
+  // records of the change file are not part of the directory table
+  if (cont && !fileNames.empty())
+  {
+    auto range = fileNames.equal_range(key);
+    for (auto it = range.first; cont && it != range.second; ++it)
     {
-      PathName path;
-      path = rootDirectory;
-      path /= relativeDirectory.ToString();
-      path /= fileName.ToString();
-      trace_fndb->WriteLine("core", fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(it->second.GetInfo())));
-      result.push_back({ path, it->second.GetInfo() });
-      if (!all)
+      if (matchDirectory(it->second.GetDirectory().c_str()))
       {
-        break;
+        cont = found(it->second.GetDirectory().c_str(), it->second.GetInfo().c_str());
       }
     }
   }
@@ -220,6 +356,87 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
   return !result.empty();
 }
 
+FileNameDatabase::DirectoryMatcher FileNameDatabase::MakeDirectoryMatcher(const char* comparablePathPattern) const
+{
+  DirectoryMatcher matcher;
+  if (fndbHeader == nullptr || fndbHeader->foDirectoryTable == 0)
+  {
+    return matcher;
+  }
+  string directory(comparablePathPattern);
+  DirectoryMatcher::Kind kind = DirectoryMatcher::Kind::Exact;
+  size_t pos = directory.find(RECURSION_INDICATOR);
+  if (pos != string::npos)
+  {
+    // only a trailing recursion indicator (below the root directory) maps
+    // to a sub-tree
+    if (pos == 0 || pos + RECURSION_INDICATOR_LENGTH != directory.length())
+    {
+      return matcher;
+    }
+    directory.erase(pos);
+    kind = DirectoryMatcher::Kind::SubTree;
+  }
+  while (!directory.empty() && PathNameUtil::IsDirectoryDelimiter(directory.back()))
+  {
+    directory.pop_back();
+  }
+  if (!directory.empty() && PathNameUtil::IsDirectoryDelimiter(directory.front()))
+  {
+    return matcher;
+  }
+  FndbWord directoryIndex = ResolveDirectory(directory);
+  if (directoryIndex == NO_DIRECTORY)
+  {
+    matcher.kind = DirectoryMatcher::Kind::None;
+    return matcher;
+  }
+  matcher.kind = kind;
+  matcher.first = directoryIndex;
+  matcher.last = kind == DirectoryMatcher::Kind::SubTree ? directoryIndex + GetDirectoryTable()[directoryIndex].numDescendants : directoryIndex;
+  return matcher;
+}
+
+FndbWord FileNameDatabase::ResolveDirectory(const string& comparableDirectory) const
+{
+  lock_guard<mutex> lockGuard(resolvedDirectoriesMutex);
+  auto it = resolvedDirectories.find(comparableDirectory);
+  if (it != resolvedDirectories.end())
+  {
+    return it->second;
+  }
+  const FileNameDatabaseDirectoryRecord* directories = GetDirectoryTable();
+  FndbWord numDirectories = fndbHeader->numDirs + 1;
+  FndbWord current = 0;
+  size_t start = 0;
+  while (current != NO_DIRECTORY && start < comparableDirectory.length())
+  {
+    size_t end = start;
+    while (end < comparableDirectory.length() && !PathNameUtil::IsDirectoryDelimiter(comparableDirectory[end]))
+    {
+      ++end;
+    }
+    if (end > start)
+    {
+      string name = comparableDirectory.substr(start, end - start);
+      FndbWord endOfSubTree = current + directories[current].numDescendants + 1;
+      FndbWord child = current + 1;
+      // the sub-directories are the roots of consecutive sub-trees
+      for (; child < endOfSubTree && child < numDirectories; child += directories[child].numDescendants + 1)
+      {
+        if (PathNameView::Equals(PathNameView(GetString(directories[child].foPath)).GetFileName(), name))
+        {
+          break;
+        }
+      }
+      current = child < endOfSubTree && child < numDirectories ? child : NO_DIRECTORY;
+    }
+    start = end + 1;
+  }
+  resolvedDirectories[comparableDirectory] = current;
+  return current;
+}
+
 void FileNameDatabase::Add(const vector<Fndb::Record>& records)
 {
   FileStream writer(OpenChangeFileExclusively());
@@ -230,8 +447,8 @@ void FileNameDatabase::Add(const vector<Fndb::Record>& records)
     std::tie(fileName, directory) = SplitPath(rec.path);
     if (InsertRecord(Record(fileName, directory, rec.fileNameInfo)))
     {
-      string s = fmt::format("+{0}{1}{2}{1}{3}\n", fileName, char(PathNameUtil::PathNameDelimiter), directory, rec.fileNameInfo);
-      fputs(s.c_str(), writer.GetFile());
+      string s = FndbChangeFile::MakeEntry(++changeFileSequenceNumber, FileNameDatabaseChangeFileEntryHeader::Add, fileName, directory, rec.fileNameInfo);
+      writer.Write(s.c_str(), s.length());
       changeFileRecordCount++;
       changeFileSize += s.length();
     }
@@ -265,8 +482,8 @@ void FileNameDatabase::Remove(const vector<PathName>& paths)
     string directory;
     std::tie(fileName, directory) = SplitPath(path);
     EraseRecord(Record(fileName, directory, ""));
-    string s = fmt::format("-{}{}{}\n", fileName, char(PathNameUtil::PathNameDelimiter), directory);
-    fputs(s.c_str(), writer.GetFile());
+    string s = FndbChangeFile::MakeEntry(++changeFileSequenceNumber, FileNameDatabaseChangeFileEntryHeader::Remove, fileName, directory, "");
+    writer.Write(s.c_str(), s.length());
     changeFileRecordCount++;
     changeFileSize += s.length();
   }
@@ -296,15 +513,13 @@ bool FileNameDatabase::FileExists(const PathName& path)
   string fileName;
   string directory;
   std::tie(fileName, directory) = SplitPath(path);
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  bool found = false;
+  ForEachRecord(MakeKey(fileName), [&found, &directory](const char* dir, const char* info)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(directory)))
-    {
-      return true;
-    }
-  }
-  return false;
+    found = PathName::Equals(PathName(dir), PathName(directory));
+    return !found;
+  });
+  return found;
 }
 
 tuple<string, string> FileNameDatabase::SplitPath(const PathName& path_) const
@@ -340,13 +555,15 @@ void FileNameDatabase::FastInsertRecord(FileNameDatabase::Record&& record)
 bool FileNameDatabase::InsertRecord(FileNameDatabase::Record&& record)
 {
   string key = MakeKey(record.fileName);
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key);
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  bool exists = false;
+  ForEachRecord(key, [&exists, &record](const char* directory, const char* info)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(record.GetDirectory())))
-    {
-      return false;
-    }
+    exists = PathName::Equals(PathName(directory), PathName(record.GetDirectory()));
+    return !exists;
+  });
+  if (exists)
+  {
+    return false;
   }
   fileNames.insert(pair<string, Record>(std::move(key), std::move(record)));
   return true;
@@ -354,58 +571,59 @@ bool FileNameDatabase::InsertRecord(FileNameDatabase::Record&& record)
 
 string FileNameDatabase::MakeKey(const string& fileName) const
 {
-  return MakeKey(PathName(fileName));
+#if defined(MIKTEX_WINDOWS)
+  if (StringUtil::IsAscii(fileName.c_str(), fileName.length()))
+  {
+    // same as PathName::TransformForComparison(), without the detour
+    string key(fileName.length(), 0);
+    StringUtil::ToLowerAscii(&key[0], fileName.c_str(), fileName.length());
+    std::replace(key.begin(), key.end(), PathNameUtil::DosDirectoryDelimiter, PathNameUtil::UnixDirectoryDelimiter);
+    return key;
+  }
+  return PathName(fileName).TransformForComparison().ToString();
+#else
+  return fileName;
+#endif
 }
 
 string FileNameDatabase::MakeKey(const PathName& fileName) const
 {
-  PathName key = fileName;
-  key.TransformForComparison();
-  return key.ToString();
+  return MakeKey(fileName.ToString());
 }
 
 void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
 {
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(record.fileName));
-  if (range.first == range.second)
+  string key = MakeKey(record.fileName);
+  PathName directory(record.GetDirectory());
+  vector<FndbWord> mappedToBeRemoved;
+  ForEachMappedRecord(key, [this, &directory, &mappedToBeRemoved](FndbWord idx, const FileNameDatabaseRecord& rec)
   {
-    FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.fileName);
-  }
+    if (PathName::Equals(PathName(GetString(rec.foDirectory)), directory))
+    {
+      mappedToBeRemoved.push_back(idx);
+    }
+    return true;
+  });
   vector<FileNameHashTable::const_iterator> toBeRemoved;
+  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key);
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(record.GetDirectory())))
+    if (PathName::Equals(PathName(it->second.GetDirectory()), directory))
     {
       toBeRemoved.push_back(it);
     }
   }
-  if (toBeRemoved.empty())
+  if (mappedToBeRemoved.empty() && toBeRemoved.empty())
   {
     FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.fileName, "directory", record.GetDirectory());
   }
+  removedRecords.insert(mappedToBeRemoved.begin(), mappedToBeRemoved.end());
   for (const auto& it : toBeRemoved)
   {
     fileNames.erase(it);
   }
 }
 
-void FileNameDatabase::ReadFileNames()
-{
-  fileNames.clear();
-  fileNames.rehash(fndbHeader->numFiles);
-  CoreStopWatch stopWatch(fmt::format("fndb read file names {}", Q_(rootDirectory)));
-  ReadFileNames(GetTable());
-}
-
-void FileNameDatabase::ReadFileNames(const FileNameDatabaseRecord* table)
-{
-  for (size_t idx = 0; idx < fndbHeader->numFiles; ++idx)
-  {
-    const FileNameDatabaseRecord* rec = &table[idx];
-    FastInsertRecord(Record(this, GetString(rec->foFileName), rec->foDirectory, rec->foInfo));
-  }
-}
-
 void FileNameDatabase::Finalize()
 {
   if (fsWatcher != nullptr)
@@ -434,7 +652,6 @@ void FileNameDatabase::Initialize(const PathName& fndbPath, const PathName& root
   fsWatcher->AddDirectories({fndbPath.GetDirectoryName()});
 
   OpenFileNameDatabase(fndbPath);
-  ReadFileNames();
 
   changeFile = fndbPath;
   changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
@@ -468,69 +685,106 @@ void FileNameDatabase::ApplyChangeFile()
   {
     return;
   }
-  MIKTEX_ASSERT(newChangeFileSize > changeFileSize);
-  CoreStopWatch stopWatch(fmt::format(T_("applying FNDB change file {0} starting at record #{1}"), Q_(changeFile), changeFileRecordCount));
   FileStream reader(File::Open(changeFile, FileMode::Open, FileAccess::Read, false));
   if (!File::TryLock(reader.GetFile(), File::LockType::Shared, 2s))
   {
     MIKTEX_FATAL_ERROR_2(T_("Could not acquire shared lock."), "path", changeFile.ToString());
   }
-  if (changeFileSize > 0)
+  ReadChangeFile(reader.GetFile());
+  File::Unlock(reader.GetFile());
+  reader.Close();
+}
+
+void FileNameDatabase::ReadChangeFile(FILE* file)
+{
+  FileNameDatabaseChangeFileHeader header;
+  if (!FndbChangeFile::ReadHeader(file, changeFile, header))
+  {
+    return;
+  }
+  if (header.id != changeFileId)
   {
-    reader.Seek(static_cast<long>(changeFileSize), SeekOrigin::Begin);
+    // another change file has been started (the previous one has been folded into the FNDB)
+    changeFileId = header.id;
+    changeFileSize = sizeof(header);
+    changeFileSequenceNumber = 0;
   }
-  for (string line; Utils::ReadLine(line, reader.GetFile(), false); )
+  // entries up to this number are contained in the FNDB file
+  FndbWord foldedSequenceNumber = fndbHeader->changeFileId == header.id ? fndbHeader->changeFileSequenceNumber : 0;
+  CoreStopWatch stopWatch("apply FNDB change file", fmt::format(T_("applying FNDB change file {0} starting at entry #{1}"), Q_(changeFile), changeFileSequenceNumber + 1));
+  if (fseek(file, static_cast<long>(changeFileSize), SEEK_SET) != 0)
   {
-    if (line.empty())
-    {
-      FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
-    }
-    changeFileRecordCount++;
-    changeFileSize += line.length() + sizeof('\n');
-    string op = line.substr(0, 1);
-    vector<string> data = StringUtil::Split(line.substr(1), PathNameUtil::PathNameDelimiter);
-    if (data.size() < 2)
+    MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", changeFile.ToString());
+  }
+  FndbChangeFile::Entry entry;
+  while (FndbChangeFile::ReadEntry(file, changeFile, entry))
+  {
+    changeFileSize = static_cast<size_t>(ftell(file));
+    if (entry.sequenceNumber <= foldedSequenceNumber)
     {
-      FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+      changeFileSequenceNumber = entry.sequenceNumber;
+      continue;
     }
-    string& fileName = data[0];
-    string& directory = data[1];
-    if (op == "+")
+    if (entry.sequenceNumber != changeFileSequenceNumber + 1)
     {
-      if (data.size() < 3)
-      {
-        FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
-      }
-      string& fileNameInfo = data[2];
-      FastInsertRecord(Record(std::move(fileName), std::move(directory), std::move(fileNameInfo)));
+      FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString(), "sequenceNumber", std::to_string(entry.sequenceNumber));
     }
-    else if (op == "-")
+    changeFileSequenceNumber = entry.sequenceNumber;
+    changeFileRecordCount++;
+    if (entry.op == FileNameDatabaseChangeFileEntryHeader::Add)
     {
-      EraseRecord(Record(std::move(fileName), std::move(directory), ""));
+      FastInsertRecord(Record(std::move(entry.fileName), std::move(entry.directory), std::move(entry.info)));
     }
     else
     {
-      FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+      EraseRecord(Record(std::move(entry.fileName), std::move(entry.directory), ""));
     }
   }
-  File::Unlock(reader.GetFile());
-  reader.Close();
 }
 
 FILE* FileNameDatabase::OpenChangeFileExclusively()
 {
-  ApplyChangeFile();
-  FileStream writer(File::Open(changeFile, FileMode::Append, FileAccess::Write, false));
+  FileStream writer(File::Open(changeFile, FileMode::Append, FileAccess::ReadWrite, false));
   if (!File::TryLock(writer.GetFile(), File::LockType::Exclusive, 2s))
   {
     MIKTEX_FATAL_ERROR_2(T_("Could not acquire exclusive lock."), "path", changeFile.ToString());
   }
+  lastAccessTime = chrono::high_resolution_clock::now();
+  if (fseek(writer.GetFile(), 0, SEEK_END) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", changeFile.ToString());
+  }
+  long size = ftell(writer.GetFile());
+  if (size == 0)
+  {
+    string header = FndbChangeFile::MakeHeader();
+    writer.Write(header.c_str(), header.length());
+    changeFileId = reinterpret_cast<const FileNameDatabaseChangeFileHeader*>(header.c_str())->id;
+    changeFileSize = header.length();
+    changeFileSequenceNumber = 0;
+  }
+  else
+  {
+    // catch up with other writers; we hold the lock, so nothing can change under us
+    ReadChangeFile(writer.GetFile());
+    if (changeFileSize != static_cast<size_t>(size))
+    {
+      FNDB_DAMAGED_2(T_("FNDB change file is incomplete."), "path", changeFile.ToString());
+    }
+    // switch from reading to writing
+    if (fseek(writer.GetFile(), 0, SEEK_END) != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", changeFile.ToString());
+    }
+  }
   return writer.Detach();
 }
 
 void FileNameDatabase::OpenFileNameDatabase(const PathName& fndbPath)
 {
-  mmap->Open(fndbPath, false);
+  // lookups hit the hash table and the records at random: read-ahead at
+  // each fault would be wasted, but all pages will be needed sooner or later
+  mmap->Open(fndbPath, false, { MemoryMappedFileHint::RandomAccess, MemoryMappedFileHint::WillNeed });
 
   if (mmap->GetSize() < sizeof(*fndbHeader))
   {
@@ -552,6 +806,24 @@ void FileNameDatabase::OpenFileNameDatabase(const PathName& fndbPath)
   {
     FNDB_DAMAGED_2(T_("Unknown file name database file version."), "path", fndbPath.ToString(), "versionFound", std::to_string(fndbHeader->Version), "versionExpected", std::to_string(FileNameDatabaseHeader::Version));
   }
+
+  // check the hash index
+  FndbWord hashTableSize = fndbHeader->hashTableSize;
+  if (hashTableSize <= fndbHeader->numFiles
+    || (hashTableSize & (hashTableSize - 1)) != 0
+    || fndbHeader->foHashTable < sizeof(*fndbHeader)
+    || fndbHeader->foHashTable + static_cast<size_t>(hashTableSize) * sizeof(FileNameDatabaseHashSlot) > foEnd)
+  {
+    FNDB_DAMAGED_2(T_("Invalid hash index."), "path", fndbPath.ToString());
+  }
+
+  // check the directory table
+  if (fndbHeader->foDirectoryTable != 0
+    && (fndbHeader->foDirectoryTable < sizeof(*fndbHeader)
+      || fndbHeader->foDirectoryTable + (static_cast<size_t>(fndbHeader->numDirs) + 1) * sizeof(FileNameDatabaseDirectoryRecord) > foEnd))
+  {
+    FNDB_DAMAGED_2(T_("Invalid directory table."), "path", fndbPath.ToString());
+  }
 }
 
 void FileNameDatabase::CloseFileNameDatabase()
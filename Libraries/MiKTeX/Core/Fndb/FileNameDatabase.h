@@ -26,7 +26,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <mutex>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <miktex/Core/Debug>
 #include <miktex/Core/DirectoryLister>
@@ -34,7 +37,9 @@
 #include <miktex/Core/Fndb>
 #include <miktex/Core/MemoryMappedFile>
 #include <miktex/Util/PathName>
+#include <miktex/Util/PathNameView>
 
+#include "Session/CompiledSearchPath.h"
 #include "fndbmem.h"
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
@@ -58,7 +63,11 @@ public:
   void OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override;
 
 public:
-  bool Search(const MiKTeX::Util::PathName& relativePath, const std::string& pathPattern, bool all, std::vector<MiKTeX::Core::Fndb::Record>& result);
+  bool Search(MiKTeX::Util::PathNameView relativePath, const std::string& pathPattern, bool all, std::vector<MiKTeX::Core::Fndb::Record>& result);
+
+  /// Searches with a pre-parsed directory pattern.
+public:
+  bool Search(MiKTeX::Util::PathNameView relativePath, const CompiledPathPattern& pathPattern, bool all, std::vector<MiKTeX::Core::Fndb::Record>& result);
 
 public:
   void Add(const std::vector<MiKTeX::Core::Fndb::Record>& records);
@@ -69,6 +78,22 @@ public:
 public:
   bool FileExists(const MiKTeX::Util::PathName& path);
 
+  // the change file should be folded into the FNDB file
+public:
+  bool NeedsCompaction() const
+  {
+    return changeFileRecordCount >= FNDB_CHANGE_FILE_COMPACTION_THRESHOLD;
+  }
+
+  // the change file should be folded into the FNDB file, so that other
+  // processes can use the mapped hash index instead of replaying the
+  // change file
+public:
+  bool NeedsPublishing() const
+  {
+    return changeFileRecordCount >= FNDB_CHANGE_FILE_PUBLISH_THRESHOLD;
+  }
+
 public:
   std::chrono::time_point<std::chrono::high_resolution_clock> GetLastAccessTime() const
   {
@@ -78,14 +103,6 @@ public:
 private:
   struct Record
   {
-  public:
-    Record(const FileNameDatabase* fndb, std::string&& fileName, FndbByteOffset foDirectory, FndbByteOffset foInfo) :
-      fndb(fndb),
-      fileName(std::move(fileName)),
-      foDirectory(foDirectory),
-      foInfo(foInfo)
-    {
-    }
   public:
     Record(const std::string& fileName, const std::string& directory, const std::string& info) :
       fileName(fileName),
@@ -101,41 +118,19 @@ private:
     {
     }
   public:
-    std::string GetDirectory() const
+    const std::string& GetDirectory() const
     {
-      if (foDirectory != 0)
-      {
-        MIKTEX_ASSERT(fndb != nullptr);
-        return fndb->GetString(foDirectory);
-      }
-      else
-      {
-        return directory;
-      }
+      return directory;
     }
   public:
-    std::string GetInfo() const
+    const std::string& GetInfo() const
     {
-      if (foInfo != 0)
-      {
-        MIKTEX_ASSERT(fndb != nullptr);
-        return fndb->GetString(foInfo);
-      }
-      else
-      {
-        return info;
-      }
+      return info;
     }
-  private:
-    const FileNameDatabase* fndb = nullptr;
   public:
     std::string fileName;
-  private:
-    FndbByteOffset foDirectory = 0;
   private:
     std::string directory;
-  private:
-    FndbByteOffset foInfo = 0;
   private:
     std::string info;
   };
@@ -143,6 +138,35 @@ private:
 private:
   std::tuple<std::string, std::string> SplitPath(const MiKTeX::Util::PathName& path) const;
 
+private:
+  bool SearchRecords(const std::string& key, MiKTeX::Util::PathNameView fileName, const char* comparablePathPattern, bool all, std::vector<MiKTeX::Core::Fndb::Record>& result);
+
+  // a path pattern translated into a range of directory records
+private:
+  struct DirectoryMatcher
+  {
+    enum class Kind
+    {
+      // directory strings must be matched
+      String,
+      // only the resolved directory matches
+      Exact,
+      // the resolved directory and its sub-tree match
+      SubTree,
+      // no mapped directory matches
+      None
+    };
+    Kind kind = Kind::String;
+    FndbWord first = 0;
+    FndbWord last = 0;
+  };
+
+private:
+  DirectoryMatcher MakeDirectoryMatcher(const char* comparablePathPattern) const;
+
+private:
+  FndbWord ResolveDirectory(const std::string& comparableDirectory) const;
+
 private:
   std::string MakeKey(const std::string& fileName) const;
 
@@ -153,16 +177,20 @@ private:
   void FastInsertRecord(Record&& record);
 
 private:
-  bool InsertRecord(Record&& record);
+  bool IsKey(const char* fileName, const std::string& key) const;
 
 private:
-  void EraseRecord(const Record& record);
-  
+  template<typename Func> void ForEachMappedRecord(const std::string& key, Func f) const;
+
 private:
-  void ReadFileNames();
+  template<typename Func> void ForEachRecord(const std::string& key, Func f) const;
 
 private:
-  void ReadFileNames(const FileNameDatabaseRecord* table);
+  bool InsertRecord(Record&& record);
+
+private:
+  void EraseRecord(const Record& record);
+  
 private:
   void Finalize();
 
@@ -201,12 +229,27 @@ private:
     return reinterpret_cast<const FileNameDatabaseRecord*>(GetPointer(fndbHeader->foTable));
   }
 
+private:
+  const FileNameDatabaseDirectoryRecord* GetDirectoryTable() const
+  {
+    return reinterpret_cast<const FileNameDatabaseDirectoryRecord*>(GetPointer(fndbHeader->foDirectoryTable));
+  }
+
+private:
+  const FileNameDatabaseHashSlot* GetHashTable() const
+  {
+    return reinterpret_cast<const FileNameDatabaseHashSlot*>(GetPointer(fndbHeader->foHashTable));
+  }
+
 private:
   void Initialize(const MiKTeX::Util::PathName& fndbPath, const MiKTeX::Util::PathName& rootDirectory, std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher);
 
 private:
   void ApplyChangeFile();
 
+private:
+  void ReadChangeFile(FILE* file);
+
 private:
   FILE* OpenChangeFileExclusively();
 
@@ -234,9 +277,22 @@ private:
 private:
   typedef std::unordered_multimap<std::string, Record> FileNameHashTable;
 
+  // records added by the change file; the records of the FNDB file
+  // itself are looked up through the mapped hash index
 private:
   FileNameHashTable fileNames;
 
+  // indexes of mapped records which have been removed by the change file
+private:
+  std::unordered_set<FndbWord> removedRecords;
+
+  // comparable directory path => directory record index
+private:
+  mutable std::unordered_map<std::string, FndbWord> resolvedDirectories;
+
+private:
+  mutable std::mutex resolvedDirectoriesMutex;
+
 private:
   std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
 
@@ -252,6 +308,14 @@ private:
 private:
   int changeFileRecordCount = 0;
 
+  // id of the change file which has been read
+private:
+  FndbWord changeFileId = 0;
+
+  // sequence number of the last change file entry which has been read
+private:
+  FndbWord changeFileSequenceNumber = 0;
+
 private:
   std::chrono::time_point<std::chrono::high_resolution_clock> lastAccessTime = std::chrono::high_resolution_clock::now();
 
@@ -61,6 +61,13 @@ void Fndb::Add(const vector<Fndb::Record>& records)
       MIKTEX_UNEXPECTED();
     }
     fndb->Add(records);
+    bool compact = fndb->NeedsCompaction() && root != session->GetNumberOfTEXMFRoots();
+    fndb = nullptr;
+    session->InvalidateFindFileMissCache();
+    if (compact)
+    {
+      CompactFileNameDatabase(pathFqFndbFileName, session->GetRootDirectoryPath(root));
+    }
   }
   else
   {
@@ -91,6 +98,14 @@ void Fndb::Remove(const vector<PathName>& paths)
     MIKTEX_UNEXPECTED();
   }
   fndb->Remove(paths);
+  bool compact = fndb->NeedsCompaction() && root != session->GetNumberOfTEXMFRoots();
+  fndb = nullptr;
+  session->InvalidateFindFileMissCache();
+  PathName pathFqFndbFileName;
+  if (compact && session->FindFilenameDatabase(root, pathFqFndbFileName))
+  {
+    CompactFileNameDatabase(pathFqFndbFileName, session->GetRootDirectoryPath(root));
+  }
 }
 
 bool Fndb::FileExists(const PathName& path)
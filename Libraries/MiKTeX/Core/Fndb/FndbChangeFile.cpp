@@ -0,0 +1,105 @@
+/**
+ * @file Fndb/FndbChangeFile.cpp
+ * @author Christian Schenk
+ * @brief FNDB change file format
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <chrono>
+#include <random>
+
+#include "internal.h"
+
+#include "FndbChangeFile.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+bool FndbChangeFile::ReadHeader(FILE* file, const PathName& path, FileNameDatabaseChangeFileHeader& header)
+{
+    if (fseek(file, 0, SEEK_SET) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString());
+    }
+    size_t n = fread(&header, 1, sizeof(header), file);
+    if (n == 0)
+    {
+        return false;
+    }
+    if (n != sizeof(header) || header.signature != FileNameDatabaseChangeFileHeader::Signature || header.version != FileNameDatabaseChangeFileHeader::Version)
+    {
+        FNDB_DAMAGED_2(T_("Not an FNDB change file."), "path", path.ToString());
+    }
+    return true;
+}
+
+bool FndbChangeFile::ReadEntry(FILE* file, const PathName& path, Entry& entry)
+{
+    FileNameDatabaseChangeFileEntryHeader entryHeader;
+    if (fread(&entryHeader, 1, sizeof(entryHeader), file) != sizeof(entryHeader))
+    {
+        return false;
+    }
+    if (entryHeader.op != FileNameDatabaseChangeFileEntryHeader::Add && entryHeader.op != FileNameDatabaseChangeFileEntryHeader::Remove)
+    {
+        FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", path.ToString(), "sequenceNumber", std::to_string(entryHeader.sequenceNumber));
+    }
+    string data(entryHeader.size, '\0');
+    if (entryHeader.size > 0 && fread(&data[0], 1, entryHeader.size, file) != entryHeader.size)
+    {
+        return false;
+    }
+    size_t end1 = data.find('\0');
+    size_t end2 = end1 == string::npos ? string::npos : data.find('\0', end1 + 1);
+    if (end2 == string::npos || data.empty() || data.back() != '\0')
+    {
+        FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", path.ToString(), "sequenceNumber", std::to_string(entryHeader.sequenceNumber));
+    }
+    entry.sequenceNumber = entryHeader.sequenceNumber;
+    entry.op = entryHeader.op;
+    entry.fileName = data.substr(0, end1);
+    entry.directory = data.substr(end1 + 1, end2 - end1 - 1);
+    entry.info = data.substr(end2 + 1, data.length() - end2 - 2);
+    return true;
+}
+
+string FndbChangeFile::MakeHeader()
+{
+    FileNameDatabaseChangeFileHeader header;
+    header.signature = FileNameDatabaseChangeFileHeader::Signature;
+    header.version = FileNameDatabaseChangeFileHeader::Version;
+    random_device rd;
+    do
+    {
+        header.id = static_cast<FndbWord>(rd() ^ chrono::high_resolution_clock::now().time_since_epoch().count());
+    } while (header.id == 0);
+    header.reserved = 0;
+    return string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+string FndbChangeFile::MakeEntry(FndbWord sequenceNumber, FndbWord op, const string& fileName, const string& directory, const string& info)
+{
+    string data;
+    data.reserve(fileName.length() + directory.length() + info.length() + 3);
+    data += fileName;
+    data += '\0';
+    data += directory;
+    data += '\0';
+    data += info;
+    data += '\0';
+    FileNameDatabaseChangeFileEntryHeader entryHeader;
+    entryHeader.sequenceNumber = sequenceNumber;
+    entryHeader.op = op;
+    entryHeader.size = static_cast<FndbWord>(data.length());
+    return string(reinterpret_cast<const char*>(&entryHeader), sizeof(entryHeader)) + data;
+}
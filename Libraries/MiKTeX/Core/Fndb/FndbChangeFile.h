@@ -0,0 +1,58 @@
+/**
+ * @file Fndb/FndbChangeFile.h
+ * @author Christian Schenk
+ * @brief FNDB change file format
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+#include <string>
+
+#include <miktex/Util/PathName>
+
+#include "fndbmem.h"
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Reads and writes FNDB change files.
+///
+/// A change file is a binary, append-only log of file name database
+/// modifications.  A torn entry at the end of the file (e.g., caused by a
+/// crash) is treated as not yet written.
+class FndbChangeFile
+{
+
+public:
+
+    struct Entry
+    {
+        FndbWord sequenceNumber = 0;
+        FndbWord op = 0;
+        std::string fileName;
+        std::string directory;
+        std::string info;
+    };
+
+    /// Reads the change file header, starting at the beginning of the file.
+    /// @return Returns `false`, if the file is empty.
+    static bool ReadHeader(FILE* file, const MiKTeX::Util::PathName& path, FileNameDatabaseChangeFileHeader& header);
+
+    /// Reads the next entry.
+    /// @return Returns `false`, if there is no complete entry.
+    static bool ReadEntry(FILE* file, const MiKTeX::Util::PathName& path, Entry& entry);
+
+    static std::string MakeHeader();
+
+    static std::string MakeEntry(FndbWord sequenceNumber, FndbWord op, const std::string& fileName, const std::string& directory, const std::string& info);
+};
+
+CORE_INTERNAL_END_NAMESPACE;
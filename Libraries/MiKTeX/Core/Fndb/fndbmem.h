@@ -1,6 +1,6 @@
 /* fndbmem.h: fndb file format                          -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -24,7 +24,12 @@
 #if !defined(A0FEBF8A9A7A419BB1230D6A7C07C5FA)
 #define A0FEBF8A9A7A419BB1230D6A7C07C5FA
 
+#include <cstring>
+
+#include <algorithm>
+
 #include <miktex/Core/Debug>
+#include <miktex/Util/StringUtil>
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
 
@@ -62,8 +67,21 @@ struct FileNameDatabaseHeader
 
   // size (in bytes) of fndb; includes header size
   FndbWord size;
-  
-  FndbWord reserved;
+
+  // pointer to the directory table (numDirs + 1 records); 0 if there is none
+  FndbByteOffset foDirectoryTable;
+
+  // pointer to the file name hash index
+  FndbByteOffset foHashTable;
+
+  // number of hash index slots (a power of two)
+  FndbWord hashTableSize;
+
+  // identifies the change file whose entries have been folded in
+  FndbWord changeFileId;
+
+  // sequence number of the last folded change file entry
+  FndbWord changeFileSequenceNumber;
 
   void Init()
   {
@@ -72,6 +90,11 @@ struct FileNameDatabaseHeader
     version = Version;
     flags = 0;
     size = sizeof(*this);
+    foDirectoryTable = 0;
+    foHashTable = 0;
+    hashTableSize = 0;
+    changeFileId = 0;
+    changeFileSequenceNumber = 0;
   }
 };
 
@@ -80,9 +103,118 @@ struct FileNameDatabaseRecord
   FndbByteOffset foFileName;
   FndbByteOffset foDirectory;
   FndbByteOffset foInfo;
-  FndbByteOffset reserved = 0;
+
+  // directory record index + 1; 0 if unknown
+  FndbWord directoryNumber = 0;
 };
 
+// the change file starts with this header; entries are appended
+struct FileNameDatabaseChangeFileHeader
+{
+  static const FndbWord Signature = 0x4c444e46; // 'FNDL' (the x86 way)
+  static const FndbWord Version = 1;
+
+  FndbWord signature;
+
+  FndbWord version;
+
+  // random number; a new change file gets a new id
+  FndbWord id;
+
+  FndbWord reserved;
+};
+
+// each change file entry starts with this header; it is followed by
+// `size` bytes: file name, directory and file name info (each one
+// null-terminated)
+struct FileNameDatabaseChangeFileEntryHeader
+{
+  static const FndbWord Add = '+';
+  static const FndbWord Remove = '-';
+
+  // consecutive numbers, starting at 1
+  FndbWord sequenceNumber;
+
+  FndbWord op;
+
+  FndbWord size;
+};
+
+// directories in depth-first order; the file records of a directory are
+// contiguous
+struct FileNameDatabaseDirectoryRecord
+{
+  // path relative to the root directory
+  FndbByteOffset foPath;
+
+  // number of sub-directories; their records follow this record
+  FndbWord numSubDirectories;
+
+  // index of the first file record
+  FndbWord firstRecord;
+
+  // number of file records
+  FndbWord numRecords;
+
+  // last write time of the directory (seconds since the epoch); 0 means:
+  // rescan unconditionally
+  FndbWord lastWriteTimeLow;
+  FndbWord lastWriteTimeHigh;
+
+  // index of the parent directory record; the root refers to itself
+  FndbWord parent;
+
+  // number of directory records in the sub-tree (excluding this one); the
+  // records of the sub-tree follow this record
+  FndbWord numDescendants;
+};
+
+// open addressing (linear probing) hash index over the record table
+struct FileNameDatabaseHashSlot
+{
+  // hash value of the comparable file name
+  FndbWord hash = 0;
+
+  // record index + 1; 0 marks an empty slot
+  FndbWord recordNumber = 0;
+};
+
+// FNV-1a over the comparable file name; ASCII letters are folded to lower
+// case so that the index does not depend on the case sensitivity of the
+// host file system
+inline FndbWord FndbHash(const char* fileName, std::size_t length)
+{
+  FndbWord hash = 2166136261u;
+  char folded[64];
+  for (std::size_t pos = 0; pos < length; pos += sizeof(folded))
+  {
+    std::size_t n = std::min(sizeof(folded), length - pos);
+    MiKTeX::Util::StringUtil::ToLowerAscii(folded, fileName + pos, n);
+    for (std::size_t idx = 0; idx < n; ++idx)
+    {
+      hash ^= static_cast<unsigned char>(folded[idx]);
+      hash *= 16777619u;
+    }
+  }
+  return hash;
+}
+
+inline FndbWord FndbHash(const char* fileName)
+{
+  return FndbHash(fileName, strlen(fileName));
+}
+
+inline FndbWord FndbHashTableSize(FndbWord numFiles)
+{
+  // keep the load factor below 0.5
+  FndbWord size = 16;
+  while (size < 2 * numFiles)
+  {
+    size <<= 1;
+  }
+  return size;
+}
+
 CORE_INTERNAL_END_NAMESPACE;
 
 #endif
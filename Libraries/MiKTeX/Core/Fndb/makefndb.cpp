@@ -21,17 +21,35 @@
 
 #include "config.h"
 
+#if defined(MIKTEX_WINDOWS)
+#include <Windows.h>
+#include <psapi.h>
+#include <io.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <mutex>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
-#include <unordered_set>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Directory>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/LockFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/TemporaryFile>
 
@@ -42,10 +60,12 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "FndbChangeFile.h"
 #include "fndbmem.h"
 
 using namespace std;
 
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
@@ -54,11 +74,227 @@ const uint8_t null_byte = 0;
 
 #define FN_MIKTEXIGNORE ".miktexignore"
 
+/// Pool of the strings which go into an FNDB.
+///
+/// Each distinct string is stored once, in large blocks which never move;
+/// the hash table holds pointers into the blocks, not copies.  In front of
+/// each string, there is room for the string's offset in the FNDB image,
+/// i.e., the image needs no map of its own to pool strings.
+class StringArena
+{
+public:
+  const char* Intern(string_view s);
+
+public:
+  static FndbByteOffset GetOffset(const char* s)
+  {
+    FndbByteOffset fo;
+    memcpy(&fo, s - sizeof(fo), sizeof(fo));
+    return fo;
+  }
+
+public:
+  static void SetOffset(const char* s, FndbByteOffset fo)
+  {
+    memcpy(const_cast<char*>(s) - sizeof(fo), &fo, sizeof(fo));
+  }
+
+public:
+  void ClearOffsets();
+
+public:
+  size_t GetCount() const
+  {
+    return count;
+  }
+
+public:
+  size_t GetMemoryUsage() const
+  {
+    return allocated + table.capacity() * sizeof(table[0]);
+  }
+
+private:
+  char* Allocate(size_t size);
+
+private:
+  void Grow();
+
+private:
+  static constexpr size_t BLOCK_SIZE = 1024 * 1024;
+
+private:
+  vector<unique_ptr<char[]>> blocks;
+
+private:
+  char* blockTop = nullptr;
+
+private:
+  size_t blockLeft = 0;
+
+private:
+  size_t allocated = 0;
+
+private:
+  vector<const char*> table;
+
+private:
+  size_t count = 0;
+};
+
+const char* StringArena::Intern(string_view s)
+{
+  if ((count + 1) * 4 > table.size() * 3)
+  {
+    Grow();
+  }
+  size_t mask = table.size() - 1;
+  size_t slot = hash<string_view>()(s) & mask;
+  while (table[slot] != nullptr)
+  {
+    if (s == table[slot])
+    {
+      return table[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+  char* p = Allocate(sizeof(FndbByteOffset) + s.size() + 1) + sizeof(FndbByteOffset);
+  memcpy(p, s.data(), s.size());
+  p[s.size()] = 0;
+  SetOffset(p, 0);
+  table[slot] = p;
+  ++count;
+  return p;
+}
+
+void StringArena::ClearOffsets()
+{
+  for (const char* s : table)
+  {
+    if (s != nullptr)
+    {
+      SetOffset(s, 0);
+    }
+  }
+}
+
+char* StringArena::Allocate(size_t size)
+{
+  if (size > blockLeft)
+  {
+    size_t blockSize = std::max(size, BLOCK_SIZE);
+    blocks.push_back(make_unique<char[]>(blockSize));
+    blockTop = blocks.back().get();
+    blockLeft = blockSize;
+    allocated += blockSize;
+  }
+  char* p = blockTop;
+  blockTop += size;
+  blockLeft -= size;
+  return p;
+}
+
+void StringArena::Grow()
+{
+  vector<const char*> newTable(table.empty() ? 1024 : table.size() * 2, nullptr);
+  size_t mask = newTable.size() - 1;
+  for (const char* s : table)
+  {
+    if (s != nullptr)
+    {
+      size_t slot = hash<string_view>()(string_view(s)) & mask;
+      while (newTable[slot] != nullptr)
+      {
+        slot = (slot + 1) & mask;
+      }
+      newTable[slot] = s;
+    }
+  }
+  table.swap(newTable);
+}
+
 struct FILENAMEINFO
 {
-  string FileName;
-  const string* Directory = nullptr;
-  const string* Info = nullptr;
+  const char* FileName = nullptr;
+  const char* Directory = nullptr;
+  const char* Info = nullptr;
+  FndbWord DirectoryNumber = 0;
+};
+
+struct DirectoryNode
+{
+  PathName parentPath;
+  PathName folderName;
+  size_t level = 0;
+  string directory;
+  vector<string> subDirectoryNames;
+  vector<string> fileNames;
+  vector<string> fileNameInfos;
+  vector<unique_ptr<DirectoryNode>> children;
+  time_t lastWriteTime = 0;
+  // the same directory in the existing FNDB (incremental refresh)
+  DirectoryNode* previous = nullptr;
+};
+
+class FndbManager;
+
+/// Walks a directory tree with a pool of threads.
+///
+/// Each directory is a task; a thread pushes the sub-directories it
+/// discovers onto its own queue and steals from the other queues when it
+/// runs dry.  The tree of `DirectoryNode` objects preserves the listing
+/// order, i.e., the result does not depend on the scheduling.
+class ParallelDirectoryWalker
+{
+public:
+  ParallelDirectoryWalker(FndbManager& manager, unsigned numThreads) :
+    manager(manager),
+    queues(numThreads)
+  {
+  }
+
+public:
+  void Run(DirectoryNode& root);
+
+private:
+  void Push(unsigned id, DirectoryNode* node);
+
+private:
+  bool TryPop(unsigned id, DirectoryNode*& node);
+
+private:
+  void Work(unsigned id);
+
+private:
+  struct WorkQueue
+  {
+    mutex mtx;
+    deque<DirectoryNode*> tasks;
+  };
+
+private:
+  FndbManager& manager;
+
+private:
+  vector<WorkQueue> queues;
+
+private:
+  atomic<size_t> pending{ 0 };
+
+private:
+  atomic_bool failed{ false };
+
+private:
+  mutex errorMutex;
+
+private:
+  exception_ptr error;
+
+private:
+  mutex idleMutex;
+
+private:
+  condition_variable idleCondition;
 };
 
 class FndbManager
@@ -71,7 +307,7 @@ public:
   }
 
 public:
-  bool Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
+  bool Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, bool incremental);
 
 private:
   void* GetMemPointer()
@@ -126,6 +362,9 @@ private:
 private:
   FndbByteOffset PushBack(const char* data);
 
+private:
+  void TracePeakMemory();
+
 private:
   void AlignMem(size_t align = 8);
 
@@ -133,10 +372,37 @@ private:
   static void GetIgnorableFiles(const PathName& dirPath, vector<string>& filesToBeIgnored);
 
 public:
-  void ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp);
+  void ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<string>& fileNames, bool doCleanUp);
+
+public:
+  void ProcessDirectory(DirectoryNode& node);
+
+private:
+  void CollectFiles(vector<FILENAMEINFO>& fileNames, vector<pair<const char*, FileNameDatabaseDirectoryRecord>>& directories);
+
+private:
+  void MergeFiles(const DirectoryNode& node, vector<FILENAMEINFO>& fileNames, vector<pair<const char*, FileNameDatabaseDirectoryRecord>>& directories, FndbWord parent = 0);
+
+public:
+  bool Compact(const PathName& fndbPath, const PathName& rootPath);
+
+public:
+  bool Seed(const PathName& seedPath, const PathName& fndbPath, const PathName& rootPath);
 
 private:
-  void CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames);
+  void Write(const PathName& fndbPath, unsigned rootIdx, const vector<FILENAMEINFO>& fileNames, vector<pair<const char*, FileNameDatabaseDirectoryRecord>>& directories, FndbWord changeFileId, FndbWord changeFileSequenceNumber);
+
+private:
+  static DirectoryNode* FindDirectory(DirectoryNode& root, unordered_map<string, DirectoryNode*>& directoryMap, const string& directory);
+
+private:
+  unique_ptr<DirectoryNode> LoadPreviousDirectories(const PathName& fndbPath, FileNameDatabaseHeader* header);
+
+private:
+  static unique_ptr<DirectoryNode> ParsePreviousDirectory(const vector<unsigned char>& bytes, const FileNameDatabaseHeader& header, FndbWord& directoryIndex, size_t level);
+
+private:
+  unsigned GetNumberOfThreads();
 
 private:
   PathName rootPath;
@@ -147,9 +413,6 @@ private:
 private:
   size_t deepestLevel;
 
-private:
-  size_t currentLevel;
-
 private:
   size_t numDirectories;
 
@@ -157,16 +420,22 @@ private:
   size_t numFiles;
 
 private:
-  ICreateFndbCallback* callback;
+  unique_ptr<DirectoryNode> previousRoot;
+
+private:
+  time_t scanStartTime;
 
 private:
-  unordered_set<string> stringPool;
-  
+  atomic<size_t> numReusedDirectories{ 0 };
+
+private:
+  ICreateFndbCallback* callback;
+
 private:
-  typedef unordered_map<string, FndbByteOffset> StringMap;
+  mutex callbackMutex;
 
 private:
-  StringMap stringMap;
+  StringArena strings;
 
 private:
   bool enableStringPooling;
@@ -184,61 +453,37 @@ private:
 FndbByteOffset FndbManager::ReserveMem(size_t size)
 {
   FndbByteOffset ret = GetMemTop();
-  byteArray.reserve(byteArray.size() + size);
-  for (size_t i = 0; i < size; ++i)
-  {
-    byteArray.push_back(null_byte);
-  }
+  byteArray.resize(byteArray.size() + size, null_byte);
   return ret;
 }
 
 FndbByteOffset FndbManager::PushBack(FndbWord data)
 {
   AlignMem(sizeof(FndbWord));
-  const uint8_t* byteArray = reinterpret_cast<const uint8_t*>(&data);
-  if (sizeof(FndbWord) == 4)
-  {
-    FndbByteOffset ret = GetMemTop();
-    FastPushBack(byteArray[0]);
-    FastPushBack(byteArray[1]);
-    FastPushBack(byteArray[2]);
-    FastPushBack(byteArray[3]);
-    return ret;
-  }
-  else
-  {
-    return PushBack(byteArray, sizeof(FndbWord));
-  }
+  return PushBack(&data, sizeof(FndbWord));
 }
 
 FndbByteOffset FndbManager::PushBack(const void* data, size_t size)
 {
   FndbByteOffset ret = GetMemTop();
-  const uint8_t* byteArray = reinterpret_cast<const uint8_t*>(data);
-  for (size_t i = 0; i < size; ++i)
-  {
-    FastPushBack(byteArray[i]);
-  }
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(data);
+  byteArray.insert(byteArray.end(), begin, begin + size);
   return ret;
 }
 
+// data must have been interned: equal strings are identical
 FndbByteOffset FndbManager::PushBack(const char* data)
 {
-  if (enableStringPooling)
+  MIKTEX_ASSERT(data != nullptr);
+  // offset 0 is the header, i.e., never a string
+  if (enableStringPooling && StringArena::GetOffset(data) != 0)
   {
-    StringMap::const_iterator it = stringMap.find(data);
-    if (it != stringMap.end())
-    {
-      return it->second;
-    }
+    return StringArena::GetOffset(data);
   }
-  FndbByteOffset ret = GetMemTop();
-  MIKTEX_ASSERT(data != nullptr);
-  PushBack(data, strlen(data));
-  FastPushBack(null_byte);
+  FndbByteOffset ret = PushBack(data, strlen(data) + 1);
   if (enableStringPooling)
   {
-    stringMap[data] = ret;
+    StringArena::SetOffset(data, ret);
   }
   return ret;
 }
@@ -268,7 +513,7 @@ void FndbManager::GetIgnorableFiles(const PathName& dirPath, vector<string>& fil
   sort(filesToBeIgnored.begin(), filesToBeIgnored.end(), StringComparerIgnoringCase());
 }
 
-void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp)
+void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<string>& fileNames, bool doCleanUp)
 {
   if (!Directory::Exists(dirPath))
   {
@@ -277,42 +522,37 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   }
   vector<string> filesToBeIgnored;
   GetIgnorableFiles(dirPath, filesToBeIgnored);
-  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(dirPath);
-  DirectoryEntry entry;
-  vector<DirectoryEntry> toBeDeleted;
-  PathName directory(Utils::GetRelativizedPath(dirPath.GetData(), rootPath.GetData()));
-  directory = directory.ToUnix();
-  while (lister->GetNext(entry))
+  DirectoryListing listing;
+  DirectoryLister::ReadAll(dirPath, (int)DirectoryLister::Options::None, listing);
+  vector<size_t> toBeDeleted;
+  for (size_t idx = 0; idx < listing.GetCount(); ++idx)
   {
-    if (binary_search(filesToBeIgnored.begin(), filesToBeIgnored.end(), entry.name, StringComparerIgnoringCase()))
+    const char* name = listing.GetName(idx);
+    if (!filesToBeIgnored.empty() && binary_search(filesToBeIgnored.begin(), filesToBeIgnored.end(), string(name), StringComparerIgnoringCase()))
     {
       continue;
     }
-    if (doCleanUp && PathName(entry.name).HasExtension(MIKTEX_TO_BE_DELETED_FILE_SUFFIX))
+    if (doCleanUp && PathName(name).HasExtension(MIKTEX_TO_BE_DELETED_FILE_SUFFIX))
     {
-      toBeDeleted.push_back(entry);
+      toBeDeleted.push_back(idx);
     }
-    else if (entry.isDirectory)
+    else if (listing.IsDirectory(idx))
     {
-      subDirectoryNames.push_back(entry.name);
+      subDirectoryNames.push_back(name);
     }
     else
     {
-      FILENAMEINFO filenameinfo;
-      filenameinfo.FileName = entry.name;
-      filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
-      fileNames.push_back(filenameinfo);
+      fileNames.push_back(name);
     }
   }
-  lister->Close();
 
   // silent clean-up
-  for (const DirectoryEntry& e : toBeDeleted)
+  for (size_t idx : toBeDeleted)
   {
     try
     {
-      PathName path(dirPath / e.name);
-      if (e.isDirectory)
+      PathName path(dirPath / listing.GetName(idx));
+      if (listing.IsDirectory(idx))
       {
         Directory::Delete(path, true);
       }
@@ -327,140 +567,480 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   }
 }
 
-void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames)
+void FndbManager::ProcessDirectory(DirectoryNode& node)
 {
-  if (currentLevel > deepestLevel)
-  {
-    deepestLevel = currentLevel;
-  }
-
-  vector<string> subDirectoryNames;
-  subDirectoryNames.reserve(40);
-
   bool done = false;
 
-  PathName path(parentPath / folderName.ToString());
+  PathName path(node.parentPath / node.folderName.ToString());
   path.MakeFullyQualified();
 
   PathName directory(Utils::GetRelativizedPath(path.GetData(), rootPath.GetData()));
-  directory = directory.ToUnix();
+  node.directory = directory.ToUnix().ToString();
 
   if (callback != nullptr)
   {
-    if (!callback->OnProgress(static_cast<unsigned>(currentLevel), path))
+    // the callback need not be thread-safe
+    lock_guard<mutex> lockGuard(callbackMutex);
+    if (!callback->OnProgress(static_cast<unsigned>(node.level), path))
     {
       throw OperationCancelledException();
     }
-    vector<string> subDirs;
-    vector<string> files;
-    vector<string> infos;
-    done = callback->ReadDirectory(path, subDirs, files, infos);
+    done = callback->ReadDirectory(path, node.subDirectoryNames, node.fileNames, node.fileNameInfos);
     if (done)
     {
-      subDirectoryNames = subDirs;
-      MIKTEX_ASSERT(files.size() == infos.size());
-      for (int i = 0; i < files.size(); ++i)
-      {
-        FILENAMEINFO filenameinfo;
-        filenameinfo.FileName = files[i];
-        filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
-        filenameinfo.Info = &*stringPool.insert(infos[i]).first;
-        fileNames.push_back(filenameinfo);
-      }
+      MIKTEX_ASSERT(node.fileNames.size() == node.fileNameInfos.size());
+    }
+    else
+    {
+      node.subDirectoryNames.clear();
+      node.fileNames.clear();
+      node.fileNameInfos.clear();
     }
   }
 
+  DirectoryNode* previous = node.previous;
+  bool reused = false;
+
   if (!done)
   {
-    ReadDirectory(path, subDirectoryNames, fileNames, true);
+    // take the timestamp before listing, so that concurrent changes are seen next time
+    time_t lastWriteTime = Directory::Exists(path) ? File::GetLastWriteTime(path) : 0;
+    if (previous != nullptr && previous->lastWriteTime != 0 && previous->lastWriteTime == lastWriteTime)
+    {
+      node.subDirectoryNames = std::move(previous->subDirectoryNames);
+      node.fileNames = std::move(previous->fileNames);
+      reused = true;
+      ++numReusedDirectories;
+    }
+    else
+    {
+      ReadDirectory(path, node.subDirectoryNames, node.fileNames, true);
+    }
+    // timestamps have a coarse resolution: don't trust recent ones
+    node.lastWriteTime = lastWriteTime + 1 >= scanStartTime ? 0 : lastWriteTime;
+  }
+
+  unordered_map<string, DirectoryNode*> previousChildren;
+  if (previous != nullptr && !reused)
+  {
+    for (const unique_ptr<DirectoryNode>& child : previous->children)
+    {
+      previousChildren[child->folderName.ToString()] = child.get();
+    }
+  }
+
+  PathName pathFolder(node.parentPath / node.folderName.ToString());
+  node.children.reserve(node.subDirectoryNames.size());
+  for (size_t i = 0; i < node.subDirectoryNames.size(); ++i)
+  {
+    const string& s = node.subDirectoryNames[i];
+    unique_ptr<DirectoryNode> child = make_unique<DirectoryNode>();
+    child->parentPath = pathFolder;
+    child->folderName = s;
+    child->level = node.level + 1;
+    if (reused)
+    {
+      child->previous = previous->children[i].get();
+    }
+    else if (auto it = previousChildren.find(s); it != previousChildren.end())
+    {
+      child->previous = it->second;
+    }
+    node.children.push_back(std::move(child));
+  }
+}
+
+unique_ptr<DirectoryNode> FndbManager::ParsePreviousDirectory(const vector<unsigned char>& bytes, const FileNameDatabaseHeader& header, FndbWord& directoryIndex, size_t level)
+{
+  auto getString = [&bytes, &header](FndbByteOffset fo)
+  {
+    if (fo >= header.size || memchr(&bytes[fo], 0, header.size - fo) == nullptr)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    return string(reinterpret_cast<const char*>(&bytes[fo]));
+  };
+  if (directoryIndex > header.numDirs || level > header.depth)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  FileNameDatabaseDirectoryRecord dirRec;
+  memcpy(&dirRec, &bytes[header.foDirectoryTable + directoryIndex * sizeof(dirRec)], sizeof(dirRec));
+  ++directoryIndex;
+  if (static_cast<uint64_t>(dirRec.firstRecord) + dirRec.numRecords > header.numFiles)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  unique_ptr<DirectoryNode> node = make_unique<DirectoryNode>();
+  node->directory = getString(dirRec.foPath);
+  node->folderName = PathName(node->directory).GetFileName();
+  node->level = level;
+  node->lastWriteTime = static_cast<time_t>((static_cast<uint64_t>(dirRec.lastWriteTimeHigh) << 32) | dirRec.lastWriteTimeLow);
+  node->fileNames.reserve(dirRec.numRecords);
+  bool haveInfos = false;
+  for (FndbWord idx = 0; idx < dirRec.numRecords; ++idx)
+  {
+    FileNameDatabaseRecord rec;
+    memcpy(&rec, &bytes[header.foTable + (dirRec.firstRecord + idx) * sizeof(rec)], sizeof(rec));
+    node->fileNames.push_back(getString(rec.foFileName));
+    node->fileNameInfos.push_back(getString(rec.foInfo));
+    haveInfos = haveInfos || !node->fileNameInfos.back().empty();
+  }
+  if (!haveInfos)
+  {
+    node->fileNameInfos.clear();
+  }
+  node->children.reserve(dirRec.numSubDirectories);
+  for (FndbWord idx = 0; idx < dirRec.numSubDirectories; ++idx)
+  {
+    // RECURSION
+    node->children.push_back(ParsePreviousDirectory(bytes, header, directoryIndex, level + 1));
+    node->subDirectoryNames.push_back(node->children.back()->folderName.ToString());
   }
+  return node;
+}
 
-  numDirectories += subDirectoryNames.size();
+unique_ptr<DirectoryNode> FndbManager::LoadPreviousDirectories(const PathName& fndbPath, FileNameDatabaseHeader* header_)
+{
+  if (!File::Exists(fndbPath))
+  {
+    return nullptr;
+  }
+  try
+  {
+    vector<unsigned char> bytes = File::ReadAllBytes(fndbPath);
+    FileNameDatabaseHeader header;
+    if (bytes.size() < sizeof(header))
+    {
+      return nullptr;
+    }
+    memcpy(&header, bytes.data(), sizeof(header));
+    if (header.signature != FileNameDatabaseHeader::Signature
+      || header.version != FileNameDatabaseHeader::Version
+      || header.foDirectoryTable == 0
+      || header.size > bytes.size()
+      || header.foTable + static_cast<uint64_t>(header.numFiles) * sizeof(FileNameDatabaseRecord) > header.size
+      || header.foDirectoryTable + (static_cast<uint64_t>(header.numDirs) + 1) * sizeof(FileNameDatabaseDirectoryRecord) > header.size)
+    {
+      trace_fndb->WriteLine("core", fmt::format(T_("{0} has no usable directory table"), Q_(fndbPath)));
+      return nullptr;
+    }
+    FndbWord directoryIndex = 0;
+    unique_ptr<DirectoryNode> root = ParsePreviousDirectory(bytes, header, directoryIndex, 0);
+    if (directoryIndex != header.numDirs + 1)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    if (header_ != nullptr)
+    {
+      *header_ = header;
+    }
+    return root;
+  }
+  catch (const exception& e)
+  {
+    trace_fndb->WriteLine("core", TraceLevel::Error, fmt::format(T_("{0} cannot be used for an incremental refresh: {1}"), Q_(fndbPath), e.what()));
+    return nullptr;
+  }
+}
 
-  // recurse into sub-directories
-  PathName pathFolder(parentPath / folderName.ToString());
-  size_t i = 0;
-  ++currentLevel;
-  for (const string& s : subDirectoryNames)
+void FndbManager::MergeFiles(const DirectoryNode& node, vector<FILENAMEINFO>& fileNames, vector<pair<const char*, FileNameDatabaseDirectoryRecord>>& directories, FndbWord parent)
+{
+  if (node.level > deepestLevel)
+  {
+    deepestLevel = node.level;
+  }
+  numDirectories += node.children.size();
+  FileNameDatabaseDirectoryRecord dirRec;
+  dirRec.foPath = 0;
+  dirRec.numSubDirectories = static_cast<FndbWord>(node.children.size());
+  dirRec.firstRecord = static_cast<FndbWord>(fileNames.size());
+  dirRec.numRecords = static_cast<FndbWord>(node.fileNames.size());
+  uint64_t lastWriteTime = static_cast<uint64_t>(node.lastWriteTime);
+  dirRec.lastWriteTimeLow = static_cast<FndbWord>(lastWriteTime & 0xffffffff);
+  dirRec.lastWriteTimeHigh = static_cast<FndbWord>(lastWriteTime >> 32);
+  dirRec.parent = parent;
+  dirRec.numDescendants = 0;
+  FndbWord myIndex = static_cast<FndbWord>(directories.size());
+  const char* directory = strings.Intern(node.directory);
+  directories.push_back({ directory, dirRec });
+  const char* noInfo = strings.Intern("");
+  for (size_t i = 0; i < node.fileNames.size(); ++i)
+  {
+    FILENAMEINFO filenameinfo;
+    filenameinfo.FileName = strings.Intern(node.fileNames[i]);
+    filenameinfo.Directory = directory;
+    filenameinfo.DirectoryNumber = myIndex + 1;
+    filenameinfo.Info = node.fileNameInfos.empty() ? noInfo : strings.Intern(node.fileNameInfos[i]);
+    fileNames.push_back(filenameinfo);
+  }
+  for (const unique_ptr<DirectoryNode>& child : node.children)
   {
     // RECURSION
-    CollectFiles(pathFolder, PathName(s), fileNames);
-    ++i;
+    MergeFiles(*child, fileNames, directories, myIndex);
+  }
+  directories[myIndex].second.numDescendants = static_cast<FndbWord>(directories.size() - myIndex - 1);
+}
+
+unsigned FndbManager::GetNumberOfThreads()
+{
+  int n = SESSION_IMPL()->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FNDB_THREADS, ConfigValue(0)).GetInt();
+  if (n > 0)
+  {
+    return static_cast<unsigned>(n);
+  }
+  // directory listings are latency-bound, especially on network file systems
+  return std::max(thread::hardware_concurrency(), 4u);
+}
+
+void FndbManager::CollectFiles(vector<FILENAMEINFO>& fileNames, vector<pair<const char*, FileNameDatabaseDirectoryRecord>>& directories)
+{
+  DirectoryNode root;
+  root.parentPath = rootPath;
+  root.folderName = CURRENT_DIRECTORY;
+  root.previous = previousRoot.get();
+  unsigned numThreads = GetNumberOfThreads();
+  trace_fndb->WriteLine("core", fmt::format(T_("collecting files with {0} thread(s)"), numThreads));
+  ParallelDirectoryWalker walker(*this, numThreads);
+  walker.Run(root);
+  previousRoot = nullptr;
+  MergeFiles(root, fileNames, directories);
+  if (root.previous != nullptr)
+  {
+    trace_fndb->WriteLine("core", fmt::format(T_("{0} of {1} directories were unchanged"), numReusedDirectories.load(), directories.size()));
+  }
+}
+
+void ParallelDirectoryWalker::Push(unsigned id, DirectoryNode* node)
+{
+  ++pending;
+  {
+    lock_guard<mutex> lockGuard(queues[id].mtx);
+    queues[id].tasks.push_back(node);
   }
-  --currentLevel;
+  idleCondition.notify_one();
 }
 
-bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+bool ParallelDirectoryWalker::TryPop(unsigned id, DirectoryNode*& node)
 {
-  trace_fndb->WriteLine("core", fmt::format(T_("creating fndb file {0}..."), Q_(fndbPath)));
+  {
+    // own queue: newest first (depth-first)
+    lock_guard<mutex> lockGuard(queues[id].mtx);
+    if (!queues[id].tasks.empty())
+    {
+      node = queues[id].tasks.back();
+      queues[id].tasks.pop_back();
+      return true;
+    }
+  }
+  for (size_t i = 1; i < queues.size(); ++i)
+  {
+    // steal: oldest first (largest sub-trees)
+    WorkQueue& victim = queues[(id + i) % queues.size()];
+    lock_guard<mutex> lockGuard(victim.mtx);
+    if (!victim.tasks.empty())
+    {
+      node = victim.tasks.front();
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParallelDirectoryWalker::Work(unsigned id)
+{
+  while (true)
+  {
+    DirectoryNode* node;
+    if (TryPop(id, node))
+    {
+      if (!failed)
+      {
+        try
+        {
+          manager.ProcessDirectory(*node);
+          for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+          {
+            Push(id, it->get());
+          }
+        }
+        catch (...)
+        {
+          lock_guard<mutex> lockGuard(errorMutex);
+          if (error == nullptr)
+          {
+            error = current_exception();
+          }
+          failed = true;
+        }
+      }
+      if (--pending == 0)
+      {
+        idleCondition.notify_all();
+      }
+      continue;
+    }
+    if (pending == 0)
+    {
+      return;
+    }
+    unique_lock<mutex> lock(idleMutex);
+    idleCondition.wait_for(lock, chrono::milliseconds(1));
+  }
+}
+
+void ParallelDirectoryWalker::Run(DirectoryNode& root)
+{
+  Push(0, &root);
+  vector<thread> threads;
+  for (unsigned id = 1; id < queues.size(); ++id)
+  {
+    threads.push_back(thread(&ParallelDirectoryWalker::Work, this, id));
+  }
+  Work(0);
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  if (error != nullptr)
+  {
+    rethrow_exception(error);
+  }
+}
+
+void FndbManager::Write(const PathName& fndbPath, unsigned rootIdx, const vector<FILENAMEINFO>& fileNames, vector<pair<const char*, FileNameDatabaseDirectoryRecord>>& directories, FndbWord changeFileId, FndbWord changeFileSequenceNumber)
+{
+  byteArray.clear();
+  byteArray.reserve(2 * 1024 * 1024);
+  strings.ClearOffsets();
+  ReserveMem(sizeof(FileNameDatabaseHeader));
+  FileNameDatabaseHeader fndb;
+  fndb.Init();
+  numFiles = fileNames.size();
+  AlignMem();
+  fndb.foTable = ReserveMem(fileNames.size() * sizeof(FileNameDatabaseRecord));
+  AlignMem();
+  fndb.hashTableSize = FndbHashTableSize(static_cast<FndbWord>(fileNames.size()));
+  vector<FileNameDatabaseHashSlot> hashTable(fndb.hashTableSize);
+  FndbWord mask = fndb.hashTableSize - 1;
+  for (size_t idx = 0; idx < fileNames.size(); ++idx)
+  {
+    FndbWord hash = FndbHash(PathName(fileNames[idx].FileName).TransformForComparison().GetData());
+    FndbWord slot = hash & mask;
+    while (hashTable[slot].recordNumber != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+    hashTable[slot].hash = hash;
+    hashTable[slot].recordNumber = static_cast<FndbWord>(idx + 1);
+  }
+  fndb.foHashTable = PushBack(hashTable.data(), hashTable.size() * sizeof(FileNameDatabaseHashSlot));
+  AlignMem();
+  fndb.foDirectoryTable = ReserveMem(directories.size() * sizeof(FileNameDatabaseDirectoryRecord));
+  AlignMem();
+  fndb.foStrings = GetMemTop();
+  for (size_t idx = 0; idx < fileNames.size(); ++idx)
+  {
+    FileNameDatabaseRecord rec;
+    rec.foFileName = PushBack(fileNames[idx].FileName);
+    rec.foDirectory = PushBack(fileNames[idx].Directory);
+    rec.foInfo = PushBack(fileNames[idx].Info);
+    rec.directoryNumber = fileNames[idx].DirectoryNumber;
+    SetMem(static_cast<unsigned>(fndb.foTable + idx * sizeof(rec)), &rec, sizeof(rec));
+  }
+  for (size_t idx = 0; idx < directories.size(); ++idx)
+  {
+    FileNameDatabaseDirectoryRecord& dirRec = directories[idx].second;
+    dirRec.foPath = PushBack(directories[idx].first);
+    SetMem(static_cast<unsigned>(fndb.foDirectoryTable + idx * sizeof(dirRec)), &dirRec, sizeof(dirRec));
+  }
+  fndb.numDirs = static_cast<unsigned>(numDirectories);
+  fndb.numFiles = static_cast<unsigned>(numFiles);
+  fndb.depth = static_cast<unsigned>(deepestLevel);
+  fndb.changeFileId = changeFileId;
+  fndb.changeFileSequenceNumber = changeFileSequenceNumber;
+  fndb.size = GetMemTop();
+  AlignMem(FNDB_PAGESIZE);
+  SetMem(0, &fndb, sizeof(fndb));
+  TracePeakMemory();
+
+  // <fixme>
+  bool unloaded = false;
+  for (size_t i = 0; !unloaded && i < 100; ++i)
+  {
+    unloaded = SESSION_IMPL()->UnloadFilenameDatabaseInternal(rootIdx, chrono::seconds(0));
+    if (!unloaded)
+    {
+      trace_fndb->WriteLine("core", "sleep for 1ms");
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+  }
+  if (!unloaded)
+  {
+    MIKTEX_FATAL_ERROR(T_("fndb cannot be unloaded"));
+  }
+  // </fixme>
+
+  // the new FNDB gets a name when it is complete: an interrupted rebuild
+  // leaves nothing behind
+  Directory::Create(fndbPath.GetDirectoryName());
+  FileStream streamFndb(TemporaryFile::OpenAnonymous(fndbPath.GetDirectoryName(), 0));
+  streamFndb.Write(reinterpret_cast<const char*>(GetMemPointer()), GetMemTop());
+  if (File::Exists(fndbPath))
+  {
+    File::Delete(fndbPath, { FileDeleteOption::TryHard });
+  }
+  TemporaryFile::LinkIntoPlace(streamFndb.GetFile(), fndbPath);
+  streamFndb.Close();
+}
+
+void FndbManager::TracePeakMemory()
+{
+  size_t peak = 0;
+#if defined(MIKTEX_WINDOWS)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    peak = counters.PeakWorkingSetSize;
+  }
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+#if defined(__APPLE__)
+    peak = static_cast<size_t>(usage.ru_maxrss);
+#else
+    peak = static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+  }
+#endif
+  trace_fndb->WriteLine("core", fmt::format(T_("{0} distinct strings, string arena: {1} KB, fndb image: {2} KB, peak process memory: {3} KB"),
+    strings.GetCount(), strings.GetMemoryUsage() / 1024, byteArray.capacity() / 1024, peak / 1024));
+}
+
+bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, bool incremental)
+{
+  trace_fndb->WriteLine("core", fmt::format(incremental ? T_("refreshing fndb file {0}...") : T_("creating fndb file {0}..."), Q_(fndbPath)));
   unsigned rootIdx = SESSION_IMPL()->DeriveTEXMFRoot(rootPath);
   this->rootPath = rootPath;
   this->enableStringPooling = enableStringPooling;
   this->storeFileNameInfo = storeFileNameInfo;
-  byteArray.reserve(2 * 1024 * 1024);
   try
   {
-    ReserveMem(sizeof(FileNameDatabaseHeader));
-    FileNameDatabaseHeader fndb;
-    fndb.Init();
     numDirectories = 0;
     numFiles = 0;
     deepestLevel = 0;
-    currentLevel = 0;
     this->callback = callback;
-    vector<FILENAMEINFO> fileNames;
-    CollectFiles(rootPath, PathName(CURRENT_DIRECTORY), fileNames);
-    numFiles = fileNames.size();
-    AlignMem();
-    fndb.foTable = ReserveMem(fileNames.size() * sizeof(FileNameDatabaseRecord));
-    AlignMem();
-    fndb.foStrings = GetMemTop();
-    for (size_t idx = 0; idx < fileNames.size(); ++idx)
-    {
-      FileNameDatabaseRecord rec;
-      rec.foFileName = PushBack(fileNames[idx].FileName.c_str());
-      rec.foDirectory = PushBack(fileNames[idx].Directory->c_str());
-      rec.foInfo = PushBack(fileNames[idx].Info == nullptr ? "" : fileNames[idx].Info->c_str());
-      SetMem(static_cast<unsigned>(fndb.foTable + idx * sizeof(rec)), &rec, sizeof(rec));
-    }
-    fndb.numDirs = static_cast<unsigned>(numDirectories);
-    fndb.numFiles = static_cast<unsigned>(numFiles);
-    fndb.depth = static_cast<unsigned>(deepestLevel);
-    fndb.size = GetMemTop();
-    AlignMem(FNDB_PAGESIZE);
-    SetMem(0, &fndb, sizeof(fndb));
-
-    // <fixme>
-    bool unloaded = false;
-    for (size_t i = 0; !unloaded && i < 100; ++i)
-    {
-      unloaded = SESSION_IMPL()->UnloadFilenameDatabaseInternal(rootIdx, chrono::seconds(0));
-      if (!unloaded)
-      {
-        trace_fndb->WriteLine("core", "sleep for 1ms");
-        this_thread::sleep_for(chrono::milliseconds(1));
-      }
-    }
-    if (!unloaded)
+    scanStartTime = time(nullptr);
+    if (incremental)
     {
-      MIKTEX_FATAL_ERROR(T_("fndb cannot be unloaded"));
+      previousRoot = LoadPreviousDirectories(fndbPath, nullptr);
     }
-    // </fixme>
-    
-    PathName tmpFndbPath(fndbPath);
-    tmpFndbPath.AppendExtension(".tmp");
-    unique_ptr<TemporaryFile> tmpFndbFile = TemporaryFile::Create(tmpFndbPath);
-    FileStream streamFndb;
-    streamFndb.Attach(File::Open(tmpFndbPath, FileMode::Create, FileAccess::Write, false));
-    streamFndb.Write(reinterpret_cast<const char*>(GetMemPointer()), GetMemTop());
-    streamFndb.Close();
-    if (File::Exists(fndbPath))
-    {
-      File::Delete(fndbPath, { FileDeleteOption::TryHard });
-    }
-    File::Move(tmpFndbPath, fndbPath);
-    tmpFndbFile->Keep();
-
+    vector<FILENAMEINFO> fileNames;
+    vector<pair<const char*, FileNameDatabaseDirectoryRecord>> directories;
+    CollectFiles(fileNames, directories);
+    Write(fndbPath, rootIdx, fileNames, directories, 0, 0);
     PathName changeFile = fndbPath;
     changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
     if (File::Exists(changeFile))
@@ -483,11 +1063,222 @@ bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFnd
   return Fndb::Create(fndbPath, rootPath, callback, true, false);
 }
 
-bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+DirectoryNode* FndbManager::FindDirectory(DirectoryNode& root, unordered_map<string, DirectoryNode*>& directoryMap, const string& directory)
+{
+  string key = PathName(directory).TransformForComparison().ToString();
+  if (auto it = directoryMap.find(key); it != directoryMap.end())
+  {
+    return it->second;
+  }
+  DirectoryNode* parent = &root;
+  string::size_type slash = directory.rfind('/');
+  if (slash != string::npos)
+  {
+    // RECURSION
+    parent = FindDirectory(root, directoryMap, directory.substr(0, slash));
+  }
+  unique_ptr<DirectoryNode> node = make_unique<DirectoryNode>();
+  node->directory = directory;
+  node->folderName = slash == string::npos ? directory : directory.substr(slash + 1);
+  node->level = parent->level + 1;
+  parent->lastWriteTime = 0;
+  parent->subDirectoryNames.push_back(node->folderName.ToString());
+  parent->children.push_back(std::move(node));
+  DirectoryNode* result = parent->children.back().get();
+  directoryMap[key] = result;
+  return result;
+}
+
+static void TruncateChangeFile(FILE* file, const PathName& changeFile)
+{
+#if defined(MIKTEX_WINDOWS)
+  if (_chsize_s(_fileno(file), 0) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("_chsize_s", "path", changeFile.ToString());
+  }
+#else
+  if (ftruncate(fileno(file), 0) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("ftruncate", "path", changeFile.ToString());
+  }
+#endif
+}
+
+bool FndbManager::Compact(const PathName& fndbPath, const PathName& rootPath)
+{
+  trace_fndb->WriteLine("core", fmt::format(T_("compacting fndb file {0}..."), Q_(fndbPath)));
+  unsigned rootIdx = SESSION_IMPL()->DeriveTEXMFRoot(rootPath);
+  this->rootPath = rootPath;
+  this->enableStringPooling = true;
+  this->storeFileNameInfo = true;
+  FileNameDatabaseHeader header;
+  unique_ptr<DirectoryNode> root = LoadPreviousDirectories(fndbPath, &header);
+  if (root == nullptr)
+  {
+    return false;
+  }
+  unordered_map<string, DirectoryNode*> directoryMap;
+  vector<DirectoryNode*> stack{ root.get() };
+  while (!stack.empty())
+  {
+    DirectoryNode* node = stack.back();
+    stack.pop_back();
+    directoryMap[PathName(node->directory).TransformForComparison().ToString()] = node;
+    for (const unique_ptr<DirectoryNode>& child : node->children)
+    {
+      stack.push_back(child.get());
+    }
+  }
+  PathName changeFile = fndbPath;
+  changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+  FileStream reader(File::Open(changeFile, FileMode::Open, FileAccess::Read, false));
+  if (!File::TryLock(reader.GetFile(), File::LockType::Shared, 2s))
+  {
+    MIKTEX_FATAL_ERROR_2(T_("Could not acquire shared lock."), "path", changeFile.ToString());
+  }
+  FileNameDatabaseChangeFileHeader changeFileHeader;
+  if (!FndbChangeFile::ReadHeader(reader.GetFile(), changeFile, changeFileHeader))
+  {
+    return false;
+  }
+  FndbWord foldedSequenceNumber = header.changeFileId == changeFileHeader.id ? header.changeFileSequenceNumber : 0;
+  FndbWord sequenceNumber = 0;
+  size_t numEntries = 0;
+  FndbChangeFile::Entry entry;
+  while (FndbChangeFile::ReadEntry(reader.GetFile(), changeFile, entry))
+  {
+    if (entry.sequenceNumber <= foldedSequenceNumber)
+    {
+      sequenceNumber = entry.sequenceNumber;
+      continue;
+    }
+    if (entry.sequenceNumber != sequenceNumber + 1)
+    {
+      FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString(), "sequenceNumber", std::to_string(entry.sequenceNumber));
+    }
+    sequenceNumber = entry.sequenceNumber;
+    ++numEntries;
+    DirectoryNode* node = FindDirectory(*root, directoryMap, entry.directory);
+    // the directory listing no longer matches the timestamp
+    node->lastWriteTime = 0;
+    PathName fileName(entry.fileName);
+    auto it = std::find_if(node->fileNames.begin(), node->fileNames.end(), [&fileName](const string& s) { return PathName(s) == fileName; });
+    if (entry.op == FileNameDatabaseChangeFileEntryHeader::Add)
+    {
+      if (it != node->fileNames.end())
+      {
+        continue;
+      }
+      if (!entry.info.empty() && node->fileNameInfos.empty())
+      {
+        node->fileNameInfos.resize(node->fileNames.size());
+      }
+      node->fileNames.push_back(entry.fileName);
+      if (!node->fileNameInfos.empty())
+      {
+        node->fileNameInfos.push_back(entry.info);
+      }
+    }
+    else if (it != node->fileNames.end())
+    {
+      if (!node->fileNameInfos.empty())
+      {
+        node->fileNameInfos.erase(node->fileNameInfos.begin() + (it - node->fileNames.begin()));
+      }
+      node->fileNames.erase(it);
+    }
+  }
+  size_t changeFileSize = static_cast<size_t>(ftell(reader.GetFile()));
+  File::Unlock(reader.GetFile());
+  reader.Close();
+  numDirectories = 0;
+  numFiles = 0;
+  deepestLevel = 0;
+  vector<FILENAMEINFO> fileNames;
+  vector<pair<const char*, FileNameDatabaseDirectoryRecord>> directories;
+  MergeFiles(*root, fileNames, directories);
+  Write(fndbPath, rootIdx, fileNames, directories, changeFileHeader.id, sequenceNumber);
+  try
+  {
+    // entries appended in the meantime must survive: writers append under
+    // the exclusive lock, so check and truncate while holding it
+    FileStream writer(File::Open(changeFile, FileMode::Append, FileAccess::ReadWrite, false));
+    if (File::TryLock(writer.GetFile(), File::LockType::Exclusive, 2s))
+    {
+      MIKTEX_AUTO(File::Unlock(writer.GetFile()));
+      if (fseek(writer.GetFile(), 0, SEEK_END) != 0)
+      {
+        MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", changeFile.ToString());
+      }
+      if (static_cast<size_t>(ftell(writer.GetFile())) == changeFileSize)
+      {
+        TruncateChangeFile(writer.GetFile(), changeFile);
+      }
+    }
+  }
+  catch (const exception&)
+  {
+    // the folded entries will be skipped
+  }
+  trace_fndb->WriteLine("core", fmt::format(T_("fndb compaction completed: {0} change file entries folded in"), numEntries));
+  return true;
+}
+
+bool FndbManager::Seed(const PathName& seedPath, const PathName& fndbPath, const PathName& rootPath)
+{
+  trace_fndb->WriteLine("core", fmt::format(T_("seeding fndb file {0} with {1}..."), Q_(fndbPath), Q_(seedPath)));
+  unsigned rootIdx = SESSION_IMPL()->DeriveTEXMFRoot(rootPath);
+  this->rootPath = rootPath;
+  this->enableStringPooling = true;
+  this->storeFileNameInfo = true;
+  unique_ptr<DirectoryNode> root = LoadPreviousDirectories(seedPath, nullptr);
+  if (root == nullptr)
+  {
+    return false;
+  }
+  // only the directory time stamps differ: stat the directories instead of
+  // listing them
+  time_t now = time(nullptr);
+  vector<DirectoryNode*> stack{ root.get() };
+  while (!stack.empty())
+  {
+    DirectoryNode* node = stack.back();
+    stack.pop_back();
+    PathName path = node->directory.empty() ? rootPath : rootPath / node->directory;
+    if (!Directory::Exists(path))
+    {
+      trace_fndb->WriteLine("core", fmt::format(T_("{0} does not match: {1} does not exist"), Q_(seedPath), Q_(path)));
+      return false;
+    }
+    time_t lastWriteTime = File::GetLastWriteTime(path);
+    node->lastWriteTime = lastWriteTime + 1 >= now ? 0 : lastWriteTime;
+    for (const unique_ptr<DirectoryNode>& child : node->children)
+    {
+      stack.push_back(child.get());
+    }
+  }
+  numDirectories = 0;
+  numFiles = 0;
+  deepestLevel = 0;
+  vector<FILENAMEINFO> fileNames;
+  vector<pair<const char*, FileNameDatabaseDirectoryRecord>> directories;
+  MergeFiles(*root, fileNames, directories);
+  Write(fndbPath, rootIdx, fileNames, directories, 0, 0);
+  PathName changeFile = fndbPath;
+  changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+  if (File::Exists(changeFile))
+  {
+    File::Delete(changeFile);
+  }
+  trace_fndb->WriteLine("core", fmt::format(T_("fndb seeding completed: {0} directories, {1} files"), directories.size(), fileNames.size()));
+  return true;
+}
+
+static bool CreateOrRefresh(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, bool incremental)
 {
   FndbManager fndbmngr;
 
-  if (!fndbmngr.Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo))
+  if (!fndbmngr.Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo, incremental))
   {
     return false;
   }
@@ -496,6 +1287,50 @@ bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFnd
   ReportMiKTeXEvent(EVENTLOG_INFORMATION_TYPE, MIKTEX_EVENT_FNDB_CREATED, fndbPath, rootPath, 0);
 #endif
 
+  shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+  if (session != nullptr)
+  {
+    session->InvalidateFindFileMissCache();
+  }
+
+  return true;
+}
+
+bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+{
+  return CreateOrRefresh(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo, false);
+}
+
+bool CompactFileNameDatabase(const PathName& fndbPath, const PathName& rootPath)
+{
+  // do not wait for another process which is compacting the same FNDB
+  PathName lockPath = fndbPath;
+  lockPath.SetExtension(MIKTEX_FNDB_LOCK_FILE_SUFFIX);
+  unique_ptr<LockFile> lockFile = LockFile::Create(lockPath);
+  if (!lockFile->TryLock(0ms))
+  {
+    return false;
+  }
+  FndbManager fndbmngr;
+  try
+  {
+    if (!fndbmngr.Compact(fndbPath, rootPath))
+    {
+      return false;
+    }
+  }
+  catch (const exception& e)
+  {
+    // the change file is still intact; try again next time
+    unique_ptr<TraceStream> trace_fndb = TraceStream::Open(MIKTEX_TRACE_FNDB);
+    trace_fndb->WriteLine("core", TraceLevel::Error, fmt::format(T_("{0} cannot be compacted: {1}"), Q_(fndbPath), e.what()));
+    return false;
+  }
+  shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+  if (session != nullptr)
+  {
+    session->InvalidateFindFileMissCache();
+  }
   return true;
 }
 
@@ -503,7 +1338,21 @@ bool Fndb::Refresh(const PathName& path, ICreateFndbCallback* callback)
 {
   unsigned root = SESSION_IMPL()->DeriveTEXMFRoot(path);
   PathName pathFndbPath = SESSION_IMPL()->GetFilenameDatabasePathName(root);
-  return Fndb::Create(pathFndbPath, SESSION_IMPL()->GetRootDirectoryPath(root), callback);
+  return CreateOrRefresh(pathFndbPath, SESSION_IMPL()->GetRootDirectoryPath(root), callback, true, false, true);
+}
+
+bool Fndb::Seed(const PathName& seedPath, const PathName& rootPath)
+{
+  shared_ptr<SessionImpl> session = SESSION_IMPL();
+  unsigned root = session->DeriveTEXMFRoot(rootPath);
+  PathName fndbPath = session->GetFilenameDatabasePathName(root);
+  FndbManager fndbmngr;
+  if (!fndbmngr.Seed(seedPath, fndbPath, session->GetRootDirectoryPath(root)))
+  {
+    return false;
+  }
+  session->InvalidateFindFileMissCache();
+  return true;
 }
 
 bool Fndb::Refresh(ICreateFndbCallback* callback)
@@ -522,9 +1371,14 @@ bool Fndb::Refresh(ICreateFndbCallback* callback)
       // skipping common root directory
       continue;
     }
+    if (session->IsSnapshotRoot(ord))
+    {
+      // skipping installation snapshot
+      continue;
+    }
     PathName rootDirectory = session->GetRootDirectoryPath(ord);
     PathName pathFndbPath = session->GetFilenameDatabasePathName(ord);
-    if (!Fndb::Create(pathFndbPath, rootDirectory, callback))
+    if (!CreateOrRefresh(pathFndbPath, rootDirectory, callback, true, false, true))
     {
       return false;
     }
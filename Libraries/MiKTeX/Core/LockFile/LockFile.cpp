@@ -21,7 +21,9 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <chrono>
+#include <sstream>
 #include <thread>
 
 #include <fmt/format.h>
@@ -29,7 +31,6 @@
 
 #include <miktex/Core/LockFile>
 #include <miktex/Core/Process>
-#include <miktex/Core/StreamReader>
 
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
@@ -38,6 +39,8 @@
 
 #include "internal.h"
 
+#include "LockFile/LockFileHandle.h"
+
 using namespace std;
 using namespace chrono_literals;
 
@@ -83,13 +86,15 @@ public:
 public:
   void MIKTEXTHISCALL Unlock() override;
 private:
-  tuple<int, string> ReadLockFile();
+  tuple<int, string> ParseLockFile(const string& contents);
 private:
-  tuple<bool, int, string> CheckLockFile();
+  tuple<bool, int, string> CheckLockFile(const string& contents);
 private:
   PathName path;
 private:
   bool locked = false;
+private:
+  unique_ptr<LockFileHandle> handle;
 private:
   unique_ptr<TraceStream> trace_lockfile;
 };
@@ -110,58 +115,48 @@ bool LockFileImpl::TryLock(chrono::milliseconds timeout)
   {
     MIKTEX_FATAL_ERROR_2(T_("File is locked: {0}"), "path", path.ToString());
   }
-  chrono::time_point<chrono::high_resolution_clock> tryUntil = chrono::high_resolution_clock::now() + timeout;
-  bool tryAgain;
+  chrono::time_point<chrono::steady_clock> tryUntil = chrono::steady_clock::now() + timeout;
   do
   {
-    tryAgain = false;
-    if (!File::Exists(path))
+    chrono::milliseconds remaining = max(chrono::duration_cast<chrono::milliseconds>(tryUntil - chrono::steady_clock::now()), chrono::milliseconds(0ms));
+    unique_ptr<LockFileHandle> h = LockFileHandle::Open(path);
+    if (h == nullptr)
     {
-      try
-      {
-        ofstream os = File::CreateOutputStream(path);
-        os
-          << Process::GetCurrentProcess()->GetSystemId() << "\n"
-          << Process::GetCurrentProcess()->get_ProcessName() << "\n";
-        os.close();
-        trace_lockfile->WriteLine("core", fmt::format(T_("lock file {0} successfully created"), Q_(path)));
-        locked = true;
-      }
-      catch (const FileExistsException&)
-      {
-      }
-      catch (const UnauthorizedAccessException&)
-      {
-      }
+      this_thread::sleep_for(min(remaining, chrono::milliseconds(10ms)));
+      continue;
+    }
+    // the kernel lock is released when the owner terminates
+    if (!h->Lock(remaining))
+    {
+      break;
+    }
+    if (!h->IsCurrent())
+    {
+      // the previous owner has removed the file
+      continue;
     }
-    if (!locked)
+    // older versions do not lock the file: they own it as long as it exists
+    // and the owner process is running
+    string contents = h->ReadContents();
+    if (!contents.empty())
     {
       bool isGarbage;
       int pid;
       string processName;
-      tie(isGarbage, pid, processName) = CheckLockFile();
-      if (isGarbage)
-      {
-        trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("removing lock file {0} created by {1} ({2})"), Q_(path), processName, pid));
-        try
-        {
-          File::Delete(path);
-        }
-        catch (const FileNotFoundException&)
-        {
-        }
-        catch (const exception&)
-        {
-          throw;
-        }
-        tryAgain = true;
-      }
-      else
+      tie(isGarbage, pid, processName) = CheckLockFile(contents);
+      if (!isGarbage)
       {
+        h = nullptr;
         this_thread::sleep_for(10ms);
+        continue;
       }
+      trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("taking over lock file {0} created by {1} ({2})"), Q_(path), processName, pid));
     }
-  } while (!locked && (tryAgain || chrono::high_resolution_clock::now() < tryUntil));
+    h->WriteContents(fmt::format("{0}\n{1}\n", Process::GetCurrentProcess()->GetSystemId(), Process::GetCurrentProcess()->get_ProcessName()));
+    trace_lockfile->WriteLine("core", fmt::format(T_("lock file {0} successfully created"), Q_(path)));
+    handle = move(h);
+    locked = true;
+  } while (!locked && chrono::steady_clock::now() < tryUntil);
   return locked;
 }
 
@@ -173,36 +168,33 @@ void MIKTEXTHISCALL LockFileImpl::Unlock()
     MIKTEX_FATAL_ERROR_2(T_("File is not locked: {0}"), "path", path.ToString());
   }
   locked = false;
-  File::Delete(path);
+  unique_ptr<LockFileHandle> h = move(handle);
+  h->RemoveAndClose();
 }
 
-tuple<int, string> LockFileImpl::ReadLockFile()
+tuple<int, string> LockFileImpl::ParseLockFile(const string& contents)
 {
   string pid;
   string processName;
-  StreamReader reader(path);
-  reader.ReadLine(pid);
-  reader.ReadLine(processName);
-  reader.Close();
+  istringstream reader(contents);
+  getline(reader, pid);
+  getline(reader, processName);
   return make_tuple(std::stoi(pid), processName);
 }
 
-tuple<bool, int, string> LockFileImpl::CheckLockFile()
+tuple<bool, int, string> LockFileImpl::CheckLockFile(const string& contents)
 {
-  int pid;
+  int pid = 0;
   string processName;
   try
   {
-    tie(pid, processName) = ReadLockFile();
-  }
-  catch (const UnauthorizedAccessException&)
-  {
-    trace_lockfile->WriteLine("core", fmt::format(T_("permission denied: {0}"), Q_(path)));
-    return make_tuple(false, pid, processName);
+    tie(pid, processName) = ParseLockFile(contents);
   }
-  catch (const IOException&)
+  catch (const exception&)
   {
-    trace_lockfile->WriteLine("core", fmt::format(T_("could not read lock file {0}"), Q_(path)));
+    // e.g., an older version (which does not lock) is writing the file: the
+    // file can only be taken over when its owner is known to be gone
+    trace_lockfile->WriteLine("core", fmt::format(T_("could not parse lock file {0}"), Q_(path)));
     return make_tuple(false, pid, processName);
   }
   if (pid == -1)
@@ -0,0 +1,66 @@
+/**
+ * @file LockFile/LockFileHandle.h
+ * @author Christian Schenk
+ * @brief Kernel lock on a lock file
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#if !defined(E4B7C1A92F6D4E8B9A3C5D7F1B2E4A68)
+#define E4B7C1A92F6D4E8B9A3C5D7F1B2E4A68
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// An open lock file, which can be locked exclusively. The lock is held by
+/// the kernel: it is released when the file is closed, even if the process
+/// dies.
+class LockFileHandle
+{
+public:
+  virtual ~LockFileHandle() noexcept = default;
+
+  /// Opens (or creates) a lock file.
+  /// @param path The path to the lock file.
+  /// @return Returns `nullptr`, if the file cannot be opened now (e.g.,
+  /// permission denied, or it is about to be removed).
+public:
+  static std::unique_ptr<LockFileHandle> Open(const MiKTeX::Util::PathName& path);
+
+  /// Waits in the kernel for the exclusive lock.
+  /// @param timeout The maximum time to wait.
+  /// @return Returns `true`, if the lock has been acquired.
+public:
+  virtual bool Lock(std::chrono::milliseconds timeout) = 0;
+
+  /// Tests whether the open file still is the file at the path. The
+  /// previous owner removes the file before it releases the lock.
+public:
+  virtual bool IsCurrent() = 0;
+
+public:
+  virtual std::string ReadContents() = 0;
+
+public:
+  virtual void WriteContents(const std::string& contents) = 0;
+
+  /// Removes the file and releases the lock.
+public:
+  virtual void RemoveAndClose() = 0;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * @file LockFile/unx/unxLockFileHandle.cpp
+ * @author Christian Schenk
+ * @brief Kernel lock on a lock file (Unix)
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+#include <cerrno>
+
+#include <algorithm>
+#include <thread>
+
+#include "internal.h"
+
+#include "LockFile/LockFileHandle.h"
+
+using namespace std;
+using namespace chrono_literals;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+class unxLockFileHandle :
+  public LockFileHandle
+{
+public:
+  unxLockFileHandle(const PathName& path, int fd) :
+    path(path),
+    fd(fd)
+  {
+  }
+
+public:
+  ~unxLockFileHandle() noexcept override
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+  }
+
+public:
+  bool Lock(chrono::milliseconds timeout) override
+  {
+    chrono::time_point<chrono::steady_clock> tryUntil = chrono::steady_clock::now() + timeout;
+#if defined(__linux__)
+    // the owner closes (and removes) the file when it releases the lock:
+    // wait for that instead of polling
+    int watchFd = timeout > 0ms ? inotify_init1(IN_CLOEXEC | IN_NONBLOCK) : -1;
+    if (watchFd >= 0 && inotify_add_watch(watchFd, path.GetData(), IN_CLOSE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ATTRIB) < 0)
+    {
+      close(watchFd);
+      watchFd = -1;
+    }
+#endif
+    bool locked;
+    while (true)
+    {
+      locked = flock(fd, LOCK_EX | LOCK_NB) == 0;
+      if (locked)
+      {
+        break;
+      }
+      if (errno != EWOULDBLOCK)
+      {
+        int err = errno;
+#if defined(__linux__)
+        if (watchFd >= 0)
+        {
+          close(watchFd);
+        }
+#endif
+        errno = err;
+        MIKTEX_FATAL_CRT_ERROR_2("flock", "path", path.ToString());
+      }
+      chrono::milliseconds remaining = chrono::duration_cast<chrono::milliseconds>(tryUntil - chrono::steady_clock::now());
+      if (remaining <= 0ms)
+      {
+        break;
+      }
+#if defined(__linux__)
+      if (watchFd >= 0)
+      {
+        // wake up now and then, in case an event is missed (e.g., on
+        // a network file system)
+        struct pollfd pfd = { watchFd, POLLIN, 0 };
+        if (poll(&pfd, 1, static_cast<int>(min(remaining, chrono::milliseconds(1s)).count())) > 0)
+        {
+          char buf[4096];
+          while (read(watchFd, buf, sizeof(buf)) > 0)
+          {
+          }
+        }
+        continue;
+      }
+#endif
+      this_thread::sleep_for(min(remaining, chrono::milliseconds(10ms)));
+    }
+#if defined(__linux__)
+    if (watchFd >= 0)
+    {
+      close(watchFd);
+    }
+#endif
+    return locked;
+  }
+
+public:
+  bool IsCurrent() override
+  {
+    struct stat openStat;
+    struct stat pathStat;
+    if (fstat(fd, &openStat) != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("fstat", "path", path.ToString());
+    }
+    if (stat(path.GetData(), &pathStat) != 0)
+    {
+      return false;
+    }
+    return openStat.st_dev == pathStat.st_dev && openStat.st_ino == pathStat.st_ino;
+  }
+
+public:
+  string ReadContents() override
+  {
+    string contents;
+    char buf[512];
+    ssize_t n;
+    off_t offset = 0;
+    while ((n = pread(fd, buf, sizeof(buf), offset)) > 0)
+    {
+      contents.append(buf, n);
+      offset += n;
+    }
+    if (n < 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("pread", "path", path.ToString());
+    }
+    return contents;
+  }
+
+public:
+  void WriteContents(const string& contents) override
+  {
+    if (ftruncate(fd, 0) != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("ftruncate", "path", path.ToString());
+    }
+    if (pwrite(fd, contents.c_str(), contents.length(), 0) != static_cast<ssize_t>(contents.length()))
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("pwrite", "path", path.ToString());
+    }
+  }
+
+public:
+  void RemoveAndClose() override
+  {
+    // remove the file first: a process waiting for the lock then sees
+    // that it has got the lock on a removed file
+    if (unlink(path.GetData()) != 0 && errno != ENOENT)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("unlink", "path", path.ToString());
+    }
+    int fd = this->fd;
+    this->fd = -1;
+    if (close(fd) != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("close", "path", path.ToString());
+    }
+  }
+
+private:
+  PathName path;
+
+private:
+  int fd;
+};
+
+unique_ptr<LockFileHandle> LockFileHandle::Open(const PathName& path)
+{
+  int fd = open(path.GetData(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0)
+  {
+    if (errno == EACCES || errno == EPERM || errno == EROFS || errno == ENOENT)
+    {
+      return nullptr;
+    }
+    MIKTEX_FATAL_CRT_ERROR_2("open", "path", path.ToString());
+  }
+  return make_unique<unxLockFileHandle>(path, fd);
+}
@@ -0,0 +1,203 @@
+/**
+ * @file LockFile/win/winLockFileHandle.cpp
+ * @author Christian Schenk
+ * @brief Kernel lock on a lock file (Windows)
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <Windows.h>
+
+#include "internal.h"
+
+#include "LockFile/LockFileHandle.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+// Windows locks are mandatory: lock a byte far beyond the end of the file,
+// so that the contents can be read by others
+constexpr DWORD LOCK_OFFSET_HIGH = 0x40000000;
+
+class winLockFileHandle :
+  public LockFileHandle
+{
+public:
+  winLockFileHandle(const PathName& path, HANDLE handle) :
+    path(path),
+    handle(handle)
+  {
+  }
+
+public:
+  ~winLockFileHandle() noexcept override
+  {
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(handle);
+    }
+  }
+
+public:
+  bool Lock(chrono::milliseconds timeout) override
+  {
+    OVERLAPPED overlapped = {};
+    overlapped.OffsetHigh = LOCK_OFFSET_HIGH;
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (overlapped.hEvent == nullptr)
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
+    }
+    DWORD flags = LOCKFILE_EXCLUSIVE_LOCK;
+    if (timeout.count() <= 0)
+    {
+      flags |= LOCKFILE_FAIL_IMMEDIATELY;
+    }
+    bool locked = LockFileEx(handle, flags, 0, 1, 0, &overlapped) ? true : false;
+    DWORD error = locked ? ERROR_SUCCESS : GetLastError();
+    if (error == ERROR_IO_PENDING)
+    {
+      // the kernel grants the lock when the owner releases it
+      DWORD waitResult = WaitForSingleObject(overlapped.hEvent, static_cast<DWORD>(min<chrono::milliseconds::rep>(timeout.count(), INFINITE - 1)));
+      if (waitResult != WAIT_OBJECT_0)
+      {
+        CancelIoEx(handle, &overlapped);
+      }
+      DWORD n;
+      // the lock may have been granted before the request was canceled
+      locked = GetOverlappedResult(handle, &overlapped, &n, TRUE) ? true : false;
+      error = locked ? ERROR_SUCCESS : GetLastError();
+    }
+    CloseHandle(overlapped.hEvent);
+    if (!locked && error != ERROR_LOCK_VIOLATION && error != ERROR_OPERATION_ABORTED)
+    {
+      SetLastError(error);
+      MIKTEX_FATAL_WINDOWS_ERROR_2("LockFileEx", "path", path.ToString());
+    }
+    return locked;
+  }
+
+public:
+  bool IsCurrent() override
+  {
+    BY_HANDLE_FILE_INFORMATION openInfo;
+    if (!GetFileInformationByHandle(handle, &openInfo))
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR_2("GetFileInformationByHandle", "path", path.ToString());
+    }
+    HANDLE pathHandle = CreateFileW(path.ToExtendedLengthPathName().ToWideCharString().c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (pathHandle == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+    BY_HANDLE_FILE_INFORMATION pathInfo;
+    bool ok = GetFileInformationByHandle(pathHandle, &pathInfo) ? true : false;
+    CloseHandle(pathHandle);
+    return ok
+      && openInfo.dwVolumeSerialNumber == pathInfo.dwVolumeSerialNumber
+      && openInfo.nFileIndexHigh == pathInfo.nFileIndexHigh
+      && openInfo.nFileIndexLow == pathInfo.nFileIndexLow;
+  }
+
+public:
+  string ReadContents() override
+  {
+    string contents;
+    char buf[512];
+    DWORD n;
+    while ((n = Transfer(false, buf, sizeof(buf), contents.length())) > 0)
+    {
+      contents.append(buf, n);
+    }
+    return contents;
+  }
+
+public:
+  void WriteContents(const string& contents) override
+  {
+    FILE_END_OF_FILE_INFO eofInfo = {};
+    if (!SetFileInformationByHandle(handle, FileEndOfFileInfo, &eofInfo, sizeof(eofInfo)))
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR_2("SetFileInformationByHandle", "path", path.ToString());
+    }
+    if (Transfer(true, const_cast<char*>(contents.c_str()), static_cast<DWORD>(contents.length()), 0) != contents.length())
+    {
+      MIKTEX_UNEXPECTED();
+    }
+  }
+
+public:
+  void RemoveAndClose() override
+  {
+    // remove the file first: a process waiting for the lock then sees that
+    // it has got the lock on a removed file
+    FILE_DISPOSITION_INFO dispositionInfo = { TRUE };
+    if (!SetFileInformationByHandle(handle, FileDispositionInfo, &dispositionInfo, sizeof(dispositionInfo)))
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR_2("SetFileInformationByHandle", "path", path.ToString());
+    }
+    HANDLE handle = this->handle;
+    this->handle = INVALID_HANDLE_VALUE;
+    if (!CloseHandle(handle))
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR_2("CloseHandle", "path", path.ToString());
+    }
+  }
+
+  // the file has been opened for overlapped I/O
+private:
+  DWORD Transfer(bool write, char* buf, DWORD count, size_t offset)
+  {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    DWORD n = 0;
+    bool ok = write ? WriteFile(handle, buf, count, nullptr, &overlapped) : ReadFile(handle, buf, count, nullptr, &overlapped);
+    if ((!ok && GetLastError() != ERROR_IO_PENDING) || !GetOverlappedResult(handle, &overlapped, &n, TRUE))
+    {
+      if (!write && GetLastError() == ERROR_HANDLE_EOF)
+      {
+        return 0;
+      }
+      MIKTEX_FATAL_WINDOWS_ERROR_2(write ? "WriteFile" : "ReadFile", "path", path.ToString());
+    }
+    return n;
+  }
+
+private:
+  PathName path;
+
+private:
+  HANDLE handle;
+};
+
+unique_ptr<LockFileHandle> LockFileHandle::Open(const PathName& path)
+{
+  HANDLE handle = CreateFileW(
+    path.ToExtendedLengthPathName().ToWideCharString().c_str(),
+    GENERIC_READ | GENERIC_WRITE | DELETE,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+    nullptr,
+    OPEN_ALWAYS,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+    nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    DWORD error = GetLastError();
+    // ERROR_ACCESS_DENIED: also returned, if the file is about to be removed
+    if (error == ERROR_ACCESS_DENIED || error == ERROR_SHARING_VIOLATION)
+    {
+      return nullptr;
+    }
+    MIKTEX_FATAL_WINDOWS_ERROR_2("CreateFileW", "path", path.ToString());
+  }
+  return make_unique<winLockFileHandle>(path, handle);
+}
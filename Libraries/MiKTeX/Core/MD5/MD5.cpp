@@ -21,7 +21,14 @@
 
 #include "config.h"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
 #include <miktex/Core/File>
+#include <miktex/Core/FileStream>
 #include <miktex/Core/MD5>
 #include <miktex/Core/MemoryMappedFile>
 #include <miktex/Util/PathName>
@@ -41,13 +48,87 @@ MD5 MD5::FromFile(const PathName& path)
   if (size > 0)
   {
     unique_ptr<MemoryMappedFile> mmapFile(MemoryMappedFile::Create());
-    const void* ptr = mmapFile->Open(path, false);
-    md5Builder.Update(ptr, size);
+    const void* ptr = nullptr;
+    try
+    {
+      ptr = mmapFile->Open(path, false);
+    }
+    catch (const MiKTeXException&)
+    {
+      // the file cannot be mapped (e.g., it is too large for the address
+      // space): read it
+    }
+    if (ptr != nullptr)
+    {
+      md5Builder.Update(ptr, size);
+    }
+    else
+    {
+      FileStream stream(File::Open(path, FileMode::Open, FileAccess::Read, false));
+      vector<unsigned char> buf(1024 * 1024);
+      size_t n;
+      while ((n = stream.Read(&buf[0], buf.size())) > 0)
+      {
+        md5Builder.Update(&buf[0], n);
+      }
+      stream.Close();
+    }
   }
   md5Builder.Final();
   return md5Builder.GetMD5();
 }
 
+vector<MD5> MD5::FromFiles(const vector<PathName>& paths, size_t maxConcurrency)
+{
+  vector<MD5> digests(paths.size());
+  atomic<size_t> next(0);
+  atomic<bool> failed(false);
+  exception_ptr error;
+  mutex errorMutex;
+  auto worker = [&]()
+  {
+    size_t idx;
+    while (!failed && (idx = next++) < paths.size())
+    {
+      try
+      {
+        digests[idx] = FromFile(paths[idx]);
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lockGuard(errorMutex);
+        if (!failed)
+        {
+          error = current_exception();
+          failed = true;
+        }
+      }
+    }
+  };
+  vector<thread> threads;
+  try
+  {
+    for (size_t n = 1; n < maxConcurrency && n < paths.size(); ++n)
+    {
+      threads.push_back(thread(worker));
+    }
+  }
+  catch (const system_error&)
+  {
+    // continue with the threads we have got
+  }
+  worker();
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  if (error)
+  {
+    rethrow_exception(error);
+  }
+  return digests;
+}
+
 MD5 MD5::FromChars(const string& s)
 {
   MD5Builder md5Builder;
@@ -52,10 +52,11 @@ unxMemoryMappedFile::~unxMemoryMappedFile()
   }
 }
 
-void* unxMemoryMappedFile::Open(const PathName& pathArg, bool readWrite)
+void* unxMemoryMappedFile::Open(const PathName& pathArg, bool readWrite, MemoryMappedFileHintSet hints)
 {
   path = pathArg;
   this->readWrite = readWrite;
+  this->hints = hints;
   OpenFile();
   CreateMapping(0);
   return ptr;
@@ -115,12 +116,59 @@ void unxMemoryMappedFile::CreateMapping(size_t maximumFileSize)
 
   size = maximumFileSize;
 
-  ptr = mmap(nullptr, size, (readWrite ? (PROT_READ | PROT_WRITE) : PROT_READ), MAP_SHARED, filedes, 0);
+  int flags = MAP_SHARED;
+
+#if defined(MAP_POPULATE)
+  if (hints[MemoryMappedFileHint::Populate])
+  {
+    flags |= MAP_POPULATE;
+  }
+#endif
+
+  ptr = mmap(nullptr, size, (readWrite ? (PROT_READ | PROT_WRITE) : PROT_READ), flags, filedes, 0);
 
   if (ptr == MAP_FAILED)
   {
+    ptr = nullptr;
     MIKTEX_FATAL_CRT_ERROR_2("mmap", "path", path.ToString(), "size", std::to_string(size), "readWrite", std::to_string(readWrite));
   }
+
+  ApplyHints();
+}
+
+void unxMemoryMappedFile::ApplyHints()
+{
+  // the hints are advice: failures are not errors
+  if (hints[MemoryMappedFileHint::RandomAccess])
+  {
+    posix_madvise(ptr, size, POSIX_MADV_RANDOM);
+  }
+  else if (hints[MemoryMappedFileHint::SequentialAccess])
+  {
+    posix_madvise(ptr, size, POSIX_MADV_SEQUENTIAL);
+  }
+#if !defined(MAP_POPULATE)
+  if (hints[MemoryMappedFileHint::Populate])
+  {
+    // touch every page
+    volatile const char* bytes = static_cast<const char*>(ptr);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    for (size_t offset = 0; offset < size; offset += pageSize)
+    {
+      (void)bytes[offset];
+    }
+  }
+#endif
+  if (hints[MemoryMappedFileHint::WillNeed])
+  {
+    posix_madvise(ptr, size, POSIX_MADV_WILLNEED);
+  }
+#if defined(MADV_HUGEPAGE)
+  if (hints[MemoryMappedFileHint::HugePages])
+  {
+    madvise(ptr, size, MADV_HUGEPAGE);
+  }
+#endif
 }
 
 void unxMemoryMappedFile::CloseFile()
@@ -36,7 +36,10 @@ public:
   ~unxMemoryMappedFile() override;
 
 public:
-  void* Open(const MiKTeX::Util::PathName& path, bool readWrite) override;
+  using MiKTeX::Core::MemoryMappedFile::Open;
+
+public:
+  void* Open(const MiKTeX::Util::PathName& path, bool readWrite, MiKTeX::Core::MemoryMappedFileHintSet hints) override;
 
 public:
   void Close() override;
@@ -71,6 +74,9 @@ private:
 private:
   void CreateMapping(size_t maximumFileSize);
 
+private:
+  void ApplyHints();
+
 private:
   void CloseFile();
 
@@ -83,6 +89,9 @@ private:
 private:
   bool readWrite = false;
 
+private:
+  MiKTeX::Core::MemoryMappedFileHintSet hints;
+
 private:
   MiKTeX::Util::PathName path;
 
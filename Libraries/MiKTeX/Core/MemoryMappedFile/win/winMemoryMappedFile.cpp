@@ -61,10 +61,11 @@ winMemoryMappedFile::~winMemoryMappedFile()
   }
 }
 
-void* winMemoryMappedFile::Open(const PathName& path_, bool readWrite)
+void* winMemoryMappedFile::Open(const PathName& path_, bool readWrite, MemoryMappedFileHintSet hints)
 {
   path = path_;
   this->readWrite = readWrite;
+  this->hints = hints;
 
   // create a unique object name
   PathName path2 = path;
@@ -109,6 +110,8 @@ void* winMemoryMappedFile::Open(const PathName& path_, bool readWrite)
 #else
 #  error Unimplemented: winMemoryMappedFile::Open()
 #endif
+
+    ApplyHints();
   }
   else
   {
@@ -153,7 +156,9 @@ void winMemoryMappedFile::OpenFile()
 
   traceStream->WriteLine("core", fmt::format(T_("opening memory-mapped file {0} for {1}"), Q_(path), (readWrite ? T_("reading/writing") : T_("reading"))));
 
-  hFile = CreateFileW(UW_(path.GetData()), desiredAccess, shareMode, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+  unsigned long flagsAndAttributes = hints[MemoryMappedFileHint::SequentialAccess] ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+
+  hFile = CreateFileW(UW_(path.GetData()), desiredAccess, shareMode, nullptr, OPEN_EXISTING, flagsAndAttributes, nullptr);
 
   if (hFile == INVALID_HANDLE_VALUE)
   {
@@ -203,6 +208,38 @@ void winMemoryMappedFile::CreateMapping(size_t maximumFileSize)
   {
     MIKTEX_FATAL_WINDOWS_ERROR_2("MapViewOfFile", "path", name);
   }
+
+  ApplyHints();
+}
+
+void winMemoryMappedFile::ApplyHints()
+{
+  // read-ahead is controlled by the file flags; large pages are not
+  // available for file mappings
+#if _WIN32_WINNT >= 0x0602
+  if (hints[MemoryMappedFileHint::WillNeed] || hints[MemoryMappedFileHint::Populate])
+  {
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = ptr;
+    range.NumberOfBytes = size;
+    // the hint is advice: failure is not an error
+    if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0))
+    {
+      traceStream->WriteLine("core", fmt::format(T_("could not prefetch memory-mapped file {0}"), Q_(path)));
+    }
+  }
+#endif
+  if (hints[MemoryMappedFileHint::Populate])
+  {
+    // touch every page
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    volatile const char* bytes = static_cast<const char*>(ptr);
+    for (size_t offset = 0; offset < size; offset += systemInfo.dwPageSize)
+    {
+      (void)bytes[offset];
+    }
+  }
 }
 
 void winMemoryMappedFile::CloseFile()
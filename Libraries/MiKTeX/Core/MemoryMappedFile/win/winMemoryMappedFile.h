@@ -38,7 +38,10 @@ public:
   ~winMemoryMappedFile() override;
 
 public:
-  void* MIKTEXTHISCALL Open(const MiKTeX::Util::PathName& path, bool readWrite) override;
+  using MiKTeX::Core::MemoryMappedFile::Open;
+
+public:
+  void* MIKTEXTHISCALL Open(const MiKTeX::Util::PathName& path, bool readWrite, MiKTeX::Core::MemoryMappedFileHintSet hints) override;
 
 public:
   void MIKTEXTHISCALL Close() override;
@@ -73,6 +76,9 @@ private:
 private:
   void CreateMapping(size_t maximumFileSize);
 
+private:
+  void ApplyHints();
+
 private:
   void CloseFile();
 
@@ -85,6 +91,9 @@ private:
 private:
   bool readWrite = false;
 
+private:
+  MiKTeX::Core::MemoryMappedFileHintSet hints;
+
 private:
   MiKTeX::Util::PathName path;
 
@@ -21,6 +21,9 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <functional>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -42,6 +45,10 @@ Process::~Process() noexcept
 {
 }
 
+PipeMultiplexer::~PipeMultiplexer() noexcept
+{
+}
+
 void Process::Start(const PathName& fileName, const vector<string>& arguments, FILE* pFileStandardInput, FILE** ppFileStandardInput, FILE** ppFileStandardOutput, FILE** ppFileStandardError, const char* workingDirectory)
 {
   MIKTEX_ASSERT_STRING_OR_NIL(workingDirectory);
@@ -211,6 +218,58 @@ void Process::Run(const PathName& fileName, const vector<string>& arguments, IRu
   }
 }
 
+vector<ProcessRunResult> Process::RunAll(const vector<ProcessStartInfo>& startInfos, size_t maxConcurrency)
+{
+  maxConcurrency = std::max<size_t>(maxConcurrency, 1);
+  vector<ProcessRunResult> results(startInfos.size());
+  vector<unique_ptr<Process>> processes(startInfos.size());
+  unique_ptr<PipeMultiplexer> multiplexer = PipeMultiplexer::Create();
+  size_t next = 0;
+  function<void()> startNext = [&]()
+  {
+    size_t idx = next++;
+    ProcessStartInfo startinfo = startInfos[idx];
+#if defined(MIKTEX_WINDOWS)
+    startinfo.StandardError = nullptr;
+    startinfo.StandardOutput = nullptr;
+#endif
+    startinfo.StandardInput = nullptr;
+    startinfo.RedirectStandardInput = false;
+    startinfo.RedirectStandardOutput = true;
+    startinfo.RedirectStandardError = false;
+    processes[idx] = Process::Start(startinfo);
+    FILE* stdoutFile = processes[idx]->get_StandardOutput();
+    multiplexer->Add(stdoutFile, [&, idx, stdoutFile](const void* output, size_t n)
+    {
+      ProcessRunResult& result = results[idx];
+      if (n > 0)
+      {
+        result.output.append(reinterpret_cast<const char*>(output), n);
+        return true;
+      }
+      // end of output: the next process takes the place
+      fclose(stdoutFile);
+      Process& process = *processes[idx];
+      process.WaitForExit();
+      result.exitStatus = process.get_ExitStatus();
+      result.exitCode = result.exitStatus == ProcessExitStatus::Exited ? process.get_ExitCode() : -1;
+      process.Close();
+      processes[idx] = nullptr;
+      if (next < startInfos.size())
+      {
+        startNext();
+      }
+      return false;
+    });
+  };
+  while (next < startInfos.size() && next < maxConcurrency)
+  {
+    startNext();
+  }
+  multiplexer->Run();
+  return results;
+}
+
 bool Process::ExecuteSystemCommand(const string& commandLine)
 {
   return ExecuteSystemCommand(commandLine, nullptr, nullptr, nullptr);
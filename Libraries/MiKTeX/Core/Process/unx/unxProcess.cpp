@@ -16,7 +16,11 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <poll.h>
 #include <signal.h>
+#if defined(HAVE_POSIX_SPAWN)
+#  include <spawn.h>
+#endif
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -36,6 +40,7 @@
 #   include <fcntl.h>
 #endif
 
+#include <algorithm>
 #include <thread>
 #include <tuple>
 
@@ -198,6 +203,92 @@ unique_ptr<Process> Process::Start(const ProcessStartInfo& startinfo)
     return make_unique<unxProcess>(startinfo);
 }
 
+#if defined(HAVE_POSIX_SPAWN)
+// posix_spawn() does not copy the address space of this process (glibc and
+// macOS have vfork semantics), which makes a difference when a big program
+// (e.g., TeX with a large main memory) runs a helper; returns -1, if the
+// child must be forked
+MIKTEXSTATICFUNC(pid_t) Spawn(const PathName& fileName, const Argv& argv, char** environmentPointers, const ProcessStartInfo& startinfo, const Pipe& pipeStdout, const Pipe& pipeStderr, const Pipe& pipeStdin, int fdChildStdin, int fdChildStderr)
+{
+#if !defined(POSIX_SPAWN_SETSID)
+    if (startinfo.Daemonize)
+    {
+        return -1;
+    }
+#endif
+#if !defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+    if (!startinfo.WorkingDirectory.empty())
+    {
+        return -1;
+    }
+#endif
+    posix_spawn_file_actions_t fileActions;
+    if (posix_spawn_file_actions_init(&fileActions) != 0)
+    {
+        return -1;
+    }
+    MIKTEX_AUTO(posix_spawn_file_actions_destroy(&fileActions));
+    posix_spawnattr_t attr;
+    if (posix_spawnattr_init(&attr) != 0)
+    {
+        return -1;
+    }
+    MIKTEX_AUTO(posix_spawnattr_destroy(&attr));
+    // the same as the forked child does
+    int ret = 0;
+    if (pipeStdout.GetWriteEnd() >= 0)
+    {
+        ret = ret != 0 ? ret : posix_spawn_file_actions_adddup2(&fileActions, pipeStdout.GetWriteEnd(), filenoStdout);
+    }
+    if (pipeStderr.GetWriteEnd() >= 0)
+    {
+        ret = ret != 0 ? ret : posix_spawn_file_actions_adddup2(&fileActions, pipeStderr.GetWriteEnd(), filenoStderr);
+    }
+    else if (fdChildStderr >= 0)
+    {
+        ret = ret != 0 ? ret : posix_spawn_file_actions_adddup2(&fileActions, fdChildStderr, filenoStderr);
+    }
+    if (pipeStdin.GetReadEnd() >= 0)
+    {
+        ret = ret != 0 ? ret : posix_spawn_file_actions_adddup2(&fileActions, pipeStdin.GetReadEnd(), filenoStdin);
+    }
+    else if (fdChildStdin >= 0)
+    {
+        ret = ret != 0 ? ret : posix_spawn_file_actions_adddup2(&fileActions, fdChildStdin, filenoStdin);
+    }
+    for (int fd : { fdChildStderr, fdChildStdin, pipeStdout.GetReadEnd(), pipeStdout.GetWriteEnd(), pipeStderr.GetReadEnd(), pipeStderr.GetWriteEnd(), pipeStdin.GetReadEnd(), pipeStdin.GetWriteEnd() })
+    {
+        if (fd > filenoStderr)
+        {
+            ret = ret != 0 ? ret : posix_spawn_file_actions_addclose(&fileActions, fd);
+        }
+    }
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+    if (!startinfo.WorkingDirectory.empty())
+    {
+        ret = ret != 0 ? ret : posix_spawn_file_actions_addchdir_np(&fileActions, startinfo.WorkingDirectory.c_str());
+    }
+#endif
+#if defined(POSIX_SPAWN_SETSID)
+    if (startinfo.Daemonize)
+    {
+        ret = ret != 0 ? ret : posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+    }
+#endif
+    if (ret != 0)
+    {
+        return -1;
+    }
+    pid_t pid;
+    if (posix_spawn(&pid, fileName.GetData(), &fileActions, &attr, const_cast<char* const*>(argv.GetArgv()), environmentPointers) != 0)
+    {
+        // let the forked child report the error
+        return -1;
+    }
+    return pid;
+}
+#endif
+
 #if defined(NDEBUG)
 #  define TRACEREDIR 0
 #else
@@ -273,12 +364,22 @@ void unxProcess::Create()
 
     session->UnloadFilenameDatabase();
 
+    startTime = chrono::system_clock::now();
+
+#if defined(HAVE_POSIX_SPAWN)
+    trace_process->WriteLine("core", TraceLevel::Info, "spawning...");
+    pid = Spawn(fileName, argv, environmentPointers, startinfo, pipeStdout, pipeStderr, pipeStdin, fdChildStdin, fdChildStderr);
+#endif
+
     // fork
-    trace_process->WriteLine("core", TraceLevel::Info, "forking...");
-    pid = fork();
     if (pid < 0)
     {
-        MIKTEX_FATAL_CRT_ERROR("fork");
+        trace_process->WriteLine("core", TraceLevel::Info, "forking...");
+        pid = fork();
+        if (pid < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("fork");
+        }
     }
 
     if (pid == 0)
@@ -358,6 +459,75 @@ void unxProcess::Create()
     pipeStdin.Dispose();
 }
 
+unique_ptr<PipeMultiplexer> PipeMultiplexer::Create()
+{
+    return make_unique<unxPipeMultiplexer>();
+}
+
+void unxPipeMultiplexer::Add(FILE* pipe, function<bool(const void*, size_t)> callback)
+{
+    int fd = fileno(pipe);
+    if (fd < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fileno");
+    }
+    newPipes.push_back(Pipe{ fd, callback });
+}
+
+void unxPipeMultiplexer::Run()
+{
+    const size_t CHUNK_SIZE = 64 * 1024;
+    vector<char> buf(CHUNK_SIZE);
+    vector<pollfd> pollFds;
+    while (true)
+    {
+        // pipes added by callbacks join here, not while the pipes are iterated
+        for (Pipe& pipe : newPipes)
+        {
+            pipes.push_back(std::move(pipe));
+        }
+        newPipes.clear();
+        if (pipes.empty())
+        {
+            break;
+        }
+        pollFds.clear();
+        for (const Pipe& pipe : pipes)
+        {
+            pollFds.push_back(pollfd{ pipe.fd, POLLIN, 0 });
+        }
+        if (poll(pollFds.data(), pollFds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            MIKTEX_FATAL_CRT_ERROR("poll");
+        }
+        // backwards, so that finished pipes can be removed
+        for (size_t k = pollFds.size(); k-- > 0; )
+        {
+            if (pollFds[k].revents == 0)
+            {
+                continue;
+            }
+            ssize_t n = read(pollFds[k].fd, buf.data(), buf.size());
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                MIKTEX_FATAL_CRT_ERROR("read");
+            }
+            if (!pipes[k].callback(buf.data(), n) || n == 0)
+            {
+                pipes.erase(pipes.begin() + k);
+            }
+        }
+    }
+}
+
 unxProcess::unxProcess(const ProcessStartInfo& startinfo):
     startinfo(startinfo)
 {
@@ -468,6 +638,7 @@ void unxProcess::WaitForExit()
         {
             trace_process->WriteLine("core", fmt::format("process {0} terminated due to signal {1}", pid, WTERMSIG(status)));
         }
+        RecordExit();
     }
 }
 
@@ -483,6 +654,7 @@ bool unxProcess::WaitForExit(int milliseconds)
         if (pid == this->pid)
         {
             this->pid = -1;
+            RecordExit();
             return true;
         }
         else if (pid < 0)
@@ -497,6 +669,16 @@ bool unxProcess::WaitForExit(int milliseconds)
     return false;
 }
 
+// the child adds its own events: this span shows the parent waiting
+void unxProcess::RecordExit()
+{
+    shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+    if (session != nullptr)
+    {
+        session->AddBuildTraceSpan("child", PathName(startinfo.FileName).GetFileName().ToString(), startTime, chrono::system_clock::now());
+    }
+}
+
 ProcessExitStatus unxProcess::get_ExitStatus() const
 {
     if (WIFEXITED(status) != 0)
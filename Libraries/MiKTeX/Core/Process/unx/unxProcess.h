@@ -16,7 +16,13 @@
 #if !defined(B6278A08DFEE4038A08449DD17C4E3D3)
 #define B6278A08DFEE4038A08449DD17C4E3D3
 
+#include <cstddef>
+#include <cstdio>
+
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include <miktex/Core/Process>
 #include <miktex/Core/TemporaryFile>
@@ -67,6 +73,8 @@ private:
 
     void Create();
 
+    void RecordExit();
+
     int fdStandardError = -1;
     int fdStandardInput = -1;
     int fdStandardOutput = -1;
@@ -75,12 +83,36 @@ private:
     FILE* pFileStandardOutput = nullptr;
     pid_t pid = -1;
     MiKTeX::Core::ProcessStartInfo startinfo;
+    std::chrono::system_clock::time_point startTime;
     int status;
     std::unique_ptr<MiKTeX::Core::TemporaryFile> tmpFile;
 
     friend class MiKTeX::Core::Process;
 };
 
+class unxPipeMultiplexer :
+    public MiKTeX::Core::PipeMultiplexer
+{
+
+public:
+
+    void Add(FILE* pipe, std::function<bool(const void*, std::size_t)> callback) override;
+
+    void Run() override;
+
+private:
+
+    struct Pipe
+    {
+        int fd;
+        std::function<bool(const void*, std::size_t)> callback;
+    };
+
+    std::vector<Pipe> pipes;
+
+    std::vector<Pipe> newPipes;
+};
+
 CORE_INTERNAL_END_NAMESPACE;
 
 #endif
@@ -32,9 +32,12 @@
 
 #include <io.h>
 
+#include <algorithm>
+
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Environment>
+#include <miktex/Core/FileStream>
 #include <miktex/Core/win/winAutoResource>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
@@ -305,11 +308,14 @@ void winProcess::Create()
 
     session->UnloadFilenameDatabase();
 
+    startTime = chrono::system_clock::now();
+
     if (!CreateProcessW(UW_(fileName.GetData()), UW_(commandLine.ToString()), nullptr, nullptr, TRUE, creationFlags, environmentStrings, startinfo.WorkingDirectory.empty() ? nullptr : UW_(startinfo.WorkingDirectory), &siStartInfo, &processInformation))
     {
       MIKTEX_FATAL_WINDOWS_ERROR_2("CreateProcess", "fileName", startinfo.FileName, "commandLine", commandLine.ToString());
     }
     processStarted = true;
+    exitPending = true;
   }
 
   catch (const exception&)
@@ -364,6 +370,81 @@ winProcess::winProcess(const ProcessStartInfo& startinfo) :
   Create();
 }
 
+unique_ptr<PipeMultiplexer> PipeMultiplexer::Create()
+{
+  return make_unique<winPipeMultiplexer>();
+}
+
+void winPipeMultiplexer::Add(FILE* pipe, function<bool(const void*, size_t)> callback)
+{
+  HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(pipe)));
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    MIKTEX_FATAL_CRT_ERROR("_get_osfhandle");
+  }
+  newPipes.push_back(Pipe{ handle, callback });
+}
+
+void winPipeMultiplexer::Run()
+{
+  // anonymous pipes cannot be waited for: the pipes are peeked at, and
+  // the thread sleeps a little longer each time none of them has data
+  const DWORD CHUNK_SIZE = 64 * 1024;
+  const DWORD MAX_IDLE_MILLISECONDS = 50;
+  vector<char> buf(CHUNK_SIZE);
+  DWORD idleMilliseconds = 0;
+  while (true)
+  {
+    // pipes added by callbacks join here, not while the pipes are iterated
+    for (Pipe& pipe : newPipes)
+    {
+      pipes.push_back(std::move(pipe));
+    }
+    newPipes.clear();
+    if (pipes.empty())
+    {
+      break;
+    }
+    size_t nPipes = pipes.size();
+    bool idle = true;
+    // backwards, so that finished pipes can be removed
+    for (size_t k = nPipes; k-- > 0; )
+    {
+      DWORD available;
+      DWORD n = 0;
+      if (!PeekNamedPipe(pipes[k].handle, nullptr, 0, nullptr, &available, nullptr))
+      {
+        if (::GetLastError() != ERROR_BROKEN_PIPE)
+        {
+          MIKTEX_FATAL_WINDOWS_ERROR("PeekNamedPipe");
+        }
+      }
+      else if (available == 0)
+      {
+        continue;
+      }
+      else if (!ReadFile(pipes[k].handle, buf.data(), std::min(available, CHUNK_SIZE), &n, nullptr))
+      {
+        MIKTEX_FATAL_WINDOWS_ERROR("ReadFile");
+      }
+      idle = false;
+      if (!pipes[k].callback(buf.data(), n) || n == 0)
+      {
+        pipes.erase(pipes.begin() + k);
+      }
+    }
+    if (idle)
+    {
+      Sleep(idleMilliseconds);
+      idleMilliseconds = std::min(idleMilliseconds * 2 + 1, MAX_IDLE_MILLISECONDS);
+    }
+    else
+    {
+      idleMilliseconds = 0;
+    }
+  }
+}
+
 winProcess::~winProcess()
 {
   try
@@ -470,12 +551,35 @@ FILE* winProcess::get_StandardError()
 
 void winProcess::WaitForExit()
 {
-  WaitForSingleObject(processInformation.hProcess, INFINITE);
+  if (WaitForSingleObject(processInformation.hProcess, INFINITE) == WAIT_OBJECT_0)
+  {
+    RecordExit();
+  }
 }
 
 bool winProcess::WaitForExit(int milliseconds)
 {
-  return WaitForSingleObject(processInformation.hProcess, static_cast<DWORD>(milliseconds)) == WAIT_OBJECT_0;
+  if (WaitForSingleObject(processInformation.hProcess, static_cast<DWORD>(milliseconds)) != WAIT_OBJECT_0)
+  {
+    return false;
+  }
+  RecordExit();
+  return true;
+}
+
+// the child adds its own events: this span shows the parent waiting
+void winProcess::RecordExit()
+{
+  if (!exitPending)
+  {
+    return;
+  }
+  exitPending = false;
+  shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+  if (session != nullptr)
+  {
+    session->AddBuildTraceSpan("child", PathName(startinfo.FileName).GetFileName().ToString(), startTime, chrono::system_clock::now());
+  }
 }
 
 ProcessExitStatus winProcess::get_ExitStatus() const
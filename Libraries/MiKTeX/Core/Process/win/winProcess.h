@@ -21,7 +21,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdio>
+
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include <miktex/Core/Process>
 #include <miktex/Core/TemporaryFile>
@@ -82,6 +88,9 @@ public:
 private:
   void Create();
 
+private:
+  void RecordExit();
+
 private:
   MiKTeX::Core::ProcessStartInfo startinfo;
 
@@ -101,6 +110,13 @@ private:
 private:
   bool processStarted = false;
 
+private:
+  // the child has been started by us and its exit has not been recorded yet
+  bool exitPending = false;
+
+private:
+  std::chrono::system_clock::time_point startTime;
+
 private:
   PROCESSENTRY32W processEntry;
 
@@ -117,4 +133,27 @@ private:
   friend class MiKTeX::Core::Process;
 };
 
+class winPipeMultiplexer :
+  public MiKTeX::Core::PipeMultiplexer
+{
+public:
+  void MIKTEXTHISCALL Add(FILE* pipe, std::function<bool(const void*, std::size_t)> callback) override;
+
+public:
+  void MIKTEXTHISCALL Run() override;
+
+private:
+  struct Pipe
+  {
+    HANDLE handle;
+    std::function<bool(const void*, std::size_t)> callback;
+  };
+
+private:
+  std::vector<Pipe> pipes;
+
+private:
+  std::vector<Pipe> newPipes;
+};
+
 CORE_INTERNAL_END_NAMESPACE;
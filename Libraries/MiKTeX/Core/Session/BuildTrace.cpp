@@ -0,0 +1,93 @@
+/**
+ * @file Session/BuildTrace.cpp
+ * @author Christian Schenk
+ * @brief Build timeline
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <fstream>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/File>
+#include <miktex/Core/LockFile>
+#include <miktex/Core/Process>
+
+#include "internal.h"
+
+#include "Session/BuildTrace.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+// other processes may be appending their events
+constexpr chrono::milliseconds LOCK_TIMEOUT = 10s;
+
+static long long Microseconds(BuildTrace::Clock::time_point t)
+{
+    return chrono::duration_cast<chrono::microseconds>(t.time_since_epoch()).count();
+}
+
+static long long Microseconds(chrono::nanoseconds d)
+{
+    return chrono::duration_cast<chrono::microseconds>(d).count();
+}
+
+BuildTrace::BuildTrace() :
+    processStart(Clock::now())
+{
+}
+
+void BuildTrace::AddSpan(const string& category, const string& name, Clock::time_point start, Clock::time_point end)
+{
+    lock_guard<mutex> lockGuard(traceMutex);
+    auto it = threadIds.emplace(this_thread::get_id(), static_cast<unsigned>(threadIds.size())).first;
+    spans.push_back(Span{ category, name, start, end, it->second });
+}
+
+void BuildTrace::RecordFindFile(chrono::nanoseconds latency)
+{
+    lock_guard<mutex> lockGuard(traceMutex);
+    findFileRequests++;
+    findFileLatency += latency;
+}
+
+void BuildTrace::Write(const PathName& traceFile, const string& programName)
+{
+    lock_guard<mutex> lockGuard(traceMutex);
+    Clock::time_point processEnd = Clock::now();
+    int pid = Process::GetCurrentProcess()->GetSystemId();
+    string events = fmt::format("{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":{0},\"tid\":0,\"args\":{{\"name\":{1}}}}},\n", pid, JsonString(programName));
+    events += fmt::format("{{\"name\":{0},\"cat\":\"process\",\"ph\":\"X\",\"ts\":{1},\"dur\":{2},\"pid\":{3},\"tid\":0,\"args\":{{\"findFileRequests\":{4},\"findFileMicroseconds\":{5}}}}},\n",
+        JsonString(programName), Microseconds(processStart), Microseconds(processEnd) - Microseconds(processStart), pid, findFileRequests, Microseconds(findFileLatency));
+    for (const Span& span : spans)
+    {
+        events += fmt::format("{{\"name\":{0},\"cat\":{1},\"ph\":\"X\",\"ts\":{2},\"dur\":{3},\"pid\":{4},\"tid\":{5}}},\n",
+            JsonString(span.name), JsonString(span.category), Microseconds(span.start), Microseconds(span.end) - Microseconds(span.start), pid, span.tid);
+    }
+    unique_ptr<LockFile> lockFile = LockFile::Create(PathName(traceFile.ToString() + ".lock"));
+    if (!lockFile->TryLock(LOCK_TIMEOUT))
+    {
+        MIKTEX_FATAL_ERROR_2(T_("The build trace file is locked."), "path", traceFile.ToString());
+    }
+    // the array is never closed: viewers accept a missing closing bracket
+    bool first = !File::Exists(traceFile) || File::GetSize(traceFile) == 0;
+    ofstream stream = File::CreateOutputStream(traceFile, ios_base::app | ios_base::binary);
+    if (first)
+    {
+        stream << "[\n";
+    }
+    stream << events;
+    stream.close();
+    lockFile->Unlock();
+}
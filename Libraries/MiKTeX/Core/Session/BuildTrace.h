@@ -0,0 +1,85 @@
+/**
+ * @file Session/BuildTrace.h
+ * @author Christian Schenk
+ * @brief Build timeline
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Collects the spans of a build timeline.
+///
+/// The events are appended to the trace file in the Trace Event Format
+/// (JSON array form, which may lack the closing bracket), so that texify
+/// and all the programs it runs can contribute to one timeline.  Time
+/// stamps are wall clock times: the processes do not share a monotonic
+/// clock.
+class BuildTrace
+{
+
+public:
+
+    typedef std::chrono::system_clock Clock;
+
+    BuildTrace();
+
+    /// Adds a span.
+    /// @param category The category of the span.
+    /// @param name The name of the span.
+    /// @param start The start of the span.
+    /// @param end The end of the span.
+    void AddSpan(const std::string& category, const std::string& name, Clock::time_point start, Clock::time_point end);
+
+    /// Records a find-file request.
+    /// @param latency The time it took to look for the file.
+    void RecordFindFile(std::chrono::nanoseconds latency);
+
+    /// Appends the events of this process to the trace file.
+    /// @param traceFile The path to the trace file.
+    /// @param programName The name of this program.
+    void Write(const MiKTeX::Util::PathName& traceFile, const std::string& programName);
+
+private:
+
+    struct Span
+    {
+        std::string category;
+        std::string name;
+        Clock::time_point start;
+        Clock::time_point end;
+        unsigned tid;
+    };
+
+    Clock::time_point processStart;
+
+    std::vector<Span> spans;
+
+    // small numbers are easier to read in the viewer
+    std::unordered_map<std::thread::id, unsigned> threadIds;
+
+    std::uint64_t findFileRequests = 0;
+
+    std::chrono::nanoseconds findFileLatency = std::chrono::nanoseconds::zero();
+
+    std::mutex traceMutex;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,90 @@
+/**
+ * @file Session/CompiledSearchPath.h
+ * @author Christian Schenk
+ * @brief Expanded and pre-parsed search paths
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// A directory pattern with everything the FNDB matcher needs.
+struct CompiledPathPattern
+{
+    /// The fully expanded directory pattern (e.g. `/texmf/tex/latex//`).
+    MiKTeX::Util::PathName path;
+
+    /// Indicates whether the pattern addresses the package manager's virtual
+    /// tree.
+    bool isMpm = false;
+
+    /// The index of the TEXMF root directory which covers the pattern.
+    unsigned rootIndex = MiKTeX::Core::INVALID_ROOT_INDEX;
+
+    /// The TEXMF root directory which covers the pattern, or empty.
+    MiKTeX::Util::PathName rootDirectory;
+
+    /// The pattern relative to `rootDirectory`, transformed for comparison.
+    std::string comparableRelativePath;
+};
+
+/// An immutable, expanded search path.
+///
+/// Instances are shared: holders of a `shared_ptr` can carry on when the
+/// session discards its search path cache.
+class CompiledSearchPath
+{
+
+public:
+
+    explicit CompiledSearchPath(std::vector<CompiledPathPattern>&& patterns) :
+        patterns(std::move(patterns))
+    {
+        pathNames.reserve(this->patterns.size());
+        for (const CompiledPathPattern& pattern : this->patterns)
+        {
+            pathNames.push_back(pattern.path);
+        }
+        searchPath = MakeSearchPath(pathNames);
+    }
+
+    const std::vector<CompiledPathPattern>& GetPatterns() const
+    {
+        return patterns;
+    }
+
+    const std::vector<MiKTeX::Util::PathName>& GetPathNames() const
+    {
+        return pathNames;
+    }
+
+    /// Gets the path names as a search path string.
+    const std::string& GetSearchPath() const
+    {
+        return searchPath;
+    }
+
+private:
+
+    std::vector<MiKTeX::Util::PathName> pathNames;
+
+    std::string searchPath;
+
+    std::vector<CompiledPathPattern> patterns;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,114 @@
+/**
+ * @file Session/ConfigValueCache.cpp
+ * @author Christian Schenk
+ * @brief Resolved configuration values
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <miktex/Core/Directory>
+
+#include "internal.h"
+
+#include "Session/ConfigValueCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+ConfigValueCache::ConfigValueCache(shared_ptr<FileSystemWatcher> fsWatcher) :
+    fsWatcher(fsWatcher),
+    environmentGeneration(GetEnvironmentGeneration())
+{
+    if (fsWatcher != nullptr)
+    {
+        fsWatcher->Subscribe(this);
+    }
+}
+
+ConfigValueCache::~ConfigValueCache()
+{
+    try
+    {
+        if (fsWatcher != nullptr)
+        {
+            fsWatcher->Unsubscribe(this);
+        }
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+void ConfigValueCache::ClearIfInvalidated()
+{
+    unsigned currentEnvironmentGeneration = GetEnvironmentGeneration();
+    if (invalidated.exchange(false) || environmentGeneration != currentEnvironmentGeneration)
+    {
+        values.clear();
+        environmentGeneration = currentEnvironmentGeneration;
+    }
+}
+
+bool ConfigValueCache::TryGet(const string& key, bool& haveValue, string& value)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    ClearIfInvalidated();
+    auto it = values.find(key);
+    if (it == values.end())
+    {
+        return false;
+    }
+    haveValue = it->second.first;
+    value = it->second.second;
+    return true;
+}
+
+void ConfigValueCache::Put(const string& key, bool haveValue, const string& value)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    ClearIfInvalidated();
+    values[key] = make_pair(haveValue, value);
+}
+
+void ConfigValueCache::Watch(const vector<PathName>& directories)
+{
+    if (fsWatcher == nullptr)
+    {
+        return;
+    }
+    vector<PathName> watchable;
+    for (const PathName& dir : directories)
+    {
+        if (dir.IsFullyQualified() && Directory::Exists(dir))
+        {
+            watchable.push_back(dir);
+        }
+    }
+    if (watchable.empty())
+    {
+        return;
+    }
+    try
+    {
+        fsWatcher->AddDirectories(watchable);
+    }
+    catch (const exception&)
+    {
+        // SetConfigValue() still invalidates the cache
+    }
+}
+
+void ConfigValueCache::OnChange(const FileSystemChangeEvent& ev)
+{
+    // configuration files may have been changed
+    invalidated = true;
+}
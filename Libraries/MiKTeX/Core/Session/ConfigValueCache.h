@@ -0,0 +1,81 @@
+/**
+ * @file Session/ConfigValueCache.h
+ * @author Christian Schenk
+ * @brief Resolved configuration values
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <miktex/Core/FileSystemWatcher>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Remembers configuration values as resolved from the environment, the
+/// registry and the configuration files, i.e., before the value is expanded.
+///
+/// All values are forgotten when the environment is changed, or when a file
+/// in a watched directory is modified.
+class ConfigValueCache :
+    public MiKTeX::Core::FileSystemWatcherCallback
+{
+
+public:
+
+    ConfigValueCache(std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher);
+
+    ~ConfigValueCache();
+
+    ConfigValueCache(const ConfigValueCache& other) = delete;
+
+    ConfigValueCache& operator=(const ConfigValueCache& other) = delete;
+
+    /// Looks up a resolved value.
+    /// @param key The lookup key.
+    /// @param[out] haveValue Indicates whether the value is defined.
+    /// @param[out] value The unexpanded value.
+    /// @return Returns `false`, if the key is unknown.
+    bool TryGet(const std::string& key, bool& haveValue, std::string& value);
+
+    void Put(const std::string& key, bool haveValue, const std::string& value);
+
+    void Invalidate()
+    {
+        invalidated = true;
+    }
+
+    void Watch(const std::vector<MiKTeX::Util::PathName>& directories);
+
+    void OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override;
+
+private:
+
+    void ClearIfInvalidated();
+
+    std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
+
+    std::atomic_bool invalidated{ false };
+
+    unsigned environmentGeneration = 0;
+
+    std::unordered_map<std::string, std::pair<bool, std::string>> values;
+
+    std::mutex mutex;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,140 @@
+/**
+ * @file Session/DirectoryIndex.cpp
+ * @author Christian Schenk
+ * @brief In-memory index of directories without an FNDB
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+
+#include "internal.h"
+
+#include "Session/DirectoryIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    string MakeComparable(const PathName& path)
+    {
+        PathName comparable(path);
+        comparable.TransformForComparison();
+        return comparable.ToString();
+    }
+}
+
+DirectoryIndex::DirectoryIndex(shared_ptr<FileSystemWatcher> fsWatcher) :
+    fsWatcher(fsWatcher)
+{
+    if (fsWatcher != nullptr)
+    {
+        fsWatcher->Subscribe(this);
+    }
+}
+
+DirectoryIndex::~DirectoryIndex()
+{
+    try
+    {
+        if (fsWatcher != nullptr)
+        {
+            fsWatcher->Unsubscribe(this);
+        }
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+TriState DirectoryIndex::Contains(const PathName& directory, const string& fileName)
+{
+    // without notifications, a listing would become stale
+    if (fsWatcher == nullptr || !directory.IsFullyQualified() || std::any_of(fileName.begin(), fileName.end(), [](char ch) { return PathNameUtil::IsDirectoryDelimiter(ch); }))
+    {
+        return TriState::Undetermined;
+    }
+    string key = MakeComparable(directory);
+    string comparableFileName = MakeComparable(PathName(fileName));
+    size_t gen;
+    {
+        lock_guard<std::mutex> lockGuard(mutex);
+        auto it = listings.find(key);
+        if (it != listings.end())
+        {
+            return it->second->find(comparableFileName) != it->second->end() ? TriState::True : TriState::False;
+        }
+        if (unwatchable.find(key) != unwatchable.end())
+        {
+            return TriState::Undetermined;
+        }
+        gen = generation;
+    }
+    // watch first: changes made while the directory is read are noticed
+    try
+    {
+        if (!Directory::Exists(directory))
+        {
+            return TriState::Undetermined;
+        }
+        fsWatcher->AddDirectories({ directory });
+    }
+    catch (const exception&)
+    {
+        lock_guard<std::mutex> lockGuard(mutex);
+        unwatchable.insert(key);
+        return TriState::Undetermined;
+    }
+    auto listing = make_shared<Listing>();
+    try
+    {
+        DirectoryListing entries;
+        DirectoryLister::ReadAll(directory, (int)DirectoryLister::Options::None, entries);
+        for (size_t idx = 0; idx < entries.GetCount(); ++idx)
+        {
+            listing->insert(MakeComparable(PathName(entries.GetName(idx))));
+        }
+    }
+    catch (const exception&)
+    {
+        return TriState::Undetermined;
+    }
+    bool found = listing->find(comparableFileName) != listing->end();
+    lock_guard<std::mutex> lockGuard(mutex);
+    if (gen == generation)
+    {
+        listings[key] = listing;
+    }
+    return found ? TriState::True : TriState::False;
+}
+
+void DirectoryIndex::Invalidate(const PathName& directory)
+{
+    string key = MakeComparable(directory);
+    lock_guard<std::mutex> lockGuard(mutex);
+    ++generation;
+    listings.erase(key);
+}
+
+void DirectoryIndex::OnChange(const FileSystemChangeEvent& ev)
+{
+    // file contents do not matter
+    if (ev.action != FileSystemChangeAction::Modified)
+    {
+        Invalidate(ev.fileName.GetDirectoryName());
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file Session/DirectoryIndex.h
+ * @author Christian Schenk
+ * @brief In-memory index of directories without an FNDB
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <miktex/Configuration/TriState>
+#include <miktex/Core/FileSystemWatcher>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Remembers the file names of searched directories.
+///
+/// A directory is read the first time a file is searched in it.  Its
+/// listing is dropped when a file is added to or removed from the directory.
+/// Directories which cannot be watched are not indexed.
+class DirectoryIndex :
+    public MiKTeX::Core::FileSystemWatcherCallback
+{
+
+public:
+
+    DirectoryIndex(std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher);
+
+    ~DirectoryIndex();
+
+    DirectoryIndex(const DirectoryIndex& other) = delete;
+
+    DirectoryIndex& operator=(const DirectoryIndex& other) = delete;
+
+    /// Checks whether a directory has an entry of the given name.
+    /// @param directory The fully qualified path to the directory.
+    /// @param fileName The name of the entry (without directory).
+    /// @return Returns `TriState::Undetermined`, if the directory is not
+    /// indexed.  `TriState::True` does not imply a file: the entry can be a
+    /// directory or a dangling link.
+    MiKTeX::Configuration::TriState Contains(const MiKTeX::Util::PathName& directory, const std::string& fileName);
+
+    /// Drops the listing of a directory.
+    void Invalidate(const MiKTeX::Util::PathName& directory);
+
+    void OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override;
+
+private:
+
+    typedef std::unordered_set<std::string> Listing;
+
+    std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
+
+    // incremented with each change, so that a listing which has been read
+    // during a change is not kept
+    std::size_t generation = 0;
+
+    std::unordered_map<std::string, std::shared_ptr<const Listing>> listings;
+
+    std::mutex mutex;
+
+    std::unordered_set<std::string> unwatchable;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,102 @@
+/**
+ * @file Session/ExpansionCache.cpp
+ * @author Christian Schenk
+ * @brief Memoized expansions
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include "internal.h"
+
+#include "Session/ExpansionCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+ExpansionCache::ExpansionCache(shared_ptr<FileSystemWatcher> fsWatcher) :
+    fsWatcher(fsWatcher),
+    environmentGeneration(GetEnvironmentGeneration())
+{
+    if (fsWatcher != nullptr)
+    {
+        fsWatcher->Subscribe(this);
+    }
+}
+
+ExpansionCache::~ExpansionCache()
+{
+    try
+    {
+        if (fsWatcher != nullptr)
+        {
+            fsWatcher->Unsubscribe(this);
+        }
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+unsigned ExpansionCache::GetGeneration()
+{
+    unsigned currentEnvironmentGeneration = GetEnvironmentGeneration();
+    unsigned currentInvalidations = invalidations;
+    if (seenInvalidations != currentInvalidations || environmentGeneration != currentEnvironmentGeneration)
+    {
+        ++currentGeneration;
+        seenInvalidations = currentInvalidations;
+        environmentGeneration = currentEnvironmentGeneration;
+    }
+    return currentGeneration;
+}
+
+ExpansionCache::Lookup ExpansionCache::TryGet(const string& key, unsigned& generation, string& expansion, vector<Dependency>& dependencies)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    generation = GetGeneration();
+    auto it = entries.find(key);
+    if (it == entries.end())
+    {
+        return Lookup::Miss;
+    }
+    expansion = it->second.expansion;
+    if (it->second.generation == generation)
+    {
+        return Lookup::Hit;
+    }
+    dependencies = it->second.dependencies;
+    return Lookup::Stale;
+}
+
+void ExpansionCache::Put(const string& key, unsigned generation, const string& expansion, vector<Dependency>&& dependencies)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    Entry& entry = entries[key];
+    entry.generation = generation;
+    entry.expansion = expansion;
+    entry.dependencies = std::move(dependencies);
+}
+
+void ExpansionCache::Revalidate(const string& key, unsigned generation)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end())
+    {
+        it->second.generation = generation;
+    }
+}
+
+void ExpansionCache::OnChange(const FileSystemChangeEvent& ev)
+{
+    // configuration files may have been changed
+    ++invalidations;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file Session/ExpansionCache.h
+ * @author Christian Schenk
+ * @brief Memoized expansions
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/FileSystemWatcher>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Remembers the results of `$VALUE` expansions.
+///
+/// An entry records the values it depends on.  The cache generation is
+/// bumped when the configuration, the environment or the root directories
+/// change; an entry of an older generation is stale but not lost: it is used
+/// again, if its dependencies still resolve to the recorded values.
+class ExpansionCache :
+    public MiKTeX::Core::FileSystemWatcherCallback
+{
+
+public:
+
+    struct Dependency
+    {
+        std::string valueName;
+        bool haveValue = false;
+        std::string value;
+    };
+
+    enum class Lookup
+    {
+        Miss,
+        Hit,
+        Stale
+    };
+
+    ExpansionCache(std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher);
+
+    ~ExpansionCache();
+
+    ExpansionCache(const ExpansionCache& other) = delete;
+
+    ExpansionCache& operator=(const ExpansionCache& other) = delete;
+
+    /// Looks up an expansion.
+    /// @param key The lookup key.
+    /// @param[out] generation The current generation.
+    /// @param[out] expansion The expansion.
+    /// @param[out] dependencies The dependencies of a stale entry.
+    /// @return Returns `Lookup::Stale`, if the dependencies must be checked.
+    Lookup TryGet(const std::string& key, unsigned& generation, std::string& expansion, std::vector<Dependency>& dependencies);
+
+    void Put(const std::string& key, unsigned generation, const std::string& expansion, std::vector<Dependency>&& dependencies);
+
+    /// Marks a stale entry as valid.
+    void Revalidate(const std::string& key, unsigned generation);
+
+    void Invalidate()
+    {
+        ++invalidations;
+    }
+
+    void OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override;
+
+private:
+
+    struct Entry
+    {
+        unsigned generation = 0;
+        std::string expansion;
+        std::vector<Dependency> dependencies;
+    };
+
+    unsigned GetGeneration();
+
+    std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
+
+    std::atomic_uint invalidations{ 0 };
+
+    unsigned environmentGeneration = 0;
+
+    unsigned currentGeneration = 0;
+
+    unsigned seenInvalidations = 0;
+
+    std::unordered_map<std::string, Entry> entries;
+
+    std::mutex mutex;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,197 @@
+/**
+ * @file Session/FindFileCache.cpp
+ * @author Christian Schenk
+ * @brief Persistent find-file result cache
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#if defined(MIKTEX_WINDOWS)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/AutoResource>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Utils>
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "Session/FindFileCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+constexpr const char* FIND_FILE_CACHE_SIGNATURE = "miktex-findfile-cache-1";
+
+constexpr const char* NOT_FOUND = "?";
+
+constexpr size_t MAX_PENDING_ENTRIES = 64;
+
+FindFileCache::FindFileCache(const PathName& path, const string& generation) :
+    generation(generation),
+    path(path),
+    trace_filesearch(TraceStream::Open(MIKTEX_TRACE_FILESEARCH))
+{
+}
+
+FindFileCache::~FindFileCache()
+{
+    Flush();
+}
+
+void FindFileCache::Load()
+{
+    loaded = true;
+    if (!File::Exists(path))
+    {
+        return;
+    }
+    FileStream reader(File::Open(path, FileMode::Open, FileAccess::Read, false));
+    if (!File::TryLock(reader.GetFile(), File::LockType::Shared, 100ms))
+    {
+        trace_filesearch->WriteLine("core", fmt::format(T_("find-file cache {0} is locked; not using it"), Q_(path)));
+        disabled = true;
+        return;
+    }
+    string line;
+    if (!Utils::ReadLine(line, reader.GetFile(), false) || line != fmt::format("{0} {1}", FIND_FILE_CACHE_SIGNATURE, generation))
+    {
+        trace_filesearch->WriteLine("core", fmt::format(T_("find-file cache {0} is out of date"), Q_(path)));
+        File::Unlock(reader.GetFile());
+        reader.Close();
+        return;
+    }
+    while (Utils::ReadLine(line, reader.GetFile(), false))
+    {
+        string::size_type tab = line.find('\t');
+        if (tab == string::npos || tab == 0 || tab + 1 == line.length())
+        {
+            // partially written entry
+            continue;
+        }
+        string value = line.substr(tab + 1);
+        entries[line.substr(0, tab)] = value == NOT_FOUND ? PathName() : PathName(value);
+    }
+    File::Unlock(reader.GetFile());
+    reader.Close();
+    trace_filesearch->WriteLine("core", fmt::format(T_("loaded {0} find-file cache entries from {1}"), entries.size(), Q_(path)));
+}
+
+bool FindFileCache::TryGet(const string& key, PathName& result)
+{
+    if (disabled)
+    {
+        return false;
+    }
+    try
+    {
+        if (!loaded)
+        {
+            Load();
+        }
+    }
+    catch (const exception& e)
+    {
+        trace_filesearch->WriteLine("core", TraceLevel::Error, fmt::format(T_("find-file cache {0} cannot be read: {1}"), Q_(path), e.what()));
+        disabled = true;
+        return false;
+    }
+    auto it = entries.find(key);
+    if (it == entries.end())
+    {
+        return false;
+    }
+    result = it->second;
+    return true;
+}
+
+void FindFileCache::Put(const string& key, const PathName& result)
+{
+    if (disabled || !loaded || key.find_first_of("\t\n") != string::npos || strpbrk(result.GetData(), "\t\n") != nullptr)
+    {
+        return;
+    }
+    entries[key] = result;
+    pending.push_back(make_pair(key, result));
+    if (pending.size() >= MAX_PENDING_ENTRIES)
+    {
+        Flush();
+    }
+}
+
+void FindFileCache::Flush()
+{
+    if (disabled || pending.empty())
+    {
+        return;
+    }
+    try
+    {
+        // append mode: the file is not truncated before we hold the lock
+        FileStream stream(File::Open(path, FileMode::Append, FileAccess::ReadWrite, false));
+        if (!File::TryLock(stream.GetFile(), File::LockType::Exclusive, 100ms))
+        {
+            stream.Close();
+            pending.clear();
+            return;
+        }
+        MIKTEX_AUTO(File::Unlock(stream.GetFile()));
+        string header = fmt::format("{0} {1}", FIND_FILE_CACHE_SIGNATURE, generation);
+        string line;
+        string s;
+        if (fseek(stream.GetFile(), 0, SEEK_SET) != 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString());
+        }
+        if (!Utils::ReadLine(line, stream.GetFile(), false) || line != header)
+        {
+            // written for another FNDB generation (or not at all)
+#if defined(MIKTEX_WINDOWS)
+            if (_chsize_s(_fileno(stream.GetFile()), 0) != 0)
+            {
+                MIKTEX_FATAL_CRT_ERROR_2("_chsize_s", "path", path.ToString());
+            }
+#else
+            if (ftruncate(fileno(stream.GetFile()), 0) != 0)
+            {
+                MIKTEX_FATAL_CRT_ERROR_2("ftruncate", "path", path.ToString());
+            }
+#endif
+            s = header + "\n";
+        }
+        for (const auto& p : pending)
+        {
+            s += fmt::format("{0}\t{1}\n", p.first, p.second.Empty() ? NOT_FOUND : p.second.ToString());
+        }
+        pending.clear();
+        if (fseek(stream.GetFile(), 0, SEEK_END) != 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString());
+        }
+        fputs(s.c_str(), stream.GetFile());
+        fflush(stream.GetFile());
+    }
+    catch (const exception& e)
+    {
+        trace_filesearch->WriteLine("core", TraceLevel::Error, fmt::format(T_("find-file cache {0} cannot be written: {1}"), Q_(path), e.what()));
+        disabled = true;
+        pending.clear();
+    }
+}
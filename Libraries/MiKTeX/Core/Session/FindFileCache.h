@@ -0,0 +1,68 @@
+/**
+ * @file Session/FindFileCache.h
+ * @author Christian Schenk
+ * @brief Persistent find-file result cache
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <miktex/Trace/TraceStream>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Find-file results which survive the process.
+///
+/// The cache file starts with a header line carrying the FNDB generation;
+/// entries (one per line) are appended by the processes which resolve a
+/// file for the first time.  New entries are collected and written in
+/// batches; the header is checked again while the cache file is locked,
+/// and the file is started over when the generation has changed.  An
+/// empty path records an unsuccessful search.
+class FindFileCache
+{
+
+public:
+
+    FindFileCache(const MiKTeX::Util::PathName& path, const std::string& generation);
+
+    ~FindFileCache();
+
+    bool TryGet(const std::string& key, MiKTeX::Util::PathName& path);
+
+    void Put(const std::string& key, const MiKTeX::Util::PathName& path);
+
+    void Flush();
+
+private:
+
+    void Load();
+
+    bool disabled = false;
+
+    std::unordered_map<std::string, MiKTeX::Util::PathName> entries;
+
+    std::string generation;
+
+    bool loaded = false;
+
+    MiKTeX::Util::PathName path;
+
+    std::vector<std::pair<std::string, MiKTeX::Util::PathName>> pending;
+
+    std::unique_ptr<MiKTeX::Trace::TraceStream> trace_filesearch;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
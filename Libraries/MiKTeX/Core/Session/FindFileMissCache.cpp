@@ -0,0 +1,119 @@
+/**
+ * @file Session/FindFileMissCache.cpp
+ * @author Christian Schenk
+ * @brief Negative find-file results
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Paths>
+
+#include "internal.h"
+
+#include "Session/FindFileMissCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+FindFileMissCache::FindFileMissCache(shared_ptr<FileSystemWatcher> fsWatcher, size_t capacity) :
+    capacity(capacity),
+    fsWatcher(fsWatcher)
+{
+    if (fsWatcher != nullptr)
+    {
+        fsWatcher->Subscribe(this);
+    }
+}
+
+FindFileMissCache::~FindFileMissCache()
+{
+    try
+    {
+        if (fsWatcher != nullptr)
+        {
+            fsWatcher->Unsubscribe(this);
+        }
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+void FindFileMissCache::ClearIfInvalidated()
+{
+    if (invalidated.exchange(false))
+    {
+        keys.clear();
+        order.clear();
+    }
+}
+
+bool FindFileMissCache::Contains(const string& key)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    ClearIfInvalidated();
+    return keys.find(key) != keys.end();
+}
+
+void FindFileMissCache::Insert(const string& key)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    ClearIfInvalidated();
+    if (capacity == 0 || !keys.insert(key).second)
+    {
+        return;
+    }
+    order.push_back(key);
+    if (order.size() > capacity)
+    {
+        keys.erase(order.front());
+        order.pop_front();
+    }
+}
+
+void FindFileMissCache::Watch(const vector<PathName>& directories)
+{
+    if (fsWatcher == nullptr)
+    {
+        return;
+    }
+    vector<PathName> watchable;
+    for (const PathName& dir : directories)
+    {
+        if (dir.IsFullyQualified() && Directory::Exists(dir))
+        {
+            watchable.push_back(dir);
+        }
+    }
+    if (watchable.empty())
+    {
+        return;
+    }
+    try
+    {
+        fsWatcher->AddDirectories(watchable);
+    }
+    catch (const exception&)
+    {
+        // the shadow check in FindFileByType() keeps us safe
+    }
+}
+
+void FindFileMissCache::OnChange(const FileSystemChangeEvent& ev)
+{
+    // file contents do not matter, except for the FNDB change file
+    if (ev.action != FileSystemChangeAction::Modified || EndsWith(ev.fileName.ToString(), MIKTEX_FNDB_CHANGE_FILE_SUFFIX))
+    {
+        Invalidate();
+    }
+}
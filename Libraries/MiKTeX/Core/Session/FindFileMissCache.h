@@ -0,0 +1,86 @@
+/**
+ * @file Session/FindFileMissCache.h
+ * @author Christian Schenk
+ * @brief Negative find-file results
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <miktex/Core/FileSystemWatcher>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Remembers unsuccessful file searches.
+///
+/// The cache holds at most `capacity` keys; the oldest key is dropped first.
+/// All keys are forgotten when a file is added to or removed from a watched
+/// directory, or when an FNDB change file is modified.
+class FindFileMissCache :
+    public MiKTeX::Core::FileSystemWatcherCallback
+{
+
+public:
+
+    FindFileMissCache(std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher, std::size_t capacity);
+
+    ~FindFileMissCache();
+
+    FindFileMissCache(const FindFileMissCache& other) = delete;
+
+    FindFileMissCache& operator=(const FindFileMissCache& other) = delete;
+
+    bool Contains(const std::string& key);
+
+    void Insert(const std::string& key);
+
+    void Invalidate()
+    {
+        invalidated = true;
+        ++generation;
+    }
+
+    std::size_t GetGeneration() const
+    {
+        return generation;
+    }
+
+    void Watch(const std::vector<MiKTeX::Util::PathName>& directories);
+
+    void OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override;
+
+private:
+
+    void ClearIfInvalidated();
+
+    std::size_t capacity;
+
+    std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
+
+    std::atomic_bool invalidated{ false };
+
+    std::atomic<std::size_t> generation{ 0 };
+
+    std::unordered_set<std::string> keys;
+
+    std::mutex mutex;
+
+    std::deque<std::string> order;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
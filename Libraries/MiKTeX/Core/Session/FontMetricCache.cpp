@@ -0,0 +1,252 @@
+/**
+ * @file Session/FontMetricCache.cpp
+ * @author Christian Schenk
+ * @brief Persistent font metric cache
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Process>
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "Session/FontMetricCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+constexpr const char FONT_METRIC_CACHE_SIGNATURE[] = "miktex-font-metric-cache-1\n";
+
+// record signature: 'F', 'M', 'C', '1'
+constexpr uint32_t RECORD_MAGIC = 0x31434d46;
+
+// a cache file which is larger than this is replaced by the next process
+// which adds an entry
+constexpr size_t MAX_CACHE_SIZE = 16 * 1024 * 1024;
+
+// font metric files are small; OFM files for large Unicode fonts are the
+// exception
+constexpr size_t MAX_FONT_METRIC_FILE_SIZE = 4 * 1024 * 1024;
+
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t pathLength;
+    int64_t lastWriteTime;
+    uint32_t size;
+    uint32_t checksum;
+};
+
+FontMetricCache::FontMetricCache(const PathName& path) :
+    path(path),
+    trace_fontinfo(TraceStream::Open(MIKTEX_TRACE_FONTINFO))
+{
+}
+
+uint32_t FontMetricCache::Checksum(const unsigned char* data, size_t size)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        hash ^= data[idx];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool FontMetricCache::IsPlausible(const vector<unsigned char>& data)
+{
+    if (data.size() < 24 || data.size() > MAX_FONT_METRIC_FILE_SIZE)
+    {
+        return false;
+    }
+    if (data[0] == 247 && data[1] == 202)
+    {
+        // VF: pre, id
+        return true;
+    }
+    size_t lf;
+    if (data[0] != 0 || data[1] != 0)
+    {
+        // TFM: the length of the file (in words) comes first
+        lf = (static_cast<size_t>(data[0]) << 8) | data[1];
+    }
+    else
+    {
+        // OFM: the level comes first, then the length of the file
+        if (data[2] != 0 || data[3] > 2)
+        {
+            return false;
+        }
+        lf = (static_cast<size_t>(data[4]) << 24) | (static_cast<size_t>(data[5]) << 16) | (static_cast<size_t>(data[6]) << 8) | data[7];
+    }
+    return lf * 4 <= data.size();
+}
+
+void FontMetricCache::Load()
+{
+    loaded = true;
+    if (!File::Exists(path) || File::GetSize(path) < sizeof(FONT_METRIC_CACHE_SIGNATURE) - 1)
+    {
+        return;
+    }
+    mapping.reset(MemoryMappedFile::Create());
+    // the records are scanned from start to end
+    mapping->Open(path, false, { MemoryMappedFileHint::SequentialAccess });
+    const unsigned char* ptr = static_cast<const unsigned char*>(mapping->GetPtr());
+    size_t size = mapping->GetSize();
+    size_t offset = sizeof(FONT_METRIC_CACHE_SIGNATURE) - 1;
+    if (size < offset || memcmp(ptr, FONT_METRIC_CACHE_SIGNATURE, offset) != 0)
+    {
+        trace_fontinfo->WriteLine("core", fmt::format(T_("font metric cache {0} is out of date"), Q_(path)));
+        mapping = nullptr;
+        return;
+    }
+    replace = size > MAX_CACHE_SIZE;
+    while (size - offset >= sizeof(RecordHeader))
+    {
+        RecordHeader header;
+        memcpy(&header, ptr + offset, sizeof(header));
+        if (header.magic != RECORD_MAGIC || static_cast<size_t>(header.pathLength) + header.size > size - offset - sizeof(header))
+        {
+            // partially written record
+            break;
+        }
+        Entry entry;
+        entry.offset = offset + sizeof(header) + header.pathLength;
+        entry.size = header.size;
+        entry.lastWriteTime = header.lastWriteTime;
+        entry.checksum = header.checksum;
+        entries[string(reinterpret_cast<const char*>(ptr) + offset + sizeof(header), header.pathLength)] = std::move(entry);
+        offset += sizeof(header) + header.pathLength + header.size;
+    }
+    trace_fontinfo->WriteLine("core", fmt::format(T_("loaded {0} font metric cache entries from {1}"), entries.size(), Q_(path)));
+}
+
+bool FontMetricCache::TryGet(const PathName& fontMetricFile, vector<unsigned char>& data)
+{
+    if (disabled)
+    {
+        return false;
+    }
+    try
+    {
+        if (!loaded)
+        {
+            Load();
+        }
+    }
+    catch (const exception& e)
+    {
+        trace_fontinfo->WriteLine("core", TraceLevel::Error, fmt::format(T_("font metric cache {0} cannot be read: {1}"), Q_(path), e.what()));
+        mapping = nullptr;
+        entries.clear();
+        disabled = true;
+        return false;
+    }
+    auto it = entries.find(fontMetricFile.ToString());
+    if (it == entries.end())
+    {
+        return false;
+    }
+    const Entry& entry = it->second;
+    if (File::GetSize(fontMetricFile) != entry.size || static_cast<int64_t>(File::GetLastWriteTime(fontMetricFile)) != entry.lastWriteTime)
+    {
+        return false;
+    }
+    const unsigned char* ptr = entry.data.empty() ? static_cast<const unsigned char*>(mapping->GetPtr()) + entry.offset : entry.data.data();
+    if (Checksum(ptr, entry.size) != entry.checksum)
+    {
+        trace_fontinfo->WriteLine("core", TraceLevel::Warning, fmt::format(T_("font metric cache entry {0} is corrupted"), Q_(fontMetricFile)));
+        return false;
+    }
+    data.assign(ptr, ptr + entry.size);
+    return true;
+}
+
+void FontMetricCache::Put(const PathName& fontMetricFile, const vector<unsigned char>& data)
+{
+    string key = fontMetricFile.ToString();
+    if (disabled || !loaded || data.empty() || data.size() > MAX_FONT_METRIC_FILE_SIZE || key.length() > 0xffff)
+    {
+        return;
+    }
+    try
+    {
+        Entry entry;
+        entry.size = data.size();
+        entry.lastWriteTime = File::GetLastWriteTime(fontMetricFile);
+        entry.checksum = Checksum(data.data(), data.size());
+        entry.data = data;
+        RecordHeader header;
+        header.magic = RECORD_MAGIC;
+        header.pathLength = static_cast<uint32_t>(key.length());
+        header.lastWriteTime = entry.lastWriteTime;
+        header.size = static_cast<uint32_t>(entry.size);
+        header.checksum = entry.checksum;
+        string record;
+        if (replace)
+        {
+            record = FONT_METRIC_CACHE_SIGNATURE;
+        }
+        record.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        record += key;
+        record.append(reinterpret_cast<const char*>(data.data()), data.size());
+        PathName directory = path.GetDirectoryName();
+        if (!Directory::Exists(directory))
+        {
+            Directory::Create(directory);
+        }
+        if (replace)
+        {
+            // other processes may have the old cache file mapped: write a
+            // new file and move it into place
+            PathName newPath = path;
+            newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+            FileStream writer(File::Open(newPath, FileMode::Create, FileAccess::Write, false));
+            writer.Write(record.c_str(), record.length());
+            writer.Close();
+            File::Move(newPath, path, { FileMoveOption::ReplaceExisting });
+            replace = false;
+        }
+        else
+        {
+            FileStream writer(File::Open(path, FileMode::Append, FileAccess::Write, false));
+            if (!File::TryLock(writer.GetFile(), File::LockType::Exclusive, 100ms))
+            {
+                writer.Close();
+                return;
+            }
+            writer.Write(record.c_str(), record.length());
+            fflush(writer.GetFile());
+            File::Unlock(writer.GetFile());
+            writer.Close();
+        }
+        entries[key] = std::move(entry);
+    }
+    catch (const exception& e)
+    {
+        trace_fontinfo->WriteLine("core", TraceLevel::Error, fmt::format(T_("font metric cache {0} cannot be written: {1}"), Q_(path), e.what()));
+        disabled = true;
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file Session/FontMetricCache.h
+ * @author Christian Schenk
+ * @brief Persistent font metric cache
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Trace/TraceStream>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Validated font metric files (TFM, OFM, VF) which survive the process.
+///
+/// All cached files live in one file, which is mapped into memory: a job
+/// which loads hundreds of fonts touches a single file instead of opening
+/// and reading each font metric file.  Entries are keyed by the file system
+/// path of the font metric file; an entry is used only if the size and the
+/// modification time of the original file still match and if the contents
+/// pass the checksum test.
+///
+/// Processes append entries.  A cache file which has outgrown its limit is
+/// replaced (not truncated) so that processes which have it mapped are not
+/// affected.
+class FontMetricCache
+{
+
+public:
+
+    FontMetricCache(const MiKTeX::Util::PathName& path);
+
+    bool TryGet(const MiKTeX::Util::PathName& fontMetricFile, std::vector<unsigned char>& data);
+
+    void Put(const MiKTeX::Util::PathName& fontMetricFile, const std::vector<unsigned char>& data);
+
+    /// Tests whether the data looks like a TFM, an OFM or a VF file.
+    static bool IsPlausible(const std::vector<unsigned char>& data);
+
+private:
+
+    struct Entry
+    {
+        // offset of the data in the mapped cache file
+        std::size_t offset = 0;
+        std::size_t size = 0;
+        std::int64_t lastWriteTime = 0;
+        std::uint32_t checksum = 0;
+        // the data of entries which have been added by this process
+        std::vector<unsigned char> data;
+    };
+
+    void Load();
+
+    static std::uint32_t Checksum(const unsigned char* data, std::size_t size);
+
+    bool disabled = false;
+
+    std::unordered_map<std::string, Entry> entries;
+
+    bool loaded = false;
+
+    std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mapping;
+
+    MiKTeX::Util::PathName path;
+
+    bool replace = true;
+
+    std::unique_ptr<MiKTeX::Trace::TraceStream> trace_fontinfo;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
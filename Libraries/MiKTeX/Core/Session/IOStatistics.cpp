@@ -0,0 +1,140 @@
+/**
+ * @file Session/IOStatistics.cpp
+ * @author Christian Schenk
+ * @brief File I/O statistics
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Process>
+
+#include "internal.h"
+
+#include "Session/IOStatistics.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+MIKTEXINTERNALFUNC(string) JsonString(const string& s)
+{
+    string result = "\"";
+    for (char ch : s)
+    {
+        switch (ch)
+        {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\r':
+            result += "\\r";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20)
+            {
+                result += fmt::format("\\u{0:04x}", static_cast<unsigned>(ch));
+            }
+            else
+            {
+                result += ch;
+            }
+            break;
+        }
+    }
+    result += "\"";
+    return result;
+}
+
+static long long Microseconds(IOStatistics::Clock::duration d)
+{
+    return chrono::duration_cast<chrono::microseconds>(d).count();
+}
+
+void IOStatistics::RecordOpen(const string& path, Clock::duration blocked)
+{
+    lock_guard<mutex> lockGuard(statisticsMutex);
+    FileStatistics& stat = files[path];
+    stat.opens++;
+    stat.blocked += blocked;
+}
+
+void IOStatistics::RecordClose(const string& path, FileAccess access, int64_t position, Clock::duration blocked)
+{
+    lock_guard<mutex> lockGuard(statisticsMutex);
+    FileStatistics& stat = files[path];
+    if (position > 0)
+    {
+        if (access == FileAccess::Write || access == FileAccess::ReadWrite)
+        {
+            stat.bytesWritten += position;
+        }
+        else
+        {
+            stat.bytesRead += position;
+        }
+    }
+    stat.blocked += blocked;
+}
+
+void IOStatistics::RecordFindFile(const string& fileName, bool found, Clock::duration latency)
+{
+    lock_guard<mutex> lockGuard(statisticsMutex);
+    FindFileStatistics& stat = findFileRequests[fileName];
+    stat.requests++;
+    if (found)
+    {
+        stat.found++;
+    }
+    stat.latency += latency;
+}
+
+void IOStatistics::WriteReport(const PathName& reportFile, const string& programName)
+{
+    lock_guard<mutex> lockGuard(statisticsMutex);
+    // most expensive first
+    vector<pair<string, FileStatistics>> sortedFiles(files.begin(), files.end());
+    sort(sortedFiles.begin(), sortedFiles.end(), [](const auto& a, const auto& b) { return a.second.blocked > b.second.blocked; });
+    vector<pair<string, FindFileStatistics>> sortedFindFileRequests(findFileRequests.begin(), findFileRequests.end());
+    sort(sortedFindFileRequests.begin(), sortedFindFileRequests.end(), [](const auto& a, const auto& b) { return a.second.latency > b.second.latency; });
+    string report = fmt::format("{{\"program\":{0},\"pid\":{1},\"files\":[", JsonString(programName), Process::GetCurrentProcess()->GetSystemId());
+    for (size_t idx = 0; idx < sortedFiles.size(); ++idx)
+    {
+        const FileStatistics& stat = sortedFiles[idx].second;
+        report += fmt::format("{0}{{\"path\":{1},\"opens\":{2},\"bytesRead\":{3},\"bytesWritten\":{4},\"blockedMicroseconds\":{5}}}",
+            idx > 0 ? "," : "", JsonString(sortedFiles[idx].first), stat.opens, stat.bytesRead, stat.bytesWritten, Microseconds(stat.blocked));
+    }
+    report += "],\"findFile\":[";
+    for (size_t idx = 0; idx < sortedFindFileRequests.size(); ++idx)
+    {
+        const FindFileStatistics& stat = sortedFindFileRequests[idx].second;
+        report += fmt::format("{0}{{\"fileName\":{1},\"requests\":{2},\"found\":{3},\"latencyMicroseconds\":{4}}}",
+            idx > 0 ? "," : "", JsonString(sortedFindFileRequests[idx].first), stat.requests, stat.found, Microseconds(stat.latency));
+    }
+    report += "]}\n";
+    ofstream stream = File::CreateOutputStream(reportFile, ios_base::app | ios_base::binary);
+    stream << report;
+    stream.close();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file Session/IOStatistics.h
+ * @author Christian Schenk
+ * @brief File I/O statistics
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <miktex/Core/File>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Collects statistics about the files opened by the session and about
+/// find-file requests.
+///
+/// The report is a single line of JSON; it is appended to the report file,
+/// so that the processes of a job (e.g., a TeX run and the programs it runs)
+/// can share one report file.
+class IOStatistics
+{
+
+public:
+
+    typedef std::chrono::steady_clock Clock;
+
+    /// Records that a file has been opened.
+    /// @param path The file.
+    /// @param blocked The time it took to open the file.
+    void RecordOpen(const std::string& path, Clock::duration blocked);
+
+    /// Records that a file has been closed.
+    /// @param path The file.
+    /// @param access How the file was accessed.
+    /// @param position The file position when the file was closed; this is
+    /// the number of bytes read or written, unless the file has been
+    /// repositioned.
+    /// @param blocked The time it took to close (and flush) the file.
+    void RecordClose(const std::string& path, MiKTeX::Core::FileAccess access, std::int64_t position, Clock::duration blocked);
+
+    /// Records a find-file request.
+    /// @param fileName The requested file name.
+    /// @param found Indicates whether the file has been found.
+    /// @param latency The time it took to look for the file.
+    void RecordFindFile(const std::string& fileName, bool found, Clock::duration latency);
+
+    /// Appends the report to a file.
+    /// @param reportFile The path to the report file.
+    /// @param programName The name of this program.
+    void WriteReport(const MiKTeX::Util::PathName& reportFile, const std::string& programName);
+
+private:
+
+    struct FileStatistics
+    {
+        std::uint64_t opens = 0;
+        std::uint64_t bytesRead = 0;
+        std::uint64_t bytesWritten = 0;
+        Clock::duration blocked = Clock::duration::zero();
+    };
+
+    struct FindFileStatistics
+    {
+        std::uint64_t requests = 0;
+        std::uint64_t found = 0;
+        Clock::duration latency = Clock::duration::zero();
+    };
+
+    std::unordered_map<std::string, FileStatistics> files;
+
+    std::unordered_map<std::string, FindFileStatistics> findFileRequests;
+
+    std::mutex statisticsMutex;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,115 @@
+/**
+ * @file Session/PdfBoxCache.cpp
+ * @author Christian Schenk
+ * @brief Cache of PDF page boxes
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <cstdint>
+
+#include <locale>
+#include <sstream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Process>
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "Session/PdfBoxCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+constexpr const char PDF_BOX_CACHE_SIGNATURE[] = "miktex-pdf-box-1";
+
+PdfBoxCache::PdfBoxCache(const PathName& directory) :
+    directory(directory),
+    trace_core(TraceStream::Open(MIKTEX_TRACE_CORE))
+{
+}
+
+PathName PdfBoxCache::GetEntryPath(const PathName& pdfFile, int page, const string& boxName) const
+{
+    PathName fqPath(pdfFile);
+    fqPath.MakeFullyQualified();
+    return directory / MD5::FromChars(fmt::format("{0}\n{1}\n{2}", fqPath.ToString(), page, boxName)).ToString();
+}
+
+bool PdfBoxCache::TryGet(const PathName& pdfFile, int page, const string& boxName, PdfBoxInfo& info)
+{
+    try
+    {
+        PathName entryPath = GetEntryPath(pdfFile, page, boxName);
+        if (!File::Exists(entryPath))
+        {
+            return false;
+        }
+        vector<unsigned char> bytes = File::ReadAllBytes(entryPath);
+        istringstream reader(string(bytes.begin(), bytes.end()));
+        reader.imbue(locale::classic());
+        string signature;
+        size_t size;
+        int64_t lastWriteTime;
+        int hasPageGroup;
+        reader >> signature >> size >> lastWriteTime >> info.llx >> info.lly >> info.urx >> info.ury >> info.rotate >> info.pageCount >> info.pdfVersion >> hasPageGroup;
+        if (!reader || signature != PDF_BOX_CACHE_SIGNATURE)
+        {
+            trace_core->WriteLine("core", TraceLevel::Warning, fmt::format(T_("PDF box cache entry {0} is corrupted"), Q_(entryPath)));
+            return false;
+        }
+        if (File::GetSize(pdfFile) != size || static_cast<int64_t>(File::GetLastWriteTime(pdfFile)) != lastWriteTime)
+        {
+            return false;
+        }
+        info.hasPageGroup = hasPageGroup != 0;
+        return true;
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+}
+
+void PdfBoxCache::Put(const PathName& pdfFile, int page, const string& boxName, const PdfBoxInfo& info)
+{
+    try
+    {
+        string line = fmt::format("{0} {1} {2} {3} {4} {5} {6} {7} {8} {9} {10}\n",
+            PDF_BOX_CACHE_SIGNATURE,
+            File::GetSize(pdfFile),
+            static_cast<int64_t>(File::GetLastWriteTime(pdfFile)),
+            info.llx, info.lly, info.urx, info.ury,
+            info.rotate,
+            info.pageCount,
+            info.pdfVersion,
+            info.hasPageGroup ? 1 : 0);
+        PathName entryPath = GetEntryPath(pdfFile, page, boxName);
+        Directory::Create(directory);
+        PathName newPath = entryPath;
+        newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        File::WriteBytes(newPath, vector<unsigned char>(line.begin(), line.end()));
+        File::Move(newPath, entryPath, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const exception& e)
+    {
+        // the cache is an optimization: the box has been computed
+        trace_core->WriteLine("core", TraceLevel::Warning, fmt::format(T_("PDF box of {0} cannot be cached: {1}"), Q_(pdfFile), e.what()));
+    }
+}
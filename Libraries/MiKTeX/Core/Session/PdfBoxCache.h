@@ -0,0 +1,52 @@
+/**
+ * @file Session/PdfBoxCache.h
+ * @author Christian Schenk
+ * @brief Cache of PDF page boxes
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <miktex/Core/Session>
+#include <miktex/Trace/TraceStream>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Page boxes of included PDF files which survive the process.
+///
+/// Each entry is a small file in the cache directory, named after the
+/// digest of the PDF file path, the page number and the box name.  An entry
+/// is used only if the size and the modification time of the PDF file still
+/// match.  Entries are written to a temporary file and renamed into place,
+/// i.e., several processes can use the cache at the same time.
+class PdfBoxCache
+{
+
+public:
+
+    PdfBoxCache(const MiKTeX::Util::PathName& directory);
+
+    bool TryGet(const MiKTeX::Util::PathName& pdfFile, int page, const std::string& boxName, MiKTeX::Core::PdfBoxInfo& info);
+
+    void Put(const MiKTeX::Util::PathName& pdfFile, int page, const std::string& boxName, const MiKTeX::Core::PdfBoxInfo& info);
+
+private:
+
+    MiKTeX::Util::PathName GetEntryPath(const MiKTeX::Util::PathName& pdfFile, int page, const std::string& boxName) const;
+
+    MiKTeX::Util::PathName directory;
+
+    std::unique_ptr<MiKTeX::Trace::TraceStream> trace_core;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
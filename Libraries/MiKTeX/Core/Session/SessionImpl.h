@@ -24,10 +24,14 @@
 #if !defined(INTERNAL_CORE_SESSION_SESSIONIMPL_H)
 #define INTERNAL_CORE_SESSION_SESSIONIMPL_H
 
+#include <atomic>
 #include <deque>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 #if defined(HAVE_ATLBASE_H)
 #  define _ATL_FREE_THREADED
@@ -53,6 +57,17 @@
 #endif
 
 #include "Fndb/FileNameDatabase.h"
+#include "Session/BuildTrace.h"
+#include "Session/CompiledSearchPath.h"
+#include "Session/FindFileCache.h"
+#include "Session/IOStatistics.h"
+#include "Session/ConfigValueCache.h"
+#include "Session/DirectoryIndex.h"
+#include "Session/ExpansionCache.h"
+#include "Session/FindFileMissCache.h"
+#include "Session/FontMetricCache.h"
+#include "Session/PdfBoxCache.h"
+#include "SessionService/SessionServiceClient.h"
 #include "RootDirectoryInternals.h"
 
 #if defined(MIKTEX_WINDOWS) && USE_LOCAL_SERVER
@@ -111,7 +126,14 @@ inline bool operator<(const LanguageInfo_& lhs, const LanguageInfo_& rhs)
 struct InternalFileTypeInfo :
   public MiKTeX::Core::FileTypeInfo
 {
-  std::vector<MiKTeX::Util::PathName> pathPatterns;
+  /// The expanded search path; shared with running searches.
+  std::shared_ptr<const CompiledSearchPath> compiledSearchPath;
+  /// Prefix of find-file cache keys; derived from `compiledSearchPath`.
+  std::string findFileCacheKey;
+  /// Directory patterns not covered by a file name database.
+  std::vector<MiKTeX::Util::PathName> volatilePathPatterns;
+  /// Indicates whether find-file results can be cached.
+  MiKTeX::Configuration::TriState findFileCacheable = MiKTeX::Configuration::TriState::Undetermined;
 };
 
 struct DvipsPaperSizeInfo :
@@ -137,8 +159,24 @@ struct InternalStartupConfig :
 
   /// MiKTeX setup version.
   MiKTeX::Core::VersionNumber setupVersion;
+
+  /// Version of the read-only installation snapshot; empty, if the
+  /// installation is not a snapshot.
+  std::string snapshotVersion;
+};
+
+/// How a file is read during startup.
+enum class StartupConfigFileRole
+{
+  CommonStartupConfigFile,
+  CommonStartupConfigFileUserScope,
+  UserStartupConfigFile,
+  UserMiKTeXConfig,
+  BinRelativeMiKTeXConfig
 };
 
+class StartupConfigSnapshot;
+
 class SessionImpl :
   public MiKTeX::Core::Session
 {
@@ -296,6 +334,27 @@ public:
 public:
   bool IsOutputFile(const FILE* file) override;
 
+public:
+  std::vector<unsigned char> ReadFontMetricFile(const MiKTeX::Util::PathName& path) override;
+
+public:
+  bool IsFontMetricCacheEnabled() override;
+
+public:
+  bool TryGetPdfBoxInfo(const MiKTeX::Util::PathName& path, int page, const std::string& boxName, MiKTeX::Core::PdfBoxInfo& info) override;
+
+public:
+  void SetPdfBoxInfo(const MiKTeX::Util::PathName& path, int page, const std::string& boxName, const MiKTeX::Core::PdfBoxInfo& info) override;
+
+public:
+  void AddBuildTraceSpan(const std::string& category, const std::string& name, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end) override;
+
+public:
+  void BeforeFork() override;
+
+public:
+  void AfterFork(bool child) override;
+
 #if defined(MIKTEX_WINDOWS)
 public:
   bool IsFileAlreadyOpen(const MiKTeX::Util::PathName& fileName) override;
@@ -321,6 +380,9 @@ public:
 public:
   void RecordFileInfo(const MiKTeX::Util::PathName& path, MiKTeX::Core::FileAccess access) override;
 
+public:
+  void FlushFileInfoRecorder() override;
+
 public:
   std::vector<MiKTeX::Core::FileInfoRecord> GetFileInfoRecords() override;
 
@@ -330,6 +392,9 @@ public:
 public:
   MiKTeX::Core::LocateResult MIKTEXTHISCALL Locate(const std::string& fileName, const MiKTeX::Core::LocateOptions& options) override;
 
+private:
+  MiKTeX::Core::LocateResult LocateInternal(const std::string& fileName, const MiKTeX::Core::LocateOptions& options);
+
 public:
   bool FindFile(const std::string& fileName, const std::string& searchPath, FindFileOptionSet options, std::vector<MiKTeX::Util::PathName>& result) override;
 
@@ -408,6 +473,12 @@ public:
 public:
   void SetFindFileCallback(MiKTeX::Core::IFindFileCallback* callback) override;
 
+public:
+  std::size_t GetFindFileGeneration() override
+  {
+    return findFileGeneration + (findFileMissCache != nullptr ? findFileMissCache->GetGeneration() : 0);
+  }
+
 public:
   void SplitFontPath(const MiKTeX::Util::PathName& fontPath, std::string* fontType, std::string* supplier, std::string* typeface, std::string* fontName, std::string* pointSize) override;
 
@@ -607,6 +678,10 @@ public:
 public:
   std::shared_ptr<FileNameDatabase> GetFileNameDatabase(const char* path);
 
+  // checks whether this process is supposed to update the FNDB of a root
+private:
+  bool IsFndbWritable(unsigned r);
+
 public:
   MiKTeX::Util::PathName GetTempDirectory();
 
@@ -746,6 +821,17 @@ private:
 private:
   std::vector<std::string> systemFontDirs;
 
+private:
+  struct FontNameMap
+  {
+    time_t lastWriteTime = 0;
+    // the tokens of each line, in file order
+    std::vector<std::vector<std::string>> lines;
+  };
+
+private:
+  std::map<std::string, FontNameMap> fontNameMaps;
+
 private:
   std::string psFontDirs;
 
@@ -769,7 +855,16 @@ public:
   bool GetWorkingDirectory(unsigned n, MiKTeX::Util::PathName& path);
 
 private:
-  std::vector<MiKTeX::Util::PathName> GetDirectoryPatterns(MiKTeX::Core::FileType fileType);
+  std::shared_ptr<const CompiledSearchPath> GetDirectoryPatterns(MiKTeX::Core::FileType fileType);
+
+private:
+  std::shared_ptr<const CompiledSearchPath> GetCompiledSearchPath(const std::string& searchPath);
+
+private:
+  std::shared_ptr<const CompiledSearchPath> CompileSearchPath(const std::vector<MiKTeX::Util::PathName>& pathNames);
+
+private:
+  void ClearCompiledSearchPaths();
 
 private:
   void TraceDirectoryPatterns(const std::string& fileType, const std::vector<MiKTeX::Util::PathName>& pathPatterns);
@@ -780,6 +875,9 @@ private:
 private:
   void UnregisterLibraryTraceStreams();
 
+private:
+  const FontNameMap& GetFontNameMap(const std::string& mapName);
+
 private:
   bool FindInTypefaceMap(const std::string& fontName, std::string& typeface);
 
@@ -796,7 +894,7 @@ private:
   bool MakePkFileName(MiKTeX::Util::PathName& pkFileName, const std::string& fontName, int dpi);
 
 private:
-  bool FindFileInDirectories(const std::string& fileName, const std::vector<MiKTeX::Util::PathName>& pathPatterns, bool all, bool useFndb, bool searchFileSystem, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
+  bool FindFileInDirectories(const std::string& fileName, const CompiledSearchPath& searchPath, bool all, bool useFndb, bool searchFileSystem, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
 
 private:
   bool FindFileByType(const std::string& fileName, MiKTeX::Core::FileType fileType, bool all, bool tryHard, bool create, bool renew, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
@@ -807,6 +905,21 @@ private:
 private:
   bool CheckCandidate(MiKTeX::Util::PathName& path, const char* fileInfo, MiKTeX::Core::IFindFileCallback* callback);
 
+private:
+  std::vector<char> CheckCandidates(std::vector<MiKTeX::Core::Fndb::Record>& records, bool trusted, MiKTeX::Core::IFindFileCallback* callback);
+
+private:
+  bool IsFndbTrusted(unsigned r);
+
+private:
+  MiKTeX::Configuration::TriState trustFndb = MiKTeX::Configuration::TriState::Undetermined;
+
+private:
+  bool IsFndbServed();
+
+private:
+  MiKTeX::Configuration::TriState fndbServed = MiKTeX::Configuration::TriState::Undetermined;
+
 private:
   bool GetSessionValue(const std::string& sectionName, const std::string& valueName, std::string& value, MiKTeX::Configuration::HasNamedValues* callback);
 
@@ -885,6 +998,9 @@ private:
 private:
   InternalStartupConfig ReadMiKTeXConfig(const MiKTeX::Util::PathName& path);
 
+private:
+  InternalStartupConfig ReadStartupConfigFiles(StartupConfigSnapshot& snapshot, const std::vector<std::pair<StartupConfigFileRole, MiKTeX::Util::PathName>>& files);
+
 private:
   MiKTeX::Util::PathName GetStartupConfigFile(MiKTeX::Core::ConfigurationScope scope, MiKTeX::Core::MiKTeXConfiguration config, MiKTeX::Core::VersionNumber version);
 
@@ -928,6 +1044,9 @@ private:
 private:
   bool IsTeXMFReadOnly(unsigned r);
 
+public:
+  bool IsSnapshotRoot(unsigned r);
+
 private:
   std::pair<bool, MiKTeX::Util::PathName> TryGetBinDirectory(bool canonicalized);
 
@@ -979,9 +1098,29 @@ private:
 private:
   void WritePackageHistory();
 
+private:
+  void WriteIOReport();
+
+private:
+  void WriteBuildTrace();
+
 private:
   std::string ExpandValues(const std::string& toBeExpanded, MiKTeX::Configuration::HasNamedValues* callback);
 
+private:
+  std::string ExpandValues(const std::string& toBeExpanded, MiKTeX::Configuration::HasNamedValues* callback, std::vector<ExpansionCache::Dependency>* dependencies);
+
+private:
+  bool IsExpansionUpToDate(const std::vector<ExpansionCache::Dependency>& dependencies);
+
+private:
+  std::unique_ptr<ExpansionCache> expansionCache;
+
+private:
+  // counts the lookups of values which do not come from the configuration:
+  // expansions which depend on such values are not memoized
+  unsigned untrackedValueLookups = 0;
+
 private:
   void DirectoryWalk(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths);
 
@@ -1024,6 +1163,119 @@ private:
 private:
   MiKTeX::Core::IFindFileCallback* findFileCallback = nullptr;
 
+private:
+  FindFileCache* GetFindFileCache();
+
+private:
+  std::string GetFindFileCacheGeneration();
+
+private:
+  bool PrepareFindFileCache(InternalFileTypeInfo& fti, const std::vector<MiKTeX::Util::PathName>& pathPatterns);
+
+private:
+  bool IsShadowedByVolatileFile(const InternalFileTypeInfo& fti, const std::vector<MiKTeX::Util::PathName>& fileNames);
+
+private:
+  bool IsKnownToPackageManager(const std::vector<MiKTeX::Util::PathName>& pathPatterns, const std::vector<MiKTeX::Util::PathName>& fileNames);
+
+private:
+  std::vector<MiKTeX::Util::PathName> GetFileNamesToTry(const std::string& fileName, const InternalFileTypeInfo& fti);
+
+private:
+  FindFileMissCache* GetFindFileMissCache();
+
+public:
+  void InvalidateFindFileMissCache()
+  {
+    ++findFileGeneration;
+    if (findFileMissCache != nullptr)
+    {
+      findFileMissCache->Invalidate();
+    }
+  }
+
+private:
+  std::unique_ptr<FindFileCache> findFileCache;
+
+private:
+  bool findFileCacheInitialized = false;
+
+private:
+  std::unique_ptr<FindFileMissCache> findFileMissCache;
+
+private:
+  DirectoryIndex* GetDirectoryIndex();
+
+private:
+  std::unique_ptr<DirectoryIndex> directoryIndex;
+
+private:
+  std::atomic<std::size_t> findFileGeneration{ 0 };
+
+private:
+  FontMetricCache* GetFontMetricCache();
+
+private:
+  std::unique_ptr<FontMetricCache> fontMetricCache;
+
+private:
+  bool fontMetricCacheInitialized = false;
+
+private:
+  PdfBoxCache* GetPdfBoxCache();
+
+private:
+  std::unique_ptr<PdfBoxCache> pdfBoxCache;
+
+private:
+  bool pdfBoxCacheInitialized = false;
+
+private:
+  std::map<int, MiKTeX::Util::PathName> GetPkResolutions(const MiKTeX::Util::PathName& pkFileName, const std::string& mfMode);
+
+private:
+  void CollectPkResolutions(const MiKTeX::Util::PathName& pkFileName, const std::string& mfMode, std::map<int, MiKTeX::Util::PathName>& resolutions);
+
+  // the installed PK files, by file name and METAFONT mode
+private:
+  std::unordered_map<std::string, std::map<int, MiKTeX::Util::PathName>> pkResolutions;
+
+  // the session service looks up PK files on concurrent connections
+private:
+  std::mutex pkResolutionsMutex;
+
+public:
+  void BeginServingSessionRequests();
+
+public:
+  std::string ServeSessionRequest(const std::string& request);
+
+private:
+  SessionServiceClient* GetSessionServiceClient();
+
+private:
+  void ResetSessionServiceClient();
+
+private:
+  std::string GetSessionServiceEnvironment();
+
+private:
+  std::unique_ptr<SessionServiceClient> sessionServiceClient;
+
+private:
+  bool sessionServiceInitialized = false;
+
+  // set when the session is fully initialized
+private:
+  bool sessionServiceAllowed = false;
+
+private:
+  bool servingSessionRequests = false;
+
+  // the FNDB generation the session service is answering for
+private:
+  std::string servedGeneration;
+
 private:
   std::vector<InternalFileTypeInfo> fileTypes;
 
@@ -1048,6 +1300,10 @@ private:
 private:
   SearchPathDictionary expandedPathPatterns;
 
+private:
+  // compiled search paths which are not bound to a file type
+  std::unordered_map<std::string, std::shared_ptr<const CompiledSearchPath>> compiledSearchPaths;
+
 private:
   // file access history
   std::vector<MiKTeX::Core::FileInfoRecord> fileInfoRecords;
@@ -1063,10 +1319,37 @@ private:
 private:
   std::ofstream fileNameRecorderStream;
 
+private:
+  // lines which have been written to the file name recorder log file
+  std::unordered_set<std::string> recordedFileNames;
+
+private:
+  // package names of recorded files
+  std::unordered_map<std::string, std::string> recordedPackageNames;
+
+private:
+  void WriteFileInfoRecord(const MiKTeX::Core::FileInfoRecord& fir);
+
 private:
   // package history file
   std::string packageHistoryFile;
 
+private:
+  // I/O report file
+  std::string ioReportFile;
+
+private:
+  // file I/O statistics, if a report has been requested
+  std::unique_ptr<IOStatistics> ioStatistics;
+
+private:
+  // build trace file
+  std::string buildTraceFile;
+
+private:
+  // build timeline, if a trace has been requested
+  std::unique_ptr<BuildTrace> buildTrace;
+
 private:
   bool makeFonts = true;
 
@@ -1076,6 +1359,29 @@ private:
 private:
   ConfigurationSettings configurationSettings;
 
+private:
+  bool GetResolvedConfigValue(const std::string& sectionName, const std::string& valueName, std::string& value);
+
+private:
+  bool ResolveConfigValue(const std::string& sectionName, const std::string& valueName, std::string& value);
+
+private:
+  void InvalidateConfigValueCache()
+  {
+    if (configValueCache != nullptr)
+    {
+      configValueCache->Invalidate();
+    }
+    // expansions are derived from the values
+    if (expansionCache != nullptr)
+    {
+      expansionCache->Invalidate();
+    }
+  }
+
+private:
+  std::unique_ptr<ConfigValueCache> configValueCache;
+
 private:
   std::vector<FormatInfo_> formats;
 
@@ -1208,6 +1514,10 @@ private:
 private:
   std::vector<std::string> onFinishScript;
 
+private:
+  // files are scheduled for removal by concurrent deletions
+  std::mutex onFinishScriptMutex;
+
 private:
   void StartFinishScript(int delay);
 
@@ -31,6 +31,7 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "Session/StartupConfigSnapshot.h"
 
 #if defined(MIKTEX_WINDOWS)
 #  include "win/winRegistry.h"
@@ -140,31 +141,52 @@ void SessionImpl::InitializeStartupConfig()
       Utils::GetPathNamePrefix(dir, PathName(MIKTEX_PATH_MIKTEX_CONFIG_DIR), userPrefix);
     }
 
+    // what has been read from the files the last time
+    StartupConfigSnapshot snapshot;
+    snapshot.Load(DefaultConfig().userConfigRoot / MIKTEX_PATH_STARTUP_CONFIG_SNAPSHOT);
+
     // read common startup config file
+    vector<pair<StartupConfigFileRole, PathName>> startupConfigFiles;
     if (haveCommonStartupConfigFile)
     {
-      MergeStartupConfig(initStartupConfig, ReadStartupConfigFile(ConfigurationScope::Common, commonStartupConfigFile));
+      startupConfigFiles.push_back(make_pair(StartupConfigFileRole::CommonStartupConfigFile, commonStartupConfigFile));
       if (!IsAdminMode())
       {
-        MergeStartupConfig(initStartupConfig, ReadStartupConfigFile(ConfigurationScope::User, commonStartupConfigFile));
+        startupConfigFiles.push_back(make_pair(StartupConfigFileRole::CommonStartupConfigFileUserScope, commonStartupConfigFile));
       }
     }
 
     // read user startup config file
     if (haveUserStartupConfigFile)
     {
-      MergeStartupConfig(initStartupConfig, ReadStartupConfigFile(ConfigurationScope::User, userStartupConfigFile));
+      startupConfigFiles.push_back(make_pair(StartupConfigFileRole::UserStartupConfigFile, userStartupConfigFile));
     }
 
+    MergeStartupConfig(initStartupConfig, ReadStartupConfigFiles(snapshot, startupConfigFiles));
+
+    // the location of the user's miktex.ini depends on the startup
+    // configuration read so far
+    vector<pair<StartupConfigFileRole, PathName>> miKTeXConfigFiles;
     PathName miKTeXConfig;
     miKTeXConfig = DefaultConfig().userConfigRoot / MIKTEX_PATH_MIKTEX_INI;
     if (File::Exists(miKTeXConfig))
     {
-      MergeStartupConfig(initStartupConfig, ReadMiKTeXConfig(miKTeXConfig));
+      miKTeXConfigFiles.push_back(make_pair(StartupConfigFileRole::UserMiKTeXConfig, miKTeXConfig));
     }
     if (FindBinRelative(PathName(MIKTEX_PATH_MIKTEX_INI), miKTeXConfig))
     {
-      MergeStartupConfig(initStartupConfig, ReadMiKTeXConfig(miKTeXConfig));
+      miKTeXConfigFiles.push_back(make_pair(StartupConfigFileRole::BinRelativeMiKTeXConfig, miKTeXConfig));
+    }
+
+    MergeStartupConfig(initStartupConfig, ReadStartupConfigFiles(snapshot, miKTeXConfigFiles));
+
+    try
+    {
+      snapshot.Save();
+    }
+    catch (const exception& e)
+    {
+      trace_config->WriteLine("core", TraceLevel::Warning, fmt::format(T_("startup configuration snapshot cannot be written: {0}"), e.what()));
     }
 
   #if USE_WINDOWS_REGISTRY
@@ -185,6 +207,54 @@ void SessionImpl::InitializeStartupConfig()
 
   // merge in the default startup config
   MergeStartupConfig(initStartupConfig, DefaultConfig(initStartupConfig.config, initStartupConfig.setupVersion, commonPrefix, userPrefix));
+
+  // a snapshot is published by an administrator: it is a shared setup
+  if (!initStartupConfig.snapshotVersion.empty())
+  {
+    initStartupConfig.isSharedSetup = TriState::True;
+  }
+}
+
+InternalStartupConfig SessionImpl::ReadStartupConfigFiles(StartupConfigSnapshot& snapshot, const vector<pair<StartupConfigFileRole, PathName>>& files)
+{
+  InternalStartupConfig ret;
+  vector<StartupConfigSnapshot::Input> inputs;
+  for (const auto& file : files)
+  {
+    if (!File::Exists(file.second))
+    {
+      // a fatal error (detected below)
+      inputs.clear();
+      break;
+    }
+    inputs.push_back(StartupConfigSnapshot::MakeInput(static_cast<uint32_t>(file.first), file.second));
+  }
+  if (!inputs.empty() && snapshot.TryGet(inputs, ret))
+  {
+    trace_config->WriteLine("core", T_("using compiled startup configuration"));
+    return ret;
+  }
+  for (const auto& file : files)
+  {
+    switch (file.first)
+    {
+    case StartupConfigFileRole::CommonStartupConfigFile:
+      MergeStartupConfig(ret, ReadStartupConfigFile(ConfigurationScope::Common, file.second));
+      break;
+    case StartupConfigFileRole::CommonStartupConfigFileUserScope:
+    case StartupConfigFileRole::UserStartupConfigFile:
+      MergeStartupConfig(ret, ReadStartupConfigFile(ConfigurationScope::User, file.second));
+      break;
+    default:
+      MergeStartupConfig(ret, ReadMiKTeXConfig(file.second));
+      break;
+    }
+  }
+  if (!inputs.empty())
+  {
+    snapshot.Put(inputs, ret);
+  }
+  return ret;
 }
 
 bool SessionImpl::FindBinRelative(const PathName& relPath, PathName& path)
@@ -375,6 +445,10 @@ InternalStartupConfig SessionImpl::ReadStartupConfigFile(ConfigurationScope scop
 
   if (scope == ConfigurationScope::Common)
   {
+    if (cfg->TryGetValueAsString(MIKTEX_CONFIG_SECTION_SETUP, MIKTEX_CONFIG_VALUE_SNAPSHOT_VERSION, str))
+    {
+      ret.snapshotVersion = str;
+    }
     if (cfg->TryGetValueAsString("Paths", MIKTEX_CONFIG_VALUE_COMMON_ROOTS, str))
     {
       Absolutize(str, relativeFrom);
@@ -653,6 +727,10 @@ void SessionImpl::MergeStartupConfig(InternalStartupConfig& startupConfig, const
   {
     startupConfig.setupVersion = defaults.setupVersion;
   }
+  if (startupConfig.snapshotVersion.empty())
+  {
+    startupConfig.snapshotVersion = defaults.snapshotVersion;
+  }
   if (startupConfig.config == MiKTeXConfiguration::None)
   {
     startupConfig.config = defaults.config;
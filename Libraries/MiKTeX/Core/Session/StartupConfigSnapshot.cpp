@@ -0,0 +1,310 @@
+/**
+ * @file Session/StartupConfigSnapshot.cpp
+ * @author Christian Schenk
+ * @brief Compiled startup configuration
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <cstring>
+#include <ctime>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/Process>
+
+#include "internal.h"
+
+#include "Session/StartupConfigSnapshot.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+constexpr const char STARTUP_CONFIG_SNAPSHOT_SIGNATURE[] = "miktex-startup-config-snapshot-2\n";
+
+// entries are written by programs with different startup files (e.g., admin
+// mode, other installations); keep the most recent ones
+constexpr size_t MAX_ENTRIES = 8;
+
+class SnapshotWriter
+{
+
+public:
+
+    void Write(const void* data, size_t n)
+    {
+        buffer.append(static_cast<const char*>(data), n);
+    }
+
+    void Write(uint32_t value)
+    {
+        Write(&value, sizeof(value));
+    }
+
+    void Write(uint64_t value)
+    {
+        Write(&value, sizeof(value));
+    }
+
+    void Write(int64_t value)
+    {
+        Write(&value, sizeof(value));
+    }
+
+    void Write(const string& s)
+    {
+        Write(static_cast<uint32_t>(s.length()));
+        Write(s.c_str(), s.length());
+    }
+
+    const string& GetBuffer() const
+    {
+        return buffer;
+    }
+
+private:
+
+    string buffer;
+};
+
+class SnapshotReader
+{
+
+public:
+
+    SnapshotReader(const unsigned char* ptr, size_t size) :
+        ptr(ptr),
+        size(size)
+    {
+    }
+
+    void Read(void* data, size_t n)
+    {
+        if (n > size - offset)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        memcpy(data, ptr + offset, n);
+        offset += n;
+    }
+
+    template<typename T> T Read()
+    {
+        T value;
+        Read(&value, sizeof(value));
+        return value;
+    }
+
+    string ReadString()
+    {
+        uint32_t length = Read<uint32_t>();
+        if (length > size - offset)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        string s(reinterpret_cast<const char*>(ptr) + offset, length);
+        offset += length;
+        return s;
+    }
+
+private:
+
+    size_t offset = 0;
+    const unsigned char* ptr;
+    size_t size;
+};
+
+inline bool IsSameInput(const StartupConfigSnapshot::Input& lhs, const StartupConfigSnapshot::Input& rhs, bool compareFileTimes)
+{
+    return lhs.role == rhs.role && lhs.path == rhs.path && (!compareFileTimes || (lhs.size == rhs.size && lhs.lastWriteTime == rhs.lastWriteTime));
+}
+
+inline bool IsSameInputs(const vector<StartupConfigSnapshot::Input>& lhs, const vector<StartupConfigSnapshot::Input>& rhs, bool compareFileTimes)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    for (size_t idx = 0; idx < lhs.size(); ++idx)
+    {
+        if (!IsSameInput(lhs[idx], rhs[idx], compareFileTimes))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+StartupConfigSnapshot::Input StartupConfigSnapshot::MakeInput(uint32_t role, const PathName& path)
+{
+    return Input{ role, path, File::GetSize(path), static_cast<int64_t>(File::GetLastWriteTime(path)) };
+}
+
+void StartupConfigSnapshot::Load(const PathName& snapshotFile)
+{
+    this->snapshotFile = snapshotFile;
+    entries.clear();
+    modified = false;
+    if (!File::Exists(snapshotFile))
+    {
+        return;
+    }
+    try
+    {
+        unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+        mapping->Open(snapshotFile, false);
+        SnapshotReader reader(static_cast<const unsigned char*>(mapping->GetPtr()), mapping->GetSize());
+        char signature[sizeof(STARTUP_CONFIG_SNAPSHOT_SIGNATURE) - 1];
+        reader.Read(signature, sizeof(signature));
+        if (memcmp(signature, STARTUP_CONFIG_SNAPSHOT_SIGNATURE, sizeof(signature)) != 0)
+        {
+            return;
+        }
+        uint32_t entryCount = reader.Read<uint32_t>();
+        for (uint32_t idx = 0; idx < entryCount && idx < MAX_ENTRIES; ++idx)
+        {
+            Entry entry;
+            uint32_t inputCount = reader.Read<uint32_t>();
+            if (inputCount > mapping->GetSize())
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            for (uint32_t n = 0; n < inputCount; ++n)
+            {
+                Input input;
+                input.role = reader.Read<uint32_t>();
+                input.path = reader.ReadString();
+                input.size = reader.Read<uint64_t>();
+                input.lastWriteTime = reader.Read<int64_t>();
+                entry.inputs.push_back(input);
+            }
+            InternalStartupConfig& startupConfig = entry.startupConfig;
+            startupConfig.isSharedSetup = static_cast<TriState>(reader.Read<uint32_t>());
+            startupConfig.setupVersion.n1 = reader.Read<uint32_t>();
+            startupConfig.setupVersion.n2 = reader.Read<uint32_t>();
+            startupConfig.setupVersion.n3 = reader.Read<uint32_t>();
+            startupConfig.setupVersion.n4 = reader.Read<uint32_t>();
+            startupConfig.config = static_cast<MiKTeXConfiguration>(reader.Read<uint32_t>());
+            startupConfig.userConfigRoot = reader.ReadString();
+            startupConfig.userDataRoot = reader.ReadString();
+            startupConfig.userInstallRoot = reader.ReadString();
+            startupConfig.userRoots = reader.ReadString();
+            startupConfig.otherUserRoots = reader.ReadString();
+            startupConfig.commonConfigRoot = reader.ReadString();
+            startupConfig.commonDataRoot = reader.ReadString();
+            startupConfig.commonInstallRoot = reader.ReadString();
+            startupConfig.commonRoots = reader.ReadString();
+            startupConfig.otherCommonRoots = reader.ReadString();
+            startupConfig.snapshotVersion = reader.ReadString();
+            entries.push_back(std::move(entry));
+        }
+        mapping->Close();
+    }
+    catch (const exception&)
+    {
+        entries.clear();
+    }
+}
+
+bool StartupConfigSnapshot::TryGet(const vector<Input>& inputs, InternalStartupConfig& startupConfig) const
+{
+    for (const Entry& entry : entries)
+    {
+        if (IsSameInputs(entry.inputs, inputs, true))
+        {
+            startupConfig = entry.startupConfig;
+            return true;
+        }
+    }
+    return false;
+}
+
+void StartupConfigSnapshot::Put(const vector<Input>& inputs, const InternalStartupConfig& startupConfig)
+{
+    // file times have a resolution of one second: a file which has just been
+    // modified could be modified again without being noticed
+    time_t now = time(nullptr);
+    for (const Input& input : inputs)
+    {
+        if (input.lastWriteTime + 1 >= now)
+        {
+            return;
+        }
+    }
+    // replace the entry for the same files
+    for (auto it = entries.begin(); it != entries.end(); )
+    {
+        it = IsSameInputs(it->inputs, inputs, false) ? entries.erase(it) : it + 1;
+    }
+    entries.insert(entries.begin(), Entry{ inputs, startupConfig });
+    if (entries.size() > MAX_ENTRIES)
+    {
+        entries.resize(MAX_ENTRIES);
+    }
+    modified = true;
+}
+
+void StartupConfigSnapshot::Save()
+{
+    PathName snapshotDir = snapshotFile;
+    snapshotDir.RemoveFileSpec();
+    if (!modified || !Directory::Exists(snapshotDir))
+    {
+        return;
+    }
+    SnapshotWriter writer;
+    writer.Write(STARTUP_CONFIG_SNAPSHOT_SIGNATURE, sizeof(STARTUP_CONFIG_SNAPSHOT_SIGNATURE) - 1);
+    writer.Write(static_cast<uint32_t>(entries.size()));
+    for (const Entry& entry : entries)
+    {
+        writer.Write(static_cast<uint32_t>(entry.inputs.size()));
+        for (const Input& input : entry.inputs)
+        {
+            writer.Write(input.role);
+            writer.Write(input.path.ToString());
+            writer.Write(input.size);
+            writer.Write(input.lastWriteTime);
+        }
+        const InternalStartupConfig& startupConfig = entry.startupConfig;
+        writer.Write(static_cast<uint32_t>(startupConfig.isSharedSetup));
+        writer.Write(static_cast<uint32_t>(startupConfig.setupVersion.n1));
+        writer.Write(static_cast<uint32_t>(startupConfig.setupVersion.n2));
+        writer.Write(static_cast<uint32_t>(startupConfig.setupVersion.n3));
+        writer.Write(static_cast<uint32_t>(startupConfig.setupVersion.n4));
+        writer.Write(static_cast<uint32_t>(startupConfig.config));
+        writer.Write(startupConfig.userConfigRoot.ToString());
+        writer.Write(startupConfig.userDataRoot.ToString());
+        writer.Write(startupConfig.userInstallRoot.ToString());
+        writer.Write(startupConfig.userRoots);
+        writer.Write(startupConfig.otherUserRoots);
+        writer.Write(startupConfig.commonConfigRoot.ToString());
+        writer.Write(startupConfig.commonDataRoot.ToString());
+        writer.Write(startupConfig.commonInstallRoot.ToString());
+        writer.Write(startupConfig.commonRoots);
+        writer.Write(startupConfig.otherCommonRoots);
+        writer.Write(startupConfig.snapshotVersion);
+    }
+    // other processes may have the old snapshot file mapped: write a new file
+    // and move it into place
+    PathName newPath = snapshotFile;
+    newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+    FileStream stream(File::Open(newPath, FileMode::Create, FileAccess::Write, false));
+    stream.Write(writer.GetBuffer().c_str(), writer.GetBuffer().length());
+    stream.Close();
+    File::Move(newPath, snapshotFile, { FileMoveOption::ReplaceExisting });
+    modified = false;
+}
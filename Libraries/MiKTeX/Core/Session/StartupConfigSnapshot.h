@@ -0,0 +1,84 @@
+/**
+ * @file Session/StartupConfigSnapshot.h
+ * @author Christian Schenk
+ * @brief Compiled startup configuration
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+#include "Session/SessionImpl.h"
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// What has been read from the startup configuration files
+/// (`miktexstartup.ini`) and from the `miktex.ini` files, compiled into a
+/// binary file which can be loaded without parsing.
+///
+/// An entry records the files it was compiled from.  An entry is stale if
+/// the session reads other files, or if one of the files has been modified.
+class StartupConfigSnapshot
+{
+
+public:
+
+    /// A file which is read during startup.
+    struct Input
+    {
+        /// Identifies the role of the file, i.e., how the file is read.
+        std::uint32_t role;
+        MiKTeX::Util::PathName path;
+        std::uint64_t size;
+        std::int64_t lastWriteTime;
+    };
+
+    /// Creates an input record for an existing file.
+    static Input MakeInput(std::uint32_t role, const MiKTeX::Util::PathName& path);
+
+    /// Loads the snapshot file.  A missing or unreadable snapshot file is
+    /// treated as an empty one.
+    /// @param snapshotFile Path to the snapshot file.
+    void Load(const MiKTeX::Util::PathName& snapshotFile);
+
+    /// Gets the startup configuration compiled from the given files.
+    /// @param inputs The files which would be read, in this order.
+    /// @param[out] startupConfig The startup configuration.
+    /// @return Returns `false`, if there is no up-to-date entry.
+    bool TryGet(const std::vector<Input>& inputs, InternalStartupConfig& startupConfig) const;
+
+    /// Adds an entry.  Nothing is added, if one of the files has just been
+    /// modified.
+    /// @param inputs The files the startup configuration was read from.
+    /// @param startupConfig The startup configuration.
+    void Put(const std::vector<Input>& inputs, const InternalStartupConfig& startupConfig);
+
+    /// Writes the snapshot file, if entries have been added and if the
+    /// directory exists.
+    void Save();
+
+private:
+
+    struct Entry
+    {
+        std::vector<Input> inputs;
+        InternalStartupConfig startupConfig;
+    };
+
+    std::vector<Entry> entries;
+    bool modified = false;
+    MiKTeX::Util::PathName snapshotFile;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
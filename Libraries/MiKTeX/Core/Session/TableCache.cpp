@@ -0,0 +1,169 @@
+/**
+ * @file Session/TableCache.cpp
+ * @author Christian Schenk
+ * @brief Persistent cache of parsed configuration tables
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <cstring>
+#include <ctime>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Process>
+
+#include "internal.h"
+
+#include "Session/TableCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+void TableWriter::Put(int64_t n)
+{
+    data.append(reinterpret_cast<const char*>(&n), sizeof(n));
+}
+
+void TableWriter::Put(const string& s)
+{
+    Put(static_cast<int64_t>(s.length()));
+    data.append(s);
+}
+
+void TableWriter::Put(const vector<string>& v)
+{
+    Put(static_cast<int64_t>(v.size()));
+    for (const string& s : v)
+    {
+        Put(s);
+    }
+}
+
+int64_t TableReader::GetInt()
+{
+    int64_t n;
+    if (data.length() - offset < sizeof(n))
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    memcpy(&n, data.c_str() + offset, sizeof(n));
+    offset += sizeof(n);
+    return n;
+}
+
+string TableReader::GetString()
+{
+    int64_t length = GetInt();
+    if (length < 0 || static_cast<uint64_t>(length) > data.length() - offset)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    string s = data.substr(offset, static_cast<size_t>(length));
+    offset += static_cast<size_t>(length);
+    return s;
+}
+
+vector<string> TableReader::GetStringVector()
+{
+    int64_t count = GetInt();
+    if (count < 0 || static_cast<uint64_t>(count) > (data.length() - offset) / sizeof(int64_t))
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    vector<string> v;
+    v.reserve(static_cast<size_t>(count));
+    for (int64_t idx = 0; idx < count; ++idx)
+    {
+        v.push_back(GetString());
+    }
+    return v;
+}
+
+TableCache::TableCache(const PathName& path, const string& signature) :
+    path(path),
+    signature(signature + "\n")
+{
+}
+
+// returns false, if a source file has been modified just now: a second
+// modification within the resolution of the time stamp would go unnoticed
+bool TableCache::MakeStamp(const vector<PathName>& sources, string& stamp)
+{
+    time_t now = time(nullptr);
+    TableWriter writer;
+    writer.Put(static_cast<int64_t>(sources.size()));
+    bool stable = true;
+    for (const PathName& source : sources)
+    {
+        time_t lastWriteTime = File::GetLastWriteTime(source);
+        stable = stable && lastWriteTime + 1 < now;
+        writer.Put(source.ToString());
+        writer.Put(static_cast<int64_t>(File::GetSize(source)));
+        writer.Put(static_cast<int64_t>(lastWriteTime));
+    }
+    stamp = writer.GetData();
+    return stable;
+}
+
+bool TableCache::TryRead(const vector<PathName>& sources, string& data)
+{
+    try
+    {
+        if (!File::Exists(path))
+        {
+            return false;
+        }
+        string stamp;
+        MakeStamp(sources, stamp);
+        vector<unsigned char> bytes = File::ReadAllBytes(path);
+        size_t headerSize = signature.length() + stamp.length();
+        if (bytes.size() < headerSize
+            || memcmp(bytes.data(), signature.c_str(), signature.length()) != 0
+            || memcmp(bytes.data() + signature.length(), stamp.c_str(), stamp.length()) != 0)
+        {
+            return false;
+        }
+        data.assign(reinterpret_cast<const char*>(bytes.data()) + headerSize, bytes.size() - headerSize);
+        return true;
+    }
+    catch (const MiKTeXException&)
+    {
+        return false;
+    }
+}
+
+void TableCache::Write(const vector<PathName>& sources, const string& data)
+{
+    try
+    {
+        string stamp;
+        if (!MakeStamp(sources, stamp))
+        {
+            return;
+        }
+        string contents = signature + stamp + data;
+        Directory::Create(path.GetDirectoryName());
+        // other processes may be reading the cache file: write a new file and
+        // move it into place
+        PathName newPath = path;
+        newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        File::WriteBytes(newPath, vector<unsigned char>(contents.begin(), contents.end()));
+        File::Move(newPath, path, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const MiKTeXException&)
+    {
+        // the cache is an optimization
+    }
+}
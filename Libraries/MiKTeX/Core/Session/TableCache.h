@@ -0,0 +1,111 @@
+/**
+ * @file Session/TableCache.h
+ * @author Christian Schenk
+ * @brief Persistent cache of parsed configuration tables
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Serializes a parsed table.
+class TableWriter
+{
+
+public:
+
+    void Put(std::int64_t n);
+
+    void Put(const std::string& s);
+
+    void Put(const std::vector<std::string>& v);
+
+    const std::string& GetData() const
+    {
+        return data;
+    }
+
+private:
+
+    std::string data;
+};
+
+/// Deserializes a parsed table. All getters throw, if the data is
+/// malformed.
+class TableReader
+{
+
+public:
+
+    TableReader(const std::string& data) :
+        data(data)
+    {
+    }
+
+    std::int64_t GetInt();
+
+    std::string GetString();
+
+    std::vector<std::string> GetStringVector();
+
+    bool AtEnd() const
+    {
+        return offset == data.length();
+    }
+
+private:
+
+    const std::string& data;
+
+    std::size_t offset = 0;
+};
+
+/// A table which has been parsed from configuration files, kept in a file so
+/// that the next process does not have to parse the configuration files
+/// again.
+///
+/// The cached table is used only if it was made from the same files, and if
+/// the size and the modification time of each file still match.
+class TableCache
+{
+
+public:
+
+    TableCache(const MiKTeX::Util::PathName& path, const std::string& signature);
+
+    /// Reads the cached table.
+    /// @param sources The files from which the table is parsed.
+    /// @param[out] data The serialized table.
+    /// @return Returns `false`, if there is no valid cached table.
+    bool TryRead(const std::vector<MiKTeX::Util::PathName>& sources, std::string& data);
+
+    /// Caches a table. Errors are ignored.
+    /// @param sources The files from which the table has been parsed.
+    /// @param data The serialized table.
+    void Write(const std::vector<MiKTeX::Util::PathName>& sources, const std::string& data);
+
+private:
+
+    bool MakeStamp(const std::vector<MiKTeX::Util::PathName>& sources, std::string& stamp);
+
+    MiKTeX::Util::PathName path;
+
+    std::string signature;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -193,16 +193,36 @@ MIKTEXSTATICFUNC(void) AppendToEnvVarName(string& name, const string& part)
   }
 }
 
-bool SessionImpl::GetSessionValue(const string& sectionName, const string& valueName, string& value, HasNamedValues* callback)
+bool SessionImpl::GetResolvedConfigValue(const string& sectionName, const string& valueName, string& value)
 {
-  bool haveValue = false;
-
-  // try special values, part 1
-  if (!haveValue && Utils::EqualsIgnoreCase(valueName, CFG_MACRO_NAME_ENGINE))
+  if (configValueCache == nullptr)
   {
-    value = GetEngineName();
-    haveValue = true;
+    configValueCache = make_unique<ConfigValueCache>(fsWatcher);
+    vector<PathName> configDirectories;
+    for (unsigned r = 0; r < GetNumberOfTEXMFRoots(); ++r)
+    {
+      configDirectories.push_back(GetRootDirectoryPath(r) / MIKTEX_PATH_MIKTEX_CONFIG_DIR);
+    }
+    configValueCache->Watch(configDirectories);
+  }
+  string key = applicationNames + '\n' + sectionName + '\n' + valueName;
+  bool haveValue;
+  if (configValueCache->TryGet(key, haveValue, value))
+  {
+    return haveValue;
   }
+  SessionServiceClient* sessionServiceClient = GetSessionServiceClient();
+  if (sessionServiceClient == nullptr || !sessionServiceClient->TryGetConfigValue(applicationNames, sectionName, valueName, haveValue, value))
+  {
+    haveValue = ResolveConfigValue(sectionName, valueName, value);
+  }
+  configValueCache->Put(key, haveValue, haveValue ? value : string());
+  return haveValue;
+}
+
+bool SessionImpl::ResolveConfigValue(const string& sectionName, const string& valueName, string& value)
+{
+  bool haveValue = false;
 
   // iterate over application tags, e.g.: latex;tex;miktex
   for (CsvList app(applicationNames, PathNameUtil::PathNameDelimiter); !haveValue && app; ++app)
@@ -291,8 +311,37 @@ bool SessionImpl::GetSessionValue(const string& sectionName, const string& value
     }
   }
 
+#if defined(MIKTEX_WINDOWS)
+  // try registry value
+  if (!haveValue && !IsMiKTeXPortable() && !sectionName.empty() && winRegistry::TryGetValue(ConfigurationScope::None, sectionName, valueName, value))
+  {
+    haveValue = true;
+  }
+#endif
+
+  return haveValue;
+}
+
+bool SessionImpl::GetSessionValue(const string& sectionName, const string& valueName, string& value, HasNamedValues* callback)
+{
+  bool haveValue = false;
+  bool configured = false;
+
+  // try special values, part 1
+  if (!haveValue && Utils::EqualsIgnoreCase(valueName, CFG_MACRO_NAME_ENGINE))
+  {
+    value = GetEngineName();
+    haveValue = true;
+  }
+
+  if (!haveValue)
+  {
+    haveValue = configured = GetResolvedConfigValue(sectionName, valueName, value);
+  }
+
   // try environment variable
   // <VALUENAME>
+  // not cached: programs may change the environment behind our back
   if (!haveValue && sectionName.empty())
   {
     if (Utils::GetEnvironmentString(valueName, value))
@@ -301,14 +350,6 @@ bool SessionImpl::GetSessionValue(const string& sectionName, const string& value
     }
   }
 
-#if defined(MIKTEX_WINDOWS)
-  // try registry value
-  if (!haveValue && !IsMiKTeXPortable() && !sectionName.empty() && winRegistry::TryGetValue(ConfigurationScope::None, sectionName, valueName, value))
-  {
-    haveValue = true;
-  }
-#endif
-
   // try special values, part 2
   if (!haveValue && Utils::EqualsIgnoreCase(valueName, CFG_MACRO_NAME_BINDIR))
   {
@@ -388,11 +429,16 @@ bool SessionImpl::GetSessionValue(const string& sectionName, const string& value
     }
     if (cfg->TryGetValueAsString(sectionName, valueName, value))
     {
-      haveValue = true;
+      haveValue = configured = true;
     }
   }
 #endif
 
+  if (!configured)
+  {
+    ++untrackedValueLookups;
+  }
+
 #if 1
   // expand the value
   if (haveValue)
@@ -474,6 +520,7 @@ void SessionImpl::SetConfigValue(const std::string& sectionName, const string& v
     && !GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_NO_REGISTRY, ConfigValue(USE_WINDOWS_REGISTRY ? false : true)).GetBool())
   {
     winRegistry::SetValue(IsAdminMode() ? ConfigurationScope::Common : ConfigurationScope::User, sectionName, valueName, value.GetString());
+    InvalidateConfigValueCache();
     string newValue;
     if (GetSessionValue(sectionName, valueName, newValue, nullptr))
     {
@@ -494,6 +541,10 @@ void SessionImpl::SetConfigValue(const std::string& sectionName, const string& v
     Fndb::Add({ { pathConfigFile } });
   }
   configurationSettings.clear();
+  InvalidateConfigValueCache();
+  // the service must not answer with the old value: reconnecting makes it
+  // catch up
+  ResetSessionServiceClient();
 }
 
 void SessionImpl::SetAdminMode(bool adminMode, bool force)
@@ -512,6 +563,7 @@ void SessionImpl::SetAdminMode(bool adminMode, bool force)
   }
   trace_config->WriteLine("core", TraceLevel::Info, fmt::format(T_("turning {0} administrator mode"), (adminMode ? "on" : "off")));
   // reinitialize
+  ResetSessionServiceClient();
   fileTypes.clear();
   UnloadFilenameDatabase();
   this->adminMode = adminMode;
@@ -725,6 +777,72 @@ std::string SessionImpl::Expand(const string& toBeExpanded, ExpandOptionSet opti
 }
 
 std::string SessionImpl::ExpandValues(const string& toBeExpanded, HasNamedValues* callback)
+{
+  if (toBeExpanded.find('$') == string::npos)
+  {
+    return toBeExpanded;
+  }
+  bool isDefaultCallback = dynamic_cast<DefaultCallback*>(callback) != nullptr;
+  if (callback != nullptr && !isDefaultCallback)
+  {
+    // other callbacks may answer differently next time
+    return ExpandValues(toBeExpanded, callback, nullptr);
+  }
+  if (expansionCache == nullptr)
+  {
+    expansionCache = make_unique<ExpansionCache>(fsWatcher);
+  }
+  // values are resolved on behalf of the application
+  string key = applicationNames + '\n' + (isDefaultCallback ? "1" : "0") + toBeExpanded;
+  unsigned generation;
+  string expansion;
+  vector<ExpansionCache::Dependency> dependencies;
+  switch (expansionCache->TryGet(key, generation, expansion, dependencies))
+  {
+  case ExpansionCache::Lookup::Hit:
+    return expansion;
+  case ExpansionCache::Lookup::Stale:
+    if (IsExpansionUpToDate(dependencies))
+    {
+      expansionCache->Revalidate(key, generation);
+      return expansion;
+    }
+    dependencies.clear();
+    break;
+  case ExpansionCache::Lookup::Miss:
+    break;
+  }
+  unsigned untracked = untrackedValueLookups;
+  expansion = ExpandValues(toBeExpanded, callback, &dependencies);
+  if (untrackedValueLookups == untracked)
+  {
+    expansionCache->Put(key, generation, expansion, std::move(dependencies));
+  }
+  return expansion;
+}
+
+bool SessionImpl::IsExpansionUpToDate(const vector<ExpansionCache::Dependency>& dependencies)
+{
+  unsigned untracked = untrackedValueLookups;
+  for (const ExpansionCache::Dependency& dependency : dependencies)
+  {
+    if (valuesBeingExpanded.find(dependency.valueName) != valuesBeingExpanded.end())
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    set<string>::iterator it = valuesBeingExpanded.insert(dependency.valueName).first;
+    string value;
+    bool haveValue = TryGetConfigValue(MIKTEX_CONFIG_SECTION_NONE, dependency.valueName, value);
+    valuesBeingExpanded.erase(it);
+    if (haveValue != dependency.haveValue || value != dependency.value || untrackedValueLookups != untracked)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string SessionImpl::ExpandValues(const string& toBeExpanded, HasNamedValues* callback, vector<ExpansionCache::Dependency>* dependencies)
 {
   const char* lpsz = toBeExpanded.c_str();
   string valueName;
@@ -781,6 +899,10 @@ std::string SessionImpl::ExpandValues(const string& toBeExpanded, HasNamedValues
         if (!haveValue)
         {
           haveValue = TryGetConfigValue(MIKTEX_CONFIG_SECTION_NONE, valueName, value);
+          if (dependencies != nullptr)
+          {
+            dependencies->push_back({ valueName, haveValue, haveValue ? value : string() });
+          }
         }
         if (haveValue)
         {
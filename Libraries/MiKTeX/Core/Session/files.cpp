@@ -113,24 +113,54 @@ void SessionImpl::RecordFileInfo(const PathName& path, FileAccess access)
   fir.access = access;
   if (recordingPackageNames || !packageHistoryFile.empty())
   {
-    PathName pathRelPath;
-    if (IsTEXMFFile(path, pathRelPath))
+    auto it = recordedPackageNames.find(fir.fileName);
+    if (it != recordedPackageNames.end())
     {
-      shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(GetMpmRoot());
-      if (fndb != nullptr)
+      fir.packageName = it->second;
+    }
+    else
+    {
+      PathName pathRelPath;
+      if (IsTEXMFFile(path, pathRelPath))
       {
-        vector<Fndb::Record> records;
-        if (fndb->Search(pathRelPath, MPM_ROOT_PATH, false, records))
+        shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(GetMpmRoot());
+        if (fndb != nullptr)
         {
-          fir.packageName = records[0].fileNameInfo;
+          vector<Fndb::Record> records;
+          if (fndb->Search(pathRelPath, MPM_ROOT_PATH, false, records))
+          {
+            fir.packageName = records[0].fileNameInfo;
+          }
         }
       }
+      recordedPackageNames[fir.fileName] = fir.packageName;
     }
   }
   fileInfoRecords.push_back(fir);
   if (fileNameRecorderStream.is_open())
   {
-    fileNameRecorderStream << (fir.access == FileAccess::Read ? "INPUT" : "OUTPUT") << " " << PathName(fir.fileName).ToUnix() << std::endl;
+    WriteFileInfoRecord(fir);
+  }
+}
+
+// the log file is flushed on request, e.g., after a page has been shipped
+// out, and when the session is closed
+void SessionImpl::WriteFileInfoRecord(const FileInfoRecord& fir)
+{
+  string line = (fir.access == FileAccess::Read ? "INPUT " : "OUTPUT ") + PathName(fir.fileName).ToUnix().ToString();
+  if (!recordedFileNames.insert(line).second)
+  {
+    return;
+  }
+  line += '\n';
+  fileNameRecorderStream.write(line.c_str(), line.length());
+}
+
+void SessionImpl::FlushFileInfoRecorder()
+{
+  if (fileNameRecorderStream.is_open())
+  {
+    fileNameRecorderStream.flush();
   }
 }
 
@@ -163,6 +193,12 @@ FILE* SessionImpl::OpenFile(const PathName& path, FileMode mode, FileAccess acce
   unique_ptr<Process> process;
   FILE* file = nullptr;
 
+  IOStatistics::Clock::time_point start;
+  if (ioStatistics != nullptr)
+  {
+    start = IOStatistics::Clock::now();
+  }
+
   if (mode == FileMode::Command)
   {
     MIKTEX_ASSERT(access == FileAccess::Read || access == FileAccess::Write);
@@ -173,6 +209,18 @@ FILE* SessionImpl::OpenFile(const PathName& path, FileMode mode, FileAccess acce
   else
   {
     file = File::Open(path, mode, access, text);
+    if (access != FileAccess::Read && directoryIndex != nullptr)
+    {
+      // don't wait for the watcher
+      PathName directory(path);
+      directory.MakeFullyQualified();
+      directoryIndex->Invalidate(directory.GetDirectoryName());
+    }
+  }
+
+  if (ioStatistics != nullptr)
+  {
+    ioStatistics->RecordOpen(path.ToString(), IOStatistics::Clock::now() - start);
   }
 
   try
@@ -304,14 +352,23 @@ void SessionImpl::CloseFile(FILE* file, int& exitCode)
   map<const FILE*, InternalOpenFileInfo>::iterator it = openFilesMap.find(file);
   bool isCommand = false;
   string command;
+  FileAccess access = FileAccess::None;
   unique_ptr<Process> process;
   if (it != openFilesMap.end())
   {
     isCommand = (it->second.mode == FileMode::Command);
     command = it->second.fileName;
+    access = it->second.access;
     process = move(it->second.process);
     openFilesMap.erase(it);
   }
+  IOStatistics::Clock::time_point start;
+  int64_t position = -1;
+  if (ioStatistics != nullptr)
+  {
+    start = IOStatistics::Clock::now();
+    position = isCommand ? -1 : static_cast<int64_t>(ftell(file));
+  }
   if (isCommand)
   {
     exitCode = CloseProcessPipe(process.get(), file);
@@ -324,6 +381,10 @@ void SessionImpl::CloseFile(FILE* file, int& exitCode)
   {
     MIKTEX_FATAL_CRT_ERROR("fclose");
   }
+  if (ioStatistics != nullptr && !command.empty())
+  {
+    ioStatistics->RecordClose(command, access, position, IOStatistics::Clock::now() - start);
+  }
 }
 
 bool SessionImpl::IsOutputFile(const FILE* file)
@@ -369,10 +430,9 @@ void SessionImpl::SetRecorderPath(const PathName& path)
   PathName cwd;
   cwd.SetToCurrentDirectory();
   fileNameRecorderStream << "PWD " << cwd.ToUnix() << "\n";
-  vector<FileInfoRecord> fileInfoRecords = GetFileInfoRecords();
-  for (vector<FileInfoRecord>::const_iterator it = fileInfoRecords.begin(); it != fileInfoRecords.end(); ++it)
+  for (const FileInfoRecord& fir : fileInfoRecords)
   {
-    fileNameRecorderStream << (it->access == FileAccess::Read ? "INPUT" : "OUTPUT") << " " << PathName(it->fileName).ToUnix() << "\n";
+    WriteFileInfoRecord(fir);
   }
   fileNameRecorderStream.flush();
 }
@@ -390,6 +450,48 @@ void SessionImpl::CheckOpenFiles()
   }
 }
 
+void SessionImpl::WriteIOReport()
+{
+  if (ioStatistics == nullptr)
+  {
+    return;
+  }
+  try
+  {
+    ioStatistics->WriteReport(PathName(ioReportFile), Utils::GetExeName());
+  }
+  catch (const exception& e)
+  {
+    trace_error->WriteLine("core", TraceLevel::Error, fmt::format("I/O report could not be written: {0}", e.what()));
+  }
+  ioStatistics = nullptr;
+}
+
+void SessionImpl::AddBuildTraceSpan(const string& category, const string& name, chrono::system_clock::time_point start, chrono::system_clock::time_point end)
+{
+  if (buildTrace != nullptr)
+  {
+    buildTrace->AddSpan(category, name, start, end);
+  }
+}
+
+void SessionImpl::WriteBuildTrace()
+{
+  if (buildTrace == nullptr)
+  {
+    return;
+  }
+  try
+  {
+    buildTrace->Write(PathName(buildTraceFile), Utils::GetExeName());
+  }
+  catch (const exception& e)
+  {
+    trace_error->WriteLine("core", TraceLevel::Error, fmt::format("build trace could not be written: {0}", e.what()));
+  }
+  buildTrace = nullptr;
+}
+
 void SessionImpl::WritePackageHistory()
 {
   if (packageHistoryFile.empty())
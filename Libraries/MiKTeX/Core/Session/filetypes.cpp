@@ -295,8 +295,11 @@ vector<FileTypeInfo> SessionImpl::GetFileTypes()
 
 void SessionImpl::ClearSearchVectors()
 {
+  ClearCompiledSearchPaths();
   for (InternalFileTypeInfo& info : fileTypes)
   {
-    info.pathPatterns.clear();
+    info.findFileCacheKey.clear();
+    info.volatilePathPatterns.clear();
+    info.findFileCacheable = TriState::Undetermined;
   }
 }
@@ -21,11 +21,20 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/BufferSizes>
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/LockFile>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Paths>
 
 #include "internal.h"
@@ -33,11 +42,13 @@
 #include "Fndb/FileNameDatabase.h"
 #include "Session/SessionImpl.h"
 #include "Utils/CoreStopWatch.h"
+#include "Utils/inliners.h"
 
 using namespace std;
 
 using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
 void SessionImpl::SetFindFileCallback(IFindFileCallback* callback)
@@ -71,6 +82,110 @@ bool SessionImpl::CheckCandidate(PathName& path, const char* fileInfo, IFindFile
   return found;
 }
 
+vector<char> SessionImpl::CheckCandidates(vector<Fndb::Record>& records, bool trusted, IFindFileCallback* callback)
+{
+  vector<char> exists(records.size(), 0);
+  vector<char> checked(records.size(), 0);
+  vector<size_t> files;
+  for (size_t idx = 0; idx < records.size(); ++idx)
+  {
+    if (IsMpmFile(records[idx].path.GetData()))
+    {
+      continue;
+    }
+    if (trusted)
+    {
+      exists[idx] = 1;
+      checked[idx] = 1;
+    }
+    else
+    {
+      files.push_back(idx);
+    }
+  }
+  if (files.size() >= FIND_FILE_PARALLEL_CHECK_THRESHOLD)
+  {
+    // one round trip per file is expensive on a network share: let the
+    // round trips overlap
+    size_t threadCount = std::min<size_t>({ FIND_FILE_MAX_CHECK_THREADS, files.size(), std::max<size_t>(1, thread::hardware_concurrency()) });
+    atomic<size_t> next{ 0 };
+    auto work = [&]()
+    {
+      for (size_t n = next++; n < files.size(); n = next++)
+      {
+        size_t idx = files[n];
+        try
+        {
+          exists[idx] = File::Exists(records[idx].path) ? 1 : 0;
+          checked[idx] = 1;
+        }
+        catch (const exception&)
+        {
+          // checked below
+        }
+      }
+    };
+    vector<thread> threads;
+    for (size_t n = 1; n < threadCount; ++n)
+    {
+      threads.push_back(thread(work));
+    }
+    work();
+    for (thread& t : threads)
+    {
+      t.join();
+    }
+  }
+  // the package installer is triggered in order
+  for (size_t idx = 0; idx < records.size(); ++idx)
+  {
+    if (!checked[idx])
+    {
+      exists[idx] = CheckCandidate(records[idx].path, records[idx].fileNameInfo.c_str(), callback) ? 1 : 0;
+    }
+  }
+  return exists;
+}
+
+bool SessionImpl::IsFndbTrusted(unsigned r)
+{
+  if (trustFndb == TriState::Undetermined)
+  {
+    trustFndb = GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_TRUST_FNDB, ConfigValue(false)).GetBool() ? TriState::True : TriState::False;
+  }
+  if (trustFndb != TriState::True || r == INVALID_ROOT_INDEX || r >= GetNumberOfTEXMFRoots())
+  {
+    return false;
+  }
+  // nobody changes a read-only managed tree behind our back; a writable tree
+  // is kept up-to-date by the FNDB service (miktex fndb serve)
+  return IsFndbWritable(r) ? IsFndbServed() : IsManagedRoot(r);
+}
+
+bool SessionImpl::IsFndbServed()
+{
+  if (fndbServed == TriState::Undetermined)
+  {
+    fndbServed = TriState::False;
+    PathName lockPath = GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FNDB_SERVICE_LOCK;
+    if (File::Exists(lockPath))
+    {
+      // the service holds the lock as long as it is running
+      unique_ptr<LockFile> lockFile = LockFile::Create(lockPath);
+      if (lockFile->TryLock(0ms))
+      {
+        lockFile->Unlock();
+      }
+      else
+      {
+        fndbServed = TriState::True;
+      }
+    }
+    trace_fndb->WriteLine("core", fmt::format(T_("fndb service: {0}"), fndbServed == TriState::True ? T_("running") : T_("not running")));
+  }
+  return fndbServed == TriState::True;
+}
+
 bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPattern, bool all, vector<PathName>& result, IFindFileCallback* callback)
 {
   MIKTEX_ASSERT(result.empty());
@@ -80,43 +195,52 @@ bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPatte
     return false;
   }
 
-  trace_filesearch->WriteLine("core", fmt::format(T_("file system search: fileName={0}, pathPattern={1}"), Q_(fileName), Q_(pathPattern)));
-
-  vector<PathName> directories;
+  MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("file system search: fileName={0}, pathPattern={1}"), Q_(fileName), Q_(pathPattern)));
 
   PathName comparablePathPattern(pathPattern);
   comparablePathPattern.TransformForComparison();
 
-  SearchPathDictionary::const_iterator it = expandedPathPatterns.find(comparablePathPattern.ToString());
+  SearchPathDictionary::iterator it = expandedPathPatterns.find(comparablePathPattern.ToString());
 
   if (it == expandedPathPatterns.end())
   {
+    vector<PathName> directories;
     ExpandPathPattern(PathName(), PathName(pathPattern), directories);
-    expandedPathPatterns[comparablePathPattern.ToString()] = directories;
-  }
-  else
-  {
-    directories = it->second;
+    it = expandedPathPatterns.emplace(comparablePathPattern.ToString(), std::move(directories)).first;
   }
 
+  // entries are never erased, so the reference stays valid
+  const vector<PathName>& directories = it->second;
+
   bool found = false;
 
+  DirectoryIndex* directoryIndex = GetDirectoryIndex();
+
+  // the watcher may not have reported a file which has just been created in
+  // the working directory, e.g., by a shell escape
+  PathName currentDirectory;
+  currentDirectory.SetToCurrentDirectory();
+
   for (vector<PathName>::const_iterator it = directories.begin(); (!found || all) && it != directories.end(); ++it)
   {
+    if (directoryIndex->Contains(*it, fileName) == TriState::False && *it != currentDirectory)
+    {
+      continue;
+    }
     PathName path(*it / fileName);
     if (CheckCandidate(path, nullptr, callback))
     {
       found = true;
-      result.push_back(path);
+      result.push_back(std::move(path));
     }
   }
 
   return found;
 }
 
-bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<PathName>& pathPatterns, bool all, bool useFndb, bool searchFileSystem, vector<PathName>& result, IFindFileCallback* callback)
+bool SessionImpl::FindFileInDirectories(const string& fileName, const CompiledSearchPath& searchPath, bool all, bool useFndb, bool searchFileSystem, vector<PathName>& result, IFindFileCallback* callback)
 {
-  CoreStopWatch stopWatch(fmt::format("find file {}", Q_(fileName)));
+  CoreStopWatch stopWatch("find file", fmt::format("find file {}", Q_(fileName)));
 
   MIKTEX_ASSERT(useFndb || searchFileSystem);
 
@@ -135,7 +259,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
     found = CheckCandidate(path, nullptr, callback);
     if (found)
     {
-      result.push_back(path);
+      result.push_back(std::move(path));
     }
     return found;
   }
@@ -160,7 +284,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
           path = fileName;
         }
 #endif
-        result.push_back(path);
+        result.push_back(std::move(path));
       }
     }
     return found;
@@ -176,7 +300,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
       found = CheckCandidate(p.second, nullptr, callback);
       if (found)
       {
-        result.push_back(p.second);
+        result.push_back(std::move(p.second));
       }
       return found;
     }
@@ -185,32 +309,33 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
   // make use of the file name database
   if (useFndb)
   {
-    for (vector<PathName>::const_iterator it = pathPatterns.begin(); (!found || all) && it != pathPatterns.end(); ++it)
+    for (vector<CompiledPathPattern>::const_iterator it = searchPath.GetPatterns().begin(); (!found || all) && it != searchPath.GetPatterns().end(); ++it)
     {
-      trace_filesearch->WriteLine("core", fmt::format(T_("going to search in FNDB: filename={0}, directory={1}"), Q_(fileName), Q_(it->ToString())));
+      MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("going to search in FNDB: filename={0}, directory={1}"), Q_(fileName), Q_(it->path.ToString())));
 #if FIND_FILE_DONT_TRIGGER_INSTALLER_IF_ALL
-      if (found && all && IsMpmFile(it->GetData()))
+      if (found && all && it->isMpm)
       {
         // don't trigger the package installer if we have found a file and if all occurrences are requested
         continue;
       }
 #endif
-      shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(it->GetData());
+      shared_ptr<FileNameDatabase> fndb = it->rootIndex == INVALID_ROOT_INDEX ? nullptr : GetFileNameDatabase(it->rootIndex);
       if (fndb != nullptr)
       {
         // search fndb
         vector<Fndb::Record> records;
-        bool foundInFndb = fndb->Search(PathName(fileName), it->ToString(), all, records);
+        bool foundInFndb = fndb->Search(fileName, *it, all, records);
         // we must release the FNDB handle since CheckCandidate() might request an unload of the FNDB
         fndb = nullptr;
         if (foundInFndb)
         {
+          vector<char> exists = CheckCandidates(records, IsFndbTrusted(it->rootIndex), callback);
           for (int idx = 0; idx < records.size(); ++idx)
           {
-            if (CheckCandidate(records[idx].path, records[idx].fileNameInfo.c_str(), callback))
+            if (exists[idx])
             {
               found = true;
-              result.push_back(records[idx].path);
+              result.push_back(std::move(records[idx].path));
             }
           }
         }
@@ -218,12 +343,12 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
       else
       {
         // search the file system because the FNDB does not exist
-        trace_filesearch->WriteLine("core", fmt::format(T_("no FNDB found, so going to continue on disk: filename={0}, directory={1}"), Q_(fileName), Q_(*it)));
+        MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("no FNDB found, so going to continue on disk: filename={0}, directory={1}"), Q_(fileName), Q_(it->path)));
         vector<PathName> paths;
-        if (SearchFileSystem(fileName, it->GetData(), all, paths, callback))
+        if (SearchFileSystem(fileName, it->path.GetData(), all, paths, callback))
         {
           found = true;
-          result.insert(result.end(), paths.begin(), paths.end());
+          result.insert(result.end(), make_move_iterator(paths.begin()), make_move_iterator(paths.end()));
         }
       }
     }
@@ -235,21 +360,25 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
   }
 
   // search the file system
-  for (vector<PathName>::const_iterator it = pathPatterns.begin(); (!found || all) && it != pathPatterns.end(); ++it)
+  for (vector<CompiledPathPattern>::const_iterator it = searchPath.GetPatterns().begin(); (!found || all) && it != searchPath.GetPatterns().end(); ++it)
   {
     // FIXME: why if found and all?
-    if (found && all && IsMpmFile(it->GetData()))
+    if (found && all && it->isMpm)
     {
       // don't search the virtual MPM directory tree
       continue;
     }
-    unsigned rootIdx = TryDeriveTEXMFRoot(*it);
-    if (rootIdx != INVALID_ROOT_INDEX && IsManagedRoot(rootIdx))
+    if (it->rootIndex == INVALID_ROOT_INDEX)
+    {
+      // FNDB does not exist => we already searched the file system (see above)
+      continue;
+    }
+    if (IsManagedRoot(it->rootIndex))
     {
       // don't search managed root file system (because we insist that an FNDB exists)
       continue;
     }
-    shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(it->GetData());
+    shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(it->rootIndex);
     if (fndb == nullptr)
     {
       // FNDB does not exist => we already searched the file system (see above)
@@ -257,10 +386,10 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
     }
     fndb = nullptr;
     vector<PathName> paths;
-    if (SearchFileSystem(fileName, it->GetData(), all, paths, callback))
+    if (SearchFileSystem(fileName, it->path.GetData(), all, paths, callback))
     {
       found = true;
-      result.insert(result.end(), paths.begin(), paths.end());
+      result.insert(result.end(), make_move_iterator(paths.begin()), make_move_iterator(paths.end()));
     }
   }
 
@@ -272,6 +401,269 @@ inline bool IsNewer(const PathName& path1, const PathName& path2)
   return File::Exists(path1) && File::Exists(path2) && File::GetLastWriteTime(path1) > File::GetLastWriteTime(path2);
 }
 
+bool SessionImpl::IsShadowedByVolatileFile(const InternalFileTypeInfo& fti, const vector<PathName>& fileNames)
+{
+  for (const PathName& pattern : fti.volatilePathPatterns)
+  {
+    for (const PathName& fn : fileNames)
+    {
+      if (File::Exists(pattern / fn.ToString()))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool SessionImpl::IsKnownToPackageManager(const vector<PathName>& pathPatterns, const vector<PathName>& fileNames)
+{
+  for (const PathName& pattern : pathPatterns)
+  {
+    if (!IsMpmFile(pattern.GetData()))
+    {
+      continue;
+    }
+    shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(pattern.GetData());
+    if (fndb == nullptr)
+    {
+      continue;
+    }
+    for (const PathName& fn : fileNames)
+    {
+      vector<Fndb::Record> records;
+      if (fndb->Search(fn, pattern.ToString(), false, records))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+FindFileMissCache* SessionImpl::GetFindFileMissCache()
+{
+  if (findFileMissCache == nullptr)
+  {
+    findFileMissCache = make_unique<FindFileMissCache>(fsWatcher, FIND_FILE_MISS_CACHE_CAPACITY);
+  }
+  return findFileMissCache.get();
+}
+
+DirectoryIndex* SessionImpl::GetDirectoryIndex()
+{
+  if (directoryIndex == nullptr)
+  {
+    directoryIndex = make_unique<DirectoryIndex>(fsWatcher);
+  }
+  return directoryIndex.get();
+}
+
+string SessionImpl::GetFindFileCacheGeneration()
+{
+  MD5Builder md5Builder;
+  auto update = [&md5Builder](const string& s)
+  {
+    md5Builder.Update(s.c_str(), s.length() + 1);
+  };
+  update(fmt::format("{0}", MIKTEX_FNDB_VERSION));
+  unsigned n = GetNumberOfTEXMFRoots();
+  for (unsigned r = 0; r <= n; ++r)
+  {
+    if (r == n && GetInstallRoot() == INVALID_ROOT_INDEX)
+    {
+      continue;
+    }
+    if (r < n)
+    {
+      update(GetRootDirectoryPath(r).ToString());
+      // configuration files are rewritten in place: the FNDB stays the same
+      PathName configDir = GetRootDirectoryPath(r) / MIKTEX_PATH_MIKTEX_CONFIG_DIR;
+      if (Directory::Exists(configDir))
+      {
+        vector<string> configFiles;
+        unique_ptr<DirectoryLister> lister = DirectoryLister::Open(configDir, "*.ini");
+        DirectoryEntry entry;
+        while (lister->GetNext(entry))
+        {
+          if (!entry.isDirectory)
+          {
+            configFiles.push_back(entry.name);
+          }
+        }
+        lister->Close();
+        sort(configFiles.begin(), configFiles.end());
+        for (const string& name : configFiles)
+        {
+          PathName configFile = configDir / name;
+          update(fmt::format("{0}:{1}:{2}", name, File::GetSize(configFile), File::GetLastWriteTime(configFile)));
+        }
+      }
+    }
+    PathName fndbPath;
+    if (!FindFilenameDatabase(r, fndbPath))
+    {
+      update("");
+      continue;
+    }
+    update(fndbPath.ToString());
+    update(fmt::format("{0}:{1}", File::GetSize(fndbPath), File::GetLastWriteTime(fndbPath)));
+    PathName changeFile = fndbPath;
+    changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+    if (File::Exists(changeFile))
+    {
+      update(fmt::format("{0}:{1}", File::GetSize(changeFile), File::GetLastWriteTime(changeFile)));
+    }
+  }
+  md5Builder.Final();
+  return md5Builder.GetMD5().ToString();
+}
+
+FindFileCache* SessionImpl::GetFindFileCache()
+{
+  if (!findFileCacheInitialized)
+  {
+    findFileCacheInitialized = true;
+    if (GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FIND_FILE_CACHE, ConfigValue(false)).GetBool())
+    {
+      try
+      {
+        findFileCache = make_unique<FindFileCache>(GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FINDFILE_CACHE, GetFindFileCacheGeneration());
+      }
+      catch (const exception& e)
+      {
+        trace_filesearch->WriteLine("core", TraceLevel::Error, fmt::format(T_("find-file cache cannot be used: {0}"), e.what()));
+      }
+    }
+  }
+  return findFileCache.get();
+}
+
+FontMetricCache* SessionImpl::GetFontMetricCache()
+{
+  if (!fontMetricCacheInitialized)
+  {
+    fontMetricCacheInitialized = true;
+    if (GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FONT_METRIC_CACHE, ConfigValue(false)).GetBool())
+    {
+      try
+      {
+        fontMetricCache = make_unique<FontMetricCache>(GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FONT_METRIC_CACHE);
+      }
+      catch (const exception& e)
+      {
+        trace_error->WriteLine("core", TraceLevel::Error, fmt::format(T_("font metric cache cannot be used: {0}"), e.what()));
+      }
+    }
+  }
+  return fontMetricCache.get();
+}
+
+vector<unsigned char> SessionImpl::ReadFontMetricFile(const PathName& path)
+{
+  vector<unsigned char> data;
+  FontMetricCache* fontMetricCache = GetFontMetricCache();
+  if (fontMetricCache == nullptr || !fontMetricCache->TryGet(path, data))
+  {
+    data = File::ReadAllBytes(path);
+    if (fontMetricCache != nullptr && FontMetricCache::IsPlausible(data))
+    {
+      fontMetricCache->Put(path, data);
+    }
+  }
+  RecordFileInfo(path, FileAccess::Read);
+  return data;
+}
+
+bool SessionImpl::IsFontMetricCacheEnabled()
+{
+  return GetFontMetricCache() != nullptr;
+}
+
+PdfBoxCache* SessionImpl::GetPdfBoxCache()
+{
+  if (!pdfBoxCacheInitialized)
+  {
+    pdfBoxCacheInitialized = true;
+    if (GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_PDF_BOX_CACHE, ConfigValue(true)).GetBool())
+    {
+      pdfBoxCache = make_unique<PdfBoxCache>(GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_PDF_BOX_CACHE_DIR);
+    }
+  }
+  return pdfBoxCache.get();
+}
+
+bool SessionImpl::TryGetPdfBoxInfo(const PathName& path, int page, const string& boxName, PdfBoxInfo& info)
+{
+  PdfBoxCache* pdfBoxCache = GetPdfBoxCache();
+  return pdfBoxCache != nullptr && pdfBoxCache->TryGet(path, page, boxName, info);
+}
+
+void SessionImpl::SetPdfBoxInfo(const PathName& path, int page, const string& boxName, const PdfBoxInfo& info)
+{
+  PdfBoxCache* pdfBoxCache = GetPdfBoxCache();
+  if (pdfBoxCache != nullptr)
+  {
+    pdfBoxCache->Put(path, page, boxName, info);
+  }
+}
+
+bool SessionImpl::PrepareFindFileCache(InternalFileTypeInfo& fti, const vector<PathName>& pathPatterns)
+{
+  if (fti.findFileCacheable != TriState::Undetermined)
+  {
+    return fti.findFileCacheable == TriState::True;
+  }
+  fti.findFileCacheable = TriState::False;
+  fti.volatilePathPatterns.clear();
+  MD5Builder md5Builder;
+  for (const PathName& pattern : pathPatterns)
+  {
+    md5Builder.Update(pattern.GetData(), pattern.GetLength() + 1);
+    if (IsMpmFile(pattern.GetData()) || GetFileNameDatabase(pattern.GetData()) != nullptr)
+    {
+      continue;
+    }
+    // files can come and go here without notice
+    if (strstr(pattern.GetData(), RECURSION_INDICATOR) != nullptr)
+    {
+      trace_filesearch->WriteLine("core", fmt::format(T_("not caching {0} lookups because of {1}"), fti.fileTypeString, Q_(pattern)));
+      return false;
+    }
+    fti.volatilePathPatterns.push_back(pattern);
+  }
+  GetFindFileMissCache()->Watch(fti.volatilePathPatterns);
+  md5Builder.Final();
+  fti.findFileCacheKey = fmt::format("{0}:{1}", static_cast<int>(fti.fileType), md5Builder.GetMD5().ToString());
+  fti.findFileCacheable = TriState::True;
+  return true;
+}
+
+vector<PathName> SessionImpl::GetFileNamesToTry(const string& fileName, const InternalFileTypeInfo& fti)
+{
+  // check to see whether the file name has a registered file name extension
+  PathName extension(PathName(fileName).GetExtension());
+  bool hasRegisteredExtension = !extension.Empty()
+    && (std::find_if(fti.fileNameExtensions.begin(), fti.fileNameExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti.fileNameExtensions.end()
+      || std::find_if(fti.alternateExtensions.begin(), fti.alternateExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti.alternateExtensions.end());
+
+  vector<PathName> fileNamesToTry;
+
+  // try each registered file name extension, if none was specified
+  if (!hasRegisteredExtension)
+  {
+    for (const string& ext : fti.fileNameExtensions)
+    {
+      fileNamesToTry.push_back(PathName(fileName).AppendExtension(ext));
+    }
+  }
+
+  // try it with the given file name
+  fileNamesToTry.push_back(PathName(fileName));
+
+  return fileNamesToTry;
+}
+
 bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool all, bool searchFileSystem, bool create, bool renew, vector<PathName>& result, IFindFileCallback* callback)
 {
   MIKTEX_ASSERT(result.empty());
@@ -287,7 +679,7 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
     fileType = DeriveFileType(PathName(fileName));
     if (fileType == FileType::None)
     {
-      trace_filesearch->WriteLine("core", fmt::format(T_("cannot derive file type from {0}"), Q_(fileName)));
+      MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("cannot derive file type from {0}"), Q_(fileName)));
       return false;
     }
   }
@@ -298,37 +690,95 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
   }
 
   // construct the search vector
-  vector<PathName> pathPatterns = GetDirectoryPatterns(fileType);
+  shared_ptr<const CompiledSearchPath> searchPath = GetDirectoryPatterns(fileType);
+  const vector<PathName>& pathPatterns = searchPath->GetPathNames();
 
   // get the file type information
   const InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
   MIKTEX_ASSERT(fti != nullptr);
 
-  // check to see whether the file name has a registered file name extension
-  PathName extension(PathName(fileName).GetExtension());
-  bool hasRegisteredExtension = !extension.Empty()
-    && (std::find_if(fti->fileNameExtensions.begin(), fti->fileNameExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->fileNameExtensions.end()
-      || std::find_if(fti->alternateExtensions.begin(), fti->alternateExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->alternateExtensions.end());
-
-  vector<PathName> fileNamesToTry;
-
-  // try each registered file name extension, if none was specified
-  if (!hasRegisteredExtension)
+  vector<PathName> fileNamesToTry = GetFileNamesToTry(fileName, *fti);
+
+  // consult the find-file caches, unless the file name is not subject to a path search
+  FindFileCache* findFileCache = nullptr;
+  FindFileMissCache* findFileMissCache = nullptr;
+  string findFileCacheKey;
+  string findFileMissKey;
+  if (!all
+    && !PathNameUtil::IsAbsolutePath(fileName)
+    && !IsExplicitlyRelativePath(fileName.c_str())
+    && fileName[0] != '~'
+    && PrepareFindFileCache(*GetInternalFileTypeInfo(fileType), pathPatterns))
   {
-    for (const string& ext : fti->fileNameExtensions)
+    findFileCache = GetFindFileCache();
+    findFileMissCache = create ? nullptr : GetFindFileMissCache();
+    findFileCacheKey = fti->findFileCacheKey + ":" + fileName;
+    findFileMissKey = fmt::format("{0}:{1}", searchFileSystem ? 1 : 0, findFileCacheKey);
+    if (!IsShadowedByVolatileFile(*fti, fileNamesToTry))
     {
-      fileNamesToTry.push_back(PathName(fileName).AppendExtension(ext));
+      if (findFileMissCache != nullptr && findFileMissCache->Contains(findFileMissKey))
+      {
+        MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("{0} is known to be missing"), Q_(fileName)));
+        return false;
+      }
+      PathName cachedPath;
+      if (findFileCache != nullptr && findFileCache->TryGet(findFileCacheKey, cachedPath))
+      {
+        if (cachedPath.Empty())
+        {
+          if (!searchFileSystem && findFileMissCache != nullptr)
+          {
+            MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("{0} is known to be missing (find-file cache)"), Q_(fileName)));
+            findFileMissCache->Insert(findFileMissKey);
+            return false;
+          }
+        }
+        else if (File::Exists(cachedPath))
+        {
+          MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("found {0} in find-file cache: {1}"), Q_(fileName), Q_(cachedPath)));
+          result.push_back(cachedPath);
+          return true;
+        }
+      }
+      // let the session service answer, if it is running
+      SessionServiceClient* sessionServiceClient = create ? nullptr : GetSessionServiceClient();
+      if (sessionServiceClient != nullptr)
+      {
+        PathName servedPath;
+        switch (sessionServiceClient->FindFile(fileType, fti->findFileCacheKey, searchFileSystem, fileName, servedPath))
+        {
+        case SessionServiceClient::FindFileResult::Found:
+          MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("found {0} by session service: {1}"), Q_(fileName), Q_(servedPath)));
+          result.push_back(servedPath);
+          return true;
+        case SessionServiceClient::FindFileResult::Missing:
+          MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("{0} is known to be missing (session service)"), Q_(fileName)));
+          if (findFileMissCache != nullptr)
+          {
+            findFileMissCache->Insert(findFileMissKey);
+          }
+          return false;
+        default:
+          break;
+        }
+      }
     }
   }
 
-  // try it with the given file name
-  fileNamesToTry.push_back(PathName(fileName));
-
   // first round: use the fndb
   for (const PathName& fn : fileNamesToTry)
   {
-    if (FindFileInDirectories(fn.ToString(), pathPatterns, all, true, false, result, callback) && !all)
+    if (FindFileInDirectories(fn.ToString(), *searchPath, all, true, false, result, callback) && !all)
     {
+      if (findFileCache != nullptr)
+      {
+        unsigned r = TryDeriveTEXMFRoot(result[0]);
+        PathName fndbPath;
+        if (r != INVALID_ROOT_INDEX && r != GetNumberOfTEXMFRoots() && FindFilenameDatabase(r, fndbPath))
+        {
+          findFileCache->Put(findFileCacheKey, result[0]);
+        }
+      }
       return true;
     }
   }
@@ -338,20 +788,30 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
   {
     for (const PathName& fn : fileNamesToTry)
     {
-      if (FindFileInDirectories(fn.ToString(), pathPatterns, all, false, true, result, callback) && !all)
+      if (FindFileInDirectories(fn.ToString(), *searchPath, all, false, true, result, callback) && !all)
       {
         return true;
       }
     }
   }
 
+  // remember the miss, unless the package manager could have provided the file
+  if (findFileMissCache != nullptr && result.empty() && !IsKnownToPackageManager(pathPatterns, fileNamesToTry))
+  {
+    findFileMissCache->Insert(findFileMissKey);
+    if (findFileCache != nullptr && !searchFileSystem)
+    {
+      findFileCache->Put(findFileCacheKey, PathName());
+    }
+  }
+
   if (create)
   {
     if (result.empty())
     {
       if (callback != nullptr && callback->TryCreateFile(PathName(fileName), fileType))
       {
-        FindFileInDirectories(fileName, pathPatterns, all, true, false, result, callback);
+        FindFileInDirectories(fileName, *searchPath, all, true, false, result, callback);
       }
     }
     else if ((fileType == FileType::BASE || fileType == FileType::FMT || fileType == FileType::MEM) && callback != nullptr && GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_RENEW_FORMATS_ON_UPDATE).GetBool())
@@ -373,7 +833,7 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
         if (callback->TryCreateFile(PathName(fileName), fileType))
         {
           result.clear();
-          FindFileInDirectories(fileName, pathPatterns, all, true, false, result, callback);
+          FindFileInDirectories(fileName, *searchPath, all, true, false, result, callback);
         }
       }
     }
@@ -383,17 +843,37 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
 }
 
 LocateResult MIKTEXTHISCALL SessionImpl::Locate(const string& givenFileName, const LocateOptions& options)
+{
+  if (ioStatistics != nullptr || buildTrace != nullptr)
+  {
+    IOStatistics::Clock::time_point start = IOStatistics::Clock::now();
+    LocateResult result = LocateInternal(givenFileName, options);
+    IOStatistics::Clock::duration latency = IOStatistics::Clock::now() - start;
+    if (ioStatistics != nullptr)
+    {
+      ioStatistics->RecordFindFile(givenFileName, !result.pathNames.empty(), latency);
+    }
+    if (buildTrace != nullptr)
+    {
+      buildTrace->RecordFindFile(latency);
+    }
+    return result;
+  }
+  return LocateInternal(givenFileName, options);
+}
+
+LocateResult SessionImpl::LocateInternal(const string& givenFileName, const LocateOptions& options)
 {
   string fileName = this->ExpandValues(givenFileName, nullptr);
   bool found = false;
   vector<PathName> pathNames;
   if (options.fileType == FileType::None)
   {
-    auto pathPatterns = SplitSearchPath(options.searchPath.empty() ? MIKTEX_PATH_TEXMF_PLACEHOLDER : options.searchPath);
-    found = FindFileInDirectories(fileName, pathPatterns, options.all, true, false, pathNames, options.callback);
+    shared_ptr<const CompiledSearchPath> searchPath = GetCompiledSearchPath(options.searchPath.empty() ? MIKTEX_PATH_TEXMF_PLACEHOLDER : options.searchPath);
+    found = FindFileInDirectories(fileName, *searchPath, options.all, true, false, pathNames, options.callback);
     if (!found && options.searchFileSystem)
     {
-      found = FindFileInDirectories(fileName, pathPatterns, options.all, false, true, pathNames, options.callback);
+      found = FindFileInDirectories(fileName, *searchPath, options.all, false, true, pathNames, options.callback);
     }
   }
   else
@@ -532,6 +1012,44 @@ static const string DEFAULT_PK_SEARCH_PATH = ".;%R\\fonts\\pk\\%m//dpi%d";
 static const string DEFAULT_PK_SEARCH_PATH = ".:%R/fonts/pk/%m//dpi%d";
 #endif
 
+map<int, PathName> SessionImpl::GetPkResolutions(const PathName& pkFileName, const string& mfMode)
+{
+  string key = pkFileName.ToString() + "\n" + mfMode;
+  {
+    lock_guard<mutex> lockGuard(pkResolutionsMutex);
+    auto it = pkResolutions.find(key);
+    if (it != pkResolutions.end())
+    {
+      return it->second;
+    }
+  }
+  map<int, PathName> resolutions;
+  SessionServiceClient* sessionServiceClient = GetSessionServiceClient();
+  if (sessionServiceClient == nullptr || !sessionServiceClient->TryGetPkResolutions(pkFileName, mfMode, resolutions))
+  {
+    resolutions.clear();
+    CollectPkResolutions(pkFileName, mfMode, resolutions);
+  }
+  lock_guard<mutex> lockGuard(pkResolutionsMutex);
+  return pkResolutions.emplace(key, resolutions).first->second;
+}
+
+void SessionImpl::CollectPkResolutions(const PathName& pkFileName, const string& mfMode, map<int, PathName>& resolutions)
+{
+  // one FNDB search for all dpiNNN directories
+  LocateOptions locateOptions;
+  locateOptions.all = true;
+  locateOptions.searchPath = (PathName("%R") / "fonts" / "pk" / mfMode).ToString() + RECURSION_INDICATOR;
+  for (const PathName& path : Locate(pkFileName.ToString(), locateOptions).pathNames)
+  {
+    string dir = path.GetDirectoryName().GetFileName().ToString();
+    if (dir.length() > 3 && dir.compare(0, 3, "dpi") == 0 && std::all_of(dir.begin() + 3, dir.end(), IsDecimalDigitAscii))
+    {
+      resolutions.emplace(std::stoi(dir.substr(3)), path);
+    }
+  }
+}
+
 bool SessionImpl::FindPkFile(const string& fontName, const string& mfMode, int dpi, PathName& result)
 {
   PathName pkFileName;
@@ -541,11 +1059,41 @@ bool SessionImpl::FindPkFile(const string& fontName, const string& mfMode, int d
     return false;
   }
 
+  // FIXME: hardcoded METAFONT mode
+  string mode = mfMode.empty() ? "ljfour" : mfMode;
+
   string searchPathTemplate;
 
+  // the index can be used if the resolution is encoded in the directory
+  // name only
+  bool useIndex = false;
+
   if (!GetSessionValue(MIKTEX_CONFIG_SECTION_CORE, "PKPath", searchPathTemplate, nullptr))
   {
     searchPathTemplate = DEFAULT_PK_SEARCH_PATH;
+    PathName otherPkFileName;
+    useIndex = MakePkFileName(otherPkFileName, fontName, dpi + 1) && otherPkFileName == pkFileName;
+  }
+
+  if (useIndex && !File::Exists(pkFileName))
+  {
+    map<int, PathName> resolutions = GetPkResolutions(pkFileName, mode);
+    // the tolerance of the DVI library (see PkFont::CheckDpi())
+    int margin = 1 + dpi / 500;
+    auto best = resolutions.end();
+    for (auto it = resolutions.lower_bound(dpi - margin); it != resolutions.end() && it->first <= dpi + margin; ++it)
+    {
+      if (best == resolutions.end() || std::abs(it->first - dpi) < std::abs(best->first - dpi))
+      {
+        best = it;
+      }
+    }
+    if (best != resolutions.end())
+    {
+      result = best->second;
+      return true;
+    }
+    // the PK file may have been made after the index was built
   }
 
   string searchPath;
@@ -569,15 +1117,7 @@ bool SessionImpl::FindPkFile(const string& fontName, const string& mfMode, int d
         searchPath += '%';
         break;
       case 'm':
-        if (!mfMode.empty())
-        {
-          searchPath += mfMode;
-        }
-        else
-        {
-          // FIXME: hardcoded METAFONT mode
-          searchPath += "ljfour";
-        }
+        searchPath += mode;
         break;
       case 'd':
         searchPath += std::to_string(dpi);
@@ -598,6 +1138,15 @@ bool SessionImpl::FindPkFile(const string& fontName, const string& mfMode, int d
   if (auto locateResult = Locate(pkFileName.ToString(), locateOptions); !locateResult.pathNames.empty())
   {
     result = locateResult.pathNames[0];
+    if (useIndex && result.IsFullyQualified())
+    {
+      lock_guard<mutex> lockGuard(pkResolutionsMutex);
+      auto it = pkResolutions.find(pkFileName.ToString() + "\n" + mode);
+      if (it != pkResolutions.end())
+      {
+        it->second.emplace(dpi, result);
+      }
+    }
     return true;
   }
 
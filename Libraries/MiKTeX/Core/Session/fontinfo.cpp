@@ -53,6 +53,42 @@ MIKTEXSTATICFUNC(int) IsPrefixOf(const string& s1, const string& s2)
   return l1 <= s2.length() && strncmp(s1.c_str(), s2.c_str(), l1) == 0;
 }
 
+const SessionImpl::FontNameMap& SessionImpl::GetFontNameMap(const string& mapName)
+{
+  PathName path;
+  if (!FindFile(mapName, MAP_SEARCH_PATH, path))
+  {
+    MIKTEX_UNEXPECTED();
+  }
+
+  // the maps are consulted for every font which has to be made; they
+  // are read once and then re-read only when they have changed
+  time_t lastWriteTime = File::GetLastWriteTime(path);
+  FontNameMap& map = fontNameMaps[path.ToString()];
+  if (map.lastWriteTime == lastWriteTime && !map.lines.empty())
+  {
+    return map;
+  }
+  map.lastWriteTime = lastWriteTime;
+  map.lines.clear();
+
+  ifstream reader = File::CreateInputStream(path);
+  for (string line; std::getline(reader, line); )
+  {
+    vector<string> tokens;
+    for (Tokenizer tok(line, WHITESPACE); tok; ++tok)
+    {
+      tokens.push_back(*tok);
+    }
+    if (!tokens.empty())
+    {
+      map.lines.push_back(std::move(tokens));
+    }
+  }
+
+  return map;
+}
+
 MIKTEXSTATICFUNC(bool) SessionImpl::FindInTypefaceMap(const string& fontName, string& typeface)
 {
   const size_t FONT_ABBREV_LENGTH = 2;
@@ -65,27 +101,13 @@ MIKTEXSTATICFUNC(bool) SessionImpl::FindInTypefaceMap(const string& fontName, st
   // "ptmr8r" => "tm"
   string fontAbbrev = fontName.substr(1, FONT_ABBREV_LENGTH);
 
-  PathName typefaceMap;
-  if (!FindFile("typeface.map", MAP_SEARCH_PATH, typefaceMap))
-  {
-    MIKTEX_UNEXPECTED();
-  }
-
-  ifstream reader = File::CreateInputStream(typefaceMap);  
-  
-  for (string line; std::getline(reader, line); )
+  for (const vector<string>& tokens : GetFontNameMap("typeface.map").lines)
   {
-    Tokenizer tok(line, WHITESPACE);
-    if (!tok || fontAbbrev != *tok)
+    if (tokens.size() < 2 || fontAbbrev != tokens[0])
     {
       continue;
     }
-    ++tok;
-    if (!tok)
-    {
-      continue;
-    }
-    typeface = *tok;
+    typeface = tokens[1];
     trace_fonts->WriteLine("core", fmt::format(T_("found {0} in typeface.map"), Q_(typeface)));
     return true;
   }
@@ -105,30 +127,17 @@ bool SessionImpl::FindInSupplierMap(const string& fontName, string& supplier, st
   // "ptmr8r" => "p"
   string supplierAbbrev = fontName.substr(0, SUPPLIER_ABBREV_LENGTH);
 
-  PathName supplierMap;
-  if (!FindFile("supplier.map", MAP_SEARCH_PATH, supplierMap))
-  {
-    MIKTEX_UNEXPECTED();
-  }
-
-  ifstream reader = File::CreateInputStream(supplierMap);
-
   bool found = false;
-  for (string line; !found && std::getline(reader, line); )
+  for (const vector<string>& tokens : GetFontNameMap("supplier.map").lines)
   {
-    Tokenizer tok(line, WHITESPACE);
-    if (!tok || supplierAbbrev != *tok)
-    {
-      continue;
-    }
-    ++tok;
-    if (!tok)
+    if (tokens.size() < 2 || supplierAbbrev != tokens[0])
     {
       continue;
     }
-    supplier = *tok;
+    supplier = tokens[1];
     trace_fonts->WriteLine("core", fmt::format(T_("found {0} in supplier.map"), Q_(supplier)));
     found = true;
+    break;
   }
 
   return found && FindInTypefaceMap(fontName, typeface);
@@ -142,38 +151,21 @@ char GetLastChar(const string& s)
 
 bool SessionImpl::FindInSpecialMap(const string& fontName, string& supplier, string& typeface)
 {
-  PathName specialMap;
-  if (!FindFile("special.map", MAP_SEARCH_PATH, specialMap))
+  for (const vector<string>& tokens : GetFontNameMap("special.map").lines)
   {
-    MIKTEX_UNEXPECTED();
-  }
-
-  ifstream reader = File::CreateInputStream(specialMap);
-
-  bool found = false;
-  for (string line; !found && std::getline(reader, line); )
-  {
-    Tokenizer tok(line, WHITESPACE);
-    if (!tok
-      || !(fontName == *tok
-        || (IsPrefixOf(*tok, fontName)
+    if (!(fontName == tokens[0]
+        || (IsPrefixOf(tokens[0], fontName)
           && (IsDecimalDigitAscii(GetLastChar(fontName)))
-          && (!IsDecimalDigitAscii(GetLastChar(*tok))))))
+          && (!IsDecimalDigitAscii(GetLastChar(tokens[0]))))))
     {
       continue;
     }
-    ++tok;
-    if (!tok)
+    if (tokens.size() < 3)
     {
       continue;
     }
-    supplier = *tok;
-    ++tok;
-    if (!tok)
-    {
-      continue;
-    }
-    typeface = *tok;
+    supplier = tokens[1];
+    typeface = tokens[2];
     trace_fonts->WriteLine("core", fmt::format(T_("found {0}/{1} in special.map"), Q_(supplier), Q_(typeface)));
     return true;
   }
@@ -183,6 +175,12 @@ bool SessionImpl::FindInSpecialMap(const string& fontName, string& supplier, str
 
 bool SessionImpl::InternalGetFontInfo(const string& fontName, string& supplier, string& typeface)
 {
+  SessionServiceClient* sessionServiceClient = GetSessionServiceClient();
+  bool haveInfo;
+  if (sessionServiceClient != nullptr && sessionServiceClient->TryGetFontInfo(fontName, haveInfo, supplier, typeface))
+  {
+    return haveInfo;
+  }
   return FindInSpecialMap(fontName, supplier, typeface) || FindInSupplierMap(fontName, supplier, typeface);
 }
 
@@ -27,6 +27,7 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "Session/TableCache.h"
 
 using namespace std;
 
@@ -162,10 +163,64 @@ void SessionImpl::ReadFormatsIni()
   {
     MIKTEX_FATAL_ERROR(T_("The configuration file formats.ini could not be found."));
   }
+  TableCache cache(GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FORMATS_CACHE, "miktex-formats-cache-1");
+  string data;
+  if (cache.TryRead(iniFiles, data))
+  {
+    try
+    {
+      unsigned distRoot = GetInstallRoot();
+      TableReader tableReader(data);
+      for (int64_t count = tableReader.GetInt(); count > 0; --count)
+      {
+        FormatInfo_ formatInfo;
+        formatInfo.cfgFile = tableReader.GetString();
+        formatInfo.key = tableReader.GetString();
+        formatInfo.name = tableReader.GetString();
+        formatInfo.description = tableReader.GetString();
+        formatInfo.compiler = tableReader.GetString();
+        formatInfo.inputFile = tableReader.GetString();
+        formatInfo.outputFile = tableReader.GetString();
+        formatInfo.preloaded = tableReader.GetString();
+        formatInfo.exclude = tableReader.GetInt() != 0;
+        formatInfo.noExecutable = tableReader.GetInt() != 0;
+        formatInfo.arguments = tableReader.GetStringVector();
+        // depends on the root configuration, not on formats.ini
+        formatInfo.custom = distRoot != INVALID_ROOT_INDEX && DeriveTEXMFRoot(formatInfo.cfgFile) != distRoot;
+        formats.push_back(formatInfo);
+      }
+      if (!tableReader.AtEnd())
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      return;
+    }
+    catch (const MiKTeXException&)
+    {
+      formats.clear();
+    }
+  }
   for (vector<PathName>::const_reverse_iterator it = iniFiles.rbegin(); it != iniFiles.rend(); ++it)
   {
     ReadFormatsIni(*it);
   }
+  TableWriter tableWriter;
+  tableWriter.Put(static_cast<int64_t>(formats.size()));
+  for (const FormatInfo_& formatInfo : formats)
+  {
+    tableWriter.Put(formatInfo.cfgFile.ToString());
+    tableWriter.Put(formatInfo.key);
+    tableWriter.Put(formatInfo.name);
+    tableWriter.Put(formatInfo.description);
+    tableWriter.Put(formatInfo.compiler);
+    tableWriter.Put(formatInfo.inputFile);
+    tableWriter.Put(formatInfo.outputFile);
+    tableWriter.Put(formatInfo.preloaded);
+    tableWriter.Put(static_cast<int64_t>(formatInfo.exclude ? 1 : 0));
+    tableWriter.Put(static_cast<int64_t>(formatInfo.noExecutable ? 1 : 0));
+    tableWriter.Put(formatInfo.arguments);
+  }
+  cache.Write(iniFiles, tableWriter.GetData());
 }
 
 void SessionImpl::WriteFormatsIni()
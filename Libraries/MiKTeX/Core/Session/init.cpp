@@ -46,7 +46,9 @@ extern char** environ;
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/Environment>
 #include <miktex/Core/Paths>
+#include <miktex/Core/Process>
 #include <miktex/Core/TemporaryDirectory>
+#include <miktex/Trace/TraceRecorder>
 
 #include "internal.h"
 
@@ -63,6 +65,10 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
+// number of trace messages kept in memory by the trace recorder (512 bytes
+// per message)
+const size_t traceRecorderCapacity = 4096;
+
 weak_ptr<SessionImpl> SessionImpl::theSession;
 
 shared_ptr<Session> Session::Create(const Session::InitInfo& initInfo)
@@ -126,6 +132,8 @@ SessionImpl::~SessionImpl()
 
 void SessionImpl::Initialize(const Session::InitInfo& initInfo)
 {
+  BuildTrace::Clock::time_point initStart = BuildTrace::Clock::now();
+
   adminMode = initInfo.GetOptions()[InitOption::AdminMode];
   if (!adminMode)
   {
@@ -143,6 +151,11 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
 
   initialized = true;
 
+  if (Utils::GetEnvironmentString(MIKTEX_ENV_BUILD_TRACE_FILE, buildTraceFile) && !buildTraceFile.empty())
+  {
+    buildTrace = make_unique<BuildTrace>();
+  }
+
   fsWatcher = FileSystemWatcher::Create();
   fsWatcher->Start();
 
@@ -173,12 +186,27 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
     TraceStream::SetOptions(traceOptions);
   }
 
+  // record trace messages in memory; the recorded messages are dumped into
+  // the given directory when the process exits
+  string traceRecorderDirectory;
+  if (Utils::GetEnvironmentString(MIKTEX_ENV_TRACE_RECORDER_DIR, traceRecorderDirectory) && !traceRecorderDirectory.empty())
+  {
+    PathName dumpFile(traceRecorderDirectory);
+    dumpFile /= fmt::format("{0}-{1}.mtrace", Utils::GetExeName(), Process::GetCurrentProcess()->GetSystemId());
+    TraceRecorder::Start(dumpFile.ToString(), TraceLevel::Trace, traceRecorderCapacity);
+  }
+
   InitializeStartupConfig();
 
   InitializeRootDirectories(initStartupConfig, false);
 
   Utils::GetEnvironmentString(MIKTEX_ENV_PACKAGE_LIST_FILE, packageHistoryFile);
 
+  if (Utils::GetEnvironmentString(MIKTEX_ENV_IO_REPORT_FILE, ioReportFile) && !ioReportFile.empty())
+  {
+    ioStatistics = make_unique<IOStatistics>();
+  }
+
   PushAppName(Utils::GetExeName());
 
   startDirectory.SetToCurrentDirectory();
@@ -221,6 +249,13 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
     }
   }
 #endif
+
+  sessionServiceAllowed = true;
+
+  if (buildTrace != nullptr)
+  {
+    buildTrace->AddSpan("session", "initialize", initStart, BuildTrace::Clock::now());
+  }
 }
 
 void SessionImpl::RecordMaintenance()
@@ -247,20 +282,62 @@ void SessionImpl::Close()
   StartFinishScript(10);
   initialized = false;
   trace_core->WriteLine("core", T_("uninitializing core library"));
+  findFileMissCache = nullptr;
+  findFileCache = nullptr;
+  findFileCacheInitialized = false;
+  directoryIndex = nullptr;
+  configValueCache = nullptr;
+  expansionCache = nullptr;
+  ResetSessionServiceClient();
   if (fsWatcher != nullptr)
   {
     fsWatcher->Stop();
     fsWatcher = nullptr;
   }
   CheckOpenFiles();
+  try
+  {
+    FlushFileInfoRecorder();
+  }
+  catch (const exception& e)
+  {
+    trace_error->WriteLine("core", TraceLevel::Error, fmt::format("file name recorder log file could not be written: {0}", e.what()));
+  }
   WritePackageHistory();
+  WriteIOReport();
+  WriteBuildTrace();
   inputDirectories.clear();
   UnregisterLibraryTraceStreams();
   configurationSettings.clear();
 }
 
+void SessionImpl::BeforeFork()
+{
+  if (fsWatcher != nullptr)
+  {
+    fsWatcher->Stop();
+  }
+}
+
+void SessionImpl::AfterFork(bool child)
+{
+  if (child)
+  {
+    // the inotify/fanotify descriptors are shared with the parent: reading
+    // them would steal the parent's events; the connection to the session
+    // service is shared, too
+    ResetSessionServiceClient();
+    return;
+  }
+  if (fsWatcher != nullptr)
+  {
+    fsWatcher->Start();
+  }
+}
+
 void SessionImpl::ScheduleSystemCommand(const std::string& commandLine)
 {
+  lock_guard<mutex> lockGuard(onFinishScriptMutex);
   onFinishScript.push_back(commandLine);
 }
 
@@ -28,6 +28,7 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "Session/TableCache.h"
 #include "Utils/inliners.h"
 
 using namespace std;
@@ -52,6 +53,36 @@ void SessionImpl::ReadMetafontModes()
     MIKTEX_FATAL_ERROR(T_("METAFONT modes cannot be initialized because 'modes.mf' is missing."));
   }
 
+  // modes.mf is big; parsing it is a noticeable part of a short-lived
+  // process
+  TableCache cache(GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_MFMODES_CACHE, "miktex-mfmodes-cache-1");
+  string data;
+  if (cache.TryRead({ path }, data))
+  {
+    try
+    {
+      TableReader tableReader(data);
+      for (int64_t count = tableReader.GetInt(); count > 0; --count)
+      {
+        MIKTEXMFMODE mfmode;
+        mfmode.mnemonic = tableReader.GetString();
+        mfmode.description = tableReader.GetString();
+        mfmode.horizontalResolution = static_cast<int>(tableReader.GetInt());
+        mfmode.verticalResolution = static_cast<int>(tableReader.GetInt());
+        metafontModes.push_back(mfmode);
+      }
+      if (!tableReader.AtEnd())
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      return;
+    }
+    catch (const MiKTeXException&)
+    {
+      metafontModes.clear();
+    }
+  }
+
   ifstream reader = File::CreateInputStream(path);
 
   bool readingModeDef = false;
@@ -126,6 +157,17 @@ void SessionImpl::ReadMetafontModes()
   }
 
   sort(metafontModes.begin(), metafontModes.end(), ModeComparer());
+
+  TableWriter tableWriter;
+  tableWriter.Put(static_cast<int64_t>(metafontModes.size()));
+  for (const MIKTEXMFMODE& mode : metafontModes)
+  {
+    tableWriter.Put(mode.mnemonic);
+    tableWriter.Put(mode.description);
+    tableWriter.Put(static_cast<int64_t>(mode.horizontalResolution));
+    tableWriter.Put(static_cast<int64_t>(mode.verticalResolution));
+  }
+  cache.Write({ path }, tableWriter.GetData());
 }
 
 bool SessionImpl::GetMETAFONTMode(unsigned idx, MIKTEXMFMODE& mode)
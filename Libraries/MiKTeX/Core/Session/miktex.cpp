@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <atomic>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -572,6 +574,19 @@ MiKTeXUserInfo SessionImpl::RegisterMiKTeXUser(const MiKTeXUserInfo& info)
 }
 #endif
 
+// incremented whenever the environment of the process is changed
+static atomic_uint environmentGeneration(0);
+
+MIKTEXINTERNALFUNC(unsigned) GetEnvironmentGeneration()
+{
+  return environmentGeneration;
+}
+
+MIKTEXINTERNALFUNC(void) OnEnvironmentChanged()
+{
+  environmentGeneration += 1;
+}
+
 MIKTEXINTERNALFUNC(bool) GetEnvironmentString(const string& name, string& value)
 {
 #if defined(MIKTEX_WINDOWS)
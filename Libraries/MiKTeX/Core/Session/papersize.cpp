@@ -32,6 +32,7 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "Session/TableCache.h"
 #include "Utils/inliners.h"
 
 using namespace std;
@@ -163,6 +164,34 @@ void SessionImpl::ReadDvipsPaperSizes()
   vector<PathName> configFiles;
   if (FindFile(MIKTEX_PATH_CONFIG_PS, MIKTEX_PATH_TEXMF_PLACEHOLDER, { FindFileOption::All }, configFiles))
   {
+    TableCache cache(GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_PAPERSIZES_CACHE, "miktex-papersizes-cache-1");
+    string data;
+    if (cache.TryRead(configFiles, data))
+    {
+      try
+      {
+        TableReader tableReader(data);
+        for (int64_t count = tableReader.GetInt(); count > 0; --count)
+        {
+          DvipsPaperSizeInfo paperSize;
+          paperSize.dvipsName = tableReader.GetString();
+          paperSize.name = tableReader.GetString();
+          paperSize.width = static_cast<int>(tableReader.GetInt());
+          paperSize.height = static_cast<int>(tableReader.GetInt());
+          paperSize.definition = tableReader.GetStringVector();
+          dvipsPaperSizes.push_back(paperSize);
+        }
+        if (!tableReader.AtEnd() || dvipsPaperSizes.empty())
+        {
+          MIKTEX_UNEXPECTED();
+        }
+        return;
+      }
+      catch (const MiKTeXException&)
+      {
+        dvipsPaperSizes.clear();
+      }
+    }
     for (vector<PathName>::const_reverse_iterator it = configFiles.rbegin(); it != configFiles.rend(); ++it)
     {
       ifstream reader = File::CreateInputStream(*it);
@@ -237,6 +266,20 @@ void SessionImpl::ReadDvipsPaperSizes()
         AddDvipsPaperSize(current);
       }
     }
+    TableWriter tableWriter;
+    tableWriter.Put(static_cast<int64_t>(dvipsPaperSizes.size()));
+    for (const DvipsPaperSizeInfo& paperSize : dvipsPaperSizes)
+    {
+      tableWriter.Put(paperSize.dvipsName);
+      tableWriter.Put(paperSize.name);
+      tableWriter.Put(static_cast<int64_t>(paperSize.width));
+      tableWriter.Put(static_cast<int64_t>(paperSize.height));
+      tableWriter.Put(paperSize.definition);
+    }
+    if (!dvipsPaperSizes.empty())
+    {
+      cache.Write(configFiles, tableWriter.GetData());
+    }
   }
   if (dvipsPaperSizes.empty())
   {
@@ -38,6 +38,10 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
+namespace {
+  mutex searchPathMutex;
+}
+
 void SessionImpl::ExpandRootDirectories(const string& toBeExpanded, vector<PathName>& pathNames)
 {
   if (toBeExpanded.length() >= 2 && toBeExpanded[0] == '%' && (toBeExpanded[1] == 'R' || toBeExpanded[1] == 'r'))
@@ -178,35 +182,108 @@ void SessionImpl::TraceDirectoryPatterns(const std::string& fileType, const vect
   }
 }
 
-vector<PathName> SessionImpl::GetDirectoryPatterns(FileType fileType)
+shared_ptr<const CompiledSearchPath> SessionImpl::CompileSearchPath(const vector<PathName>& pathNames)
+{
+  vector<CompiledPathPattern> patterns;
+  patterns.reserve(pathNames.size());
+  for (const PathName& path : pathNames)
+  {
+    CompiledPathPattern pattern;
+    pattern.path = path;
+    pattern.isMpm = IsMpmFile(path.GetData());
+    if (path.IsFullyQualified())
+    {
+      pattern.rootIndex = TryDeriveTEXMFRoot(path);
+    }
+    if (pattern.rootIndex != INVALID_ROOT_INDEX)
+    {
+      pattern.rootDirectory = rootDirectories[pattern.rootIndex].get_Path();
+      const char* relativePath = Utils::GetRelativizedPath(path.GetData(), pattern.rootDirectory.GetData());
+      if (relativePath != nullptr)
+      {
+        pattern.comparableRelativePath = PathName(relativePath).TransformForComparison().ToString();
+      }
+      else
+      {
+        pattern.rootDirectory.Clear();
+      }
+    }
+    patterns.push_back(std::move(pattern));
+  }
+  return make_shared<const CompiledSearchPath>(std::move(patterns));
+}
+
+shared_ptr<const CompiledSearchPath> SessionImpl::GetDirectoryPatterns(FileType fileType)
 {
   InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
-  if (fti->pathPatterns.empty())
   {
-    for (const string& env : fti->envVarNames)
+    lock_guard<mutex> lockGuard(searchPathMutex);
+    if (fti->compiledSearchPath != nullptr)
     {
-      string searchPath;
-      if (Utils::GetEnvironmentString(env, searchPath))
+      return fti->compiledSearchPath;
+    }
+  }
+  vector<PathName> pathPatterns;
+  for (const string& env : fti->envVarNames)
+  {
+    string searchPath;
+    if (Utils::GetEnvironmentString(env, searchPath))
+    {
+      for (const string& s : StringUtil::Split(searchPath, PathNameUtil::PathNameDelimiter))
       {
-        for (const string& s : StringUtil::Split(searchPath, PathNameUtil::PathNameDelimiter))
-        {
-          PushBackPath(fti->pathPatterns, PathName(s));
-        }
+        PushBackPath(pathPatterns, PathName(s));
       }
     }
-    for (const string& s : fti->searchPath)
+  }
+  for (const string& s : fti->searchPath)
+  {
+    PushBackPath(pathPatterns, PathName(s));
+  }
+  TraceDirectoryPatterns(fti->fileTypeString, pathPatterns);
+  shared_ptr<const CompiledSearchPath> compiledSearchPath = CompileSearchPath(pathPatterns);
+  lock_guard<mutex> lockGuard(searchPathMutex);
+  if (fti->compiledSearchPath == nullptr)
+  {
+    fti->compiledSearchPath = compiledSearchPath;
+  }
+  return fti->compiledSearchPath;
+}
+
+shared_ptr<const CompiledSearchPath> SessionImpl::GetCompiledSearchPath(const string& searchPath)
+{
+  {
+    lock_guard<mutex> lockGuard(searchPathMutex);
+    auto it = compiledSearchPaths.find(searchPath);
+    if (it != compiledSearchPaths.end())
     {
-      PushBackPath(fti->pathPatterns, PathName(s));
+      return it->second;
     }
-    TraceDirectoryPatterns(fti->fileTypeString, fti->pathPatterns);
   }
-  return fti->pathPatterns;
+  shared_ptr<const CompiledSearchPath> compiledSearchPath = CompileSearchPath(SplitSearchPath(searchPath));
+  lock_guard<mutex> lockGuard(searchPathMutex);
+  if (compiledSearchPaths.size() >= MAX_COMPILED_SEARCH_PATHS)
+  {
+    // programs which make up search paths on the fly
+    compiledSearchPaths.clear();
+  }
+  compiledSearchPaths[searchPath] = compiledSearchPath;
+  return compiledSearchPath;
+}
+
+void SessionImpl::ClearCompiledSearchPaths()
+{
+  lock_guard<mutex> lockGuard(searchPathMutex);
+  for (InternalFileTypeInfo& info : fileTypes)
+  {
+    info.compiledSearchPath = nullptr;
+  }
+  compiledSearchPaths.clear();
 }
 
 string SessionImpl::GetExpandedSearchPath(FileType fileType)
 {
   MIKTEX_ASSERT(fileType != FileType::None);
-  return MakeSearchPath(GetDirectoryPatterns(fileType));
+  return GetDirectoryPatterns(fileType)->GetSearchPath();
 }
 
 void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathPattern, vector<PathName>& paths)
@@ -219,17 +296,17 @@ void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathP
   {
     ExpandPathPattern(directory, pathPattern, paths);
   }
-  unique_ptr<DirectoryLister> dirLister = DirectoryLister::Open(directory, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
-  DirectoryEntry entry;
+  DirectoryListing listing;
+  DirectoryLister::ReadAll(directory, (int)DirectoryLister::Options::DirectoriesOnly, listing);
   vector<PathName> subdirs;
-  while (dirLister->GetNext(entry))
+  subdirs.reserve(listing.GetCount());
+  for (size_t idx = 0; idx < listing.GetCount(); ++idx)
   {
-    MIKTEX_ASSERT(entry.isDirectory);
+    MIKTEX_ASSERT(listing.IsDirectory(idx));
     PathName subdir(directory);
-    subdir /= entry.name;
-    subdirs.push_back(subdir);
+    subdir /= listing.GetName(idx);
+    subdirs.push_back(std::move(subdir));
   }
-  dirLister->Close();
   // TODO: async?
   for (const PathName& subdir : subdirs)
   {
@@ -254,7 +331,7 @@ void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathNam
     directory /= pathPattern.ToString();
     if (!IsMpmFile(directory.GetData()) && Directory::Exists(directory))
     {
-      paths.push_back(directory);
+      paths.push_back(std::move(directory));
     }
   }
   else
@@ -288,8 +365,8 @@ vector<PathName> SessionImpl::ExpandPathPatterns(const string& toBeExpanded)
     {
       vector<PathName> paths2;
       ExpandPathPattern(PathName(), pattern, paths2);
-      expandedPathPatterns[comparablePathPattern.GetData()] = paths2;
       pathNames.insert(pathNames.end(), paths2.begin(), paths2.end());
+      expandedPathPatterns[comparablePathPattern.GetData()] = std::move(paths2);
     }
     else
     {
@@ -318,10 +395,10 @@ inline void Combine(vector<PathName>& pathNames, const vector<PathName>& toBeApp
     {
       PathName path(p1);
       path.Append(p2.GetData(), false);
-      result.push_back(path);
+      result.push_back(std::move(path));
     }
   }
-  pathNames = result;
+  pathNames = std::move(result);
 }
 
 inline void Combine(vector<PathName>& paths, const string& path)
@@ -354,7 +431,7 @@ inline vector<PathName> ExpandBracesHelper(const char*& lpszToBeExpanded)
     {
       Combine(subtotal, str);
       str = "";
-      result.insert(result.end(), subtotal.begin(), subtotal.end());
+      result.insert(result.end(), make_move_iterator(subtotal.begin()), make_move_iterator(subtotal.end()));
       subtotal.clear();
     }
     else
@@ -363,7 +440,7 @@ inline vector<PathName> ExpandBracesHelper(const char*& lpszToBeExpanded)
     }
   }
   Combine(subtotal, str);
-  result.insert(result.end(), subtotal.begin(), subtotal.end());
+  result.insert(result.end(), make_move_iterator(subtotal.begin()), make_move_iterator(subtotal.end()));
   return result;
 }
 
@@ -394,7 +471,7 @@ void SessionImpl::ExpandBraces(const string& toBeExpanded, vector<PathName>& pat
     }
   }
   Combine(result, str);
-  pathNames.insert(pathNames.end(), result.begin(), result.end());
+  pathNames.insert(pathNames.end(), make_move_iterator(result.begin()), make_move_iterator(result.end()));
 }
 
 vector<PathName> SessionImpl::ExpandBraces(const string& toBeExpanded)
@@ -0,0 +1,240 @@
+/**
+ * @file sessionservice.cpp
+ * @author Christian Schenk
+ * @brief Handing over lookups to the session service
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#if defined(MIKTEX_UNIX)
+#  include <unistd.h>
+extern char** environ;
+#endif
+
+#if defined(MIKTEX_MACOS_BUNDLE)
+#  include <crt_externs.h>
+#  define environ (*_NSGetEnviron ())
+#endif
+
+#include <algorithm>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/AutoResource>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+#include "SessionService/SessionServiceClient.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+// the environment variables which can override configuration values
+string SessionImpl::GetSessionServiceEnvironment()
+{
+    vector<string> variables;
+#if defined(MIKTEX_WINDOWS)
+    auto environmentStrings = GetEnvironmentStringsW();
+    MIKTEX_AUTO(FreeEnvironmentStringsW(environmentStrings));
+    for (const wchar_t* env = environmentStrings; *env != 0; env += wcslen(env) + 1)
+    {
+        string variable = WU_(env);
+        // variable names are case-insensitive
+        size_t pos = variable.find('=', 1);
+        transform(variable.begin(), pos == string::npos ? variable.end() : variable.begin() + pos, variable.begin(), [](char ch) { return ToUpperAscii(ch); });
+        if (variable.compare(0, strlen(MIKTEX_ENV_PREFIX_), MIKTEX_ENV_PREFIX_) == 0)
+        {
+            variables.push_back(variable);
+        }
+    }
+#else
+    for (char** env = environ; *env != nullptr; ++env)
+    {
+        if (strncmp(*env, MIKTEX_ENV_PREFIX_, strlen(MIKTEX_ENV_PREFIX_)) == 0)
+        {
+            variables.push_back(*env);
+        }
+    }
+#endif
+    sort(variables.begin(), variables.end());
+    MD5Builder md5Builder;
+    for (const string& variable : variables)
+    {
+        md5Builder.Update(variable.c_str(), variable.length() + 1);
+    }
+    md5Builder.Final();
+    return md5Builder.GetMD5().ToString();
+}
+
+SessionServiceClient* SessionImpl::GetSessionServiceClient()
+{
+    if (sessionServiceInitialized)
+    {
+        if (sessionServiceClient != nullptr && sessionServiceClient->NeedsRevalidation(GetEnvironmentGeneration()))
+        {
+            // computing the handshake values can come back here: the client
+            // is out of the game until it is revalidated
+            unique_ptr<SessionServiceClient> client = std::move(sessionServiceClient);
+            if (client->Revalidate(GetFindFileCacheGeneration(), GetSessionServiceEnvironment()))
+            {
+                sessionServiceClient = std::move(client);
+            }
+        }
+        return sessionServiceClient.get();
+    }
+    // must be set first: GetConfigValue() comes back here
+    sessionServiceInitialized = true;
+    if (!sessionServiceAllowed
+        || servingSessionRequests
+        || IsAdminMode()
+        || !GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_USE_SESSION_SERVICE, ConfigValue(true)).GetBool())
+    {
+        return nullptr;
+    }
+    try
+    {
+        sessionServiceClient = SessionServiceClient::TryConnect(GetSpecialPath(SpecialPath::UserDataRoot) / MIKTEX_PATH_SESSION_SERVICE_ENDPOINT, GetFindFileCacheGeneration(), GetSessionServiceEnvironment());
+    }
+    catch (const exception& e)
+    {
+        trace_core->WriteLine("core", TraceLevel::Warning, fmt::format(T_("session service cannot be used: {0}"), e.what()));
+    }
+    return sessionServiceClient.get();
+}
+
+void SessionImpl::ResetSessionServiceClient()
+{
+    sessionServiceClient = nullptr;
+    sessionServiceInitialized = false;
+}
+
+void SessionImpl::BeginServingSessionRequests()
+{
+    ResetSessionServiceClient();
+    servingSessionRequests = true;
+    // missing packages are installed by the sessions
+    findFileCallback = nullptr;
+    servedGeneration = GetFindFileCacheGeneration();
+}
+
+string SessionImpl::ServeSessionRequest(const string& request)
+{
+    vector<string> fields = SessionServiceChannel::SplitFields(request);
+    try
+    {
+        if (fields[0] == "hello" && fields.size() == 4)
+        {
+            if (fields[1] != SESSION_SERVICE_PROTOCOL)
+            {
+                return SessionServiceChannel::JoinFields({ "error", T_("unsupported protocol") });
+            }
+            // catch up with FNDB updates and configuration changes
+            string generation = GetFindFileCacheGeneration();
+            if (generation != servedGeneration)
+            {
+                trace_core->WriteLine("core", T_("session service: reloading the file name databases and the configuration files"));
+                configurationSettings.clear();
+                InvalidateConfigValueCache();
+                UnloadFilenameDatabase();
+                {
+                    lock_guard<mutex> lockGuard(pkResolutionsMutex);
+                    pkResolutions.clear();
+                }
+                InvalidateFindFileMissCache();
+                servedGeneration = generation;
+            }
+            return SessionServiceChannel::JoinFields({ "ok", fields[2] == servedGeneration ? "1" : "0", fields[3] == GetSessionServiceEnvironment() ? "1" : "0" });
+        }
+        else if (fields[0] == "findfile" && fields.size() == 5)
+        {
+            int fileTypeValue = std::stoi(fields[1]);
+            if (fileTypeValue <= static_cast<int>(FileType::None) || fileTypeValue >= static_cast<int>(FileType::E_N_D))
+            {
+                return SessionServiceChannel::JoinFields({ "error", T_("invalid file type") });
+            }
+            FileType fileType = static_cast<FileType>(fileTypeValue);
+            bool searchFileSystem = fields[3] == "1";
+            const string& fileName = fields[4];
+            InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
+            shared_ptr<const CompiledSearchPath> searchPath = GetDirectoryPatterns(fileType);
+            const vector<PathName>& pathPatterns = searchPath->GetPathNames();
+            // the session must be searching the same path
+            if (!PrepareFindFileCache(*fti, pathPatterns) || fti->findFileCacheKey != fields[2])
+            {
+                return "unknown";
+            }
+            vector<PathName> result;
+            if (FindFileByType(fileName, fileType, false, searchFileSystem, false, false, result, nullptr))
+            {
+                // only FNDB results are valid for other processes
+                unsigned r = TryDeriveTEXMFRoot(result[0]);
+                PathName fndbPath;
+                if (r != INVALID_ROOT_INDEX && r != GetNumberOfTEXMFRoots() && FindFilenameDatabase(r, fndbPath))
+                {
+                    return SessionServiceChannel::JoinFields({ "found", result[0].ToString() });
+                }
+                return "unknown";
+            }
+            return IsKnownToPackageManager(pathPatterns, GetFileNamesToTry(fileName, *fti)) ? "unknown" : "missing";
+        }
+        else if (fields[0] == "config" && fields.size() == 4)
+        {
+            string oldApplicationNames = applicationNames;
+            applicationNames = fields[1];
+            string value;
+            bool haveValue;
+            try
+            {
+                haveValue = GetResolvedConfigValue(fields[2], fields[3], value);
+            }
+            catch (const exception&)
+            {
+                applicationNames = oldApplicationNames;
+                throw;
+            }
+            applicationNames = oldApplicationNames;
+            return haveValue ? SessionServiceChannel::JoinFields({ "value", value }) : "undefined";
+        }
+        else if (fields[0] == "pk" && fields.size() == 3)
+        {
+            vector<string> reply{ "resolutions" };
+            for (const auto& p : GetPkResolutions(PathName(fields[1]), fields[2]))
+            {
+                reply.push_back(std::to_string(p.first));
+                reply.push_back(p.second.ToString());
+            }
+            return SessionServiceChannel::JoinFields(reply);
+        }
+        else if (fields[0] == "fontinfo" && fields.size() == 2)
+        {
+            string supplier;
+            string typeface;
+            if (InternalGetFontInfo(fields[1], supplier, typeface))
+            {
+                return SessionServiceChannel::JoinFields({ "fontinfo", supplier, typeface });
+            }
+            return "undefined";
+        }
+        return SessionServiceChannel::JoinFields({ "error", T_("unknown request") });
+    }
+    catch (const exception& e)
+    {
+        return SessionServiceChannel::JoinFields({ "error", e.what() });
+    }
+}
@@ -132,6 +132,10 @@ unsigned SessionImpl::RegisterRootDirectory(const PathName& root, RootDirectoryI
 
 void SessionImpl::InitializeRootDirectories(const InternalStartupConfig& startupConfig, bool review)
 {
+    ResetSessionServiceClient();
+    // configuration files live in the root directories
+    InvalidateConfigValueCache();
+
     rootDirectories.clear();
 
     commonInstallRootIndex = INVALID_ROOT_INDEX;
@@ -264,7 +268,15 @@ void SessionImpl::InitializeRootDirectories(const InternalStartupConfig& startup
         }
     }
 
-    RegisterRootDirectory(PathName(MPM_ROOT_PATH), RootDirectoryInfo::Purpose::Generic, IsAdminMode() ? ConfigurationScope::Common : ConfigurationScope::User, false, false);
+    // the file name database of a snapshot's package set is part of the
+    // snapshot: users must not generate their own
+    bool commonMpmRoot = IsAdminMode() || !startupConfig.snapshotVersion.empty();
+    RegisterRootDirectory(PathName(MPM_ROOT_PATH), RootDirectoryInfo::Purpose::Generic, commonMpmRoot ? ConfigurationScope::Common : ConfigurationScope::User, false, false);
+
+    if (!startupConfig.snapshotVersion.empty())
+    {
+        trace_config->WriteLine("core", fmt::format(T_("installation snapshot: {0}"), startupConfig.snapshotVersion));
+    }
 
     if (!IsAdminMode())
     {
@@ -716,6 +728,10 @@ bool SessionImpl::IsTeXMFReadOnly(unsigned r)
     {
         return true;
     }
+    if (IsSnapshotRoot(r))
+    {
+        return true;
+    }
     if (IsMiKTeXPortable())
     {
         return false;
@@ -725,6 +741,12 @@ bool SessionImpl::IsTeXMFReadOnly(unsigned r)
             || (rootDirectories[r].IsCommon() && !IsAdminMode()));
 }
 
+bool SessionImpl::IsSnapshotRoot(unsigned r)
+{
+    // a snapshot is immutable, even for the administrator
+    return !initStartupConfig.snapshotVersion.empty() && rootDirectories[r].IsCommon();
+}
+
 bool SessionImpl::FindFilenameDatabase(unsigned r, PathName& path)
 {
     if (!(r < GetNumberOfTEXMFRoots() || r == MPM_ROOT))
@@ -824,7 +846,7 @@ shared_ptr<FileNameDatabase> SessionImpl::GetFileNameDatabase(unsigned r)
         INVALID_ARGUMENT("index", std::to_string(r));
     }
 
-    lock_guard<mutex> lockGuard(fndbMutex);
+    unique_lock<mutex> lockGuard(fndbMutex);
 
     RootDirectoryInternals& root = rootDirectories[r];
 
@@ -857,9 +879,35 @@ shared_ptr<FileNameDatabase> SessionImpl::GetFileNameDatabase(unsigned r)
 
     root.SetFndb(pFndb);
 
+    PathName rootPath = root.get_Path();
+
+    lockGuard.unlock();
+
+    // we had to replay a lot of change file entries: spare the processes to
+    // come (e.g., the engines of a parallel build) this effort
+    if (pFndb->NeedsPublishing() && r != MPM_ROOT && IsFndbWritable(r))
+    {
+        trace_fndb->WriteLine("core", fmt::format(T_("publishing the changes of fndb: {0}"), fqFndbFileName.ToDisplayString()));
+        CompactFileNameDatabase(fqFndbFileName, rootPath);
+    }
+
     return pFndb;
 }
 
+bool SessionImpl::IsFndbWritable(unsigned r)
+{
+    // the same rule as in Fndb::Refresh()
+    if (IsSnapshotRoot(r))
+    {
+        return false;
+    }
+    if (IsAdminMode())
+    {
+        return IsCommonRootDirectory(r);
+    }
+    return !IsCommonRootDirectory(r) || IsMiKTeXPortable();
+}
+
 shared_ptr<FileNameDatabase> SessionImpl::GetFileNameDatabase(const char* path)
 {
     unsigned root = TryDeriveTEXMFRoot(PathName(path));
@@ -473,6 +473,7 @@ void SessionImpl::ScheduleFileRemoval(const PathName& fileName)
 {
     string cmd = Directory::Exists(fileName) ? "rmdir /S /Q " : "del ";
     cmd += Q_(fileName.ToDos());
+    lock_guard<mutex> lockGuard(onFinishScriptMutex);
     onFinishScript.push_back(cmd);
 }
 
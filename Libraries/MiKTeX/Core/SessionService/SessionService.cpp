@@ -0,0 +1,129 @@
+/**
+ * @file SessionService/SessionService.cpp
+ * @author Christian Schenk
+ * @brief Per-user session service
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/LockFile>
+#include <miktex/Core/Paths>
+#include <miktex/Core/SessionService>
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+#include "SessionService/SessionServiceChannel.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    struct Connection
+    {
+        unique_ptr<SessionServiceChannel> channel;
+        atomic_bool done{ false };
+        thread worker;
+    };
+}
+
+void SessionService::Run(function<bool()> canceled)
+{
+    shared_ptr<SessionImpl> session = SESSION_IMPL();
+    if (session->IsAdminMode())
+    {
+        MIKTEX_FATAL_ERROR(T_("The session service cannot be run in administrator mode."));
+    }
+    unique_ptr<TraceStream> trace_core = TraceStream::Open(MIKTEX_TRACE_CORE);
+    PathName userDataRoot = session->GetSpecialPath(SpecialPath::UserDataRoot);
+    PathName lockPath = userDataRoot / MIKTEX_PATH_SESSION_SERVICE_LOCK;
+    Directory::Create(lockPath.GetDirectoryName());
+    unique_ptr<LockFile> lockFile = LockFile::Create(lockPath);
+    if (!lockFile->TryLock(0ms))
+    {
+        MIKTEX_FATAL_ERROR(T_("The session service is already running."));
+    }
+    session->BeginServingSessionRequests();
+    PathName endpoint = userDataRoot / MIKTEX_PATH_SESSION_SERVICE_ENDPOINT;
+    unique_ptr<SessionServiceListener> listener = SessionServiceListener::Create(endpoint);
+    trace_core->WriteLine("core", fmt::format(T_("serving sessions on {0}"), Q_(endpoint)));
+    // the session is not thread-safe: requests are served one at a time
+    std::mutex sessionMutex;
+    list<Connection> connections;
+    while (!canceled())
+    {
+        unique_ptr<SessionServiceChannel> channel = listener->Accept(200ms);
+        for (auto it = connections.begin(); it != connections.end(); )
+        {
+            if (it->done)
+            {
+                it->worker.join();
+                it = connections.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        if (channel == nullptr)
+        {
+            continue;
+        }
+        connections.emplace_back();
+        Connection& connection = connections.back();
+        connection.channel = std::move(channel);
+        connection.worker = thread([&connection, &session, &sessionMutex, &trace_core]()
+        {
+            try
+            {
+                string request;
+                while (connection.channel->ReadLine(request))
+                {
+                    string reply;
+                    {
+                        lock_guard<std::mutex> lockGuard(sessionMutex);
+                        reply = session->ServeSessionRequest(request);
+                    }
+                    connection.channel->WriteLine(reply);
+                }
+            }
+            catch (const exception& e)
+            {
+                trace_core->WriteLine("core", TraceLevel::Warning, fmt::format(T_("session service connection failed: {0}"), e.what()));
+            }
+            connection.done = true;
+        });
+    }
+    for (Connection& connection : connections)
+    {
+        connection.channel->Shutdown();
+    }
+    for (Connection& connection : connections)
+    {
+        connection.worker.join();
+    }
+    connections.clear();
+    listener = nullptr;
+    lockFile->Unlock();
+}
@@ -0,0 +1,74 @@
+/**
+ * @file SessionService/SessionServiceChannel.h
+ * @author Christian Schenk
+ * @brief Local IPC channel of the session service
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// A connection between a session and the session service.
+///
+/// Requests and replies are lines of tab-separated fields.  On Unix-alike
+/// systems, the channel is a Unix domain socket in the user's lock
+/// directory; on Windows, it is a named pipe, whose name is derived from
+/// the same path.
+class SessionServiceChannel
+{
+
+public:
+
+    virtual ~SessionServiceChannel() noexcept = default;
+
+    /// Reads the next line.
+    /// @param[out] line The line without the line terminator.
+    /// @return Returns `false`, if the peer has closed the channel.
+    virtual bool ReadLine(std::string& line) = 0;
+
+    virtual void WriteLine(const std::string& line) = 0;
+
+    /// Lets pending and future reads return `false`.
+    virtual void Shutdown() = 0;
+
+    /// Connects to the session service.
+    /// @param endpoint The path the channel name is derived from.
+    /// @param timeout How long to wait for a reply.
+    /// @return Returns `nullptr`, if the service is not running.
+    static std::unique_ptr<SessionServiceChannel> TryConnect(const MiKTeX::Util::PathName& endpoint, std::chrono::milliseconds timeout);
+
+    static std::string JoinFields(const std::vector<std::string>& fields);
+
+    static std::vector<std::string> SplitFields(const std::string& line);
+};
+
+/// The server side of the session service channels.
+class SessionServiceListener
+{
+
+public:
+
+    virtual ~SessionServiceListener() noexcept = default;
+
+    /// Waits for a session to connect.
+    /// @return Returns `nullptr`, if no session connected in time.
+    virtual std::unique_ptr<SessionServiceChannel> Accept(std::chrono::milliseconds timeout) = 0;
+
+    static std::unique_ptr<SessionServiceListener> Create(const MiKTeX::Util::PathName& endpoint);
+};
+
+CORE_INTERNAL_END_NAMESPACE;
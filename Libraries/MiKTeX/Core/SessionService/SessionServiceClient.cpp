@@ -0,0 +1,203 @@
+/**
+ * @file SessionService/SessionServiceClient.cpp
+ * @author Christian Schenk
+ * @brief Session side of the session service
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/File>
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "SessionService/SessionServiceClient.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+// a stuck service must not stall the session for long
+constexpr chrono::milliseconds REPLY_TIMEOUT = 5s;
+
+// FNDB updates and configuration file changes (they are part of the
+// generation) are noticed within this interval
+constexpr chrono::milliseconds VALIDATION_INTERVAL = 2s;
+
+SessionServiceClient::SessionServiceClient(unique_ptr<SessionServiceChannel> channel, unsigned environmentGeneration) :
+    channel(std::move(channel)),
+    environmentGeneration(environmentGeneration),
+    trace_core(TraceStream::Open(MIKTEX_TRACE_CORE))
+{
+}
+
+unique_ptr<SessionServiceClient> SessionServiceClient::TryConnect(const PathName& endpoint, const string& generation, const string& environment)
+{
+    unique_ptr<SessionServiceChannel> channel = SessionServiceChannel::TryConnect(endpoint, REPLY_TIMEOUT);
+    if (channel == nullptr)
+    {
+        return nullptr;
+    }
+    auto client = make_unique<SessionServiceClient>(std::move(channel), GetEnvironmentGeneration());
+    if (!client->Handshake(generation, environment))
+    {
+        return nullptr;
+    }
+    client->trace_core->WriteLine("core", fmt::format(T_("using the session service {0}"), Q_(endpoint)));
+    return client;
+}
+
+bool SessionServiceClient::NeedsRevalidation(unsigned environmentGeneration) const
+{
+    return environmentGeneration != this->environmentGeneration || chrono::steady_clock::now() - lastValidation > VALIDATION_INTERVAL;
+}
+
+bool SessionServiceClient::Revalidate(const string& generation, const string& environment)
+{
+    environmentGeneration = GetEnvironmentGeneration();
+    return Handshake(generation, environment);
+}
+
+bool SessionServiceClient::Handshake(const string& generation, const string& environment)
+{
+    vector<string> reply;
+    if (!Transact({ "hello", SESSION_SERVICE_PROTOCOL, generation, environment }, reply) || reply.size() != 3 || reply[0] != "ok")
+    {
+        broken = true;
+        return false;
+    }
+    if (reply[1] != "1")
+    {
+        trace_core->WriteLine("core", T_("the session service uses other file name databases"));
+        broken = true;
+        return false;
+    }
+    configDelegation = reply[2] == "1";
+    lastValidation = chrono::steady_clock::now();
+    return true;
+}
+
+bool SessionServiceClient::Transact(const vector<string>& request, vector<string>& reply)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    if (broken)
+    {
+        return false;
+    }
+    try
+    {
+        channel->WriteLine(SessionServiceChannel::JoinFields(request));
+        string line;
+        if (!channel->ReadLine(line))
+        {
+            MIKTEX_FATAL_ERROR(T_("The session service channel has been closed."));
+        }
+        reply = SessionServiceChannel::SplitFields(line);
+    }
+    catch (const exception& e)
+    {
+        trace_core->WriteLine("core", TraceLevel::Warning, fmt::format(T_("not using the session service anymore: {0}"), e.what()));
+        broken = true;
+        return false;
+    }
+    if (reply.empty())
+    {
+        broken = true;
+        return false;
+    }
+    if (reply[0] == "error")
+    {
+        trace_core->WriteLine("core", TraceLevel::Warning, fmt::format(T_("session service error: {0}"), reply.size() > 1 ? reply[1] : string()));
+        return false;
+    }
+    return true;
+}
+
+SessionServiceClient::FindFileResult SessionServiceClient::FindFile(FileType fileType, const string& searchKey, bool searchFileSystem, const string& fileName, PathName& path)
+{
+    vector<string> reply;
+    if (!Transact({ "findfile", std::to_string(static_cast<int>(fileType)), searchKey, searchFileSystem ? "1" : "0", fileName }, reply))
+    {
+        return FindFileResult::Unknown;
+    }
+    if (reply[0] == "found" && reply.size() == 2)
+    {
+        path = reply[1];
+        // the file may have been removed behind the back of the FNDB
+        return File::Exists(path) ? FindFileResult::Found : FindFileResult::Unknown;
+    }
+    if (reply[0] == "missing")
+    {
+        return FindFileResult::Missing;
+    }
+    return FindFileResult::Unknown;
+}
+
+bool SessionServiceClient::TryGetConfigValue(const string& applicationNames, const string& sectionName, const string& valueName, bool& haveValue, string& value)
+{
+    vector<string> reply;
+    if (!configDelegation || !Transact({ "config", applicationNames, sectionName, valueName }, reply))
+    {
+        return false;
+    }
+    if (reply[0] == "value" && reply.size() == 2)
+    {
+        haveValue = true;
+        value = reply[1];
+        return true;
+    }
+    if (reply[0] == "undefined")
+    {
+        haveValue = false;
+        return true;
+    }
+    return false;
+}
+
+bool SessionServiceClient::TryGetPkResolutions(const PathName& pkFileName, const string& mfMode, map<int, PathName>& resolutions)
+{
+    vector<string> reply;
+    if (!Transact({ "pk", pkFileName.ToString(), mfMode }, reply) || reply[0] != "resolutions" || reply.size() % 2 != 1)
+    {
+        return false;
+    }
+    for (size_t idx = 1; idx < reply.size(); idx += 2)
+    {
+        resolutions.emplace(std::stoi(reply[idx]), PathName(reply[idx + 1]));
+    }
+    return true;
+}
+
+bool SessionServiceClient::TryGetFontInfo(const string& fontName, bool& haveInfo, string& supplier, string& typeface)
+{
+    vector<string> reply;
+    if (!Transact({ "fontinfo", fontName }, reply))
+    {
+        return false;
+    }
+    if (reply[0] == "fontinfo" && reply.size() == 3)
+    {
+        haveInfo = true;
+        supplier = reply[1];
+        typeface = reply[2];
+        return true;
+    }
+    if (reply[0] == "undefined")
+    {
+        haveInfo = false;
+        return true;
+    }
+    return false;
+}
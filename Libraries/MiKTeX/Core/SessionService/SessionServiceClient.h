@@ -0,0 +1,103 @@
+/**
+ * @file SessionService/SessionServiceClient.h
+ * @author Christian Schenk
+ * @brief Session side of the session service
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Session>
+#include <miktex/Trace/TraceStream>
+#include <miktex/Util/PathName>
+
+#include "SessionService/SessionServiceChannel.h"
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+constexpr const char* SESSION_SERVICE_PROTOCOL = "miktex-session-1";
+
+/// Hands over lookups to the session service.
+///
+/// Answers are used only if they are exactly what the session would have
+/// found itself: the service must use the same file name databases
+/// (checked by the handshake) and the same search path (checked per
+/// request).  Configuration values are delegated only if the `MIKTEX_*`
+/// environment variables of both processes agree.  Any failure disables
+/// the client; the session then does the lookups itself.
+class SessionServiceClient
+{
+
+public:
+
+    enum class FindFileResult
+    {
+        Unknown,
+        Found,
+        Missing
+    };
+
+    /// Connects to the session service.
+    /// @param endpoint The channel path.
+    /// @param generation The FNDB generation of the session.
+    /// @param environment The fingerprint of the `MIKTEX_*` environment
+    /// variables.
+    /// @return Returns `nullptr`, if the service is not running or uses
+    /// other file name databases.
+    static std::unique_ptr<SessionServiceClient> TryConnect(const MiKTeX::Util::PathName& endpoint, const std::string& generation, const std::string& environment);
+
+    /// Repeats the handshake.
+    /// @return Returns `false`, if the client cannot be used anymore.
+    bool Revalidate(const std::string& generation, const std::string& environment);
+
+    /// Checks whether the last handshake is too old.
+    bool NeedsRevalidation(unsigned environmentGeneration) const;
+
+    FindFileResult FindFile(MiKTeX::Core::FileType fileType, const std::string& searchKey, bool searchFileSystem, const std::string& fileName, MiKTeX::Util::PathName& path);
+
+    /// @return Returns `false`, if the service cannot answer.
+    bool TryGetConfigValue(const std::string& applicationNames, const std::string& sectionName, const std::string& valueName, bool& haveValue, std::string& value);
+
+    /// @return Returns `false`, if the service cannot answer.
+    bool TryGetPkResolutions(const MiKTeX::Util::PathName& pkFileName, const std::string& mfMode, std::map<int, MiKTeX::Util::PathName>& resolutions);
+
+    /// @return Returns `false`, if the service cannot answer.
+    bool TryGetFontInfo(const std::string& fontName, bool& haveInfo, std::string& supplier, std::string& typeface);
+
+    SessionServiceClient(std::unique_ptr<SessionServiceChannel> channel, unsigned environmentGeneration);
+
+private:
+
+    bool Handshake(const std::string& generation, const std::string& environment);
+
+    bool Transact(const std::vector<std::string>& request, std::vector<std::string>& reply);
+
+    bool broken = false;
+
+    std::unique_ptr<SessionServiceChannel> channel;
+
+    bool configDelegation = false;
+
+    unsigned environmentGeneration;
+
+    std::chrono::steady_clock::time_point lastValidation;
+
+    std::mutex mutex;
+
+    std::unique_ptr<MiKTeX::Trace::TraceStream> trace_core;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,94 @@
+/**
+ * @file SessionService/SessionServiceFields.cpp
+ * @author Christian Schenk
+ * @brief Fields of the session service requests and replies
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include <string>
+#include <vector>
+
+#include "internal.h"
+
+#include "SessionService/SessionServiceChannel.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+string SessionServiceChannel::JoinFields(const vector<string>& fields)
+{
+    string line;
+    for (size_t idx = 0; idx < fields.size(); ++idx)
+    {
+        if (idx > 0)
+        {
+            line += '\t';
+        }
+        for (char ch : fields[idx])
+        {
+            switch (ch)
+            {
+            case '\\':
+                line += "\\\\";
+                break;
+            case '\t':
+                line += "\\t";
+                break;
+            case '\n':
+                line += "\\n";
+                break;
+            case '\r':
+                line += "\\r";
+                break;
+            default:
+                line += ch;
+                break;
+            }
+        }
+    }
+    return line;
+}
+
+vector<string> SessionServiceChannel::SplitFields(const string& line)
+{
+    vector<string> fields(1);
+    for (size_t idx = 0; idx < line.length(); ++idx)
+    {
+        char ch = line[idx];
+        if (ch == '\t')
+        {
+            fields.emplace_back();
+        }
+        else if (ch == '\\' && idx + 1 < line.length())
+        {
+            ++idx;
+            switch (line[idx])
+            {
+            case 't':
+                fields.back() += '\t';
+                break;
+            case 'n':
+                fields.back() += '\n';
+                break;
+            case 'r':
+                fields.back() += '\r';
+                break;
+            default:
+                fields.back() += line[idx];
+                break;
+            }
+        }
+        else
+        {
+            fields.back() += ch;
+        }
+    }
+    return fields;
+}
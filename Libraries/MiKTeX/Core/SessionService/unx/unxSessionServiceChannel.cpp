@@ -0,0 +1,249 @@
+/**
+ * @file SessionService/unx/unxSessionServiceChannel.cpp
+ * @author Christian Schenk
+ * @brief Session service channel (Unix-alike)
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <miktex/Core/File>
+
+#include "internal.h"
+
+#include "SessionService/SessionServiceChannel.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+#if defined(MSG_NOSIGNAL)
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+namespace
+{
+    class unxSessionServiceChannel :
+        public SessionServiceChannel
+    {
+
+    public:
+
+        unxSessionServiceChannel(int fd) :
+            fd(fd)
+        {
+#if defined(SO_NOSIGPIPE)
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        }
+
+        ~unxSessionServiceChannel() noexcept override
+        {
+            close(fd);
+        }
+
+        bool ReadLine(string& line) override
+        {
+            while (true)
+            {
+                size_t pos = buffer.find('\n');
+                if (pos != string::npos)
+                {
+                    line = buffer.substr(0, pos);
+                    buffer.erase(0, pos + 1);
+                    return true;
+                }
+                char buf[4096];
+                ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n == 0)
+                {
+                    return false;
+                }
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    MIKTEX_FATAL_CRT_ERROR("recv");
+                }
+                buffer.append(buf, n);
+            }
+        }
+
+        void WriteLine(const string& line) override
+        {
+            string data = line + '\n';
+            size_t written = 0;
+            while (written < data.length())
+            {
+                ssize_t n = send(fd, data.c_str() + written, data.length() - written, SEND_FLAGS);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    MIKTEX_FATAL_CRT_ERROR("send");
+                }
+                written += n;
+            }
+        }
+
+        void Shutdown() override
+        {
+            shutdown(fd, SHUT_RDWR);
+        }
+
+    private:
+
+        string buffer;
+
+        int fd;
+    };
+
+    class unxSessionServiceListener :
+        public SessionServiceListener
+    {
+
+    public:
+
+        unxSessionServiceListener(int fd, const PathName& path) :
+            fd(fd),
+            path(path)
+        {
+        }
+
+        ~unxSessionServiceListener() noexcept override
+        {
+            close(fd);
+            unlink(path.GetData());
+        }
+
+        unique_ptr<SessionServiceChannel> Accept(chrono::milliseconds timeout) override
+        {
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            int ret = poll(&pfd, 1, static_cast<int>(timeout.count()));
+            if (ret < 0 && errno != EINTR)
+            {
+                MIKTEX_FATAL_CRT_ERROR("poll");
+            }
+            if (ret <= 0)
+            {
+                return nullptr;
+            }
+            int clientFd = accept(fd, nullptr, nullptr);
+            if (clientFd < 0)
+            {
+                // the session may have given up already
+                return nullptr;
+            }
+            fcntl(clientFd, F_SETFD, FD_CLOEXEC);
+            return make_unique<unxSessionServiceChannel>(clientFd);
+        }
+
+    private:
+
+        int fd;
+
+        PathName path;
+    };
+
+    bool MakeAddress(const PathName& path, struct sockaddr_un& addr)
+    {
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.GetLength() >= sizeof(addr.sun_path))
+        {
+            return false;
+        }
+        memcpy(addr.sun_path, path.GetData(), path.GetLength());
+        return true;
+    }
+}
+
+unique_ptr<SessionServiceChannel> SessionServiceChannel::TryConnect(const PathName& endpoint, chrono::milliseconds timeout)
+{
+    struct sockaddr_un addr;
+    if (!MakeAddress(endpoint, addr))
+    {
+        return nullptr;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+    // the session must not hang on a stuck service
+    struct timeval tv;
+    tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return make_unique<unxSessionServiceChannel>(fd);
+}
+
+unique_ptr<SessionServiceListener> SessionServiceListener::Create(const PathName& endpoint)
+{
+    struct sockaddr_un addr;
+    if (!MakeAddress(endpoint, addr))
+    {
+        MIKTEX_FATAL_ERROR_2(T_("The socket path is too long."), "path", endpoint.ToString());
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("socket");
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    // the caller holds the service lock: the socket file is a leftover
+    if (File::Exists(endpoint))
+    {
+        unlink(endpoint.GetData());
+    }
+    // other users must not connect
+    mode_t oldMask = umask(S_IRWXG | S_IRWXO);
+    int ret = ::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    umask(oldMask);
+    if (ret != 0)
+    {
+        close(fd);
+        MIKTEX_FATAL_CRT_ERROR_2("bind", "path", endpoint.ToString());
+    }
+    if (listen(fd, 16) != 0)
+    {
+        close(fd);
+        unlink(endpoint.GetData());
+        MIKTEX_FATAL_CRT_ERROR_2("listen", "path", endpoint.ToString());
+    }
+    return make_unique<unxSessionServiceListener>(fd, endpoint);
+}
@@ -0,0 +1,349 @@
+/**
+ * @file SessionService/win/winSessionServiceChannel.cpp
+ * @author Christian Schenk
+ * @brief Session service channel (Windows)
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <Windows.h>
+
+#include <atomic>
+#include <vector>
+
+#include <miktex/Core/MD5>
+#include <miktex/Core/win/winAutoResource>
+
+#include "internal.h"
+
+#include "SessionService/SessionServiceChannel.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    // named pipes live in a global namespace: the name is unique per
+    // user data root
+    wstring MakePipeName(const PathName& endpoint)
+    {
+        PathName key(endpoint);
+        key.TransformForComparison();
+        return UW_("\\\\.\\pipe\\miktex-session-" + MD5::FromChars(key.ToString()).ToString());
+    }
+
+    vector<unsigned char> GetTokenUser(HANDLE token)
+    {
+        DWORD size = 0;
+        GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+        vector<unsigned char> buf(size);
+        if (size == 0 || !GetTokenInformation(token, TokenUser, buf.data(), size, &size))
+        {
+            buf.clear();
+        }
+        return buf;
+    }
+
+    // anyone can create a pipe with our name: make sure that the server
+    // runs on behalf of the current user
+    bool IsServedByCurrentUser(HANDLE pipe)
+    {
+        ULONG serverProcessId;
+        if (!GetNamedPipeServerProcessId(pipe, &serverProcessId))
+        {
+            return false;
+        }
+        HANDLE serverProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, serverProcessId);
+        if (serverProcess == nullptr)
+        {
+            return false;
+        }
+        AutoHANDLE autoServerProcess(serverProcess);
+        HANDLE serverToken;
+        if (!OpenProcessToken(serverProcess, TOKEN_QUERY, &serverToken))
+        {
+            return false;
+        }
+        AutoHANDLE autoServerToken(serverToken);
+        HANDLE myToken;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &myToken))
+        {
+            return false;
+        }
+        AutoHANDLE autoMyToken(myToken);
+        vector<unsigned char> serverUser = GetTokenUser(serverToken);
+        vector<unsigned char> myUser = GetTokenUser(myToken);
+        return !serverUser.empty() && !myUser.empty()
+            && EqualSid(reinterpret_cast<TOKEN_USER*>(serverUser.data())->User.Sid, reinterpret_cast<TOKEN_USER*>(myUser.data())->User.Sid);
+    }
+
+    class winSessionServiceChannel :
+        public SessionServiceChannel
+    {
+
+    public:
+
+        winSessionServiceChannel(HANDLE handle, bool isServer, DWORD timeout) :
+            handle(handle),
+            isServer(isServer),
+            timeout(timeout)
+        {
+            event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (event == nullptr)
+            {
+                CloseHandle(handle);
+                MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
+            }
+        }
+
+        ~winSessionServiceChannel() noexcept override
+        {
+            if (isServer)
+            {
+                FlushFileBuffers(handle);
+                DisconnectNamedPipe(handle);
+            }
+            CloseHandle(handle);
+            CloseHandle(event);
+        }
+
+        bool ReadLine(string& line) override
+        {
+            while (true)
+            {
+                size_t pos = buffer.find('\n');
+                if (pos != string::npos)
+                {
+                    line = buffer.substr(0, pos);
+                    buffer.erase(0, pos + 1);
+                    return true;
+                }
+                if (shutdownRequested)
+                {
+                    return false;
+                }
+                char buf[4096];
+                DWORD n;
+                if (!Transfer(false, buf, sizeof(buf), n))
+                {
+                    return false;
+                }
+                buffer.append(buf, n);
+            }
+        }
+
+        void WriteLine(const string& line) override
+        {
+            string data = line + '\n';
+            size_t written = 0;
+            while (written < data.length())
+            {
+                DWORD n;
+                if (!Transfer(true, const_cast<char*>(data.c_str() + written), static_cast<DWORD>(data.length() - written), n))
+                {
+                    MIKTEX_FATAL_ERROR(T_("The session service channel has been closed."));
+                }
+                written += n;
+            }
+        }
+
+        void Shutdown() override
+        {
+            shutdownRequested = true;
+            CancelIoEx(handle, nullptr);
+            if (isServer)
+            {
+                DisconnectNamedPipe(handle);
+            }
+        }
+
+    private:
+
+        // returns false, if the channel has been closed
+        bool Transfer(bool write, char* buf, DWORD size, DWORD& n)
+        {
+            OVERLAPPED overlapped;
+            ZeroMemory(&overlapped, sizeof(overlapped));
+            overlapped.hEvent = event;
+            n = 0;
+            BOOL done = write ? WriteFile(handle, buf, size, nullptr, &overlapped) : ReadFile(handle, buf, size, nullptr, &overlapped);
+            if (!done)
+            {
+                DWORD error = GetLastError();
+                if (error != ERROR_IO_PENDING)
+                {
+                    if (IsClosed(error))
+                    {
+                        return false;
+                    }
+                    MIKTEX_FATAL_WINDOWS_RESULT(write ? "WriteFile" : "ReadFile", error);
+                }
+                if (WaitForSingleObject(event, timeout) != WAIT_OBJECT_0)
+                {
+                    CancelIoEx(handle, &overlapped);
+                    GetOverlappedResult(handle, &overlapped, &n, TRUE);
+                    MIKTEX_FATAL_ERROR(T_("The session service did not respond in time."));
+                }
+            }
+            if (!GetOverlappedResult(handle, &overlapped, &n, FALSE))
+            {
+                DWORD error = GetLastError();
+                if (IsClosed(error))
+                {
+                    return false;
+                }
+                MIKTEX_FATAL_WINDOWS_RESULT("GetOverlappedResult", error);
+            }
+            return write || n > 0;
+        }
+
+        static bool IsClosed(DWORD error)
+        {
+            return error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED || error == ERROR_OPERATION_ABORTED || error == ERROR_NO_DATA;
+        }
+
+        string buffer;
+
+        HANDLE event = nullptr;
+
+        HANDLE handle;
+
+        bool isServer;
+
+        atomic_bool shutdownRequested{ false };
+
+        DWORD timeout;
+    };
+
+    class winSessionServiceListener :
+        public SessionServiceListener
+    {
+
+    public:
+
+        winSessionServiceListener(const wstring& pipeName) :
+            pipeName(pipeName)
+        {
+            ZeroMemory(&overlapped, sizeof(overlapped));
+            overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (overlapped.hEvent == nullptr)
+            {
+                MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
+            }
+            // fails, if another process serves the pipe
+            CreateInstance(true);
+        }
+
+        ~winSessionServiceListener() noexcept override
+        {
+            if (pipe != INVALID_HANDLE_VALUE)
+            {
+                CancelIoEx(pipe, &overlapped);
+                CloseHandle(pipe);
+            }
+            CloseHandle(overlapped.hEvent);
+        }
+
+        unique_ptr<SessionServiceChannel> Accept(chrono::milliseconds timeout) override
+        {
+            if (pipe == INVALID_HANDLE_VALUE)
+            {
+                CreateInstance(false);
+            }
+            if (connecting)
+            {
+                if (WaitForSingleObject(overlapped.hEvent, static_cast<DWORD>(timeout.count())) != WAIT_OBJECT_0)
+                {
+                    return nullptr;
+                }
+                DWORD n;
+                connecting = false;
+                if (!GetOverlappedResult(pipe, &overlapped, &n, FALSE))
+                {
+                    // the session may have given up already
+                    CloseHandle(pipe);
+                    pipe = INVALID_HANDLE_VALUE;
+                    return nullptr;
+                }
+            }
+            HANDLE connected = pipe;
+            pipe = INVALID_HANDLE_VALUE;
+            return make_unique<winSessionServiceChannel>(connected, true, INFINITE);
+        }
+
+    private:
+
+        void CreateInstance(bool first)
+        {
+            DWORD openMode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+            pipe = CreateNamedPipeW(pipeName.c_str(), openMode, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, PIPE_UNLIMITED_INSTANCES, 4096, 4096, 0, nullptr);
+            if (pipe == INVALID_HANDLE_VALUE)
+            {
+                MIKTEX_FATAL_WINDOWS_ERROR_2("CreateNamedPipeW", "name", WU_(pipeName));
+            }
+            ResetEvent(overlapped.hEvent);
+            if (ConnectNamedPipe(pipe, &overlapped))
+            {
+                connecting = false;
+                return;
+            }
+            DWORD error = GetLastError();
+            if (error == ERROR_IO_PENDING)
+            {
+                connecting = true;
+            }
+            else if (error == ERROR_PIPE_CONNECTED)
+            {
+                connecting = false;
+            }
+            else
+            {
+                CloseHandle(pipe);
+                pipe = INVALID_HANDLE_VALUE;
+                MIKTEX_FATAL_WINDOWS_RESULT_2("ConnectNamedPipe", error, "name", WU_(pipeName));
+            }
+        }
+
+        bool connecting = false;
+
+        OVERLAPPED overlapped;
+
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+
+        wstring pipeName;
+    };
+}
+
+unique_ptr<SessionServiceChannel> SessionServiceChannel::TryConnect(const PathName& endpoint, chrono::milliseconds timeout)
+{
+    wstring pipeName = MakePipeName(endpoint);
+    HANDLE handle = CreateFileW(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, nullptr);
+    if (handle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY && WaitNamedPipeW(pipeName.c_str(), static_cast<DWORD>(timeout.count())))
+    {
+        handle = CreateFileW(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, nullptr);
+    }
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+    if (!IsServedByCurrentUser(handle))
+    {
+        CloseHandle(handle);
+        return nullptr;
+    }
+    return make_unique<winSessionServiceChannel>(handle, false, static_cast<DWORD>(timeout.count()));
+}
+
+unique_ptr<SessionServiceListener> SessionServiceListener::Create(const PathName& endpoint)
+{
+    return make_unique<winSessionServiceListener>(MakePipeName(endpoint));
+}
@@ -21,10 +21,18 @@
 
 #include "config.h"
 
+#include <cstring>
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+
 #include <bzlib.h>
 
 #include <miktex/Core/BZip2Stream>
-#include <miktex/Core/FileStream>
+#include <miktex/Core/File>
+#include <miktex/Core/MemoryMappedFile>
 
 #include <miktex/Util/PathName>
 
@@ -79,45 +87,139 @@ private:
     }
   };
 
+private:
+  // a stream starts with "BZh", the block size and the magic number of the
+  // first block (or of the end of the stream)
+  static bool IsStreamStart(const unsigned char* data, size_t size)
+  {
+    const unsigned char blockMagic[] = { 0x31, 0x41, 0x59, 0x26, 0x53, 0x59 };
+    const unsigned char endMagic[] = { 0x17, 0x72, 0x45, 0x38, 0x50, 0x90 };
+    return size >= 10
+      && data[0] == 'B' && data[1] == 'Z' && data[2] == 'h' && data[3] >= '1' && data[3] <= '9'
+      && (memcmp(data + 4, blockMagic, sizeof(blockMagic)) == 0 || memcmp(data + 4, endMagic, sizeof(endMagic)) == 0);
+  }
+
+private:
+  // decodes one stream (or, if !single, all concatenated streams); returns
+  // the number of bytes consumed
+  template<typename Sink> static size_t DecodeStreams(const unsigned char* data, size_t size, bool single, Sink sink)
+  {
+    const size_t BUFFER_SIZE = 1024 * 64;
+    vector<char> outbuf(BUFFER_SIZE);
+    size_t pos = 0;
+    do
+    {
+      bz_stream_wrapper bzStream;
+      bzStream.next_in = nullptr;
+      bzStream.avail_in = 0;
+      int ret;
+      do
+      {
+        if (bzStream.avail_in == 0 && pos < size)
+        {
+          size_t n = min<size_t>(size - pos, 1024 * 1024 * 1024);
+          bzStream.next_in = reinterpret_cast<char*>(const_cast<unsigned char*>(data + pos));
+          bzStream.avail_in = static_cast<unsigned int>(n);
+          pos += n;
+        }
+        bzStream.next_out = outbuf.data();
+        bzStream.avail_out = BUFFER_SIZE;
+        ret = BZ2_bzDecompress(&bzStream);
+        if (ret != BZ_OK && ret != BZ_STREAM_END)
+        {
+          MIKTEX_FATAL_ERROR_2("BZ2 decoder did not succeed.", "ret", std::to_string(ret));
+        }
+        size_t n = BUFFER_SIZE - bzStream.avail_out;
+        if (ret == BZ_OK && n == 0 && bzStream.avail_in == 0 && pos == size)
+        {
+          MIKTEX_FATAL_ERROR("BZ2 decoder did not succeed (unexpected end of file).");
+        }
+        sink(outbuf.data(), n);
+      } while (ret != BZ_STREAM_END);
+      pos -= bzStream.avail_in;
+    } while (!single && IsStreamStart(data + pos, size - pos));
+    return pos;
+  }
+
 protected:
-  virtual void DoUncompress(const PathName& path)
+  void DoUncompress(const PathName& path) override
   {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    char inbuf[BUFFER_SIZE];
-    char outbuf[BUFFER_SIZE];
-    unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
-    unique_ptr<bz_stream_wrapper> bzStream = make_unique<bz_stream_wrapper>();
-    bzStream->next_in = nullptr;
-    bzStream->avail_in = 0;
-    bzStream->next_out = outbuf;
-    bzStream->avail_out = BUFFER_SIZE;
-    bool eof = false;
-    while (true)
+    size_t size = File::GetSize(path);
+    if (size == 0)
+    {
+      MIKTEX_FATAL_ERROR("BZ2 decoder did not succeed (unexpected end of file).");
+    }
+    unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+    const unsigned char* data = static_cast<const unsigned char*>(mapping->Open(path, false));
+    auto toPipe = [this](const char* buf, size_t n)
+    {
+      pipe.Write(buf, n);
+    };
+
+    // parallel compressors (pbzip2, lbzip2) write one stream per block;
+    // such streams are decoded by several threads; a match in the middle of
+    // a stream is detected because the stream before does not end there
+    vector<size_t> starts;
+    for (size_t pos = 0; pos + 10 <= size; ++pos)
     {
-      if (bzStream->avail_in == 0 && !eof)
+      if (data[pos] == 'B' && IsStreamStart(data + pos, size - pos))
       {
-        bzStream->next_in = inbuf;
-        bzStream->avail_in = static_cast<unsigned int>(fileStream->Read(inbuf, BUFFER_SIZE));
-        eof = bzStream->avail_in == 0;
+        starts.push_back(pos);
       }
-      int ret = BZ2_bzDecompress(bzStream.get());
-      if (bzStream->avail_out == 0 || ret == BZ_STREAM_END)
+    }
+    size_t numThreads = thread::hardware_concurrency();
+    if (starts.size() < 2 || starts[0] != 0 || numThreads < 2)
+    {
+      DecodeStreams(data, size, false, toPipe);
+      mapping->Close();
+      return;
+    }
+    starts.push_back(size);
+    size_t segmentCount = starts.size() - 1;
+    for (size_t first = 0; first < segmentCount; first += numThreads)
+    {
+      size_t last = min(first + numThreads, segmentCount);
+      vector<future<vector<char>>> results;
+      for (size_t idx = first; idx < last; ++idx)
       {
-        pipe.Write(outbuf, sizeof(outbuf) - bzStream->avail_out);
-        bzStream->next_out = outbuf;
-        bzStream->avail_out = BUFFER_SIZE;
+        results.push_back(async(launch::async, [data, &starts, idx]()
+        {
+          vector<char> output;
+          size_t segmentSize = starts[idx + 1] - starts[idx];
+          size_t consumed = DecodeStreams(data + starts[idx], segmentSize, true, [&output](const char* buf, size_t n) { output.insert(output.end(), buf, buf + n); });
+          if (consumed != segmentSize)
+          {
+            MIKTEX_UNEXPECTED();
+          }
+          return output;
+        }));
       }
-      if (ret != BZ_OK)
+      vector<vector<char>> outputs;
+      bool ok = true;
+      for (future<vector<char>>& f : results)
       {
-        if (ret == BZ_STREAM_END)
+        try
+        {
+          outputs.push_back(f.get());
+        }
+        catch (const exception&)
         {
-          bzStream.reset();
-          fileStream->Close();
-          return;
+          ok = false;
         }
-        MIKTEX_FATAL_ERROR_2("BZ2 decoder did not succeed.", "ret", std::to_string(ret));
+      }
+      if (!ok)
+      {
+        // wrong stream boundary or corrupt data: decode the rest in one go
+        DecodeStreams(data + starts[first], size - starts[first], false, toPipe);
+        mapping->Close();
+        return;
+      }
+      for (const vector<char>& output : outputs)
+      {
+        pipe.Write(output.data(), output.size());
       }
     }
+    mapping->Close();
   }
 };
 
@@ -0,0 +1,226 @@
+/**
+ * @file Stream/BufferedStream.cpp
+ * @author Christian Schenk
+ * @brief Buffered output file stream
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <future>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/BufferedStream>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Process>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+class BufferedStreamImpl :
+  public BufferedStream
+{
+public:
+  BufferedStreamImpl(const PathName& path, bool append, size_t bufferSize, BufferedStreamOptionSet options) :
+    path(path),
+    writeBehind(options[BufferedStreamOption::WriteBehind]),
+    atomicReplace(options[BufferedStreamOption::AtomicReplace])
+  {
+    if (atomicReplace && append)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    filePath = path;
+    if (atomicReplace)
+    {
+      filePath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+    }
+    file.Attach(File::Open(filePath, append ? FileMode::Append : FileMode::Create, FileAccess::Write, false));
+    // the data is buffered here
+    setvbuf(file.GetFile(), nullptr, _IONBF, 0);
+    buffer.reserve(bufferSize == 0 ? DefaultBufferSize : bufferSize);
+    if (writeBehind)
+    {
+      pending.reserve(buffer.capacity());
+    }
+  }
+
+public:
+  ~BufferedStreamImpl() noexcept override
+  {
+    try
+    {
+      if (atomicReplace)
+      {
+        Discard();
+      }
+      else
+      {
+        Close();
+      }
+    }
+    catch (const exception&)
+    {
+    }
+  }
+
+public:
+  size_t MIKTEXTHISCALL Read(void* data, size_t count) override
+  {
+    MIKTEX_UNEXPECTED();
+  }
+
+public:
+  void MIKTEXTHISCALL Write(const void* data, size_t count) override
+  {
+    const char* bytes = static_cast<const char*>(data);
+    while (count > 0)
+    {
+      if (buffer.size() == buffer.capacity())
+      {
+        WriteBuffer();
+      }
+      size_t n = min(count, buffer.capacity() - buffer.size());
+      buffer.insert(buffer.end(), bytes, bytes + n);
+      bytes += n;
+      count -= n;
+    }
+  }
+
+public:
+  void MIKTEXTHISCALL Seek(long offset, SeekOrigin origin) override
+  {
+    Flush();
+    file.Seek(offset, origin);
+  }
+
+public:
+  long MIKTEXTHISCALL GetPosition() const override
+  {
+    WaitForPending();
+    return file.GetPosition() + static_cast<long>(buffer.size());
+  }
+
+public:
+  void MIKTEXTHISCALL Flush() override
+  {
+    WaitForPending();
+    if (!buffer.empty())
+    {
+      file.Write(&buffer[0], buffer.size());
+      buffer.clear();
+    }
+  }
+
+public:
+  void MIKTEXTHISCALL Close() override
+  {
+    if (file.GetFile() == nullptr)
+    {
+      return;
+    }
+    Flush();
+    file.Close();
+    if (atomicReplace)
+    {
+      File::Move(filePath, path, { FileMoveOption::ReplaceExisting });
+    }
+  }
+
+public:
+  void MIKTEXTHISCALL Discard() override
+  {
+    if (file.GetFile() == nullptr)
+    {
+      return;
+    }
+    try
+    {
+      WaitForPending();
+    }
+    catch (const exception&)
+    {
+    }
+    buffer.clear();
+    file.Close();
+    if (atomicReplace && File::Exists(filePath))
+    {
+      File::Delete(filePath);
+    }
+  }
+
+private:
+  void WriteBuffer()
+  {
+    if (!writeBehind)
+    {
+      file.Write(&buffer[0], buffer.size());
+      buffer.clear();
+      return;
+    }
+    // the previous buffer must have been written before its memory is reused
+    WaitForPending();
+    swap(buffer, pending);
+    buffer.clear();
+    pendingWrite = async(launch::async, [this]() { file.Write(&pending[0], pending.size()); });
+  }
+
+private:
+  void WaitForPending() const
+  {
+    if (pendingWrite.valid())
+    {
+      pendingWrite.get();
+    }
+  }
+
+private:
+  PathName path;
+
+private:
+  PathName filePath;
+
+private:
+  bool writeBehind;
+
+private:
+  bool atomicReplace;
+
+private:
+  FileStream file;
+
+private:
+  vector<char> buffer;
+
+  // the buffer which is being written on a background thread
+private:
+  vector<char> pending;
+
+private:
+  mutable future<void> pendingWrite;
+};
+
+unique_ptr<BufferedStream> BufferedStream::Create(const PathName& path, size_t bufferSize, BufferedStreamOptionSet options)
+{
+  return make_unique<BufferedStreamImpl>(path, false, bufferSize, options);
+}
+
+unique_ptr<BufferedStream> BufferedStream::Append(const PathName& path, size_t bufferSize, BufferedStreamOptionSet options)
+{
+  return make_unique<BufferedStreamImpl>(path, true, bufferSize, options);
+}
@@ -1,6 +1,6 @@
 /* CompressedStreamBase.h:
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -101,7 +101,8 @@ protected:
   std::thread thrd;
 
 protected:
-  Pipe pipe;
+  // decouples the decompressor from the consumer
+  Pipe pipe{ 1024 * 1024 };
 
 protected:
   enum State {
@@ -1,6 +1,6 @@
 /* LzmaStream.cpp: LZMA file stream
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -21,6 +21,10 @@
 
 #include "config.h"
 
+#include <cstring>
+
+#include <vector>
+
 #include <lzma.h>
 
 #include <miktex/Core/FileStream>
@@ -47,6 +51,13 @@ public:
     StartThread(path, reading);
   }
 
+public:
+  LzmaStreamImpl(Stream* source) :
+    source(source)
+  {
+    StartThread(PathName(), true);
+  }
+
 public:
   virtual ~LzmaStreamImpl()
   {
@@ -63,10 +74,32 @@ private:
   class lzma_stream_wrapper : public lzma_stream
   {
   public:
-    lzma_stream_wrapper() :
+    lzma_stream_wrapper(bool xz) :
       lzma_stream(LZMA_STREAM_INIT)
     {
-      lzma_ret ret = lzma_auto_decoder(this, UINT64_MAX, 0);
+      lzma_ret ret;
+#if LZMA_VERSION >= 50040002
+      if (xz)
+      {
+        // xz files with more than one block are decoded by several threads;
+        // the threaded decoder falls back to single-threaded mode for the
+        // rest
+        lzma_mt mt;
+        memset(&mt, 0, sizeof(mt));
+        mt.threads = lzma_cputhreads();
+        if (mt.threads == 0)
+        {
+          mt.threads = 1;
+        }
+        mt.memlimit_threading = lzma_physmem() / 4;
+        mt.memlimit_stop = UINT64_MAX;
+        ret = lzma_stream_decoder_mt(this, &mt);
+      }
+      else
+#endif
+      {
+        ret = lzma_auto_decoder(this, UINT64_MAX, 0);
+      }
       if (ret != LZMA_OK)
       {
         MIKTEX_FATAL_ERROR_2("LZMA decoder initialization did not succeed.", "ret", std::to_string(ret));
@@ -82,29 +115,38 @@ private:
 protected:
   virtual void DoUncompress(const PathName& path)
   {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    uint8_t inbuf[BUFFER_SIZE];
-    uint8_t outbuf[BUFFER_SIZE];
-    unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
-    unique_ptr<lzma_stream_wrapper> lzmaStream = make_unique<lzma_stream_wrapper>();
-    lzmaStream->next_in = nullptr;
-    lzmaStream->avail_in = 0;
-    lzmaStream->next_out = outbuf;
+    const size_t BUFFER_SIZE = 1024 * 256;
+    vector<uint8_t> inbuf(BUFFER_SIZE);
+    vector<uint8_t> outbuf(BUFFER_SIZE);
+    unique_ptr<FileStream> fileStream;
+    Stream* inStream = source;
+    if (inStream == nullptr)
+    {
+      fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
+      inStream = fileStream.get();
+    }
+    size_t n = inStream->Read(inbuf.data(), BUFFER_SIZE);
+    const uint8_t xzMagic[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+    bool xz = n >= sizeof(xzMagic) && memcmp(inbuf.data(), xzMagic, sizeof(xzMagic)) == 0;
+    unique_ptr<lzma_stream_wrapper> lzmaStream = make_unique<lzma_stream_wrapper>(xz);
+    lzmaStream->next_in = inbuf.data();
+    lzmaStream->avail_in = n;
+    lzmaStream->next_out = outbuf.data();
     lzmaStream->avail_out = BUFFER_SIZE;
-    bool eof = false;
+    bool eof = n == 0;
     while (true)
     {
       if (lzmaStream->avail_in == 0 && !eof)
       {
-        lzmaStream->next_in = inbuf;
-        lzmaStream->avail_in = fileStream->Read(inbuf, BUFFER_SIZE);
+        lzmaStream->next_in = inbuf.data();
+        lzmaStream->avail_in = inStream->Read(inbuf.data(), BUFFER_SIZE);
         eof = lzmaStream->avail_in == 0;
       }
       lzma_ret ret = lzma_code(lzmaStream.get(), eof ? LZMA_FINISH : LZMA_RUN);
       if (lzmaStream->avail_out == 0 || ret == LZMA_STREAM_END)
       {
-        pipe.Write(outbuf, sizeof(outbuf) - lzmaStream->avail_out);
-        lzmaStream->next_out = outbuf;
+        pipe.Write(outbuf.data(), BUFFER_SIZE - lzmaStream->avail_out);
+        lzmaStream->next_out = outbuf.data();
         lzmaStream->avail_out = BUFFER_SIZE;
       }
       if (ret != LZMA_OK)
@@ -112,16 +154,27 @@ protected:
         if (ret == LZMA_STREAM_END)
         {
           lzmaStream.reset();
-          fileStream->Close();
+          if (fileStream != nullptr)
+          {
+            fileStream->Close();
+          }
           return;
         }
         MIKTEX_FATAL_ERROR_2("LZMA decoder did not succeed.", "ret", std::to_string(ret));
       }
     }
   }
+
+private:
+  Stream* source = nullptr;
 };
 
 unique_ptr<LzmaStream> LzmaStream::Create(const PathName& path, bool reading)
 {
   return make_unique<LzmaStreamImpl>(path, reading);
 }
+
+unique_ptr<LzmaStream> LzmaStream::Create(Stream* source)
+{
+  return make_unique<LzmaStreamImpl>(source);
+}
@@ -38,6 +38,11 @@ TemporaryFile::~TemporaryFile() noexcept
 {
 }
 
+FILE* TemporaryFile::OpenAnonymous(const PathName& directory, size_t expectedSize)
+{
+  return OpenAnonymous(directory, expectedSize, true);
+}
+
 class TemporaryFileImpl :
   public TemporaryFile
 {
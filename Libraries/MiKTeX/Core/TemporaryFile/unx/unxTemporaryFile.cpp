@@ -0,0 +1,121 @@
+/**
+ * @file TemporaryFile/unx/unxTemporaryFile.cpp
+ * @author Christian Schenk
+ * @brief Anonymous temporary files (Unix-alike)
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/TemporaryFile>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    // smaller files are held in memory
+    constexpr size_t IN_MEMORY_THRESHOLD = 4 * 1024 * 1024;
+}
+
+FILE* TemporaryFile::OpenAnonymous(const PathName& directory, size_t expectedSize, bool unnamed)
+{
+    int fd = -1;
+#if defined(MFD_CLOEXEC)
+    if (unnamed && expectedSize > 0 && expectedSize <= IN_MEMORY_THRESHOLD)
+    {
+        fd = memfd_create("miktex", MFD_CLOEXEC);
+    }
+#endif
+#if defined(O_TMPFILE)
+    if (unnamed && fd < 0)
+    {
+        fd = open(directory.GetData(), O_TMPFILE | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    }
+#endif
+    if (fd < 0)
+    {
+        // the file system does not support unnamed files: the name is
+        // removed right away
+        PathName path = directory / "mikXXXXXX";
+        fd = mkstemp(path.GetData());
+        if (fd < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR_2("mkstemp", "directory", directory.ToString());
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (unlink(path.GetData()) != 0)
+        {
+            close(fd);
+            MIKTEX_FATAL_CRT_ERROR_2("unlink", "path", path.ToString());
+        }
+    }
+    FILE* file = fdopen(fd, "w+b");
+    if (file == nullptr)
+    {
+        close(fd);
+        MIKTEX_FATAL_CRT_ERROR_2("fdopen", "directory", directory.ToString());
+    }
+    return file;
+}
+
+void TemporaryFile::LinkIntoPlace(FILE* file, const PathName& path)
+{
+    if (fflush(file) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("fflush", "path", path.ToString());
+    }
+    // the file gets its final name in one step
+    PathName newPath = path;
+    newPath.AppendExtension(fmt::format(".{0}", getpid()));
+#if defined(O_TMPFILE)
+    string fdPath = fmt::format("/proc/self/fd/{0}", fileno(file));
+    if (linkat(AT_FDCWD, fdPath.c_str(), AT_FDCWD, newPath.GetData(), AT_SYMLINK_FOLLOW) == 0)
+    {
+        File::Move(newPath, path, { FileMoveOption::ReplaceExisting });
+        return;
+    }
+#endif
+    // not an O_TMPFILE file: the data must be copied
+    if (fseek(file, 0, SEEK_SET) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString());
+    }
+    FileStream newStream(File::Open(newPath, FileMode::Create, FileAccess::Write, false));
+    vector<char> buf(64 * 1024);
+    size_t n;
+    while ((n = fread(buf.data(), 1, buf.size(), file)) > 0)
+    {
+        newStream.Write(buf.data(), n);
+    }
+    if (ferror(file) != 0)
+    {
+        newStream.Close();
+        File::Delete(newPath);
+        MIKTEX_FATAL_CRT_ERROR_2("fread", "path", path.ToString());
+    }
+    newStream.Close();
+    File::Move(newPath, path, { FileMoveOption::ReplaceExisting });
+}
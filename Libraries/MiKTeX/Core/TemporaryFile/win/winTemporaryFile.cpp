@@ -0,0 +1,110 @@
+/**
+ * @file TemporaryFile/win/winTemporaryFile.cpp
+ * @author Christian Schenk
+ * @brief Anonymous temporary files (Windows)
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <Windows.h>
+
+#include <fcntl.h>
+#include <io.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/TemporaryFile>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+FILE* TemporaryFile::OpenAnonymous(const PathName& directory, size_t expectedSize, bool unnamed)
+{
+    // the name cannot be avoided; FILE_ATTRIBUTE_TEMPORARY keeps the data
+    // in the cache, i.e., small files are held in memory anyway
+    PathName path;
+    path.SetToTempFile(directory);
+    HANDLE handle = CreateFileW(path.ToNativeString().c_str(), GENERIC_READ | GENERIC_WRITE | DELETE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, TRUNCATE_EXISTING, FILE_ATTRIBUTE_TEMPORARY, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        DWORD error = GetLastError();
+        DeleteFileW(path.ToNativeString().c_str());
+        MIKTEX_FATAL_WINDOWS_RESULT_2("CreateFileW", error, "path", path.ToString());
+    }
+    // unlike FILE_FLAG_DELETE_ON_CLOSE, the disposition can be revoked
+    FILE_DISPOSITION_INFO dispositionInfo;
+    dispositionInfo.DeleteFile = TRUE;
+    if (!SetFileInformationByHandle(handle, FileDispositionInfo, &dispositionInfo, sizeof(dispositionInfo)))
+    {
+        DWORD error = GetLastError();
+        CloseHandle(handle);
+        DeleteFileW(path.ToNativeString().c_str());
+        MIKTEX_FATAL_WINDOWS_RESULT_2("SetFileInformationByHandle", error, "path", path.ToString());
+    }
+    int fd = _open_osfhandle(reinterpret_cast<intptr_t>(handle), _O_RDWR | _O_BINARY);
+    if (fd < 0)
+    {
+        CloseHandle(handle);
+        MIKTEX_FATAL_CRT_ERROR_2("_open_osfhandle", "path", path.ToString());
+    }
+    FILE* file = _fdopen(fd, "w+b");
+    if (file == nullptr)
+    {
+        _close(fd);
+        MIKTEX_FATAL_CRT_ERROR_2("_fdopen", "path", path.ToString());
+    }
+    return file;
+}
+
+void TemporaryFile::LinkIntoPlace(FILE* file, const PathName& path)
+{
+    if (fflush(file) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("fflush", "path", path.ToString());
+    }
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("_get_osfhandle", "path", path.ToString());
+    }
+    FILE_DISPOSITION_INFO dispositionInfo;
+    dispositionInfo.DeleteFile = FALSE;
+    if (!SetFileInformationByHandle(handle, FileDispositionInfo, &dispositionInfo, sizeof(dispositionInfo)))
+    {
+        MIKTEX_FATAL_WINDOWS_ERROR_2("SetFileInformationByHandle", "path", path.ToString());
+    }
+    // the file is not temporary anymore
+    FILE_BASIC_INFO basicInfo;
+    memset(&basicInfo, 0, sizeof(basicInfo));
+    basicInfo.FileAttributes = FILE_ATTRIBUTE_NORMAL;
+    if (!SetFileInformationByHandle(handle, FileBasicInfo, &basicInfo, sizeof(basicInfo)))
+    {
+        MIKTEX_FATAL_WINDOWS_ERROR_2("SetFileInformationByHandle", "path", path.ToString());
+    }
+    PathName fqPath(path);
+    fqPath.MakeFullyQualified();
+    wstring newName = fqPath.ToNativeString();
+    vector<unsigned char> buf(sizeof(FILE_RENAME_INFO) + newName.length() * sizeof(wchar_t));
+    FILE_RENAME_INFO* renameInfo = reinterpret_cast<FILE_RENAME_INFO*>(buf.data());
+    renameInfo->ReplaceIfExists = TRUE;
+    renameInfo->RootDirectory = nullptr;
+    renameInfo->FileNameLength = static_cast<DWORD>(newName.length() * sizeof(wchar_t));
+    memcpy(renameInfo->FileName, newName.c_str(), renameInfo->FileNameLength);
+    if (!SetFileInformationByHandle(handle, FileRenameInfo, renameInfo, static_cast<DWORD>(buf.size())))
+    {
+        MIKTEX_FATAL_WINDOWS_ERROR_2("SetFileInformationByHandle", "path", path.ToString());
+    }
+}
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief CoreStopWatch class
  *
- * @copyright Copyright © 1996-2023 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <miktex/Trace/Profiler>
 #include <miktex/Trace/StopWatch>
 
 #include "Session/SessionImpl.h"
@@ -24,7 +25,9 @@ class CoreStopWatch
 
 public:
 
-    CoreStopWatch(const std::string &message) : stopWatch(MiKTeX::Trace::StopWatch::Start(SESSION_IMPL()->trace_stopwatch.get(), "core", message))
+    CoreStopWatch(const char* name, const std::string& message) :
+        profileScope("core", name, message),
+        stopWatch(MiKTeX::Trace::StopWatch::Start(SESSION_IMPL()->trace_stopwatch.get(), "core", message))
     {
     }
 
@@ -41,6 +44,8 @@ public:
 
 private:
 
+    MiKTeX::Trace::ProfileScope profileScope;
+
     std::unique_ptr<MiKTeX::Trace::StopWatch> stopWatch;
 };
 
@@ -0,0 +1,224 @@
+/**
+ * @file Utils/DvipsFontMapIndex.cpp
+ * @author Christian Schenk
+ * @brief Index of dvips font map files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+#include <miktex/Core/Utils>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+// the index file consists of:
+//   signature
+//   size and last write time of the map file
+//   number of entries
+//   entries (sorted by TeX font name)
+//   string pool (TeX font names and map lines)
+constexpr const char DVIPS_FONT_MAP_INDEX_SIGNATURE[] = "miktex-font-map-index-1\n";
+
+constexpr size_t SIGNATURE_SIZE = sizeof(DVIPS_FONT_MAP_INDEX_SIGNATURE) - 1;
+
+constexpr size_t HEADER_SIZE = SIGNATURE_SIZE + sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint32_t);
+
+struct IndexEntry
+{
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t lineOffset;
+    uint32_t lineLength;
+};
+
+static PathName GetIndexFile(const PathName& mapFile)
+{
+    PathName path = SESSION_IMPL()->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FONTMAPS_CACHE_DIR;
+    PathName fullPath = mapFile;
+    fullPath.MakeFullyQualified();
+    path /= MD5::FromChars(fullPath.ToString()).ToString();
+    path.AppendExtension(".idx");
+    return path;
+}
+
+void Utils::MakeDvipsFontMapIndex(const PathName& mapFile)
+{
+    uint64_t mapFileSize = File::GetSize(mapFile);
+    int64_t mapFileTime = File::GetLastWriteTime(mapFile);
+
+    // the first mapping of a font wins
+    vector<pair<string, string>> mappings;
+    ifstream stream = File::CreateInputStream(mapFile);
+    string line;
+    DvipsFontMapEntry mapEntry;
+    while (std::getline(stream, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (ParseDvipsFontMapLine(line, mapEntry))
+        {
+            mappings.push_back({ mapEntry.texName, line });
+        }
+    }
+    stream.close();
+    stable_sort(mappings.begin(), mappings.end(), [](const pair<string, string>& a, const pair<string, string>& b) { return a.first < b.first; });
+    mappings.erase(unique(mappings.begin(), mappings.end(), [](const pair<string, string>& a, const pair<string, string>& b) { return a.first == b.first; }), mappings.end());
+
+    string entries;
+    string pool;
+    for (const auto& m : mappings)
+    {
+        IndexEntry entry;
+        entry.nameOffset = static_cast<uint32_t>(pool.length());
+        entry.nameLength = static_cast<uint32_t>(m.first.length());
+        pool += m.first;
+        entry.lineOffset = static_cast<uint32_t>(pool.length());
+        entry.lineLength = static_cast<uint32_t>(m.second.length());
+        pool += m.second;
+        entries.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    uint32_t count = static_cast<uint32_t>(mappings.size());
+
+    PathName indexFile = GetIndexFile(mapFile);
+    Directory::Create(indexFile.GetDirectoryName());
+    // other processes may have the old index file mapped: write a new file
+    // and move it into place
+    PathName newPath = indexFile;
+    newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+    FileStream indexStream(File::Open(newPath, FileMode::Create, FileAccess::Write, false));
+    indexStream.Write(DVIPS_FONT_MAP_INDEX_SIGNATURE, SIGNATURE_SIZE);
+    indexStream.Write(&mapFileSize, sizeof(mapFileSize));
+    indexStream.Write(&mapFileTime, sizeof(mapFileTime));
+    indexStream.Write(&count, sizeof(count));
+    indexStream.Write(entries.c_str(), entries.length());
+    indexStream.Write(pool.c_str(), pool.length());
+    indexStream.Close();
+    File::Move(newPath, indexFile, { FileMoveOption::ReplaceExisting });
+}
+
+// returns false, if the index file does not exist or is not up-to-date
+static bool LookupDvipsFontMapIndex(const PathName& mapFile, const string& texName, bool& found, string& line)
+{
+    PathName indexFile = GetIndexFile(mapFile);
+    if (!File::Exists(indexFile))
+    {
+        return false;
+    }
+    unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+    const char* ptr = static_cast<const char*>(mapping->Open(indexFile, false));
+    size_t size = mapping->GetSize();
+    if (size < HEADER_SIZE || memcmp(ptr, DVIPS_FONT_MAP_INDEX_SIGNATURE, SIGNATURE_SIZE) != 0)
+    {
+        mapping->Close();
+        return false;
+    }
+    uint64_t mapFileSize;
+    int64_t mapFileTime;
+    uint32_t count;
+    memcpy(&mapFileSize, ptr + SIGNATURE_SIZE, sizeof(mapFileSize));
+    memcpy(&mapFileTime, ptr + SIGNATURE_SIZE + sizeof(mapFileSize), sizeof(mapFileTime));
+    memcpy(&count, ptr + SIGNATURE_SIZE + sizeof(mapFileSize) + sizeof(mapFileTime), sizeof(count));
+    if (mapFileSize != File::GetSize(mapFile) || mapFileTime != static_cast<int64_t>(File::GetLastWriteTime(mapFile)) || count > (size - HEADER_SIZE) / sizeof(IndexEntry))
+    {
+        mapping->Close();
+        return false;
+    }
+    const char* entries = ptr + HEADER_SIZE;
+    const char* pool = entries + count * sizeof(IndexEntry);
+    size_t poolSize = size - (pool - ptr);
+    auto getEntry = [&](uint32_t idx)
+    {
+        IndexEntry entry;
+        memcpy(&entry, entries + idx * sizeof(IndexEntry), sizeof(entry));
+        if (entry.nameOffset > poolSize || entry.nameLength > poolSize - entry.nameOffset || entry.lineOffset > poolSize || entry.lineLength > poolSize - entry.lineOffset)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        return entry;
+    };
+    found = false;
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        IndexEntry entry = getEntry(mid);
+        int cmp = string(pool + entry.nameOffset, entry.nameLength).compare(texName);
+        if (cmp == 0)
+        {
+            line.assign(pool + entry.lineOffset, entry.lineLength);
+            found = true;
+            break;
+        }
+        else if (cmp < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    mapping->Close();
+    return true;
+}
+
+bool Utils::FindDvipsFontMapEntry(const PathName& mapFile, const string& texName, DvipsFontMapEntry& fontMapEntry)
+{
+    bool found = false;
+    string line;
+    try
+    {
+        if (!LookupDvipsFontMapIndex(mapFile, texName, found, line))
+        {
+            MakeDvipsFontMapIndex(mapFile);
+            if (!LookupDvipsFontMapIndex(mapFile, texName, found, line))
+            {
+                MIKTEX_UNEXPECTED();
+            }
+        }
+    }
+    catch (const exception&)
+    {
+        // the index is an optimization: read the map file
+        ifstream stream = File::CreateInputStream(mapFile);
+        while (!found && std::getline(stream, line))
+        {
+            found = ParseDvipsFontMapLine(line, fontMapEntry) && fontMapEntry.texName == texName;
+        }
+        stream.close();
+        return found;
+    }
+    return found && ParseDvipsFontMapLine(line, fontMapEntry);
+}
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Pipe class
  *
- * @copyright Copyright © 1996-2023 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -29,9 +29,9 @@ class Pipe
 
 public:
 
-    Pipe()
+    Pipe(size_t capacity = 1024 * 32) :
+        capacity(capacity)
     {
-        capacity = 1024 * 32;
         buffer = new unsigned char[capacity];
     }
 
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @briefUtility functions (Unix)
  *
- * @copyright Copyright © 1996-2023 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -80,6 +80,7 @@ void Utils::SetEnvironmentString(const string& valueName, const string& value)
     {
         MIKTEX_FATAL_CRT_ERROR_2("setenv", "name", valueName);
     }
+    OnEnvironmentChanged();
 }
 
 void Utils::RemoveEnvironmentString(const string& valueName)
@@ -90,6 +91,7 @@ void Utils::RemoveEnvironmentString(const string& valueName)
     {
         MIKTEX_FATAL_CRT_ERROR_2("unsetenv", "name", valueName);
     }
+    OnEnvironmentChanged();
 }
 
 void Utils::CheckHeap()
@@ -16,6 +16,7 @@
 #cmakedefine HAVE_ATLBASE_H 1
 #cmakedefine HAVE_DIRENT_H 1
 #cmakedefine HAVE_INTTYPES_H 1
+#cmakedefine HAVE_SYS_FANOTIFY_H 1
 #cmakedefine HAVE_SYS_MMAN_H 1
 #cmakedefine HAVE_SYS_STATVFS_H 1
 #cmakedefine HAVE_SYS_STAT_H 1
@@ -31,6 +32,8 @@
 #cmakedefine HAVE_FORK 1
 #cmakedefine HAVE_FUTIMES 1
 #cmakedefine HAVE_MMAP 1
+#cmakedefine HAVE_POSIX_SPAWN 1
+#cmakedefine HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP 1
 #cmakedefine HAVE_STATVFS 1
 #cmakedefine HAVE_UNAME_SYSCALL 1
 #cmakedefine HAVE_VFORK 1
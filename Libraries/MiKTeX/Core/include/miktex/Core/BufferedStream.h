@@ -0,0 +1,87 @@
+/**
+ * @file miktex/Core/BufferedStream.h
+ * @author Christian Schenk
+ * @brief Buffered output file stream
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#if !defined(C2E5B0A3F0A44E0C8F1B6A4D7E9D3C21)
+#define C2E5B0A3F0A44E0C8F1B6A4D7E9D3C21
+
+#include <miktex/Core/config.h>
+
+#include <cstddef>
+#include <memory>
+
+#include <miktex/Util/OptionSet>
+#include <miktex/Util/PathName>
+
+#include "Stream.h"
+
+MIKTEX_CORE_BEGIN_NAMESPACE;
+
+/// Buffered stream options.
+enum class BufferedStreamOption
+{
+  /// Write full buffers on a background thread, so that the caller can
+  /// produce the next data meanwhile.
+  WriteBehind,
+  /// Write to a temporary file, which replaces the file when the stream is
+  /// closed. The file is not synced to disk.
+  AtomicReplace,
+};
+
+typedef MiKTeX::Util::OptionSet<BufferedStreamOption> BufferedStreamOptionSet;
+
+/// An output file stream which collects small writes in a large buffer.
+class MIKTEXNOVTABLE BufferedStream :
+  public Stream
+{
+  /// The default buffer size.
+public:
+  static constexpr std::size_t DefaultBufferSize = 1024 * 1024;
+
+  /// Writes the buffered data to the file.
+public:
+  virtual void MIKTEXTHISCALL Flush() = 0;
+
+  /// Writes the buffered data and closes the file. With
+  /// `BufferedStreamOption::AtomicReplace`, the file is replaced now.
+public:
+  virtual void MIKTEXTHISCALL Close() = 0;
+
+  /// Closes the file without replacing the original file. Has no effect, if
+  /// the stream has been closed.
+  /// With `BufferedStreamOption::AtomicReplace`, the temporary file is removed.
+public:
+  virtual void MIKTEXTHISCALL Discard() = 0;
+
+  /// Creates a file and opens a buffered stream for writing.
+  /// @param path The path to the file.
+  /// @param bufferSize The size of the buffer.
+  /// @param options Stream options.
+  /// @return Returns a smart pointer to the new stream.
+public:
+  static MIKTEXCORECEEAPI(std::unique_ptr<BufferedStream>) Create(const MiKTeX::Util::PathName& path, std::size_t bufferSize, BufferedStreamOptionSet options);
+
+  /// Opens a buffered stream for appending to a file.
+  /// @param path The path to the file.
+  /// @param bufferSize The size of the buffer.
+  /// @param options Stream options (`BufferedStreamOption::AtomicReplace` is
+  /// not supported).
+  /// @return Returns a smart pointer to the new stream.
+public:
+  static MIKTEXCORECEEAPI(std::unique_ptr<BufferedStream>) Append(const MiKTeX::Util::PathName& path, std::size_t bufferSize, BufferedStreamOptionSet options);
+};
+
+MIKTEX_CORE_END_NAMESPACE;
+
+#endif
@@ -29,6 +29,8 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <miktex/Util/PathName>
 
@@ -55,6 +57,83 @@ struct DirectoryEntry2 :
   std::size_t size;
 };
 
+/// The entries of a file system directory, read by `DirectoryLister::ReadAll()`.
+/// The names are stored in one buffer, which is reused when the object is
+/// filled again.
+class DirectoryListing
+{
+  /// Removes all entries.
+public:
+  void Clear()
+  {
+    names.clear();
+    entries.clear();
+  }
+
+  /// Adds an entry.
+  /// @param name The name of the entry (not necessarily null-terminated).
+  /// @param length The length of the name.
+  /// @param isDirectory Indicates whether the entry is a directory.
+public:
+  void Add(const char* name, std::size_t length, bool isDirectory)
+  {
+    entries.push_back({ names.size(), length, isDirectory });
+    names.insert(names.end(), name, name + length);
+    names.push_back(0);
+  }
+
+  /// Gets the number of entries.
+  /// @return Returns the number of entries.
+public:
+  std::size_t GetCount() const
+  {
+    return entries.size();
+  }
+
+  /// Gets the name of an entry.
+  /// @param idx The index of the entry.
+  /// @return Returns the null-terminated name. It is valid until the object
+  /// is modified.
+public:
+  const char* GetName(std::size_t idx) const
+  {
+    return &names[entries[idx].offset];
+  }
+
+  /// Gets the name of an entry.
+  /// @param idx The index of the entry.
+  /// @return Returns a view of the name. It is valid until the object is
+  /// modified.
+public:
+  std::string_view GetNameView(std::size_t idx) const
+  {
+    return std::string_view(&names[entries[idx].offset], entries[idx].length);
+  }
+
+  /// Tests whether an entry is a directory.
+  /// @param idx The index of the entry.
+  /// @return Returns `true`, if the entry is a directory.
+public:
+  bool IsDirectory(std::size_t idx) const
+  {
+    return entries[idx].isDirectory;
+  }
+
+private:
+  struct Entry
+  {
+    std::size_t offset;
+    std::size_t length;
+    bool isDirectory;
+  };
+
+private:
+  std::vector<char> names;
+
+private:
+  std::vector<Entry> entries;
+};
+
 /// An instances can be used to read entries of a file system directory.
 class MIKTEXNOVTABLE DirectoryLister
 {
@@ -113,6 +192,16 @@ public:
   /// @return Returns a smart pointer to the `DirectoryLister` interface.
 public:
   static MIKTEXCORECEEAPI(std::unique_ptr<DirectoryLister>) Open(const MiKTeX::Util::PathName& directory, const char* pattern, int options);
+
+  /// Reads all entries of a directory at once.
+  /// This is faster than reading the entries one by one: the operating system
+  /// is asked for many entries at a time, and no string object is made per
+  /// entry. The entries are in no particular order.
+  /// @param directory File system path to the directory.
+  /// @param options Read options.
+  /// @param[out] listing The entries. Previous entries are removed.
+public:
+  static MIKTEXCORECEEAPI(void) ReadAll(const MiKTeX::Util::PathName& directory, int options, DirectoryListing& listing);
 };
 
 MIKTEX_CORE_END_NAMESPACE;
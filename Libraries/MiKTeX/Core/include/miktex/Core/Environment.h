@@ -1,6 +1,6 @@
 /* miktex/Core/Environment.h:                           -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -28,6 +28,7 @@
 #define MIKTEX_ENV_PREFIX_ MIKTEX_ENV_PREFIX "_"
 
 #define MIKTEX_ENV_BIN_DIR MIKTEX_ENV_PREFIX_ "BINDIR"
+#define MIKTEX_ENV_BUILD_TRACE_FILE MIKTEX_ENV_PREFIX_ "BUILD_TRACE_FILE"
 #define MIKTEX_ENV_COMMON_CONFIG MIKTEX_ENV_PREFIX_ "COMMONCONFIG"
 #define MIKTEX_ENV_COMMON_DATA MIKTEX_ENV_PREFIX_ "COMMONDATA"
 #define MIKTEX_ENV_COMMON_INSTALL MIKTEX_ENV_PREFIX_ "COMMONINSTALL"
@@ -35,11 +36,15 @@
 #define MIKTEX_ENV_COMMON_STARTUP_FILE MIKTEX_ENV_PREFIX_ "COMMONSTARTUPFILE"
 #define MIKTEX_ENV_CWD_LIST MIKTEX_ENV_PREFIX_ "CWDLIST"
 #define MIKTEX_ENV_EXCEPTION_PATH MIKTEX_ENV_PREFIX_ "EXCEPTION_PATH"
+#define MIKTEX_ENV_IO_REPORT_FILE MIKTEX_ENV_PREFIX_ "IO_REPORT_FILE"
+#define MIKTEX_ENV_JOB_CACHE MIKTEX_ENV_PREFIX_ "JOB_CACHE"
 #define MIKTEX_ENV_OTHER_COMMON_ROOTS MIKTEX_ENV_PREFIX_ "OTHERCOMMONROOTS"
 #define MIKTEX_ENV_OTHER_USER_ROOTS MIKTEX_ENV_PREFIX_ "OTHERUSERROOTS"
+#define MIKTEX_ENV_OUTPUT_DIGESTS MIKTEX_ENV_PREFIX_ "OUTPUT_DIGESTS"
 #define MIKTEX_ENV_PACKAGE_LIST_FILE MIKTEX_ENV_PREFIX_ "PKGLISTFILE"
 #define MIKTEX_ENV_REPOSITORY MIKTEX_ENV_PREFIX_ "REPOSITORY"
 #define MIKTEX_ENV_TRACE MIKTEX_ENV_PREFIX_ "TRACE"
+#define MIKTEX_ENV_TRACE_RECORDER_DIR MIKTEX_ENV_PREFIX_ "TRACE_RECORDER_DIR"
 #define MIKTEX_ENV_USER_CONFIG MIKTEX_ENV_PREFIX_ "USERCONFIG"
 #define MIKTEX_ENV_USER_DATA MIKTEX_ENV_PREFIX_ "USERDATA"
 #define MIKTEX_ENV_USER_INSTALL MIKTEX_ENV_PREFIX_ "USERINSTALL"
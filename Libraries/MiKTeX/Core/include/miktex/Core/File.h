@@ -288,6 +288,15 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) Equals(const MiKTeX::Util::PathName& path1, const MiKTeX::Util::PathName& path2);
 
+  /// Tests if two paths refer to the same file (e.g., hard links).
+  /// Symbolic links are followed.
+  /// @param path1 The file system path to the first file.
+  /// @param path2 The file system path to the second file.
+  /// @return Returns `true`, if both paths refer to the same file; returns
+  /// `false`, if they do not or if one of the files does not exist.
+public:
+  static MIKTEXCORECEEAPI(bool) IsSameFile(const MiKTeX::Util::PathName& path1, const MiKTeX::Util::PathName& path2);
+
   /// Sets the maximum number of simultaneously open files.
   /// @todo To be removed
 public:
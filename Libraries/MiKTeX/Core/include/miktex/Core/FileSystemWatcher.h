@@ -79,6 +79,12 @@ public:
 public:
   virtual void MIKTEXTHISCALL AddDirectories(const std::vector<MiKTeX::Util::PathName>& directories) = 0;
 
+public:
+  /// Checks whether all added directories are being watched.
+  /// @return Returns `false`, if a directory could not be watched, e.g.,
+  /// because a system limit has been reached.
+  virtual bool MIKTEXTHISCALL IsWatchingAll() = 0;
+
 public:
   virtual bool MIKTEXTHISCALL Start() = 0;
 
@@ -93,6 +93,16 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) Refresh(ICreateFndbCallback* callback);
 
+  /// Installs a file name database which has been created for an identical
+  /// directory tree elsewhere: the directory time stamps are taken from the
+  /// root directory, i.e., the next refresh trusts the recorded listings.
+  /// @param seedPath The file name database to be installed.
+  /// @param rootPath The root directory.
+  /// @return Returns `false`, if the file cannot be used, or if a recorded
+  /// directory does not exist.
+public:
+  static MIKTEXCORECEEAPI(bool) Seed(const MiKTeX::Util::PathName& seedPath, const MiKTeX::Util::PathName& rootPath);
+
 };
 
 MIKTEX_CORE_END_NAMESPACE;
@@ -39,6 +39,12 @@ class MIKTEXNOVTABLE LzmaStream :
 {
 public:
   static MIKTEXCORECEEAPI(std::unique_ptr<LzmaStream>) Create(const MiKTeX::Util::PathName& path, bool reading);
+
+  /// Decompresses the data which is read from another stream, e.g., from a
+  /// download. The source stream is read on a background thread; it must
+  /// outlive the new stream.
+public:
+  static MIKTEXCORECEEAPI(std::unique_ptr<LzmaStream>) Create(Stream* source);
 };
 
 MIKTEX_CORE_END_NAMESPACE;
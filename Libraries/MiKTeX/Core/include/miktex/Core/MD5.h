@@ -50,6 +50,14 @@ class MD5 :
 public:
   static MIKTEXCORECEEAPI(MD5) FromFile(const MiKTeX::Util::PathName& path);
 
+  /// Calculates the MD5 values of files.
+  /// The files are read by up to `maxConcurrency` threads.
+  /// @param paths The path names of the files.
+  /// @param maxConcurrency The maximum number of threads.
+  /// @return Returns the MD5 values, in the order of `paths`.
+public:
+  static MIKTEXCORECEEAPI(std::vector<MD5>) FromFiles(const std::vector<MiKTeX::Util::PathName>& paths, std::size_t maxConcurrency);
+
   /// Calculates the MD5 value of a char sequence.
   /// @param s The char sequence.
   /// @return Returns the MD5 of the char sequence.
@@ -109,7 +117,15 @@ public:
 public:
   void Update(const void* ptr, size_t size)
   {
-    md5_append(&ctx, reinterpret_cast<const md5_byte_t*>(ptr), static_cast<int>(size));
+    // md5_append() takes an int
+    const md5_byte_t* bytes = reinterpret_cast<const md5_byte_t*>(ptr);
+    while (size > 0)
+    {
+      size_t n = std::min<size_t>(size, 1024 * 1024 * 1024);
+      md5_append(&ctx, bytes, static_cast<int>(n));
+      bytes += n;
+      size -= n;
+    }
   }
 
   /// Calculates the final MD5 value.
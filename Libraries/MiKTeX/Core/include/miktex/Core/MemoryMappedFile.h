@@ -28,10 +28,30 @@
 
 #include <cstddef>
 
+#include <miktex/Util/OptionSet>
 #include <miktex/Util/PathName>
 
 MIKTEX_CORE_BEGIN_NAMESPACE;
 
+/// Hints on how the memory-mapped file will be accessed. The hints are
+/// ignored where the operating system does not support them.
+enum class MemoryMappedFileHint
+{
+  None,
+  /// Pages will be accessed in random order (no read-ahead).
+  RandomAccess,
+  /// Pages will be accessed in sequential order (aggressive read-ahead).
+  SequentialAccess,
+  /// All pages will be needed soon: they are read in the background.
+  WillNeed,
+  /// All pages are read in before the file is returned.
+  Populate,
+  /// Map the file with huge pages.
+  HugePages
+};
+
+typedef MiKTeX::Util::OptionSet<MemoryMappedFileHint> MemoryMappedFileHintSet;
+
 /// Instances of this class provide access to memory-mapped files.
 class MIKTEXNOVTABLE MemoryMappedFile
 {
@@ -44,7 +64,20 @@ public:
   /// be opened for reading and writing.
   /// @return Returns a pointer to the block of memory.
 public:
-  virtual void* MIKTEXTHISCALL Open(const MiKTeX::Util::PathName& path, bool readWrite) = 0;
+  void* Open(const MiKTeX::Util::PathName& path, bool readWrite)
+  {
+    return Open(path, readWrite, {});
+  }
+
+  /// Maps a file into memory.
+  /// @param path The file system path to the file to be mapped.
+  /// @param readWrite Indicates whether the file should
+  /// be opened for reading and writing.
+  /// @param hints Hints on how the file will be accessed. The hints also
+  /// apply, when the file is resized.
+  /// @return Returns a pointer to the block of memory.
+public:
+  virtual void* MIKTEXTHISCALL Open(const MiKTeX::Util::PathName& path, bool readWrite, MemoryMappedFileHintSet hints) = 0;
 
   /// Closes the file mapping.
 public:
@@ -197,6 +197,19 @@ struct ProcessInfo
   int parent = -1;
 };
 
+/// The result of a process run by `Process::RunAll()`.
+struct ProcessRunResult
+{
+  /// How the process finished.
+  ProcessExitStatus exitStatus = ProcessExitStatus::None;
+
+  /// The exit code, if the process has exited.
+  int exitCode = -1;
+
+  /// The output (`stdout` and `stderr`) of the process.
+  std::string output;
+};
+
 /// An instance of this class manages a child process.
 class MIKTEXNOVTABLE Process
 {
@@ -394,6 +407,15 @@ public:
 public:
   static MIKTEXCORECEEAPI(std::unique_ptr<Process>) Start(const ProcessStartInfo& startinfo);
 
+  /// Runs processes concurrently and collects their output.
+  /// The output of all running processes is read by the calling thread.
+  /// @param startInfos The process start options. The redirection options
+  /// are ignored.
+  /// @param maxConcurrency The maximum number of processes running at a time.
+  /// @return Returns the results, in the order of `startInfos`.
+public:
+  static MIKTEXCORECEEAPI(std::vector<ProcessRunResult>) RunAll(const std::vector<ProcessStartInfo>& startInfos, std::size_t maxConcurrency);
+
   /// Starts a process.
   /// @param fileName The name of an executable file to run in the process.
   /// @param arguments The command-line arguments to pass when starting
@@ -428,6 +450,35 @@ public:
   static MIKTEXCORECEEAPI(void) Overlay(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments);
 };
 
+/// Reads the pipes of several child processes on one thread.
+///
+/// A pipe is read whenever data is available, i.e., no child process
+/// blocks because nobody empties its pipe.
+class MIKTEXNOVTABLE PipeMultiplexer
+{
+public:
+  virtual MIKTEXTHISCALL ~PipeMultiplexer() noexcept = 0;
+
+  /// Adds a pipe. Can also be called by a callback, while the pipes are
+  /// being read.
+  /// @param pipe The read end of the pipe. It must not have been read
+  /// from yet, and it remains open.
+  /// @param callback The output function. Called with the data read from
+  /// the pipe, and called with `n == 0` at the end of the data. Stops
+  /// reading the pipe, if the output function returns `false`.
+public:
+  virtual void MIKTEXTHISCALL Add(FILE* pipe, std::function<bool(const void*, std::size_t)> callback) = 0;
+
+  /// Reads the pipes until no pipe is left.
+public:
+  virtual void MIKTEXTHISCALL Run() = 0;
+
+  /// Creates a new `PipeMultiplexer` object.
+  /// @return Returns a smart pointer to the new object.
+public:
+  static MIKTEXCORECEEAPI(std::unique_ptr<PipeMultiplexer>) Create();
+};
+
 MIKTEX_CORE_END_NAMESPACE;
 
 #endif
@@ -260,6 +260,24 @@ struct FileInfoRecord
   FileAccess access = FileAccess::None;
 };
 
+/// Page box of an included PDF file.
+struct PdfBoxInfo
+{
+  /// The lower left and the upper right corner of the box, in PDF units.
+  double llx = 0;
+  double lly = 0;
+  double urx = 0;
+  double ury = 0;
+  /// The value of the `/Rotate` entry of the page.
+  int rotate = 0;
+  /// The number of pages of the PDF file.
+  int pageCount = 0;
+  /// The PDF version (e.g., `17` for PDF 1.7).
+  int pdfVersion = 0;
+  /// `true`, if the page has a page group.
+  bool hasPageGroup = false;
+};
+
 /// User information.
 struct MiKTeXUserInfo
 {
@@ -750,6 +768,53 @@ public:
   /// @return Returns `true`, if it is an output file.
   virtual bool MIKTEXTHISCALL IsOutputFile(const FILE* file) = 0;
 
+  /// Reads a font metric file (TFM, OFM or VF).
+  /// @param path The file system path to the font metric file.
+  /// @return Returns the contents of the file.  The contents come from the font
+  /// metric cache, if enabled and the file has not changed since it was cached.
+  virtual std::vector<unsigned char> MIKTEXTHISCALL ReadFontMetricFile(const MiKTeX::Util::PathName& path) = 0;
+
+  /// Tests whether the font metric cache is enabled.
+  /// @return Returns `true`, if `ReadFontMetricFile()` can serve cached contents.
+  virtual bool MIKTEXTHISCALL IsFontMetricCacheEnabled() = 0;
+
+  /// Gets a cached page box of a PDF file.
+  /// @param path The file system path to the PDF file.
+  /// @param page The page number.
+  /// @param boxName The name of the box, qualified by the program which has
+  /// computed it (e.g., `pdftex/crop`).
+  /// @param[out] info The page box.
+  /// @return Returns `true`, if the PDF file has not changed since the box
+  /// was cached.
+  virtual bool MIKTEXTHISCALL TryGetPdfBoxInfo(const MiKTeX::Util::PathName& path, int page, const std::string& boxName, PdfBoxInfo& info) = 0;
+
+  /// Caches a page box of a PDF file.
+  /// @param path The file system path to the PDF file.
+  /// @param page The page number.
+  /// @param boxName The name of the box.
+  /// @param info The page box.
+  virtual void MIKTEXTHISCALL SetPdfBoxInfo(const MiKTeX::Util::PathName& path, int page, const std::string& boxName, const PdfBoxInfo& info) = 0;
+
+  /// Adds a span to the build timeline.
+  /// Does nothing, unless the environment variable `MIKTEX_BUILD_TRACE_FILE`
+  /// names the trace file.
+  /// @param category The category of the span (e.g., `install`).
+  /// @param name The name of the span.
+  /// @param start The start of the span.
+  /// @param end The end of the span.
+  virtual void MIKTEXTHISCALL AddBuildTraceSpan(const std::string& category, const std::string& name, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end) = 0;
+
+  /// Prepares the session for `fork()`.
+  /// Stops the background threads of the session, so that the child process
+  /// does not inherit locked mutexes and shared notification channels.
+  virtual void MIKTEXTHISCALL BeforeFork() = 0;
+
+  /// Restores the session after `fork()`.
+  /// The parent process restarts the background threads; the child process
+  /// does without them.
+  /// @param child `true`, if this is the child process.
+  virtual void MIKTEXTHISCALL AfterFork(bool child) = 0;
+
 #if defined(MIKTEX_WINDOWS)
   /// Tests if a file as been opened.
   /// @param fileName Name of the file to be checked.
@@ -785,6 +850,9 @@ public:
   /// @param How the file is accessed.
   virtual void MIKTEXTHISCALL RecordFileInfo(const MiKTeX::Util::PathName& path, FileAccess access) = 0;
 
+  /// Writes buffered file name records to the log file.
+  virtual void MIKTEXTHISCALL FlushFileInfoRecorder() = 0;
+
   /// Gets the recorded file names.
   /// @return Returns the recorded file names.
   virtual std::vector<FileInfoRecord> MIKTEXTHISCALL GetFileInfoRecords() = 0;
@@ -879,6 +947,12 @@ public:
   /// @param callback The pointer to an object which implements the interface.
   virtual void MIKTEXTHISCALL SetFindFileCallback(IFindFileCallback* callback) = 0;
 
+  /// Gets the find-file generation.
+  /// @return Returns a number which changes whenever earlier search results
+  /// may have become stale, e.g. after a package installation or when a
+  /// file was added to a search directory.
+  virtual std::size_t MIKTEXTHISCALL GetFindFileGeneration() = 0;
+
   /// Splits the file system path of a font file.
   /// @param fontPath The file system path to the font file.
   /// @param[out] fontType The font type.
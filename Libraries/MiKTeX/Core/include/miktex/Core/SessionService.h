@@ -0,0 +1,69 @@
+/* miktex/Core/SessionService.h:                        -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(58A19754080B49EFB1B897A9B790BB06)
+#define 58A19754080B49EFB1B897A9B790BB06
+
+#include <miktex/Core/config.h>
+
+#include <functional>
+
+MIKTEX_CORE_BEGIN_NAMESPACE;
+
+/// Answers the lookups of the sessions of the current user.
+///
+/// The service keeps the file name databases, the configuration files and
+/// the font name maps loaded.  A session which finds the service running
+/// hands over find-file, configuration value, PK and font info lookups,
+/// unless it uses other root directories, file name databases or
+/// environment settings than the service.
+class MIKTEXNOVTABLE SessionService
+{
+public:
+  SessionService() = delete;
+
+public:
+  SessionService(const SessionService& other) = delete;
+
+public:
+  SessionService& operator=(const SessionService& other) = delete;
+
+public:
+  SessionService(SessionService&& other) = delete;
+
+public:
+  SessionService& operator=(SessionService&& other) = delete;
+
+public:
+  ~SessionService() = delete;
+
+public:
+  /// Serves the lookups of the current session.
+  /// @param canceled Polled a few times per second; the service stops when
+  /// `true` is returned.
+  static MIKTEXCORECEEAPI(void) Run(std::function<bool()> canceled);
+};
+
+MIKTEX_CORE_END_NAMESPACE;
+
+#endif
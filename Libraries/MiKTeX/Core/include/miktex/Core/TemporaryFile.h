@@ -26,6 +26,9 @@
 
 #include <miktex/Core/config.h>
 
+#include <cstddef>
+#include <cstdio>
+
 #include <memory>
 
 #include <miktex/Util/PathName>
@@ -51,6 +54,37 @@ public:
 
 public:
   static MIKTEXCORECEEAPI(std::unique_ptr<TemporaryFile>) Create(const MiKTeX::Util::PathName& path);
+
+  /// Opens a new temporary file which has no name in the file system.
+  /// The file is deleted when it is closed, unless it has been linked
+  /// into place.
+  /// @param directory The directory which holds the data. Should be on the
+  /// file system of the final destination, if the file is to be linked into
+  /// place.
+  /// @param expectedSize The expected size (in bytes), or `0`, if unknown.
+  /// A small file is held in memory, if the operating system supports it.
+  /// @return Returns the opened file (binary, for reading and writing).
+public:
+  static MIKTEXCORECEEAPI(FILE*) OpenAnonymous(const MiKTeX::Util::PathName& directory, std::size_t expectedSize);
+
+  /// Opens a new temporary file which has no name in the file system.
+  /// @param directory The directory which holds the data.
+  /// @param expectedSize The expected size (in bytes), or `0`, if unknown.
+  /// @param unnamed Indicates whether the file can be created without a
+  /// name. Otherwise, the file is created with a name, which is removed
+  /// right away (the fallback for file systems which do not support
+  /// unnamed files).
+  /// @return Returns the opened file (binary, for reading and writing).
+public:
+  static MIKTEXCORECEEAPI(FILE*) OpenAnonymous(const MiKTeX::Util::PathName& directory, std::size_t expectedSize, bool unnamed);
+
+  /// Gives a file opened by `OpenAnonymous()` a name in the file system.
+  /// An existing file is replaced. The file remains open; its position is
+  /// undefined.
+  /// @param file The anonymous temporary file.
+  /// @param path The file system path.
+public:
+  static MIKTEXCORECEEAPI(void) LinkIntoPlace(FILE* file, const MiKTeX::Util::PathName& path);
 };
 
 MIKTEX_CORE_END_NAMESPACE;
@@ -195,6 +195,21 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) ParseDvipsFontMapLine(const std::string& line, DvipsFontMapEntry& fontMapEntry);
 
+  /// Looks up a TeX font in a dvips font map file.
+  /// An index of the map file is kept in the font map cache. The index is made
+  /// if it does not exist or if the map file has changed.
+  /// @param mapFile The path to the map file.
+  /// @param texName The name of the TeX font.
+  /// @param[out] fontMapEntry The font map entry.
+  /// @return Returns `true`, if the TeX font was found.
+public:
+  static MIKTEXCORECEEAPI(bool) FindDvipsFontMapEntry(const MiKTeX::Util::PathName& mapFile, const std::string& texName, DvipsFontMapEntry& fontMapEntry);
+
+  /// Makes the index of a dvips font map file.
+  /// @param mapFile The path to the map file.
+public:
+  static MIKTEXCORECEEAPI(void) MakeDvipsFontMapIndex(const MiKTeX::Util::PathName& mapFile);
+
 public:
   static MIKTEXCORECEEAPI(bool) IsMiKTeXDirectRoot(const MiKTeX::Util::PathName& root);
 
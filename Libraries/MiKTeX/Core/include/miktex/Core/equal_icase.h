@@ -1,6 +1,6 @@
 /* miktex/Core/equal_icase.h:                           -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -28,7 +28,7 @@
 
 #include <string>
 
-#include "Utils.h"
+#include <miktex/Util/StringUtil>
 
 MIKTEX_CORE_BEGIN_NAMESPACE;
 
@@ -37,7 +37,7 @@ struct equal_icase
 public:
   bool operator()(const std::string& str1, const std::string& str2) const
   {
-    return Utils::EqualsIgnoreCase(str1, str2);
+    return MiKTeX::Util::StringUtil::EqualsIgnoreCaseAscii(str1, str2);
   }
 };
 
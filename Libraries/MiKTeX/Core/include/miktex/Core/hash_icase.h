@@ -1,6 +1,6 @@
 /* miktex/Core/hash_icase:                              -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -28,8 +28,11 @@
 
 #include <cstddef>
 
+#include <algorithm>
 #include <string>
 
+#include <miktex/Util/StringUtil>
+
 #include "Debug.h"
 
 MIKTEX_CORE_BEGIN_NAMESPACE;
@@ -50,19 +53,22 @@ public:
     const std::size_t offset_basis = 2166136261;
 #endif
     std::size_t hash = offset_basis;
-    for (char ch : str)
+    char folded[64];
+    for (std::size_t pos = 0; pos < str.length(); pos += sizeof(folded))
     {
-      if (static_cast<unsigned>(ch) >= 128)
-      {
-        // ignore UTF-8 chars
-        continue;
-      }
-      else if (ch >= 'a' && ch <= 'z')
+      std::size_t n = std::min(sizeof(folded), str.length() - pos);
+      MiKTeX::Util::StringUtil::ToLowerAscii(folded, str.data() + pos, n);
+      for (std::size_t idx = 0; idx < n; ++idx)
       {
-        ch = 'A' + (ch - 'a');
+        unsigned char ch = static_cast<unsigned char>(folded[idx]);
+        if (ch >= 128)
+        {
+          // ignore UTF-8 chars
+          continue;
+        }
+        hash ^= ch;
+        hash *= FNV_prime;
       }
-      hash ^= (std::size_t)ch;
-      hash *= FNV_prime;
     }
     return hash;
   }
@@ -77,6 +77,9 @@ CORE_INTERNAL_BEGIN_NAMESPACE;
 
 #define INVALID_ARGUMENT(argumentName, argumentValue) MIKTEX_FATAL_ERROR_2(T_("MiKTeX encountered an internal error."), argumentName, argumentValue)
 
+#define FNDB_DAMAGED_2(description, ...) \
+  ThrowFndbDamaged(description, MiKTeX::Core::MiKTeXException::KVMAP(__VA_ARGS__), MIKTEX_SOURCE_LOCATION())
+
 #define OUT_OF_MEMORY(function) MIKTEX_INTERNAL_ERROR()
 
 #define UNIMPLEMENTED() MIKTEX_INTERNAL_ERROR()
@@ -145,6 +148,15 @@ const char PATH_DELIMITER = ':';
 
 const char* const RECURSION_INDICATOR = "//";
 const size_t RECURSION_INDICATOR_LENGTH = 2;
+const size_t FIND_FILE_MISS_CACHE_CAPACITY = 4096;
+// candidates are checked on several threads, if there are at least this many
+const size_t FIND_FILE_PARALLEL_CHECK_THRESHOLD = 4;
+const size_t FIND_FILE_MAX_CHECK_THREADS = 8;
+const size_t MAX_COMPILED_SEARCH_PATHS = 64;
+const int FNDB_CHANGE_FILE_COMPACTION_THRESHOLD = 1000;
+// a process which had to replay this many change file entries folds them in
+// for the processes to come
+const int FNDB_CHANGE_FILE_PUBLISH_THRESHOLD = 100;
 const char* const SESSIONSVC = "sessionsvc";
 
 // The virtual TEXMF root MPM_ROOT_PATH is assigned to the MiKTeX
@@ -190,6 +202,8 @@ void FatalOpenSSLError();
 RSA_ptr LoadPublicKey_OpenSSL(const MiKTeX::Util::PathName& publicKeyFile);
 #endif
 
+bool CompactFileNameDatabase(const MiKTeX::Util::PathName& fndbPath, const MiKTeX::Util::PathName& rootPath);
+
 void CreateDirectoryPath(const MiKTeX::Util::PathName& path);
 
 bool FileIsOnROMedia(const char* path);
@@ -234,10 +248,18 @@ bool HaveEnvironmentString(const char* name);
 
 bool GetEnvironmentString(const std::string& name, std::string& value);
 
+unsigned GetEnvironmentGeneration();
+
+void OnEnvironmentChanged();
+
 bool IsExplicitlyRelativePath(const char* path);
 
+void MIKTEXNORETURN ThrowFndbDamaged(const std::string& description, const MiKTeX::Core::MiKTeXException::KVMAP& info, const MiKTeX::Core::SourceLocation& sourceLocation);
+
 std::string MakeSearchPath(const std::vector<MiKTeX::Util::PathName>& vec);
 
+std::string JsonString(const std::string& s);
+
 void RemoveDirectoryDelimiter(char* path);
 
 #if defined(MIKTEX_WINDOWS) && REPORT_EVENTS
@@ -0,0 +1,181 @@
+/* 2.cpp: Cfg parser tests
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Cfg>
+#include <miktex/Core/File>
+#include <miktex/Core/StreamWriter>
+#include <miktex/Core/Utils>
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Util;
+
+const PathName MANIFESTS_FILE("package-manifests.ini");
+
+constexpr int PACKAGE_COUNT = 5000;
+
+// flattened contents: "key\nvalue" => values
+typedef map<string, vector<string>> Contents;
+
+Contents GetContents(Cfg& cfg)
+{
+  Contents contents;
+  for (auto key : cfg)
+  {
+    for (auto val : *key)
+    {
+      contents[Utils::MakeLower(key->GetName()) + "\n" + Utils::MakeLower(val->GetName())] = val->AsStringVector();
+    }
+  }
+  return contents;
+}
+
+// reads the text in place (memory-mapped) and as a stream; both parsers
+// must agree
+Contents ReadText(const string& text)
+{
+  const PathName path("edge-case.ini");
+  File::WriteBytes(path, vector<unsigned char>(text.begin(), text.end()));
+  shared_ptr<Cfg> mapped = Cfg::Create();
+  mapped->Read(path);
+  shared_ptr<Cfg> streamed = Cfg::Create();
+  ifstream reader = File::CreateInputStream(path);
+  streamed->Read(reader);
+  reader.close();
+  Contents contents = GetContents(*mapped);
+  if (contents != GetContents(*streamed))
+  {
+    throw runtime_error("the parsers disagree");
+  }
+  return contents;
+}
+
+BEGIN_TEST_SCRIPT("cfg-2");
+
+BEGIN_TEST_FUNCTION(1);
+{
+  // a file which looks like package-manifests.ini
+  StreamWriter writer(MANIFESTS_FILE);
+  for (int pkg = 0; pkg < PACKAGE_COUNT; ++pkg)
+  {
+    writer.WriteLine("[package" + std::to_string(pkg) + "]");
+    writer.WriteLine("displayName=Package " + std::to_string(pkg));
+    writer.WriteLine("creator=mpc");
+    writer.WriteLine("title=The package number " + std::to_string(pkg));
+    writer.WriteLine("version=1.0." + std::to_string(pkg));
+    writer.WriteLine("description[]=This is a package.");
+    writer.WriteLine("description[]=It contains a couple of files.");
+    writer.WriteLine("runSize=123456");
+    for (int file = 0; file < 20; ++file)
+    {
+      writer.WriteLine("run[]=texmf/tex/latex/package" + std::to_string(pkg) + "/file" + std::to_string(file) + ".sty");
+    }
+    writer.WriteLine("timePackaged=1700000000");
+    writer.WriteLine("digest=0123456789abcdef0123456789abcdef");
+    writer.WriteLine("ctanPath=/macros/latex/contrib/package" + std::to_string(pkg));
+  }
+  writer.Close();
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  shared_ptr<Cfg> mapped = Cfg::Create();
+  TESTX(mapped->Read(MANIFESTS_FILE));
+  shared_ptr<Cfg> streamed = Cfg::Create();
+  ifstream reader = File::CreateInputStream(MANIFESTS_FILE);
+  TESTX(streamed->Read(reader));
+  reader.close();
+  TEST(mapped->GetSize() == PACKAGE_COUNT);
+  TEST(GetContents(*mapped) == GetContents(*streamed));
+  vector<string> run;
+  TEST(mapped->TryGetValueAsStringVector("PACKAGE42", "run[]", run));
+  TEST(run.size() == 20 && run[19] == "texmf/tex/latex/package42/file19.sty");
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  // CRLF line endings
+  Contents contents = ReadText("[Key]\r\nname=value\r\nlist[]=a\r\nlist[]=b\r\n");
+  TEST(contents.size() == 2);
+  TEST(contents["key\nname"] == vector<string>{ "value" });
+  TEST((contents["key\nlist[]"] == vector<string>{ "a", "b" }));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(4);
+{
+  // no newline at the end of the last line
+  Contents contents = ReadText("[key]\nfirst=1\nlast=2");
+  TEST(contents.size() == 2);
+  TEST(contents["key\nlast"] == vector<string>{ "2" });
+  contents = ReadText("[key]\r\nlast=2\r");
+  TEST(contents.size() == 1);
+  TEST(contents["key\nlast"] == vector<string>{ "2" });
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(5);
+{
+  // an empty file cannot be mapped into memory
+  TEST(ReadText("").empty());
+  TEST(ReadText("\n\n").empty());
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(6);
+{
+  // the last definition of a value wins; a key can be continued
+  Contents contents = ReadText("[key]\nname=first\nNAME=second\n[other]\nx=1\n[KEY]\nname=third\n");
+  TEST(contents.size() == 2);
+  TEST(contents["key\nname"] == vector<string>{ "third" });
+  TEST(contents["other\nx"] == vector<string>{ "1" });
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
@@ -29,9 +29,11 @@
 #include <memory>
 #include <string>
 
+#include <miktex/Configuration/ConfigNames>
 #include <miktex/Configuration/HasNamedValues>
 #include <miktex/Core/Session>
 
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Test;
 using namespace MiKTeX::Util;
@@ -137,10 +139,45 @@ BEGIN_TEST_FUNCTION(2);
 }
 END_TEST_FUNCTION();
 
+// expansions are memoized: they must follow configuration changes
+BEGIN_TEST_FUNCTION(3);
+{
+  pSession->SetConfigValue(MIKTEX_CONFIG_SECTION_NONE, "ExpansionTestA", ConfigValue("one"));
+  pSession->SetConfigValue(MIKTEX_CONFIG_SECTION_NONE, "ExpansionTestB", ConfigValue("[$ExpansionTestA]"));
+  TEST(pSession->Expand("x$ExpansionTestA") == "xone");
+  TEST(pSession->Expand("x$ExpansionTestA") == "xone");
+  TEST(pSession->Expand("x$ExpansionTestB") == "x[one]");
+  pSession->SetConfigValue(MIKTEX_CONFIG_SECTION_NONE, "ExpansionTestA", ConfigValue("two"));
+  TEST(pSession->Expand("x$ExpansionTestA") == "xtwo");
+  // the dependency of a dependency has changed
+  TEST(pSession->Expand("x$ExpansionTestB") == "x[two]");
+  pSession->SetConfigValue(MIKTEX_CONFIG_SECTION_NONE, "ExpansionTestB", ConfigValue("($ExpansionTestA)"));
+  TEST(pSession->Expand("x$ExpansionTestB") == "x(two)");
+}
+END_TEST_FUNCTION();
+
+// values taken from the environment can change behind our back
+BEGIN_TEST_FUNCTION(4);
+{
+  TEST(pSession->Expand("${ExpansionTestC}") == "${ExpansionTestC}");
+  putenv("ExpansionTestC=one");
+  TEST(pSession->Expand("${ExpansionTestC}") == "one");
+  TEST(pSession->Expand("$ExpansionTestA$ExpansionTestC") == "twoone");
+  putenv("ExpansionTestC=two");
+  TEST(pSession->Expand("${ExpansionTestC}") == "two");
+  // the untracked lookup makes the whole expansion uncacheable
+  TEST(pSession->Expand("$ExpansionTestA$ExpansionTestC") == "twotwo");
+  pSession->SetConfigValue(MIKTEX_CONFIG_SECTION_NONE, "ExpansionTestA", ConfigValue("three"));
+  TEST(pSession->Expand("$ExpansionTestA$ExpansionTestC") == "threetwo");
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
 }
 END_TEST_PROGRAM();
 
@@ -120,12 +120,90 @@ BEGIN_TEST_FUNCTION(4);
 }
 END_TEST_FUNCTION();
 
+// lookups through the hash index of the mapped FNDB
+BEGIN_TEST_FUNCTION(5);
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName dirA = installRoot / "hashindex" / "a";
+  PathName dirB = installRoot / "hashindex" / "b";
+  TESTX(Directory::Create(dirA));
+  TESTX(Directory::Create(dirB));
+  for (int n = 0; n < 200; ++n)
+  {
+    Touch(dirA / ("file-" + to_string(n) + ".txt"));
+  }
+  Touch(dirB / "file-0.txt");
+  unsigned installRootIdx = pSession->DeriveTEXMFRoot(installRoot);
+  TEST(Fndb::Create(pSession->GetFilenameDatabasePathName(installRootIdx), installRoot, nullptr));
+  TESTX(pSession->UnloadFilenameDatabase());
+  PathName path;
+  for (int n = 0; n < 200; ++n)
+  {
+    TEST(pSession->FindFile("file-" + to_string(n) + ".txt", "%R/hashindex//", path));
+    TEST(path == dirA / ("file-" + to_string(n) + ".txt") || n == 0);
+  }
+  TEST(!pSession->FindFile("file-200.txt", "%R/hashindex//", path));
+  TEST(!pSession->FindFile("file-2000.txt", "%R/hashindex//", path));
+  // files with the same name are in the same hash chain
+  vector<PathName> paths;
+  TEST(pSession->FindFile("file-0.txt", "%R/hashindex//", paths));
+  TEST(paths.size() == 2);
+  TEST(Fndb::FileExists(dirA / "file-199.txt"));
+  TEST(!Fndb::FileExists(dirB / "file-199.txt"));
+}
+END_TEST_FUNCTION();
+
+// entries of the change file are found along with the hash index entries
+BEGIN_TEST_FUNCTION(6);
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName dirC = installRoot / "hashindex" / "c";
+  vector<Fndb::Record> records;
+  for (int n = 0; n < 10; ++n)
+  {
+    records.push_back({ dirC / ("added-" + to_string(n) + ".txt"), "" });
+  }
+  TESTX(Fndb::Add(records));
+  for (int n = 0; n < 10; ++n)
+  {
+    TEST(Fndb::FileExists(dirC / ("added-" + to_string(n) + ".txt")));
+  }
+  TEST(Fndb::FileExists(installRoot / "hashindex" / "a" / "file-0.txt"));
+  // the change file is replayed when the FNDB is mapped again
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(Fndb::FileExists(dirC / "added-0.txt"));
+  TEST(Fndb::FileExists(dirC / "added-9.txt"));
+  TESTX(Fndb::Remove({ dirC / "added-0.txt" }));
+  TEST(!Fndb::FileExists(dirC / "added-0.txt"));
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(!Fndb::FileExists(dirC / "added-0.txt"));
+  TEST(Fndb::FileExists(dirC / "added-1.txt"));
+  // enough changes to fold the change file into the FNDB: the entries are
+  // then found through the hash index
+  records.clear();
+  for (int n = 10; n < 1100; ++n)
+  {
+    records.push_back({ dirC / ("added-" + to_string(n) + ".txt"), "" });
+  }
+  TESTX(Fndb::Add(records));
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(!Fndb::FileExists(dirC / "added-0.txt"));
+  TEST(Fndb::FileExists(dirC / "added-1.txt"));
+  TEST(Fndb::FileExists(dirC / "added-10.txt"));
+  TEST(Fndb::FileExists(dirC / "added-1099.txt"));
+  TEST(!Fndb::FileExists(dirC / "added-1100.txt"));
+  TEST(Fndb::FileExists(installRoot / "hashindex" / "a" / "file-199.txt"));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
 }
 END_TEST_PROGRAM();
 
@@ -25,7 +25,9 @@
 
 #include <chrono>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
@@ -41,6 +43,12 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Test;
 using namespace MiKTeX::Util;
 
+// older versions do not lock the file: its contents tell the owner
+void WriteLockFile(const PathName& path, const string& contents)
+{
+  File::WriteBytes(path, vector<unsigned char>(contents.begin(), contents.end()));
+}
+
 BEGIN_TEST_SCRIPT("lockfile-1");
 
 BEGIN_TEST_FUNCTION(1);
@@ -96,12 +104,60 @@ BEGIN_TEST_FUNCTION(4);
 }
 END_TEST_FUNCTION();
 
+// a stale lock file is taken over
+BEGIN_TEST_FUNCTION(5);
+{
+  PathName path("lockfile-stale");
+  unique_ptr<Process> parent = Process::GetCurrentProcess()->get_Parent();
+  TEST(parent != nullptr);
+  // the owner process has a different name: the PID has been reused
+  WriteLockFile(path, to_string(parent->GetSystemId()) + "\n" + parent->get_ProcessName() + "-gone\n");
+  unique_ptr<MiKTeX::Core::LockFile> lockFile = LockFile::Create(path);
+  TEST(lockFile->TryLock(0s));
+  lockFile->Unlock();
+  TEST(!File::Exists(path));
+}
+END_TEST_FUNCTION();
+
+// unparsable contents: the owner may still be writing the file
+BEGIN_TEST_FUNCTION(6);
+{
+  PathName path("lockfile-garbage");
+  WriteLockFile(path, "garbage\n");
+  unique_ptr<MiKTeX::Core::LockFile> lockFile = LockFile::Create(path);
+  TEST(!lockFile->TryLock(0s));
+  TEST(!lockFile->TryLock(500ms));
+  TESTX(File::Delete(path));
+  TEST(lockFile->TryLock(0s));
+  lockFile->Unlock();
+}
+END_TEST_FUNCTION();
+
+// a lock file of a running process is not taken over
+BEGIN_TEST_FUNCTION(7);
+{
+  PathName path("lockfile-busy");
+  unique_ptr<Process> parent = Process::GetCurrentProcess()->get_Parent();
+  TEST(parent != nullptr);
+  WriteLockFile(path, to_string(parent->GetSystemId()) + "\n" + parent->get_ProcessName() + "\n");
+  unique_ptr<MiKTeX::Core::LockFile> lockFile = LockFile::Create(path);
+  TEST(!lockFile->TryLock(500ms));
+  // permanently locked
+  WriteLockFile(path, "-1\n\n");
+  TEST(!lockFile->TryLock(500ms));
+  TESTX(File::Delete(path));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
+  CALL_TEST_FUNCTION(7);
 }
 END_TEST_PROGRAM();
 
@@ -13,11 +13,14 @@
 
 #include "config.h"
 
+#include <cctype>
+
 #include <miktex/Core/Test>
 #include <miktex/Core/Utils>
 
 #include <miktex/Util/PathName>
 #include <miktex/Util/PathNameParser>
+#include <miktex/Util/PathNameView>
 
 #if defined(MIKTEX_WINDOWS)
 #include <direct.h>
@@ -263,6 +266,86 @@ BEGIN_TEST_FUNCTION(15);
 }
 END_TEST_FUNCTION();
 
+int Sign(int n)
+{
+    return n < 0 ? -1 : n > 0 ? 1 : 0;
+}
+
+BEGIN_TEST_FUNCTION(16);
+{
+    PathName path("/abc/def/ghi.jkl");
+    string str = path.ToString();
+    PathNameView view(path);
+    TEST(view.GetLength() == str.length());
+    TEST(view.ToString() == str);
+    TEST(PathNameView::Equals(view, PathNameView(str)));
+    TEST(PathNameView::Equals(view, "/abc/def/ghi.jkl"));
+    TEST(view.ToPathName() == path);
+    TEST(view.IsAbsolute());
+    TEST(!PathNameView("abc/def").IsAbsolute());
+    TEST(PathNameView().Empty());
+    TEST(view.GetFileName().ToString() == "ghi.jkl");
+    TEST(PathNameView("ghi.jkl").GetFileName().ToString() == "ghi.jkl");
+    TEST(PathNameView("/abc/").GetFileName().Empty());
+    // a trailing slash does not count
+    TEST(PathNameView::Equals("/abc/def", "/abc/def/"));
+    TEST(PathNameView::Equals("/abc/def/", "/abc/def"));
+    TEST(!PathNameView::Equals("/abc/def", "/abc/def/g"));
+    TEST(PathNameView::Compare("/abc/a", "/abc/b") < 0);
+    TEST(PathNameView::Compare("/abc/b", "/abc/a") > 0);
+    TEST(PathNameView::Compare("/abc", "/abcd") < 0);
+    TEST(PathNameView::Compare("/abcd", "/abc") > 0);
+    TEST(PathNameView::Compare("", "") == 0);
+#if defined(MIKTEX_WINDOWS)
+    TEST(PathNameView::Equals("/ABC/Def", "/abc/dEF"));
+    TEST(PathNameView::Equals("C:\\abc\\def", "c:/ABC/def"));
+    TEST(PathNameView::Equals("C:\\abc\\def\\", "c:/ABC/def"));
+    TEST(PathNameView::Compare("/abc/A", "/abc/b") < 0);
+#else
+    TEST(!PathNameView::Equals("/ABC/Def", "/abc/dEF"));
+#endif
+}
+END_TEST_FUNCTION();
+
+// the comparison follows the PathName rules, around the vector block sizes
+BEGIN_TEST_FUNCTION(17);
+{
+    for (size_t n : { 15, 16, 17, 31, 32, 33, 64, 300 })
+    {
+        string s1 = "/";
+        while (s1.length() < n)
+        {
+            s1 += s1.length() % 8 == 0 ? '/' : static_cast<char>('a' + s1.length() % 26);
+        }
+        string s2 = s1;
+        s2[n - 1] = s1[n - 1] == 'z' ? 'y' : 'z';
+        TEST(PathNameView::Equals(s1, PathName(s1)));
+        TEST(!PathNameView::Equals(s1, s2));
+        TEST(Sign(PathNameView::Compare(s1, s2)) == Sign(s1.compare(s2)));
+        TEST(Sign(PathNameView::Compare(s1, s2)) == Sign(PathName::Compare(PathName(s1), PathName(s2))));
+#if defined(MIKTEX_WINDOWS)
+        // the slow path (backslashes) agrees with the fast path
+        string upper = s1;
+        for (char& ch : upper)
+        {
+            ch = ch == '/' ? '\\' : static_cast<char>(toupper(ch));
+        }
+        TEST(PathNameView::Equals(s1, upper));
+        TEST(Sign(PathNameView::Compare(upper, s2)) == Sign(PathNameView::Compare(s1, s2)));
+#endif
+        // copies and moves hold the same path name
+        PathName path(s1);
+        PathName copy = path;
+        TEST(copy == path);
+        TEST(copy.GetLength() == n);
+        PathName moved = std::move(copy);
+        TEST(moved == path);
+        copy = moved;
+        TEST(copy.ToString() == s1);
+    }
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
     CALL_TEST_FUNCTION(1);
@@ -282,6 +365,8 @@ BEGIN_TEST_PROGRAM();
     CALL_TEST_FUNCTION(14);
 #endif
     CALL_TEST_FUNCTION(15);
+    CALL_TEST_FUNCTION(16);
+    CALL_TEST_FUNCTION(17);
 }
 END_TEST_PROGRAM();
 
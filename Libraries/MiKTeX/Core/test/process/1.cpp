@@ -138,6 +138,37 @@ BEGIN_TEST_FUNCTION(5);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(6);
+{
+  PathName pathEcho = pSession->GetMyLocation(false);
+  pathEcho /= "core_process_test1-2" MIKTEX_EXE_FILE_SUFFIX;
+  PathName pathFail = pSession->GetMyLocation(false);
+  pathFail /= "core_process_test1-3" MIKTEX_EXE_FILE_SUFFIX;
+  vector<ProcessStartInfo> startInfos;
+  for (int idx = 0; idx < 10; ++idx)
+  {
+    ProcessStartInfo startInfo(idx == 5 ? pathFail : pathEcho);
+    startInfo.Arguments = { startInfo.FileName, "hello", std::to_string(idx) };
+    startInfos.push_back(startInfo);
+  }
+  vector<ProcessRunResult> results = Process::RunAll(startInfos, 3);
+  TEST(results.size() == startInfos.size());
+  for (int idx = 0; idx < 10; ++idx)
+  {
+    TEST(results[idx].exitStatus == ProcessExitStatus::Exited);
+    if (idx == 5)
+    {
+      TEST(results[idx].exitCode == 1);
+    }
+    else
+    {
+      TEST(results[idx].exitCode == 0);
+      TEST(results[idx].output == "hello\n" + std::to_string(idx) + "\n");
+    }
+  }
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -145,6 +176,7 @@ BEGIN_TEST_PROGRAM();
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
   CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
 }
 END_TEST_PROGRAM();
 
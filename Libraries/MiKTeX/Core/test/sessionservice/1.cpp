@@ -0,0 +1,98 @@
+/* 1.cpp:
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <string>
+#include <vector>
+
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Paths>
+#include <miktex/Util/PathName>
+
+#include "internal.h"
+
+#include "SessionService/SessionServiceChannel.h"
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Util;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("sessionservice-1");
+
+BEGIN_TEST_FUNCTION(1);
+{
+  vector<vector<string>> tests = {
+    { "" },
+    { "hello" },
+    { "", "" },
+    { "config", "latex;tex;miktex", "Core", "" },
+    { "a\tb", "c\nd", "e\rf" },
+    { "\\", "\\t", "a\\\tb\\" },
+    { "found", "C:\\texmf\\tex\\latex\\base\\article.cls" },
+  };
+  for (const vector<string>& fields : tests)
+  {
+    string line = SessionServiceChannel::JoinFields(fields);
+    // a line must remain a line
+    TEST(line.find('\n') == string::npos);
+    TEST(line.find('\r') == string::npos);
+    TEST(SessionServiceChannel::SplitFields(line) == fields);
+  }
+  TEST(SessionServiceChannel::JoinFields({ "a", "b" }) == "a\tb");
+  TEST(SessionServiceChannel::SplitFields("a\\tb\tc") == vector<string>({ "a\tb", "c" }));
+  // a trailing backslash is kept
+  TEST(SessionServiceChannel::SplitFields("a\\") == vector<string>({ "a\\" }));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  // the service is not running: lookups are done by the session itself
+  TEST(!File::Exists(pSession->GetSpecialPath(SpecialPath::UserDataRoot) / MIKTEX_PATH_SESSION_SERVICE_ENDPOINT));
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  unsigned installRootIdx = pSession->DeriveTEXMFRoot(installRoot);
+  TEST(Fndb::Create(pSession->GetFilenameDatabasePathName(installRootIdx), installRoot, nullptr));
+  PathName path;
+  TEST(pSession->FindFile("test.tex", "%R/tex//", path));
+  TEST(!pSession->FindFile("abrakadabra.tex", "%R/tex//", path));
+  pSession->SetConfigValue("SessionService", "Value", ConfigValue("a\tb"));
+  TEST(pSession->GetConfigValue("SessionService", "Value").GetString() == "a\tb");
+  pSession->SetConfigValue("SessionService", "Value", ConfigValue("c"));
+  TEST(pSession->GetConfigValue("SessionService", "Value").GetString() == "c");
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
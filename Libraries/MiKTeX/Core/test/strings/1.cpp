@@ -26,8 +26,13 @@
 #include <cstring>
 
 #include <functional>
+#include <string>
+#include <vector>
 
 #include <miktex/Core/ci_string>
+#include <miktex/Core/equal_icase>
+#include <miktex/Core/hash_icase>
+#include <miktex/Util/StringUtil>
 
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Test;
@@ -36,6 +41,30 @@ using namespace std;
 
 BEGIN_TEST_SCRIPT("strings-1");
 
+// around the SSE2/NEON (16) and AVX2 (32) block sizes
+const vector<size_t> lengths = { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65 };
+
+string MixedCase(size_t n)
+{
+  string s;
+  for (size_t idx = 0; idx < n; ++idx)
+  {
+    char ch = static_cast<char>('a' + idx % 26);
+    s += idx % 2 == 0 ? ch : static_cast<char>(ch - 'a' + 'A');
+  }
+  return s;
+}
+
+string LowerCase(size_t n)
+{
+  string s;
+  for (size_t idx = 0; idx < n; ++idx)
+  {
+    s += static_cast<char>('a' + idx % 26);
+  }
+  return s;
+}
+
 BEGIN_TEST_FUNCTION(1);
 {
   ci_string s("AbCdE");
@@ -63,11 +92,82 @@ BEGIN_TEST_FUNCTION(3);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(4);
+{
+  for (size_t n : lengths)
+  {
+    string s = MixedCase(n);
+    TEST(StringUtil::IsAscii(s.c_str(), n));
+    string lower(n, '?');
+    StringUtil::ToLowerAscii(&lower[0], s.c_str(), n);
+    TEST(lower == LowerCase(n));
+    string inPlace = s;
+    StringUtil::ToLowerAscii(&inPlace[0], inPlace.c_str(), n);
+    TEST(inPlace == LowerCase(n));
+    if (n == 0)
+    {
+      continue;
+    }
+    // a non-ASCII byte in the first and in the last lane
+    for (size_t pos : { size_t(0), n - 1 })
+    {
+      string utf8 = s;
+      utf8[pos] = '\xC3';
+      TEST(!StringUtil::IsAscii(utf8.c_str(), n));
+      StringUtil::ToLowerAscii(&lower[0], utf8.c_str(), n);
+      TEST(lower[pos] == '\xC3');
+    }
+    // the bytes around 'A'..'Z' are not letters
+    string others(n, '@');
+    others[n - 1] = '[';
+    StringUtil::ToLowerAscii(&lower[0], others.c_str(), n);
+    TEST(lower == others);
+  }
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(5);
+{
+  for (size_t n : lengths)
+  {
+    string s = MixedCase(n);
+    string lower = LowerCase(n);
+    TEST(StringUtil::MismatchIgnoreCaseAscii(s.c_str(), lower.c_str(), n) == n);
+    TEST(StringUtil::EqualsIgnoreCaseAscii(s, lower));
+    TEST(equal_icase()(s, lower));
+    TEST(hash_icase()(s) == hash_icase()(lower));
+    for (size_t pos = 0; pos < n; ++pos)
+    {
+      string other = lower;
+      other[pos] = '0';
+      TEST(StringUtil::MismatchIgnoreCaseAscii(s.c_str(), other.c_str(), n) == pos);
+    }
+    if (n == 0)
+    {
+      continue;
+    }
+    // a mismatch in the last lane
+    string other = lower;
+    // '@' and '`' differ in the case bit only: they are not letters
+    other[n - 1] = '`';
+    string s2 = s;
+    s2[n - 1] = '@';
+    TEST(StringUtil::MismatchIgnoreCaseAscii(s2.c_str(), other.c_str(), n) == n - 1);
+    TEST(!StringUtil::EqualsIgnoreCaseAscii(s2, other));
+    TEST(!equal_icase()(s2, other));
+    // the lengths differ
+    TEST(!StringUtil::EqualsIgnoreCaseAscii(s, lower.substr(0, n - 1)));
+  }
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
   CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
 }
 END_TEST_PROGRAM();
 
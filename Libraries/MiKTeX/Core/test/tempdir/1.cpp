@@ -23,12 +23,18 @@
 
 #include <miktex/Core/Test>
 
+#include <cstdio>
+
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
 #include <miktex/Core/File>
 #include <miktex/Util/PathName>
 #include <miktex/Core/TemporaryDirectory>
+#include <miktex/Core/TemporaryFile>
 
 using namespace std;
 
@@ -85,10 +91,64 @@ BEGIN_TEST_FUNCTION(2);
 }
 END_TEST_FUNCTION();
 
+size_t CountEntries(const PathName& dir)
+{
+  DirectoryListing listing;
+  DirectoryLister::ReadAll(dir, (int)DirectoryLister::Options::None, listing);
+  return listing.GetCount();
+}
+
+BEGIN_TEST_FUNCTION(3);
+{
+  unique_ptr<TemporaryDirectory> tmpDir = TemporaryDirectory::Create();
+  PathName dir = tmpDir->GetPathName();
+  string contents = "abrakadabra\n";
+  int n = 0;
+  // unnamed: held in memory (small expected size) or an unnamed file;
+  // otherwise: a named file, which is removed right away
+  for (bool unnamed : { true, false })
+  {
+    for (size_t expectedSize : { contents.length(), size_t(0) })
+    {
+      ++n;
+      PathName path = dir / ("linked-" + std::to_string(n));
+      if (n % 2 == 0)
+      {
+        // an existing file is replaced
+        Touch(path);
+      }
+      size_t nEntries = CountEntries(dir);
+      FILE* file;
+      TESTX(file = TemporaryFile::OpenAnonymous(dir, expectedSize, unnamed));
+      TEST(file != nullptr);
+#if !defined(MIKTEX_WINDOWS)
+      // on Windows, the file is listed until it is closed
+      TEST(CountEntries(dir) == nEntries);
+#endif
+      TEST(fwrite(contents.c_str(), 1, contents.length(), file) == contents.length());
+      TESTX(TemporaryFile::LinkIntoPlace(file, path));
+      TEST(fclose(file) == 0);
+      TEST(File::Exists(path));
+      vector<unsigned char> bytes = File::ReadAllBytes(path);
+      TEST(string(bytes.begin(), bytes.end()) == contents);
+    }
+  }
+  // nothing but the linked files is left behind
+  TEST(CountEntries(dir) == n);
+  // not linked: the file is gone when it is closed
+  FILE* file;
+  TESTX(file = TemporaryFile::OpenAnonymous(dir, 0));
+  TEST(fwrite(contents.c_str(), 1, contents.length(), file) == contents.length());
+  TEST(fclose(file) == 0);
+  TEST(CountEntries(dir) == n);
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
 }
 END_TEST_PROGRAM();
 
@@ -1,6 +1,6 @@
 /* DibChunker.cpp:
 
-   Copyright (C) 2002-2020 Christian Schenk
+   Copyright (C) 2002-2024 Christian Schenk
 
    This file is part of the MiKTeX DibChunker Library.
 
@@ -50,6 +50,9 @@ const RGBQUAD RGBQUAD_BLACK = { 0, 0, 0, 0 };
 
 const RGBQUAD whiteAndBlack[2] = { RGBQUAD_WHITE, RGBQUAD_BLACK };
 
+// maximum width (in pixels) of a tile
+const unsigned long tileWidth = 512;
+
 DibChunk::~DibChunk()
 {
 }
@@ -179,6 +182,11 @@ void DibChunkerImpl::ReadBitmapInfo()
 
   // get colors
   numColors = bitmapInfoHeader.biClrUsed == 0 ? CalcNumColors(bitmapInfoHeader.biBitCount) : bitmapInfoHeader.biClrUsed;
+  if (colors != nullptr)
+  {
+    delete[] colors;
+    colors = nullptr;
+  }
   if (numColors > 0)
   {
     colors = new RGBQUAD[numColors];
@@ -342,9 +350,11 @@ bool DibChunkerImpl::ReadScanLine(unsigned long& left, unsigned long& right)
 {
   unsigned long n = BytesPerLine();
 
-  if (scanLine == nullptr)
+  if (scanLine == nullptr || scanLineSize != n)
   {
+    delete[] scanLine;
     scanLine = new unsigned char[n];
+    scanLineSize = n;
   }
 
   Read(scanLine, n);
@@ -442,12 +452,124 @@ void DibChunkerImpl::Monochromize24(const unsigned char* src, unsigned char* dst
   }
 }
 
+bool DibChunkerImpl::IsWhite(const unsigned char* line, unsigned long left, unsigned long right) const
+{
+  switch (bitmapInfoHeader.biBitCount)
+  {
+  case 1:
+  {
+    unsigned char white;
+    if (GetColor(0) == RGB_WHITE)
+    {
+      white = 0;
+    }
+    else if (GetColor(1) == RGB_WHITE)
+    {
+      white = 255;
+    }
+    else
+    {
+      return false;
+    }
+    for (unsigned long idx = left; idx <= right; ++idx)
+    {
+      if (line[idx] != white)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  case 4:
+    for (unsigned long idx = left; idx <= right; ++idx)
+    {
+      if (GetColor((line[idx] >> 4) & 15) != RGB_WHITE || GetColor(line[idx] & 15) != RGB_WHITE)
+      {
+        return false;
+      }
+    }
+    return true;
+  case 8:
+    for (unsigned long idx = left; idx <= right; ++idx)
+    {
+      if (GetColor(line[idx]) != RGB_WHITE)
+      {
+        return false;
+      }
+    }
+    return true;
+  case 24:
+    for (unsigned long idx = left; idx + 2 <= right; idx += 3)
+    {
+      if (RGB(line[idx + 2], line[idx + 1], line[idx]) != RGB_WHITE)
+      {
+        return false;
+      }
+    }
+    return true;
+  default:
+    MIKTEX_UNEXPECTED();
+  }
+}
+
 void DibChunkerImpl::EndChunk()
 {
   // cut off white lines 
   numScanLines -= blankLines;
 
-  long bytesInChunk = (rightPos - leftPos + 1);
+  inChunk = false;
+
+  if ((processingFlags & CreateTiles) == 0 || numScanLines == 0)
+  {
+    ShipChunk(leftPos, rightPos, 0, numScanLines);
+    return;
+  }
+
+  // tiles must start at pixel boundaries
+  unsigned long bytesPerTile;
+  switch (bitmapInfoHeader.biBitCount)
+  {
+  case 1:
+    bytesPerTile = tileWidth / 8;
+    break;
+  case 4:
+    bytesPerTile = tileWidth / 2;
+    break;
+  case 8:
+    bytesPerTile = tileWidth;
+    break;
+  case 24:
+    bytesPerTile = tileWidth * 3;
+    break;
+  default:
+    MIKTEX_UNEXPECTED();
+  }
+
+  for (unsigned long left = leftPos; left <= rightPos; left += bytesPerTile)
+  {
+    unsigned long right = (std::min)(left + bytesPerTile - 1, rightPos);
+    // crop the tile vertically; skip white tiles
+    unsigned firstLine = 0;
+    while (firstLine < numScanLines && IsWhite(this->bits + firstLine * BytesPerLine(), left, right))
+    {
+      ++firstLine;
+    }
+    if (firstLine == numScanLines)
+    {
+      continue;
+    }
+    unsigned lastLine = numScanLines - 1;
+    while (lastLine > firstLine && IsWhite(this->bits + lastLine * BytesPerLine(), left, right))
+    {
+      --lastLine;
+    }
+    ShipChunk(left, right, firstLine, lastLine - firstLine + 1);
+  }
+}
+
+void DibChunkerImpl::ShipChunk(unsigned long left, unsigned long right, unsigned firstLine, unsigned numLines)
+{
+  long bytesInChunk = (right - left + 1);
   int x;
   long biWidth;
   long bytesPerLine;
@@ -455,23 +577,23 @@ void DibChunkerImpl::EndChunk()
   switch (bitmapInfoHeader.biBitCount)
   {
   case 1:
-    x = leftPos * 8;
+    x = left * 8;
     biWidth = bytesInChunk * 8;
     bytesPerLine = BytesPerLine(biWidth, 1);
     break;
   case 4:
-    x = leftPos * 2;
+    x = left * 2;
     biWidth = bytesInChunk * 2;
     bytesPerLine = BytesPerLine(biWidth, 4);
     break;
   case 8:
-    x = leftPos;
+    x = left;
     biWidth = bytesInChunk;
     bytesPerLine = BytesPerLine(biWidth, 8);
     break;
   case 24:
-    MIKTEX_ASSERT(leftPos % 3 == 0);
-    x = leftPos / 3;
+    MIKTEX_ASSERT(left % 3 == 0);
+    x = left / 3;
     MIKTEX_ASSERT(bytesInChunk % 3 == 0);
     biWidth = bytesInChunk / 3;
 #if 1
@@ -490,14 +612,14 @@ void DibChunkerImpl::EndChunk()
     MIKTEX_UNEXPECTED();
   }
 
-  shared_ptr<DibChunkImpl> chunk = make_shared<DibChunkImpl>(bytesPerLine, numScanLines);
+  shared_ptr<DibChunkImpl> chunk = make_shared<DibChunkImpl>(bytesPerLine, numLines);
 
   chunk->SetX(x);
 
   // make chunked bitmap info header
   BITMAPINFOHEADER bitmapinfoheader;
   bitmapinfoheader = this->bitmapInfoHeader;
-  bitmapinfoheader.biHeight = numScanLines;
+  bitmapinfoheader.biHeight = numLines;
   bitmapinfoheader.biWidth = biWidth;
   bitmapinfoheader.biSizeImage = 0;
   const RGBQUAD* colors = nullptr;
@@ -514,15 +636,15 @@ void DibChunkerImpl::EndChunk()
     colors = this->colors;
   }
   // FIXME: okay?
-  int y = yPosChunk;
+  int y = yPosChunk + firstLine;
   y += bitmapinfoheader.biHeight - 1;
   y = this->bitmapInfoHeader.biHeight - y;
   chunk->SetY(y);
   //
   unsigned char* bits = reinterpret_cast<unsigned char*>(chunk->GetBits2());
-  for (unsigned long i = 0; i < numScanLines; ++i)
+  for (unsigned long i = 0; i < numLines; ++i)
   {
-    const unsigned char* src = this->bits + i * BytesPerLine() + leftPos;
+    const unsigned char* src = this->bits + (firstLine + i) * BytesPerLine() + left;
     unsigned char* dest = bits + i * bytesPerLine;
     memset(dest, 0, bytesPerLine);
     if (monochromize24)
@@ -535,7 +657,6 @@ void DibChunkerImpl::EndChunk()
     }
   }
   trace_dib->WriteLine("libdib", fmt::format(T_("shipping chunk: x={0}, y={1}, w={2}, h={3}, monochromized=%s"), chunk->GetX(), chunk->GetY(), bitmapinfoheader.biWidth, bitmapinfoheader.biHeight, (monochromize24 ? "true" : "false")));
-  inChunk = false;
   chunk->SetBitmapInfo(bitmapinfoheader, numColors, colors);
   callback->OnNewChunk(chunk);
 }
@@ -554,7 +675,16 @@ bool DibChunkerImpl::Process(unsigned long flags, unsigned long chunkSize, IDibC
   {
     MIKTEX_UNEXPECTED();
   }
-  bits = new unsigned char[chunkSize];
+  // the chunk buffer is the only buffer whose size depends on the
+  // bitmap: it never exceeds the chunk size
+  size_t bufferSize = (std::min)(static_cast<size_t>(chunkSize), static_cast<size_t>(BytesPerLine()) * bitmapInfoHeader.biHeight);
+  if (bits == nullptr || bitsSize < bufferSize)
+  {
+    delete[] bits;
+    bits = nullptr;
+    bits = new unsigned char[bufferSize];
+    bitsSize = bufferSize;
+  }
   try
   {
     inChunk = false;
@@ -611,14 +741,13 @@ bool DibChunkerImpl::Process(unsigned long flags, unsigned long chunkSize, IDibC
     {
       EndChunk();
     }
-    delete[] bits;
-    bits = nullptr;
     return true;
   }
   catch (const exception &)
   {
     delete[] bits;
     bits = nullptr;
+    bitsSize = 0;
     throw;
   }
 }
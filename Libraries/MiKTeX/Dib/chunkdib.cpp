@@ -1,6 +1,6 @@
 /* chunkdib.cpp: test driver for the DibChunker interfaces
 
-   Copyright (C) 2002-2022 Christian Schenk
+   Copyright (C) 2002-2024 Christian Schenk
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU Library General Public License
@@ -41,6 +41,9 @@ using namespace std;
 #define Q_(x) MiKTeX::Core::Quoter<char>(x).GetData()
 #define T_(x) MIKTEXTEXT(x)
 
+// memory ceiling when chunking large bitmap files
+const unsigned long maxChunkSize = 4 * 1024 * 1024;
+
 class ChunkDib :
   public Application,
   public IDibChunkerCallback
@@ -103,6 +106,10 @@ void ChunkDib::Run(int argc, const char** argv)
     PathName fileName(argv[1]);
     prefix = fileName.GetFileNameWithoutExtension().ToString();
     chunkSize = static_cast<unsigned long>(File::GetSize(PathName(argv[1]))) / 5;
+    if (chunkSize > maxChunkSize)
+    {
+      chunkSize = maxChunkSize;
+    }
     stream.Attach(File::Open(fileName, FileMode::Open, FileAccess::Read, false));
   }
   else
@@ -116,7 +123,7 @@ void ChunkDib::Run(int argc, const char** argv)
   {
     ++nBitmaps;
     nChunks = 0;
-  } while (chunker->Process(DibChunker::Default, chunkSize, this));
+  } while (chunker->Process(DibChunker::Default | DibChunker::CreateTiles, chunkSize, this));
 }
 
 int main(int argc, char** argv)
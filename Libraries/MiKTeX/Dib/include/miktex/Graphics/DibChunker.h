@@ -1,6 +1,6 @@
 /* miktex/Graphics/DibChunker.h:                        -*- C++ -*-
 
-   Copyright (C) 2002-2018 Christian Schenk
+   Copyright (C) 2002-2024 Christian Schenk
 
    This file is part of the MiKTeX DibChunker Library.
 
@@ -92,7 +92,9 @@ public:
     RemoveBlankLines = 1,
     CreateChunks = 2,
     Crop = 4,
-    Default = 7
+    Default = 7,
+    // cut chunks into tiles; each tile is cropped on its own
+    CreateTiles = 8
   };
 
 public:
@@ -1,6 +1,6 @@
 /* internal.h:                                          -*- C++ -*-
 
-   Copyright (C) 2002-2018 Christian Schenk
+   Copyright (C) 2002-2024 Christian Schenk
 
    This file is part of the MiKTeX DibChunker Library.
 
@@ -189,6 +189,12 @@ private:
 private:
   void EndChunk();
 
+private:
+  void ShipChunk(unsigned long left, unsigned long right, unsigned firstLine, unsigned numLines);
+
+private:
+  bool IsWhite(const unsigned char* line, unsigned long left, unsigned long right) const;
+
 private:
   unsigned long BytesPerLine(long width, long bitCount) const
   {
@@ -246,6 +252,12 @@ private:
 private:
   unsigned char* bits = nullptr;
 
+private:
+  size_t bitsSize = 0;
+
+private:
+  unsigned long scanLineSize = 0;
+
 private:
   unsigned numScanLines;
 
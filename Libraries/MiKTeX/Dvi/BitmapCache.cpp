@@ -0,0 +1,109 @@
+/**
+ * @file BitmapCache.cpp
+ * @author Christian Schenk
+ * @brief Memory-budgeted cache of page rasters
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX DVI Library.
+ *
+ * The MiKTeX DVI Library is licensed under GNU Library General Public License
+ * version 2 or any later version.
+ */
+
+#include "config.h"
+
+#include "internal.h"
+
+#include "BitmapCache.h"
+
+void BitmapCache::Touch(DviPageImpl* page, int shrinkFactor)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    auto it = index.find(Key(page, shrinkFactor));
+    if (it == index.end())
+    {
+        return;
+    }
+    statistics.hits += 1;
+    // O(1): move the entry to the front
+    entries.splice(entries.begin(), entries, it->second);
+}
+
+void BitmapCache::Put(DviPageImpl* page, int shrinkFactor, size_t rasterSize)
+{
+    vector<Entry> victims;
+    {
+        lock_guard<std::mutex> lockGuard(mutex);
+        statistics.misses += 1;
+        Key key(page, shrinkFactor);
+        auto it = index.find(key);
+        if (it != index.end())
+        {
+            statistics.size -= it->second->size;
+            entries.erase(it->second);
+        }
+        entries.push_front(Entry{ page, shrinkFactor, rasterSize });
+        index[key] = entries.begin();
+        statistics.size += rasterSize;
+        // evict from the back; rasters which are in use are skipped
+        auto victim = entries.end();
+        --victim;
+        while (statistics.size > budget && victim != entries.begin())
+        {
+            auto current = victim--;
+            DviPageImpl* victimPage = current->page;
+            if (victimPage == page || victimPage->IsNearCurrentPage() || !victimPage->TryLock())
+            {
+                continue;
+            }
+            statistics.size -= current->size;
+            statistics.evictions += 1;
+            victims.push_back(*current);
+            index.erase(Key(victimPage, current->shrinkFactor));
+            entries.erase(current);
+        }
+        if (!victims.empty())
+        {
+            trace->WriteLine("libdvi", fmt::format(T_("evicted {0} rasters; {1}"), victims.size(), GetStatisticsTextNoLock()));
+        }
+    }
+    // free the evicted rasters outside the cache lock: the pages are locked
+    for (const Entry& entry : victims)
+    {
+        entry.page->FreeShrinkedRaster(entry.shrinkFactor);
+        entry.page->Unlock();
+    }
+}
+
+void BitmapCache::Remove(DviPageImpl* page, int shrinkFactor)
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    auto it = index.find(Key(page, shrinkFactor));
+    if (it == index.end())
+    {
+        return;
+    }
+    statistics.size -= it->second->size;
+    entries.erase(it->second);
+    index.erase(it);
+}
+
+BitmapCache::Statistics BitmapCache::GetStatistics()
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    Statistics result = statistics;
+    result.budget = budget;
+    return result;
+}
+
+string BitmapCache::GetStatisticsText()
+{
+    lock_guard<std::mutex> lockGuard(mutex);
+    return GetStatisticsTextNoLock();
+}
+
+string BitmapCache::GetStatisticsTextNoLock()
+{
+    return fmt::format(T_("bitmap cache: {0} hits, {1} misses, {2} evictions, {3}/{4} KB"), statistics.hits, statistics.misses, statistics.evictions, statistics.size / 1024, budget / 1024);
+}
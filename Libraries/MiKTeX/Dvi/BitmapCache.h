@@ -0,0 +1,127 @@
+/**
+ * @file BitmapCache.h
+ * @author Christian Schenk
+ * @brief Memory-budgeted cache of page rasters
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX DVI Library.
+ *
+ * The MiKTeX DVI Library is licensed under GNU Library General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <miktex/Trace/TraceStream>
+
+class DviPageImpl;
+
+/**
+ * @brief LRU cache of shrinked page rasters.
+ *
+ * An entry stands for the DVI bitmaps (or DIB chunks) of one page at one
+ * shrink factor.  The rasters are owned by the page; the cache keeps track of
+ * their size and of their last use.  When a new raster exceeds the byte
+ * budget, the least recently used rasters are freed.  Rasters of locked pages
+ * and of pages near the current page are not freed.
+ */
+class BitmapCache
+{
+public:
+
+    struct Statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t size = 0;
+        std::size_t budget = 0;
+    };
+
+    BitmapCache(std::size_t budget, MiKTeX::Trace::TraceStream* trace) :
+        budget(budget),
+        trace(trace)
+    {
+    }
+
+    /**
+     * @brief Records the use of a cached raster.
+     * @param page The page owning the raster.
+     * @param shrinkFactor The shrink factor of the raster.
+     */
+    void Touch(DviPageImpl* page, int shrinkFactor);
+
+    /**
+     * @brief Records a raster which has just been made.
+     *
+     * Frees least recently used rasters of other pages until the cache fits
+     * into its budget.  The caller must own the lock of `page`.
+     *
+     * @param page The page owning the raster.
+     * @param shrinkFactor The shrink factor of the raster.
+     * @param rasterSize The size of the raster (in bytes).
+     */
+    void Put(DviPageImpl* page, int shrinkFactor, std::size_t rasterSize);
+
+    /**
+     * @brief Forgets a raster which has been freed by its page.
+     * @param page The page owning the raster.
+     * @param shrinkFactor The shrink factor of the raster.
+     */
+    void Remove(DviPageImpl* page, int shrinkFactor);
+
+    /**
+     * @brief Gets the cache statistics.
+     * @return Returns the number of hits, misses and evictions and the
+     * current size of the cache.
+     */
+    Statistics GetStatistics();
+
+    /**
+     * @brief Formats the cache statistics.
+     * @return Returns a human-readable text.
+     */
+    std::string GetStatisticsText();
+
+private:
+
+    struct Entry
+    {
+        DviPageImpl* page;
+        int shrinkFactor;
+        std::size_t size;
+    };
+
+    typedef std::pair<DviPageImpl*, int> Key;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            return std::hash<DviPageImpl*>()(key.first) ^ (std::hash<int>()(key.second) << 1);
+        }
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    std::string GetStatisticsTextNoLock();
+
+    std::size_t budget;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    std::mutex mutex;
+
+    // most recently used rasters first
+    EntryList entries;
+
+    Statistics statistics;
+    MiKTeX::Trace::TraceStream* trace;
+};
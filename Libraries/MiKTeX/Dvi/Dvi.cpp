@@ -1,6 +1,6 @@
 /* dvi.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -23,6 +23,8 @@
 
 #include "config.h"
 
+#include <map>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -30,6 +32,19 @@
 
 #include "internal.h"
 
+// the page loader thread pool is not bigger than this
+const int maxPageLoaders = 4;
+
+// number of pages in reading direction which are prepared in the background
+const int pageLoaderLookAhead = 10;
+
+// number of pages against reading direction which are prepared in the
+// background
+const int pageLoaderLookBehind = 2;
+
+// the DVI object owning the current page loader thread
+static thread_local DviImpl* pageLoaderOwner = nullptr;
+
 void DviImpl::PushState()
 {
   stateStack.push(currentState);
@@ -96,25 +111,20 @@ DviImpl::DviImpl(const char* fileName, const char* metafontMode, int resolution,
 
   dviInfo.lastWriteTime = 0;
   fontMap = new FontMap;
-  hByeByeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-  if (hByeByeEvent == nullptr)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
-  }
-  hNewPageEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
-  if (hNewPageEvent == nullptr)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
-  }
-  hScannedEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
-  if (hScannedEvent == nullptr)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
-  }
+  bitmapCache = make_unique<BitmapCache>(static_cast<size_t>(session->GetConfigValue("Dvi", "BitmapCacheSize", ConfigValue(100)).GetInt()) * 1024 * 1024, trace_gc.get());
   if (dviAccess == DviAccess::Random)
   {
-    garbageCollectorThread = thread(&DviImpl::GarbageCollector, this);
-    pageLoaderThread = thread(&DviImpl::PageLoader, this);
+    // 0 means: one thread per processor, leaving one processor for the viewer
+    int numPageLoaders = session->GetConfigValue("Dvi", "PageLoaderThreads", ConfigValue(0)).GetInt();
+    if (numPageLoaders <= 0)
+    {
+      numPageLoaders = static_cast<int>(thread::hardware_concurrency()) - 1;
+      numPageLoaders = numPageLoaders < 1 ? 1 : numPageLoaders > maxPageLoaders ? maxPageLoaders : numPageLoaders;
+    }
+    for (int idx = 0; idx < numPageLoaders; ++idx)
+    {
+      pageLoaderThreads.push_back(thread(&DviImpl::PageLoader, this));
+    }
   }
 }
 
@@ -131,20 +141,22 @@ DviImpl::~DviImpl()
 
 void DviImpl::Dispose()
 {
-  if (hByeByeEvent != nullptr)
   {
-    if (!SetEvent(hByeByeEvent))
-    {
-      MIKTEX_FATAL_WINDOWS_ERROR("SetEvent");
-    }
+    lock_guard<mutex> lockGuard(pageLoaderMutex);
+    byeBye = true;
   }
-  if (garbageCollectorThread.joinable())
+  pageLoaderCondition.notify_all();
+  for (thread& pageLoaderThread : pageLoaderThreads)
   {
-    garbageCollectorThread.join();
+    if (pageLoaderThread.joinable())
+    {
+      pageLoaderThread.join();
+    }
   }
-  if (pageLoaderThread.joinable())
+  pageLoaderThreads.clear();
   {
-    pageLoaderThread.join();
+    lock_guard<mutex> lockGuard(ghostscriptMutex);
+    ghostscripts.clear();
   }
   BEGIN_CRITICAL_SECTION(dviMutex)
   {
@@ -154,23 +166,12 @@ void DviImpl::Dispose()
       delete fontMap;
       fontMap = nullptr;
     }
-    if (hByeByeEvent != nullptr)
-    {
-      CloseHandle(hByeByeEvent);
-      hByeByeEvent = nullptr;
-    }
-    if (hNewPageEvent != nullptr)
-    {
-      CloseHandle(hNewPageEvent);
-      hNewPageEvent = nullptr;
-    }
-    if (hScannedEvent != nullptr)
-    {
-      CloseHandle(hScannedEvent);
-      hScannedEvent = nullptr;
-    }
   }
   END_CRITICAL_SECTION();
+  if (bitmapCache != nullptr && trace_gc != nullptr)
+  {
+    trace_gc->WriteLine("libdvi", bitmapCache->GetStatisticsText());
+  }
   if (trace_dvifile != nullptr)
   {
     trace_dvifile->Close();
@@ -228,6 +229,12 @@ void DviImpl::FreeContents(bool keepFonts)
   tempFiles.clear();
 }
 
+// bop, c[0]...c[9], p
+const int bopSize = 45;
+
+// post, p, num, den, mag, l, u, s, t
+const int postambleHeaderSize = 29;
+
 const int set_char = 0;
 const int set1 = 128;
 const int set2 = 129;
@@ -368,10 +375,9 @@ const int dvi_id = 2;
 
 void DviImpl::Scan()
 {
-  InputStream inputStream(dviFileName.GetData());
+  lock_guard<recursive_mutex> lockGuard(dviMutex);
 
-  // reset this object
-  FreeContents(false);
+  InputStream inputStream(dviFileName.GetData());
 
   trace_dvifile->WriteLine("libdvi", fmt::format(T_("going to scan {0}"), Q_(dviFileName)));
 
@@ -442,7 +448,29 @@ void DviImpl::Scan()
     FATAL_DVI_ERROR_2(T_("Invalid DVI file."), "fileName", dviFileName.ToString());
   }
 
+  // the font definitions of the postamble and the conversion factors
+  // decide whether fonts and pages of the previous scan can be kept
+  string newScanSignature = fmt::format("{0},{1},{2};", numerator, denominator, mag);
+  if (q + postambleHeaderSize < m - 4)
+  {
+    inputStream.SetReadPosition(q + postambleHeaderSize, SeekOrigin::Begin);
+    vector<char> fontDefinitions(m - 4 - (q + postambleHeaderSize));
+    inputStream.Read(fontDefinitions.data(), fontDefinitions.size());
+    newScanSignature.append(fontDefinitions.data(), fontDefinitions.size());
+  }
+  bool keepFonts = !pages.empty() && newScanSignature == scanSignature;
+  scanSignature = newScanSignature;
+
+  // reset this object
+  vector<DviPageImpl*> previousPages;
+  if (keepFonts)
+  {
+    previousPages.swap(pages);
+  }
+  FreeContents(keepFonts);
+
   // process the postamble
+  inputStream.SetReadPosition(q + 1, SeekOrigin::Begin);
   int firstbackpointer =        // pointer to last page
     inputStream.ReadSignedQuad();
   inputStream.ReadSignedQuad(); // postamble_num
@@ -458,16 +486,24 @@ void DviImpl::Scan()
   trace_dvifile->WriteLine("libdvi", fmt::format("dviInfo.nPages: {0}", dviInfo.nPages));
 
   // process the font definitions of the postamble
-  do
+  if (keepFonts)
   {
+    inputStream.SetReadPosition(m - 4, SeekOrigin::Begin);
     k = inputStream.ReadByte();
-    if (k >= fnt_def1 && k < fnt_def1 + 4)
+  }
+  else
+  {
+    do
     {
-      int p = FirstParam(inputStream, k);
-      DefineFont(inputStream, p);
-      k = nop;
-    }
-  } while (k == nop);
+      k = inputStream.ReadByte();
+      if (k >= fnt_def1 && k < fnt_def1 + 4)
+      {
+        int p = FirstParam(inputStream, k);
+        DefineFont(inputStream, p);
+        k = nop;
+      }
+    } while (k == nop);
+  }
 
   if (k != post_post)
   {
@@ -509,6 +545,17 @@ void DviImpl::Scan()
     pages.push_back(dviPage);
   }
   reverse(pages.begin(), pages.end());
+
+  if (dviAccess == DviAccess::Random)
+  {
+    ComputePageDigests(inputStream, q);
+    ReusePages(previousPages);
+  }
+  for (DviPageImpl* dviPage : previousPages)
+  {
+    delete dviPage;
+  }
+
   lastChecked = clock();
 
 #if 0
@@ -520,12 +567,81 @@ void DviImpl::Scan()
   }
 #endif
 
-  // wake up page loader thread
-  SetEvent(hScannedEvent);
+  // wake up page loader threads
+  {
+    lock_guard<mutex> lockGuard(pageLoaderMutex);
+    scanned = true;
+    pageLoaderGeneration += 1;
+  }
+  pageLoaderCondition.notify_all();
 
   hasDviFileChanged = false;
 }
 
+// Computes the digests of the pages.  A page digest covers the bytes from
+// bop (without the back pointer) up to the next bop (or the postamble).
+void DviImpl::ComputePageDigests(InputStream& inputStream, int postamblePosition)
+{
+  vector<char> buffer;
+  for (size_t pageIdx = 0; pageIdx < pages.size(); ++pageIdx)
+  {
+    DviPageImpl* dviPage = pages[pageIdx];
+    long start = dviPage->GetReadPosition() - bopSize;
+    long end = pageIdx + 1 < pages.size() ? pages[pageIdx + 1]->GetReadPosition() - bopSize : postamblePosition;
+    if (end <= start)
+    {
+      FATAL_DVI_ERROR_2(T_("Invalid DVI file."), "fileName", dviFileName.ToString());
+    }
+    buffer.resize(end - start);
+    inputStream.SetReadPosition(start, SeekOrigin::Begin);
+    inputStream.Read(buffer.data(), buffer.size());
+    MD5Builder md5Builder;
+    md5Builder.Update(buffer.data(), bopSize - 4);
+    md5Builder.Update(buffer.data() + bopSize, buffer.size() - bopSize);
+    dviPage->digest = md5Builder.Final();
+  }
+}
+
+// Replaces new pages by loaded pages of the previous scan, if their
+// contents are unchanged.  TeX rewrites the DVI file page by page: after a
+// recompile, most pages are usually the same.
+void DviImpl::ReusePages(vector<DviPageImpl*>& previousPages)
+{
+  multimap<MD5, size_t> reusablePages;
+  for (size_t idx = 0; idx < previousPages.size(); ++idx)
+  {
+    DviPageImpl* dviPage = previousPages[idx];
+    if (dviPage->IsFrozen() && dviPage->IsSelfContained())
+    {
+      reusablePages.insert(make_pair(dviPage->digest, idx));
+    }
+  }
+  if (reusablePages.empty())
+  {
+    return;
+  }
+  int nReused = 0;
+  for (size_t pageIdx = 0; pageIdx < pages.size(); ++pageIdx)
+  {
+    multimap<MD5, size_t>::iterator it = reusablePages.find(pages[pageIdx]->digest);
+    if (it == reusablePages.end())
+    {
+      continue;
+    }
+    DviPageImpl* dviPage = previousPages[it->second];
+    previousPages[it->second] = nullptr;
+    reusablePages.erase(it);
+    dviPage->Lock();
+    AutoUnlockPage autoUnlockPage(dviPage);
+    dviPage->pageIdx = static_cast<int>(pageIdx);
+    dviPage->readPosition = pages[pageIdx]->GetReadPosition();
+    delete pages[pageIdx];
+    pages[pageIdx] = dviPage;
+    nReused += 1;
+  }
+  trace_dvifile->WriteLine("libdvi", fmt::format(T_("reused {0} of {1} pages"), nReused, pages.size()));
+}
+
 void DviImpl::DefineFont(InputStream & inputStream, int fontNum)
 {
   trace_dvifile->WriteLine("libdvi", fmt::format(T_("going to define font {0}"), fontNum));
@@ -655,7 +771,7 @@ void DviImpl::DoPage(int pageIdx)
 
   Progress(DviNotification::BeginLoadPage, fmt::format(T_("loading page #{0}..."), pageIdx));
 
-  bool background = pageLoaderThread.joinable() && this_thread::get_id() == pageLoaderThread.get_id();
+  bool background = IsPageLoaderThread();
 
   if (background)
   {
@@ -697,14 +813,7 @@ void DviImpl::DoPage(int pageIdx)
 
 bool DviImpl::DoNextCommand(InputStream & inputStream, DviPageImpl & page)
 {
-  MIKTEX_ASSERT(hByeByeEvent != nullptr);
-
-  DWORD wait = WaitForSingleObject(hByeByeEvent, 0);
-  if (wait == WAIT_FAILED)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-  }
-  if (wait == WAIT_OBJECT_0)
+  if (byeBye)
   {
     throw OperationCancelledException();
   }
@@ -1244,9 +1353,7 @@ DviPage* DviImpl::GetPage(int pageIdx)
     dviPage->Lock();
     try
     {
-      if ((!pageLoaderThread.joinable() || this_thread::get_id() != pageLoaderThread.get_id())
-        && (!garbageCollectorThread.joinable() || this_thread::get_id() != garbageCollectorThread.get_id())
-        && currentPageIdx != pageIdx)
+      if (!IsPageLoaderThread() && currentPageIdx != pageIdx)
       {
         trace_dvifile->WriteLine("libdvi", fmt::format(T_("getting page #{0}"), pageIdx));
         if (pageIdx < currentPageIdx)
@@ -1258,10 +1365,11 @@ DviPage* DviImpl::GetPage(int pageIdx)
           direction = 1;
         }
         currentPageIdx = pageIdx;
-        if (!SetEvent(hNewPageEvent))
         {
-          MIKTEX_FATAL_WINDOWS_ERROR("SetEvent");
+          lock_guard<mutex> lockGuard(pageLoaderMutex);
+          pageLoaderGeneration += 1;
         }
+        pageLoaderCondition.notify_all();
       }
       return dviPage;
     }
@@ -1315,13 +1423,19 @@ DviPage* DviImpl::GetLoadedPage(int pageIdx)
   CheckCondition();
   BEGIN_CRITICAL_SECTION(dviMutex)
   {
-    switch (GetPageStatus(pageIdx))
+    PageStatus pageStatus = GetPageStatus(pageIdx);
+    if (pageStatus == PageStatus::Changed)
+    {
+      // unchanged pages survive the scan
+      Scan();
+      pageStatus = GetPageStatus(pageIdx);
+    }
+    switch (pageStatus)
     {
     case PageStatus::Lost:
     case PageStatus::Unknown:
-      return 0;
     case PageStatus::Changed:
-      Scan();              // fall through
+      return 0;
     case PageStatus::NotLoaded:
       DoPage(pageIdx);     // fall through
     case PageStatus::Loaded:
@@ -1342,8 +1456,7 @@ DviPage* DviImpl::GetLoadedPage(int pageIdx)
 
 void DviImpl::Progress(DviNotification nf, const string& msg)
 {
-  if ((pageLoaderThread.joinable() && this_thread::get_id() == pageLoaderThread.get_id())
-    || (garbageCollectorThread.joinable() && this_thread::get_id() == garbageCollectorThread.get_id()))
+  if (IsPageLoaderThread())
   {
     return;
   }
@@ -1366,269 +1479,167 @@ string DviImpl::GetStatusText()
   return progressStatus;
 }
 
-const unsigned long sleepDurationLowestPrio = 1000; // milliseconds
-const unsigned long sleepDurationBelowNormalPrio = 100;
-const unsigned long sleepDurationNormalPrio = 10;
-const unsigned long sleepDurationAboveNormalPrio = 0;
-const unsigned long sleepDurationHighestPrio = 0;
+bool DviImpl::IsPageLoaderThread()
+{
+  return pageLoaderOwner == this;
+}
 
-const unsigned long limitBelowNormalPrio = 2 * 1024 * 1024;
-const unsigned long limitNormalPrio = 20 * 1024 * 1024;
-const unsigned long limitAboveNormalPrio = 50 * 1024 * 1024;
-const unsigned long limitHighestPrio = 100 * 1024 * 1024;
+bool DviImpl::IsNearCurrentPage(int pageIdx)
+{
+  int startIdx = currentPageIdx;
+  int distance = (pageIdx - (startIdx < 0 ? 0 : startIdx)) * direction;
+  return distance >= 0 ? distance < pageLoaderLookAhead : -distance <= pageLoaderLookBehind;
+}
 
-void DviImpl::PageLoader()
+// Ghostscript sessions are kept for the lifetime of the DVI object:
+// starting Ghostscript and loading the prolog is more expensive than
+// rendering the PostScript specials of a typical page.  A session
+// serves one page at a time; concurrent page loaders get a session
+// of their own.
+unique_ptr<Ghostscript> DviImpl::AcquireGhostscript(int shrinkFactor)
 {
-  try
   {
-#if 1
-    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST) == 0)
-    {
-      MIKTEX_FATAL_WINDOWS_ERROR("SetThreadPriority");
-    }
-#endif
-
-    MIKTEX_ASSERT(hByeByeEvent != nullptr);
-    MIKTEX_ASSERT(hNewPageEvent != nullptr);
-    MIKTEX_ASSERT(hScannedEvent != nullptr);
-
-    HANDLE handles[2];
-
-    handles[0] = hByeByeEvent;
-    handles[1] = hScannedEvent;
-
-    unsigned long wait = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
-
-    if (wait == WAIT_FAILED)
+    lock_guard<mutex> lockGuard(ghostscriptMutex);
+    auto it = ghostscripts.find(shrinkFactor);
+    if (it != ghostscripts.end())
     {
-      MIKTEX_FATAL_WINDOWS_ERROR("WaitForMultipleObjects");
+      unique_ptr<Ghostscript> ghostscript = std::move(it->second);
+      ghostscripts.erase(it);
+      return ghostscript;
     }
+  }
+  return make_unique<Ghostscript>(traceCallback);
+}
 
-    if (wait == WAIT_OBJECT_0)
-    {
-      return;
-    }
+void DviImpl::ReleaseGhostscript(int shrinkFactor, unique_ptr<Ghostscript> ghostscript)
+{
+  if (!ghostscript->IsRunning() || byeBye)
+  {
+    return;
+  }
+  lock_guard<mutex> lockGuard(ghostscriptMutex);
+  ghostscripts.emplace(shrinkFactor, std::move(ghostscript));
+}
 
-    for (int pageIdx = currentPageIdx + 1; (wait = WaitForSingleObject(hByeByeEvent, sleepDurationBelowNormalPrio)) != WAIT_OBJECT_0; pageIdx += direction)
+// Picks the page which a page loader thread is going to prepare: the
+// current page first, then the adjacent pages (alternating, beginning in
+// reading direction).  The caller owns dviMutex.
+int DviImpl::NextPageToBeLoaded()
+{
+  int nPages = GetNumberOfPages();
+  int startIdx = currentPageIdx;
+  if (startIdx < 0)
+  {
+    startIdx = 0;
+  }
+  lock_guard<mutex> lockGuard(pageLoaderMutex);
+  for (int distance = 0; distance < pageLoaderLookAhead; ++distance)
+  {
+    for (int pageIdx : { startIdx + direction * distance, startIdx - direction * distance })
     {
-      if (wait == WAIT_FAILED)
+      if (pageIdx < 0 || pageIdx >= nPages || !IsNearCurrentPage(pageIdx) || pagesBeingLoaded.find(pageIdx) != pagesBeingLoaded.end())
       {
-        MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
+        continue;
       }
-      DviPage* dviPage = nullptr;
-      AutoUnlockPage autoUnlockPage(nullptr);
-      BEGIN_CRITICAL_SECTION(dviMutex)
+      DviPageImpl* dviPage = pages[pageIdx];
+      // don't wait for pages which are used by the viewer
+      if (!dviPage->TryLock())
       {
-        wait = WaitForSingleObject(hNewPageEvent, 0);
-        if (wait == WAIT_FAILED)
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-        }
-        if (wait == WAIT_OBJECT_0)
-        {
-          pageIdx = currentPageIdx;
-        }
-        if (pageIdx < 0 || pageIdx >= GetNumberOfPages())
-        {
-          pageIdx = currentPageIdx;
-          continue;
-        }
-        if (direction > 0)
-        {
-          if (!(pageIdx >= currentPageIdx && pageIdx < currentPageIdx + 10))
-          {
-            continue;
-          }
-        }
-        else
-        {
-          MIKTEX_ASSERT(direction < 0);
-          if (!(pageIdx <= currentPageIdx && pageIdx > currentPageIdx - 10))
-          {
-            continue;
-          }
-        }
-        DviPageImpl* pPageImpl = pages[pageIdx];
-        if (pPageImpl->IsLocked())
-        {
-          continue;
-        }
-        dviPage = GetLoadedPage(pageIdx);
-        autoUnlockPage.Attach(dviPage);
+        // OnPageUnlocked() wakes up the page loaders
+        skippedLockedPage = true;
+        continue;
       }
-      END_CRITICAL_SECTION();
-      if (dviPage != nullptr)
+      bool done = dviPage->IsFrozen() && dviPage->HaveShrinkedRaster(defaultShrinkFactor);
+      dviPage->Unlock();
+      if (!done)
       {
-        dviPage->GetNumberOfDviBitmaps(defaultShrinkFactor);
+        pagesBeingLoaded.insert(pageIdx);
+        return pageIdx;
       }
     }
   }
+  return -1;
+}
 
-  catch (const MiKTeXException & e)
-  {
-    miktexException = e;
-    fatalMiKTeXError = true;
-  }
-
-  catch (const exception & e)
+void DviImpl::OnPageUnlocked()
+{
   {
-    stdException = e;
-    fatalError = true;
+    lock_guard<mutex> lockGuard(pageLoaderMutex);
+    if (!skippedLockedPage)
+    {
+      return;
+    }
+    skippedLockedPage = false;
+    pageLoaderGeneration += 1;
   }
+  pageLoaderCondition.notify_all();
 }
 
-const time_t timeKeepBitmapsLowestPrio = 120; // seconds
-const time_t timeKeepBitmapsBelowNormalPrio = 60;
-const time_t timeKeepBitmapsNormalPrio = 30;
-const time_t timeKeepBitmapsAboveNormalPrio = 10;
-const time_t timeKeepBitmapsHighestPrio = 5;
-
-void DviImpl::GarbageCollector()
+void DviImpl::PageLoader()
 {
+  pageLoaderOwner = this;
+
   try
   {
-    int priority = THREAD_PRIORITY_LOWEST;
-    unsigned long sleepDuration = sleepDurationLowestPrio;
-    time_t timeKeepBitmaps = timeKeepBitmapsLowestPrio;
-    if (!SetThreadPriority(GetCurrentThread(), priority))
+#if defined(MIKTEX_WINDOWS)
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST) == 0)
     {
       MIKTEX_FATAL_WINDOWS_ERROR("SetThreadPriority");
     }
-    DWORD wait;
-    while ((wait = WaitForSingleObject(hByeByeEvent, sleepDuration)) != WAIT_OBJECT_0)
-    {
-      if (wait == WAIT_FAILED)
-      {
-        MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-      }
-      size_t sizeBiggest = 0;
-      int biggestPageIdx = -1;
-      DviPageImpl* dviPage;
-      size_t totalSize = 0;
-      time_t now = time(nullptr);
-      for (int pageIdx = 0; (wait = WaitForSingleObject(hByeByeEvent, 0)) != WAIT_OBJECT_0; ++pageIdx)
-      {
-        if (wait == WAIT_FAILED)
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-        }
-        BEGIN_CRITICAL_SECTION(dviMutex)
-        {
-          if (pageIdx >= GetNumberOfPages())
-          {
-            break;
-          }
-          if (direction > 0)
-          {
-            if (pageIdx >= currentPageIdx && pageIdx < currentPageIdx + 10)
-            {
-              continue;
-            }
-          }
-          else
-          {
-            MIKTEX_ASSERT(direction < 0);
-            if (pageIdx <= currentPageIdx && pageIdx > currentPageIdx - 10)
-            {
-              continue;
-            }
-          }
-          DviPageImpl* dviPage = pages[pageIdx];
-          totalSize += dviPage->GetSize();
-          if (!dviPage->IsFrozen())
-          {
-            continue;
-          }
-          time_t timeLastVisit = dviPage->GetTimeLastVisit();
-          if (timeLastVisit + timeKeepBitmaps < now)
-          {
-            if (dviPage->GetSize() > sizeBiggest && !dviPage->IsLocked())
-            {
-              sizeBiggest = dviPage->GetSize();
-              biggestPageIdx = pageIdx;
-            }
-          }
-        }
-        END_CRITICAL_SECTION();
-      }
-      wait = WaitForSingleObject(hByeByeEvent, 0);
-      if (wait == WAIT_FAILED)
-      {
-        MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-      }
-      if (wait == WAIT_OBJECT_0)
-      {
-        break;
-      }
-      int newPriority;
-      if (totalSize > limitHighestPrio)
-      {
-#if 0
-        newPriority = THREAD_PRIORITY_HIGHEST;
-#else
-        newPriority = THREAD_PRIORITY_NORMAL;
 #endif
-        sleepDuration = sleepDurationHighestPrio;
-        timeKeepBitmaps = timeKeepBitmapsHighestPrio;
-      }
-      else if (totalSize > limitAboveNormalPrio)
-      {
-#if 0
-        newPriority = THREAD_PRIORITY_ABOVE_NORMAL;
-#else
-        newPriority = THREAD_PRIORITY_NORMAL;
-#endif
-        sleepDuration = sleepDurationAboveNormalPrio;
-        timeKeepBitmaps = timeKeepBitmapsAboveNormalPrio;
-      }
-      else if (totalSize > limitNormalPrio)
-      {
-        newPriority = THREAD_PRIORITY_NORMAL;
-        sleepDuration = sleepDurationBelowNormalPrio;
-        timeKeepBitmaps = timeKeepBitmapsNormalPrio;
-      }
-      else if (totalSize > limitBelowNormalPrio)
-      {
-        newPriority = THREAD_PRIORITY_BELOW_NORMAL;
-        sleepDuration = sleepDurationBelowNormalPrio;
-        timeKeepBitmaps = timeKeepBitmapsBelowNormalPrio;
-      }
-      else
+
+    {
+      unique_lock<mutex> lock(pageLoaderMutex);
+      pageLoaderCondition.wait(lock, [this]() { return byeBye || scanned; });
+    }
+
+    while (!byeBye)
+    {
+      int generation;
       {
-        newPriority = THREAD_PRIORITY_LOWEST;
-        sleepDuration = sleepDurationLowestPrio;
-        timeKeepBitmaps = timeKeepBitmapsLowestPrio;
+        lock_guard<mutex> lockGuard(pageLoaderMutex);
+        generation = pageLoaderGeneration;
       }
-      if (newPriority != priority)
+
+      int pageIdx;
+      BEGIN_CRITICAL_SECTION(dviMutex)
       {
-        priority = newPriority;
-        if (!SetThreadPriority(GetCurrentThread(), priority))
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("SetThreadPriority");
-        }
-        trace_gc->WriteLine("libdvi", fmt::format(T_("gc priority: {0}"), priority));
+        pageIdx = NextPageToBeLoaded();
       }
-      if (biggestPageIdx < 0)
+      END_CRITICAL_SECTION();
+
+      if (pageIdx < 0)
       {
+        // nothing to do until another page is requested or a skipped page
+        // gets unlocked
+        unique_lock<mutex> lock(pageLoaderMutex);
+        pageLoaderCondition.wait(lock, [&]() { return byeBye || pageLoaderGeneration != generation; });
         continue;
       }
+
+      MIKTEX_AUTO(
+        {
+          lock_guard<mutex> lockGuard(pageLoaderMutex);
+          pagesBeingLoaded.erase(pageIdx);
+        });
+
+      // DVI commands are interpreted one page at a time, because the
+      // interpreter state is kept in this object
+      DviPage* dviPage;
       BEGIN_CRITICAL_SECTION(dviMutex)
       {
-        if (biggestPageIdx >= GetNumberOfPages())
-        {
-          continue;
-        }
-        dviPage = pages[biggestPageIdx];
-        if (dviPage->IsLocked())
-        {
-          continue;
-        }
-        dviPage->Lock();
-        AutoUnlockPage autoUnlockPage(dviPage);
-        trace_gc->WriteLine("libdvi", fmt::format(T_("freeing page #{0} ({1} bytes)"), biggestPageIdx, dviPage->GetSize()));
-        dviPage->FreeContents(false, false);
+        dviPage = GetLoadedPage(pageIdx);
       }
       END_CRITICAL_SECTION();
+
+      if (dviPage == nullptr)
+      {
+        continue;
+      }
+
+      // the page loaders rasterize their pages at the same time
+      AutoUnlockPage autoUnlockPage(dviPage);
+      dviPage->GetNumberOfDviBitmaps(defaultShrinkFactor);
     }
   }
 
@@ -1676,6 +1687,39 @@ bool DviImpl::MakeFonts(const FontMap & fontMap, int recursion)
   return done;
 }
 
+// Kicks off makepk for all missing PK files, so that they are made in
+// parallel; MakeFonts() then collects the results font by font.
+void DviImpl::StartMakeFonts(const FontMap& fontMap, int recursion)
+{
+  const int maxRecursion = 20;
+  if (recursion >= maxRecursion)
+  {
+    return;
+  }
+  for (FontMap::const_iterator it = fontMap.begin(); it != fontMap.end(); ++it)
+  {
+    if (it->second->IsNotLoadable())
+    {
+      continue;
+    }
+    PkFont* pkFont = dynamic_cast<PkFont*>(it->second);
+    if (pkFont != nullptr)
+    {
+      pkFont->StartMake();
+      continue;
+    }
+    VFont* pVFont = dynamic_cast<VFont*>(it->second);
+    if (pVFont != nullptr)
+    {
+      pVFont->Read();
+      if (!pVFont->IsNotLoadable())
+      {
+        StartMakeFonts(pVFont->GetFontMap(), recursion + 1);
+      }
+    }
+  }
+}
+
 bool DviImpl::MakeFonts()
 {
   CheckCondition();
@@ -1685,6 +1729,7 @@ bool DviImpl::MakeFonts()
     {
       MIKTEX_UNEXPECTED();
     }
+    StartMakeFonts(*fontMap, 0);
     return MakeFonts(*fontMap, 0);
   }
   END_CRITICAL_SECTION();
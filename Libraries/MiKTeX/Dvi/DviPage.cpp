@@ -1,6 +1,6 @@
 /* DviPage.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -38,6 +38,10 @@ const int MaxVerticalWhite = 2;
 const int MaxHorizontalWhite = 32;
 #endif
 
+// DVI bitmaps are drawn by up to four threads, if there are enough of them
+const size_t maxRasterizers = 4;
+const size_t minBitmapsPerRasterizer = 16;
+
 size_t DviPageImpl::totalSize = 0;
 
 #if defined(max)
@@ -219,6 +223,10 @@ int DviPageImpl::GetNumberOfDviBitmaps(int shrinkFactor)
   {
     MakeShrinkedRaster(shrinkFactor);
   }
+  else
+  {
+    dviImpl->GetBitmapCache()->Touch(this, shrinkFactor);
+  }
   return static_cast<int>(shrinkedDviBitmaps[shrinkFactor].size());
 }
 
@@ -230,6 +238,10 @@ int DviPageImpl::GetNumberOfDibChunks(int shrinkFactor)
   {
     MakeShrinkedRaster(shrinkFactor);
   }
+  else
+  {
+    dviImpl->GetBitmapCache()->Touch(this, shrinkFactor);
+  }
   return static_cast<int>(shrinkedDibChunks[shrinkFactor].size());
 }
 
@@ -252,13 +264,112 @@ void DviPageImpl::MakeShrinkedRaster(int shrinkFactor)
     }
   }
   haveShrinkedRaster[shrinkFactor] = true;
+  dviImpl->GetBitmapCache()->Put(this, shrinkFactor, GetShrinkedRasterSize(shrinkFactor));
+}
+
+size_t DviPageImpl::GetShrinkedRasterSize(int shrinkFactor)
+{
+  size_t rasterSize = 0;
+  MAPNUMTOBITMAPVEC::const_iterator itBitmaps = shrinkedDviBitmaps.find(shrinkFactor);
+  if (itBitmaps != shrinkedDviBitmaps.end())
+  {
+    for (const DviBitmap& bitmap : itBitmaps->second)
+    {
+      rasterSize += bitmap.bytesPerLine * bitmap.height;
+    }
+  }
+  MAPNUMTODIBCHUNKVEC::const_iterator itDibChunks = shrinkedDibChunks.find(shrinkFactor);
+  if (itDibChunks != shrinkedDibChunks.end())
+  {
+    for (const shared_ptr<DibChunk>& dibChunk : itDibChunks->second)
+    {
+      rasterSize += dibChunk->GetSize();
+    }
+  }
+  return rasterSize;
+}
+
+void DviPageImpl::FreeShrinkedRaster(int shrinkFactor)
+{
+  MIKTEX_ASSERT(IsLocked());
+  tracePage->WriteLine("libdvi", fmt::format(T_("freeing {0} bytes (shrink factor {1}) of page '{2}'"), GetShrinkedRasterSize(shrinkFactor), shrinkFactor, pageName));
+  FreeDviBitmaps(shrinkFactor);
+  MAPNUMTODIBCHUNKVEC::iterator itDibChunks = shrinkedDibChunks.find(shrinkFactor);
+  if (itDibChunks != shrinkedDibChunks.end())
+  {
+    for (const shared_ptr<DibChunk>& dibChunk : itDibChunks->second)
+    {
+      size -= dibChunk->GetSize();
+      totalSize -= dibChunk->GetSize();
+    }
+    shrinkedDibChunks.erase(itDibChunks);
+  }
+  haveShrinkedRaster.erase(shrinkFactor);
+  dviImpl->GetBitmapCache()->Remove(this, shrinkFactor);
+}
+
+bool DviPageImpl::IsNearCurrentPage()
+{
+  return dviImpl->IsNearCurrentPage(pageIdx);
+}
+
+// Indicates whether the page can be rendered without external files (such
+// as graphics files and PostScript headers).
+bool DviPageImpl::IsSelfContained()
+{
+  if (pageMode == DviPageMode::Dvips)
+  {
+    return false;
+  }
+  for (DviSpecial* special : dviSpecials)
+  {
+    if (dynamic_cast<GraphicsSpecial*>(special) != nullptr
+      || dynamic_cast<PsdefSpecial*>(special) != nullptr
+      || dynamic_cast<DvipsSpecial*>(special) != nullptr
+      || dynamic_cast<PsfileSpecial*>(special) != nullptr)
+    {
+      return false;
+    }
+  }
+  return true;
 }
 
+void DviPageImpl::FreeDviBitmaps(int shrinkFactor)
+{
+  MAPNUMTOBITMAPVEC::iterator itBitmaps = shrinkedDviBitmaps.find(shrinkFactor);
+  if (itBitmaps != shrinkedDviBitmaps.end())
+  {
+    for (DviBitmap& bitmap : itBitmaps->second)
+    {
+      if (bitmap.pixels != nullptr)
+      {
+        size -= (bitmap.bytesPerLine * bitmap.height);
+        totalSize -= (bitmap.bytesPerLine * bitmap.height);
+        bitmap.pixels = nullptr;
+      }
+    }
+    shrinkedDviBitmaps.erase(itBitmaps);
+  }
+  unordered_map<int, void*>::iterator itArena = shrinkedDviBitmapArenas.find(shrinkFactor);
+  if (itArena != shrinkedDviBitmapArenas.end())
+  {
+    free(itArena->second);
+    shrinkedDviBitmapArenas.erase(itArena);
+  }
+}
+
+// DVI bitmaps are made in two steps: (1) the page is divided into
+// bitmaps and (2) the bitmaps are drawn.  The bitmaps don't overlap, so
+// they can be drawn in parallel.  The pixels of all bitmaps are stored
+// in one memory block.
 void DviPageImpl::MakeDviBitmaps(int shrinkFactor)
 {
   MIKTEX_ASSERT(!dviItems.empty());
   MIKTEX_ASSERT(frozen);
 
+  vector<PendingDviBitmap> pendingBitmaps;
+  pendingBitmaps.reserve(1000 / shrinkFactor);
+
   vector<DviItem>::iterator it = dviItems.begin();
 
   // initialize band
@@ -275,7 +386,7 @@ void DviPageImpl::MakeDviBitmaps(int shrinkFactor)
 
     if (itemTop > bandBottom + MaxVerticalWhite)
     {
-      ProcessBand(shrinkFactor, dviItemPointers);
+      ProcessBand(shrinkFactor, dviItemPointers, pendingBitmaps);
       bandBottom = itemBottom;
     }
     else
@@ -287,10 +398,87 @@ void DviPageImpl::MakeDviBitmaps(int shrinkFactor)
   }
 
   // process last band
-  ProcessBand(shrinkFactor, dviItemPointers);
+  ProcessBand(shrinkFactor, dviItemPointers, pendingBitmaps);
+
+  // allocate pixel storage
+  size_t arenaSize = 0;
+  for (const PendingDviBitmap& pendingBitmap : pendingBitmaps)
+  {
+    arenaSize += pendingBitmap.rasterSize;
+  }
+  BYTE* arena = reinterpret_cast<BYTE*>(calloc(arenaSize, 1));
+  if (arena == nullptr && arenaSize > 0)
+  {
+    OUT_OF_MEMORY("calloc");
+  }
+  FreeDviBitmaps(shrinkFactor);
+  shrinkedDviBitmapArenas[shrinkFactor] = arena;
+  size += arenaSize;
+  totalSize += arenaSize;
+  size_t offset = 0;
+  for (PendingDviBitmap& pendingBitmap : pendingBitmaps)
+  {
+    pendingBitmap.bitmap.pixels = arena + offset;
+    offset += pendingBitmap.rasterSize;
+  }
+
+  // draw the bitmaps
+  size_t numThreads = thread::hardware_concurrency();
+  numThreads = std::min(numThreads, pendingBitmaps.size() / minBitmapsPerRasterizer);
+  numThreads = std::min(numThreads, maxRasterizers);
+  if (numThreads <= 1)
+  {
+    for (PendingDviBitmap& pendingBitmap : pendingBitmaps)
+    {
+      MakeDviBitmap(shrinkFactor, pendingBitmap);
+    }
+  }
+  else
+  {
+    atomic_size_t nextBitmap{ 0 };
+    mutex errorMutex;
+    exception_ptr error;
+    auto rasterizer = [&]()
+    {
+      try
+      {
+        for (size_t idx = nextBitmap++; idx < pendingBitmaps.size(); idx = nextBitmap++)
+        {
+          MakeDviBitmap(shrinkFactor, pendingBitmaps[idx]);
+        }
+      }
+      catch (const exception&)
+      {
+        nextBitmap = pendingBitmaps.size();
+        lock_guard<mutex> lockGuard(errorMutex);
+        error = current_exception();
+      }
+    };
+    vector<thread> rasterizers;
+    for (size_t idx = 1; idx < numThreads; ++idx)
+    {
+      rasterizers.push_back(thread(rasterizer));
+    }
+    rasterizer();
+    for (thread& t : rasterizers)
+    {
+      t.join();
+    }
+    if (error != nullptr)
+    {
+      rethrow_exception(error);
+    }
+  }
+
+  vector<DviBitmap>& bitmaps = shrinkedDviBitmaps[shrinkFactor];
+  bitmaps.reserve(pendingBitmaps.size());
+  for (const PendingDviBitmap& pendingBitmap : pendingBitmaps)
+  {
+    bitmaps.push_back(pendingBitmap.bitmap);
+  }
 }
 
-void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointers)
+void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointers, vector<PendingDviBitmap>& pendingBitmaps)
 {
   MIKTEX_ASSERT(dviItemPointers.size() > 0);
 
@@ -333,7 +521,7 @@ void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointer
       // add the current bitmap
       if (currentBitmap.width > 0 && currentBitmap.height > 0)
       {
-        MakeDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, itItemPtr);
+        AddDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, itItemPtr, pendingBitmaps);
       }
 
       itItemPtrMark = itItemPtr;
@@ -367,42 +555,42 @@ void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointer
   }
 
   // add the current bitmap
-  MakeDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, dviItemPointers.end());
+  AddDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, dviItemPointers.end(), pendingBitmaps);
 
   // clear the band, since we are ready
   dviItemPointers.clear();
 }
 
-void DviPageImpl::MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator itItemPtrBegin, vector<DviItem*>::iterator itItemPtrEnd)
+void DviPageImpl::AddDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator itItemPtrBegin, vector<DviItem*>::iterator itItemPtrEnd, vector<PendingDviBitmap>& pendingBitmaps)
 {
   MIKTEX_ASSERT(bitmap.pixels == nullptr);
 
-  vector<DviBitmap>& bitmaps = shrinkedDviBitmaps[shrinkFactor];
-
-  bitmaps.reserve(1000 / shrinkFactor);
-
-  traceBitmap->WriteLine("libdvi", fmt::format(T_("bitmap {0}; bounding box: {1},{2},{3},{4}"), bitmaps.size(), bitmap.x, bitmap.y, bitmap.width, bitmap.height));
+  traceBitmap->WriteLine("libdvi", fmt::format(T_("bitmap {0}; bounding box: {1},{2},{3},{4}"), pendingBitmaps.size(), bitmap.x, bitmap.y, bitmap.width, bitmap.height));
 
   int bytesPerLine = dviImpl->GetBytesPerLine(shrinkFactor, bitmap.width);
   MIKTEX_ASSERT(bytesPerLine > 0);
   bitmap.bytesPerLine = bytesPerLine;
 
-  int rasterSize = (bytesPerLine * bitmap.height);
-  bitmap.pixels = malloc(rasterSize);
-  if (bitmap.pixels == nullptr)
-  {
-    OUT_OF_MEMORY("malloc");
-  }
-  size += rasterSize;
-  totalSize += rasterSize;
-  memset(const_cast<void*>(bitmap.pixels), 0, rasterSize);
+  PendingDviBitmap pendingBitmap;
+  pendingBitmap.bitmap = bitmap;
+  pendingBitmap.rasterSize = bytesPerLine * bitmap.height;
+  pendingBitmap.items.assign(itItemPtrBegin, itItemPtrEnd);
+  pendingBitmaps.push_back(std::move(pendingBitmap));
+}
+
+void DviPageImpl::MakeDviBitmap(int shrinkFactor, PendingDviBitmap& pendingBitmap)
+{
+  const DviBitmap& bitmap = pendingBitmap.bitmap;
+  int bytesPerLine = bitmap.bytesPerLine;
+  int rasterSize = static_cast<int>(pendingBitmap.rasterSize);
+  UNUSED(rasterSize);
 
   int bitsPerPixel = dviImpl->GetBitsPerPixel(shrinkFactor);
   int pixelsPerByte = dviImpl->GetPixelsPerByte(shrinkFactor);
 
-  for (; itItemPtrBegin != itItemPtrEnd; ++itItemPtrBegin)
+  for (DviItem* itemPtr : pendingBitmap.items)
   {
-    DviItem& item = **itItemPtrBegin;
+    DviItem& item = *itemPtr;
 
     int itemLeft = item.GetLeftShr(shrinkFactor);
     int itemTop = item.GetTopShr(shrinkFactor);
@@ -456,8 +644,6 @@ void DviPageImpl::MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviI
       }
     }
   }
-
-  bitmaps.push_back(bitmap);
 }
 
 void DviPageImpl::DestroyDviBitmaps()
@@ -471,13 +657,17 @@ void DviPageImpl::DestroyDviBitmaps()
       {
         size -= (bitmaps[j].bytesPerLine * bitmaps[j].height);
         totalSize -= (bitmaps[j].bytesPerLine * bitmaps[j].height);
-        free(const_cast<void*>(bitmaps[j].pixels));
         bitmaps[j].pixels = nullptr;
       }
     }
     bitmaps.clear();
   }
   shrinkedDviBitmaps.clear();
+  for (auto& arena : shrinkedDviBitmapArenas)
+  {
+    free(arena.second);
+  }
+  shrinkedDviBitmapArenas.clear();
 }
 
 void DviPageImpl::DestroyDibChunks()
@@ -518,6 +708,10 @@ void DviPageImpl::FreeContents(bool keepSpecials, bool keepItems)
     }
     dviRules.clear();
   }
+  for (const auto& p : haveShrinkedRaster)
+  {
+    dviImpl->GetBitmapCache()->Remove(this, p.first);
+  }
   haveShrinkedRaster.clear();
   DestroyDviBitmaps();
   DestroyDibChunks();
@@ -678,12 +872,31 @@ void DviPageImpl::Lock()
   MIKTEX_ASSERT(nLocks >= 0);
   MIKTEX_ASSERT(nLocks < 1000);
   nLocks += 1;
+  lockOwner = this_thread::get_id();
+}
+
+bool DviPageImpl::TryLock()
+{
+  // the calling thread might own the lock already
+  if (lockOwner == this_thread::get_id() || !pageMutex.try_lock())
+  {
+    return false;
+  }
+  MIKTEX_ASSERT(nLocks >= 0);
+  MIKTEX_ASSERT(nLocks < 1000);
+  nLocks += 1;
+  lockOwner = this_thread::get_id();
+  return true;
 }
 
 void DviPageImpl::Unlock()
 {
   MIKTEX_ASSERT(nLocks > 0);
   nLocks -= 1;
+  if (nLocks == 0)
+  {
+    lockOwner = thread::id();
+  }
   try
   {
     if (nLocks == 0 && autoClean)
@@ -697,7 +910,13 @@ void DviPageImpl::Unlock()
     pageMutex.unlock();
     throw;
   }
+  bool released = nLocks == 0;
   pageMutex.unlock();
+  // page loaders hold pageLoaderMutex while they unlock pages
+  if (released && !dviImpl->IsPageLoaderThread())
+  {
+    dviImpl->OnPageUnlocked();
+  }
 }
 
 HypertexSpecial* DviPageImpl::GetNextHyperref(int& idx)
@@ -720,18 +939,16 @@ void DviPageImpl::MakeDibChunks(int shrinkFactor)
   try
   {
     pDvips = StartDvips();
-    thread dvipsTranscriptReader(&DviPageImpl::DvipsTranscriptReader, this);
     pGhostscript = StartGhostscript(shrinkFactor);
-    thread ghostscriptTranscriptReader(&DviPageImpl::GhostscriptTranscriptReader, this);
+    thread transcriptReader(&DviPageImpl::TranscriptReader, this);
     unique_ptr<DibChunker> pChunker(DibChunker::Create());
     const size_t CHUNK_SIZE = 1024 * 64;
     MIKTEX_ASSERT(IsLocked());
     dibShrinkFactor = shrinkFactor;
-    while (pChunker->Process(DibChunker::Default, CHUNK_SIZE, this))
+    while (pChunker->Process(DibChunker::Default | DibChunker::CreateTiles, CHUNK_SIZE, this))
     {
     }
-    dvipsTranscriptReader.join();
-    ghostscriptTranscriptReader.join();
+    transcriptReader.join();
   }
   catch (const exception&)
   {
@@ -767,51 +984,25 @@ void DviPageImpl::MakeDibChunks(int shrinkFactor)
   }
 }
 
-void DviPageImpl::DvipsTranscriptReader()
+void DviPageImpl::TranscriptReader()
 {
+  dvipsTranscript = "";
+  gsTranscript = "";
   try
   {
-#define CHUNK_SIZE 64
-    char buf[CHUNK_SIZE];
-    dvipsTranscript = "";
-    try
+    // one thread reads both transcripts
+    unique_ptr<PipeMultiplexer> multiplexer = PipeMultiplexer::Create();
+    multiplexer->Add(dvipsErr.GetFile(), [this](const void* output, size_t n)
     {
-      size_t n;
-      while ((n = dvipsErr.Read(buf, CHUNK_SIZE)) > 0)
-      {
-        dvipsTranscript.append(buf, n);
-      }
-    }
-    catch (const BrokenPipeException&)
+      dvipsTranscript.append(reinterpret_cast<const char*>(output), n);
+      return true;
+    });
+    multiplexer->Add(gsErr.GetFile(), [this](const void* output, size_t n)
     {
-    }
-  }
-  catch (const MiKTeXException&)
-  {
-  }
-  catch (const exception&)
-  {
-  }
-}
-
-void DviPageImpl::GhostscriptTranscriptReader()
-{
-  try
-  {
-#define CHUNK_SIZE 64
-    char buf[CHUNK_SIZE];
-    gsTranscript = "";
-    try
-    {
-      size_t n;
-      while ((n = gsErr.Read(buf, CHUNK_SIZE)) > 0)
-      {
-        gsTranscript.append(buf, n);
-      }
-    }
-    catch (const BrokenPipeException&)
-    {
-    }
+      gsTranscript.append(reinterpret_cast<const char*>(output), n);
+      return true;
+    });
+    multiplexer->Run();
   }
   catch (const MiKTeXException&)
   {
@@ -969,7 +1160,36 @@ int DviPageImpl::GetNumberOfGraphicsInclusions(int shrinkFactor)
 
 void DviPageImpl::DoPostScriptSpecials(int shrinkFactor)
 {
-  Ghostscript gs(dviImpl->GetTraceCallback());
+  bool havePostScript = false;
+  for (size_t idx = 0; !havePostScript && idx < dviSpecials.size(); ++idx)
+  {
+    DviSpecialType type = dviSpecials[idx]->GetType();
+    havePostScript = type == DviSpecialType::Psfile || type == DviSpecialType::Ps;
+  }
+  if (!havePostScript)
+  {
+    return;
+  }
+
+  unique_ptr<Ghostscript> ghostscript = dviImpl->AcquireGhostscript(shrinkFactor);
+  Ghostscript& gs = *ghostscript;
+
+  try
+  {
+    RenderPostScriptSpecials(gs, shrinkFactor);
+  }
+  catch (const exception&)
+  {
+    // the session is in an unknown state
+    gs.Shutdown();
+    throw;
+  }
+
+  dviImpl->ReleaseGhostscript(shrinkFactor, std::move(ghostscript));
+}
+
+void DviPageImpl::RenderPostScriptSpecials(Ghostscript& gs, int shrinkFactor)
+{
 
   for (size_t idx = 0; idx < dviSpecials.size(); ++idx)
   {
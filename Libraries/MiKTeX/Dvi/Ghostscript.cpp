@@ -1,6 +1,6 @@
 /* Ghostscript.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -25,12 +25,19 @@
 #include <fmt/ostream.h>
 
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/DirectoryLister>
 #include <miktex/Core/Quoter>
 
 #include "internal.h"
 
 #include "Ghostscript.h"
 
+// echoed by Ghostscript when a page has been rendered
+const char* const endOfPageMarker = "%%[MiKTeX: end of page]%%";
+
+// maximum time to wait for a page
+const int pageTimeout = 60;
+
 Ghostscript::Ghostscript(TraceCallback* traceCallback) :
   PostScript(traceCallback)
 {
@@ -38,12 +45,30 @@ Ghostscript::Ghostscript(TraceCallback* traceCallback) :
 
 Ghostscript::~Ghostscript()
 {
-  MIKTEX_ASSERT(process == nullptr);
-  MIKTEX_ASSERT(!chunkerThread.joinable());
-  MIKTEX_ASSERT(!stderrReaderThread.joinable());
-  MIKTEX_ASSERT(gsIn.GetFile() == nullptr);
-  MIKTEX_ASSERT(gsOut.GetFile() == nullptr);
-  MIKTEX_ASSERT(gsErr.GetFile() == nullptr);
+  try
+  {
+    Shutdown();
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+void Ghostscript::GetDeviceSize(int& width, int& height)
+{
+  PaperSizeInfo paperSizeInfo = dviImpl->GetPaperSizeInfo();
+  width = paperSizeInfo.width;
+  height = paperSizeInfo.height;
+  if (dviImpl->Landscape())
+  {
+    swap(width, height);
+  }
+  width =
+    static_cast<int>(((dviImpl->GetResolution() * width) / 72.0)
+      / shrinkFactor);
+  height =
+    static_cast<int>(((dviImpl->GetResolution() * height) / 72.0)
+      / shrinkFactor);
 }
 
 void Ghostscript::Start()
@@ -60,24 +85,16 @@ void Ghostscript::Start()
     MIKTEX_UNEXPECTED();
   }
 
+  GetDeviceSize(deviceWidth, deviceHeight);
+
+  // each page goes into a file of its own
+  pageDirectory = TemporaryDirectory::Create();
+
   // make Ghostscript command line
   vector<string> arguments{ gsExe.GetFileNameWithoutExtension().ToString() };
   string res = std::to_string(static_cast<double>(dviImpl->GetResolution()) / shrinkFactor);
   arguments.push_back("-r" + res + 'x' + res);
-  PaperSizeInfo paperSizeInfo = dviImpl->GetPaperSizeInfo();
-  int width = paperSizeInfo.width;
-  int height = paperSizeInfo.height;
-  if (dviImpl->Landscape())
-  {
-    swap(width, height);
-  }
-  width =
-    static_cast<int>(((dviImpl->GetResolution() * width) / 72.0)
-      / shrinkFactor);
-  height =
-    static_cast<int>(((dviImpl->GetResolution() * height) / 72.0)
-      / shrinkFactor);
-  arguments.push_back("-g" + std::to_string(width) + 'x' + std::to_string(height));
+  arguments.push_back("-g" + std::to_string(deviceWidth) + 'x' + std::to_string(deviceHeight));
   arguments.push_back("-sDEVICE="s + "bmp16m");
   arguments.push_back("-q");
   arguments.push_back("-dBATCH");
@@ -87,7 +104,7 @@ void Ghostscript::Start()
   arguments.push_back("-dTextAlphaBits="s + "4");
   arguments.push_back("-dGraphicsAlphaBits="s + "4");
   arguments.push_back("-dDOINTERPOLATE");
-  arguments.push_back("-sOutputFile="s + "-");
+  arguments.push_back("-sOutputFile="s + (pageDirectory->GetPathName() / "page%d.bmp").ToString());
   arguments.push_back("-");
 
   tracePS->WriteLine("libdvi", CommandLineBuilder(arguments).ToString());
@@ -98,26 +115,95 @@ void Ghostscript::Start()
   startinfo.FileName = gsExe.ToString();
   startinfo.StandardInput = nullptr;
   startinfo.RedirectStandardInput = true;
-  startinfo.RedirectStandardOutput = true;
+  startinfo.RedirectStandardOutput = false;
   startinfo.RedirectStandardError = true;
   startinfo.WorkingDirectory = dviImpl->GetDviFileName().MakeFullyQualified().RemoveFileSpec().ToString();
 
   process = Process::Start(startinfo);
 
   gsIn.Attach(process->get_StandardInput());
-  gsOut.Attach(process->get_StandardOutput());
   gsErr.Attach(process->get_StandardError());
 
-  // start chunker thread
-  chunkerThread = thread(&Ghostscript::Chunker, this);
+  stderrEof = false;
+  stderrBuffer.clear();
 
   // start stderr reader
   stderrReaderThread = thread(&Ghostscript::StderrReader, this);
+
+  // the standard headers are sent only once per session
+  vector<string> jobHeaders;
+  swap(headers, jobHeaders);
+  Initialize();
+  for (const string& header : headers)
+  {
+    SendHeader(header.c_str());
+    residentHeaders.insert(header);
+  }
+  for (const string& header : jobHeaders)
+  {
+    AddHeader(header.c_str());
+  }
+}
+
+void Ghostscript::Shutdown()
+{
+  // close Ghostscript's input stream
+  if (gsIn.GetFile() != nullptr)
+  {
+    gsIn.Close();
+  }
+
+  // wait for Ghostscript to finish
+  if (process != nullptr)
+  {
+    process->WaitForExit(10000);
+    process = nullptr;
+  }
+
+  // wait for stderr reader to finish
+  if (stderrReaderThread.joinable())
+  {
+    stderrReaderThread.join();
+  }
+
+  // close Ghostscript's error stream
+  if (gsErr.GetFile() != nullptr)
+  {
+    gsErr.Close();
+  }
+
+  if (pageFile.GetFile() != nullptr)
+  {
+    pageFile.Close();
+  }
+
+  pageDirectory = nullptr;
+  residentHeaders.clear();
+}
+
+void Ghostscript::BeginJob()
+{
+  if (process != nullptr)
+  {
+    int width, height;
+    GetDeviceSize(width, height);
+    if (width != deviceWidth || height != deviceHeight)
+    {
+      tracePS->WriteLine("libdvi", T_("device size has changed; restarting Ghostscript"));
+      Shutdown();
+    }
+  }
+  if (process == nullptr)
+  {
+    Start();
+  }
+  graphicsInclusions.clear();
+  Execute("/MiKTeXJobSave save def\n");
 }
 
 size_t Ghostscript::Read(void* data, size_t size)
 {
-  return gsOut.Read(data, size);
+  return pageFile.Read(data, size);
 }
 
 void Ghostscript::OnNewChunk(shared_ptr<DibChunk> dibChunk)
@@ -175,22 +261,36 @@ void Ghostscript::OnNewChunk(shared_ptr<DibChunk> dibChunk)
     ImageType::DIB, fileName, true, dibChunk->GetX(), dibChunk->GetY(), bitmapInfo->bmiHeader.biWidth, bitmapInfo->bmiHeader.biHeight));
 }
 
-void Ghostscript::Chunker()
+void Ghostscript::ReadPageFiles()
 {
+  vector<PathName> pageFiles;
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(pageDirectory->GetPathName(), "*.bmp", (int)DirectoryLister::Options::FilesOnly);
+  DirectoryEntry entry;
+  while (lister->GetNext(entry))
+  {
+    pageFiles.push_back(pageDirectory->GetPathName() / entry.name);
+  }
+  lister->Close();
+  sort(pageFiles.begin(), pageFiles.end());
   unique_ptr<DibChunker> pChunker(DibChunker::Create());
-  try
+  const int chunkSize = 2 * 1024 * 1024;
+  for (const PathName& path : pageFiles)
   {
-    const int chunkSize = 2 * 1024 * 1024;
-    while (pChunker->Process(DibChunker::Default, chunkSize, this))
+    pageFile.Attach(File::Open(path, FileMode::Open, FileAccess::Read, false));
+    try
     {
+      while (pChunker->Process(DibChunker::Default, chunkSize, this))
+      {
+      }
     }
+    catch (const exception&)
+    {
+      pageFile.Close();
+      throw;
+    }
+    pageFile.Close();
+    File::Delete(path);
   }
-  catch (const exception&)
-  {
-    gsOut.Close();
-    throw;
-  }
-  pChunker.reset();
 }
 
 void Ghostscript::StderrReader()
@@ -198,10 +298,41 @@ void Ghostscript::StderrReader()
   const int chunkSize = 64;
   char buf[chunkSize];
   size_t n;
-  while ((n = gsErr.Read(buf, chunkSize)) > 0)
+  try
+  {
+    while ((n = gsErr.Read(buf, chunkSize)) > 0)
+    {
+      lock_guard<mutex> lockGuard(stderrMutex);
+      stderrBuffer.append(buf, n);
+      stderrCondition.notify_one();
+    }
+  }
+  catch (const exception&)
+  {
+  }
+  lock_guard<mutex> lockGuard(stderrMutex);
+  stderrEof = true;
+  stderrCondition.notify_one();
+}
+
+bool Ghostscript::WaitForEndOfPage(string& transcript)
+{
+  unique_lock<mutex> lock(stderrMutex);
+  size_t pos = string::npos;
+  bool done = stderrCondition.wait_for(lock, chrono::seconds(pageTimeout), [this, &pos]()
+  {
+    pos = stderrBuffer.find(endOfPageMarker);
+    return pos != string::npos || stderrEof;
+  });
+  if (!done || pos == string::npos)
   {
-    stderrBuffer.append(buf, n);
+    transcript = stderrBuffer;
+    stderrBuffer.clear();
+    return false;
   }
+  transcript = stderrBuffer.substr(0, pos);
+  stderrBuffer.erase(0, pos + strlen(endOfPageMarker));
+  return true;
 }
 
 void Ghostscript::Write(const void* data, unsigned n)
@@ -220,62 +351,35 @@ void Ghostscript::Execute(const string& s)
 
 void Ghostscript::Finalize()
 {
-  // close Ghostscript's input stream
-  if (gsIn.GetFile() != nullptr)
-  {
-    gsIn.Close();
-  }
+  // restore the virtual memory and let Ghostscript echo the marker
+  Execute("MiKTeXJobSave restore\n");
+  Execute(fmt::format("(\\n{0}\\n) print flush\n", endOfPageMarker));
+  fflush(gsIn.GetFile());
 
-  // wait for Ghostscript to finish
-  int gsExitCode = -1;
-  if (process != nullptr)
-  {
-    if (process->WaitForExit(10000))
-    {
-      gsExitCode = process->get_ExitCode();
-    }
-    process = nullptr;
-  }
-
-  // wait for the chunker to finish
-  if (chunkerThread.joinable())
-  {
-    chunkerThread.join();
-  }
-
-  // wait for stderr reader to finish
-  if (stderrReaderThread.joinable())
-  {
-    stderrReaderThread.join();
-  }
+  string transcript;
+  bool done = WaitForEndOfPage(transcript);
 
   // write the transcript to the debug stream
-  if (!stderrBuffer.empty())
+  if (!transcript.empty())
   {
     tracePS->WriteLine("libdvi", fmt::format(T_("Ghostscript transcript follows:\n\
 ==========================================================================\n\
 {0}\n\
 =========================================================================="),
-                       stderrBuffer));
-  }
-
-  // close Ghostscript's output stream
-  if (gsOut.GetFile() != nullptr)
-  {
-    gsOut.Close();
+                       transcript));
   }
 
-  // close Ghostscript's error stream
-  if (gsErr.GetFile() != nullptr)
-  {
-    gsErr.Close();
-  }
+  // page definitions don't survive the job
+  definitions.clear();
+  headers.clear();
 
   PostScript::Finalize();
 
-  // check Ghostscript's exit code
-  if (gsExitCode != 0)
+  if (!done)
   {
+    Shutdown();
     MIKTEX_FATAL_ERROR(T_("Some PostScript specials could not be rendered."));
   }
+
+  ReadPageFiles();
 }
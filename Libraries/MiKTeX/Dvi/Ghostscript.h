@@ -1,6 +1,6 @@
 /* Ghostscript.h:                                       -*- C++ -*-
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -23,6 +23,9 @@
 
 #include "PostScript.h"
 
+// A Ghostscript session renders the PostScript specials of any number
+// of DVI pages.  Each page is rendered inside save/restore; the page
+// is complete when Ghostscript echoes the end-of-page marker.
 class Ghostscript :
   public PostScript,
   public IDibChunkerCallback
@@ -30,6 +33,9 @@ class Ghostscript :
 public:
   ~Ghostscript() override;
 
+private:
+  void BeginJob() override;
+
 private:
   void Finalize() override;
 
@@ -48,17 +54,29 @@ public:
 public:
   Ghostscript(TraceCallback *traceCallback);
 
+public:
+  bool IsRunning() const
+  {
+    return process != nullptr;
+  }
+
+public:
+  void Shutdown();
+
 private:
   void Start();
 
 private:
-  void Chunker();
+  void GetDeviceSize(int& width, int& height);
 
 private:
   void StderrReader();
 
 private:
-  thread chunkerThread;
+  bool WaitForEndOfPage(string& transcript);
+
+private:
+  void ReadPageFiles();
 
 private:
   thread stderrReaderThread;
@@ -67,14 +85,33 @@ private:
   FileStream gsIn;
 
 private:
-  FileStream gsOut;
+  FileStream gsErr;
 
 private:
-  FileStream gsErr;
+  FileStream pageFile;
 
 private:
   unique_ptr<Process> process;
 
+private:
+  unique_ptr<MiKTeX::Core::TemporaryDirectory> pageDirectory;
+
+  // device size the session was started with
+private:
+  int deviceWidth = 0;
+
+private:
+  int deviceHeight = 0;
+
+private:
+  mutex stderrMutex;
+
+private:
+  condition_variable stderrCondition;
+
+private:
+  bool stderrEof = false;
+
 private:
   string stderrBuffer;
 };
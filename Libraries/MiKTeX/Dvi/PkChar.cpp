@@ -1,6 +1,6 @@
 /* PkChar.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -35,7 +35,7 @@ const unsigned long bitsPerRasterWord = 16;
 #undef min
 #endif
 
-const int PkChar::powerOfTwo[32] =
+const int PkGlyph::powerOfTwo[32] =
 {
   twopwr(0), twopwr(1), twopwr(2), twopwr(3), twopwr(4), twopwr(5), twopwr(6), twopwr(7),
   twopwr(8), twopwr(9), twopwr(10), twopwr(11), twopwr(12), twopwr(13), twopwr(14), twopwr(15),
@@ -43,7 +43,7 @@ const int PkChar::powerOfTwo[32] =
   twopwr(24), twopwr(25), twopwr(26), twopwr(27), twopwr(28), twopwr(29), twopwr(30), twopwr(31)
 };
 
-const int PkChar::gpower[33] =
+const int PkGlyph::gpower[33] =
 {
   twopwr(0) - 1, twopwr(1) - 1, twopwr(2) - 1, twopwr(3) - 1, twopwr(4) - 1, twopwr(5) - 1, twopwr(6) - 1, twopwr(7) - 1,
   twopwr(8) - 1, twopwr(9) - 1, twopwr(10) - 1, twopwr(11) - 1, twopwr(12) - 1, twopwr(13) - 1, twopwr(14) - 1, twopwr(15) - 1,
@@ -52,19 +52,17 @@ const int PkChar::gpower[33] =
   -1
 };
 
-int PkChar::GetLower3()
+int PkGlyph::GetLower3()
 {
   return flag & 7;
 }
 
-PkChar::PkChar(DviFont* pFont) :
-  DviChar(pFont),
-  trace_error(TraceStream::Open(MIKTEX_TRACE_ERROR, pFont->GetTraceCallback())),
-  trace_pkchar(TraceStream::Open(MIKTEX_TRACE_DVIPKCHAR, pFont->GetTraceCallback()))
+PkGlyph::PkGlyph() :
+  trace_pkchar(TraceStream::Open(MIKTEX_TRACE_DVIPKCHAR))
 {
 }
 
-PkChar::~PkChar()
+PkGlyph::~PkGlyph()
 {
   try
   {
@@ -83,11 +81,6 @@ PkChar::~PkChar()
       free(it->second);
       it->second = nullptr;
     }
-    if (trace_error != nullptr)
-    {
-      trace_error->Close();
-      trace_error = nullptr;
-    }
     if (trace_pkchar != nullptr)
     {
       trace_pkchar->Close();
@@ -99,22 +92,22 @@ PkChar::~PkChar()
   }
 }
 
-bool PkChar::IsShort()
+bool PkGlyph::IsShort()
 {
   return GetLower3() < 4 ? true : false;
 }
 
-bool PkChar::IsExtendedShort()
+bool PkGlyph::IsExtendedShort()
 {
   return GetLower3() < 7 && !IsShort() ? true : false;
 }
 
-bool PkChar::IsLong()
+bool PkGlyph::IsLong()
 {
   return GetLower3() == 7 ? true : false;
 }
 
-void PkChar::Read(InputStream& inputstream, int flag)
+void PkGlyph::Read(InputStream& inputstream, int flag)
 {
   this->flag = flag;
 
@@ -158,8 +151,6 @@ void PkChar::Read(InputStream& inputstream, int flag)
     cyOffset = inputstream.ReadSignedQuad();
   }
 
-  tfm = ScaleFix(tfm, dviFont->GetScaledAt());
-
   if (packetSize == 0)
   {
 #if 0
@@ -174,7 +165,7 @@ void PkChar::Read(InputStream& inputstream, int flag)
   }
 }
 
-int PkChar::Unpacker::GetNybble()
+int PkGlyph::Unpacker::GetNybble()
 {
   if (bitWeight == 0)
   {
@@ -189,7 +180,7 @@ int PkChar::Unpacker::GetNybble()
   return temp;
 }
 
-bool PkChar::Unpacker::GetBit()
+bool PkGlyph::Unpacker::GetBit()
 {
   bitWeight /= 2;
 
@@ -209,7 +200,7 @@ bool PkChar::Unpacker::GetBit()
   return temp;
 }
 
-int PkChar::Unpacker::GetPackedNumber()
+int PkGlyph::Unpacker::GetPackedNumber()
 {
   int i = GetNybble();
   int j;
@@ -249,7 +240,7 @@ int PkChar::Unpacker::GetPackedNumber()
   }
 }
 
-void PkChar::Unpack()
+void PkGlyph::Unpack()
 {
   if (unpackedRaster != nullptr)
   {
@@ -374,12 +365,35 @@ namespace {
   };
 }
 
-unsigned long PkChar::CountBits(const RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h)
+unsigned long PkGlyph::CountBits(const RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h)
 {
   unsigned long result = 0;
 
-  unsigned long rightShift = bitsPerRasterWord - (xStart % bitsPerRasterWord);
-  rasterWord += xStart / bitsPerRasterWord;
+  int wordIdx = xStart / bitsPerRasterWord;
+  int bitIdx = xStart % bitsPerRasterWord;
+
+  if (w <= static_cast<int>(maxBitFieldLength))
+  {
+    // the sample fits into a window of two adjacent raster words: one
+    // table lookup per raster row
+    bool haveNextWord = wordIdx + 1 < rasterWordsPerLine;
+    unsigned long rightShift = 2 * bitsPerRasterWord - bitIdx - w;
+    unsigned long mask = gpower[w];
+    rasterWord += wordIdx;
+    for (int i = 0; i < h; ++i, rasterWord += rasterWordsPerLine)
+    {
+      unsigned long window = static_cast<unsigned long>(static_cast<unsigned short>(rasterWord[0])) << bitsPerRasterWord;
+      if (haveNextWord)
+      {
+        window |= static_cast<unsigned short>(rasterWord[1]);
+      }
+      result += bitcounts[(window >> rightShift) & mask];
+    }
+    return result;
+  }
+
+  unsigned long rightShift = bitsPerRasterWord - bitIdx;
+  rasterWord += wordIdx;
 
   while (w > 0)
   {
@@ -405,19 +419,13 @@ unsigned long PkChar::CountBits(const RASTERWORD* rasterWord, int xStart, int ra
   return result;
 }
 
-void PkChar::Print()
-{
-}
-
 inline unsigned long color(unsigned long n, unsigned long bitsPerPixel, unsigned long shrinkFactor)
 {
   return Round(static_cast<double>(n * (twopwr(bitsPerPixel) - 1)) / static_cast<double>(shrinkFactor * shrinkFactor));
 }
 
-void* PkChar::Shrink(int shrinkFactor)
+void* PkGlyph::Shrink(int shrinkFactor)
 {
-#define BE_FAST
-#ifdef BE_FAST
   if (shrinkFactor == 1)
   {
     unsigned long cbLine = ((rasterWidth + 31) / 32) * 4;
@@ -426,47 +434,27 @@ void* PkChar::Shrink(int shrinkFactor)
     unsigned char* pShrinkedRaster = reinterpret_cast<unsigned char*>(malloc(rasterHeight * cbLine));
     memset(pShrinkedRaster, 0, rasterHeight * cbLine);
 
-    int shrinkedRasterHeight = 0;
-
-    for (int row = 0; row < rasterHeight; ++shrinkedRasterHeight, ++row)
+    // raster words hold 16 pixels, most significant bit first, and the
+    // padding bits are clear: copy the raster bytewise
+    for (int row = 0; row < rasterHeight; ++row)
     {
-      BYTE* pbyte = &pShrinkedRaster[shrinkedRasterHeight * cbLine];
-      unsigned long idxBit = 7;
-      for (int col = 0; col < rasterWidth; ++col)
+      BYTE* pbyte = &pShrinkedRaster[row * cbLine];
+      const RASTERWORD* rasterWord = unpackedRaster + rasterWordsPerLine * row;
+      for (unsigned long idx = 0; idx < rasterWordsPerLine; ++idx)
       {
-        RASTERWORD rw =
-          unpackedRaster[(rasterWordsPerLine * row
-            + col / bitsPerRasterWord)];
-        unsigned long n =
-          ((rw & powerOfTwo[bitsPerRasterWord
-            - col % bitsPerRasterWord
-            - 1])
-            ? 1
-            : 0);
-        if (idxBit == 0)
-        {
-          *pbyte |= static_cast<BYTE>(n);
-          ++pbyte;
-          idxBit = 7;
-        }
-        else
-        {
-          int shift = idxBit;
-          *pbyte |= static_cast<BYTE>((n << shift) & 0xff);
-          --idxBit;
-        }
-
+        unsigned short rw = static_cast<unsigned short>(rasterWord[idx]);
+        *pbyte++ = static_cast<BYTE>(rw >> 8);
+        *pbyte++ = static_cast<BYTE>(rw & 0xff);
       }
     }
 
     return pShrinkedRaster;
   }
-#endif // BE_FAST
 
   int widthShr = GetWidthShr(shrinkFactor);
   int heightShr = GetHeightShr(shrinkFactor);
 
-  unsigned long bitsPerPixel = dviFont->GetDviObject()->GetBitsPerPixel(shrinkFactor);
+  unsigned long bitsPerPixel = DviImpl::GetBitsPerPixel(shrinkFactor);
   unsigned long lineSizeShr = ((widthShr * bitsPerPixel + 31) / 32) * 4;
 
   unsigned long rasterWordsPerLine = (rasterWidth + bitsPerRasterWord - 1) / bitsPerRasterWord;
@@ -474,6 +462,13 @@ void* PkChar::Shrink(int shrinkFactor)
   unsigned char* pShrinkedRaster = reinterpret_cast<unsigned char*>(malloc(heightShr * lineSizeShr));
   memset(pShrinkedRaster, 0, heightShr * lineSizeShr);
 
+  // gray levels by number of black pixels
+  vector<BYTE> colors(shrinkFactor * shrinkFactor + 1);
+  for (size_t n = 0; n < colors.size(); ++n)
+  {
+    colors[n] = static_cast<BYTE>(color(n, bitsPerPixel, shrinkFactor));
+  }
+
   int shrinkedRasterHeight = 0;
 
   int sampleHeight = (cyOffset + 1) - ((cyOffset + 1) / shrinkFactor) * shrinkFactor;
@@ -496,7 +491,7 @@ void* PkChar::Shrink(int shrinkFactor)
 
     for (int col = 0; col < rasterWidth; )
     {
-      unsigned long n = color(CountBits(unpackedRaster + (rasterWordsPerLine * row), col, rasterWordsPerLine, std::min(sampleWidth, rasterWidth - col), std::min(sampleHeight, rasterHeight - row)), bitsPerPixel, shrinkFactor);
+      unsigned long n = colors[CountBits(unpackedRaster + (rasterWordsPerLine * row), col, rasterWordsPerLine, std::min(sampleWidth, rasterWidth - col), std::min(sampleHeight, rasterHeight - row))];
 
       if (idxBit == bitsPerPixel - 1)
       {
@@ -522,8 +517,10 @@ void* PkChar::Shrink(int shrinkFactor)
   return pShrinkedRaster;
 }
 
-const void* PkChar::GetBitmap(int shrinkFactor)
+const void* PkGlyph::GetBitmap(int shrinkFactor)
 {
+  // page loader threads rasterize pages concurrently
+  lock_guard<mutex> lockGuard(bitmapsMutex);
   MAPINTTORASTER::const_iterator it = bitmaps.find(shrinkFactor);
   if (it != bitmaps.end())
   {
@@ -534,3 +531,13 @@ const void* PkChar::GetBitmap(int shrinkFactor)
   bitmaps[shrinkFactor] = p;
   return p;
 }
+
+PkChar::PkChar(DviFont* dviFont, shared_ptr<PkGlyph> glyph) :
+  DviChar(dviFont),
+  glyph(glyph)
+{
+  charCode = glyph->GetCharacterCode();
+  tfm = ScaleFix(glyph->GetTfm(), dviFont->GetScaledAt());
+  cx = glyph->GetCx();
+  cy = glyph->GetCy();
+}
@@ -1,6 +1,6 @@
 /* PkChar.h:                                            -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -24,73 +24,83 @@
 class InputStream;
 class DviFont;
 
-class PkChar :
-  public DviChar
+// The glyph of a PK character.  Glyphs don't depend on the DVI document:
+// they are shared by all documents which use the same PK file (see
+// PkFontFile).  The raster is unpacked when the first bitmap is requested.
+class PkGlyph
 {
 public:
-  PkChar(DviFont* dviFont = nullptr);
+  PkGlyph();
 
 public:
-  ~PkChar() override;
+  ~PkGlyph();
 
 public:
   void Read(InputStream& inputstream, int flag);
 
 public:
-  int GetWidthShr(int shrinkFactor)
+  int GetCharacterCode() const
   {
-    return shrinkFactor == 1 ? rasterWidth : WidthShrink(shrinkFactor, rasterWidth) + 1;
+    return charCode;
   }
 
+  // unscaled TFM width
 public:
-  int GetHeightShr(int shrinkFactor)
+  int GetTfm() const
   {
-    return shrinkFactor == 1 ? rasterHeight : WidthShrink(shrinkFactor, rasterHeight) + 1;
+    return tfm;
   }
 
 public:
-  int GetWidthUns()
+  int GetCx() const
   {
-    return rasterWidth;
+    return cx;
   }
 
 public:
-  int GetHeightUns()
+  int GetCy() const
   {
-    return rasterHeight;
+    return cy;
   }
 
 public:
-  int GetLeftShr(int shrinkFactor, int x)
+  int GetCxOffset() const
   {
-    return PixelShrink(shrinkFactor, x) - cxOffset / shrinkFactor;
+    return cxOffset;
   }
 
 public:
-  int GetTopShr(int shrinkFactor, int y)
+  int GetCyOffset() const
   {
-    return PixelShrink(shrinkFactor, y) - cyOffset / shrinkFactor;
+    return cyOffset;
   }
 
 public:
-  int GetLeftUns(int x)
+  int GetWidthShr(int shrinkFactor)
   {
-    return x - cxOffset;
+    return shrinkFactor == 1 ? rasterWidth : WidthShrink(shrinkFactor, rasterWidth) + 1;
   }
 
 public:
-  int GetTopUns(int y)
+  int GetHeightShr(int shrinkFactor)
+  {
+    return shrinkFactor == 1 ? rasterHeight : WidthShrink(shrinkFactor, rasterHeight) + 1;
+  }
+
+public:
+  int GetWidthUns()
   {
-    return y - cyOffset;
+    return rasterWidth;
   }
 
 public:
-  const void *
-    GetBitmap(int shrinkFactor);
+  int GetHeightUns()
+  {
+    return rasterHeight;
+  }
 
 public:
-  void
-    Print();
+  const void* GetBitmap(int shrinkFactor);
 
   // 16-bit raster word, big-endian
 private:
@@ -117,25 +127,42 @@ private:
 private:
   void* Shrink(int shrinkFactor);
 
-private:
-  inline int PixelShrink(int shrinkFactor, int pxl);
-
 private:
   inline int WidthShrink(int shrinkFactor, int pxl);
 
 private:
   typedef unordered_map<int, void*> MAPINTTORASTER;
 
+  // shrinked bitmaps by shrink factor
 private:
   MAPINTTORASTER bitmaps;
 
+private:
+  mutex bitmapsMutex;
+
   // flag byte  
 private:
-  int flag;
+  int flag = 0;
+
+  // character code
+private:
+  int charCode = 0;
+
+  // unscaled glyph width
+private:
+  int tfm = 0;
+
+  // horizontal escapement (in pixels)
+private:
+  int cx = 0;
+
+  // vertical escapement (in pixels)
+private:
+  int cy = 0;
 
   // length (in bytes) of packed raster data
 private:
-  int packetSize;
+  int packetSize = 0;
 
   // width (in pixels) of minimum bounding box
 private:
@@ -228,8 +255,72 @@ private:
   };
 
 private:
-  unique_ptr<TraceStream> trace_error;
+  unique_ptr<TraceStream> trace_pkchar;
+};
+
+class PkChar :
+  public DviChar
+{
+public:
+  PkChar(DviFont* dviFont, shared_ptr<PkGlyph> glyph);
+
+public:
+  int GetWidthShr(int shrinkFactor)
+  {
+    return glyph->GetWidthShr(shrinkFactor);
+  }
+
+public:
+  int GetHeightShr(int shrinkFactor)
+  {
+    return glyph->GetHeightShr(shrinkFactor);
+  }
+
+public:
+  int GetWidthUns()
+  {
+    return glyph->GetWidthUns();
+  }
+
+public:
+  int GetHeightUns()
+  {
+    return glyph->GetHeightUns();
+  }
+
+public:
+  int GetLeftShr(int shrinkFactor, int x)
+  {
+    return PixelShrink(shrinkFactor, x) - glyph->GetCxOffset() / shrinkFactor;
+  }
+
+public:
+  int GetTopShr(int shrinkFactor, int y)
+  {
+    return PixelShrink(shrinkFactor, y) - glyph->GetCyOffset() / shrinkFactor;
+  }
+
+public:
+  int GetLeftUns(int x)
+  {
+    return x - glyph->GetCxOffset();
+  }
+
+public:
+  int GetTopUns(int y)
+  {
+    return y - glyph->GetCyOffset();
+  }
+
+public:
+  const void* GetBitmap(int shrinkFactor)
+  {
+    return glyph->GetBitmap(shrinkFactor);
+  }
+
+private:
+  inline int PixelShrink(int shrinkFactor, int pxl);
 
 private:
-  unique_ptr<TraceStream> trace_pkchar;
+  shared_ptr<PkGlyph> glyph;
 };
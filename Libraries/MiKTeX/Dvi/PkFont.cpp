@@ -1,6 +1,6 @@
 /* PkFont.cpp:
 
-   Copyright (C) 1996-2022 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -27,6 +27,7 @@
 #include <fmt/ostream.h>
 
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/File>
 #include <miktex/Core/Paths>
 
 #include "internal.h"
@@ -159,6 +160,33 @@ const int pk_post = 245;
 const int pk_no_op = 246;
 const int pk_pre = 247;
 
+int PkFont::GetDpi()
+{
+  int dpi =
+    static_cast<int>((static_cast<double>(mag)
+      * static_cast<double>(scaledAt)
+      * static_cast<double>(baseDpi))
+      / (static_cast<double>(designSize) * 1000.0)
+      + 0.5);
+  return CheckDpi(dpi, baseDpi);
+}
+
+// Starts making the PK file in the background, if it doesn't exist.
+// Read() waits for the result.
+void PkFont::StartMake()
+{
+  if (!pkChars.empty() || dviInfo.notLoadable)
+  {
+    return;
+  }
+  int dpi = GetDpi();
+  PathName fileName;
+  if (!session->FindPkFile(dviInfo.name, metafontMode, dpi, fileName))
+  {
+    MakeAsync(dviInfo.name, dpi, baseDpi, metafontMode);
+  }
+}
+
 void PkFont::Read()
 {
   if (!pkChars.empty() || dviInfo.notLoadable)
@@ -168,13 +196,7 @@ void PkFont::Read()
 
   trace_pkfont->WriteLine("libdvi", fmt::format(T_("going to load pk font {0}"), dviInfo.name));
 
-  int dpi =
-    static_cast<int>((static_cast<double>(mag)
-      * static_cast<double>(scaledAt)
-      * static_cast<double>(baseDpi))
-      / (static_cast<double>(designSize) * 1000.0)
-      + 0.5);
-  dpi = CheckDpi(dpi, baseDpi);
+  int dpi = GetDpi();
 
   dviInfo.notLoadable = true;
 
@@ -210,8 +232,43 @@ void PkFont::Read()
 
   dviInfo.fileName = fileName.ToString();
 
+  pkFontFile = GetPkFontFile(fileName);
+  if (pkFontFile == nullptr)
+  {
+    pkFontFile = AddPkFontFile(fileName, ReadPkFile(fileName));
+  }
+  else
+  {
+    trace_pkfont->WriteLine("libdvi", fmt::format(T_("sharing pk file {0}"), Q_(fileName.ToDisplayString())));
+  }
+
+  dviInfo.comment = pkFontFile->comment;
+  hppp = pkFontFile->hppp;
+  vppp = pkFontFile->vppp;
+
+  if (pkFontFile->designSize * tfmConv != designSize)
+  {
+    trace_error->WriteLine("libdvi", fmt::format(T_("{0}: designSize mismatch"), dviInfo.name));
+  }
+  if (pkFontFile->checkSum != checkSum)
+  {
+    trace_error->WriteLine("libdvi", fmt::format(T_("{0}: checkSum mismatch"), dviInfo.name));
+  }
+
+  for (const auto& glyph : pkFontFile->glyphs)
+  {
+    pkChars[glyph.first] = new PkChar(this, glyph.second);
+  }
+
+  dviInfo.notLoadable = !fontFileExists;
+}
+
+shared_ptr<PkFontFile> PkFont::ReadPkFile(const PathName& fileName)
+{
   trace_pkfont->WriteLine("libdvi", fmt::format(T_("opening pk file {0}"), Q_(fileName.ToDisplayString())));
 
+  shared_ptr<PkFontFile> result = make_shared<PkFontFile>();
+
   InputStream inputstream(fileName.GetData());
   int b;
   while (inputstream.TryToReadByte(b))
@@ -268,60 +325,170 @@ void PkFont::Read()
       char tmp[256];
       inputstream.Read(tmp, len);
       tmp[len] = 0;
-      dviInfo.comment = tmp;
-      int my_designSize = inputstream.ReadSignedQuad();
-      int my_checkSum = inputstream.ReadSignedQuad();
-      hppp = inputstream.ReadSignedQuad();
-      vppp = inputstream.ReadSignedQuad();
-      trace_pkfont->WriteLine("libdvi", fmt::format("comment: {0}", dviInfo.comment));
-      trace_pkfont->WriteLine("libdvi", fmt::format("designSize: {0}", my_designSize));
-      trace_pkfont->WriteLine("libdvi", fmt::format("checkSum: {0:o}", my_checkSum));
-      trace_pkfont->WriteLine("libdvi", fmt::format("hppp: {0}", hppp));
-      trace_pkfont->WriteLine("libdvi", fmt::format("vppp: {0}", vppp));
-
-      if (my_designSize * tfmConv != designSize)
-      {
-        trace_error->WriteLine("libdvi", fmt::format(T_("{0}: designSize mismatch"), dviInfo.name));
-      }
-      if (my_checkSum != checkSum)
-      {
-        trace_error->WriteLine("libdvi", fmt::format(T_("{0}: checkSum mismatch"), dviInfo.name));
-      }
+      result->comment = tmp;
+      result->designSize = inputstream.ReadSignedQuad();
+      result->checkSum = inputstream.ReadSignedQuad();
+      result->hppp = inputstream.ReadSignedQuad();
+      result->vppp = inputstream.ReadSignedQuad();
+      trace_pkfont->WriteLine("libdvi", fmt::format("comment: {0}", result->comment));
+      trace_pkfont->WriteLine("libdvi", fmt::format("designSize: {0}", result->designSize));
+      trace_pkfont->WriteLine("libdvi", fmt::format("checkSum: {0:o}", result->checkSum));
+      trace_pkfont->WriteLine("libdvi", fmt::format("hppp: {0}", result->hppp));
+      trace_pkfont->WriteLine("libdvi", fmt::format("vppp: {0}", result->vppp));
     }
     break;
 
     default:
 
       // do a character definition
-      PkChar* pkChar = new PkChar(this);
-      pkChar->Read(inputstream, b);
-      pkChars[pkChar->GetCharacterCode()] = pkChar;
+      shared_ptr<PkGlyph> glyph = make_shared<PkGlyph>();
+      glyph->Read(inputstream, b);
+      result->glyphs[glyph->GetCharacterCode()] = glyph;
       break;
     }
   }
 
-  dviInfo.notLoadable = !fontFileExists;
+  return result;
+}
+
+namespace
+{
+  struct PkFontFileCacheEntry
+  {
+    time_t lastWriteTime;
+    weak_ptr<PkFontFile> pkFontFile;
+  };
+
+  // PK files in use, by path
+  mutex pkFontFilesMutex;
+  unordered_map<string, PkFontFileCacheEntry> pkFontFiles;
+}
+
+shared_ptr<PkFontFile> PkFont::GetPkFontFile(const PathName& fileName)
+{
+  time_t lastWriteTime = File::GetLastWriteTime(fileName);
+  lock_guard<mutex> lockGuard(pkFontFilesMutex);
+  auto it = pkFontFiles.find(fileName.ToString());
+  if (it == pkFontFiles.end() || it->second.lastWriteTime != lastWriteTime)
+  {
+    return nullptr;
+  }
+  return it->second.pkFontFile.lock();
+}
+
+shared_ptr<PkFontFile> PkFont::AddPkFontFile(const PathName& fileName, shared_ptr<PkFontFile> pkFontFile)
+{
+  time_t lastWriteTime = File::GetLastWriteTime(fileName);
+  lock_guard<mutex> lockGuard(pkFontFilesMutex);
+  PkFontFileCacheEntry& entry = pkFontFiles[fileName.ToString()];
+  shared_ptr<PkFontFile> existing = entry.pkFontFile.lock();
+  if (existing != nullptr && entry.lastWriteTime == lastWriteTime)
+  {
+    // another document was faster
+    return existing;
+  }
+  entry.lastWriteTime = lastWriteTime;
+  entry.pkFontFile = pkFontFile;
+  // forget PK files which are no longer in use
+  for (auto it = pkFontFiles.begin(); it != pkFontFiles.end(); )
+  {
+    if (it->second.pkFontFile.expired())
+    {
+      it = pkFontFiles.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  return pkFontFile;
+}
+
+namespace
+{
+  // makepk runs of all documents, by name, resolution and mode
+  mutex makePkJobsMutex;
+  unordered_map<string, shared_future<MakePkResult>> makePkJobs;
+
+  // throttles concurrent makepk runs
+  mutex makePkSlotsMutex;
+  condition_variable makePkSlotsCondition;
+  int busyMakePkSlots = 0;
+
+  const int maxMakePkJobs = 4;
+
+  string MakePkJobKey(const string& name, int dpi, const string& metafontMode)
+  {
+    return fmt::format("{0}:{1}:{2}", name, dpi, metafontMode);
+  }
+
+  int GetMaxMakePkJobs()
+  {
+    int n = static_cast<int>(thread::hardware_concurrency());
+    return n < 1 ? 1 : n > maxMakePkJobs ? maxMakePkJobs : n;
+  }
+}
+
+// Runs makepk in the background.  Requests for the same PK file are
+// coalesced, also across DVI documents.
+shared_future<MakePkResult> PkFont::MakeAsync(const string& name, int dpi, int baseDpi, const string& metafontMode)
+{
+  string key = MakePkJobKey(name, dpi, metafontMode);
+  lock_guard<mutex> lockGuard(makePkJobsMutex);
+  auto it = makePkJobs.find(key);
+  if (it != makePkJobs.end())
+  {
+    return it->second;
+  }
+  shared_ptr<Session> session = MIKTEX_SESSION();
+  PathName pathMakePk;
+  vector<string> args = session->MakeMakePkCommandLine(name, dpi, baseDpi, metafontMode, pathMakePk, TriState::Undetermined);
+  shared_future<MakePkResult> job = async(launch::async, [pathMakePk, args]()
+  {
+    {
+      unique_lock<mutex> lock(makePkSlotsMutex);
+      makePkSlotsCondition.wait(lock, []() { return busyMakePkSlots < GetMaxMakePkJobs(); });
+      busyMakePkSlots += 1;
+    }
+    MIKTEX_AUTO(
+      {
+        lock_guard<mutex> lockGuard(makePkSlotsMutex);
+        busyMakePkSlots -= 1;
+        makePkSlotsCondition.notify_one();
+      });
+    MakePkResult result;
+    result.commandLine = CommandLineBuilder(args).ToString();
+    ProcessOutput<4096> makepkOutput;
+    int exitCode;
+    result.done = Process::Run(pathMakePk, args, &makepkOutput, &exitCode, nullptr) && exitCode == 0;
+    result.output = makepkOutput.StdoutToString();
+    return result;
+  }).share();
+  makePkJobs[key] = job;
+  return job;
 }
 
 bool PkFont::Make(const string& name, int dpi, int baseDpi, const string& metafontMode)
 {
+  dviImpl->Progress(DviNotification::BeginLoadFont, fmt::format("{0}...", dviInfo.name));
+  shared_future<MakePkResult> job = MakeAsync(name, dpi, baseDpi, metafontMode);
+  const MakePkResult& result = job.get();
+  {
+    // a failed run may be retried later
+    lock_guard<mutex> lockGuard(makePkJobsMutex);
+    makePkJobs.erase(MakePkJobKey(name, dpi, metafontMode));
+  }
   dviInfo.transcript += "\r\n";
   dviInfo.transcript += T_("Making PK font:\r\n");
-  PathName pathMakePk;
-  vector<string> args = session->MakeMakePkCommandLine(name, dpi, baseDpi, metafontMode, pathMakePk, TriState::Undetermined);
-  dviInfo.transcript += CommandLineBuilder(args).ToString();
+  dviInfo.transcript += result.commandLine;
   dviInfo.transcript += "\r\n";
-  dviImpl->Progress(DviNotification::BeginLoadFont, fmt::format("{0}...", dviInfo.name));
-  ProcessOutput<4096> makepkOutput;
-  int exitCode;
-  bool b = Process::Run(pathMakePk, args, &makepkOutput, &exitCode, nullptr) && exitCode == 0;
-  if (!b)
+  if (!result.done)
   {
-    trace_error->WriteLine("libdvi", makepkOutput.StdoutToString());
+    trace_error->WriteLine("libdvi", result.output);
   }
-  dviInfo.transcript += makepkOutput.StdoutToString();
+  dviInfo.transcript += result.output;
   dviInfo.transcript += "\r\n";
-  return b;
+  return result.done;
 }
 
 PkChar* PkFont::operator[] (unsigned long idx)
@@ -331,7 +498,7 @@ PkChar* PkFont::operator[] (unsigned long idx)
   if (pkChar == nullptr)
   {
     trace_pkfont->WriteLine("libdvi", fmt::format(T_("{0}: nil character at {1}"), dviInfo.name, idx));
-    pkChar = new PkChar(this);
+    pkChar = new PkChar(this, make_shared<PkGlyph>());
     pkChars[idx] = pkChar;
   }
   return pkChar;
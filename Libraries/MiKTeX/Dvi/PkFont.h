@@ -1,6 +1,6 @@
 /* PkFont.h:                                            -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -23,6 +23,26 @@
 
 typedef unordered_map<int, PkChar *> MAPNUMTOPKCHAR;
 
+// The outcome of a makepk run.
+struct MakePkResult
+{
+  bool done = false;
+  string commandLine;
+  string output;
+};
+
+// The contents of a PK file.  PK files are shared by all DVI documents
+// of the process, so that a glyph is decoded and shrinked only once.
+struct PkFontFile
+{
+  string comment;
+  int designSize = 0;
+  int checkSum = 0;
+  int hppp = 0;
+  int vppp = 0;
+  unordered_map<int, shared_ptr<PkGlyph>> glyphs;
+};
+
 class PkFont :
   public DviFont
 {
@@ -47,12 +67,30 @@ private:
 private:
   bool Make(const string& name, int dpi, int baseDpi, const string& metafontMode);
 
+private:
+  static shared_future<MakePkResult> MakeAsync(const string& name, int dpi, int baseDpi, const string& metafontMode);
+
+private:
+  int GetDpi();
+
+public:
+  void StartMake();
+
 private:
   bool MakeTFM(const string& name);
 
 public:
   void Read();
 
+private:
+  shared_ptr<PkFontFile> ReadPkFile(const PathName& fileName);
+
+private:
+  static shared_ptr<PkFontFile> GetPkFontFile(const PathName& fileName);
+
+private:
+  static shared_ptr<PkFontFile> AddPkFontFile(const PathName& fileName, shared_ptr<PkFontFile> pkFontFile);
+
 public:
   void ReadTFM();
 
@@ -68,6 +106,9 @@ private:
 private:
   MAPNUMTOPKCHAR pkChars;
 
+private:
+  shared_ptr<PkFontFile> pkFontFile;
+
 private:
   int existSizes[30];
 
@@ -1,6 +1,6 @@
 /* PostScript.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -194,7 +194,10 @@ void PostScript::DoProlog()
   vector<string>::iterator it;
   for (it = headers.begin(); it != headers.end(); ++it)
   {
-    SendHeader(it->c_str());
+    if (residentHeaders.find(*it) == residentHeaders.end())
+    {
+      SendHeader(it->c_str());
+    }
   }
   DoDefinitions();
 }
@@ -376,6 +379,7 @@ void PostScript::Open(DviImpl* dviImpl, int shrinkFactor)
   }
 
   // initialize
+  BeginJob();
   Initialize();
   DoProlog();
   Execute("TeXDict begin\n");
@@ -407,6 +411,10 @@ void PostScript::EndPage()
   pageBegunFlag = false;
 }
 
+void PostScript::BeginJob()
+{
+}
+
 void PostScript::Finalize()
 {
 }
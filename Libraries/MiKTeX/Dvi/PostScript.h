@@ -1,6 +1,6 @@
 /* PostScript.h:                                        -*- C++ -*-
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -26,6 +26,9 @@ class PostScript
 protected:
   virtual ~PostScript();
 
+protected:
+  virtual void BeginJob();
+
 protected:
   virtual void Finalize();
 
@@ -140,6 +143,10 @@ protected:
 protected:
   vector<string> headers;
 
+  // headers which have been sent outside of the current job
+protected:
+  set<string> residentHeaders;
+
 protected:
   vector<shared_ptr<GraphicsInclusion> > graphicsInclusions;
 
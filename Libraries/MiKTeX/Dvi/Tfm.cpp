@@ -1,6 +1,6 @@
 /* Tfm.cpp:
 
-   Copyright (C) 1996-2022 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -120,7 +120,18 @@ void Tfm::Read()
 
   trace_tfm->WriteLine("libdvi", fmt::format(T_("opening TFM file {0}"), Q_(fileName.ToDisplayString())));
 
-  InputStream inputStream(fileName.GetData());
+  vector<unsigned char> data;
+  unique_ptr<InputStream> stream;
+  if (session->IsFontMetricCacheEnabled())
+  {
+    data = session->ReadFontMetricFile(fileName);
+    stream = make_unique<InputStream>(data.data(), data.size());
+  }
+  else
+  {
+    stream = make_unique<InputStream>(fileName.GetData());
+  }
+  InputStream& inputStream = *stream;
 
   long lf = inputStream.ReadSignedPair();
 
@@ -1,6 +1,6 @@
 /* inliners.h: inlined functions                        -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -24,9 +24,9 @@ inline int PkChar::PixelShrink(int shrinkFactor, int pxl)
   return dviFont->PixelShrink(shrinkFactor, pxl);
 }
 
-inline int PkChar::WidthShrink(int shrinkFactor, int pxl)
+inline int PkGlyph::WidthShrink(int shrinkFactor, int pxl)
 {
-  return dviFont->WidthShrink(shrinkFactor, pxl);
+  return DviImpl::WidthShrink(shrinkFactor, pxl);
 }
 
 inline int DviPageImpl::PixelShrink(int shrinkFactor, int pxl)
@@ -1,6 +1,6 @@
 /* internal.h: internal DVI definitions                 -*- C++ -*-
 
-   Copyright (C) 1996-2022 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -20,8 +20,15 @@
    USA.  */
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
 #include <mutex>
+#include <set>
 #include <stack>
+#include <thread>
+#include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -29,7 +36,9 @@
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/Debug>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Quoter>
+#include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/TemporaryFile>
 #include <miktex/Core/Utils>
 #include <miktex/DVI/Dvi>
@@ -250,6 +259,7 @@ typedef unordered_map<string, unique_ptr<TemporaryFile> > TempFileCollection;
 
 typedef unordered_map<int, vector<shared_ptr<GraphicsInclusion> > > MAPNUMTOGRINCVEC;
 
+#include "BitmapCache.h"
 #include "Dib.h"
 #include "DviChar.h"
 #include "DviFont.h"
@@ -382,6 +392,14 @@ public:
   }
 };
 
+// a DVI bitmap whose pixels are yet to be drawn
+struct PendingDviBitmap
+{
+  DviBitmap bitmap;
+  size_t rasterSize;
+  vector<DviItem*> items;
+};
+
 class InputStream
 {
 public:
@@ -692,6 +710,15 @@ public:
 public:
   void FreeContents(bool keepSpecials = false, bool keepItems = false);
 
+public:
+  void FreeShrinkedRaster(int shrinkFactor);
+
+public:
+  bool IsNearCurrentPage();
+
+public:
+  bool IsSelfContained();
+
 public:
   bool IsFrozen()
   {
@@ -704,6 +731,17 @@ public:
     return nLocks > 0;
   }
 
+public:
+  bool TryLock();
+
+public:
+  bool HaveShrinkedRaster(int shrinkFactor)
+  {
+    MIKTEX_ASSERT(IsLocked());
+    MAPNUMTOBOOL::const_iterator it = haveShrinkedRaster.find(shrinkFactor);
+    return it != haveShrinkedRaster.end() && it->second;
+  }
+
 public:
   size_t GetSize()
   {
@@ -763,14 +801,23 @@ private:
 private:
   void MakeShrinkedRaster(int shrinkFactor);
 
+private:
+  size_t GetShrinkedRasterSize(int shrinkFactor);
+
 private:
   void MakeDviBitmaps(int shrinkFactor);
 
 private:
-  void ProcessBand(int shrinkFactor, vector<DviItem*>& vecDviItemPtr);
+  void ProcessBand(int shrinkFactor, vector<DviItem*>& vecDviItemPtr, vector<PendingDviBitmap>& pendingBitmaps);
 
 private:
-  void MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator ititemptrBegin, vector<DviItem*>::iterator ititemptrEnd);
+  void AddDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator ititemptrBegin, vector<DviItem*>::iterator ititemptrEnd, vector<PendingDviBitmap>& pendingBitmaps);
+
+private:
+  void MakeDviBitmap(int shrinkFactor, PendingDviBitmap& pendingBitmap);
+
+private:
+  void FreeDviBitmaps(int shrinkFactor);
 
 private:
   void CheckRules();
@@ -788,10 +835,7 @@ private:
   unique_ptr<Process> StartDvips();
 
 private:
-  void DvipsTranscriptReader();
-
-private:
-  void GhostscriptTranscriptReader();
+  void TranscriptReader();
 
 public:
   size_t MIKTEXTHISCALL Read(void* data, size_t size) override;
@@ -817,6 +861,9 @@ private:
 private:
   void DoPostScriptSpecials(int shrinkFactor);
 
+private:
+  void RenderPostScriptSpecials(Ghostscript& gs, int shrinkFactor);
+
 private:
   void DoGraphicsSpecials(int shrinkFactor);
 
@@ -844,6 +891,10 @@ private:
 private:
   int pageIdx;
 
+  // digest of the page contents within the DVI file
+private:
+  MD5 digest;
+
   // item vector
 private:
   vector<DviItem> dviItems;
@@ -877,6 +928,10 @@ private:
 private:
   MAPNUMTOBITMAPVEC shrinkedDviBitmaps;
 
+  // pixel storage of the DVI bitmaps (one block per shrink factor)
+private:
+  unordered_map<int, void*> shrinkedDviBitmapArenas;
+
 private:
   MAPNUMTODIBCHUNKVEC shrinkedDibChunks;
 
@@ -904,6 +959,10 @@ private:
 private:
   atomic_long nLocks = 0;
 
+  // the thread which has locked the page
+private:
+  atomic<thread::id> lockOwner{ thread::id() };
+
 private:
   DviPageMode pageMode;
 
@@ -1020,19 +1079,19 @@ public:
   void Progress(DviNotification nf, const std::string& msg);
 
 public:
-  int PixelShrink(int shrinkFactor, int pxl)
+  static int PixelShrink(int shrinkFactor, int pxl)
   {
     return pxl / shrinkFactor;
   }
 
 public:
-  int WidthShrink(int shrinkFactor, int pxl)
+  static int WidthShrink(int shrinkFactor, int pxl)
   {
     return PixelShrink(shrinkFactor, pxl + shrinkFactor - 1);
   }
 
 public:
-  int GetBitsPerPixel(int shrinkFactor)
+  static int GetBitsPerPixel(int shrinkFactor)
   {
     return shrinkFactor == 1 ? 1 : 4;
   }
@@ -1107,12 +1166,14 @@ public:
 public:
   void RememberTempFile(const string& key, const PathName& path)
   {
+    lock_guard<mutex> lockGuard(tempFilesMutex);
     tempFiles[key] = TemporaryFile::Create(path);
   }
 
 public:
   bool TryGetTempFile(const string& key, PathName& path)
   {
+    lock_guard<mutex> lockGuard(tempFilesMutex);
     TempFileCollection::const_iterator it = tempFiles.find(key);
     if (it != tempFiles.end())
     {
@@ -1170,6 +1231,12 @@ private:
 private:
   void FreeContents(bool keepFonts = false);
 
+private:
+  void ComputePageDigests(InputStream& inputStream, int postamblePosition);
+
+private:
+  void ReusePages(vector<DviPageImpl*>& previousPages);
+
 private:
   void PushState();
 
@@ -1182,6 +1249,9 @@ private:
 private:
   bool MakeFonts(const FontMap& mapnumtofontptr, int recursion);
 
+private:
+  void StartMakeFonts(const FontMap& fontMap, int recursion);
+
 private:
   double GetConv()
   {
@@ -1195,28 +1265,71 @@ private:
   float PatternToShadeLevel(const char* textureSpec);
 
 private:
-  void GarbageCollector();
+  void PageLoader();
 
 private:
-  void PageLoader();
+  int NextPageToBeLoaded();
+
+public:
+  bool IsNearCurrentPage(int pageIdx);
+
+public:
+  BitmapCache* GetBitmapCache()
+  {
+    return bitmapCache.get();
+  }
+
+private:
+  unique_ptr<BitmapCache> bitmapCache;
+
+public:
+  unique_ptr<Ghostscript> AcquireGhostscript(int shrinkFactor);
+
+public:
+  void ReleaseGhostscript(int shrinkFactor, unique_ptr<Ghostscript> ghostscript);
+
+private:
+  mutex ghostscriptMutex;
+
+  // idle Ghostscript sessions, keyed by shrink factor
+private:
+  multimap<int, unique_ptr<Ghostscript>> ghostscripts;
 
 private:
   shared_ptr<Session> session = MIKTEX_SESSION();
 
+  // set when the background threads have to quit
+private:
+  atomic_bool byeBye{ false };
+
+  // guards the page loader state below
+private:
+  mutex pageLoaderMutex;
+
+private:
+  condition_variable pageLoaderCondition;
+
+  // incremented whenever another page is requested
+private:
+  int pageLoaderGeneration = 0;
+
+  // indicates whether the DVI file has been scanned
 private:
-  HANDLE hByeByeEvent;
+  bool scanned = false;
 
+  // pages which are being loaded by page loader threads
 private:
-  HANDLE hNewPageEvent;
+  set<int> pagesBeingLoaded;
 
+  // indicates whether a page loader skipped a page because it was locked
 private:
-  HANDLE hScannedEvent;
+  bool skippedLockedPage = false;
 
 private:
-  int currentPageIdx = -1;
+  atomic_int currentPageIdx{ -1 };
 
 private:
-  int direction = 1;
+  atomic_int direction{ 1 };
 
 private:
   DviPageMode pageMode;
@@ -1237,10 +1350,13 @@ private:
   bool landscape;
 
 private:
-  thread garbageCollectorThread;
+  vector<thread> pageLoaderThreads;
 
-private:
-  thread pageLoaderThread;
+public:
+  bool IsPageLoaderThread();
+
+public:
+  void OnPageUnlocked();
 
   // resolution in dots per inch
 private:
@@ -1306,6 +1422,10 @@ private:
 private:
   DviInfo dviInfo;
 
+  // conversion factors and postamble font definitions of the last scan
+private:
+  string scanSignature;
+
 private:
   PathName dviFileName;
 
@@ -1410,6 +1530,9 @@ private:
 
 private:
   TempFileCollection tempFiles;
+
+private:
+  mutex tempFilesMutex;
 };
 
 class MIKTEXNOVTABLE SpecialRoot
@@ -27,6 +27,14 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -47,11 +55,18 @@ using namespace MiKTeX::Util;
 
 struct mspack_file* CabExtractor::Open(struct mspack_system* self, const char* fileName, int mode)
 {
-  UNUSED_ALWAYS(self);
   try
   {
     MyFile* myFile = new MyFile;
     myFile->fileName = fileName;
+    MySystem* mySystem = static_cast<MySystem*>(self);
+    if (mode == MSPACK_SYS_OPEN_WRITE && mySystem->sink != nullptr)
+    {
+      // the file is written by the writer pool
+      mySystem->sink->clear();
+      myFile->memory = mySystem->sink;
+      return reinterpret_cast<mspack_file*>(myFile);
+    }
     FileMode fileMode(FileMode::Open);
     FileAccess fileAccess(FileAccess::Read);
     switch (mode)
@@ -98,7 +113,10 @@ void CabExtractor::Close(struct mspack_file* mspackFile)
   MyFile* myFile = reinterpret_cast<MyFile*>(mspackFile);
   try
   {
-    fclose(myFile->stdioFile);
+    if (myFile->stdioFile != nullptr)
+    {
+      fclose(myFile->stdioFile);
+    }
     delete myFile;
   }
   catch (const exception&)
@@ -133,6 +151,11 @@ int CabExtractor::Write(struct mspack_file* mspackFile, void* data, int numBytes
   MyFile* myFile = reinterpret_cast<MyFile*>(mspackFile);
   try
   {
+    if (myFile->memory != nullptr)
+    {
+      myFile->memory->insert(myFile->memory->end(), static_cast<char*>(data), static_cast<char*>(data) + numBytes);
+      return numBytes;
+    }
     size_t n = fwrite(data, 1, numBytes, myFile->stdioFile);
     if (ferror(myFile->stdioFile) != 0)
     {
@@ -278,7 +301,8 @@ CabExtractor::~CabExtractor()
   }
 }
 
-static void SetAttributes(const PathName& path, int cabattr)
+// 0: the default attributes
+static unsigned long GetNativeAttributes(int cabattr)
 {
   unsigned long nativeAttributes;
 #if defined(MIKTEX_WINDOWS)
@@ -299,10 +323,6 @@ static void SetAttributes(const PathName& path, int cabattr)
   {
     nativeAttributes |= FILE_ATTRIBUTE_ARCHIVE;
   }
-  if (nativeAttributes == 0)
-  {
-    return;
-  }
 #else
   const unsigned long NORMAL =
     (0
@@ -320,10 +340,10 @@ static void SetAttributes(const PathName& path, int cabattr)
   }
   if (nativeAttributes == NORMAL)
   {
-    return;
+    nativeAttributes = 0;
   }
 #endif
-  File::SetNativeAttributes(path, nativeAttributes);
+  return nativeAttributes;
 }
 
 void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir, bool makeDirectories, IExtractCallback* callback, const string& prefix)
@@ -333,6 +353,12 @@ void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir,
 
   mscabd_cabinet* cabinet = nullptr;
 
+  vector<Member> members;
+  vector<vector<size_t>> folders;
+
+  // decompression on the folder workers, file output on the writer threads
+  FileWriterPool writerPool(callback);
+
   try
   {
     cabinet = decompressor->open(decompressor, const_cast<char *>(cabinetPath.GetData()));
@@ -344,7 +370,7 @@ void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir,
 
     size_t prefixLen = prefix.length();
 
-    unsigned fileCount = 0;
+    map<mscabd_folder*, size_t> folderIndex;
 
     for (mscabd_file* cabFile = cabinet->files; cabFile != nullptr; cabFile = cabFile->next)
     {
@@ -369,70 +395,178 @@ void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir,
       }
       path /= dest.ToString();
 
-      // notify the client
-      if (callback != nullptr)
+      // create the destination directory
+      writerPool.CreateDirectoryFor(path);
+
+      // the files of a folder form one compressed stream
+      auto it = folderIndex.find(cabFile->folder);
+      if (it == folderIndex.end())
       {
-        callback->OnBeginFileExtraction(path.ToString(), cabFile->length);
+        it = folderIndex.insert(make_pair(cabFile->folder, folders.size())).first;
+        folders.push_back({});
       }
+      folders[it->second].push_back(members.size());
+      members.push_back(Member{ path, cabFile->length });
+    }
 
-      // create the destination directory
-      Directory::Create(PathName(path).RemoveFileSpec());
+    decompressor->close(decompressor, cabinet);
+    cabinet = nullptr;
+  }
+  catch (const exception&)
+  {
+    if (cabinet != nullptr)
+    {
+      decompressor->close(decompressor, cabinet);
+    }
+    throw;
+  }
+
+  ExtractFolders(cabinetPath, members, folders, writerPool);
+
+  writerPool.Finish();
+
+  traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s) ({1} unchanged) from {2} folder(s)"), writerPool.GetFileCount(), writerPool.GetUnchangedFileCount(), folders.size()));
+}
+
+void CabExtractor::ExtractFolders(const PathName& cabinetPath, const vector<Member>& members, const vector<vector<size_t>>& folders, FileWriterPool& writerPool)
+{
+  if (folders.empty())
+  {
+    return;
+  }
 
-      // remove the existing file
-      if (File::Exists(path))
+  // the folders are independent: each worker decompresses whole folders
+  // with its own decompressor
+  size_t workerCount = std::max<size_t>(1, std::min<size_t>(folders.size(), thread::hardware_concurrency()));
+
+  atomic<size_t> nextFolder(0);
+  atomic<bool> stop(false);
+
+  auto work = [&]()
+  {
+    vector<char> data;
+    MySystem workerSystem = mspackSystem;
+    workerSystem.sink = &data;
+    mscab_decompressor* workerDecompressor = nullptr;
+    mscabd_cabinet* cabinet = nullptr;
+    try
+    {
+      workerDecompressor = mspack_create_cab_decompressor(&workerSystem);
+      if (workerDecompressor == nullptr)
       {
-        File::Delete(path, { FileDeleteOption::TryHard });
+        MIKTEX_UNEXPECTED();
       }
-
-      // extract the file
-      int r = decompressor->extract(decompressor, cabFile, path.GetData());
-      if (r != MSPACK_ERR_OK)
+      cabinet = workerDecompressor->open(workerDecompressor, const_cast<char*>(cabinetPath.GetData()));
+      if (cabinet == nullptr)
       {
-         MIKTEX_FATAL_ERROR_2(T_("The member could not bex extracted from the cabinet file."), "cabinetPath", cabinetPath.ToString(), "member", cabFile->filename, "ret", std::to_string(r));
+        MIKTEX_FATAL_ERROR_2(T_("The cabinet file could not be opened."), "path", cabinetPath.ToString());
       }
-
-      fileCount += 1;
-
-      // set time when the file was created
-      struct tm tm;
-      tm.tm_sec = cabFile->time_s;
-      tm.tm_min = cabFile->time_m;
-      tm.tm_hour = cabFile->time_h;
-      tm.tm_mday = cabFile->date_d;
-      tm.tm_mon = cabFile->date_m - 1;
-      tm.tm_year = cabFile->date_y - 1900;
-      tm.tm_isdst = 0;
-      time_t time = mktime(&tm);
-      if (time == static_cast<time_t>(-1))
+      vector<mscabd_file*> cabFiles;
+      for (mscabd_file* cabFile = cabinet->files; cabFile != nullptr; cabFile = cabFile->next)
       {
-        MIKTEX_FATAL_CRT_ERROR("mktime");
+        cabFiles.push_back(cabFile);
       }
-      File::SetTimes(path, time, time, time);
-
-      // set file attributes
-      SetAttributes(path, cabFile->attribs);
-
-      // notify the client
-      if (callback != nullptr)
+      if (cabFiles.size() != members.size())
       {
-        callback->OnEndFileExtraction("", cabFile->length);
+        MIKTEX_UNEXPECTED();
       }
+      for (size_t folder = nextFolder++; folder < folders.size() && !stop; folder = nextFolder++)
+      {
+        for (size_t idx : folders[folder])
+        {
+          if (stop)
+          {
+            break;
+          }
+          mscabd_file* cabFile = cabFiles[idx];
+          const PathName& path = members[idx].path;
+
+          // extract the file into memory
+          data.reserve(members[idx].length);
+          int r = workerDecompressor->extract(workerDecompressor, cabFile, path.GetData());
+          if (r != MSPACK_ERR_OK)
+          {
+            MIKTEX_FATAL_ERROR_2(T_("The member could not bex extracted from the cabinet file."), "cabinetPath", cabinetPath.ToString(), "member", cabFile->filename, "ret", std::to_string(r));
+          }
+
+          FileWriterPool::Job job;
+          job.path = path;
+          job.data = std::move(data);
+          data = vector<char>();
+
+          // set time when the file was created
+          struct tm tm;
+          tm.tm_sec = cabFile->time_s;
+          tm.tm_min = cabFile->time_m;
+          tm.tm_hour = cabFile->time_h;
+          tm.tm_mday = cabFile->date_d;
+          tm.tm_mon = cabFile->date_m - 1;
+          tm.tm_year = cabFile->date_y - 1900;
+          tm.tm_isdst = 0;
+          job.time = mktime(&tm);
+          if (job.time == static_cast<time_t>(-1))
+          {
+            MIKTEX_FATAL_CRT_ERROR("mktime");
+          }
+
+          // set file attributes
+          job.nativeAttributes = GetNativeAttributes(cabFile->attribs);
+
+          writerPool.Write(std::move(job));
+        }
+      }
+    }
+    catch (const exception&)
+    {
+      writerPool.SetError(current_exception());
+      stop = true;
+    }
+    if (cabinet != nullptr)
+    {
+      workerDecompressor->close(workerDecompressor, cabinet);
+    }
+    if (workerDecompressor != nullptr)
+    {
+      mspack_destroy_cab_decompressor(workerDecompressor);
     }
+  };
 
-    traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s)"), fileCount));
+  vector<thread> workers;
+  for (size_t n = 0; n < workerCount; ++n)
+  {
+    workers.push_back(thread(work));
+  }
 
-    decompressor->close(decompressor, cabinet);
-    cabinet = nullptr;
+  auto joinWorkers = [&]()
+  {
+    stop = true;
+    for (thread& t : workers)
+    {
+      if (t.joinable())
+      {
+        t.join();
+      }
+    }
+  };
 
-  }
-  catch (const exception&)
+  // the client is notified on this thread; every member is either written or
+  // the pool has an error
+  try
   {
-    if (cabinet != nullptr)
+    for (size_t reported = 0; reported < members.size(); )
     {
-      decompressor->close(decompressor, cabinet);
+      reported += writerPool.Report(true);
     }
+  }
+  catch (const exception&)
+  {
+    // wake up workers waiting for the writer pool
+    writerPool.SetError(current_exception());
+    joinWorkers();
     throw;
   }
+
+  joinWorkers();
 }
 
 void CabExtractor::Extract(Stream* stream, const PathName& destDir, bool makeDirectories, IExtractCallback* callback, const string& prefix)
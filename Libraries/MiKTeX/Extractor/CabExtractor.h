@@ -24,11 +24,19 @@
 #if !defined(AE5923232DF04F7888B2DD7F583253A4)
 #define AE5923232DF04F7888B2DD7F583253A4
 
+#include <cstddef>
+
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <mspack.h>
 
 #include <miktex/Extractor/Extractor>
 #include <miktex/Trace/TraceStream>
 
+#include "FileWriterPool.h"
+
 BEGIN_INTERNAL_NAMESPACE;
 
 class CabExtractor :
@@ -46,6 +54,16 @@ public:
 public:
   void MIKTEXTHISCALL Extract(MiKTeX::Core::Stream* stream, const MiKTeX::Util::PathName& destDir, bool makeDirectories, IExtractCallback* callback, const std::string& str) override;
 
+private:
+  struct Member
+  {
+    MiKTeX::Util::PathName path;
+    std::size_t length;
+  };
+
+private:
+  void ExtractFolders(const MiKTeX::Util::PathName& cabinetPath, const std::vector<Member>& members, const std::vector<std::vector<std::size_t>>& folders, FileWriterPool& writerPool);
+
 private:
   mscab_decompressor* decompressor = nullptr;
 
@@ -82,7 +100,8 @@ private:
 private:
   struct MySystem : public mspack_system
   {
-    CabExtractor* pCabExtractor = nullptr;
+    // receives the extracted file, if not null
+    std::vector<char>* sink = nullptr;
   };
 
 private:
@@ -90,10 +109,11 @@ private:
   {
     std::string fileName;
     FILE* stdioFile = nullptr;
+    std::vector<char>* memory = nullptr;
   };
 
 private:
-  mspack_system mspackSystem;
+  MySystem mspackSystem;
 
 private:
   std::unique_ptr<MiKTeX::Trace::TraceStream> traceStream;
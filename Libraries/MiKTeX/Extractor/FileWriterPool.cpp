@@ -0,0 +1,310 @@
+/**
+ * @file FileWriterPool.cpp
+ * @author Christian Schenk
+ * @brief Writing extracted files on a pool of threads
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Extractor.
+ *
+ * MiKTeX Extractor is licensed under GNU General Public License version 2 or
+ * any later version.
+ */
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+
+#include "internal.h"
+
+#include "FileWriterPool.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Extractor;
+using namespace MiKTeX::Util;
+
+// small files dominate: more writers than cores hide the file system latency
+constexpr size_t MAX_WRITER_THREADS = 8;
+
+// the decompressor is stalled, if the writers are behind by this many bytes
+constexpr size_t MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+FileWriterPool::FileWriterPool(IExtractCallback* callback) :
+  callback(callback)
+{
+  size_t threadCount = std::max<size_t>(1, std::min<size_t>(thread::hardware_concurrency(), MAX_WRITER_THREADS));
+  for (size_t n = 0; n < threadCount; ++n)
+  {
+    threads.push_back(thread(&FileWriterPool::WriterThread, this));
+  }
+}
+
+FileWriterPool::~FileWriterPool()
+{
+  try
+  {
+    Stop();
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+void FileWriterPool::Stop()
+{
+  {
+    lock_guard<mutex> lock(mux);
+    stop = true;
+  }
+  jobAvailable.notify_all();
+  spaceAvailable.notify_all();
+  for (thread& t : threads)
+  {
+    if (t.joinable())
+    {
+      t.join();
+    }
+  }
+  threads.clear();
+}
+
+void FileWriterPool::CreateDirectoryFor(const PathName& path)
+{
+  PathName directory = PathName(path).RemoveFileSpec();
+  lock_guard<mutex> lock(directoriesMutex);
+  if (directories.insert(directory.ToString()).second)
+  {
+    Directory::Create(directory);
+  }
+}
+
+void FileWriterPool::Write(Job&& job)
+{
+  CreateDirectoryFor(job.path);
+  size_t size = job.data.size();
+  {
+    unique_lock<mutex> lock(mux);
+    // a file larger than the limit is queued alone
+    spaceAvailable.wait(lock, [&]() { return error != nullptr || stop || queuedBytes == 0 || queuedBytes + size <= MAX_QUEUED_BYTES; });
+    if (error != nullptr)
+    {
+      rethrow_exception(error);
+    }
+    if (stop)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    queuedBytes += size;
+    pending += 1;
+    jobs.push_back(std::move(job));
+  }
+  jobAvailable.notify_one();
+}
+
+size_t FileWriterPool::Report(bool wait)
+{
+  deque<pair<string, size_t>> written;
+  exception_ptr firstError;
+  {
+    unique_lock<mutex> lock(mux);
+    if (wait)
+    {
+      jobDone.wait(lock, [&]() { return !done.empty() || error != nullptr; });
+    }
+    written.swap(done);
+    firstError = error;
+  }
+  if (callback != nullptr)
+  {
+    for (const auto& w : written)
+    {
+      callback->OnBeginFileExtraction(w.first, w.second);
+      callback->OnEndFileExtraction("", w.second);
+    }
+  }
+  if (firstError != nullptr)
+  {
+    rethrow_exception(firstError);
+  }
+  return written.size();
+}
+
+void FileWriterPool::SetError(exception_ptr error)
+{
+  {
+    lock_guard<mutex> lock(mux);
+    if (this->error == nullptr)
+    {
+      this->error = error;
+    }
+  }
+  jobDone.notify_all();
+  spaceAvailable.notify_all();
+}
+
+void FileWriterPool::Finish()
+{
+  {
+    unique_lock<mutex> lock(mux);
+    jobDone.wait(lock, [&]() { return pending == 0 || error != nullptr; });
+  }
+  Stop();
+  if (error == nullptr)
+  {
+    for (const Job& job : inUseJobs)
+    {
+      bool unchanged = WriteFile(job, true);
+      fileCount += 1;
+      if (unchanged)
+      {
+        unchangedFileCount += 1;
+      }
+      done.push_back(make_pair(job.path.ToString(), job.data.size()));
+    }
+  }
+  inUseJobs.clear();
+  Report(false);
+}
+
+void FileWriterPool::WriterThread()
+{
+  while (true)
+  {
+    Job job;
+    {
+      unique_lock<mutex> lock(mux);
+      jobAvailable.wait(lock, [&]() { return stop || !jobs.empty(); });
+      if (stop)
+      {
+        return;
+      }
+      job = std::move(jobs.front());
+      jobs.pop_front();
+      queuedBytes -= job.data.size();
+    }
+    spaceAvailable.notify_all();
+    bool unchanged = false;
+    bool inUse = false;
+    exception_ptr writeError;
+    try
+    {
+      unchanged = WriteFile(job, false);
+    }
+    catch (const UnauthorizedAccessException&)
+    {
+      // most likely in use: let Finish() try harder
+      inUse = true;
+    }
+    catch (const exception&)
+    {
+      writeError = current_exception();
+    }
+    {
+      lock_guard<mutex> lock(mux);
+      pending -= 1;
+      if (inUse)
+      {
+        inUseJobs.push_back(std::move(job));
+      }
+      else if (writeError != nullptr)
+      {
+        if (error == nullptr)
+        {
+          error = writeError;
+        }
+      }
+      else
+      {
+        fileCount += 1;
+        if (unchanged)
+        {
+          unchangedFileCount += 1;
+        }
+        done.push_back(make_pair(job.path.ToString(), job.data.size()));
+      }
+    }
+    jobDone.notify_all();
+    if (writeError != nullptr)
+    {
+      spaceAvailable.notify_all();
+    }
+  }
+}
+
+bool FileWriterPool::WriteFile(const Job& job, bool tryHard)
+{
+  size_t size = job.data.size();
+
+  // an existing file of the same size is updated in place: the bytes are
+  // compared and nothing is written as long as they match
+  FileStream stream;
+  bool updateInPlace = false;
+  if (File::Exists(job.path))
+  {
+    if (File::GetSize(job.path) == size)
+    {
+      try
+      {
+        stream.Attach(File::Open(job.path, FileMode::Open, FileAccess::ReadWrite, false));
+        updateInPlace = true;
+      }
+      catch (const MiKTeXException&)
+      {
+      }
+    }
+    if (!updateInPlace)
+    {
+      if (tryHard)
+      {
+        File::Delete(job.path, { FileDeleteOption::TryHard });
+      }
+      else
+      {
+        File::Delete(job.path);
+      }
+    }
+  }
+  if (!updateInPlace)
+  {
+    stream.Attach(File::Open(job.path, FileMode::Create, FileAccess::Write, false));
+  }
+
+  // the contents are written with one call
+  setvbuf(stream.GetFile(), nullptr, _IONBF, 0);
+  bool changed = !updateInPlace;
+  if (!changed && size > 0)
+  {
+    vector<char> existing(size);
+    if (stream.Read(existing.data(), size) != size || memcmp(existing.data(), job.data.data(), size) != 0)
+    {
+      changed = true;
+      stream.Seek(0, SeekOrigin::Begin);
+    }
+  }
+  if (changed && size > 0)
+  {
+    stream.Write(job.data.data(), size);
+  }
+  if (job.time != static_cast<time_t>(-1))
+  {
+    File::SetTimes(stream.GetFile(), job.time, job.time, job.time);
+  }
+  stream.Close();
+
+  if (job.nativeAttributes != 0)
+  {
+    File::SetNativeAttributes(job.path, job.nativeAttributes);
+  }
+
+  return !changed;
+}
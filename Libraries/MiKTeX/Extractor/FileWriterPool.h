@@ -0,0 +1,169 @@
+/**
+ * @file FileWriterPool.h
+ * @author Christian Schenk
+ * @brief Writing extracted files on a pool of threads
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Extractor.
+ *
+ * MiKTeX Extractor is licensed under GNU General Public License version 2 or
+ * any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <miktex/Extractor/Extractor>
+#include <miktex/Util/PathName>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+/// Writes extracted files on a pool of threads.
+///
+/// The extractor decompresses and hands over the contents of each file.
+/// The writer threads create, write and close the files and set the
+/// timestamps. An existing file with the same contents is not rewritten.
+/// Directories are created by the submitting thread, each one only once.
+///
+/// The extraction callback is notified on the thread which calls Report()
+/// or Finish(), after the file has been written.
+///
+/// Files which are in use (Windows) are replaced by the thread which calls
+/// Finish(): moving them out of the way schedules their removal, which is
+/// left to a single thread.
+class FileWriterPool
+{
+public:
+  struct Job
+  {
+    MiKTeX::Util::PathName path;
+    std::vector<char> data;
+    std::time_t time = static_cast<std::time_t>(-1);
+    // 0: keep the default attributes
+    unsigned long nativeAttributes = 0;
+  };
+
+public:
+  FileWriterPool(MiKTeX::Extractor::IExtractCallback* callback);
+
+public:
+  FileWriterPool(const FileWriterPool& other) = delete;
+
+public:
+  FileWriterPool& operator=(const FileWriterPool& other) = delete;
+
+public:
+  ~FileWriterPool();
+
+  /// Creates the directory of a file, unless this was done before.
+  /// Thread-safe.
+public:
+  void CreateDirectoryFor(const MiKTeX::Util::PathName& path);
+
+  /// Queues a file.  Blocks while too much data is queued.  Thread-safe.
+public:
+  void Write(Job&& job);
+
+  /// Notifies the callback about the written files; rethrows the first
+  /// error.
+  /// @param wait Wait for at least one written file or an error.
+  /// @return Returns the number of reported files.
+public:
+  std::size_t Report(bool wait);
+
+  /// Records an error of a submitting thread.  Thread-safe.
+public:
+  void SetError(std::exception_ptr error);
+
+  /// Waits for the queued files, notifies the callback and stops the
+  /// writer threads; rethrows the first error.
+public:
+  void Finish();
+
+public:
+  std::size_t GetFileCount() const
+  {
+    return fileCount;
+  }
+
+public:
+  std::size_t GetUnchangedFileCount() const
+  {
+    return unchangedFileCount;
+  }
+
+private:
+  void WriterThread();
+
+private:
+  static bool WriteFile(const Job& job, bool tryHard);
+
+private:
+  void Stop();
+
+private:
+  MiKTeX::Extractor::IExtractCallback* callback;
+
+private:
+  std::unordered_set<std::string> directories;
+
+private:
+  std::mutex directoriesMutex;
+
+private:
+  std::deque<std::pair<std::string, std::size_t>> done;
+
+private:
+  std::exception_ptr error;
+
+private:
+  std::size_t fileCount = 0;
+
+private:
+  std::condition_variable jobAvailable;
+
+private:
+  std::condition_variable jobDone;
+
+private:
+  std::deque<Job> jobs;
+
+private:
+  std::vector<Job> inUseJobs;
+
+private:
+  std::mutex mux;
+
+private:
+  std::size_t pending = 0;
+
+private:
+  std::size_t queuedBytes = 0;
+
+private:
+  std::condition_variable spaceAvailable;
+
+private:
+  bool stop = false;
+
+private:
+  std::vector<std::thread> threads;
+
+private:
+  std::size_t unchangedFileCount = 0;
+};
+
+END_INTERNAL_NAMESPACE;
@@ -21,6 +21,12 @@
 
 #include "config.h"
 
+#include <cstdio>
+#include <cstring>
+
+#include <memory>
+#include <utility>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -31,6 +37,7 @@
 
 #include "internal.h"
 
+#include "FileWriterPool.h"
 #include "TarExtractor.h"
 
 using namespace std;
@@ -315,12 +322,13 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
     size_t len;
     Header header;
     size_t prefixLen = prefix.length();
-    unsigned fileCount = 0;
 
     bool checkHeader = true;
 
-    CharBuffer<char> buffer;
-    buffer.Reserve(1024 * 1024);
+    const size_t BUFFER_SIZE = 1024 * 1024;
+
+    // decompression on this thread, file output on the writer threads
+    FileWriterPool writerPool(callback);
 
     while ((len = Read(&header, sizeof(header))) > 0)
     {
@@ -391,61 +399,42 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
       }
       path /= dest.ToString();
 
-      // notify the client
-      if (callback != nullptr)
-      {
-        callback->OnBeginFileExtraction(path.ToString(), size);
-      }
-
-      // create the destination directory
-      Directory::Create(PathName(path).RemoveFileSpec());
-
-      // remove the existing file
-      if (File::Exists(path))
-      {
-        File::Delete(path, { FileDeleteOption::TryHard });
-      }
-
-      // extract the file
-      FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
+      // read the file; the writer pool creates it
+      FileWriterPool::Job job;
+      job.path = path;
+      job.data.resize(size);
       size_t bytesRead = 0;
       while (bytesRead < size)
       {
         size_t remaining = size - bytesRead;
-        size_t n = (remaining > buffer.GetCapacity() ? buffer.GetCapacity() : remaining);
-        if (Read(buffer.GetData(), n) != n)
+        size_t n = (remaining > BUFFER_SIZE ? BUFFER_SIZE : remaining);
+        if (Read(job.data.data() + bytesRead, n) != n)
         {
           MIKTEX_UNEXPECTED();
         }
-        streamOut.Write(buffer.GetData(), n);
         bytesRead += n;
       }
-      // set time when the file was created
-      time_t time = header.GetLastModificationTime();
-      File::SetTimes(streamOut.GetFile(), time, time, time);
-      streamOut.Close();
-
-      // skip extra bytes
-      if (bytesRead % sizeof(Header) > 0)
+      size_t paddedSize = ((size + BLOCKSIZE - 1) / BLOCKSIZE) * BLOCKSIZE;
+      if (paddedSize > size)
       {
-        Skip(sizeof(Header) - bytesRead % sizeof(Header));
+        Skip(paddedSize - size);
       }
-
-      fileCount += 1;
+      job.time = header.GetLastModificationTime();
 
 #if 0
       // set file attributes
-      File::SetAttributes(path, todo);
+      job.nativeAttributes = todo;
 #endif
 
+      writerPool.Write(std::move(job));
+
       // notify the client
-      if (callback != nullptr)
-      {
-        callback->OnEndFileExtraction("", size);
-      }
+      writerPool.Report(false);
     }
 
-    traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s)"), fileCount));
+    writerPool.Finish();
+
+    traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s) ({1} unchanged)"), writerPool.GetFileCount(), writerPool.GetUnchangedFileCount()));
   }
   catch (const exception&)
   {
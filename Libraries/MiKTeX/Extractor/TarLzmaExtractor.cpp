@@ -47,3 +47,9 @@ void TarLzmaExtractor::Extract(const PathName& path, const PathName& destDir, bo
   unique_ptr<LzmaStream> lzmaStream = LzmaStream::Create(path, true);
   TarExtractor::Extract(lzmaStream.get(), destDir, makeDirectories, callback, prefix);
 }
+
+void TarLzmaExtractor::Extract(Stream* stream, const PathName& destDir, bool makeDirectories, IExtractCallback* callback, const string& prefix)
+{
+  unique_ptr<LzmaStream> lzmaStream = LzmaStream::Create(stream);
+  TarExtractor::Extract(lzmaStream.get(), destDir, makeDirectories, callback, prefix);
+}
@@ -726,6 +726,9 @@ typedef struct
 #define kpathsea_find_file(kpse, name, format, must_exist) \
     miktex_kpathsea_find_file(kpse, name, format, must_exist)
 
+#define kpathsea_find_file_buffer(kpse, name, format, must_exist, buf, buf_size) \
+    miktex_kpathsea_find_file_buffer(kpse, name, format, must_exist, buf, buf_size)
+
 #define kpathsea_find_file_generic(kpse, name, format, must_exist, all) \
     miktex_kpathsea_find_file_generic(kpse, name, format, must_exist, all)
 
@@ -765,6 +768,9 @@ typedef struct
 #define kpse_find_file(name, format, must_exist) \
     kpathsea_find_file(kpse_def, name, format, must_exist)
 
+#define kpse_find_file_buffer(name, format, must_exist, buf, buf_size) \
+    kpathsea_find_file_buffer(kpse_def, name, format, must_exist, buf, buf_size)
+
 #define kpse_find_ofm(name) kpse_find_file(name, kpse_ofm_format, 1)
 
 #define kpse_find_pict(name) kpse_find_file(name, kpse_pict_format, 1)
@@ -1062,6 +1068,8 @@ MIKTEXKPSCEEAPI(boolean) miktex_kpathsea_dir_p(kpathsea kpse, string fn);
 
 MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist);
 
+MIKTEXKPSCEEAPI(int) miktex_kpathsea_find_file_buffer(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist, char* buf, size_t bufSize);
+
 MIKTEXKPSCEEAPI(char**) miktex_kpathsea_find_file_generic(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, boolean mustExist, boolean all);
 
 MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_glyph(kpathsea kpseInstance, const char* fontName, unsigned dpi, kpse_file_format_type format, kpse_glyph_file_type* glyph_file);
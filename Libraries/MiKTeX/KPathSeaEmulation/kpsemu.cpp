@@ -19,6 +19,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #if defined(MIKTEX_UNIX)
 #include <sys/time.h>
@@ -53,6 +54,12 @@ using namespace MiKTeX;
 namespace {
     unsigned kpse_baseResolution = 600;
     std::string kpse_mode;
+
+    // remembered results of miktex_kpathsea_find_file(); an empty path
+    // stands for "not found"
+    constexpr std::size_t FIND_FILE_MEMO_CAPACITY = 8192;
+    std::unordered_map<std::string, std::string> findFileMemo;
+    std::size_t findFileMemoGeneration = 0;
 }
 
 MIKTEXKPSDATA(const char*) miktex_kpathsea_bug_address = T_("Visit miktex.org for bug reports.");
@@ -234,13 +241,24 @@ MIKTEXSTATICFUNC(FileType) ToFileType(kpse_file_format_type format)
     return ft;
 }
 
-MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist)
+// the returned string is valid until the next lookup
+MIKTEXSTATICFUNC(const string*) FindFileMemoized(const char* fileName, kpse_file_format_type format, int mustExist)
 {
-    MIKTEX_ASSERT(kpseInstance != nullptr);
-    MIKTEX_ASSERT(fileName != nullptr);
-    bool found = false;
-    PathName result;
     shared_ptr<Session> session = MIKTEX_SESSION();
+    size_t generation = session->GetFindFileGeneration();
+    if (generation != findFileMemoGeneration || findFileMemo.size() >= FIND_FILE_MEMO_CAPACITY)
+    {
+        findFileMemo.clear();
+        findFileMemoGeneration = generation;
+    }
+    string key = std::to_string(format) + (mustExist ? "!" : "?") + fileName;
+    auto it = findFileMemo.find(key);
+    // a file which has been written meanwhile must not be hidden
+    if (it != findFileMemo.end() && (!it->second.empty() || !File::Exists(PathName(fileName))))
+    {
+        return it->second.empty() ? nullptr : &it->second;
+    }
+    PathName result;
     FileType ft = ToFileType(format);
     Session::FindFileOptionSet options;
     if (mustExist)
@@ -248,13 +266,37 @@ MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const ch
         options += Session::FindFileOption::Create;
         options += Session::FindFileOption::SearchFileSystem;
     }
-    found = session->FindFile(fileName, ft, options, result);
-    if (!found)
+    if (!session->FindFile(fileName, ft, options, result))
     {
+        findFileMemo[key] = "";
         return nullptr;
     }
     result.ConvertToUnix();
-    return xstrdup(result.GetData());
+    string& memo = findFileMemo[key];
+    memo = result.ToString();
+    return &memo;
+}
+
+MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist)
+{
+    MIKTEX_ASSERT(kpseInstance != nullptr);
+    MIKTEX_ASSERT(fileName != nullptr);
+    const string* result = FindFileMemoized(fileName, format, mustExist);
+    return result == nullptr ? nullptr : xstrdup(result->c_str());
+}
+
+MIKTEXKPSCEEAPI(int) miktex_kpathsea_find_file_buffer(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist, char* buf, size_t bufSize)
+{
+    MIKTEX_ASSERT(kpseInstance != nullptr);
+    MIKTEX_ASSERT(fileName != nullptr);
+    MIKTEX_ASSERT_BUFFER(buf, bufSize);
+    const string* result = FindFileMemoized(fileName, format, mustExist);
+    if (result == nullptr || result->length() >= bufSize)
+    {
+        return 0;
+    }
+    memcpy(buf, result->c_str(), result->length() + 1);
+    return 1;
 }
 
 MIKTEXKPSCEEAPI(char**) miktex_kpathsea_find_file_generic(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, boolean mustExist, boolean all)
@@ -27,18 +27,17 @@
 #include <CoreFoundation/CoreFoundation.h>
 #endif
 
+#include <cstdint>
+#include <cstring>
 #include <fstream>
-#include <locale>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #if !defined(MIKTEX_LOC_STATIC)
-#define WITH_BOOST_LOCALE
-#endif
-
-#if defined(WITH_BOOST_LOCALE)
-#include <boost/locale.hpp>
+#define WITH_MESSAGE_CATALOGS
 #endif
 
 #include <miktex/Configuration/ConfigNames>
@@ -93,8 +92,13 @@ public:
   once_flag initFlag;
 public:
   ResourceRepository* resources = nullptr;
+  // the compiled message catalog (.mo file), if it is not a resource
 public:
-  std::locale uiLocale;
+  vector<char> catalogData;
+  // msgid => msgstr; points into the catalog data; empty, if messages are
+  // not translated
+public:
+  unordered_map<string_view, string_view> messages;
 };
 
 Translator::Translator(const string& domain, ResourceRepository* resources, shared_ptr<ConfigurationProvider> config) :
@@ -110,77 +114,176 @@ Translator::~Translator()
   delete pimpl;
 }
 
-static vector<char> LoadFile(ResourceRepository* resources, string const& fileName, string const& encoding)
+// resources are not copied: they stay in memory
+static bool LoadCatalog(ResourceRepository* resources, const string& fileName, vector<char>& buffer, const char*& data, size_t& size)
 {
-  if (encoding != "UTF-8" && encoding != "utf-8")
-  {
-    return vector<char>();
-  }
-  if (fileName.empty())
-  {
-    return vector<char>();
-  }
   if (fileName[0] == ':')
   {
     if (resources == nullptr)
     {
-      return vector<char>();
+      return false;
     }
     const Resource& resource = resources->GetResource(fileName.c_str());
     if (resource.data == nullptr)
     {
-      return vector<char>();
+      return false;
     }
-    const char* data = static_cast<const char*>(resource.data);
-    return vector<char>(data, data + resource.len);
+    data = static_cast<const char*>(resource.data);
+    size = resource.len;
+    return true;
   }
   ifstream file(fileName, ios::binary | ios::ate);
-  if (file)
+  if (!file)
+  {
+    return false;
+  }
+  streamsize fileSize = file.tellg();
+  buffer.resize(fileSize);
+  file.seekg(0, std::ios::beg);
+  file.read(buffer.data(), fileSize);
+  data = buffer.data();
+  size = buffer.size();
+  return true;
+}
+
+// see "The Format of GNU MO Files" in the GNU gettext manual
+static bool ParseCatalog(const char* data, size_t size, unordered_map<string_view, string_view>& messages)
+{
+  constexpr uint32_t MO_MAGIC = 0x950412de;
+  constexpr uint32_t MO_MAGIC_SWAPPED = 0xde120495;
+  if (size < 20)
+  {
+    return false;
+  }
+  auto get = [data](size_t offset) {
+    uint32_t n;
+    memcpy(&n, data + offset, sizeof(n));
+    return n;
+  };
+  bool swapped;
+  if (get(0) == MO_MAGIC)
+  {
+    swapped = false;
+  }
+  else if (get(0) == MO_MAGIC_SWAPPED)
+  {
+    swapped = true;
+  }
+  else
+  {
+    return false;
+  }
+  auto getWord = [get, swapped](size_t offset) {
+    uint32_t n = get(offset);
+    return swapped ? ((n >> 24) | ((n >> 8) & 0xff00) | ((n << 8) & 0xff0000) | (n << 24)) : n;
+  };
+  uint32_t numStrings = getWord(8);
+  uint32_t originalTable = getWord(12);
+  uint32_t translationTable = getWord(16);
+  if (originalTable > size || translationTable > size || numStrings > (size - originalTable) / 8 || numStrings > (size - translationTable) / 8)
+  {
+    return false;
+  }
+  auto getString = [data, size, getWord](size_t tableOffset, uint32_t idx, string_view& str) {
+    uint32_t length = getWord(tableOffset + 8 * idx);
+    uint32_t offset = getWord(tableOffset + 8 * idx + 4);
+    if (offset > size || length >= size - offset)
+    {
+      return false;
+    }
+    // plural forms are separated by NUL: use the singular form
+    str = string_view(data + offset, strnlen(data + offset, length));
+    return true;
+  };
+  messages.reserve(numStrings);
+  for (uint32_t idx = 0; idx < numStrings; ++idx)
   {
-    streamsize size = file.tellg();
-    vector<char> buffer(size);
-    file.seekg(0, std::ios::beg);
-    file.read(buffer.data(), size);
-    return buffer;
+    string_view msgId;
+    string_view msgStr;
+    if (!getString(originalTable, idx, msgId) || !getString(translationTable, idx, msgStr))
+    {
+      messages.clear();
+      return false;
+    }
+    // skip the header entry and untranslated messages
+    if (!msgId.empty() && !msgStr.empty())
+    {
+      messages[msgId] = msgStr;
+    }
   }
-  return vector<char>();
+  return true;
 }
 
 void Translator::Init()
 {
-#if defined(WITH_BOOST_LOCALE)
-  boost::locale::gnu_gettext::messages_info messagesInfo;
+#if defined(WITH_MESSAGE_CATALOGS)
+  auto uiLanguages = GetSystemUILanguages();
+  if (uiLanguages.empty())
+  {
+    return;
+  }
+  string language, country, encoding, variant;
+  try
+  {
+    std::tie(language, country, encoding, variant) = ParseLocaleIdentifier(uiLanguages[0]);
+  }
+  catch (const exception&)
+  {
+    return;
+  }
+  // message ids are English
+  if (language.empty() || language == "en" || language == "c" || language == "posix")
+  {
+    return;
+  }
+  vector<string> localeNames;
+  if (!country.empty())
+  {
+    if (!variant.empty())
+    {
+      localeNames.push_back(language + "_" + country + "@" + variant);
+    }
+    localeNames.push_back(language + "_" + country);
+  }
+  if (!variant.empty())
+  {
+    localeNames.push_back(language + "@" + variant);
+  }
+  localeNames.push_back(language);
+  vector<string> paths;
   string localeDir;
-  if (pimpl->config->TryGetConfigValue("Translator", "BaseDir", localeDir))
+  if (pimpl->config != nullptr && pimpl->config->TryGetConfigValue("Translator", "BaseDir", localeDir))
   {
-    messagesInfo.paths.push_back(localeDir);
+    paths.push_back(localeDir);
   }
-  messagesInfo.paths.push_back(":");
-  messagesInfo.domains.push_back(boost::locale::gnu_gettext::messages_info::domain(pimpl->domain));
-  std::function<vector<char>(const string&, const string&)> callback = [this](const string& fileName, const string& encoding) { return LoadFile(pimpl->resources, fileName, encoding); };
-  messagesInfo.callback = callback;
-  boost::locale::generator gen;
-  string localeIdentifier;
-  auto uiLanguages = GetSystemUILanguages();
-  if (!uiLanguages.empty())
+  paths.push_back(":");
+  for (const string& path : paths)
   {
-    localeIdentifier = uiLanguages[0] + ".UTF-8";
+    for (const string& localeName : localeNames)
+    {
+      string fileName = path + "/" + localeName + "/LC_MESSAGES/" + pimpl->domain + ".mo";
+      const char* data;
+      size_t size;
+      if (LoadCatalog(pimpl->resources, fileName, pimpl->catalogData, data, size) && ParseCatalog(data, size, pimpl->messages))
+      {
+        return;
+      }
+    }
   }
-  std::locale baseLocale = gen(localeIdentifier);
-  boost::locale::info const& properties = std::use_facet<boost::locale::info>(baseLocale);
-  messagesInfo.country = properties.country();
-  messagesInfo.encoding = properties.encoding();
-  messagesInfo.language = properties.language();
-  messagesInfo.variant = properties.variant();
-  pimpl->uiLocale = std::locale(baseLocale, boost::locale::gnu_gettext::create_messages_facet<char>(messagesInfo));
 #endif
 }
 
 std::string Translator::Translate(const char* msgId)
 {
-#if defined(WITH_BOOST_LOCALE)
+#if defined(WITH_MESSAGE_CATALOGS)
+  // the catalog is not modified after it has been loaded: no lock is needed
   std::call_once(pimpl->initFlag, [this]() { Init(); });
-  return boost::locale::gettext(msgId, pimpl->uiLocale);
+  if (pimpl->messages.empty())
+  {
+    return msgId;
+  }
+  auto it = pimpl->messages.find(string_view(msgId));
+  return it == pimpl->messages.end() ? string(msgId) : string(it->second);
 #else
   return msgId;
 #endif
@@ -1,6 +1,6 @@
 /* CurlWebFile.cpp:
 
-   Copyright (C) 2001-2020 Christian Schenk
+   Copyright (C) 2001-2024 Christian Schenk
 
    This file is part of MiKTeX Package Manager.
 
@@ -23,23 +23,30 @@
 
 #if defined(HAVE_LIBCURL)
 
+#include <cstdlib>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Util/StringUtil>
+
 #include "CurlWebFile.h"
 #include "CurlWebSession.h"
 
 using namespace std;
 
 using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
 const int READ_TIMEOUT_SECONDS = 40;
 
-CurlWebFile::CurlWebFile(shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData) :
+CurlWebFile::CurlWebFile(shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData, size_t offset, const WebFileValidators& validators) :
+  offset(offset),
   webSession(webSession),
   url(url),
+  requestValidators(validators),
   trace_mpm(TraceStream::Open(MIKTEX_TRACE_MPM))
 {
   try
@@ -61,6 +68,11 @@ CurlWebFile::CurlWebFile(shared_ptr<CurlWebSession> webSession, const std::strin
     {
       curl_multi_remove_handle(webSession->GetMultiHandle(), webSession->GetEasyHandle());
     }
+    if (requestHeaders != nullptr)
+    {
+      curl_easy_setopt(webSession->GetEasyHandle(), CURLOPT_HTTPHEADER, webSession->GetCustomHeaders());
+      curl_slist_free_all(requestHeaders);
+    }
     throw;
   }
 }
@@ -87,6 +99,28 @@ void CurlWebFile::Initialize()
   {
     webSession->SetOption(CURLOPT_HTTPGET, 1);
   }
+  // the easy handle is reused: always set the start position
+  webSession->SetOption(CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(offset));
+  // ... and the request headers
+  if (!requestValidators.Empty())
+  {
+    for (curl_slist* header = webSession->GetCustomHeaders(); header != nullptr; header = header->next)
+    {
+      requestHeaders = curl_slist_append(requestHeaders, header->data);
+    }
+    if (!requestValidators.eTag.empty())
+    {
+      requestHeaders = curl_slist_append(requestHeaders, ("If-None-Match: " + requestValidators.eTag).c_str());
+    }
+    if (!requestValidators.lastModified.empty())
+    {
+      requestHeaders = curl_slist_append(requestHeaders, ("If-Modified-Since: " + requestValidators.lastModified).c_str());
+    }
+  }
+  webSession->SetOption(CURLOPT_HTTPHEADER, requestHeaders != nullptr ? requestHeaders : webSession->GetCustomHeaders());
+  webSession->SetOption(CURLOPT_HEADERDATA, reinterpret_cast<void*>(this));
+  curl_write_callback headerCallback = HeaderCallback;
+  webSession->SetOption(CURLOPT_HEADERFUNCTION, headerCallback);
   webSession->SetOption(CURLOPT_WRITEDATA, reinterpret_cast<void*>(this));
   curl_write_callback writeCallback = WriteCallback;
   webSession->SetOption(CURLOPT_WRITEFUNCTION, writeCallback);
@@ -98,20 +132,98 @@ void CurlWebFile::Initialize()
   initialized = true;
 }
 
+void CurlWebFile::WriteToBuffer(const char* data, size_t size)
+{
+  if (!buffer.CanWrite(size))
+  {
+    size_t newCapacity = buffer.GetCapacity() + 2 * size;
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Debug, fmt::format(T_("reserve buffer: {0}"), (unsigned)newCapacity));
+    buffer.Reserve(newCapacity);
+    MIKTEX_ASSERT(buffer.CanWrite(size));
+  }
+  buffer.Write(data, size);
+}
+
+size_t CurlWebFile::HeaderCallback(char* data, size_t elemSize, size_t numElements, void* pv)
+{
+  try
+  {
+    CurlWebFile* This = reinterpret_cast<CurlWebFile*>(pv);
+    size_t size = elemSize * numElements;
+    string line(data, size);
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+    {
+      line.pop_back();
+    }
+    if (line.compare(0, 5, "HTTP/") == 0)
+    {
+      // status line: a new response (e.g., after 100 Continue) starts
+      size_t pos = line.find(' ');
+      This->responseCode = pos == string::npos ? 0 : std::atol(line.c_str() + pos + 1);
+      This->responseValidators = WebFileValidators();
+      return size;
+    }
+    size_t colon = line.find(':');
+    if (colon == string::npos)
+    {
+      return size;
+    }
+    string name = line.substr(0, colon);
+    StringUtil::ToLowerAscii(&name[0], name.c_str(), name.length());
+    size_t start = line.find_first_not_of(" \t", colon + 1);
+    string value = start == string::npos ? "" : line.substr(start);
+    if (name == "etag")
+    {
+      This->responseValidators.eTag = value;
+    }
+    else if (name == "last-modified")
+    {
+      This->responseValidators.lastModified = value;
+    }
+    return size;
+  }
+  catch (const exception&)
+  {
+    return 0;
+  }
+}
+
 size_t CurlWebFile::WriteCallback(char* data, size_t elemSize, size_t numElements, void* pv)
 {
   try
   {
     CurlWebFile* This = reinterpret_cast<CurlWebFile*>(pv);
     size_t size = elemSize * numElements;
-    if (!This->buffer.CanWrite(size))
+    if (!This->receiving)
+    {
+      This->receiving = true;
+      char* localIp = nullptr;
+      if (curl_easy_getinfo(This->webSession->GetEasyHandle(), CURLINFO_LOCAL_IP, &localIp) == CURLE_OK && localIp != nullptr)
+      {
+        This->localAddress = localIp;
+      }
+      long responseCode = 0;
+      if (This->offset > 0
+        && curl_easy_getinfo(This->webSession->GetEasyHandle(), CURLINFO_RESPONSE_CODE, &responseCode) == CURLE_OK
+        && responseCode == 200)
+      {
+        // the server ignored the range request
+        This->trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Debug, fmt::format(T_("skipping the first {0} bytes"), This->offset));
+        This->toBeSkipped = This->offset;
+      }
+    }
+    if (This->toBeSkipped > 0)
     {
-      size_t newCapacity = This->buffer.GetCapacity() + 2 * size;
-      This->trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Debug, fmt::format(T_("reserve buffer: {0}"), (unsigned)newCapacity));
-      This->buffer.Reserve(newCapacity);
-      MIKTEX_ASSERT(This->buffer.CanWrite(size));
+      size_t skip = min(size, This->toBeSkipped);
+      This->toBeSkipped -= skip;
+      if (skip == size)
+      {
+        return size;
+      }
+      This->WriteToBuffer(data + skip, size - skip);
+      return size;
     }
-    This->buffer.Write(data, size);
+    This->WriteToBuffer(data, size);
     return size;
   }
   catch (const exception&)
@@ -148,6 +260,12 @@ void CurlWebFile::Close()
     initialized = false;
     webSession->ExpectOK(curl_multi_remove_handle(webSession->GetMultiHandle(), webSession->GetEasyHandle()));
   }
+  if (requestHeaders != nullptr)
+  {
+    webSession->SetOption(CURLOPT_HTTPHEADER, webSession->GetCustomHeaders());
+    curl_slist_free_all(requestHeaders);
+    requestHeaders = nullptr;
+  }
   buffer.Clear();
 }
 
@@ -1,6 +1,6 @@
 /* CurlWebFile.h:                                       -*- C++ -*-
 
-   Copyright (C) 2001-2021 Christian Schenk
+   Copyright (C) 2001-2024 Christian Schenk
 
    This file is part of MiKTeX Package Manager.
 
@@ -152,7 +152,7 @@ class CurlWebFile :
   public WebFile
 {
 public:
-  CurlWebFile(std::shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData);
+  CurlWebFile(std::shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData, std::size_t offset, const WebFileValidators& validators);
 
 public:
   ~CurlWebFile() override;
@@ -163,15 +163,48 @@ public:
 public:
   void Close() override;
 
+public:
+  bool IsNotModified() const override
+  {
+    return responseCode == 304;
+  }
+
+public:
+  WebFileValidators GetValidators() const override
+  {
+    return responseValidators;
+  }
+
+public:
+  std::string GetLocalAddress() const override
+  {
+    return localAddress;
+  }
+
+private:
+  static std::size_t HeaderCallback(char* data, std::size_t elemSize, std::size_t numElements, void* pv);
+
 private:
   static std::size_t WriteCallback(char* data, std::size_t elemSize, std::size_t numElements, void* pv);
 
 private:
   void Initialize();
 
+private:
+  void WriteToBuffer(const char* data, std::size_t size);
+
 private:
   bool initialized = false;
 
+private:
+  std::size_t offset;
+
+private:
+  bool receiving = false;
+
+private:
+  std::size_t toBeSkipped = 0;
+
 private:
   std::shared_ptr<CurlWebSession> webSession;
 
@@ -184,6 +217,22 @@ private:
 private:
   CircularBuffer buffer;
 
+  // sent with a conditional request
+private:
+  WebFileValidators requestValidators;
+
+private:
+  struct curl_slist* requestHeaders = nullptr;
+
+private:
+  long responseCode = 0;
+
+private:
+  WebFileValidators responseValidators;
+
+private:
+  std::string localAddress;
+
 private:
   std::unique_ptr<MiKTeX::Trace::TraceStream> trace_mpm;
 };
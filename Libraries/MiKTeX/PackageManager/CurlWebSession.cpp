@@ -1,6 +1,6 @@
 /* CurlWebSession.cpp:
 
-   Copyright (C) 2001-2021 Christian Schenk
+   Copyright (C) 2001-2024 Christian Schenk
 
    This file is part of MiKTeX Package Manager.
 
@@ -24,6 +24,7 @@
 #if defined(HAVE_LIBCURL)
 
 #include <algorithm>
+#include <mutex>
 #include <sstream>
 #include <thread>
 
@@ -66,6 +67,67 @@ const long DEFAULT_FTP_RESPONSE_TIMEOUT_SECONDS = 30;
 
 #define ALLOW_REDIRECTS 1
 
+#if LIBCURL_VERSION_NUM >= 0x73900
+// All sessions of the process share SSL session IDs and the DNS cache: a
+// session which is created for another thread (or for the REST service)
+// can resume the TLS session with the mirror host instead of making a full
+// handshake.  Connections are not shared: the connection cache is not safe
+// to use from several threads at once.
+class CurlShare
+{
+public:
+  CurlShare()
+  {
+    handle = curl_share_init();
+    if (handle != nullptr)
+    {
+      curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, LockFunction);
+      curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, UnlockFunction);
+      curl_share_setopt(handle, CURLSHOPT_USERDATA, reinterpret_cast<void*>(this));
+      curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+      curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+  }
+
+public:
+  ~CurlShare()
+  {
+    if (handle != nullptr)
+    {
+      curl_share_cleanup(handle);
+    }
+  }
+
+public:
+  static CURLSH* Get()
+  {
+    static CurlShare instance;
+    return instance.handle;
+  }
+
+private:
+  static void LockFunction(CURL* pCurl, curl_lock_data data, curl_lock_access access, void* pv)
+  {
+    UNUSED_ALWAYS(pCurl);
+    UNUSED_ALWAYS(access);
+    reinterpret_cast<CurlShare*>(pv)->mutexes[data % CURL_LOCK_DATA_LAST].lock();
+  }
+
+private:
+  static void UnlockFunction(CURL* pCurl, curl_lock_data data, void* pv)
+  {
+    UNUSED_ALWAYS(pCurl);
+    reinterpret_cast<CurlShare*>(pv)->mutexes[data % CURL_LOCK_DATA_LAST].unlock();
+  }
+
+private:
+  CURLSH* handle = nullptr;
+
+private:
+  mutex mutexes[CURL_LOCK_DATA_LAST];
+};
+#endif
+
 CurlWebSession::CurlWebSession(IProgressNotify_* callback) :
   trace_curl(TraceStream::Open(MIKTEX_TRACE_CURL)),
   trace_mpm(TraceStream::Open(MIKTEX_TRACE_MPM))
@@ -132,6 +194,35 @@ void CurlWebSession::Initialize()
     MIKTEX_FATAL_ERROR(T_("The cURL easy interface could not be initialized."));
   }
 
+#if LIBCURL_VERSION_NUM >= 0x73900
+  if (curlVersionInfo->version_num >= 0x73900)
+  {
+    CURLSH* share = CurlShare::Get();
+    if (share != nullptr)
+    {
+      SetOption(CURLOPT_SHARE, share);
+    }
+  }
+#endif
+
+#if LIBCURL_VERSION_NUM >= 0x72f00
+  // use HTTP/2 for https URLs, if the server supports it; requests for the
+  // same host are multiplexed over one connection
+  if (curlVersionInfo->version_num >= 0x72f00 && (curlVersionInfo->features & CURL_VERSION_HTTP2) != 0)
+  {
+    SetOption(CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    ExpectOK(curl_multi_setopt(pCurlm, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_MULTIPLEX)));
+  }
+#endif
+
+#if LIBCURL_VERSION_NUM >= 0x71900
+  // keep idle connections to the mirror host alive between downloads
+  if (curlVersionInfo->version_num >= 0x71900)
+  {
+    SetOption(CURLOPT_TCP_KEEPALIVE, static_cast<long>(true));
+  }
+#endif
+
   SetOption(CURLOPT_USERAGENT, BuildUserAgentString().c_str());
 
   SetOption(CURLOPT_PROGRESSDATA, reinterpret_cast<void*>(this));
@@ -255,7 +346,29 @@ unique_ptr<WebFile> CurlWebSession::OpenUrl(const string& url, const std::unorde
     Initialize();
   }
   trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("going to download {0}"), Q_(url)));
-  return make_unique<CurlWebFile>(shared_from_this(), url, formData);
+  return make_unique<CurlWebFile>(shared_from_this(), url, formData, 0, WebFileValidators());
+}
+
+unique_ptr<WebFile> CurlWebSession::OpenUrlAt(const string& url, size_t offset)
+{
+  runningHandles = -1;
+  if (pCurl == nullptr)
+  {
+    Initialize();
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("going to download {0}, starting at byte {1}"), Q_(url), offset));
+  return make_unique<CurlWebFile>(shared_from_this(), url, unordered_map<string, string>(), offset, WebFileValidators());
+}
+
+unique_ptr<WebFile> CurlWebSession::OpenUrlIfModified(const string& url, const WebFileValidators& validators)
+{
+  runningHandles = -1;
+  if (pCurl == nullptr)
+  {
+    Initialize();
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("going to download {0}, if modified"), Q_(url)));
+  return make_unique<CurlWebFile>(shared_from_this(), url, unordered_map<string, string>(), 0, validators);
 }
 
 void CurlWebSession::SetCustomHeaders(const unordered_map<string, string>& headers)
@@ -429,7 +542,11 @@ void CurlWebSession::ReadInformationals()
     }
     ExpectOK(r, effectiveUrl);
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("response code: {0}"), responseCode));
-    if (responseCode >= 300 && responseCode <= 399)
+    if (responseCode == 304)
+    {
+      // the answer to a conditional request
+    }
+    else if (responseCode >= 300 && responseCode <= 399)
     {
 #if ALLOW_REDIRECTS
       MIKTEX_UNEXPECTED();
@@ -58,6 +58,12 @@ public:
 public:
   std::unique_ptr<WebFile> OpenUrl(const std::string& url, const std::unordered_map<std::string, std::string>& formData) override;
 
+public:
+  std::unique_ptr<WebFile> OpenUrlAt(const std::string& url, std::size_t offset) override;
+
+public:
+  std::unique_ptr<WebFile> OpenUrlIfModified(const std::string& url, const WebFileValidators& validators) override;
+
 public:
   void Dispose() override;
 
@@ -195,6 +201,12 @@ private:
 private:
   struct curl_slist* headers = nullptr;
 
+public:
+  struct curl_slist* GetCustomHeaders() const
+  {
+    return headers;
+  }
+
 private:
   curl_version_info_data* curlVersionInfo = nullptr;
 
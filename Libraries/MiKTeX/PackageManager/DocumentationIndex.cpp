@@ -0,0 +1,265 @@
+/**
+ * @file DocumentationIndex.cpp
+ * @author Christian Schenk
+ * @brief Package documentation index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/File>
+#include <miktex/Core/Process>
+#include <miktex/Core/StreamReader>
+#include <miktex/Core/StreamWriter>
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+#include <miktex/Util/PathNameUtil>
+#include <miktex/Util/StringUtil>
+
+#include "internal.h"
+
+#include "DocumentationIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+constexpr const char* DOCUMENTATION_INDEX_SIGNATURE = "miktex-documentation-index-1";
+
+// language codes recognized in documentation file names (e.g.,
+// `foo-de.pdf`, `doc/latex/foo/fr/foo.pdf`)
+static const unordered_set<string> LANGUAGE_CODES = {
+    "cs", "de", "en", "es", "fr", "it", "ja", "ko", "nl", "pl", "pt", "ru", "uk", "zh"
+};
+
+static string ToLower(string s)
+{
+    transform(s.begin(), s.end(), s.begin(), [](unsigned char ch) { return static_cast<char>(tolower(ch)); });
+    return s;
+}
+
+static string GuessLanguage(const string& fileName)
+{
+    vector<string> components;
+    string component;
+    for (char ch : fileName)
+    {
+        if (PathNameUtil::IsDirectoryDelimiter(ch))
+        {
+            components.push_back(component);
+            component.clear();
+        }
+        else
+        {
+            component += ch;
+        }
+    }
+    string stem = PathName(component).GetFileNameWithoutExtension().ToString();
+    size_t pos = stem.find_last_of("-_");
+    if (pos != string::npos)
+    {
+        string code = ToLower(stem.substr(pos + 1));
+        if (LANGUAGE_CODES.find(code) != LANGUAGE_CODES.end())
+        {
+            return code;
+        }
+    }
+    for (auto it = components.rbegin(); it != components.rend(); ++it)
+    {
+        if (LANGUAGE_CODES.find(*it) != LANGUAGE_CODES.end())
+        {
+            return *it;
+        }
+    }
+    return "";
+}
+
+// the fields are separated by tabs
+static string Sanitize(string s)
+{
+    replace_if(s.begin(), s.end(), [](char ch) { return ch == '\t' || ch == '\r' || ch == '\n'; }, ' ');
+    return s;
+}
+
+static PathName GetIndexPath()
+{
+    return MIKTEX_SESSION()->GetSpecialPath(SpecialPath::InstallRoot) / MIKTEX_PATH_DOCUMENTATION_INDEX;
+}
+
+// the index depends on the package manifests and on the installation status
+// of the packages, in both scopes
+static vector<string> MakeStamps()
+{
+    shared_ptr<Session> session = MIKTEX_SESSION();
+    vector<string> stamps;
+    for (const PathName& root : { session->GetSpecialPath(SpecialPath::UserInstallRoot), session->GetSpecialPath(SpecialPath::CommonInstallRoot) })
+    {
+        for (const PathName& path : { root / MIKTEX_PATH_PACKAGE_MANIFESTS_INI, root / MIKTEX_PATH_PACKAGES_INI })
+        {
+            if (File::Exists(path))
+            {
+                stamps.push_back(fmt::format("S\t{0}\t{1}", File::GetSize(path), File::GetLastWriteTime(path)));
+            }
+            else
+            {
+                stamps.push_back("S\t-\t-");
+            }
+        }
+    }
+    return stamps;
+}
+
+vector<PackageDocumentation> DocumentationIndex::Build(PackageDataStore& packageDataStore)
+{
+    shared_ptr<Session> session = MIKTEX_SESSION();
+    PathName userInstallRoot = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+    PathName commonInstallRoot = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+    vector<PackageDocumentation> index;
+    for (const PackageInfo& packageInfo : packageDataStore)
+    {
+        if (packageInfo.IsPureContainer() || packageInfo.docFiles.empty())
+        {
+            continue;
+        }
+        PackageDocumentation packageDocumentation;
+        packageDocumentation.packageId = packageInfo.id;
+        packageDocumentation.title = packageInfo.title;
+        packageDocumentation.isInstalled = packageInfo.IsInstalled();
+        const PathName& installRoot = packageInfo.IsInstalled(ConfigurationScope::User) ? userInstallRoot : commonInstallRoot;
+        for (const string& docFile : packageInfo.docFiles)
+        {
+            DocumentationFile file;
+            if (!PackageManager::StripTeXMFPrefix(docFile, file.fileName))
+            {
+                continue;
+            }
+            if (packageDocumentation.isInstalled && File::Exists(installRoot / file.fileName))
+            {
+                file.path = installRoot / file.fileName;
+            }
+            string extension = PathName(file.fileName).GetExtension();
+            file.type = ToLower(extension.empty() ? extension : extension.substr(1));
+            file.language = GuessLanguage(file.fileName);
+            packageDocumentation.files.push_back(std::move(file));
+        }
+        if (!packageDocumentation.files.empty())
+        {
+            index.push_back(std::move(packageDocumentation));
+        }
+    }
+    return index;
+}
+
+bool DocumentationIndex::TryRead(vector<PackageDocumentation>& index)
+{
+    unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    PathName indexPath = GetIndexPath();
+    if (!File::Exists(indexPath))
+    {
+        return false;
+    }
+    try
+    {
+        StreamReader reader(indexPath);
+        string line;
+        if (!reader.ReadLine(line) || line != DOCUMENTATION_INDEX_SIGNATURE)
+        {
+            return false;
+        }
+        for (const string& stamp : MakeStamps())
+        {
+            if (!reader.ReadLine(line) || line != stamp)
+            {
+                trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("documentation index {0} is out of date"), Q_(indexPath)));
+                return false;
+            }
+        }
+        vector<PackageDocumentation> newIndex;
+        while (reader.ReadLine(line))
+        {
+            vector<string> fields = StringUtil::Split(line, '\t');
+            if (fields.size() == 4 && fields[0] == "P")
+            {
+                PackageDocumentation packageDocumentation;
+                packageDocumentation.isInstalled = fields[1] == "1";
+                packageDocumentation.packageId = fields[2];
+                packageDocumentation.title = fields[3];
+                newIndex.push_back(std::move(packageDocumentation));
+            }
+            else if (fields.size() == 5 && fields[0] == "F" && !newIndex.empty())
+            {
+                DocumentationFile file;
+                file.fileName = fields[1];
+                file.path = fields[2];
+                file.type = fields[3];
+                file.language = fields[4];
+                newIndex.back().files.push_back(std::move(file));
+            }
+            else
+            {
+                MIKTEX_UNEXPECTED();
+            }
+        }
+        reader.Close();
+        index = std::move(newIndex);
+    }
+    catch (const exception& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("documentation index {0} cannot be read: {1}"), Q_(indexPath), e.what()));
+        return false;
+    }
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("loaded {0} documentation records from {1}"), index.size(), Q_(indexPath)));
+    return true;
+}
+
+void DocumentationIndex::Write(const vector<PackageDocumentation>& index)
+{
+    unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    PathName indexPath = GetIndexPath();
+    try
+    {
+        // readers must not see a partially written index file
+        PathName newPath = indexPath;
+        newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        StreamWriter writer(newPath);
+        writer.WriteLine(DOCUMENTATION_INDEX_SIGNATURE);
+        for (const string& stamp : MakeStamps())
+        {
+            writer.WriteLine(stamp);
+        }
+        for (const PackageDocumentation& packageDocumentation : index)
+        {
+            writer.WriteLine(fmt::format("P\t{0}\t{1}\t{2}", packageDocumentation.isInstalled ? 1 : 0, packageDocumentation.packageId, Sanitize(packageDocumentation.title)));
+            for (const DocumentationFile& file : packageDocumentation.files)
+            {
+                writer.WriteLine(fmt::format("F\t{0}\t{1}\t{2}\t{3}", Sanitize(file.fileName), Sanitize(file.path.ToString()), file.type, file.language));
+            }
+        }
+        writer.Close();
+        File::Move(newPath, indexPath, { FileMoveOption::ReplaceExisting });
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("wrote documentation index {0}"), Q_(indexPath)));
+    }
+    catch (const exception& e)
+    {
+        // the index file is an optimization: the package database stays the
+        // master
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("documentation index {0} cannot be written: {1}"), Q_(indexPath), e.what()));
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * @file DocumentationIndex.h
+ * @author Christian Schenk
+ * @brief Package documentation index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <miktex/PackageManager/PackageManager>
+
+#include "PackageDataStore.h"
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief Maps packages to their documentation files.
+ *
+ * The index file lives in the configuration directory of the installation
+ * root.  It records the sizes and the modification times of the package
+ * database files it was built from; a stale index file is ignored and
+ * replaced.
+ */
+class DocumentationIndex
+{
+public:
+
+    /**
+     * @brief Builds the documentation index from the package database.
+     * @param packageDataStore The loaded package database.
+     * @return Returns the documentation records.
+     */
+    static std::vector<MiKTeX::Packages::PackageDocumentation> Build(PackageDataStore& packageDataStore);
+
+    /**
+     * @brief Reads an up-to-date index file.
+     * @param[out] index The documentation records.
+     * @return Returns `false`, if the index file is missing, out of date or
+     * unreadable.
+     */
+    static bool TryRead(std::vector<MiKTeX::Packages::PackageDocumentation>& index);
+
+    /**
+     * @brief Writes the index file.
+     * @param index The documentation records.
+     */
+    static void Write(const std::vector<MiKTeX::Packages::PackageDocumentation>& index);
+};
+
+MPM_INTERNAL_END_NAMESPACE;
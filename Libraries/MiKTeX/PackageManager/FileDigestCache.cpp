@@ -0,0 +1,143 @@
+/**
+ * @file FileDigestCache.cpp
+ * @author Christian Schenk
+ * @brief Digests of verified package files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Process>
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+#include "internal.h"
+
+#include "FileDigestCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+constexpr const char* FILE_DIGEST_CACHE_SIGNATURE = "miktex-file-digest-cache-1";
+
+FileDigestCache::FileDigestCache(const PathName& path) :
+    path(path)
+{
+}
+
+void FileDigestCache::Load()
+{
+    unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    entries.clear();
+    modified = false;
+    if (!File::Exists(path))
+    {
+        return;
+    }
+    try
+    {
+        ifstream stream = File::CreateInputStream(path);
+        string line;
+        if (!getline(stream, line) || line != FILE_DIGEST_CACHE_SIGNATURE)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("ignoring file digest cache {0}"), Q_(path)));
+            return;
+        }
+        // <digest> <size> <lastWriteTime> <path>
+        while (getline(stream, line))
+        {
+            istringstream fields(line);
+            string digest;
+            Entry entry;
+            string fileName;
+            if (!(fields >> digest >> entry.size >> entry.lastWriteTime) || fields.get() != ' ' || !getline(fields, fileName) || fileName.empty())
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            entry.digest = MD5::Parse(digest);
+            entries[fileName] = entry;
+        }
+        stream.close();
+    }
+    catch (const exception& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("file digest cache {0} cannot be read: {1}"), Q_(path), e.what()));
+        entries.clear();
+        return;
+    }
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("loaded {0} file digests from {1}"), entries.size(), Q_(path)));
+}
+
+void FileDigestCache::Save()
+{
+    if (!modified)
+    {
+        return;
+    }
+    unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    try
+    {
+        Directory::Create(path.GetDirectoryName());
+        PathName newPath = path;
+        newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        ofstream stream = File::CreateOutputStream(newPath);
+        stream << FILE_DIGEST_CACHE_SIGNATURE << "\n";
+        for (const auto& e : entries)
+        {
+            stream << e.second.digest << " " << e.second.size << " " << e.second.lastWriteTime << " " << e.first << "\n";
+        }
+        stream.close();
+        File::Move(newPath, path, { FileMoveOption::ReplaceExisting });
+        modified = false;
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("wrote {0} file digests to {1}"), entries.size(), Q_(path)));
+    }
+    catch (const exception& e)
+    {
+        // the cache is an optimization: a lost cache costs only time
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("file digest cache {0} cannot be written: {1}"), Q_(path), e.what()));
+    }
+}
+
+bool FileDigestCache::TryGet(const PathName& path, size_t size, time_t lastWriteTime, MD5& digest) const
+{
+    auto it = entries.find(path.ToString());
+    if (it == entries.end() || it->second.size != size || it->second.lastWriteTime != lastWriteTime)
+    {
+        return false;
+    }
+    digest = it->second.digest;
+    return true;
+}
+
+void FileDigestCache::Put(const PathName& path, size_t size, time_t lastWriteTime, const MD5& digest)
+{
+    Entry& entry = entries[path.ToString()];
+    if (entry.size == size && entry.lastWriteTime == lastWriteTime && entry.digest == digest)
+    {
+        return;
+    }
+    entry.size = size;
+    entry.lastWriteTime = lastWriteTime;
+    entry.digest = digest;
+    modified = true;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file FileDigestCache.h
+ * @author Christian Schenk
+ * @brief Digests of verified package files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+
+#include <string>
+#include <unordered_map>
+
+#include <miktex/Core/MD5>
+#include <miktex/Util/PathName>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief File digests which have been computed during a successful package
+ * verification.
+ *
+ * An entry is used only if the size and the modification time of the file
+ * still match.
+ */
+class FileDigestCache
+{
+public:
+
+    FileDigestCache(const MiKTeX::Util::PathName& path);
+
+    /**
+     * @brief Loads the cache file.
+     */
+    void Load();
+
+    /**
+     * @brief Writes the cache file, if entries have been added.
+     */
+    void Save();
+
+    /**
+     * @brief Looks up the digest of an unchanged file.
+     * @param path Path to the file.
+     * @param size Current size of the file.
+     * @param lastWriteTime Current modification time of the file.
+     * @param[out] digest The cached digest.
+     * @return Returns `true`, if an entry matches.
+     */
+    bool TryGet(const MiKTeX::Util::PathName& path, std::size_t size, std::time_t lastWriteTime, MiKTeX::Core::MD5& digest) const;
+
+    /**
+     * @brief Adds or replaces an entry.
+     * @param path Path to the file.
+     * @param size Size of the file.
+     * @param lastWriteTime Modification time of the file.
+     * @param digest Digest of the file contents.
+     */
+    void Put(const MiKTeX::Util::PathName& path, std::size_t size, std::time_t lastWriteTime, const MiKTeX::Core::MD5& digest);
+
+private:
+
+    struct Entry
+    {
+        std::size_t size = 0;
+        std::time_t lastWriteTime = 0;
+        MiKTeX::Core::MD5 digest;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+
+    bool modified = false;
+
+    MiKTeX::Util::PathName path;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
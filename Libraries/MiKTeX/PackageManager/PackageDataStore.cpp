@@ -14,6 +14,8 @@
 #include "config.h"
 
 #include <future>
+#include <iterator>
+#include <unordered_set>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -34,6 +36,7 @@
 
 #include "PackageDataStore.h"
 #include "PackageManagerImpl.h"
+#include "PackageManifestIndex.h"
 #include "TpmParser.h"
 
 using namespace std;
@@ -66,7 +69,7 @@ void PackageDataStore::LoadAllPackageManifests(const PathName& packageManifestsP
     unique_ptr<Cfg> cfg = Cfg::Create();
     cfg->Read(packageManifestsPath, mustBeSigned);
 
-    Load(*cfg);
+    Load(GetPackageManifests(*cfg));
 
     loadedAllPackageManifests = true;
 }
@@ -232,13 +235,14 @@ PackageDataStore& PackageDataStore::Load()
     }
     unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "loading all package manifests");
     NeedPackageManifestsIni();
-    unique_ptr<Cfg> cfg = Cfg::Create();
+    // user manifests come first: they take precedence
+    vector<PackageInfo> packageManifests;
     if (!session->IsAdminMode())
     {
         PathName userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
         if (File::Exists(userPath))
         {
-            cfg->Read(userPath);
+            ReadPackageManifests(userPath, packageManifests);
         }
     }
     if (session->IsAdminMode() || session->IsSharedSetup() && session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize())
@@ -246,27 +250,50 @@ PackageDataStore& PackageDataStore::Load()
         PathName commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
         if (File::Exists(commonPath))
         {
-            cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
-            cfg->Read(commonPath);
+            ReadPackageManifests(commonPath, packageManifests);
         }
     }
-    Load(*cfg);
+    Load(packageManifests);
     loadedAllPackageManifests = true;
     return *this;
 }
 
-void PackageDataStore::Load(Cfg& cfg)
+vector<PackageInfo> PackageDataStore::GetPackageManifests(Cfg& cfg)
 {
-    unsigned count = 0;
+    vector<PackageInfo> packageManifests;
     for (const auto& key : cfg)
+    {
+        packageManifests.push_back(PackageManager::GetPackageManifest(cfg, key->GetName(), TEXMF_PREFIX_DIRECTORY));
+    }
+    return packageManifests;
+}
+
+void PackageDataStore::ReadPackageManifests(const PathName& path, vector<PackageInfo>& packageManifests)
+{
+    if (PackageManifestIndex::TryRead(path, packageManifests))
+    {
+        return;
+    }
+    unique_ptr<Cfg> cfg = Cfg::Create();
+    cfg->Read(path);
+    vector<PackageInfo> newPackageManifests = GetPackageManifests(*cfg);
+    PackageManifestIndex::Write(path, newPackageManifests);
+    packageManifests.insert(packageManifests.end(), make_move_iterator(newPackageManifests.begin()), make_move_iterator(newPackageManifests.end()));
+}
+
+void PackageDataStore::Load(const vector<PackageInfo>& packageManifests)
+{
+    unsigned count = 0;
+    unordered_set<string, hash_icase, equal_icase> seen;
+    for (const PackageInfo& packageManifest : packageManifests)
     {
         // ignore redefinition
-        if (packageTable.find(key->GetName()) != packageTable.end())
+        if (!seen.insert(packageManifest.id).second || packageTable.find(packageManifest.id) != packageTable.end())
         {
             continue;
         }
 
-        PackageInfo packageInfo = PackageManager::GetPackageManifest(cfg, key->GetName(), TEXMF_PREFIX_DIRECTORY);
+        PackageInfo packageInfo = packageManifest;
 
 #if IGNORE_OTHER_SYSTEMS
         string targetSystems = packageInfo.targetSystem;
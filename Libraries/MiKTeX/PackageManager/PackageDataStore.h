@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Package data store
  *
- * @copyright Copyright © 2018-2022 Christian Schenk
+ * @copyright Copyright © 2018-2024 Christian Schenk
  *
  * This file is part of MiKTeX Package Manager.
  *
@@ -19,6 +19,7 @@
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include <miktex/Util/PathName>
 #include <miktex/Core/Session>
@@ -36,7 +37,8 @@ MPM_INTERNAL_BEGIN_NAMESPACE;
  * @brief An instance of this class collects package records.
  *
  * The record data is retrieved from two sources:
- * - `miktex/config/package-manifests.ini`: immutable package manifests
+ * - `miktex/config/package-manifests.ini`: immutable package manifests; a
+ *   compiled index (`package-manifests.idx`) is used when it is up to date
  * - `miktex/config/packages.ini`: mutable package data such as installation
  *   timestamps
  */
@@ -232,9 +234,11 @@ private:
     bool IsRemovable(const std::string& packageId);
     std::time_t GetTimeInstalled(const std::string& packageId);
     std::time_t GetTimeInstalled(const std::string& packageId, MiKTeX::Core::ConfigurationScope scope);
+    static std::vector<MiKTeX::Packages::PackageInfo> GetPackageManifests(MiKTeX::Core::Cfg& cfg);
     void IncrementFileRefCounts(const std::vector<std::string>& files);
-    void Load(MiKTeX::Core::Cfg& cfg);
+    void Load(const std::vector<MiKTeX::Packages::PackageInfo>& packageManifests);
     void LoadVarData();
+    void ReadPackageManifests(const MiKTeX::Util::PathName& path, std::vector<MiKTeX::Packages::PackageInfo>& packageManifests);
 
     ComboCfg comboCfg;
     InstalledFileInfoTable installedFileInfoTable;
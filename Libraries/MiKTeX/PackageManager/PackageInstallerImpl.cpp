@@ -13,16 +13,34 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <functional>
+#include <future>
 #include <set>
 #include <unordered_set>
 
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+#include <cerrno>
+#include <unistd.h>
+#endif
+#if defined(HAVE_SENDFILE) && defined(MIKTEX_LINUX)
+#include <sys/sendfile.h>
+#endif
+#if defined(HAVE_FCOPYFILE)
+#include <copyfile.h>
+#include <sys/stat.h>
+#endif
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/BufferedStream>
 #include <miktex/Core/Directory>
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/LockFile>
+#include <miktex/Core/Process>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/TemporaryFile>
 #include <miktex/Extractor/Extractor>
@@ -38,6 +56,8 @@
 #include <miktex/PackageManager/PackageManager>
 
 #include "internal.h"
+#include "DocumentationIndex.h"
+#include "exceptions.h"
 #include "PackageInstallerImpl.h"
 #include "PackageIteratorImpl.h"
 #include "TpmParser.h"
@@ -55,6 +75,32 @@ using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
 constexpr const char* LF = "\n";
 
+// the number of times an interrupted download is continued
+constexpr int MAX_DOWNLOAD_RETRIES = 3;
+
+// beyond this number of changed package manifests, the MPM file name
+// database is rebuilt from scratch
+constexpr size_t MAX_INCREMENTAL_MPM_FNDB_UPDATES = 500;
+
+// beyond this number of batched file name database changes, the file name
+// database of the root directory is rebuilt from scratch
+constexpr size_t MAX_BATCHED_FNDB_CHANGES = 50000;
+
+// the number of files which are copied at the same time when installing from
+// a local repository or from a MiKTeX installation
+constexpr size_t MAX_CONCURRENT_FILE_COPIES = 4;
+
+// the number of files which are deleted at the same time when removing a
+// package
+constexpr size_t MAX_CONCURRENT_FILE_DELETIONS = 8;
+
+// the buffer size used if the operating system cannot copy the file
+constexpr size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+// remembers the version of a downloaded manifest archive, so that it is
+// downloaded again only if it has been modified on the server
+constexpr const char* VALIDATORS_FILE_NAME = "validators.ini";
+
 template<typename T1, typename T2> double Divide(T1 a, T2 b)
 {
     return static_cast<double>(a) / static_cast<double>(b);
@@ -80,6 +126,7 @@ MPMSTATICFUNC(bool) IsMiKTeXPackage(const string& packageId)
 }
 
 PackageInstallerImpl::PackageInstallerImpl(shared_ptr<PackageManagerImpl> manager, const InitInfo& initInfo) :
+    batchFndbUpdates(initInfo.batchFndbUpdates),
     callback(initInfo.callback),
     enablePostProcessing(initInfo.enablePostProcessing),
     packageDataStore(manager->GetPackageDataStore()),
@@ -111,6 +158,41 @@ void PackageInstallerImpl::NeedRepository()
     }
 }
 
+void PackageInstallerImpl::PickRepository()
+{
+    repository = packageManager->PickRepositoryUrl();
+    repositoryType = RepositoryType::Remote;
+    fallbackRepositories.clear();
+    for (const string& url : packageManager->GetRankedRepositoryUrls())
+    {
+        if (url != repository)
+        {
+            fallbackRepositories.push_back(url);
+        }
+    }
+}
+
+// switches to the next best repository; the URL of a repository file is
+// changed accordingly
+bool PackageInstallerImpl::SwitchRepository(string& url)
+{
+    if (fallbackRepositories.empty() || url.compare(0, repository.length(), repository) != 0)
+    {
+        return false;
+    }
+    string relPath = url.substr(repository.length());
+    while (!relPath.empty() && relPath[0] == '/')
+    {
+        relPath.erase(0, 1);
+    }
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("giving up on {0}"), Q_(repository)));
+    repository = fallbackRepositories.front();
+    fallbackRepositories.pop_front();
+    url = MakeUrl(relPath);
+    ReportLine(fmt::format(T_("switching to repository {0}..."), Q_(repository)));
+    return true;
+}
+
 void PackageInstallerImpl::SetCallback(PackageInstallerCallback* callback)
 {
     this->callback = callback;
@@ -132,10 +214,45 @@ void PackageInstallerImpl::OnProgress()
     Notify();
 }
 
-void PackageInstallerImpl::Download(const string& url, const PathName& dest, size_t expectedSize)
+// Returns false, if asking the server again will not help.
+static bool IsTransientDownloadError(const MiKTeXException& e)
+{
+    if (dynamic_cast<const NotFoundException*>(&e) != nullptr)
+    {
+        return false;
+    }
+    MiKTeXException::KVMAP info = e.GetInfo();
+    auto it = info.find("responseCode");
+    if (it == info.end())
+    {
+        // a network error
+        return true;
+    }
+    long responseCode = std::atol(it->second.c_str());
+    return responseCode == 408 || responseCode == 429 || responseCode >= 500;
+}
+
+void PackageInstallerImpl::Download(const string& url, const PathName& dest, size_t expectedSize, bool resume)
 {
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to download: {0} => {1}"), Q_(url), Q_(dest)));
 
+    // bytes which are already there
+    size_t received = 0;
+
+    if (resume && File::Exists(dest))
+    {
+        received = File::GetSize(dest);
+        if (expectedSize == 0 || received > expectedSize)
+        {
+            received = 0;
+        }
+        else if (received == expectedSize)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} has already been downloaded"), Q_(dest)));
+            return;
+        }
+    }
+
     if (expectedSize > 0)
     {
         ReportLine(fmt::format(T_("downloading {0} (expecting {1} bytes)..."), Q_(url), expectedSize));
@@ -145,14 +262,6 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
         ReportLine(fmt::format(T_("downloading {0}..."), Q_(url)));
     }
 
-    // open the remote file
-    unique_ptr<WebFile> webFile(packageManager->GetWebSession()->OpenUrl(url.c_str()));
-
-    // open the local file
-    FileStream destStream(File::Open(dest, FileMode::Create, FileAccess::Write, false));
-
-    // receive the data
-    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("start writing on {0}"), Q_(dest)));
 #if defined(CURL_MAX_WRITE_SIZE)
     const size_t bufsize = 2 * CURL_MAX_WRITE_SIZE;
 #else
@@ -160,42 +269,91 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
 #endif
     char buf[bufsize];
     size_t n;
-    size_t received = 0;
+    size_t startReceived = received;
     clock_t start = clock();
     clock_t start1 = start;
     size_t received1 = 0;
-    while ((n = webFile->Read(buf, sizeof(buf))) > 0)
+    int retries = 0;
+    string currentUrl = url;
+
+    while (true)
     {
-        clock_t end1 = clock();
+        try
+        {
+            // open the remote file; continue an interrupted download
+            unique_ptr<WebFile> webFile(received > 0 ? packageManager->GetWebSession()->OpenUrlAt(currentUrl, received) : packageManager->GetWebSession()->OpenUrl(currentUrl));
 
-        destStream.Write(buf, n);
+            // open the local file; it is written on a background thread
+            // while the next data is received
+            unique_ptr<BufferedStream> destStream = received > 0
+                ? BufferedStream::Append(dest, BufferedStream::DefaultBufferSize, { BufferedStreamOption::WriteBehind })
+                : BufferedStream::Create(dest, BufferedStream::DefaultBufferSize, { BufferedStreamOption::WriteBehind });
 
-        received += n;
-        received1 += n;
+            // receive the data
+            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("start writing on {0}"), Q_(dest)));
+            while ((n = webFile->Read(buf, sizeof(buf))) > 0)
+            {
+                clock_t end1 = clock();
 
-        // update progress info
+                destStream->Write(buf, n);
+
+                received += n;
+                received1 += n;
+
+                // update progress info
+                {
+                    lock_guard<mutex> lockGuard(progressIndicatorMutex);
+                    progressInfo.cbPackageDownloadCompleted += n;
+                    progressInfo.cbDownloadCompleted += n;
+                    if (end1 > start1 + 1 * CLOCKS_PER_SEC)
+                    {
+                        progressInfo.bytesPerSecond = static_cast<unsigned long>(Divide(received1, Divide(end1 - start1, CLOCKS_PER_SEC)));
+                        start1 = end1;
+                        received1 = 0;
+                    }
+                    double timePassed = clock() - timeStarted;
+                    double timeTotal = ((timePassed / progressInfo.cbDownloadCompleted) * progressInfo.cbDownloadTotal);
+                    progressInfo.timeRemaining = static_cast<unsigned long>((timeTotal - timePassed) / CLOCKS_PER_SEC);
+                }
+
+                Notify();
+            }
+
+            // close files
+            destStream->Close();
+            webFile->Close();
+        }
+        catch (const OperationCancelledException&)
         {
-            lock_guard<mutex> lockGuard(progressIndicatorMutex);
-            progressInfo.cbPackageDownloadCompleted += n;
-            progressInfo.cbDownloadCompleted += n;
-            if (end1 > start1 + 1 * CLOCKS_PER_SEC)
+            throw;
+        }
+        catch (const MiKTeXException& e)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("download of {0} interrupted after {1} bytes: {2}"), Q_(currentUrl), received, e.GetErrorMessage()));
+            if (retries >= MAX_DOWNLOAD_RETRIES || !IsTransientDownloadError(e))
             {
-                progressInfo.bytesPerSecond = static_cast<unsigned long>(Divide(received1, Divide(end1 - start1, CLOCKS_PER_SEC)));
-                start1 = end1;
-                received1 = 0;
+                // fail over to the next best repository
+                if (!SwitchRepository(currentUrl))
+                {
+                    throw;
+                }
+                retries = 0;
+                continue;
             }
-            double timePassed = clock() - timeStarted;
-            double timeTotal = ((timePassed / progressInfo.cbDownloadCompleted) * progressInfo.cbDownloadTotal);
-            progressInfo.timeRemaining = static_cast<unsigned long>((timeTotal - timePassed) / CLOCKS_PER_SEC);
+            retries += 1;
+            ReportLine(fmt::format(T_("retrying the download of {0}..."), Q_(currentUrl)));
+            continue;
         }
-
-        Notify();
+        if (expectedSize > 0 && received < expectedSize && retries < MAX_DOWNLOAD_RETRIES)
+        {
+            // the connection was closed too early
+            retries += 1;
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("download of {0} incomplete ({1} of {2} bytes)"), Q_(currentUrl), received, expectedSize));
+            continue;
+        }
+        break;
     }
 
-    // close files
-    destStream.Close();
-    webFile->Close();
-
     clock_t end = clock();
 
     if (start == end)
@@ -204,7 +362,7 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
     }
 
     // report statistics
-    double mb = Divide(received, 1000000);
+    double mb = Divide(received - startReceived, 1000000);
     double seconds = Divide(end - start, CLOCKS_PER_SEC);
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloaded {0:.2f} MB in {1:.2f} seconds"), mb, seconds));
     ReportLine(fmt::format(T_("{0:.2f} MB, {1:.2f} Mbit/s"), mb, Divide(8 * mb, seconds)));
@@ -215,6 +373,462 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
     }
 }
 
+MPMSTATICFUNC(string) MakeFileStamp(const PathName& path)
+{
+    return File::Exists(path) ? fmt::format("{0}:{1}", File::GetSize(path), File::GetLastWriteTime(path)) : "";
+}
+
+MPMSTATICFUNC(WebFileValidators) ReadValidators(const PathName& path, const string& url, string& stamp)
+{
+    WebFileValidators validators;
+    stamp = "";
+    try
+    {
+        if (!File::Exists(path))
+        {
+            return validators;
+        }
+        unique_ptr<Cfg> cfg = Cfg::Create();
+        cfg->Read(path);
+        string validatorsUrl;
+        if (!cfg->TryGetValueAsString("validators", "url", validatorsUrl) || validatorsUrl != url)
+        {
+            return validators;
+        }
+        cfg->TryGetValueAsString("validators", "etag", validators.eTag);
+        cfg->TryGetValueAsString("validators", "lastmodified", validators.lastModified);
+        cfg->TryGetValueAsString("validators", "stamp", stamp);
+    }
+    catch (const MiKTeXException&)
+    {
+        validators = WebFileValidators();
+    }
+    return validators;
+}
+
+MPMSTATICFUNC(void) WriteValidators(const PathName& path, const string& url, const WebFileValidators& validators, const string& stamp)
+{
+    if (validators.Empty())
+    {
+        if (File::Exists(path))
+        {
+            File::Delete(path);
+        }
+        return;
+    }
+    unique_ptr<Cfg> cfg = Cfg::Create();
+    cfg->PutValue("validators", "url", url);
+    cfg->PutValue("validators", "etag", validators.eTag);
+    cfg->PutValue("validators", "lastmodified", validators.lastModified);
+    cfg->PutValue("validators", "stamp", stamp);
+    cfg->Write(path);
+}
+
+bool PackageInstallerImpl::DownloadIfModified(const string& url, const PathName& dest, WebFileValidators& validators)
+{
+    try
+    {
+        unique_ptr<WebFile> webFile = packageManager->GetWebSession()->OpenUrlIfModified(url, validators);
+        unique_ptr<BufferedStream> destStream = BufferedStream::Create(dest, BufferedStream::DefaultBufferSize, {});
+        char buf[32 * 1024];
+        size_t n;
+        while ((n = webFile->Read(buf, sizeof(buf))) > 0)
+        {
+            destStream->Write(buf, n);
+            {
+                lock_guard<mutex> lockGuard(progressIndicatorMutex);
+                progressInfo.cbPackageDownloadCompleted += n;
+                progressInfo.cbDownloadCompleted += n;
+            }
+            Notify();
+        }
+        destStream->Close();
+        bool notModified = webFile->IsNotModified();
+        WebFileValidators newValidators = webFile->GetValidators();
+        webFile->Close();
+        if (notModified)
+        {
+            ReportLine(fmt::format(T_("{0} has not been modified"), Q_(url)));
+            return false;
+        }
+        validators = newValidators;
+        return true;
+    }
+    catch (const OperationCancelledException&)
+    {
+        throw;
+    }
+    catch (const MiKTeXException& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("conditional download of {0} failed: {1}"), Q_(url), e.GetErrorMessage()));
+    }
+    validators = WebFileValidators();
+    Download(url, dest);
+    return true;
+}
+
+void PackageInstallerImpl::StartPrefetching(const vector<string>& packages)
+{
+    if (repositoryType != RepositoryType::Remote || packages.size() < 2)
+    {
+        return;
+    }
+    int concurrentDownloads = session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_CONCURRENT_DOWNLOADS, ConfigValue(4)).GetInt();
+    if (concurrentDownloads < 2)
+    {
+        return;
+    }
+    MIKTEX_ASSERT(prefetchThreads.empty());
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloading up to {0} archive files at the same time"), concurrentDownloads));
+    for (const string& packageId : packages)
+    {
+        PathName cachedArchiveFile = GetCachedArchiveFile(packageId);
+        if (!cachedArchiveFile.Empty() && File::Exists(cachedArchiveFile))
+        {
+            continue;
+        }
+        auto archive = make_shared<PrefetchedArchive>();
+        archive->packageId = packageId;
+        PathName packageFileName(packageId);
+        packageFileName.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(repositoryManifest.GetArchiveFileType(packageId)));
+        archive->url = MakeUrl(packageFileName.ToString());
+        archive->expectedSize = repositoryManifest.GetArchiveFileSize(packageId);
+        archive->expectedDigest = repositoryManifest.GetArchiveFileDigest(packageId);
+        prefetchQueue.push_back(archive);
+    }
+    // limit the number of archive files waiting on disk
+    prefetchLimit = 2 * concurrentDownloads;
+    stopPrefetching = false;
+    for (int idx = 0; idx < concurrentDownloads; ++idx)
+    {
+        // cURL handles must not be shared between threads
+        prefetchThreads.push_back(thread(&PackageInstallerImpl::PrefetchThread, this, WebSession::Create(nullptr)));
+    }
+}
+
+void PackageInstallerImpl::StopPrefetching()
+{
+    {
+        lock_guard<mutex> lockGuard(prefetchMutex);
+        stopPrefetching = true;
+    }
+    prefetchCondition.notify_all();
+    for (thread& t : prefetchThreads)
+    {
+        t.join();
+    }
+    prefetchThreads.clear();
+    prefetchQueue.clear();
+    prefetchedArchives.clear();
+}
+
+void PackageInstallerImpl::PrefetchThread(shared_ptr<WebSession> webSession)
+{
+    while (true)
+    {
+        shared_ptr<PrefetchedArchive> archive;
+        {
+            unique_lock<mutex> lock(prefetchMutex);
+            prefetchCondition.wait(lock, [this] { return stopPrefetching || (!prefetchQueue.empty() && prefetchedArchives.size() < prefetchLimit); });
+            if (stopPrefetching)
+            {
+                break;
+            }
+            archive = prefetchQueue.front();
+            prefetchQueue.pop_front();
+            prefetchedArchives[archive->packageId] = archive;
+        }
+        try
+        {
+            Prefetch(webSession.get(), *archive);
+        }
+        catch (const exception&)
+        {
+            archive->temporaryFile = nullptr;
+            archive->error = current_exception();
+        }
+        {
+            lock_guard<mutex> lockGuard(prefetchMutex);
+            archive->done = true;
+        }
+        prefetchCondition.notify_all();
+    }
+    webSession->Dispose();
+}
+
+void PackageInstallerImpl::Prefetch(WebSession* webSession, PrefetchedArchive& archive)
+{
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("prefetching {0}"), Q_(archive.url)));
+    archive.temporaryFile = TemporaryFile::Create();
+    unique_ptr<WebFile> webFile(webSession->OpenUrl(archive.url));
+    unique_ptr<BufferedStream> destStream = BufferedStream::Create(archive.temporaryFile->GetPathName(), BufferedStream::DefaultBufferSize, { BufferedStreamOption::WriteBehind });
+    MD5Builder md5Builder;
+    char buf[32 * 1024];
+    size_t n;
+    size_t received = 0;
+    while (!stopPrefetching && (n = webFile->Read(buf, sizeof(buf))) > 0)
+    {
+        destStream->Write(buf, n);
+        md5Builder.Update(buf, n);
+        received += n;
+        lock_guard<mutex> lockGuard(progressIndicatorMutex);
+        progressInfo.cbDownloadCompleted += n;
+    }
+    destStream->Close();
+    webFile->Close();
+    if (stopPrefetching)
+    {
+        // the archive file will not be used
+        archive.temporaryFile = nullptr;
+        return;
+    }
+    if (archive.expectedSize > 0 && archive.expectedSize != received)
+    {
+        MIKTEX_FATAL_ERROR_2(FatalError(ERROR_SIZE_MISMATCH), "url", archive.url, "expectecSize", std::to_string(archive.expectedSize), "received", std::to_string(received));
+    }
+    MD5 digest = md5Builder.Final();
+    if (digest != archive.expectedDigest)
+    {
+        MIKTEX_FATAL_ERROR_2(FatalError(ERROR_CORRUPTED_PACKAGE), "package", archive.packageId, "url", archive.url, "expectedMD5", archive.expectedDigest.ToString(), "actualMD5", digest.ToString());
+    }
+}
+
+// the archive file data is received while the extractor reads it: the digest
+// is computed on the fly; the data can also be written to a file
+class ExtractingDownloadStream :
+    public Stream
+{
+
+public:
+
+    ExtractingDownloadStream(WebFile* webFile, Stream* teeStream, function<void(size_t)> onReceived) :
+        webFile(webFile),
+        teeStream(teeStream),
+        onReceived(onReceived)
+    {
+    }
+
+    size_t Read(void* data, size_t count) override
+    {
+        // the extractor expects full reads
+        size_t total = 0;
+        while (total < count)
+        {
+            size_t n = webFile->Read(static_cast<char*>(data) + total, count - total);
+            if (n == 0)
+            {
+                break;
+            }
+            md5Builder.Update(static_cast<char*>(data) + total, n);
+            if (teeStream != nullptr)
+            {
+                teeStream->Write(static_cast<char*>(data) + total, n);
+            }
+            received += n;
+            onReceived(n);
+            total += n;
+        }
+        return total;
+    }
+
+    void Write(const void* data, size_t count) override
+    {
+        UNIMPLEMENTED();
+    }
+
+    void Seek(long offset, SeekOrigin seekOrigin) override
+    {
+        UNIMPLEMENTED();
+    }
+
+    long GetPosition() const override
+    {
+        return static_cast<long>(received);
+    }
+
+    /// Reads the data which follows the compressed data.
+    void Drain()
+    {
+        char buf[32 * 1024];
+        while (Read(buf, sizeof(buf)) > 0)
+        {
+        }
+    }
+
+    size_t GetReceived() const
+    {
+        return received;
+    }
+
+    MD5 GetDigest()
+    {
+        return md5Builder.Final();
+    }
+
+private:
+
+    WebFile* webFile;
+    Stream* teeStream;
+    function<void(size_t)> onReceived;
+    MD5Builder md5Builder;
+    size_t received = 0;
+};
+
+bool PackageInstallerImpl::ExtractWhileDownloading(const string& packageId, ArchiveFileType archiveFileType, const string& url, const PathName& teeFile)
+{
+    ReportLine(fmt::format(T_("downloading and extracting {0}..."), Q_(url)));
+    size_t expectedSize = repositoryManifest.GetArchiveFileSize(packageId);
+    MD5 expectedDigest = repositoryManifest.GetArchiveFileDigest(packageId);
+    PathName newTeeFile;
+    if (!teeFile.Empty())
+    {
+        Directory::Create(teeFile.GetDirectoryName());
+        // other processes must not see a partially written archive file
+        newTeeFile = teeFile;
+        newTeeFile.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+    }
+    // the package is not installed yet, i.e., the extracted files belong to
+    // no other package
+    auto rollBack = [this, &newTeeFile]()
+    {
+        for (const PathName& f : installedFiles)
+        {
+            if (File::Exists(f))
+            {
+                File::Delete(f, { FileDeleteOption::TryHard });
+            }
+        }
+        installedFiles.clear();
+        if (!newTeeFile.Empty() && File::Exists(newTeeFile))
+        {
+            File::Delete(newTeeFile, { FileDeleteOption::TryHard });
+        }
+        lock_guard<mutex> lockGuard(progressIndicatorMutex);
+        progressInfo.cbDownloadCompleted -= progressInfo.cbPackageDownloadCompleted;
+        progressInfo.cbPackageDownloadCompleted = 0;
+    };
+    try
+    {
+        unique_ptr<WebFile> webFile(packageManager->GetWebSession()->OpenUrl(url));
+        unique_ptr<BufferedStream> teeStream;
+        if (!newTeeFile.Empty())
+        {
+            teeStream = BufferedStream::Create(newTeeFile, BufferedStream::DefaultBufferSize, { BufferedStreamOption::WriteBehind });
+        }
+        ExtractingDownloadStream downloadStream(webFile.get(), teeStream.get(), [this](size_t n) {
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            progressInfo.cbPackageDownloadCompleted += n;
+            progressInfo.cbDownloadCompleted += n;
+        });
+        MiKTeX::Extractor::Extractor::CreateExtractor(archiveFileType)->Extract(&downloadStream, session->GetSpecialPath(SpecialPath::InstallRoot), true, this, TEXMF_PREFIX_DIRECTORY);
+        // the digest covers the whole archive file
+        downloadStream.Drain();
+        if (teeStream != nullptr)
+        {
+            teeStream->Close();
+        }
+        webFile->Close();
+        MD5 digest = downloadStream.GetDigest();
+        if ((expectedSize > 0 && expectedSize != downloadStream.GetReceived()) || digest != expectedDigest)
+        {
+            MIKTEX_FATAL_ERROR_2(FatalError(ERROR_CORRUPTED_PACKAGE), "package", packageId, "url", url, "expectedMD5", expectedDigest.ToString(), "actualMD5", digest.ToString());
+        }
+        if (!newTeeFile.Empty())
+        {
+            File::Move(newTeeFile, teeFile, { FileMoveOption::ReplaceExisting });
+        }
+        return true;
+    }
+    catch (const OperationCancelledException&)
+    {
+        rollBack();
+        throw;
+    }
+    catch (const MiKTeXException& e)
+    {
+        // the archive file is downloaded again
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("{0}: extracting while downloading did not succeed: {1}"), packageId, e.GetErrorMessage()));
+        rollBack();
+        return false;
+    }
+}
+
+PathName PackageInstallerImpl::GetCachedArchiveFile(const string& packageId)
+{
+    string cacheDirectory = session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_ARCHIVE_CACHE_DIRECTORY, ConfigValue("")).GetString();
+    if (cacheDirectory.empty())
+    {
+        return PathName();
+    }
+    // archive files are named by their contents: the same file name can be
+    // used by different repositories and by different package versions
+    PathName cachedArchiveFile = PathName(cacheDirectory) / repositoryManifest.GetArchiveFileDigest(packageId).ToString();
+    cachedArchiveFile.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(repositoryManifest.GetArchiveFileType(packageId)));
+    return cachedArchiveFile;
+}
+
+void PackageInstallerImpl::AddToArchiveCache(const string& packageId, const PathName& archiveFile)
+{
+    PathName cachedArchiveFile = GetCachedArchiveFile(packageId);
+    if (cachedArchiveFile.Empty() || File::Exists(cachedArchiveFile))
+    {
+        return;
+    }
+    try
+    {
+        Directory::Create(cachedArchiveFile.GetDirectoryName());
+        // other processes must not see a partially written archive file
+        PathName newFile = cachedArchiveFile;
+        newFile.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        File::Copy(archiveFile, newFile);
+        File::Move(newFile, cachedArchiveFile, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const MiKTeXException& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("{0} cannot be cached: {1}"), Q_(archiveFile), e.GetErrorMessage()));
+    }
+}
+
+unique_ptr<TemporaryFile> PackageInstallerImpl::TakePrefetchedArchive(const string& packageId)
+{
+    shared_ptr<PrefetchedArchive> archive;
+    {
+        unique_lock<mutex> lock(prefetchMutex);
+        auto it = prefetchedArchives.find(packageId);
+        if (it == prefetchedArchives.end())
+        {
+            // not started yet: the caller downloads the archive file
+            auto it2 = find_if(prefetchQueue.begin(), prefetchQueue.end(), [&packageId](const shared_ptr<PrefetchedArchive>& a) { return a->packageId == packageId; });
+            if (it2 != prefetchQueue.end())
+            {
+                prefetchQueue.erase(it2);
+            }
+            return nullptr;
+        }
+        archive = it->second;
+        prefetchCondition.wait(lock, [&archive] { return archive->done; });
+        prefetchedArchives.erase(it);
+    }
+    prefetchCondition.notify_all();
+    if (archive->error != nullptr)
+    {
+        try
+        {
+            rethrow_exception(archive->error);
+        }
+        catch (const MiKTeXException& e)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("prefetching {0} failed: {1}"), Q_(archive->url), e.GetErrorMessage()));
+        }
+        catch (const exception& e)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("prefetching {0} failed: {1}"), Q_(archive->url), e.what()));
+        }
+        return nullptr;
+    }
+    return std::move(archive->temporaryFile);
+}
+
 void PackageInstallerImpl::OnBeginFileExtraction(const string& fileName, size_t uncompressedSize)
 {
     UNUSED_ALWAYS(uncompressedSize);
@@ -274,8 +888,7 @@ void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
         NeedRepository();
         if (repositoryType == RepositoryType::Unknown)
         {
-            repository = packageManager->PickRepositoryUrl();
-            repositoryType = RepositoryType::Remote;
+            PickRepository();
         }
 
         ReportLine(fmt::format(T_("visiting repository {0}..."), Q_(repository)));
@@ -317,8 +930,44 @@ void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
             / MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME_NO_SUFFIX;
     }
 
+    // we need a temporary file when we download from the Internet
+    unique_ptr<TemporaryFile> temporaryFile;
+
+    string url;
+    PathName validatorsFile = cacheDirectory / VALIDATORS_FILE_NAME;
+    WebFileValidators validators;
+
+    // the cached manifest is still valid, if the server says so
+    bool unchanged = false;
+
+    if (!fromCache && repositoryType == RepositoryType::Remote)
+    {
+        ReportLine(T_("loading package repository manifest..."));
+
+        // create a temporary file
+        temporaryFile = TemporaryFile::Create();
+
+        // update progress indicator
+        {
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            progressInfo.packageId = MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME_NO_SUFFIX;
+            progressInfo.displayName = T_("Package repository manifest");
+            progressInfo.cbPackageDownloadCompleted = 0;
+            progressInfo.cbPackageDownloadTotal = ZZDB1_SIZE;
+        }
+
+        // download the database file
+        url = MakeUrl(MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME);
+        string stamp;
+        if (File::Exists(cacheDirectory / MIKTEX_MPM_INI_FILENAME))
+        {
+            validators = ReadValidators(validatorsFile, url, stamp);
+        }
+        unchanged = !DownloadIfModified(url, temporaryFile->GetPathName(), validators);
+    }
+
     // prepare the cache directory for writing
-    if (!fromCache)
+    if (!fromCache && !unchanged)
     {
         if (Directory::Exists(cacheDirectory))
         {
@@ -327,46 +976,32 @@ void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
         Directory::Create(cacheDirectory);
     }
 
-    if (fromCache)
+    if (fromCache || unchanged)
     {
     }
     else if (repositoryType == RepositoryType::Remote || repositoryType == RepositoryType::Local)
     {
-        // we need a temporary file when we download from the Internet
-        unique_ptr<TemporaryFile> temporaryFile;
-
-        ReportLine(T_("loading package repository manifest..."));
-
         // full path to the database file
         PathName pathZzdb1;
 
         // pick up the database file
         if (repositoryType == RepositoryType::Remote)
         {
-            // create a temporary file
-            temporaryFile = TemporaryFile::Create();
-
             pathZzdb1 = temporaryFile->GetPathName();
-
-            // update progress indicator
-            {
-                lock_guard<mutex> lockGuard(progressIndicatorMutex);
-                progressInfo.packageId = MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME_NO_SUFFIX;
-                progressInfo.displayName = T_("Package repository manifest");
-                progressInfo.cbPackageDownloadCompleted = 0;
-                progressInfo.cbPackageDownloadTotal = ZZDB1_SIZE;
-            }
-
-            // download the database file
-            Download(MakeUrl(MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME), temporaryFile->GetPathName());
         }
         else
         {
             MIKTEX_ASSERT(repositoryType == RepositoryType::Local);
+            ReportLine(T_("loading package repository manifest..."));
             pathZzdb1 = PathName(repository) / MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME;
         }
 
         MiKTeX::Extractor::Extractor::CreateExtractor(DB_ARCHIVE_FILE_TYPE)->Extract(pathZzdb1, cacheDirectory);
+
+        if (repositoryType == RepositoryType::Remote)
+        {
+            WriteValidators(validatorsFile, url, validators, "");
+        }
     }
     else if (repositoryType == RepositoryType::MiKTeXDirect)
     {
@@ -680,13 +1315,89 @@ void PackageInstallerImpl::FindUpgradesThread()
     }
 }
 
+void PackageInstallerImpl::DeleteDeferredFiles()
+{
+    set<PathName> directories;
+    for (const PathName& path : deferredFileDeletions)
+    {
+        // keep the files which have been extracted again
+        if (installedFiles.find(path) != installedFiles.end() || !File::Exists(path))
+        {
+            continue;
+        }
+        try
+        {
+            File::Delete(path, { FileDeleteOption::TryHard });
+            directories.insert(path.GetDirectoryName());
+        }
+        catch (const MiKTeXException& e)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("{0} cannot be deleted: {1}"), Q_(path), e.GetErrorMessage()));
+        }
+    }
+    deferredFileDeletions.clear();
+    for (const PathName& d : directories)
+    {
+        if (Directory::Exists(d))
+        {
+            Directory::RemoveEmptyDirectoryChain(d);
+        }
+    }
+}
+
 void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool silently)
 {
     set<PathName> directories;
-    for (const string& f : toBeRemoved)
+
+    auto completeRemoval = [&]()
     {
-        Notify(Notification::RemoveFileStart);
+        // update progress info
+        if (!silently)
+        {
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            progressInfo.cFilesRemoveCompleted += 1;
+        }
 
+        // notify client
+        Notify(Notification::RemoveFileEnd);
+    };
+
+    // the destructor of a future returned by async() waits for the delete
+    // operation
+    deque<pair<PathName, future<bool>>> pendingDeletions;
+
+    // wait for the oldest delete operation
+    auto completeDeletion = [&]()
+    {
+        PathName path = std::move(pendingDeletions.front().first);
+        future<bool> pendingDeletion = std::move(pendingDeletions.front().second);
+        pendingDeletions.pop_front();
+        try
+        {
+            if (pendingDeletion.get())
+            {
+                removedFiles.insert(path);
+                directories.insert(path.GetDirectoryName());
+            }
+            else
+            {
+                trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("file {0} does not exist"), Q_(path)));
+            }
+        }
+        catch (const MiKTeXException& e)
+        {
+            if (!silently)
+            {
+                MIKTEX_FATAL_ERROR_2(FatalError(ERROR_CANNOT_DELETE), "path", path.ToString(), "reason", e.GetErrorMessage());
+            }
+            Notify(Notification::RemoveFileEnd);
+            return;
+        }
+        completeRemoval();
+    };
+
+    for (const string& f : toBeRemoved)
+    {
         // only consider texmf files
         string fileName;
         if (!PackageManager::StripTeXMFPrefix(f, fileName))
@@ -694,8 +1405,6 @@ void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool s
             continue;
         }
 
-        bool done = false;
-
         unsigned long refCount = packageDataStore->GetFileRefCount(PathName(f));
 
         // decrement the file reference counter
@@ -707,54 +1416,52 @@ void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool s
         // make an absolute path name
         PathName path(session->GetSpecialPath(SpecialPath::InstallRoot) / fileName);
 
+        if (pendingDeletions.size() >= MAX_CONCURRENT_FILE_DELETIONS)
+        {
+            completeDeletion();
+        }
+
+        Notify(Notification::RemoveFileStart);
+
         // only delete if the reference count reached zero
         if (refCount > 0)
         {
             trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("will not delete {0} (ref count is {1})"), Q_(path), refCount));
-            done = true;
+            completeRemoval();
         }
-        else if (File::Exists(path))
+        else if (deferFileDeletion)
         {
-            // remove the file
-            try
-            {
-                File::Delete(path, { FileDeleteOption::TryHard });
-                removedFiles.insert(path);
-                directories.insert(path.GetDirectoryName());
-                done = true;
-            }
-            catch (const MiKTeXException& e)
-            {
-                done = false;
-                if (!silently)
-                {
-                    MIKTEX_FATAL_ERROR_2(FatalError(ERROR_CANNOT_DELETE), "path", path.ToString(), "reason", e.GetErrorMessage());
-                }
-            }
+            // the file might be part of the new package version
+            deferredFileDeletions.push_back(path);
+            removedFiles.insert(path);
+            completeRemoval();
         }
         else
         {
-            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("file {0} does not exist"), Q_(path)));
-            done = true;
+            pendingDeletions.push_back({ path, async(launch::async, [path]()
+            {
+                if (!File::Exists(path))
+                {
+                    return false;
+                }
+                File::Delete(path, { FileDeleteOption::TryHard });
+                return true;
+            }) });
         }
+    }
 
-        // update progress info
-        if (done && !silently)
-        {
-            lock_guard<mutex> lockGuard(progressIndicatorMutex);
-            progressInfo.cFilesRemoveCompleted += 1;
-        }
+    while (!pendingDeletions.empty())
+    {
+        completeDeletion();
+    }
 
-        for (const PathName& d : directories)
+    // remove empty directories, once all files are gone
+    for (const PathName& d : directories)
+    {
+        if (Directory::Exists(d))
         {
-            if (Directory::Exists(d))
-            {
-                Directory::RemoveEmptyDirectoryChain(d);
-            }
+            Directory::RemoveEmptyDirectoryChain(d);
         }
-
-        // notify client
-        Notify(Notification::RemoveFileEnd);
     }
 }
 
@@ -780,10 +1487,23 @@ void PackageInstallerImpl::RemovePackage(const string& packageId, Cfg& packageMa
     packageDataStore->SaveVarData();
 
     // remove the files
-    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to remove {0} file(s)"), package.runFiles.size() + package.docFiles.size() + package.sourceFiles.size()));
-    RemoveFiles(package.runFiles);
-    RemoveFiles(package.docFiles);
-    RemoveFiles(package.sourceFiles);
+    vector<string> files = package.runFiles;
+    files.insert(files.end(), package.docFiles.begin(), package.docFiles.end());
+    files.insert(files.end(), package.sourceFiles.begin(), package.sourceFiles.end());
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to remove {0} file(s)"), files.size()));
+    removedFiles.clear();
+    RemoveFiles(files);
+
+    // update file name database; the MPM file name database keeps the
+    // files, because the package can be installed again
+    if (batchingFndbChanges)
+    {
+        RecordFndbChanges(installRootFndbChanges, {}, removedFiles, "");
+    }
+    else
+    {
+        UpdateFndb({}, removedFiles, "");
+    }
 
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package {0} successfully removed"), Q_(packageId)));
 
@@ -797,7 +1517,7 @@ void PackageInstallerImpl::RemovePackage(const string& packageId, Cfg& packageMa
     Notify(Notification::RemovePackageEnd);
 }
 
-void PackageInstallerImpl::MyCopyFile(const PathName& source, const PathName& dest, size_t& size)
+FILE* PackageInstallerImpl::OpenDestinationFile(const PathName& dest)
 {
     // reset the read-only attribute, if the destination file exists
     if (File::Exists(dest))
@@ -827,47 +1547,125 @@ void PackageInstallerImpl::MyCopyFile(const PathName& source, const PathName& de
     {
         try
         {
-            destinationFile = File::Open(dest, FileMode::Create, FileAccess::Write, false);
+            destinationFile = File::Open(dest, FileMode::Create, FileAccess::Write, false);
+        }
+        catch (const MiKTeXException& e)
+        {
+            ostringstream text;
+            text
+                << T_("The following file could not be written:")
+                << LF
+                << LF
+                << "  " << dest.GetData()
+                << LF
+                << LF
+                << T_("The write operation failed for the following reason:")
+                << LF
+                << LF
+                << "  " << e.GetErrorMessage()
+                << LF
+                << LF
+                << T_("Make sure that no other application uses the file and that you have write permission on the file.");
+            if (AbortOrRetry(text.str().c_str()))
+            {
+                throw;
+            }
+            destinationFile = nullptr;
+        }
+    } while (destinationFile == nullptr);
+
+    return destinationFile;
+}
+
+size_t PackageInstallerImpl::CopyFileData(FileStream& fromStream, FileStream& toStream)
+{
+    size_t size = 0;
+#if defined(HAVE_COPY_FILE_RANGE) || (defined(HAVE_SENDFILE) && defined(MIKTEX_LINUX))
+    // let the kernel copy the data (this might even share the data blocks,
+    // e.g., on Btrfs/XFS)
+    int fromFd = fileno(fromStream.GetFile());
+    int toFd = fileno(toStream.GetFile());
+    bool useKernel = true;
+#if defined(HAVE_COPY_FILE_RANGE)
+    while (useKernel)
+    {
+        ssize_t n = copy_file_range(fromFd, nullptr, toFd, nullptr, COPY_BUFFER_SIZE, 0);
+        if (n > 0)
+        {
+            size += n;
+        }
+        else if (n == 0)
+        {
+            return size;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (size == 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP || errno == EBADF))
+        {
+            useKernel = false;
+        }
+        else
+        {
+            MIKTEX_FATAL_CRT_ERROR("copy_file_range");
+        }
+    }
+    useKernel = true;
+#endif
+#if defined(HAVE_SENDFILE) && defined(MIKTEX_LINUX)
+    while (useKernel)
+    {
+        ssize_t n = sendfile(toFd, fromFd, nullptr, COPY_BUFFER_SIZE);
+        if (n > 0)
+        {
+            size += n;
+        }
+        else if (n == 0)
+        {
+            return size;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (size == 0 && (errno == ENOSYS || errno == EINVAL))
+        {
+            useKernel = false;
         }
-        catch (const MiKTeXException& e)
+        else
         {
-            ostringstream text;
-            text
-                << T_("The following file could not be written:")
-                << LF
-                << LF
-                << "  " << dest.GetData()
-                << LF
-                << LF
-                << T_("The write operation failed for the following reason:")
-                << LF
-                << LF
-                << "  " << e.GetErrorMessage()
-                << LF
-                << LF
-                << T_("Make sure that no other application uses the file and that you have write permission on the file.");
-            if (AbortOrRetry(text.str().c_str()))
-            {
-                throw;
-            }
-            destinationFile = nullptr;
+            MIKTEX_FATAL_CRT_ERROR("sendfile");
         }
-    } while (destinationFile == nullptr);
+    }
+#endif
+#elif defined(HAVE_FCOPYFILE)
+    int toFd = fileno(toStream.GetFile());
+    struct stat toStat;
+    if (fcopyfile(fileno(fromStream.GetFile()), toFd, nullptr, COPYFILE_DATA) == 0 && fstat(toFd, &toStat) == 0)
+    {
+        return toStat.st_size;
+    }
+#endif
+    unique_ptr<char[]> buffer(new char[COPY_BUFFER_SIZE]);
+    size_t n;
+    while ((n = fromStream.Read(buffer.get(), COPY_BUFFER_SIZE)) > 0)
+    {
+        toStream.Write(buffer.get(), n);
+        size += n;
+    }
+    return size;
+}
 
-    FileStream toStream(destinationFile);
+void PackageInstallerImpl::MyCopyFile(const PathName& source, const PathName& dest, size_t& size)
+{
+    FileStream toStream(OpenDestinationFile(dest));
 
     // open the source file
     FileStream fromStream(File::Open(source, FileMode::Open, FileAccess::Read, false));
 
     // copy the file
-    char buffer[4096];
-    size_t n;
-    size = 0;
-    while ((n = fromStream.Read(buffer, 4096)) > 0)
-    {
-        toStream.Write(buffer, n);
-        size += n;
-    }
+    size = CopyFileData(fromStream, toStream);
 
     fromStream.Close();
     toStream.Close();
@@ -877,6 +1675,30 @@ void PackageInstallerImpl::MyCopyFile(const PathName& source, const PathName& de
 
 void PackageInstallerImpl::CopyFiles(const PathName& pathSourceRoot, const vector<string>& fileList)
 {
+    // the destructor of a future returned by async() waits for the copy
+    // operation
+    deque<future<size_t>> pendingCopies;
+
+    // wait for the oldest copy operation
+    auto completeCopy = [&]()
+    {
+        future<size_t> pendingCopy = std::move(pendingCopies.front());
+        pendingCopies.pop_front();
+        size_t size = pendingCopy.get();
+
+        // update progress info
+        {
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            progressInfo.cFilesPackageInstallCompleted += 1;
+            progressInfo.cFilesInstallCompleted += 1;
+            progressInfo.cbPackageInstallCompleted += size;
+            progressInfo.cbInstallCompleted += size;
+        }
+
+        // notify client: end of file copy operation
+        Notify(Notification::InstallFileEnd);
+    };
+
     for (const string& f : fileList)
     {
         Notify();
@@ -900,6 +1722,11 @@ void PackageInstallerImpl::CopyFiles(const PathName& pathSourceRoot, const vecto
         PathName pathDestFolder(pathDest);
         pathDestFolder.RemoveFileSpec();
 
+        if (pendingCopies.size() >= MAX_CONCURRENT_FILE_COPIES)
+        {
+            completeCopy();
+        }
+
         // notify client: beginning of file copy operation
         Notify(Notification::InstallFileStart);
 
@@ -911,23 +1738,29 @@ void PackageInstallerImpl::CopyFiles(const PathName& pathSourceRoot, const vecto
             progressInfo.fileName = pathDest;
         }
 
-        size_t size;
+        // open the files; the user might be asked to retry
+        shared_ptr<FileStream> toStream = make_shared<FileStream>(OpenDestinationFile(pathDest));
+        shared_ptr<FileStream> fromStream = make_shared<FileStream>(File::Open(pathSource, FileMode::Open, FileAccess::Read, false));
+        installedFiles.insert(pathDest);
 
         // copy the file
-        MyCopyFile(pathSource, pathDest, size);
-
-        // update progress info
+        pendingCopies.push_back(async(launch::async, [fromStream, toStream]()
         {
-            lock_guard<mutex> lockGuard(progressIndicatorMutex);
-            progressInfo.fileName = "";
-            progressInfo.cFilesPackageInstallCompleted += 1;
-            progressInfo.cFilesInstallCompleted += 1;
-            progressInfo.cbPackageInstallCompleted += size;
-            progressInfo.cbInstallCompleted += size;
-        }
+            size_t size = CopyFileData(*fromStream, *toStream);
+            fromStream->Close();
+            toStream->Close();
+            return size;
+        }));
+    }
 
-        // notify client: end of file copy operation
-        Notify(Notification::InstallFileEnd);
+    while (!pendingCopies.empty())
+    {
+        completeCopy();
+    }
+
+    {
+        lock_guard<mutex> lockGuard(progressIndicatorMutex);
+        progressInfo.fileName = "";
     }
 }
 
@@ -983,25 +1816,55 @@ MPMSTATICFUNC(unordered_set<PathName>) GetFiles(const PathName& rootDir, const P
 
 void PackageInstallerImpl::UpdateFndb(const unordered_set<PathName>& installedFiles, const unordered_set<PathName>& removedFiles, const string& packageId)
 {
-    vector<PathName> toBeRemoved;
+    unordered_map<PathName, string> installed;
+    for (const PathName& f : installedFiles)
+    {
+        installed[f] = packageId;
+    }
+    unordered_map<PathName, string> removed;
     for (const PathName& f : removedFiles)
     {
-        if (installedFiles.find(f) == installedFiles.end() && Fndb::FileExists(f))
+        removed[f] = packageId;
+    }
+    UpdateFndb(installed, removed);
+}
+
+void PackageInstallerImpl::UpdateFndb(const unordered_map<PathName, string>& installedFiles, const unordered_map<PathName, string>& removedFiles)
+{
+    // all removals come first: a file can move from one package to another
+    vector<PathName> toBeRemoved;
+    for (const auto& r : removedFiles)
+    {
+        auto it = installedFiles.find(r.first);
+        if ((it == installedFiles.end() || it->second != r.second) && Fndb::FileExists(r.first))
         {
-            toBeRemoved.push_back(f);
+            toBeRemoved.push_back(r.first);
         }
     }
     if (!toBeRemoved.empty())
     {
         Fndb::Remove(toBeRemoved);
     }
+    vector<PathName> toBeReplaced;
     vector<Fndb::Record> toBeAdded;
-    for (const PathName& f : installedFiles)
+    for (const auto& i : installedFiles)
     {
-        if (!Fndb::FileExists(f))
+        if (Fndb::FileExists(i.first))
         {
-            toBeAdded.push_back({ f, packageId });
+            auto it = removedFiles.find(i.first);
+            // the install root database does not record owners
+            if ((it != removedFiles.end() && it->second == i.second) || i.second.empty())
+            {
+                continue;
+            }
+            // owned by another package: the record must be replaced
+            toBeReplaced.push_back(i.first);
         }
+        toBeAdded.push_back({ i.first, i.second });
+    }
+    if (!toBeReplaced.empty())
+    {
+        Fndb::Remove(toBeReplaced);
     }
     if (!toBeAdded.empty())
     {
@@ -1009,6 +1872,82 @@ void PackageInstallerImpl::UpdateFndb(const unordered_set<PathName>& installedFi
     }
 }
 
+void PackageInstallerImpl::RecordFndbChanges(FndbChanges& changes, const unordered_set<PathName>& installedFiles, const unordered_set<PathName>& removedFiles, const string& packageId)
+{
+    for (const PathName& f : removedFiles)
+    {
+        if (installedFiles.find(f) == installedFiles.end())
+        {
+            changes.toBeAdded.erase(f);
+            changes.toBeRemoved.insert(f);
+        }
+    }
+    for (const PathName& f : installedFiles)
+    {
+        changes.toBeRemoved.erase(f);
+        changes.toBeAdded[f] = packageId;
+    }
+}
+
+void PackageInstallerImpl::ApplyFndbChanges(FndbChanges& changes, bool mpmRoot)
+{
+    size_t numChanges = changes.toBeAdded.size() + changes.toBeRemoved.size();
+    if (numChanges == 0)
+    {
+        return;
+    }
+    unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "applying file name database changes");
+    if (numChanges > MAX_BATCHED_FNDB_CHANGES)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("{0} file name database changes: rebuilding the file name database"), numChanges));
+        if (mpmRoot)
+        {
+            packageManager->CreateMpmFndbNoLock();
+        }
+        else
+        {
+            Fndb::Refresh(session->GetSpecialPath(SpecialPath::InstallRoot), nullptr);
+        }
+    }
+    else
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("applying {0} file name database changes"), numChanges));
+        vector<PathName> toBeRemoved;
+        for (const PathName& f : changes.toBeRemoved)
+        {
+            if (Fndb::FileExists(f))
+            {
+                toBeRemoved.push_back(f);
+            }
+        }
+        if (!toBeRemoved.empty())
+        {
+            Fndb::Remove(toBeRemoved);
+        }
+        vector<Fndb::Record> toBeAdded;
+        for (const auto& p : changes.toBeAdded)
+        {
+            if (!Fndb::FileExists(p.first))
+            {
+                toBeAdded.push_back({ p.first, p.second });
+            }
+        }
+        if (!toBeAdded.empty())
+        {
+            Fndb::Add(toBeAdded);
+        }
+    }
+    changes.toBeAdded.clear();
+    changes.toBeRemoved.clear();
+}
+
+void PackageInstallerImpl::ApplyPendingFndbChanges()
+{
+    batchingFndbChanges = false;
+    ApplyFndbChanges(installRootFndbChanges, false);
+    ApplyFndbChanges(mpmRootFndbChanges, true);
+}
+
 void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageManifests)
 {
     trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("installing package {0}"), Q_(packageId)));
@@ -1040,6 +1979,12 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
     PathName pathArchiveFile;
     ArchiveFileType aft = repositoryManifest.GetArchiveFileType(packageId);
     unique_ptr<TemporaryFile> temporaryFile;
+    bool verified = false;
+    bool extracted = false;
+
+    installedFiles.clear();
+    removedFiles.clear();
+    deferredFileDeletions.clear();
 
     // get hold of the archive file
     if (repositoryType == RepositoryType::Remote
@@ -1050,10 +1995,72 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
 
         if (repositoryType == RepositoryType::Remote)
         {
-            // take hold of the package
-            temporaryFile = TemporaryFile::Create();
-            pathArchiveFile = temporaryFile->GetPathName();
-            Download(MakeUrl(packageFileName.ToString()), temporaryFile->GetPathName());
+            PathName cachedArchiveFile = GetCachedArchiveFile(packageId);
+            if (!cachedArchiveFile.Empty() && File::Exists(cachedArchiveFile) && CheckArchiveFile(packageId, cachedArchiveFile, false))
+            {
+                verified = true;
+                pathArchiveFile = cachedArchiveFile;
+                ReportLine(fmt::format(T_("using cached archive file {0}"), Q_(cachedArchiveFile)));
+                lock_guard<mutex> lockGuard(progressIndicatorMutex);
+                progressInfo.cbPackageDownloadCompleted = progressInfo.cbPackageDownloadTotal;
+            }
+            else if ((temporaryFile = TakePrefetchedArchive(packageId)) != nullptr)
+            {
+                // the digest has been checked by the prefetching thread
+                verified = true;
+                pathArchiveFile = temporaryFile->GetPathName();
+                ReportLine(fmt::format(T_("downloaded {0}"), Q_(packageFileName)));
+                lock_guard<mutex> lockGuard(progressIndicatorMutex);
+                progressInfo.cbPackageDownloadCompleted = progressInfo.cbPackageDownloadTotal;
+            }
+            else if (!package.IsInstalled()
+                && (aft == ArchiveFileType::TarLzma || aft == ArchiveFileType::Tar)
+                && session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_EXTRACT_WHILE_DOWNLOADING, ConfigValue(true)).GetBool()
+                && ExtractWhileDownloading(packageId, aft, MakeUrl(packageFileName.ToString()), cachedArchiveFile))
+            {
+                // the archive file is neither written nor read again (unless
+                // it is cached)
+                extracted = true;
+                verified = true;
+            }
+            else if (!cachedArchiveFile.Empty())
+            {
+                // continue an interrupted download (of this or of another
+                // process)
+                PathName partialFile = cachedArchiveFile;
+                partialFile.AppendExtension(".partial");
+                Directory::Create(partialFile.GetDirectoryName());
+                PathName lockPath = partialFile;
+                lockPath.AppendExtension(".lock");
+                unique_ptr<LockFile> partialFileLock = LockFile::Create(lockPath);
+                if (!partialFileLock->TryLock(0ms))
+                {
+                    // another process is downloading the same archive file
+                    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} is locked"), Q_(partialFile)));
+                }
+                else
+                {
+                    Download(MakeUrl(packageFileName.ToString()), partialFile, repositoryManifest.GetArchiveFileSize(packageId), true);
+                    if (CheckArchiveFile(packageId, partialFile, false))
+                    {
+                        verified = true;
+                        File::Move(partialFile, cachedArchiveFile, { FileMoveOption::ReplaceExisting });
+                        pathArchiveFile = cachedArchiveFile;
+                    }
+                    else
+                    {
+                        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("discarding {0}"), Q_(partialFile)));
+                        File::Delete(partialFile);
+                    }
+                    partialFileLock->Unlock();
+                }
+            }
+            if (pathArchiveFile.Empty() && !extracted)
+            {
+                temporaryFile = TemporaryFile::Create();
+                pathArchiveFile = temporaryFile->GetPathName();
+                Download(MakeUrl(packageFileName.ToString()), temporaryFile->GetPathName(), repositoryManifest.GetArchiveFileSize(packageId));
+            }
         }
         else
         {
@@ -1063,24 +2070,31 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
         }
 
         // check to see whether the digest is good
-        if (!CheckArchiveFile(packageId, pathArchiveFile, false))
+        if (!verified && !CheckArchiveFile(packageId, pathArchiveFile, false))
         {
             LoadRepositoryManifest(true);
             CheckArchiveFile(packageId, pathArchiveFile, true);
         }
-    }
 
-    installedFiles.clear();
-    removedFiles.clear();
+        if (temporaryFile != nullptr)
+        {
+            AddToArchiveCache(packageId, pathArchiveFile);
+        }
+    }
 
     // silently uninstall the package (this also decrements the file
     // reference counts)
     if (package.IsInstalled())
     {
         trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("{0}: removing old files"), packageId));
-        RemoveFiles(package.runFiles, true);
-        RemoveFiles(package.docFiles, true);
-        RemoveFiles(package.sourceFiles, true);
+        // old files stay on disk until the archive file has been extracted:
+        // unchanged files are then not written again
+        deferFileDeletion = repositoryType == RepositoryType::Remote || repositoryType == RepositoryType::Local;
+        vector<string> files = package.runFiles;
+        files.insert(files.end(), package.docFiles.begin(), package.docFiles.end());
+        files.insert(files.end(), package.sourceFiles.begin(), package.sourceFiles.end());
+        RemoveFiles(files, true);
+        deferFileDeletion = false;
         // temporarily set the status to "not installed"
         packageDataStore->SetTimeInstalled(packageId, InvalidTimeT);
         packageDataStore->SaveVarData();
@@ -1088,9 +2102,13 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
 
     if (repositoryType == RepositoryType::Remote || repositoryType == RepositoryType::Local)
     {
-        // unpack the archive file
-        ReportLine(fmt::format(T_("extracting files from {0}..."), Q_(packageId + MiKTeX::Extractor::Extractor::GetFileNameExtension(aft))));
-        ExtractFiles(pathArchiveFile, aft);
+        if (!extracted)
+        {
+            // unpack the archive file
+            ReportLine(fmt::format(T_("extracting files from {0}..."), Q_(packageId + MiKTeX::Extractor::Extractor::GetFileNameExtension(aft))));
+            ExtractFiles(pathArchiveFile, aft);
+        }
+        DeleteDeferredFiles();
     }
     else if (repositoryType == RepositoryType::MiKTeXDirect)
     {
@@ -1124,8 +2142,16 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
     PackageManager::PutPackageManifest(packageManifests, newPackage, newPackage.timePackaged);
 
     // update file name database
-    UpdateFndb(installedFiles, removedFiles, "");
-    UpdateFndb(GetFiles(session->GetMpmRootPath(), newPackage), GetFiles(session->GetMpmRootPath(), package), packageId);
+    if (batchingFndbChanges)
+    {
+        RecordFndbChanges(installRootFndbChanges, installedFiles, removedFiles, "");
+        RecordFndbChanges(mpmRootFndbChanges, GetFiles(session->GetMpmRootPath(), newPackage), GetFiles(session->GetMpmRootPath(), package), packageId);
+    }
+    else
+    {
+        UpdateFndb(installedFiles, removedFiles, "");
+        UpdateFndb(GetFiles(session->GetMpmRootPath(), newPackage), GetFiles(session->GetMpmRootPath(), package), packageId);
+    }
 
     // set the timeInstalled value => package is installed
     time_t now = time(nullptr);
@@ -1539,6 +2565,52 @@ void PackageInstallerImpl::RunOneMiKTeXUtility(const vector<string>& extraArgume
     Process::Run(oneMiKTeXUtility, arguments, this);
 }
 
+void PackageInstallerImpl::CompileOcps(const vector<string>& packages)
+{
+    vector<string> otpFiles;
+    for (const string& p : packages)
+    {
+        PackageInfo package = packageDataStore->GetPackage(p);
+        for (const string& f : package.runFiles)
+        {
+            string fileName;
+            if (!PackageManager::StripTeXMFPrefix(f, fileName) || !PathName(fileName).HasExtension(".otp"))
+            {
+                continue;
+            }
+            PathName path = session->GetSpecialPath(SpecialPath::InstallRoot) / fileName;
+            if (File::Exists(path))
+            {
+                otpFiles.push_back(path.ToString());
+            }
+        }
+    }
+    if (otpFiles.empty())
+    {
+        return;
+    }
+    PathName mkocp;
+    if (!session->FindFile(MIKTEX_MKOCP_EXE, FileType::EXE, mkocp))
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, T_("mkocp not found: OCP files will be created on demand"));
+        return;
+    }
+    ReportLine(fmt::format(T_("compiling {0} OCP file(s)"), otpFiles.size()));
+    // mkocp compiles in parallel; the command line is kept short
+    const size_t MAX_FILES_PER_RUN = 64;
+    for (size_t start = 0; start < otpFiles.size(); start += MAX_FILES_PER_RUN)
+    {
+        vector<string> arguments{ "mkocp", "--batch" };
+        arguments.insert(arguments.end(), otpFiles.begin() + start, otpFiles.begin() + (std::min)(start + MAX_FILES_PER_RUN, otpFiles.size()));
+        int exitCode;
+        // not fatal: missing OCP files are still created on demand
+        if (!Process::Run(mkocp, arguments, this, &exitCode, nullptr, nullptr) || exitCode != 0)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, T_("some OCP files could not be compiled"));
+        }
+    }
+}
+
 void PackageInstallerImpl::CheckDependencies(set<string>& packages, const string& packageId, bool force, int level)
 {
     if (level > 10)
@@ -1630,8 +2702,7 @@ void PackageInstallerImpl::InstallRemove(Role role)
         if (repositoryType == RepositoryType::Unknown)
         {
             // we must have a package repository
-            repository = packageManager->PickRepositoryUrl();
-            repositoryType = RepositoryType::Remote;
+            PickRepository();
         }
         else if (repositoryType == RepositoryType::Remote)
         {
@@ -1743,11 +2814,28 @@ void PackageInstallerImpl::InstallRemove(Role role)
             packageManifests->Read(packageManifestsIni);
         }
 
-        // install packages
-        for (const string& p : toBeInstalled)
+        // the file name database is updated at the end of the transaction;
+        // pending changes are applied even if the transaction fails, because
+        // the files of the installed packages are in place
+        batchingFndbChanges = batchFndbUpdates;
+        MIKTEX_AUTO(if (batchingFndbChanges) { ApplyPendingFndbChanges(); });
+
+        // install packages; archive files are downloaded ahead of their
+        // installation, the installation itself is sequential
+        StartPrefetching(toBeInstalled);
+        try
         {
-            InstallPackage(p, *packageManifests);
+            for (const string& p : toBeInstalled)
+            {
+                InstallPackage(p, *packageManifests);
+            }
+        }
+        catch (const exception&)
+        {
+            StopPrefetching();
+            throw;
         }
+        StopPrefetching();
 
         // remove packages
         for (const string& p : toBeRemoved)
@@ -1773,6 +2861,7 @@ void PackageInstallerImpl::InstallRemove(Role role)
         {
             InstallPackage(p, *packageManifests);
         }
+        ApplyPendingFndbChanges();
 
         if (File::Exists(packageManifestsIni))
         {
@@ -1780,6 +2869,10 @@ void PackageInstallerImpl::InstallRemove(Role role)
         }
 
         packageManifests = nullptr;
+
+        // the documentation files are indexed now, so that mthelp and the
+        // documentation browser do not have to search for them
+        DocumentationIndex::Write(DocumentationIndex::Build(*packageDataStore));
     }
     MPM_LOCK_END();
 
@@ -1790,6 +2883,7 @@ void PackageInstallerImpl::InstallRemove(Role role)
 
     if (enablePostProcessing)
     {
+        CompileOcps(toBeInstalled);
         RunOneMiKTeXUtility({ "fontmaps", "configure" });
         if (session->IsAdminMode())
         {
@@ -1881,8 +2975,7 @@ void PackageInstallerImpl::Download()
 
     if (repositoryType == RepositoryType::Unknown)
     {
-        repository = packageManager->PickRepositoryUrl();
-        repositoryType = RepositoryType::Remote;
+        PickRepository();
     }
 
     MIKTEX_ASSERT(repositoryType == RepositoryType::Remote);
@@ -2055,7 +3148,7 @@ void PackageInstallerImpl::CleanUpUserDatabase()
     userManifests->Write(userManifestsPath);
 }
 
-void PackageInstallerImpl::HandleObsoletePackageManifests(Cfg& existingManifests, const Cfg& newManifests)
+void PackageInstallerImpl::HandleObsoletePackageManifests(Cfg& existingManifests, const Cfg& newManifests, vector<PackageInfo>& removedPackages)
 {
     vector<string> toBeRemoved;
     for (auto keyExisting : existingManifests)
@@ -2085,6 +3178,7 @@ void PackageInstallerImpl::HandleObsoletePackageManifests(Cfg& existingManifests
             // not installed: remove the package manifest (later)
             trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("removing obsolete package manifest '{0}'"), packageId));
             toBeRemoved.push_back(packageId);
+            removedPackages.push_back(packageInfo);
         }
         else
         {
@@ -2139,8 +3233,7 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
     {
         if (repositoryType == RepositoryType::Unknown)
         {
-            repository = packageManager->PickRepositoryUrl();
-            repositoryType = RepositoryType::Remote;
+            PickRepository();
         }
         else if (repositoryType == RepositoryType::Remote)
         {
@@ -2177,8 +3270,34 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
             / MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME_NO_SUFFIX;
     }
 
+    // we need a temporary file if we download the archive file
+    unique_ptr<TemporaryFile> temporaryFile;
+
+    string url;
+    PathName validatorsFile = cacheDirectory / VALIDATORS_FILE_NAME;
+    WebFileValidators validators;
+
+    // identifies the package-manifests.ini which has been written after the
+    // archive file was downloaded
+    string validatorsStamp;
+
+    // the cached package-manifests.ini is still valid, if the server says so
+    bool unchanged = false;
+
+    if (!options[UpdateDbOption::FromCache] && repositoryType == RepositoryType::Remote)
+    {
+        // download the archive file
+        url = MakeUrl(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME);
+        temporaryFile = TemporaryFile::Create();
+        if (File::Exists(cacheDirectory / MIKTEX_PACKAGE_MANIFESTS_INI_FILENAME))
+        {
+            validators = ReadValidators(validatorsFile, url, validatorsStamp);
+        }
+        unchanged = !DownloadIfModified(url, temporaryFile->GetPathName(), validators);
+    }
+
     // prepare the cache directory for writing
-    if (!options[UpdateDbOption::FromCache])
+    if (!options[UpdateDbOption::FromCache] && !unchanged)
     {
         if (Directory::Exists(cacheDirectory))
         {
@@ -2187,19 +3306,13 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
         Directory::Create(cacheDirectory);
     }
 
-    if (!options[UpdateDbOption::FromCache])
+    if (!options[UpdateDbOption::FromCache] && !unchanged)
     {
-        // we need a temporary file if we download the archive file
-        unique_ptr<TemporaryFile> temporaryFile;
-
         PathName archivePath;
 
         if (repositoryType == RepositoryType::Remote)
         {
-            // download the archive file
-            temporaryFile = TemporaryFile::Create();
             archivePath = temporaryFile->GetPathName();
-            Download(MakeUrl(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME), archivePath);
         }
         else
         {
@@ -2211,6 +3324,26 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
         MiKTeX::Extractor::Extractor::CreateExtractor(DB_ARCHIVE_FILE_TYPE)->Extract(archivePath, cacheDirectory);
     }
 
+    PathName existingPackageManifestsIni = session->GetSpecialPath(SpecialPath::InstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
+
+    // the package manifests have already been merged: only the repository
+    // manifest may have changed
+    if (unchanged && !validatorsStamp.empty() && validatorsStamp == MakeFileStamp(existingPackageManifestsIni))
+    {
+        ReportLine(T_("package manifests are up-to-date"));
+        if (session->IsSharedSetup() && !session->IsAdminMode())
+        {
+            CleanUpUserDatabase();
+        }
+        InstallRepositoryManifest(false);
+        repositoryManifest.Clear();
+        session->SetConfigValue(
+            MIKTEX_CONFIG_SECTION_MPM,
+            session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_DB : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_DB,
+            ConfigValue(std::to_string(time(nullptr))));
+        return;
+    }
+
     // load cached package-manifests.ini
     unique_ptr<Cfg> newManifests = Cfg::Create();
 #if defined(WITH_PACKAGE_DB_SIGNING)
@@ -2223,13 +3356,20 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
     // load existing package-manifests.ini
     unique_ptr<Cfg> existingManifests = Cfg::Create();
     packageDataStore->NeedPackageManifestsIni();
-    PathName existingPackageManifestsIni = session->GetSpecialPath(SpecialPath::InstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
     if (File::Exists(existingPackageManifestsIni))
     {
         existingManifests->Read(existingPackageManifestsIni);
     }
 
-    HandleObsoletePackageManifests(*existingManifests, *newManifests);
+    // package manifests which have been changed: old and new version
+    vector<pair<PackageInfo, PackageInfo>> changedPackages;
+
+    vector<PackageInfo> removedPackages;
+    HandleObsoletePackageManifests(*existingManifests, *newManifests, removedPackages);
+    for (const PackageInfo& packageInfo : removedPackages)
+    {
+        changedPackages.push_back(make_pair(packageInfo, PackageInfo()));
+    }
 
     // update the package manifests
     ReportLine(fmt::format(T_("updating package manifests ({0})..."), Q_(existingPackageManifestsIni)));
@@ -2262,6 +3402,11 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
         // update the package table
         packageDataStore->DefinePackage(packageInfo);
 
+        if (!knownPackage || existingPackage.digest != packageInfo.digest)
+        {
+            changedPackages.push_back(make_pair(knownPackage ? existingPackage : PackageInfo(), packageInfo));
+        }
+
         ++count;
     }
 
@@ -2284,11 +3429,39 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
     packageManager->ClearAll();
     packageDataStore->Load();
 
-    // create the MPM file name database
-    packageManager->CreateMpmFndbNoLock();
+    // update the MPM file name database; rebuild it, if most of the
+    // packages have changed
+    if (File::Exists(session->GetMpmDatabasePathName()) && changedPackages.size() < MAX_INCREMENTAL_MPM_FNDB_UPDATES)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("applying {0} package manifest changes to the MPM file name database"), changedPackages.size()));
+        // the changes are applied at once: a file can move between two
+        // changed packages
+        unordered_map<PathName, string> installedFiles;
+        unordered_map<PathName, string> removedFiles;
+        for (const auto& p : changedPackages)
+        {
+            for (const PathName& f : GetFiles(session->GetMpmRootPath(), p.first))
+            {
+                removedFiles[f] = p.first.id;
+            }
+            for (const PathName& f : GetFiles(session->GetMpmRootPath(), p.second))
+            {
+                installedFiles[f] = p.second.id;
+            }
+        }
+        UpdateFndb(installedFiles, removedFiles);
+    }
+    else
+    {
+        packageManager->CreateMpmFndbNoLock();
+    }
 
     if (!options[UpdateDbOption::FromCache])
     {
+        if (!url.empty())
+        {
+            WriteValidators(validatorsFile, url, validators, MakeFileStamp(existingPackageManifestsIni));
+        }
         session->SetConfigValue(
             MIKTEX_CONFIG_SECTION_MPM,
             session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_DB : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_DB,
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief PackageInstaller implementation
  *
- * @copyright Copyright © 2001-2022 Christian Schenk
+ * @copyright Copyright © 2001-2024 Christian Schenk
  *
  * This file is part of MiKTeX Package Manager.
  *
@@ -13,13 +13,22 @@
 
 #pragma once
 
+#include <cstdio>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <miktex/Core/Cfg>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Session>
 #include <miktex/Core/TemporaryFile>
 #include <miktex/Extractor/Extractor>
@@ -149,6 +158,7 @@ public:
     {
         repositoryType = PackageRepositoryDataStore::DetermineRepositoryType(repository);
         this->repository = repository;
+        fallbackRepositories.clear();
     }
 
     void MIKTEXTHISCALL UpdateDb(UpdateDbOptionSet options) override
@@ -171,30 +181,53 @@ private:
         ERROR_SOURCE_FILE_NOT_FOUND,
     };
 
+    // an archive file which is downloaded ahead of its installation
+    struct PrefetchedArchive
+    {
+        std::string packageId;
+        std::string url;
+        std::size_t expectedSize = 0;
+        MiKTeX::Core::MD5 expectedDigest;
+        std::unique_ptr<MiKTeX::Core::TemporaryFile> temporaryFile;
+        std::exception_ptr error;
+        bool done = false;
+    };
+
+    void AddToArchiveCache(const std::string& packageId, const MiKTeX::Util::PathName& archiveFile);
     void CalculateExpenditure(bool downloadOnly = false);
     bool CheckArchiveFile(const std::string& packageId, const MiKTeX::Util::PathName& archiveFileName, bool mustBeOk);
     void CheckDependencies(std::set<std::string>& packages, const std::string& packageId, bool force, int level);
     void CleanUpUserDatabase();
+    void CompileOcps(const std::vector<std::string>& packages);
+    static std::size_t CopyFileData(MiKTeX::Core::FileStream& fromStream, MiKTeX::Core::FileStream& toStream);
     void CopyFiles(const MiKTeX::Util::PathName& pathSourceRoot, const std::vector<std::string>& fileList);
     void CopyPackage(const MiKTeX::Util::PathName& pathSourceRoot, const std::string& packageId);
     void Download(const MiKTeX::Util::PathName& fileName, std::size_t expectedSize = 0);
-    void Download(const std::string& url, const MiKTeX::Util::PathName& dest, std::size_t expectedSize = 0);
+    void Download(const std::string& url, const MiKTeX::Util::PathName& dest, std::size_t expectedSize = 0, bool resume = false);
+    void DeleteDeferredFiles();
+    bool DownloadIfModified(const std::string& url, const MiKTeX::Util::PathName& dest, WebFileValidators& validators);
     void DownloadPackage(const std::string& packageId);
     void DownloadThread();
     void ExtractFiles(const MiKTeX::Util::PathName& archiveFileName, MiKTeX::Extractor::ArchiveFileType archiveFileType);
+    bool ExtractWhileDownloading(const std::string& packageId, MiKTeX::Extractor::ArchiveFileType archiveFileType, const std::string& url, const MiKTeX::Util::PathName& teeFile);
     std::string FatalError(ErrorCode error);
     void FindUpdatesNoLock();
     void FindUpdatesThread();
     void FindUpgradesNoLock(PackageLevel packageLevel);
     void FindUpgradesThread();
+    MiKTeX::Util::PathName GetCachedArchiveFile(const std::string& packageId);
     void InstallPackage(const std::string& packageId, MiKTeX::Core::Cfg& packageManifests);
-    void HandleObsoletePackageManifests(MiKTeX::Core::Cfg& cfgExisting, const MiKTeX::Core::Cfg& cfgNew);
+    void HandleObsoletePackageManifests(MiKTeX::Core::Cfg& cfgExisting, const MiKTeX::Core::Cfg& cfgNew, std::vector<MiKTeX::Packages::PackageInfo>& removedPackages);
     void InstallRemoveThread();
     void InstallRepositoryManifest(bool fromCache);
     void LoadRepositoryManifest(bool download);
     std::string MakeUrl(const std::string& relPath);
     void MyCopyFile(const MiKTeX::Util::PathName& source, const MiKTeX::Util::PathName& dest, std::size_t& size);
     void NeedRepository();
+    void PickRepository();
+    FILE* OpenDestinationFile(const MiKTeX::Util::PathName& dest);
+    void Prefetch(WebSession* webSession, PrefetchedArchive& archive);
+    void PrefetchThread(std::shared_ptr<WebSession> webSession);
     bool MIKTEXTHISCALL OnProgress(unsigned level, const MiKTeX::Util::PathName& directory) override;
     bool MIKTEXTHISCALL ReadDirectory(const MiKTeX::Util::PathName& path, std::vector<std::string>& subDirNames, std::vector<std::string>& fileNames, std::vector<std::string>& fileNameInfos) override;
     void RegisterComponents(bool doRegister, const std::vector<std::string>& packages);
@@ -202,10 +235,27 @@ private:
     void RemovePackage(const std::string& packageId, MiKTeX::Core::Cfg& packageManifests);
     void ReportLine(const std::string& s);
     void RunOneMiKTeXUtility(const std::vector<std::string>& arguments);
+    void StartPrefetching(const std::vector<std::string>& packages);
     void StartWorkerThread(void (PackageInstallerImpl::* method)());
+    void StopPrefetching();
+    bool SwitchRepository(std::string& url);
+    std::unique_ptr<MiKTeX::Core::TemporaryFile> TakePrefetchedArchive(const std::string& packageId);
     void UpdateDbNoLock(UpdateDbOptionSet options);
     void UpdateDbThread();
     void UpdateFndb(const std::unordered_set<MiKTeX::Util::PathName>& installedFiles, const std::unordered_set<MiKTeX::Util::PathName>& removedFiles, const std::string& packageId);
+    // file name => package ID
+    void UpdateFndb(const std::unordered_map<MiKTeX::Util::PathName, std::string>& installedFiles, const std::unordered_map<MiKTeX::Util::PathName, std::string>& removedFiles);
+
+    struct FndbChanges
+    {
+        // file name => package ID
+        std::unordered_map<MiKTeX::Util::PathName, std::string> toBeAdded;
+        std::unordered_set<MiKTeX::Util::PathName> toBeRemoved;
+    };
+
+    void RecordFndbChanges(FndbChanges& changes, const std::unordered_set<MiKTeX::Util::PathName>& installedFiles, const std::unordered_set<MiKTeX::Util::PathName>& removedFiles, const std::string& packageId);
+    void ApplyFndbChanges(FndbChanges& changes, bool mpmRoot);
+    void ApplyPendingFndbChanges();
 
 #if defined(MIKTEX_WINDOWS)
     void RegisterComponent(bool doRegister, const MiKTeX::Util::PathName& path, bool mustSucceed);
@@ -237,13 +287,27 @@ private:
         RegisterComponents(doRegister, packages2);
     }
 
+    bool batchFndbUpdates = true;
+    bool batchingFndbChanges = false;
     MiKTeX::Packages::PackageInstallerCallback* callback = nullptr;
     Role currentRole;
+    bool deferFileDeletion = false;
+    std::vector<MiKTeX::Util::PathName> deferredFileDeletions;
     MiKTeX::Util::PathName downloadDirectory;
     bool enablePostProcessing = true;
+    // the next best remote package repositories, if the repository has been picked automatically
+    std::deque<std::string> fallbackRepositories;
+    FndbChanges installRootFndbChanges;
     std::unordered_set<MiKTeX::Util::PathName> installedFiles;
+    FndbChanges mpmRootFndbChanges;
     PackageDataStore* packageDataStore = nullptr;
     std::shared_ptr<PackageManagerImpl> packageManager;
+    std::condition_variable prefetchCondition;
+    std::unordered_map<std::string, std::shared_ptr<PrefetchedArchive>> prefetchedArchives;
+    std::size_t prefetchLimit = 0;
+    std::mutex prefetchMutex;
+    std::deque<std::shared_ptr<PrefetchedArchive>> prefetchQueue;
+    std::vector<std::thread> prefetchThreads;
     std::mutex progressIndicatorMutex;
     ProgressInfo progressInfo;
     std::unordered_set<MiKTeX::Util::PathName> removedFiles;
@@ -252,6 +316,7 @@ private:
     MiKTeX::Packages::RepositoryReleaseState repositoryReleaseState = MiKTeX::Packages::RepositoryReleaseState::Unknown;
     MiKTeX::Packages::RepositoryType repositoryType = MiKTeX::Packages::RepositoryType::Unknown;
     std::shared_ptr<MiKTeX::Core::Session> session;
+    std::atomic_bool stopPrefetching{ false };
     MiKTeX::Packages::PackageLevel taskPackageLevel = MiKTeX::Packages::PackageLevel::None;
     MiKTeX::Core::MiKTeXException threadMiKTeXException;
     clock_t timeStarted;
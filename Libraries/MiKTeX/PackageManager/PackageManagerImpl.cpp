@@ -14,9 +14,14 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
 #include <locale>
+#include <mutex>
 #include <stack>
+#include <system_error>
+#include <thread>
 #include <unordered_set>
 
 #include <fmt/format.h>
@@ -34,6 +39,8 @@
 #include <miktex/Util/PathNameParser>
 
 #include "internal.h"
+#include "DocumentationIndex.h"
+#include "FileDigestCache.h"
 #include "PackageManagerImpl.h"
 #include "PackageInstallerImpl.h"
 #include "PackageIteratorImpl.h"
@@ -50,6 +57,9 @@ using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
+// more threads do not help when the files are read from one disk
+constexpr size_t MAX_VERIFICATION_THREADS = 8;
+
 string PackageManagerImpl::proxyUser;
 string PackageManagerImpl::proxyPassword;
 
@@ -1085,96 +1095,175 @@ void PackageManagerImpl::OnProgress()
 {
 }
 
-bool PackageManagerImpl::TryGetFileDigest(const PathName& prefix, const string& fileName, bool& haveDigest, MD5& digest)
-{
-    string unprefixed;
-    if (!StripTeXMFPrefix(fileName, unprefixed))
-    {
-        return true;
-    }
-    PathName path = prefix;
-    path /= unprefixed;
-    if (!File::Exists(path))
-    {
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
-        return false;
-    }
-    if (path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
-    {
-        haveDigest = false;
-    }
-    else
-    {
-        digest = MD5::FromFile(path);
-        haveDigest = true;
-    }
-    return true;
-}
-
-bool PackageManagerImpl::TryCollectFileDigests(const PathName& prefix, const vector<string>& files, FileDigestTable& fileDigests)
+bool PackageManagerImpl::TryCollectFilesToBeVerified(const PathName& prefix, size_t packageIdx, const vector<string>& files, vector<FileToBeVerified>& filesToBeVerified)
 {
     for (const string& fileName : files)
     {
-        bool haveDigest;
-        MD5 digest;
-        if (!TryGetFileDigest(prefix, fileName, haveDigest, digest))
+        string unprefixed;
+        if (!StripTeXMFPrefix(fileName, unprefixed))
         {
+            continue;
+        }
+        PathName path = prefix;
+        path /= unprefixed;
+        if (!File::Exists(path))
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
             return false;
         }
-        if (haveDigest)
+        if (path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
         {
-            fileDigests[fileName] = digest;
+            continue;
         }
+        FileToBeVerified fileToBeVerified;
+        fileToBeVerified.packageIdx = packageIdx;
+        fileToBeVerified.fileName = fileName;
+        fileToBeVerified.path = path;
+        filesToBeVerified.push_back(fileToBeVerified);
     }
     return true;
 }
 
-bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+void PackageManagerImpl::ComputeFileDigests(vector<FileToBeVerified>& filesToBeVerified)
 {
-    PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+    // read the files in directory order, so that the files of one directory
+    // are read one after the other
+    sort(filesToBeVerified.begin(), filesToBeVerified.end(), [](const FileToBeVerified& lhs, const FileToBeVerified& rhs) { return lhs.path < rhs.path; });
+    size_t numThreads = thread::hardware_concurrency();
+    numThreads = numThreads == 0 ? 1 : numThreads > MAX_VERIFICATION_THREADS ? MAX_VERIFICATION_THREADS : numThreads;
+    vector<size_t> indices;
+    vector<PathName> paths;
+    for (size_t idx = 0; idx < filesToBeVerified.size(); ++idx)
+    {
+        if (!filesToBeVerified[idx].haveDigest)
+        {
+            indices.push_back(idx);
+            paths.push_back(filesToBeVerified[idx].path);
+        }
+    }
+    vector<MD5> digests = MD5::FromFiles(paths, numThreads);
+    for (size_t n = 0; n < indices.size(); ++n)
+    {
+        filesToBeVerified[indices[n]].digest = digests[n];
+        filesToBeVerified[indices[n]].haveDigest = true;
+    }
+}
 
-    PathName prefix;
+vector<string> PackageManagerImpl::VerifyInstalledPackagesNoLock(const vector<string>& packageIds)
+{
+    unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "verifying packages");
 
-    if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
+    vector<PackageInfo> packages;
+    vector<bool> ok(packageIds.size(), true);
+    vector<FileToBeVerified> filesToBeVerified;
+
+    for (size_t idx = 0; idx < packageIds.size(); ++idx)
     {
-        prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+        packages.push_back(packageDataStore.GetPackage(packageIds[idx]));
+        const PackageInfo& packageInfo = packages.back();
+
+        PathName prefix;
+
+        if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
+        {
+            prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+        }
+
+        if (prefix.Empty() && session->IsSharedSetup())
+        {
+            prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+        }
+
+        size_t start = filesToBeVerified.size();
+
+        if (!TryCollectFilesToBeVerified(prefix, idx, packageInfo.runFiles, filesToBeVerified)
+            || !TryCollectFilesToBeVerified(prefix, idx, packageInfo.docFiles, filesToBeVerified)
+            || !TryCollectFilesToBeVerified(prefix, idx, packageInfo.sourceFiles, filesToBeVerified))
+        {
+            filesToBeVerified.resize(start);
+            ok[idx] = false;
+        }
     }
 
-    if (prefix.Empty() && session->IsSharedSetup())
+    unique_ptr<FileDigestCache> fileDigestCache;
+
+    if (session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_CACHE_FILE_DIGESTS, ConfigValue(false)).GetBool())
     {
-        prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+        fileDigestCache = make_unique<FileDigestCache>(session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FILE_DIGEST_CACHE);
+        fileDigestCache->Load();
+        size_t numCached = 0;
+        for (FileToBeVerified& fileToBeVerified : filesToBeVerified)
+        {
+            fileToBeVerified.size = File::GetSize(fileToBeVerified.path);
+            fileToBeVerified.lastWriteTime = File::GetLastWriteTime(fileToBeVerified.path);
+            fileToBeVerified.haveDigest = fileDigestCache->TryGet(fileToBeVerified.path, fileToBeVerified.size, fileToBeVerified.lastWriteTime, fileToBeVerified.digest);
+            if (fileToBeVerified.haveDigest)
+            {
+                numCached++;
+            }
+        }
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format("{0} of {1} files are unchanged since the last verification", numCached, filesToBeVerified.size()));
     }
 
-    FileDigestTable fileDigests;
+    ComputeFileDigests(filesToBeVerified);
 
-    if (!TryCollectFileDigests(prefix, packageInfo.runFiles, fileDigests)
-        || !TryCollectFileDigests(prefix, packageInfo.docFiles, fileDigests)
-        || !TryCollectFileDigests(prefix, packageInfo.sourceFiles, fileDigests))
+    vector<FileDigestTable> fileDigests(packages.size());
+
+    for (const FileToBeVerified& fileToBeVerified : filesToBeVerified)
     {
-        return false;
+        fileDigests[fileToBeVerified.packageIdx][fileToBeVerified.fileName] = fileToBeVerified.digest;
     }
 
-    MD5Builder md5Builder;
+    vector<string> damagedPackages;
 
-    for (const pair<string, MD5> p : fileDigests)
+    for (size_t idx = 0; idx < packages.size(); ++idx)
     {
-        PathName path(p.first);
-        // we must dosify the path name for backward compatibility
-        path.ConvertToDos();
-        md5Builder.Update(path.GetData(), path.GetLength());
-        md5Builder.Update(p.second.data(), p.second.size());
-    }
+        if (!ok[idx])
+        {
+            damagedPackages.push_back(packages[idx].id);
+            continue;
+        }
 
-    bool ok = md5Builder.Final() == packageInfo.digest;
+        MD5Builder md5Builder;
 
-    if (!ok)
+        for (const pair<string, MD5> p : fileDigests[idx])
+        {
+            PathName path(p.first);
+            // we must dosify the path name for backward compatibility
+            path.ConvertToDos();
+            md5Builder.Update(path.GetData(), path.GetLength());
+            md5Builder.Update(p.second.data(), p.second.size());
+        }
+
+        if (md5Builder.Final() != packages[idx].digest)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(packages[idx].id)));
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), packages[idx].digest.ToString()));
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5().ToString()));
+            damagedPackages.push_back(packages[idx].id);
+            ok[idx] = false;
+        }
+    }
+
+    if (fileDigestCache != nullptr)
     {
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(packageId)));
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), packageInfo.digest.ToString()));
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5().ToString()));
+        // remember only the files of packages which have been verified
+        for (const FileToBeVerified& fileToBeVerified : filesToBeVerified)
+        {
+            if (ok[fileToBeVerified.packageIdx])
+            {
+                fileDigestCache->Put(fileToBeVerified.path, fileToBeVerified.size, fileToBeVerified.lastWriteTime, fileToBeVerified.digest);
+            }
+        }
+        fileDigestCache->Save();
     }
 
-    return ok;
+    return damagedPackages;
+}
+
+bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+{
+    return VerifyInstalledPackagesNoLock({ packageId }).empty();
 }
 
 string PackageManagerImpl::GetContainerPathNoLock(const string& packageId, bool useDisplayNames)
@@ -1231,6 +1320,36 @@ InstallationSummary PackageManagerImpl::GetInstallationSummary(bool userScope)
     return result;
 }
 
+vector<PackageDocumentation> PackageManagerImpl::GetDocumentationIndex()
+{
+    vector<PackageDocumentation> index;
+    if (DocumentationIndex::TryRead(index))
+    {
+        return index;
+    }
+    MPM_LOCK_BEGIN(this)
+    {
+        packageDataStore.Load();
+        index = DocumentationIndex::Build(packageDataStore);
+        DocumentationIndex::Write(index);
+    }
+    MPM_LOCK_END();
+    return index;
+}
+
+bool PackageManagerImpl::TryGetPackageDocumentation(const string& packageId, PackageDocumentation& packageDocumentation)
+{
+    for (PackageDocumentation& record : GetDocumentationIndex())
+    {
+        if (equal_icase()(record.packageId, packageId))
+        {
+            packageDocumentation = std::move(record);
+            return true;
+        }
+    }
+    return false;
+}
+
 MPM_INTERNAL_BEGIN_NAMESPACE;
 
 bool IsUrl(const string& url)
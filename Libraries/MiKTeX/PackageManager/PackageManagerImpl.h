@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief PackageManager implementation
  *
- * @copyright Copyright © 2001-2022 Christian Schenk
+ * @copyright Copyright © 2001-2024 Christian Schenk
  *
  * This file is part of MiKTeX Package Manager.
  *
@@ -13,8 +13,12 @@
 
 #pragma once
 
+#include <cstddef>
+#include <ctime>
+
 #include <map>
 #include <string>
+#include <vector>
 
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Fndb>
@@ -99,6 +103,11 @@ public:
         return repositories.PickRepositoryUrl();
     }
 
+    std::vector<std::string> GetRankedRepositoryUrls() const
+    {
+        return repositories.GetRankedRepositoryUrls();
+    }
+
     bool MIKTEXTHISCALL TryGetPackageInfo(const std::string& packageId, MiKTeX::Packages::PackageInfo& packageInfo) override;
 
 private:
@@ -140,6 +149,21 @@ public:
 
     bool MIKTEXTHISCALL TryVerifyInstalledPackageNoLock(const std::string& packageId);
 
+    std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds) override
+    {
+        if (!packageDataStore.LoadedAllPackageManifests())
+        {
+            MPM_LOCK_BEGIN(this)
+            {
+                packageDataStore.Load();
+            }
+            MPM_LOCK_END();
+        }
+        return VerifyInstalledPackagesNoLock(packageIds);
+    }
+
+    std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackagesNoLock(const std::vector<std::string>& packageIds);
+
     std::string MIKTEXTHISCALL GetContainerPath(const std::string& packageId, bool useDisplayNames) override
     {
         if (!packageDataStore.LoadedAllPackageManifests())
@@ -155,6 +179,8 @@ public:
 
     std::string MIKTEXTHISCALL GetContainerPathNoLock(const std::string& packageId, bool useDisplayNames);
     InstallationSummary MIKTEXTHISCALL GetInstallationSummary(bool userScope) override;
+    std::vector<MiKTeX::Packages::PackageDocumentation> MIKTEXTHISCALL GetDocumentationIndex() override;
+    bool MIKTEXTHISCALL TryGetPackageDocumentation(const std::string& packageId, MiKTeX::Packages::PackageDocumentation& packageDocumentation) override;
     PackageManagerImpl(const MiKTeX::Packages::PackageManager::InitInfo& initInfo);
     void Lock(std::chrono::milliseconds timeout);
     void Unlock();
@@ -162,8 +188,19 @@ public:
 
 private:
 
-    bool TryGetFileDigest(const MiKTeX::Util::PathName& prefix, const std::string& fileName, bool& haveDigest, MiKTeX::Core::MD5& digest);
-    bool TryCollectFileDigests(const MiKTeX::Util::PathName& prefix, const std::vector<std::string>& files, FileDigestTable& fileDigests);
+    struct FileToBeVerified
+    {
+        std::size_t packageIdx;
+        std::string fileName;
+        MiKTeX::Util::PathName path;
+        MiKTeX::Core::MD5 digest;
+        bool haveDigest = false;
+        std::size_t size = 0;
+        std::time_t lastWriteTime = 0;
+    };
+
+    bool TryCollectFilesToBeVerified(const MiKTeX::Util::PathName& prefix, std::size_t packageIdx, const std::vector<std::string>& files, std::vector<FileToBeVerified>& filesToBeVerified);
+    void ComputeFileDigests(std::vector<FileToBeVerified>& filesToBeVerified);
     void Dispose();
 
     std::unique_ptr<MiKTeX::Core::LockFile> lockFile;
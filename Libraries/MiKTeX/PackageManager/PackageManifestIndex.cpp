@@ -0,0 +1,289 @@
+/**
+ * @file PackageManifestIndex.cpp
+ * @author Christian Schenk
+ * @brief Binary package manifest index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/Process>
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+#include "internal.h"
+
+#include "PackageManifestIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+constexpr const char PACKAGE_MANIFEST_INDEX_SIGNATURE[] = "miktex-package-manifest-index-1\n";
+
+constexpr const char* PACKAGE_MANIFEST_INDEX_FILE_SUFFIX = ".idx";
+
+struct IndexHeader
+{
+    uint64_t iniSize;
+    int64_t iniLastWriteTime;
+    uint32_t count;
+};
+
+class IndexWriter
+{
+public:
+
+    void Write(const void* data, size_t n)
+    {
+        buffer.append(static_cast<const char*>(data), n);
+    }
+
+    void Write(uint32_t value)
+    {
+        Write(&value, sizeof(value));
+    }
+
+    void Write(uint64_t value)
+    {
+        Write(&value, sizeof(value));
+    }
+
+    void Write(int64_t value)
+    {
+        Write(&value, sizeof(value));
+    }
+
+    void Write(const string& s)
+    {
+        Write(static_cast<uint32_t>(s.length()));
+        Write(s.c_str(), s.length());
+    }
+
+    void Write(const vector<string>& v)
+    {
+        Write(static_cast<uint32_t>(v.size()));
+        for (const string& s : v)
+        {
+            Write(s);
+        }
+    }
+
+    const string& GetBuffer() const
+    {
+        return buffer;
+    }
+
+private:
+
+    string buffer;
+};
+
+class IndexReader
+{
+public:
+
+    IndexReader(const unsigned char* ptr, size_t size) :
+        ptr(ptr),
+        size(size)
+    {
+    }
+
+    void Read(void* data, size_t n)
+    {
+        if (n > size - offset)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        memcpy(data, ptr + offset, n);
+        offset += n;
+    }
+
+    template<typename T> T Read()
+    {
+        T value;
+        Read(&value, sizeof(value));
+        return value;
+    }
+
+    string ReadString()
+    {
+        uint32_t length = Read<uint32_t>();
+        if (length > size - offset)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        string s(reinterpret_cast<const char*>(ptr) + offset, length);
+        offset += length;
+        return s;
+    }
+
+    vector<string> ReadStrings()
+    {
+        uint32_t count = Read<uint32_t>();
+        if (count > size - offset)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        vector<string> v;
+        v.reserve(count);
+        for (uint32_t idx = 0; idx < count; ++idx)
+        {
+            v.push_back(ReadString());
+        }
+        return v;
+    }
+
+private:
+
+    size_t offset = 0;
+    const unsigned char* ptr;
+    size_t size;
+};
+
+PathName PackageManifestIndex::GetIndexPath(const PathName& iniPath)
+{
+    PathName indexPath = iniPath;
+    indexPath.SetExtension(PACKAGE_MANIFEST_INDEX_FILE_SUFFIX);
+    return indexPath;
+}
+
+bool PackageManifestIndex::TryRead(const PathName& iniPath, vector<PackageInfo>& packageManifests)
+{
+    unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    PathName indexPath = GetIndexPath(iniPath);
+    if (!File::Exists(indexPath))
+    {
+        return false;
+    }
+    size_t start = packageManifests.size();
+    try
+    {
+        unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+        mapping->Open(indexPath, false);
+        IndexReader reader(static_cast<const unsigned char*>(mapping->GetPtr()), mapping->GetSize());
+        char signature[sizeof(PACKAGE_MANIFEST_INDEX_SIGNATURE) - 1];
+        reader.Read(signature, sizeof(signature));
+        IndexHeader header;
+        reader.Read(&header, sizeof(header));
+        if (memcmp(signature, PACKAGE_MANIFEST_INDEX_SIGNATURE, sizeof(signature)) != 0
+            || header.iniSize != File::GetSize(iniPath)
+            || header.iniLastWriteTime != static_cast<int64_t>(File::GetLastWriteTime(iniPath)))
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package manifest index {0} is out of date"), Q_(indexPath)));
+            mapping->Close();
+            return false;
+        }
+        packageManifests.reserve(start + header.count);
+        for (uint32_t idx = 0; idx < header.count; ++idx)
+        {
+            PackageInfo packageInfo;
+            packageInfo.id = reader.ReadString();
+            packageInfo.displayName = reader.ReadString();
+            packageInfo.creator = reader.ReadString();
+            packageInfo.title = reader.ReadString();
+            packageInfo.version = reader.ReadString();
+            packageInfo.targetSystem = reader.ReadString();
+            packageInfo.minTargetSystemVersion = reader.ReadString();
+            packageInfo.description = reader.ReadString();
+            packageInfo.requiredPackages = reader.ReadStrings();
+            packageInfo.sizeRunFiles = reader.Read<uint64_t>();
+            packageInfo.runFiles = reader.ReadStrings();
+            packageInfo.sizeDocFiles = reader.Read<uint64_t>();
+            packageInfo.docFiles = reader.ReadStrings();
+            packageInfo.sizeSourceFiles = reader.Read<uint64_t>();
+            packageInfo.sourceFiles = reader.ReadStrings();
+            packageInfo.timePackaged = reader.Read<int64_t>();
+            reader.Read(packageInfo.digest.data(), packageInfo.digest.size());
+            packageInfo.ctanPath = reader.ReadString();
+            packageInfo.copyrightOwner = reader.ReadString();
+            packageInfo.copyrightYear = reader.ReadString();
+            packageInfo.licenseType = reader.ReadString();
+            packageManifests.push_back(std::move(packageInfo));
+        }
+        mapping->Close();
+    }
+    catch (const exception& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package manifest index {0} cannot be read: {1}"), Q_(indexPath), e.what()));
+        packageManifests.resize(start);
+        return false;
+    }
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("loaded {0} package manifests from {1}"), packageManifests.size() - start, Q_(indexPath)));
+    return true;
+}
+
+void PackageManifestIndex::Write(const PathName& iniPath, const vector<PackageInfo>& packageManifests)
+{
+    unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    PathName indexPath = GetIndexPath(iniPath);
+    try
+    {
+        IndexWriter writer;
+        writer.Write(PACKAGE_MANIFEST_INDEX_SIGNATURE, sizeof(PACKAGE_MANIFEST_INDEX_SIGNATURE) - 1);
+        IndexHeader header;
+        memset(&header, 0, sizeof(header));
+        header.iniSize = File::GetSize(iniPath);
+        header.iniLastWriteTime = File::GetLastWriteTime(iniPath);
+        header.count = static_cast<uint32_t>(packageManifests.size());
+        writer.Write(&header, sizeof(header));
+        for (const PackageInfo& packageInfo : packageManifests)
+        {
+            writer.Write(packageInfo.id);
+            writer.Write(packageInfo.displayName);
+            writer.Write(packageInfo.creator);
+            writer.Write(packageInfo.title);
+            writer.Write(packageInfo.version);
+            writer.Write(packageInfo.targetSystem);
+            writer.Write(packageInfo.minTargetSystemVersion);
+            writer.Write(packageInfo.description);
+            writer.Write(packageInfo.requiredPackages);
+            writer.Write(static_cast<uint64_t>(packageInfo.sizeRunFiles));
+            writer.Write(packageInfo.runFiles);
+            writer.Write(static_cast<uint64_t>(packageInfo.sizeDocFiles));
+            writer.Write(packageInfo.docFiles);
+            writer.Write(static_cast<uint64_t>(packageInfo.sizeSourceFiles));
+            writer.Write(packageInfo.sourceFiles);
+            writer.Write(static_cast<int64_t>(packageInfo.timePackaged));
+            writer.Write(packageInfo.digest.data(), packageInfo.digest.size());
+            writer.Write(packageInfo.ctanPath);
+            writer.Write(packageInfo.copyrightOwner);
+            writer.Write(packageInfo.copyrightYear);
+            writer.Write(packageInfo.licenseType);
+        }
+        // other processes may have the old index file mapped: write a new
+        // file and move it into place
+        PathName newPath = indexPath;
+        newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        FileStream stream(File::Open(newPath, FileMode::Create, FileAccess::Write, false));
+        stream.Write(writer.GetBuffer().c_str(), writer.GetBuffer().length());
+        stream.Close();
+        File::Move(newPath, indexPath, { FileMoveOption::ReplaceExisting });
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("wrote package manifest index {0}"), Q_(indexPath)));
+    }
+    catch (const exception& e)
+    {
+        // the index file is an optimization: the INI file stays the master
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package manifest index {0} cannot be written: {1}"), Q_(indexPath), e.what()));
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file PackageManifestIndex.h
+ * @author Christian Schenk
+ * @brief Binary package manifest index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief Compiled form of `package-manifests.ini`.
+ *
+ * The index file lives next to the INI file.  It records the size and the
+ * modification time of the INI file it was compiled from; a stale index file
+ * is ignored and replaced.
+ */
+class PackageManifestIndex
+{
+public:
+
+    /**
+     * @brief Gets the path to the index file of an INI file.
+     * @param iniPath Path to the INI file.
+     * @return Returns the path to the index file.
+     */
+    static MiKTeX::Util::PathName GetIndexPath(const MiKTeX::Util::PathName& iniPath);
+
+    /**
+     * @brief Reads package manifests from an up-to-date index file.
+     * @param iniPath Path to the INI file.
+     * @param[out] packageManifests The package manifests are appended to this
+     * vector.
+     * @return Returns `false`, if the index file is missing, out of date or
+     * unreadable.
+     */
+    static bool TryRead(const MiKTeX::Util::PathName& iniPath, std::vector<MiKTeX::Packages::PackageInfo>& packageManifests);
+
+    /**
+     * @brief Writes the index file of an INI file.
+     * @param iniPath Path to the INI file.
+     * @param packageManifests The package manifests read from the INI file.
+     */
+    static void Write(const MiKTeX::Util::PathName& iniPath, const std::vector<MiKTeX::Packages::PackageInfo>& packageManifests);
+};
+
+MPM_INTERNAL_END_NAMESPACE;
@@ -21,6 +21,13 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <fmt/format.h>
+
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/Cfg>
 #include <miktex/Core/Uri>
@@ -35,6 +42,7 @@
 #include "WebFile.h"
 
 using namespace std;
+using namespace std::chrono;
 
 using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
@@ -43,6 +51,27 @@ using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
+// a large file, which exists in every package repository: only the first
+// bytes are downloaded
+constexpr const char* PROBE_FILE_NAME = "cm-super.tar.lzma";
+constexpr size_t PROBE_SIZE = 256 * 1024;
+constexpr seconds PROBE_MAX_TIME(3);
+constexpr size_t MAX_PARALLEL_PROBES = 8;
+
+// the repositories are probed again after a week
+constexpr time_t RANKING_MAX_AGE = 7 * 24 * 60 * 60;
+
+// the score is the expected time (in seconds) to download a package of this
+// size
+constexpr double SCORE_REFERENCE_SIZE = 1000000.0;
+constexpr double SCORE_FAILURE = 1000.0;
+
+string MakeKey(const string& url)
+{
+  Uri uri(url);
+  return uri.GetScheme() + "://" + uri.GetHost();
+}
+
 PackageRepositoryDataStore::PackageRepositoryDataStore(std::shared_ptr<WebSession> webSession) :
   webSession(webSession)
 {
@@ -54,19 +83,29 @@ PackageRepositoryDataStore::PackageRepositoryDataStore(std::shared_ptr<WebSessio
 
 void PackageRepositoryDataStore::Download()
 {
-  ProxySettings proxySettings;
-  if (!IsUrl(GetRemoteServiceBaseUrl()) || !PackageManager::TryGetProxy(GetRemoteServiceBaseUrl(), proxySettings))
-  {
-    proxySettings.useProxy = false;
-  }
-  unique_ptr<RemoteService> remoteService = RemoteService::Create(GetRemoteServiceBaseUrl(), proxySettings);
-  repositories = remoteService->GetRepositories(repositoryReleaseState);
+  repositories = GetRemoteService()->GetRepositories(repositoryReleaseState);
   for (RepositoryInfo& r : repositories)
   {
     LoadVarData(r);
   }
 }
 
+RemoteService* PackageRepositoryDataStore::GetRemoteService()
+{
+  // one remote service per data store: the web session keeps the connection
+  // alive
+  if (remoteService == nullptr)
+  {
+    ProxySettings proxySettings;
+    if (!IsUrl(GetRemoteServiceBaseUrl()) || !PackageManager::TryGetProxy(GetRemoteServiceBaseUrl(), proxySettings))
+    {
+      proxySettings.useProxy = false;
+    }
+    remoteService = RemoteService::Create(GetRemoteServiceBaseUrl(), proxySettings);
+  }
+  return remoteService.get();
+}
+
 string PackageRepositoryDataStore::GetRemoteServiceBaseUrl()
 {
   if (remoteServiceBaseUrl.empty())
@@ -78,13 +117,190 @@ string PackageRepositoryDataStore::GetRemoteServiceBaseUrl()
 
 string PackageRepositoryDataStore::PickRepositoryUrl()
 {
-  ProxySettings proxySettings;
-  if (!IsUrl(GetRemoteServiceBaseUrl()) || !PackageManager::TryGetProxy(GetRemoteServiceBaseUrl(), proxySettings))
+  string suggestedUrl = GetRemoteService()->PickRepositoryUrl(repositoryReleaseState);
+  try
+  {
+    RankRepositories(suggestedUrl);
+  }
+  catch (const MiKTeXException&)
+  {
+    // the ranking is an optimization
+    rankedRepositoryUrls.clear();
+  }
+  return rankedRepositoryUrls.empty() ? suggestedUrl : rankedRepositoryUrls.front();
+}
+
+PackageRepositoryDataStore::ProbeResult PackageRepositoryDataStore::Probe(const string& url)
+{
+  ProbeResult result;
+  shared_ptr<WebSession> webSession = WebSession::Create(nullptr);
+  try
+  {
+    steady_clock::time_point start = steady_clock::now();
+    unique_ptr<WebFile> webFile(webSession->OpenUrl(MakeUrl(url, PROBE_FILE_NAME)));
+    unsigned char buf[32 * 1024];
+    // wait for the first byte
+    size_t received = webFile->Read(buf, 1);
+    steady_clock::time_point firstByte = steady_clock::now();
+    size_t n;
+    while (received > 0 && received < PROBE_SIZE && steady_clock::now() - start < PROBE_MAX_TIME && (n = webFile->Read(buf, sizeof(buf))) > 0)
+    {
+      received += n;
+    }
+    steady_clock::time_point end = steady_clock::now();
+    result.localAddress = webFile->GetLocalAddress();
+    webFile->Close();
+    if (received > 1)
+    {
+      result.latency = duration<double>(firstByte - start).count();
+      result.throughput = received / std::max(duration<double>(end - firstByte).count(), 0.001);
+      result.ok = true;
+    }
+  }
+  catch (const MiKTeXException&)
+  {
+  }
+  webSession->Dispose();
+  return result;
+}
+
+vector<PackageRepositoryDataStore::ProbeResult> PackageRepositoryDataStore::ProbeAll(const vector<string>& urls)
+{
+  vector<ProbeResult> results(urls.size());
+  atomic<size_t> next(0);
+  auto worker = [&]()
+  {
+    size_t idx;
+    while ((idx = next++) < urls.size())
+    {
+      results[idx] = Probe(urls[idx]);
+    }
+  };
+  vector<thread> threads;
+  for (size_t idx = 0; idx < std::min(urls.size(), MAX_PARALLEL_PROBES); ++idx)
+  {
+    threads.push_back(thread(worker));
+  }
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  return results;
+}
+
+// the ranking is kept for each network: the subnet of the local address
+MPMSTATICFUNC(string) MakeNetworkKey(const string& localAddress)
+{
+  size_t pos;
+  if (localAddress.find(':') != string::npos)
   {
-    proxySettings.useProxy = false;
+    // IPv6: the first four groups
+    pos = 0;
+    for (int group = 0; group < 4 && pos != string::npos; ++group)
+    {
+      pos = localAddress.find(':', group == 0 ? 0 : pos + 1);
+    }
+  }
+  else
+  {
+    pos = localAddress.rfind('.');
+  }
+  string prefix = localAddress.substr(0, pos);
+  if (prefix.empty())
+  {
+    prefix = "unknown";
+  }
+  for (char& ch : prefix)
+  {
+    if (ch == '.' || ch == ':')
+    {
+      ch = '-';
+    }
+  }
+  return prefix;
+}
+
+double PackageRepositoryDataStore::UpdateScore(const string& url, const string& network, const ProbeResult& probeResult)
+{
+  string key = MakeKey(url);
+  string valueName = "Score_" + network;
+  double score = probeResult.ok ? probeResult.latency + SCORE_REFERENCE_SIZE / probeResult.throughput : SCORE_FAILURE;
+  string val;
+  if (comboCfg.TryGetValueAsString(key, valueName, val))
+  {
+    // smooth out random fluctuations
+    score = (score + std::stod(val)) / 2;
+  }
+  comboCfg.PutValue(key, valueName, fmt::format("{0:.3f}", score));
+  return score;
+}
+
+void PackageRepositoryDataStore::RankRepositories(const string& suggestedUrl)
+{
+  if (repositories.empty())
+  {
+    Download();
+  }
+  vector<string> candidates;
+  for (const RepositoryInfo& r : repositories)
+  {
+    if (r.status == RepositoryStatus::Online
+      && r.integrity != RepositoryIntegrity::Corrupted
+      && r.relativeDelay == 0
+      && Uri(r.url).GetScheme() == "https")
+    {
+      candidates.push_back(r.url);
+    }
+  }
+  if (find(candidates.begin(), candidates.end(), suggestedUrl) == candidates.end())
+  {
+    candidates.push_back(suggestedUrl);
+  }
+
+  // the suggested repository is probed first in order to find out where we are
+  ProbeResult suggested = Probe(suggestedUrl);
+  string network = MakeNetworkKey(suggested.localAddress);
+  string networkKey = "network-" + network;
+  UpdateScore(suggestedUrl, network, suggested);
+
+  time_t now = time(nullptr);
+  string val;
+  if (!comboCfg.TryGetValueAsString(networkKey, "LastProbeTime", val) || now > Utils::ToTimeT(val) + RANKING_MAX_AGE)
+  {
+    vector<string> toBeProbed;
+    for (const string& url : candidates)
+    {
+      if (url != suggestedUrl)
+      {
+        toBeProbed.push_back(url);
+      }
+    }
+    vector<ProbeResult> probeResults = ProbeAll(toBeProbed);
+    for (size_t idx = 0; idx < toBeProbed.size(); ++idx)
+    {
+      UpdateScore(toBeProbed[idx], network, probeResults[idx]);
+    }
+    comboCfg.PutValue(networkKey, "LastProbeTime", std::to_string(now));
+  }
+
+  vector<pair<double, string>> scores;
+  for (const string& url : candidates)
+  {
+    double score = SCORE_FAILURE;
+    if (comboCfg.TryGetValueAsString(MakeKey(url), "Score_" + network, val))
+    {
+      score = std::stod(val);
+    }
+    scores.push_back(make_pair(score, url));
+  }
+  // repositories without a score keep their position in the repository list
+  stable_sort(scores.begin(), scores.end(), [](const pair<double, string>& a, const pair<double, string>& b) { return a.first < b.first; });
+  rankedRepositoryUrls.clear();
+  for (const auto& s : scores)
+  {
+    rankedRepositoryUrls.push_back(s.second);
   }
-  unique_ptr<RemoteService> remoteService = RemoteService::Create(GetRemoteServiceBaseUrl(), proxySettings);
-  return remoteService->PickRepositoryUrl(repositoryReleaseState);
+  comboCfg.Save();
 }
 
 bool PackageRepositoryDataStore::TryGetRepositoryInfo(const string& url, RepositoryInfo& repositoryInfo)
@@ -92,13 +308,7 @@ bool PackageRepositoryDataStore::TryGetRepositoryInfo(const string& url, Reposit
   RepositoryType repositoryType = PackageRepositoryDataStore::DetermineRepositoryType(url);
   if (repositoryType == RepositoryType::Remote)
   {
-    ProxySettings proxySettings;
-    if (!IsUrl(GetRemoteServiceBaseUrl()) || !PackageManager::TryGetProxy(GetRemoteServiceBaseUrl(), proxySettings))
-    {
-      proxySettings.useProxy = false;
-    }
-    unique_ptr<RemoteService> remoteService = RemoteService::Create(GetRemoteServiceBaseUrl(), proxySettings);
-    pair<bool, RepositoryInfo> result = remoteService->TryGetRepositoryInfo(url);
+    pair<bool, RepositoryInfo> result = GetRemoteService()->TryGetRepositoryInfo(url);
     if (result.first)
     {
       repositoryInfo = result.second;
@@ -169,13 +379,7 @@ RepositoryInfo PackageRepositoryDataStore::VerifyPackageRepository(const string&
       return repository;
     }
   }
-  ProxySettings proxySettings;
-  if (!IsUrl(GetRemoteServiceBaseUrl()) || !PackageManager::TryGetProxy(GetRemoteServiceBaseUrl(), proxySettings))
-  {
-    proxySettings.useProxy = false;
-  }
-  unique_ptr<RemoteService> remoteService = RemoteService::Create(GetRemoteServiceBaseUrl(), proxySettings);
-  RepositoryInfo repositoryInfo = remoteService->Verify(url);
+  RepositoryInfo repositoryInfo = GetRemoteService()->Verify(url);
   LoadVarData(repositoryInfo);
   repositories.push_back(repositoryInfo);
   return repositoryInfo;
@@ -231,12 +435,6 @@ RepositoryInfo PackageRepositoryDataStore::CheckPackageRepository(const string&
   return repositoryInfo;
 }
 
-string MakeKey(const string& url)
-{
-  Uri uri(url);
-  return uri.GetScheme() + "://" + uri.GetHost();
-}
-
 void PackageRepositoryDataStore::LoadVarData(RepositoryInfo& repositoryInfo)
 {
   string key = MakeKey(repositoryInfo.url);
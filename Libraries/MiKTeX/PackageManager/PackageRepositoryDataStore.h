@@ -33,6 +33,7 @@
 #include <miktex/PackageManager/PackageManager>
 
 #include "ComboCfg.h"
+#include "RemoteService.h"
 #include "WebSession.h"
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
@@ -51,9 +52,20 @@ public:
     return repositories;
   }
 
+  /// Picks the package repository which is expected to be the fastest one.
+  /// The repositories are probed in parallel, if the ranking for the current
+  /// network is missing or outdated.
 public:
   std::string PickRepositoryUrl();
 
+  /// Gets the usable package repositories, best first.  Valid after
+  /// PickRepositoryUrl().
+public:
+  std::vector<std::string> GetRankedRepositoryUrls() const
+  {
+    return rankedRepositoryUrls;
+  }
+
 public:
   MiKTeX::Packages::RepositoryInfo CheckPackageRepository(const std::string& url);
 
@@ -84,9 +96,38 @@ private:
 private:
   void SaveVarData(const MiKTeX::Packages::RepositoryInfo& repositoryInfo);
 
+private:
+  RemoteService* GetRemoteService();
+
 private:
   std::string GetRemoteServiceBaseUrl();
 
+private:
+  struct ProbeResult
+  {
+    bool ok = false;
+    // seconds until the first byte arrived
+    double latency = 0.0;
+    // bytes/sec
+    double throughput = 0.0;
+    std::string localAddress;
+  };
+
+private:
+  static ProbeResult Probe(const std::string& url);
+
+private:
+  static std::vector<ProbeResult> ProbeAll(const std::vector<std::string>& urls);
+
+private:
+  void RankRepositories(const std::string& suggestedUrl);
+
+private:
+  double UpdateScore(const std::string& url, const std::string& network, const ProbeResult& probeResult);
+
+private:
+  std::vector<std::string> rankedRepositoryUrls;
+
 private:
   std::vector<MiKTeX::Packages::RepositoryInfo> repositories;
 
@@ -97,6 +138,9 @@ private:
   MiKTeX::Packages::RepositoryReleaseState repositoryReleaseState = MiKTeX::Packages::RepositoryReleaseState::Stable;
 #endif
 
+private:
+  std::unique_ptr<RemoteService> remoteService;
+
 private:
   std::string remoteServiceBaseUrl;
 
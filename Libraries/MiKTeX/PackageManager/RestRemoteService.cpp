@@ -21,10 +21,23 @@
 
 #include "config.h"
 
+#include <ctime>
+
+#include <fstream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
 #include <nlohmann/json.hpp>
 
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
 #include <miktex/Core/Session>
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
 
 #include <miktex/PackageManager/PackageManager>
 
@@ -46,6 +59,13 @@ using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
+constexpr const char* RESPONSE_CACHE_SIGNATURE = "miktex-remote-service-cache-1";
+
+// the list of repositories changes rarely; the state of a repository (online,
+// up to date) is checked more often
+constexpr seconds REPOSITORIES_MAX_AGE = hours(1);
+constexpr seconds REPOSITORY_INFO_MAX_AGE = minutes(10);
+
 inline string ToString(RepositoryReleaseState releaseState)
 {
   switch (releaseState)
@@ -201,8 +221,10 @@ void RestRemoteService::Initialize()
   string configAuthToken;
   string configAuthTokenNotValidAfter;
   if (session->TryGetConfigValue(MIKTEX_CONFIG_SECTION_MPM, "AuthToken", configAuthToken) &&
-      session->TryGetConfigValue(MIKTEX_CONFIG_SECTION_MPM, "AuthTokenNotValidAfter", configAuthTokenNotValidAfter))
+      session->TryGetConfigValue(MIKTEX_CONFIG_SECTION_MPM, "AuthTokenNotValidAfter", configAuthTokenNotValidAfter) &&
+      !configAuthToken.empty() && !configAuthTokenNotValidAfter.empty())
   {
+    // the token was obtained by another process
     token = configAuthToken;
     tokenNotValidAfter = system_clock::from_time_t(Utils::ToTimeT(configAuthTokenNotValidAfter));
     SetAuthHeader(token);
@@ -211,17 +233,8 @@ void RestRemoteService::Initialize()
 
 vector<RepositoryInfo> RestRemoteService::GetRepositories(RepositoryReleaseState repositoryReleaseState)
 {
-  SayHello();
-  unique_ptr<WebFile> webFile(webSession->OpenUrl(MakeUrl("repositories", { "releaseState=" + ToString(repositoryReleaseState) })));
-  char buf[1024];
-  size_t n;
-  stringstream response;
-  while ((n = webFile->Read(buf, sizeof(buf))) > 0)
-  {
-    response.write(buf, n);
-  }
   vector<RepositoryInfo> result;
-  for (const json& j_rep : json::parse(response))
+  for (const json& j_rep : json::parse(Get(MakeUrl("repositories", { "releaseState=" + ToString(repositoryReleaseState) }), REPOSITORIES_MAX_AGE)))
   {
     result.push_back(Deserialize(j_rep));
   }
@@ -230,16 +243,7 @@ vector<RepositoryInfo> RestRemoteService::GetRepositories(RepositoryReleaseState
 
 string RestRemoteService::PickRepositoryUrl(RepositoryReleaseState repositoryReleaseState)
 {
-  SayHello();
-  unique_ptr<WebFile> webFile(webSession->OpenUrl(MakeUrl("repositories", { "releaseState=" + ToString(repositoryReleaseState), "orderBy=ranking", "take=1", "onlySecure=true" })));
-  char buf[1024];
-  size_t n;
-  stringstream response;
-  while ((n = webFile->Read(buf, sizeof(buf))) > 0)
-  {
-    response.write(buf, n);
-  }
-  for (const json& j_rep : json::parse(response))
+  for (const json& j_rep : json::parse(Get(MakeUrl("repositories", { "releaseState=" + ToString(repositoryReleaseState), "orderBy=ranking", "take=1", "onlySecure=true" }), REPOSITORIES_MAX_AGE)))
   {
     return Deserialize(j_rep).url;
   }
@@ -248,17 +252,10 @@ string RestRemoteService::PickRepositoryUrl(RepositoryReleaseState repositoryRel
 
 pair<bool, RepositoryInfo> RestRemoteService::TryGetRepositoryInfo(const string& repositoryUrl)
 {
-  SayHello();
-  unique_ptr<WebFile> webFile(webSession->OpenUrl(MakeUrl("repositories/" + MD5::FromChars(repositoryUrl).ToString(), { })));
-  char buf[1024];
-  size_t n;
-  stringstream response;
+  string response;
   try
   {
-    while ((n = webFile->Read(buf, sizeof(buf))) > 0)
-    {
-      response.write(buf, n);
-    }
+    response = Get(MakeUrl("repositories/" + MD5::FromChars(repositoryUrl).ToString(), { }), REPOSITORY_INFO_MAX_AGE);
   }
   catch (const NotFoundException&)
   {
@@ -331,7 +328,13 @@ void RestRemoteService::SayHello()
   }
   if (tokenNotValidAfter < system_clock::now() + chrono::minutes(3))
   {
-    // TODO: remove config values
+    // not worth sharing: forget an older token
+    string configAuthToken;
+    if (session->TryGetConfigValue(MIKTEX_CONFIG_SECTION_MPM, "AuthToken", configAuthToken) && !configAuthToken.empty())
+    {
+      session->SetConfigValue(MIKTEX_CONFIG_SECTION_MPM, "AuthToken", ConfigValue(""));
+      session->SetConfigValue(MIKTEX_CONFIG_SECTION_MPM, "AuthTokenNotValidAfter", ConfigValue(""));
+    }
   }
   else
   {
@@ -340,3 +343,93 @@ void RestRemoteService::SayHello()
   }
   SetAuthHeader(token);
 }
+
+string RestRemoteService::Get(const string& url, seconds maxAge)
+{
+  if (!responseCacheLoaded)
+  {
+    LoadResponseCache();
+  }
+  time_t now = time(nullptr);
+  auto it = responseCache.find(url);
+  if (it != responseCache.end() && it->second.time <= now && now - it->second.time < maxAge.count())
+  {
+    return it->second.body;
+  }
+  SayHello();
+  // the web session reuses the connection
+  unique_ptr<WebFile> webFile(webSession->OpenUrl(url));
+  char buf[1024];
+  size_t n;
+  string response;
+  while ((n = webFile->Read(buf, sizeof(buf))) > 0)
+  {
+    response.append(buf, n);
+  }
+  webFile->Close();
+  responseCache[url] = CachedResponse{ now, response };
+  SaveResponseCache();
+  return response;
+}
+
+void RestRemoteService::LoadResponseCache()
+{
+  responseCacheLoaded = true;
+  PathName path = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_REMOTE_SERVICE_CACHE;
+  if (!File::Exists(path))
+  {
+    return;
+  }
+  unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+  try
+  {
+    ifstream stream = File::CreateInputStream(path);
+    json j = json::parse(stream);
+    stream.close();
+    if (j.value("signature", "") != RESPONSE_CACHE_SIGNATURE)
+    {
+      return;
+    }
+    for (json::const_iterator it = j["responses"].begin(); it != j["responses"].end(); ++it)
+    {
+      responseCache[it.key()] = CachedResponse{ it.value()["time"].get<time_t>(), it.value()["body"].get<string>() };
+    }
+  }
+  catch (const exception& e)
+  {
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("remote service cache {0} cannot be read: {1}"), Q_(path), e.what()));
+    responseCache.clear();
+  }
+}
+
+void RestRemoteService::SaveResponseCache()
+{
+  PathName path = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_REMOTE_SERVICE_CACHE;
+  unique_ptr<TraceStream> trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+  try
+  {
+    time_t now = time(nullptr);
+    json j_responses = json::object();
+    for (const auto& r : responseCache)
+    {
+      // expired entries are dropped
+      if (now - r.second.time < REPOSITORIES_MAX_AGE.count())
+      {
+        j_responses[r.first] = { {"time", r.second.time}, {"body", r.second.body} };
+      }
+    }
+    json j = { {"signature", RESPONSE_CACHE_SIGNATURE}, {"responses", j_responses} };
+    Directory::Create(path.GetDirectoryName());
+    PathName newPath = path;
+    newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+    ofstream stream = File::CreateOutputStream(newPath);
+    stream << j.dump() << "\n";
+    stream.close();
+    File::Move(newPath, path, { FileMoveOption::ReplaceExisting });
+  }
+  catch (const exception& e)
+  {
+    // the cache is an optimization
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("remote service cache {0} cannot be written: {1}"), Q_(path), e.what()));
+  }
+}
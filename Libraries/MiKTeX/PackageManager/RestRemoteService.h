@@ -23,7 +23,9 @@
 #define A965AF9537944AFEA8EE4AB0D04F55B5
 
 #include <chrono>
+#include <ctime>
 #include <string>
+#include <unordered_map>
 
 #include <miktex/Core/Session>
 
@@ -86,6 +88,30 @@ private:
 private:
   void SayHello();
 
+  /// Gets a response of the remote service.  A cached response is used, if
+  /// it is younger than `maxAge`.  The cache is shared with other processes.
+private:
+  std::string Get(const std::string& url, std::chrono::seconds maxAge);
+
+private:
+  void LoadResponseCache();
+
+private:
+  void SaveResponseCache();
+
+private:
+  struct CachedResponse
+  {
+    std::time_t time;
+    std::string body;
+  };
+
+private:
+  std::unordered_map<std::string, CachedResponse> responseCache;
+
+private:
+  bool responseCacheLoaded = false;
+
 private:
   std::string endpointBaseUrl;
 
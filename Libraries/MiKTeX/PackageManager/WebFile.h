@@ -22,10 +22,25 @@
 #if !defined(FDC3B537D4484567B7577B2803B60F36)
 #define FDC3B537D4484567B7577B2803B60F36
 
+#include <string>
+
 #include <miktex/Core/Session>
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
 
+/// The values which identify a version of a remote file (HTTP `ETag` and
+/// `Last-Modified` response headers).
+struct WebFileValidators
+{
+  std::string eTag;
+  std::string lastModified;
+
+  bool Empty() const
+  {
+    return eTag.empty() && lastModified.empty();
+  }
+};
+
 class MIKTEXNOVTABLE WebFile
 {
 public:
@@ -36,6 +51,21 @@ public:
 
 public:
   virtual void Close() = 0;
+
+  /// Checks whether the server has answered a conditional request with "not
+  /// modified".  Valid after all data has been read.
+public:
+  virtual bool IsNotModified() const = 0;
+
+  /// Gets the validators sent by the server.  Valid after all data has been
+  /// read.
+public:
+  virtual WebFileValidators GetValidators() const = 0;
+
+  /// Gets the local IP address of the connection.  Valid after data has
+  /// been received.
+public:
+  virtual std::string GetLocalAddress() const = 0;
 };
 
 MPM_INTERNAL_END_NAMESPACE;
@@ -1,6 +1,6 @@
 /* WebSession.h:                                        -*- C++ -*-
 
-   Copyright (C) 2001-2019 Christian Schenk
+   Copyright (C) 2001-2024 Christian Schenk
 
    This file is part of MiKTeX Package Manager.
 
@@ -47,6 +47,18 @@ public:
 public:
   virtual std::unique_ptr<WebFile> OpenUrl(const std::string& url, const std::unordered_map<std::string, std::string>& formData) = 0;
 
+  /// Opens a URL for reading, skipping the first bytes.  A range is requested
+  /// from the server; the bytes are skipped locally, if the server sends the
+  /// whole file.
+public:
+  virtual std::unique_ptr<WebFile> OpenUrlAt(const std::string& url, std::size_t offset) = 0;
+
+  /// Opens a URL for reading, if the remote file does not match the
+  /// validators of a previous download.
+  /// @see WebFile::IsNotModified
+public:
+  virtual std::unique_ptr<WebFile> OpenUrlIfModified(const std::string& url, const WebFileValidators& validators) = 0;
+
 public:
   virtual void SetCustomHeaders(const std::unordered_map<std::string, std::string>& headers) = 0;
 
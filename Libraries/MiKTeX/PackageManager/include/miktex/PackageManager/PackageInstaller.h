@@ -1,6 +1,6 @@
 /* miktex/PackageManager/PackageInstaller.h:            -*- C++ -*-
 
-   Copyright (C) 2001-2021 Christian Schenk
+   Copyright (C) 2001-2024 Christian Schenk
 
    This file is part of MiKTeX Package Manager.
 
@@ -385,6 +385,12 @@ public:
     bool unattended = false;
     /// Indicates whether to enable or disable post-processing.
     bool enablePostProcessing = true;
+    /// @brief Indicates whether to update the file name database once per transaction.
+    ///
+    /// If set to `true`, the file name database changes of all packages
+    /// which are installed by `InstallRemove()` are applied in one go at the
+    /// end of the transaction.
+    bool batchFndbUpdates = true;
   };
 };
 
@@ -1,6 +1,6 @@
 /* miktex/PackageManager/PackageManager.h:              -*- C++ -*-
 
-   Copyright (C) 2001-2020 Christian Schenk
+   Copyright (C) 2001-2024 Christian Schenk
 
    This file is part of MiKTeX Package Manager.
 
@@ -72,6 +72,32 @@ struct InstallationSummary
   std::size_t packageCount = 0;
 };
 
+/// A documentation file of a package.
+struct DocumentationFile
+{
+  /// File name relative to the TEXMF root directory.
+  std::string fileName;
+  /// Path to the installed file, if the package is installed.
+  MiKTeX::Util::PathName path;
+  /// File type, i.e., the lower-case file name extension without the dot.
+  std::string type;
+  /// Language code (e.g., `de`), if it can be derived from the file name.
+  std::string language;
+};
+
+/// Documentation record of a package.
+struct PackageDocumentation
+{
+  /// Package ID.
+  std::string packageId;
+  /// One-line package description.
+  std::string title;
+  /// Indicates whether the package is installed.
+  bool isInstalled = false;
+  /// The documentation files.
+  std::vector<DocumentationFile> files;
+};
+
 /// The package manager interface.
 class MIKTEXNOVTABLE PackageManager
 {
@@ -132,7 +158,7 @@ public:
 public:
   virtual std::vector<RepositoryInfo> MIKTEXTHISCALL GetRepositories() = 0;
   
-  /// Picks a random package repository.
+  /// Picks the package repository which is expected to be the fastest one.
   /// @return Returns the URL of a package repository.
 public:
   virtual std::string MIKTEXTHISCALL PickRepositoryUrl() = 0;
@@ -175,6 +201,16 @@ public:
 public:
   virtual bool MIKTEXTHISCALL TryVerifyInstalledPackage(const std::string& packageId) = 0;
 
+  /// @brief Verifies installed packages.
+  ///
+  /// This method reads the files of all packages (using several
+  /// threads) in order to verify the integrity of the packages.
+  ///
+  /// @param packageIds Identifies the packages.
+  /// @return Returns the packages which are not correctly installed.
+public:
+  virtual std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds) = 0;
+
   /// Builds the container path of a package.
   /// @param packageId Identifies the package.
   /// @param useDisplayNames Indicates whether to use user friendly names.
@@ -188,6 +224,23 @@ public:
 public:
   virtual InstallationSummary MIKTEXTHISCALL GetInstallationSummary(bool userScope) = 0;
 
+  /// @brief Gets the documentation index.
+  ///
+  /// The index lists the packages which come with documentation files.  It
+  /// is maintained by the package installer; an out-of-date index is
+  /// rebuilt from the package database.
+  ///
+  /// @return Returns the documentation records.
+public:
+  virtual std::vector<PackageDocumentation> MIKTEXTHISCALL GetDocumentationIndex() = 0;
+
+  /// Looks up a package in the documentation index.
+  /// @param packageId Identifies the package.
+  /// @param[out] packageDocumentation The documentation record.
+  /// @return Returns `false`, if the package has no documentation files.
+public:
+  virtual bool MIKTEXTHISCALL TryGetPackageDocumentation(const std::string& packageId, PackageDocumentation& packageDocumentation) = 0;
+
 public:
   /// Initialization options.
   struct InitInfo
@@ -1289,6 +1289,84 @@ void SetupServiceImpl::UnregisterComponents()
     }
 }
 
+// the file name database of the installation directory only depends on the
+// package set: it is made once and then kept with the package set
+constexpr const char* FNDB_SEED_FILE_NAME = "miktex-fndb-seed.fndb";
+constexpr const char* FNDB_SEED_STAMP_FILE_NAME = "miktex-fndb-seed.ini";
+
+string SetupServiceImpl::GetFndbSeedLayout()
+{
+    string layout = MD5::FromFile(options.LocalPackageRepository / MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME).ToString();
+    layout += fmt::format(";{};{}", static_cast<int>(options.PackageLevel), options.IsPortable ? 1 : 0);
+    MD5Builder md5Builder;
+    md5Builder.Update(layout.c_str(), layout.length());
+    return md5Builder.Final().ToString();
+}
+
+bool SetupServiceImpl::SeedFilenameDatabase(const string& layout)
+{
+    PathName seedFile = options.LocalPackageRepository / FNDB_SEED_FILE_NAME;
+    PathName stampFile = options.LocalPackageRepository / FNDB_SEED_STAMP_FILE_NAME;
+    if (!File::Exists(seedFile) || !File::Exists(stampFile))
+    {
+        return false;
+    }
+    try
+    {
+        unique_ptr<Cfg> stamp(Cfg::Create());
+        stamp->Read(stampFile);
+        string seedLayout;
+        string seedDigest;
+        if (!stamp->TryGetValueAsString("seed", "layout", seedLayout)
+            || seedLayout != layout
+            || !stamp->TryGetValueAsString("seed", "md5", seedDigest)
+            || seedDigest != MD5::FromFile(seedFile).ToString())
+        {
+            Log(fmt::format("{0} does not match the package set\n", Q_(seedFile)));
+            return false;
+        }
+    }
+    catch (const MiKTeXException& e)
+    {
+        Log(fmt::format("{0} cannot be used: {1}\n", Q_(stampFile), e.GetErrorMessage()));
+        return false;
+    }
+    // a subsequent refresh only lists the directories which have been
+    // changed after the installation
+    RunOneMiKTeXUtility({ "fndb", "seed", seedFile.ToString() }, false);
+    return true;
+}
+
+void SetupServiceImpl::SaveFilenameDatabaseSeed(const string& layout)
+{
+    if (options.IsDryRun)
+    {
+        return;
+    }
+    PathName seedFile = options.LocalPackageRepository / FNDB_SEED_FILE_NAME;
+    PathName newSeedFile = seedFile;
+    newSeedFile.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+    try
+    {
+        RunOneMiKTeXUtility({ "fndb", "seed", "--save", newSeedFile.ToString() }, true);
+        unique_ptr<Cfg> stamp(Cfg::Create());
+        stamp->PutValue("seed", "layout", layout);
+        stamp->PutValue("seed", "md5", MD5::FromFile(newSeedFile).ToString());
+        // the digest rejects a seed which does not belong to the stamp
+        File::Move(newSeedFile, seedFile, { FileMoveOption::ReplaceExisting });
+        stamp->Write(options.LocalPackageRepository / FNDB_SEED_STAMP_FILE_NAME);
+    }
+    catch (const MiKTeXException& e)
+    {
+        // the package set may be read-only
+        Log(fmt::format("the file name database could not be kept with the package set: {0}\n", e.GetErrorMessage()));
+        if (File::Exists(newSeedFile))
+        {
+            File::Delete(newSeedFile, { FileDeleteOption::TryHard });
+        }
+    }
+}
+
 void SetupServiceImpl::ConfigureMiKTeX()
 {
     if (!callback->OnProgress(MiKTeX::Setup::Notification::ConfigureBegin))
@@ -1388,23 +1466,30 @@ void SetupServiceImpl::ConfigureMiKTeX()
 #endif
 
         // create file name database files
+        bool haveFndbSeed = false;
+        string fndbSeedLayout;
+        if (options.Task == SetupTask::InstallFromLocalRepository)
+        {
+            fndbSeedLayout = GetFndbSeedLayout();
+            haveFndbSeed = SeedFilenameDatabase(fndbSeedLayout);
+        }
         RunOneMiKTeXUtility({ "fndb", "refresh" }, false);
         if (cancelled)
         {
             return;
         }
-
-        // create latex.exe, ...
-        RunOneMiKTeXUtility({ "links", "install", "--force" }, false);
-        if (cancelled)
+        if (options.Task == SetupTask::InstallFromLocalRepository && !haveFndbSeed)
         {
-            return;
+            SaveFilenameDatabaseSeed(fndbSeedLayout);
         }
 
-        // create font map files and language.dat
-        RunOneMiKTeXUtility({ "fontmaps", "configure" }, false);
-        RunOneMiKTeXUtility({ "languages", "configure" }, false);
-
+        // create latex.exe, ..., font map files and language.dat: the steps
+        // depend on the file name database, but not on each other
+        RunOneMiKTeXUtilityConcurrently({
+            { "links", "install", "--force" },
+            { "fontmaps", "configure" },
+            { "languages", "configure" },
+        }, false);
         if (cancelled)
         {
             return;
@@ -1519,12 +1604,8 @@ void SetupServiceImpl::RunIniTeXMF(const vector<string>& args, bool mustSucceed)
     }
 }
 
-void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool mustSucceed)
+vector<string> SetupServiceImpl::MakeOneMiKTeXUtilityArguments(const PathName& exePath, const vector<string>& args)
 {
-    // make absolute exe path name
-    PathName exePath = GetBinDir() / MIKTEX_MIKTEX_EXE;
-
-    // make command line
     vector<string> allArgs{ exePath.GetFileNameWithoutExtension().ToString() };
     if (options.IsCommonSetup && session->IsAdminMode())
     {
@@ -1533,6 +1614,16 @@ void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool must
     allArgs.push_back("--disable-installer");
     allArgs.push_back("--verbose");
     allArgs.insert(allArgs.end(), args.begin(), args.end());
+    return allArgs;
+}
+
+void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool mustSucceed)
+{
+    // make absolute exe path name
+    PathName exePath = GetBinDir() / MIKTEX_MIKTEX_EXE;
+
+    // make command line
+    vector<string> allArgs = MakeOneMiKTeXUtilityArguments(exePath, args);
 
     // run One MiKTeX Utility
     if (!options.IsDryRun)
@@ -1556,6 +1647,55 @@ void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool must
     }
 }
 
+void SetupServiceImpl::RunOneMiKTeXUtilityConcurrently(const vector<vector<string>>& argsList, bool mustSucceed)
+{
+    // make absolute exe path name
+    PathName exePath = GetBinDir() / MIKTEX_MIKTEX_EXE;
+
+    // make command lines
+    vector<ProcessStartInfo> startInfos;
+    for (const vector<string>& args : argsList)
+    {
+        ProcessStartInfo startInfo(exePath);
+        startInfo.Arguments = MakeOneMiKTeXUtilityArguments(exePath, args);
+        startInfos.push_back(startInfo);
+    }
+
+    // run One MiKTeX Utility
+    if (!options.IsDryRun)
+    {
+        session->UnloadFilenameDatabase();
+        vector<ProcessRunResult> results = Process::RunAll(startInfos, startInfos.size());
+        // the output is logged in the order of the steps, not interleaved
+        for (size_t idx = 0; idx < results.size() && !cancelled; ++idx)
+        {
+            const ProcessRunResult& result = results[idx];
+            string commandLine = CommandLineBuilder(startInfos[idx].Arguments).ToString();
+            Log(fmt::format("{}:\n", commandLine));
+            if (!result.output.empty() && !OnProcessOutput(result.output.c_str(), result.output.length()))
+            {
+                break;
+            }
+            if (result.exitStatus != ProcessExitStatus::Exited || result.exitCode != 0)
+            {
+                MiKTeXException miktexException(
+                    exePath.GetFileNameWithoutExtension().ToString(),
+                    T_("The operation failed for some reason."),
+                    MiKTeXException::KVMAP("commandLine", commandLine, "exitCode", std::to_string(result.exitCode)),
+                    SourceLocation());
+                if (mustSucceed)
+                {
+                    throw miktexException;
+                }
+                else
+                {
+                    Warning(miktexException);
+                }
+            }
+        }
+    }
+}
+
 void SetupServiceImpl::RunMpm(const vector<string>& args)
 {
     // make absolute exe path name
@@ -2143,24 +2283,26 @@ vector<Issue> SetupServiceImpl::FindIssues(bool checkPath, bool checkPackageInte
     {
         unique_ptr<PackageIterator> pkgIter(packageManager->CreateIterator());
         PackageInfo packageInfo;
+        vector<string> toBeVerified;
         for (int idx = 0; pkgIter->GetNext(packageInfo); ++idx)
         {
             if (!packageInfo.IsPureContainer()
                 && packageInfo.IsInstalled()
                 && packageInfo.id.compare(0, 7, "miktex-") == 0)
             {
-                if (!(packageManager->TryVerifyInstalledPackage(packageInfo.id)))
-                {
-                    result.push_back({
-                      IssueType::PackageDamaged,
-                      IssueSeverity::Critical,
-                      fmt::format(T_("Package {0} has been tampered with."), packageInfo.id),
-                      "" // TODO
-                        });
-                }
+                toBeVerified.push_back(packageInfo.id);
             }
         }
         pkgIter->Dispose();
+        for (const string& packageId : packageManager->VerifyInstalledPackages(toBeVerified))
+        {
+            result.push_back({
+              IssueType::PackageDamaged,
+              IssueSeverity::Critical,
+              fmt::format(T_("Package {0} has been tampered with."), packageId),
+              "" // TODO
+                });
+        }
     }
     PathName issuesJson = session->GetSpecialPath(SpecialPath::ConfigRoot) / MIKTEX_PATH_ISSUES_JSON;
     Directory::Create(issuesJson.GetDirectoryName());
@@ -41,6 +41,7 @@
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
@@ -260,9 +261,14 @@ protected:
     bool OnProgress(MiKTeX::Packages::Notification nf) override;
     MiKTeX::Util::PathName GetInstallRoot() const;
     MiKTeX::Util::PathName GetBinDir() const;
+    std::string GetFndbSeedLayout();
+    bool SeedFilenameDatabase(const std::string& layout);
+    void SaveFilenameDatabaseSeed(const std::string& layout);
     void ConfigureMiKTeX();
     void RunIniTeXMF(const std::vector<std::string>& args, bool mustSucceed);
+    std::vector<std::string> MakeOneMiKTeXUtilityArguments(const MiKTeX::Util::PathName& exePath, const std::vector<std::string>& args);
     void RunOneMiKTeXUtility(const std::vector<std::string>& args, bool mustSucceed);
+    void RunOneMiKTeXUtilityConcurrently(const std::vector<std::vector<std::string>>& argsList, bool mustSucceed);
     void RunMpm(const std::vector<std::string>& args);
     std::wstring& Expand(const std::string& source, std::wstring& dest);
     bool FindFile(const MiKTeX::Util::PathName& fileName, MiKTeX::Util::PathName& result);
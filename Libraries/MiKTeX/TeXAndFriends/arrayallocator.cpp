@@ -0,0 +1,273 @@
+/**
+ * @file arrayallocator.cpp
+ * @author Christian Schenk
+ * @brief Allocator for the dynamic arrays of TeX & Friends
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(MIKTEX_WINDOWS)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Session>
+
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "arrayallocator.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+
+namespace
+{
+    // arrays smaller than this live on the heap
+    const size_t RESERVATION_THRESHOLD = 1024 * 1024;
+
+    // address space is cheap on 64-bit systems: leave room for growing
+    // an array to this multiple of its initial size
+    const size_t RESERVATION_FACTOR = sizeof(void*) >= 8 ? 4 : 1;
+}
+
+ArrayAllocator::ArrayAllocator() :
+    trace_mem(TraceStream::Open(MIKTEX_TRACE_MEM))
+{
+#if defined(MIKTEX_WINDOWS)
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    pageSize = systemInfo.dwPageSize;
+#else
+    long n = sysconf(_SC_PAGESIZE);
+    pageSize = n > 0 ? static_cast<size_t>(n) : 4096;
+#endif
+}
+
+void* ArrayAllocator::Reallocate(const string& arrayName, void* ptr, size_t size, const SourceLocation& sourceLocation)
+{
+    Block block;
+    bool known = false;
+    if (ptr != nullptr)
+    {
+        auto it = blocks.find(ptr);
+        if (it != blocks.end())
+        {
+            block = it->second;
+            blocks.erase(it);
+            known = true;
+        }
+    }
+    if (size == 0)
+    {
+        if (!known)
+        {
+            return MiKTeX::Debug::Realloc(ptr, 0, sourceLocation);
+        }
+        size_t highWaterMark = GetHighWaterMark(ptr, block);
+        ArrayStatistics& stats = statistics[block.arrayName];
+        stats.highWaterMark = max(stats.highWaterMark, highWaterMark);
+        if (block.reserved > 0)
+        {
+            trace_mem->WriteLine("libtexmf", fmt::format("{0}: reserved {1} bytes, high-water mark {2} bytes", block.arrayName, block.reserved, highWaterMark));
+            Release(ptr, block);
+        }
+        else
+        {
+            MiKTeX::Debug::Free(ptr, sourceLocation);
+        }
+        return nullptr;
+    }
+    if (known && block.reserved > 0)
+    {
+        if (size <= block.reserved)
+        {
+            // grow (or shrink) in place
+            Commit(ptr, block, size);
+            block.size = size;
+            blocks[ptr] = block;
+            UpdateStatistics(block, true);
+            return ptr;
+        }
+        Block newBlock;
+        newBlock.arrayName = arrayName;
+        void* newPtr = Reserve(newBlock, size);
+        memcpy(newPtr, ptr, block.size);
+        ArrayStatistics& stats = statistics[block.arrayName];
+        stats.highWaterMark = max(stats.highWaterMark, GetHighWaterMark(ptr, block));
+        Release(ptr, block);
+        blocks[newPtr] = newBlock;
+        UpdateStatistics(newBlock, true);
+        return newPtr;
+    }
+    if (size < RESERVATION_THRESHOLD || (ptr != nullptr && !known))
+    {
+        void* newPtr = MiKTeX::Debug::Realloc(ptr, size, sourceLocation);
+        block.arrayName = arrayName;
+        block.size = size;
+        block.reserved = 0;
+        block.committed = size;
+        blocks[newPtr] = block;
+        UpdateStatistics(block, ptr != nullptr);
+        return newPtr;
+    }
+    // the array is (or becomes) large enough for a reservation
+    Block newBlock;
+    newBlock.arrayName = arrayName;
+    void* newPtr = Reserve(newBlock, size);
+    if (ptr != nullptr)
+    {
+        memcpy(newPtr, ptr, min(block.size, size));
+        MiKTeX::Debug::Free(ptr, sourceLocation);
+    }
+    blocks[newPtr] = newBlock;
+    UpdateStatistics(newBlock, ptr != nullptr);
+    return newPtr;
+}
+
+void* ArrayAllocator::Reserve(Block& block, size_t size)
+{
+    size_t reserved = RoundUp(size) * RESERVATION_FACTOR;
+#if defined(MIKTEX_WINDOWS)
+    void* ptr = VirtualAlloc(nullptr, reserved, MEM_RESERVE, PAGE_NOACCESS);
+    if (ptr == nullptr)
+    {
+        MIKTEX_FATAL_WINDOWS_ERROR("VirtualAlloc");
+    }
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+    flags |= MAP_NORESERVE;
+#endif
+    void* ptr = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (ptr == MAP_FAILED)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("mmap", "size", std::to_string(reserved));
+    }
+#endif
+    block.size = 0;
+    block.reserved = reserved;
+    block.committed = 0;
+    Commit(ptr, block, size);
+    block.size = size;
+    trace_mem->WriteLine("libtexmf", fmt::format("{0}: reserved {1} bytes for {2} bytes", block.arrayName, reserved, size));
+    return ptr;
+}
+
+void ArrayAllocator::Commit(void* ptr, Block& block, size_t size)
+{
+    MIKTEX_ASSERT(size <= block.reserved);
+#if defined(MIKTEX_WINDOWS)
+    // Windows charges committed pages; physical memory is still not used
+    // before the pages are touched
+    size_t toBeCommitted = RoundUp(size);
+    if (toBeCommitted > block.committed)
+    {
+        if (VirtualAlloc(static_cast<char*>(ptr) + block.committed, toBeCommitted - block.committed, MEM_COMMIT, PAGE_READWRITE) == nullptr)
+        {
+            MIKTEX_FATAL_WINDOWS_ERROR("VirtualAlloc");
+        }
+        block.committed = toBeCommitted;
+    }
+#else
+    // the whole reservation is accessible; pages are backed on demand
+    block.committed = block.reserved;
+#endif
+}
+
+void ArrayAllocator::Release(void* ptr, const Block& block)
+{
+#if defined(MIKTEX_WINDOWS)
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, block.reserved);
+#endif
+}
+
+size_t ArrayAllocator::GetHighWaterMark(void* ptr, const Block& block) const
+{
+    if (block.reserved == 0)
+    {
+        return block.size;
+    }
+#if defined(MIKTEX_WINDOWS)
+    return min(block.committed, block.size);
+#else
+    // pages, once touched, stay with the reservation: count the pages
+    // which are resident
+    size_t numPages = block.reserved / pageSize;
+    vector<unsigned char> residency(numPages);
+#if defined(__APPLE__)
+    int ret = mincore(ptr, block.reserved, reinterpret_cast<char*>(residency.data()));
+#else
+    int ret = mincore(ptr, block.reserved, residency.data());
+#endif
+    if (ret != 0)
+    {
+        return block.size;
+    }
+    size_t mark = 0;
+    for (size_t idx = 0; idx < numPages; ++idx)
+    {
+        if ((residency[idx] & 1) != 0)
+        {
+            mark = (idx + 1) * pageSize;
+        }
+    }
+    return min(mark, block.size);
+#endif
+}
+
+void ArrayAllocator::UpdateStatistics(const Block& block, bool reallocation)
+{
+    ArrayStatistics& stats = statistics[block.arrayName];
+    stats.reserved = max(stats.reserved, block.reserved);
+    stats.maxSize = max(stats.maxSize, block.size);
+    if (reallocation)
+    {
+        stats.reallocations += 1;
+    }
+}
+
+void ArrayAllocator::Check(const void* ptr) const
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    auto it = blocks.find(const_cast<void*>(ptr));
+    if (it != blocks.end() && it->second.reserved > 0)
+    {
+        MIKTEX_ASSERT(it->second.size <= it->second.committed && it->second.committed <= it->second.reserved);
+        return;
+    }
+    MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(ptr);
+}
+
+map<string, ArrayAllocator::ArrayStatistics> ArrayAllocator::GetStatistics() const
+{
+    map<string, ArrayStatistics> result = statistics;
+    for (const auto& b : blocks)
+    {
+        ArrayStatistics& stats = result[b.second.arrayName];
+        stats.highWaterMark = max(stats.highWaterMark, GetHighWaterMark(b.first, b.second));
+    }
+    return result;
+}
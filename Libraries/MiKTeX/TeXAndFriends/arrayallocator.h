@@ -0,0 +1,115 @@
+/**
+ * @file arrayallocator.h
+ * @author Christian Schenk
+ * @brief Allocator for the dynamic arrays of TeX & Friends
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <miktex/Core/Debug>
+
+#include <miktex/Trace/TraceStream>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+/// Allocates the dynamic arrays (`mem`, `strpool`, `fontinfo`, ...).
+///
+/// Small arrays live on the heap.  Large arrays get their own reservation
+/// of address space: pages are backed by memory when they are touched for
+/// the first time, so generous limits do not cost anything until a
+/// document actually needs them.  The reservation leaves room for growing
+/// the array in place.
+class ArrayAllocator
+{
+
+public:
+
+    /// Usage statistics of one array.
+    struct ArrayStatistics
+    {
+        /// Size of the largest address space reservation, or zero if the
+        /// array has always lived on the heap.
+        std::size_t reserved = 0;
+
+        /// Largest size requested.
+        std::size_t maxSize = 0;
+
+        /// Largest number of bytes which were actually used.
+        std::size_t highWaterMark = 0;
+
+        /// Number of size changes after the initial allocation.
+        unsigned reallocations = 0;
+    };
+
+    ArrayAllocator();
+
+    ArrayAllocator(const ArrayAllocator& other) = delete;
+    ArrayAllocator& operator=(const ArrayAllocator& other) = delete;
+
+    /// Changes the size of an array; a size of zero frees the array.
+    void* Reallocate(const std::string& arrayName, void* ptr, std::size_t size, const MiKTeX::Core::SourceLocation& sourceLocation);
+
+    /// Gets the statistics of all arrays, including the ones which have
+    /// been freed.
+    std::map<std::string, ArrayStatistics> GetStatistics() const;
+
+    /// Checks an array in debug builds.  Arrays with an address space
+    /// reservation are not heap pointers: they are checked against their
+    /// reservation.
+    void Check(const void* ptr) const;
+
+private:
+
+    struct Block
+    {
+        std::string arrayName;
+
+        std::size_t size = 0;
+
+        // size of the address space reservation, or zero if the array
+        // lives on the heap
+        std::size_t reserved = 0;
+
+        // number of bytes which are backed by (committed) memory
+        std::size_t committed = 0;
+    };
+
+    void* Reserve(Block& block, std::size_t size);
+
+    void Commit(void* ptr, Block& block, std::size_t size);
+
+    void Release(void* ptr, const Block& block);
+
+    std::size_t GetHighWaterMark(void* ptr, const Block& block) const;
+
+    void UpdateStatistics(const Block& block, bool reallocation);
+
+    std::size_t RoundUp(std::size_t size) const
+    {
+        return (size + pageSize - 1) / pageSize * pageSize;
+    }
+
+    std::size_t pageSize;
+
+    std::unordered_map<void*, Block> blocks;
+
+    std::map<std::string, ArrayStatistics> statistics;
+
+    std::unique_ptr<MiKTeX::Trace::TraceStream> trace_mem;
+};
+
+END_INTERNAL_NAMESPACE;
@@ -77,8 +77,33 @@ public:
 #endif
     bool terminalIssue = false;
     Runtime runtime;
+    // isatty() is a system call: the answers for the standard streams are
+    // remembered
+    int terminalFd[2] = { -1, -1 };
+    bool isTerminal[2] = { false, false };
+    bool IsTerminal(int fd);
 };
 
+bool C4P::ProgramBase::impl::IsTerminal(int fd)
+{
+    for (int idx = 0; idx < 2; ++idx)
+    {
+        if (terminalFd[idx] == fd)
+        {
+            return isTerminal[idx];
+        }
+    }
+#if defined(MIKTEX_WINDOWS)
+    bool result = _isatty(fd) != 0;
+#else
+    bool result = isatty(fd) != 0;
+#endif
+    int idx = terminalFd[0] < 0 ? 0 : 1;
+    terminalFd[idx] = fd;
+    isTerminal[idx] = result;
+    return result;
+}
+
 C4P::ProgramBase::ProgramBase() :
     pimpl(make_unique<impl>())
 {
@@ -272,12 +297,7 @@ void C4P::ProgramBase::WriteChar(int ch, FILE* file)
     }
     int fdStdOut = (stdout != nullptr ? fileno(stdout) : -1);
     int fdStdErr = (stderr != nullptr ? fileno(stderr) : -1);
-    bool isTerminal = (fd == fdStdOut || fd == fdStdErr);
-#if defined(MIKTEX_WINDOWS)
-    isTerminal = isTerminal && _isatty(fd);
-#else
-    isTerminal = isTerminal && isatty(fd);
-#endif
+    bool isTerminal = (fd == fdStdOut || fd == fdStdErr) && pimpl->IsTerminal(fd);
 #if defined(MIKTEX_WINDOWS)
     if (static_cast<unsigned char>(ch) > 127 && isTerminal && GetConsoleOutputCP() != 65001)
     {
@@ -285,7 +305,12 @@ void C4P::ProgramBase::WriteChar(int ch, FILE* file)
         ch = FAILCHAR;
     }
 #endif
-    if (putc(ch, file) == EOF)
+#if defined(MIKTEX_WINDOWS)
+    int written = _putc_nolock(ch, file);
+#else
+    int written = putc_unlocked(ch, file);
+#endif
+    if (written == EOF)
     {
         int errCode = errno;
         if (!isTerminal)
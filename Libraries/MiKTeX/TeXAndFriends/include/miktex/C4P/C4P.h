@@ -16,6 +16,7 @@
 #include <miktex/C4P/config.h>
 
 #include <cctype>
+#include <charconv>
 #include <climits>
 #include <cmath>
 #include <csignal>
@@ -66,6 +67,12 @@ typedef float C4P_real;
 
 typedef double C4P_longreal;
 
+#if defined(_MSC_VER)
+#  define C4P_GETC(f) _getc_nolock(f)
+#else
+#  define C4P_GETC(f) getc_unlocked(f)
+#endif
+
 // assert (sizeof(bool) == 1)
 typedef bool C4P_boolean;
 
@@ -86,6 +93,7 @@ public:
         AssertValid();
         FILE* file = this->file;
         this->file = nullptr;
+        flags &= ~AtEnd;
         if ((flags & NotOwner) != 0)
         {
             std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
@@ -122,7 +130,7 @@ public:
 protected:
 
     FILE* file = nullptr;
-    enum { NotOwner = 0x00000001 };
+    enum { NotOwner = 0x00000001, AtEnd = 0x00000002 };
     unsigned flags = 0;
     MiKTeX::Util::PathName path;
 };
@@ -252,13 +260,38 @@ public:
     void Read()
     {
         PascalFileIO(true);
-        ReadInternal(&currentElement, 1);
+        if constexpr (sizeof(ElementType) == 1)
+        {
+            // byte files (tfm, pk, dvi, pool, ...) are read one element at
+            // a time: take the element directly from the stdio buffer
+            int ch = C4P_GETC(file);
+            if (ch != EOF)
+            {
+                currentElement = static_cast<ElementType>(ch);
+                flags &= ~AtEnd;
+                return;
+            }
+            if (ferror(file) != 0)
+            {
+                MIKTEX_FATAL_CRT_ERROR_2("getc", "path", path.ToString());
+            }
+            if ((flags & AtEnd) != 0)
+            {
+                MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Read operation failed: end of file reached"), "path", path.ToString(), "n", "1");
+            }
+            flags |= AtEnd;
+        }
+        else
+        {
+            ReadInternal(&currentElement, 1);
+        }
     }
 
     void Reset()
     {
         AssertValid();
         rewind(*this);
+        flags &= ~AtEnd;
         Read();
     }
 
@@ -266,6 +299,7 @@ public:
     {
         AssertValid();
         rewind(*this);
+        flags &= ~AtEnd;
     }
 
     void Write()
@@ -285,6 +319,7 @@ public:
         {
             MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString(), "offset", std::to_string(offset), "origin", std::to_string(origin));
         }
+        flags &= ~AtEnd;
         if (IsPascalFileIO() && !(origin == SEEK_END && offset == 0))
         {
             Read();
@@ -396,22 +431,42 @@ protected:
         return c4p_write_c(v, f);
     }
 
-    template<class Vt, class Ft> void c4p_write_i(Vt v, Ft& f)
+    /// Writes an integer like `fprintf(file, "%*ld", width, v)`, without
+    /// parsing a format string.
+    static void WriteInteger(long v, int width, FILE* file)
     {
-        f.AssertValid();
-        if (fprintf(f, "%ld", static_cast<long>(v)) < 0)
+        char digits[24];
+        std::size_t len = std::to_chars(digits, digits + sizeof(digits), v).ptr - digits;
+        for (int pad = width - static_cast<int>(len); pad > 0; --pad)
         {
-            MIKTEX_FATAL_CRT_ERROR("fprintf");
+            if (putc(' ', file) == EOF)
+            {
+                MIKTEX_FATAL_CRT_ERROR("putc");
+            }
+        }
+        if (fwrite(digits, 1, len, file) != len)
+        {
+            MIKTEX_FATAL_CRT_ERROR("fwrite");
+        }
+        for (int pad = -width - static_cast<int>(len); pad > 0; --pad)
+        {
+            if (putc(' ', file) == EOF)
+            {
+                MIKTEX_FATAL_CRT_ERROR("putc");
+            }
         }
     }
 
+    template<class Vt, class Ft> void c4p_write_i(Vt v, Ft& f)
+    {
+        f.AssertValid();
+        WriteInteger(static_cast<long>(v), 0, f);
+    }
+
     template<class Vt, class Ft> void c4p_write_i1(Vt v, int w1, Ft& f)
     {
         f.AssertValid();
-        if (fprintf(f, "%*ld", static_cast<int>(w1), static_cast<long>(v)) < 0)
-        {
-            MIKTEX_FATAL_CRT_ERROR("fprintf");
-        }
+        WriteInteger(static_cast<long>(v), static_cast<int>(w1), f);
     }
 
     template<class Vt, class Ft> void c4p_write_i2(Vt v, int w1, int w2, Ft& f)
@@ -633,17 +688,6 @@ protected:
         f.Read();
     }
 
-#if 0 // optimization?
-    template<> void get<BufferedFile<C4P_unsigned8>>(BufferedFile<C4P_unsigned8>&f)
-    {
-        *f = getc(f);
-        if (static_cast<int>(*f) == EOF)
-        {
-            MIKTEX_FATAL_CRT_ERROR("getc");
-        }
-    }
-#endif
-
     double ln(double x)
     {
         return log(x);
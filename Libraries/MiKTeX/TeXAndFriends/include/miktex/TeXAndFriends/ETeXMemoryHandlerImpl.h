@@ -49,9 +49,9 @@ public:
     void Check() override
     {
         TeXMemoryHandlerImpl<PROGRAM_CLASS>::Check();
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.eofseen);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.grpstack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.ifstack);
+        this->CheckArray(this->program.eofseen);
+        this->CheckArray(this->program.grpstack);
+        this->CheckArray(this->program.ifstack);
     }
 };
 
@@ -83,20 +83,20 @@ public:
     void Check() override
     {
         TeXMFMemoryHandlerImpl<PROGRAM_CLASS>::Check();
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.bisectstack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.delta);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.deltax);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.deltay);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.ligkern);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.psi);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.strref);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.theta);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.uu);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.vv);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.ww);
+        this->CheckArray(this->program.bisectstack);
+        this->CheckArray(this->program.delta);
+        this->CheckArray(this->program.deltax);
+        this->CheckArray(this->program.deltay);
+        this->CheckArray(this->program.ligkern);
+        this->CheckArray(this->program.psi);
+        this->CheckArray(this->program.strref);
+        this->CheckArray(this->program.theta);
+        this->CheckArray(this->program.uu);
+        this->CheckArray(this->program.vv);
+        this->CheckArray(this->program.ww);
 #if defined(TRAPMF)
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.c4p_free);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.wasfree);
+        this->CheckArray(this->program.c4p_free);
+        this->CheckArray(this->program.wasfree);
 #endif
     }
 };
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX TeXMF base implementation
  *
- * @copyright Copyright © 1996-2022 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -40,6 +40,8 @@ MIKTEX_TEXMF_BEGIN_NAMESPACE;
 enum class Feature
 {
     EightBitChars,
+    // the engine calls ServeJobs() after loading the format file
+    JobServer,
     TCX
 };
 
@@ -100,23 +102,35 @@ public:
     MIKTEXMFTHISAPI(bool) OpenFontFile(C4P::BufferedFile<unsigned char>* file, const std::string& fontName, MiKTeX::Core::FileType filetype, const char* generator);
     MIKTEXMFTHISAPI(bool) OpenMemoryDumpFile(const MiKTeX::Util::PathName& fileName, FILE** file, void* buf, std::size_t size, bool renew);
     MIKTEXMFTHISAPI(bool) ParseFirstLineP() const;
+    MIKTEXMFTHISAPI(bool) ServeJobs();
     MIKTEXMFTHISAPI(int) GetInteraction() const;
     MIKTEXMFTHISAPI(int) GetTeXStringLength(int stringNumber) const;
     MIKTEXMFTHISAPI(int) GetTeXStringStart(int stringNumber) const;
     MIKTEXMFTHISAPI(int) MakeTeXString(const char* lpsz) const;
     MIKTEXMFTHISAPI(std::string) GetTeXString(int stringStart, int stringLength) const;
     MIKTEXMFTHISAPI(void) AddOptions() override;
+    MIKTEXMFTHISAPI(void) CheckArrayMemory(const void* ptr) const;
+    MIKTEXMFTHISAPI(void) CloseFileInternal(FILE* file) override;
     MIKTEXMFTHISAPI(void) EnableFeature(Feature f);
     MIKTEXMFTHISAPI(void) Finalize() override;
     MIKTEXMFTHISAPI(void) Init(std::vector<char*>& args) override;
     MIKTEXMFTHISAPI(void) InitializeBuffer() const;
     MIKTEXMFTHISAPI(void) InvokeEditor(int editFileName, int editFileNameLength, int editLineNumber, int transcriptFileName, int transcriptFileNameLength) const;
+    MIKTEXMFTHISAPI(void) OnFinishShipOut();
+    MIKTEXMFTHISAPI(void) OnInputFileFound(const std::string& fileName, MiKTeX::Core::FileType fileType, const MiKTeX::Util::PathName& path) override;
+    MIKTEXMFTHISAPI(void) OnInputFileNotFound(const MiKTeX::Util::PathName& fileName) override;
+    MIKTEXMFTHISAPI(void) OnOpenOutputFile(const MiKTeX::Util::PathName& path) override;
+    MIKTEXMFTHISAPI(void) OnShellCommand() const override;
+    MIKTEXMFTHISAPI(void) OnStartShipOut();
     MIKTEXMFTHISAPI(void) ProcessCommandLineOptions() override;
+    MIKTEXMFTHISAPI(void) ReadMemoryDumpFile(FILE* file, void* buf, std::size_t size);
+    MIKTEXMFTHISAPI(void*) ReallocateArrayMemory(const std::string& arrayName, void* ptr, std::size_t size, const MiKTeX::Core::SourceLocation& sourceLocation);
     MIKTEXMFTHISAPI(void) SetErrorHandler(IErrorHandler* errorHandler);
     MIKTEXMFTHISAPI(void) SetStringHandler(IStringHandler* stringHandler);
     MIKTEXMFTHISAPI(void) SetTcxFileName(const MiKTeX::Util::PathName& tcxFileName);
     MIKTEXMFTHISAPI(void) SetTeXMFMemoryHandler(ITeXMFMemoryHandler* memoryHandler);
     MIKTEXMFTHISAPI(void) TouchJobOutputFile(FILE* file) const override;
+    MIKTEXMFTHISAPI(void) WriteMemoryDumpFile(FILE* file, const void* buf, std::size_t size);
     virtual MIKTEXMFTHISAPI(int) GetJobName(int fallbackJobName) const;
     virtual MIKTEXMFTHISAPI(void) OnTeXMFFinishJob();
     virtual MIKTEXMFTHISAPI(void) OnTeXMFStartJob();
@@ -194,10 +208,7 @@ public:
 
     template<typename FILE_, typename ELETYPE_> void Dump(FILE_& f, const ELETYPE_& e, std::size_t n)
     {
-        if (fwrite(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
-        {
-        MIKTEX_FATAL_CRT_ERROR("fwrite");
-        }
+        WriteMemoryDumpFile(static_cast<FILE*>(f), &e, sizeof(e) * n);
     }
 
     template<typename FILE_, typename ELETYPE_> void Dump(FILE_& f, const ELETYPE_& e)
@@ -208,10 +219,7 @@ public:
     template<typename FILE_, typename ELETYPE_> void Undump(FILE_& f, ELETYPE_& e, std::size_t n)
     {
         f.PascalFileIO(false);
-        if (fread(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
-        {
-        MIKTEX_FATAL_CRT_ERROR("fread");
-        }
+        ReadMemoryDumpFile(static_cast<FILE*>(f), &e, sizeof(e) * n);
     }
 
     template<typename FILE_, typename ELETYPE_> void Undump(FILE_& f, ELETYPE_& e)
@@ -286,6 +294,10 @@ protected:
 private:
 
     MIKTEXMFTHISAPI(void) CheckFirstLine(const MiKTeX::Util::PathName& fileName);
+    MIKTEXMFTHISAPI(MiKTeX::Util::PathName) GetJobFileName(const std::string& extension) const;
+    MIKTEXMFTHISAPI(void) RestoreCachedJob();
+    MIKTEXMFTHISAPI(void) WriteMemoryStatistics(MiKTeX::Trace::TraceStream* trace_mem) const;
+    MIKTEXMFTHISAPI(void) WriteOutputDigests() const;
 
 private:
 
@@ -348,6 +360,16 @@ inline int miktexmakefullnamestring()
     return TeXMFApp::GetTeXMFApp()->MakeFullNameString();
 }
 
+inline void miktexonfinishshipout()
+{
+    TeXMFApp::GetTeXMFApp()->OnFinishShipOut();
+}
+
+inline void miktexonstartshipout()
+{
+    TeXMFApp::GetTeXMFApp()->OnStartShipOut();
+}
+
 inline void miktexontexmffinishjob()
 {
     TeXMFApp::GetTeXMFApp()->OnTeXMFFinishJob();
@@ -363,6 +385,11 @@ inline void miktexontexmfstartjob()
     TeXMFApp::GetTeXMFApp()->OnTeXMFStartJob();
 }
 
+inline bool miktexservejobs()
+{
+    return TeXMFApp::GetTeXMFApp()->ServeJobs();
+}
+
 #define miktexreallocate(p, n) miktexreallocate_(#p, p, n, MIKTEX_SOURCE_LOCATION_DEBUG())
 
 template<typename T> T* miktexreallocate_(const std::string& arrayName, T* p, size_t n, const MiKTeX::Core::SourceLocation& sourceLocation)
@@ -417,6 +444,13 @@ inline void miktexcheckmemoryifdebug()
 #endif
 }
 
+template<typename T> inline void miktexprefetch(const T& x)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(&x);
+#endif
+}
+
 inline void miktexinitializechartables()
 {
     TeXMFApp::GetTeXMFApp()->InitializeCharTables();
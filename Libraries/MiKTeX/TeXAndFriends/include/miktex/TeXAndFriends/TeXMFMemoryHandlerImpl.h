@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX TeXMF memory handler implementation
  *
- * @copyright Copyright © 2017-2022 Christian Schenk
+ * @copyright Copyright © 2017-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -158,17 +158,17 @@ public:
 
     void Check() override
     {
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.buffer);
+        CheckArray(program.buffer);
 #if defined(MIKTEX_TEX_COMPILER)
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.yzmem);
+        CheckArray(program.yzmem);
 #else
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.mem);
+        CheckArray(program.mem);
 #endif
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.inputstack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.paramstack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.strpool);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.trickbuf);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.strstart);
+        CheckArray(program.inputstack);
+        CheckArray(program.paramstack);
+        CheckArray(program.strpool);
+        CheckArray(program.trickbuf);
+        CheckArray(program.strstart);
     }
 
     void* ReallocateArray(const std::string& arrayName, void* ptr, std::size_t elemSize, std::size_t numElem, const MiKTeX::Core::SourceLocation& sourceLocation) override
@@ -184,12 +184,18 @@ public:
             amount = (numElem + 1) * elemSize;
         }
         trace_mem->WriteLine("libtexmf", "reallocate " + arrayName + ": ptr == " + std::string(ptr == nullptr ? "nullptr" : "...") + ", elementSize == " + std::to_string(elemSize) + ", nElements == " + std::to_string(numElem));
-        ptr = MiKTeX::Debug::Realloc(ptr, amount, sourceLocation);
+        ptr = texmfapp.ReallocateArrayMemory(arrayName, ptr, amount, sourceLocation);
         return ptr;
     }
 
 protected:
 
+    // arrays are allocated by TeXMFApp: some of them are not heap pointers
+    void CheckArray(const void* ptr) const
+    {
+        texmfapp.CheckArrayMemory(ptr);
+    }
+
     int GetConfigValue(const std::string& valueName, int defaultValue) const
     {
         std::shared_ptr<MiKTeX::Core::Session> session = texmfapp.GetSession();
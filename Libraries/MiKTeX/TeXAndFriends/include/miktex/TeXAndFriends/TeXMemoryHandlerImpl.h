@@ -174,52 +174,52 @@ public:
     {
         TeXMFMemoryHandlerImpl<PROGRAM_CLASS>::Check();
 
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.linestack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.inputfile);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fullsourcefilenamestack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.sourcefilenamestack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.nest);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.savestack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.triec);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.triehash);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.triel);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.trieo);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.trier);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.trietaken);
-
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.hyphword);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.hyphlist);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.hyphlink);
-
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.trietrl);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.trietro);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.trietrc);
-
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.bcharlabel);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.charbase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.depthbase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.extenbase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontarea);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontbc);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontbchar);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontcheck);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontdsize);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontec);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontfalsebchar);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontglue);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontinfo);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontname);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontparams);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontsize);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontused);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.heightbase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.hyphenchar);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.italicbase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.kernbase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.ligkernbase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.parambase);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.skewchar);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.widthbase);
+        this->CheckArray(this->program.linestack);
+        this->CheckArray(this->program.inputfile);
+        this->CheckArray(this->program.fullsourcefilenamestack);
+        this->CheckArray(this->program.sourcefilenamestack);
+        this->CheckArray(this->program.nest);
+        this->CheckArray(this->program.savestack);
+        this->CheckArray(this->program.triec);
+        this->CheckArray(this->program.triehash);
+        this->CheckArray(this->program.triel);
+        this->CheckArray(this->program.trieo);
+        this->CheckArray(this->program.trier);
+        this->CheckArray(this->program.trietaken);
+
+        this->CheckArray(this->program.hyphword);
+        this->CheckArray(this->program.hyphlist);
+        this->CheckArray(this->program.hyphlink);
+
+        this->CheckArray(this->program.trietrl);
+        this->CheckArray(this->program.trietro);
+        this->CheckArray(this->program.trietrc);
+
+        this->CheckArray(this->program.bcharlabel);
+        this->CheckArray(this->program.charbase);
+        this->CheckArray(this->program.depthbase);
+        this->CheckArray(this->program.extenbase);
+        this->CheckArray(this->program.fontarea);
+        this->CheckArray(this->program.fontbc);
+        this->CheckArray(this->program.fontbchar);
+        this->CheckArray(this->program.fontcheck);
+        this->CheckArray(this->program.fontdsize);
+        this->CheckArray(this->program.fontec);
+        this->CheckArray(this->program.fontfalsebchar);
+        this->CheckArray(this->program.fontglue);
+        this->CheckArray(this->program.fontinfo);
+        this->CheckArray(this->program.fontname);
+        this->CheckArray(this->program.fontparams);
+        this->CheckArray(this->program.fontsize);
+        this->CheckArray(this->program.fontused);
+        this->CheckArray(this->program.heightbase);
+        this->CheckArray(this->program.hyphenchar);
+        this->CheckArray(this->program.italicbase);
+        this->CheckArray(this->program.kernbase);
+        this->CheckArray(this->program.ligkernbase);
+        this->CheckArray(this->program.parambase);
+        this->CheckArray(this->program.skewchar);
+        this->CheckArray(this->program.widthbase);
     }
 };
 
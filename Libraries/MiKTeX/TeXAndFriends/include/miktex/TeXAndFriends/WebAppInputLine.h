@@ -18,10 +18,13 @@
 #include <memory>
 #include <string>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/File>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
 #include <miktex/Util/PathName>
 
 #include <miktex/Util/StringUtil>
@@ -83,6 +86,7 @@ public:
     MIKTEXMFTHISAPI(MiKTeX::Util::PathName) GetFoundFile() const;
     MIKTEXMFTHISAPI(MiKTeX::Util::PathName) GetFoundFileFq() const;
     MIKTEXMFTHISAPI(MiKTeX::Util::PathName) GetOutputDirectory() const;
+    MIKTEXMFTHISAPI(std::vector<std::pair<MiKTeX::Util::PathName, MiKTeX::Core::MD5>>) GetOutputDigests() const;
     MIKTEXMFTHISAPI(bool) AllowFileName(const MiKTeX::Util::PathName & fileName, bool forInput);
     MIKTEXMFTHISAPI(bool) InputLine(C4P::C4P_text & f, C4P::C4P_boolean bypassEndOfLine) const;
     MIKTEXMFTHISAPI(bool) OpenInputFile(C4P::FileRoot & f, const MiKTeX::Util::PathName & fileNameInternalEncoding);
@@ -130,12 +134,18 @@ protected:
     MIKTEXMFTHISAPI(MiKTeX::Util::PathName) GetLastInputFileName() const;
     MIKTEXMFTHISAPI(bool) ProcessOption(int opt, const std::string& optArg) override;
     MIKTEXMFTHISAPI(void) AddOptions() override;
+    MIKTEXMFTHISAPI(void) EnableOutputDigests(bool enable);
     MIKTEXMFTHISAPI(void) EnableShellCommands(MiKTeX::Core::ShellCommandMode mode);
     virtual MIKTEXMFTHISAPI(void) TouchJobOutputFile(FILE*) const;
+    virtual MIKTEXMFTHISAPI(void) OnInputFileFound(const std::string& fileName, MiKTeX::Core::FileType fileType, const MiKTeX::Util::PathName& path);
+    virtual MIKTEXMFTHISAPI(void) OnInputFileNotFound(const MiKTeX::Util::PathName& fileName);
+    virtual MIKTEXMFTHISAPI(void) OnOpenOutputFile(const MiKTeX::Util::PathName& path);
+    virtual MIKTEXMFTHISAPI(void) OnShellCommand() const;
 
 private:
 
     virtual MIKTEXMFTHISAPI(void) BufferSizeExceeded() const;
+    MIKTEXMFTHISAPI(void) RecordOutputDigest(const MiKTeX::Util::PathName& path);
 
     class impl;
     std::unique_ptr<impl> pimpl;
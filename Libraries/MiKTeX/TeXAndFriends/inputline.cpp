@@ -19,6 +19,8 @@
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/CommandLineBuilder>
 
+#include <miktex/Trace/Profiler>
+
 #if defined(MIKTEX_TEXMF_SHARED)
 #   define C4PEXPORT MIKTEXDLLEXPORT
 #else
@@ -37,12 +39,15 @@
 
 #include "internal.h"
 
+#include "writebehind.h"
+
 using namespace std;
 
 using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Util;
 using namespace MiKTeX::TeXAndFriends;
+using namespace MiKTeX::Trace;
 
 struct Bom
 {
@@ -129,6 +134,11 @@ public:
     TriState allowInput = TriState::Undetermined;
     TriState allowOutput = TriState::Undetermined;
     unordered_map<const FILE*, OpenFileInfo> openFiles;
+    bool recordOutputDigests = false;
+    vector<pair<PathName, MD5>> outputDigests;
+    TriState writeBehind = TriState::Undetermined;
+    // keyed by the stream the engine writes into
+    unordered_map<const FILE*, unique_ptr<WriteBehindFile>> writeBehindFiles;
 };
 
 WebAppInputLine::WebAppInputLine() :
@@ -153,6 +163,10 @@ void WebAppInputLine::Finalize()
     pimpl->lastInputFileName.Clear();
     pimpl->outputDirectory.Clear();
     pimpl->auxDirectory.Clear();
+    pimpl->recordOutputDigests = false;
+    pimpl->outputDigests.clear();
+    pimpl->writeBehind = TriState::Undetermined;
+    pimpl->writeBehindFiles.clear();
     WebApp::Finalize();
 }
 
@@ -274,6 +288,7 @@ bool WebAppInputLine::OpenOutputFile(C4P::FileRoot& f, const PathName& fileNameI
         {
             LogWarn(fmt::format("executing unrestricted output pipe: {0}", toBeExecuted));
         }
+        OnShellCommand();
         file = OpenFileInternal(PathName(toBeExecuted), FileMode::Command, FileAccess::Write);
         pimpl->openFiles[file] = OpenFileInfo{ FileAccess::Write, FileMode::Command, PathName(toBeExecuted) };
     }
@@ -291,10 +306,22 @@ bool WebAppInputLine::OpenOutputFile(C4P::FileRoot& f, const PathName& fileNameI
             path = pimpl->outputDirectory / fileName.ToString();
             fileName = path.GetData();
         }
+        OnOpenOutputFile(fileName);
         file = TryOpenFileInternal(fileName, FileMode::Create, FileAccess::Write);
         if (file != nullptr)
         {
             outPath = fileName;
+            if (pimpl->writeBehind == TriState::Undetermined)
+            {
+                pimpl->writeBehind = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_WRITE_BEHIND_OUTPUT, ConfigValue(false)).GetBool() ? TriState::True : TriState::False;
+            }
+            // pdfTeX seeks in the PDF file: only DVI files are written behind
+            if (pimpl->writeBehind == TriState::True && outPath.HasExtension(".dvi"))
+            {
+                auto writeBehindFile = make_unique<WriteBehindFile>(file, outPath);
+                file = writeBehindFile->GetEngineFile();
+                pimpl->writeBehindFiles[file] = std::move(writeBehindFile);
+            }
             pimpl->openFiles[file] = OpenFileInfo{ FileAccess::Write,  FileMode::Create, outPath };
         }
     }
@@ -324,6 +351,8 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
 {
     auto fileName = DecodeFileName(fileNameInternalEncoding);
 
+    ProfileScope profileScope("texmf", "open input", fileName.ToString());
+
     shared_ptr<Session> session = GetSession();
 
     if (fileName[0] == '|')
@@ -367,6 +396,7 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
             MIKTEX_UNEXPECTED();
         }
         LogInfo("executing input pipe: " + toBeExecuted);
+        OnShellCommand();
         *ppFile = OpenFileInternal(PathName(toBeExecuted), FileMode::Command, FileAccess::Read);
         pimpl->openFiles[*ppFile] = OpenFileInfo{ FileAccess::Read,  FileMode::Command, PathName(toBeExecuted) };
         pimpl->foundFile.Clear();
@@ -376,9 +406,12 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
     {
         if (!session->FindFile(fileName.GetData(), GetInputFileType(), pimpl->foundFile))
         {
+            OnInputFileNotFound(fileName);
             return false;
         }
 
+        OnInputFileFound(fileName.ToString(), GetInputFileType(), pimpl->foundFile);
+
         pimpl->foundFileFq = pimpl->foundFile;
         pimpl->foundFileFq.MakeFullyQualified();
 
@@ -394,6 +427,7 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
         {
             if (pimpl->foundFile.HasExtension(".gz"))
             {
+                OnShellCommand();
                 CommandLineBuilder cmd("zcat");
                 cmd.AppendArgument(pimpl->foundFile);
                 *ppFile = OpenFileInternal(PathName(cmd.ToString()), FileMode::Command, FileAccess::Read);
@@ -401,6 +435,7 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
             }
             else if (pimpl->foundFile.HasExtension(".bz2"))
             {
+                OnShellCommand();
                 CommandLineBuilder cmd("bzcat");
                 cmd.AppendArgument(pimpl->foundFile);
                 *ppFile = OpenFileInternal(PathName(cmd.ToString()), FileMode::Command, FileAccess::Read);
@@ -408,6 +443,7 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
             }
             else if (pimpl->foundFile.HasExtension(".xz") || pimpl->foundFile.HasExtension(".lzma"))
             {
+                OnShellCommand();
                 CommandLineBuilder cmd("xzcat");
                 cmd.AppendArgument(pimpl->foundFile);
                 *ppFile = OpenFileInternal(PathName(cmd.ToString()), FileMode::Command, FileAccess::Read);
@@ -484,26 +520,93 @@ bool WebAppInputLine::OpenInputFile(C4P::FileRoot& f, const PathName& fileNameIn
 void WebAppInputLine::CloseFile(C4P::FileRoot& f)
 {
     f.AssertValid();
+    ProfileScope profileScope("texmf", "close file");
     unordered_map<const FILE*, OpenFileInfo>::iterator it = pimpl->openFiles.find(f);
     bool isCommand = false;
     bool isOutput = false;
+    PathName path;
     if (it != pimpl->openFiles.end())
     {
         isCommand = (it->second.mode == FileMode::Command);
         isOutput = (it->second.access == FileAccess::Write);
+        path = it->second.path;
         pimpl->openFiles.erase(it);
     }
+    FILE* file = f;
+    auto writeBehindFile = pimpl->writeBehindFiles.find(file);
+    if (writeBehindFile != pimpl->writeBehindFiles.end())
+    {
+        // waits for the data: write errors are reported here
+        unique_ptr<WriteBehindFile> wbf = std::move(writeBehindFile->second);
+        pimpl->writeBehindFiles.erase(writeBehindFile);
+        file = wbf->Finish();
+    }
     if (isOutput)
     {
-        TouchJobOutputFile(f);
+        TouchJobOutputFile(file);
+    }
+    CloseFileInternal(file);
+    if (isOutput && !isCommand && pimpl->recordOutputDigests && !IsOutputFile(path))
+    {
+        RecordOutputDigest(path);
+    }
+}
+
+void WebAppInputLine::RecordOutputDigest(const PathName& path)
+{
+    // the file has just been written: reading it back is served by the file cache
+    MD5 md5;
+    try
+    {
+        md5 = MD5::FromFile(path);
+    }
+    catch (const MiKTeXException& e)
+    {
+        LogWarn(fmt::format("cannot digest output file {0}: {1}", path.ToString(), e.GetErrorMessage()));
+        return;
+    }
+    for (auto& od : pimpl->outputDigests)
+    {
+        if (od.first == path)
+        {
+            // the file has been written more than once: the last write counts
+            od.second = md5;
+            return;
+        }
     }
-    CloseFileInternal(f);
+    pimpl->outputDigests.push_back(make_pair(path, md5));
+}
+
+void WebAppInputLine::EnableOutputDigests(bool enable)
+{
+    pimpl->recordOutputDigests = enable;
+}
+
+vector<pair<PathName, MD5>> WebAppInputLine::GetOutputDigests() const
+{
+    return pimpl->outputDigests;
 }
 
 void WebAppInputLine::TouchJobOutputFile(FILE*) const
 {
 }
 
+void WebAppInputLine::OnInputFileFound(const string& fileName, FileType fileType, const PathName& path)
+{
+}
+
+void WebAppInputLine::OnInputFileNotFound(const PathName& fileName)
+{
+}
+
+void WebAppInputLine::OnOpenOutputFile(const PathName& path)
+{
+}
+
+void WebAppInputLine::OnShellCommand() const
+{
+}
+
 void WebAppInputLine::SetOutputDirectory(const PathName& path)
 {
     if (pimpl->outputDirectory == path)
@@ -622,10 +725,13 @@ void WebAppInputLine::BufferSizeExceeded() const
 size_t WebAppInputLine::InputLineInternal(FILE* f, char* buffer, char* buffer2, size_t bufferSize, size_t bufferPosition, int& lastChar) const
 {
     MIKTEX_ASSERT(buffer2 == nullptr);
+    // lock the stream once per line: the unlocked getc reads straight from
+    // the stdio buffer
+    StdioFileLock lock(f);
     do
     {
         errno = 0;
-        while (bufferPosition < bufferSize && (lastChar = GetC(f)) != EOF && lastChar != '\n' && lastChar != '\r')
+        while (bufferPosition < bufferSize && (lastChar = GetCUnlocked(f)) != EOF && lastChar != '\n' && lastChar != '\r')
         {
             buffer[bufferPosition++] = lastChar;
         }
@@ -51,6 +51,48 @@ inline int GetC(FILE* file)
     return ch;
 }
 
+// the caller must hold the stream lock (see StdioFileLock)
+inline int GetCUnlocked(FILE* file)
+{
+    MIKTEX_ASSERT(file != nullptr);
+#if defined(MIKTEX_WINDOWS)
+    int ch = _getc_nolock(file);
+#else
+    int ch = getc_unlocked(file);
+#endif
+    if (ch == EOF && ferror(file) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("getc");
+    }
+    return ch;
+}
+
+class StdioFileLock
+{
+public:
+    explicit StdioFileLock(FILE* file) :
+        file(file)
+    {
+#if defined(MIKTEX_WINDOWS)
+        _lock_file(file);
+#else
+        flockfile(file);
+#endif
+    }
+    StdioFileLock(const StdioFileLock& other) = delete;
+    StdioFileLock& operator=(const StdioFileLock& other) = delete;
+    ~StdioFileLock()
+    {
+#if defined(MIKTEX_WINDOWS)
+        _unlock_file(file);
+#else
+        funlockfile(file);
+#endif
+    }
+private:
+    FILE* file;
+};
+
 END_INTERNAL_NAMESPACE;
 
 
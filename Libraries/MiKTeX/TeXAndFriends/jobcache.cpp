@@ -0,0 +1,419 @@
+/**
+ * @file jobcache.cpp
+ * @author Christian Schenk
+ * @brief Cache of job outputs
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/StreamReader>
+#include <miktex/Core/StreamWriter>
+
+#include "internal.h"
+
+#include "jobcache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    struct CachedFile
+    {
+        PathName path;
+        MD5 md5;
+        size_t size = 0;
+    };
+
+    struct CachedLookup
+    {
+        string fileName;
+        FileType fileType;
+        PathName path;
+    };
+
+    size_t MaxConcurrency()
+    {
+        return std::max<size_t>(1, thread::hardware_concurrency());
+    }
+}
+
+JobCache::JobCache(const PathName& directory, const vector<string>& keyFields) :
+    directory(directory),
+    startTime(time(nullptr))
+{
+    string s;
+    for (const string& field : keyFields)
+    {
+        s += field;
+        s += '\n';
+    }
+    key = MD5::FromChars(s).ToString();
+}
+
+PathName JobCache::GetObjectPath(const MD5& md5) const
+{
+    return directory / "objects" / md5.ToString();
+}
+
+void JobCache::WriteAtomically(const PathName& source, const PathName& dest) const
+{
+    PathName destDir = dest.GetDirectoryName();
+    Directory::Create(destDir);
+    PathName temp;
+    temp.SetToTempFile(destDir);
+    try
+    {
+        File::Copy(source, temp, { FileCopyOption::ReplaceExisting });
+        File::Move(temp, dest, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const MiKTeXException&)
+    {
+        if (File::Exists(temp))
+        {
+            File::Delete(temp);
+        }
+        throw;
+    }
+}
+
+void JobCache::StoreObject(const PathName& path, const MD5& md5) const
+{
+    PathName objectPath = GetObjectPath(md5);
+    // objects are never changed: the same digest means the same contents
+    if (!File::Exists(objectPath))
+    {
+        WriteAtomically(path, objectPath);
+    }
+}
+
+bool JobCache::Restore(function<bool(const string&, FileType, PathName&)> findFile, vector<FileInfoRecord>& records)
+{
+    PathName manifestPath = directory / "jobs" / key;
+    if (!File::Exists(manifestPath))
+    {
+        return false;
+    }
+    vector<CachedFile> inputs;
+    vector<CachedLookup> found;
+    vector<CachedLookup> missing;
+    vector<CachedFile> outputs;
+    try
+    {
+        StreamReader reader(manifestPath);
+        string line;
+        while (reader.ReadLine(line))
+        {
+            string::size_type eq = line.find('=');
+            if (eq == string::npos)
+            {
+                return false;
+            }
+            string name = line.substr(0, eq);
+            string value = line.substr(eq + 1);
+            if (name == "found" || name == "missing")
+            {
+                string::size_type space = value.find(' ');
+                if (space == string::npos)
+                {
+                    return false;
+                }
+                int fileType = std::stoi(value.substr(0, space));
+                if (fileType <= static_cast<int>(FileType::None) || fileType >= static_cast<int>(FileType::E_N_D))
+                {
+                    return false;
+                }
+                CachedLookup lookup;
+                lookup.fileType = static_cast<FileType>(fileType);
+                lookup.fileName = value.substr(space + 1);
+                if (name == "found")
+                {
+                    string::size_type tab = lookup.fileName.find('\t');
+                    if (tab == string::npos)
+                    {
+                        return false;
+                    }
+                    lookup.path = PathName(lookup.fileName.substr(tab + 1));
+                    lookup.fileName.erase(tab);
+                    found.push_back(lookup);
+                }
+                else
+                {
+                    missing.push_back(lookup);
+                }
+                continue;
+            }
+            CachedFile cachedFile;
+            if (value.length() < 34 || value[32] != ' ')
+            {
+                return false;
+            }
+            cachedFile.md5 = MD5::Parse(value.substr(0, 32));
+            value = value.substr(33);
+            if (name == "input")
+            {
+                string::size_type space = value.find(' ');
+                if (space == string::npos)
+                {
+                    return false;
+                }
+                cachedFile.size = std::stoull(value.substr(0, space));
+                cachedFile.path = PathName(value.substr(space + 1));
+                inputs.push_back(cachedFile);
+            }
+            else if (name == "output")
+            {
+                cachedFile.path = PathName(value);
+                outputs.push_back(cachedFile);
+            }
+        }
+        reader.Close();
+
+        // cheap checks first
+        vector<PathName> inputPaths;
+        for (const CachedFile& input : inputs)
+        {
+            if (!File::Exists(input.path) || File::GetSize(input.path) != input.size)
+            {
+                return false;
+            }
+            inputPaths.push_back(input.path);
+        }
+        // the same names must resolve to the same files
+        for (const CachedLookup& lookup : found)
+        {
+            PathName path;
+            if (!findFile(lookup.fileName, lookup.fileType, path))
+            {
+                return false;
+            }
+            path.MakeFullyQualified();
+            if (path != lookup.path)
+            {
+                return false;
+            }
+        }
+        for (const CachedLookup& lookup : missing)
+        {
+            PathName path;
+            if (findFile(lookup.fileName, lookup.fileType, path))
+            {
+                return false;
+            }
+        }
+        for (const CachedFile& output : outputs)
+        {
+            if (!File::Exists(GetObjectPath(output.md5)))
+            {
+                return false;
+            }
+        }
+        vector<MD5> digests = MD5::FromFiles(inputPaths, MaxConcurrency());
+        for (size_t idx = 0; idx < inputs.size(); ++idx)
+        {
+            if (digests[idx] != inputs[idx].md5)
+            {
+                return false;
+            }
+        }
+
+        for (const CachedFile& output : outputs)
+        {
+            WriteAtomically(GetObjectPath(output.md5), output.path);
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+        return false;
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+    records.clear();
+    for (const CachedFile& input : inputs)
+    {
+        records.push_back(FileInfoRecord{ input.path.ToString(), "", FileAccess::Read });
+    }
+    for (const CachedFile& output : outputs)
+    {
+        records.push_back(FileInfoRecord{ output.path.ToString(), "", FileAccess::Write });
+    }
+    return true;
+}
+
+void JobCache::NoteOutputFile(const PathName& path)
+{
+    PathName fqPath(path);
+    fqPath.MakeFullyQualified();
+    for (const PriorState& priorState : priorStates)
+    {
+        if (priorState.path == fqPath)
+        {
+            return;
+        }
+    }
+    PriorState priorState;
+    priorState.path = fqPath;
+    try
+    {
+        if (File::Exists(fqPath))
+        {
+            priorState.md5 = MD5::FromFile(fqPath);
+            priorState.size = File::GetSize(fqPath);
+            priorState.existed = true;
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+        disabled = true;
+        return;
+    }
+    priorStates.push_back(priorState);
+}
+
+void JobCache::NoteFoundInputFile(const string& fileName, FileType fileType, const PathName& path)
+{
+    auto it = std::find_if(foundInputFiles.begin(), foundInputFiles.end(), [&](const Lookup& lookup) { return lookup.fileName == fileName && lookup.fileType == fileType; });
+    if (it == foundInputFiles.end())
+    {
+        PathName fqPath(path);
+        fqPath.MakeFullyQualified();
+        foundInputFiles.push_back(Lookup{ fileName, fileType, fqPath });
+    }
+}
+
+void JobCache::NoteMissingInputFile(const string& fileName, FileType fileType)
+{
+    auto it = std::find_if(missingInputFiles.begin(), missingInputFiles.end(), [&](const Lookup& lookup) { return lookup.fileName == fileName && lookup.fileType == fileType; });
+    if (it == missingInputFiles.end())
+    {
+        missingInputFiles.push_back(Lookup{ fileName, fileType, PathName() });
+    }
+}
+
+void JobCache::Store(const vector<FileInfoRecord>& records)
+{
+    if (disabled)
+    {
+        return;
+    }
+
+    // a file which is written by the job is an input only if it has been
+    // read before it was written, e.g., the .aux file
+    vector<CachedFile> inputs;
+    vector<PathName> inputPaths;
+    vector<CachedFile> outputs;
+    vector<PathName> outputPaths;
+    unordered_set<string> read;
+    unordered_set<string> written;
+    for (const FileInfoRecord& record : records)
+    {
+        PathName path(record.fileName);
+        path.MakeFullyQualified();
+        string s = path.ToString();
+        if (record.access == FileAccess::Write)
+        {
+            if (written.insert(s).second)
+            {
+                outputPaths.push_back(path);
+            }
+        }
+        else if (record.access == FileAccess::Read && written.find(s) == written.end() && read.insert(s).second)
+        {
+            inputPaths.push_back(path);
+        }
+    }
+
+    try
+    {
+        vector<PathName> unchangedInputPaths;
+        for (const PathName& path : inputPaths)
+        {
+            if (written.find(path.ToString()) != written.end())
+            {
+                auto priorState = std::find_if(priorStates.begin(), priorStates.end(), [&path](const PriorState& ps) { return ps.path == path; });
+                if (priorState == priorStates.end() || !priorState->existed)
+                {
+                    // written behind our back
+                    return;
+                }
+                inputs.push_back(CachedFile{ path, priorState->md5, priorState->size });
+            }
+            else
+            {
+                if (!File::Exists(path) || File::GetLastWriteTime(path) >= startTime)
+                {
+                    // changed while the job was running
+                    return;
+                }
+                unchangedInputPaths.push_back(path);
+            }
+        }
+        vector<MD5> digests = MD5::FromFiles(unchangedInputPaths, MaxConcurrency());
+        for (size_t idx = 0; idx < unchangedInputPaths.size(); ++idx)
+        {
+            inputs.push_back(CachedFile{ unchangedInputPaths[idx], digests[idx], File::GetSize(unchangedInputPaths[idx]) });
+        }
+
+        vector<PathName> existingOutputPaths;
+        for (const PathName& path : outputPaths)
+        {
+            // a removed file, e.g., a temporary file
+            if (File::Exists(path))
+            {
+                existingOutputPaths.push_back(path);
+            }
+        }
+        digests = MD5::FromFiles(existingOutputPaths, MaxConcurrency());
+        for (size_t idx = 0; idx < existingOutputPaths.size(); ++idx)
+        {
+            StoreObject(existingOutputPaths[idx], digests[idx]);
+            outputs.push_back(CachedFile{ existingOutputPaths[idx], digests[idx] });
+        }
+
+        // the manifest comes last: it refers to existing objects only
+        PathName jobsDir = directory / "jobs";
+        Directory::Create(jobsDir);
+        PathName temp;
+        temp.SetToTempFile(jobsDir);
+        StreamWriter writer(temp);
+        for (const CachedFile& input : inputs)
+        {
+            writer.WriteLine(fmt::format("input={0} {1} {2}", input.md5.ToString(), input.size, input.path.ToString()));
+        }
+        for (const Lookup& lookup : foundInputFiles)
+        {
+            writer.WriteLine(fmt::format("found={0} {1}\t{2}", static_cast<int>(lookup.fileType), lookup.fileName, lookup.path.ToString()));
+        }
+        for (const Lookup& lookup : missingInputFiles)
+        {
+            writer.WriteLine(fmt::format("missing={0} {1}", static_cast<int>(lookup.fileType), lookup.fileName));
+        }
+        for (const CachedFile& output : outputs)
+        {
+            writer.WriteLine(fmt::format("output={0} {1}", output.md5.ToString(), output.path.ToString()));
+        }
+        writer.Close();
+        File::Move(temp, jobsDir / key, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const MiKTeXException&)
+    {
+        // the job is not cached
+    }
+}
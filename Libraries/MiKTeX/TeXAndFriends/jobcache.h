@@ -0,0 +1,124 @@
+/**
+ * @file jobcache.h
+ * @author Christian Schenk
+ * @brief Cache of job outputs
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#include <ctime>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/MD5>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+/// Caches the output files of successful jobs.
+///
+/// A job is identified by a key, which is made up of the engine, the
+/// command line, and the working directory.  For each key, the cache
+/// directory contains a manifest `jobs/KEY`:
+///
+///     input=MD5 SIZE /home/joe/thesis/thesis.tex
+///     found=FILETYPE chapter1<TAB>/home/joe/thesis/chapter1.tex
+///     missing=FILETYPE thesis.toc
+///     output=MD5 /home/joe/thesis/thesis.pdf
+///
+/// `found` lines record how file names have been resolved: a file which
+/// now shadows the recorded one (or a changed search path) invalidates the
+/// job.  `missing` lines record input files which could not be found.  The
+/// contents of the output files are stored in `objects/MD5`.  Files are
+/// moved into place, i.e., several processes (or machines sharing the
+/// directory) can use the cache at the same time.
+///
+/// The caller must make sure that the job does not depend on the current
+/// date and time.
+class JobCache
+{
+
+public:
+
+    JobCache(const MiKTeX::Util::PathName& directory, const std::vector<std::string>& keyFields);
+
+    JobCache(const JobCache& other) = delete;
+    JobCache& operator=(const JobCache& other) = delete;
+
+    /// Restores the output files of a cached job, if the inputs of the job
+    /// are unchanged.
+    /// @param findFile Resolves a file name the way the job would.
+    /// @param[out] records The inputs and outputs of the restored job.
+    /// @return Returns `true`, if the output files have been restored.
+    bool Restore(std::function<bool(const std::string&, MiKTeX::Core::FileType, MiKTeX::Util::PathName&)> findFile, std::vector<MiKTeX::Core::FileInfoRecord>& records);
+
+    /// Takes note of an output file which is about to be created.
+    void NoteOutputFile(const MiKTeX::Util::PathName& path);
+
+    /// Takes note of a resolved file name.
+    void NoteFoundInputFile(const std::string& fileName, MiKTeX::Core::FileType fileType, const MiKTeX::Util::PathName& path);
+
+    /// Takes note of an input file which could not be found.
+    void NoteMissingInputFile(const std::string& fileName, MiKTeX::Core::FileType fileType);
+
+    /// Marks the job as not cacheable, e.g., because it has run a shell
+    /// command.
+    void Disable()
+    {
+        disabled = true;
+    }
+
+    /// Stores the output files of the finished job.
+    /// @param records The recorded inputs and outputs of the job.
+    void Store(const std::vector<MiKTeX::Core::FileInfoRecord>& records);
+
+private:
+
+    struct Lookup
+    {
+        std::string fileName;
+        MiKTeX::Core::FileType fileType;
+        MiKTeX::Util::PathName path;
+    };
+
+    struct PriorState
+    {
+        MiKTeX::Util::PathName path;
+        bool existed = false;
+        MiKTeX::Core::MD5 md5;
+        std::size_t size = 0;
+    };
+
+    MiKTeX::Util::PathName GetObjectPath(const MiKTeX::Core::MD5& md5) const;
+
+    void StoreObject(const MiKTeX::Util::PathName& path, const MiKTeX::Core::MD5& md5) const;
+
+    void WriteAtomically(const MiKTeX::Util::PathName& source, const MiKTeX::Util::PathName& dest) const;
+
+    MiKTeX::Util::PathName directory;
+
+    std::string key;
+
+    time_t startTime;
+
+    bool disabled = false;
+
+    // the output files as they were before the job wrote them
+    std::vector<PriorState> priorStates;
+
+    std::vector<Lookup> foundInputFiles;
+
+    std::vector<Lookup> missingInputFiles;
+};
+
+END_INTERNAL_NAMESPACE;
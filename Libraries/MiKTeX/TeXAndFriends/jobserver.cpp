@@ -0,0 +1,347 @@
+/**
+ * @file jobserver.cpp
+ * @author Christian Schenk
+ * @brief Preforked job server
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#if defined(MIKTEX_UNIX)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Session>
+#include <miktex/Core/Text>
+
+#include "internal.h"
+
+#include "jobserver.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    // max size of a job request
+    const size_t MAX_REQUEST_SIZE = 64 * 1024;
+
+    // milliseconds between two checks for a stop request
+    const int POLL_TIMEOUT = 200;
+}
+
+#if defined(MIKTEX_UNIX)
+
+STATICFUNC(void) SetCloseOnExec(int fd)
+{
+    int flags = fcntl(fd, F_GETFD);
+    if (flags < 0 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC) < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fcntl");
+    }
+}
+
+STATICFUNC(void) Send(int fd, const string& s)
+{
+    int flags = 0;
+#if defined(MSG_NOSIGNAL)
+    flags |= MSG_NOSIGNAL;
+#endif
+    // the client may have gone away: ignore errors
+    (void)send(fd, s.c_str(), s.length(), flags);
+}
+
+JobServer::JobServer(const PathName& socketPath) :
+    socketPath(socketPath)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.GetLength() >= sizeof(address.sun_path))
+    {
+        MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("The socket path is too long."), "path", socketPath.ToString());
+    }
+    memcpy(address.sun_path, socketPath.GetData(), socketPath.GetLength());
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("socket");
+    }
+    SetCloseOnExec(listener);
+    // remove the socket left behind by a server which has not been stopped
+    // in an orderly fashion
+    struct stat statbuf;
+    if (lstat(socketPath.GetData(), &statbuf) == 0 && S_ISSOCK(statbuf.st_mode))
+    {
+        unlink(socketPath.GetData());
+    }
+    // only the owner may submit jobs
+    mode_t oldMask = umask(0077);
+    int ret = ::bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    umask(oldMask);
+    if (ret < 0)
+    {
+        int error = errno;
+        close(listener);
+        listener = -1;
+        errno = error;
+        MIKTEX_FATAL_CRT_ERROR_2("bind", "path", socketPath.ToString());
+    }
+    if (listen(listener, SOMAXCONN) < 0)
+    {
+        Close();
+        MIKTEX_FATAL_CRT_ERROR("listen");
+    }
+}
+
+JobServer::~JobServer()
+{
+    try
+    {
+        Close();
+        ReapJobs(true);
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+void JobServer::Close()
+{
+    if (listener < 0)
+    {
+        return;
+    }
+    close(listener);
+    listener = -1;
+    unlink(socketPath.GetData());
+}
+
+bool JobServer::Serve(function<bool()> stopRequested, JobRequest& request)
+{
+    MIKTEX_ASSERT(listener >= 0);
+    while (!stopRequested())
+    {
+        ReapJobs(false);
+        struct pollfd pfd;
+        pfd.fd = listener;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int n = poll(&pfd, 1, POLL_TIMEOUT);
+        if (n < 0 && errno != EINTR)
+        {
+            MIKTEX_FATAL_CRT_ERROR("poll");
+        }
+        if (n <= 0)
+        {
+            continue;
+        }
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN)
+            {
+                continue;
+            }
+            MIKTEX_FATAL_CRT_ERROR("accept");
+        }
+        SetCloseOnExec(connection);
+        // buffered output would be written twice
+        fflush(nullptr);
+        // the session's background threads must not be running while forking
+        shared_ptr<Session> session = Session::Get();
+        session->BeforeFork();
+        pid_t pid = fork();
+        int error = errno;
+        session->AfterFork(pid == 0);
+        if (pid < 0)
+        {
+            close(connection);
+            errno = error;
+            MIKTEX_FATAL_CRT_ERROR("fork");
+        }
+        if (pid > 0)
+        {
+            jobs[pid] = connection;
+            continue;
+        }
+        // this is the job process: let go of the server's resources
+        close(listener);
+        listener = -1;
+        socketPath = "";
+        for (const auto& job : jobs)
+        {
+            close(job.second);
+        }
+        jobs.clear();
+        // the client sees the terminal output (and error messages)
+        if (dup2(connection, STDOUT_FILENO) < 0 || dup2(connection, STDERR_FILENO) < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("dup2");
+        }
+        ReadRequest(connection, request);
+        close(connection);
+        int devNull = open("/dev/null", O_RDONLY);
+        if (devNull < 0 || dup2(devNull, STDIN_FILENO) < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("dup2");
+        }
+        close(devNull);
+        return true;
+    }
+    Close();
+    ReapJobs(true);
+    return false;
+}
+
+void JobServer::ReapJobs(bool wait)
+{
+    while (!jobs.empty())
+    {
+        int status;
+        pid_t pid = waitpid(-1, &status, wait ? 0 : WNOHANG);
+        if (pid < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (pid <= 0)
+        {
+            break;
+        }
+        auto it = jobs.find(pid);
+        if (it == jobs.end())
+        {
+            continue;
+        }
+        int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+        Send(it->second, "exit-code=" + std::to_string(exitCode) + "\n");
+        close(it->second);
+        jobs.erase(it);
+    }
+}
+
+void JobServer::ReadRequest(int connection, JobRequest& request)
+{
+    string text;
+    char buf[4096];
+    while (text.find("\n\n") == string::npos)
+    {
+        if (text.length() > MAX_REQUEST_SIZE)
+        {
+            MIKTEX_FATAL_ERROR(MIKTEXTEXT("The job request is too large."));
+        }
+        ssize_t n = read(connection, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("read");
+        }
+        if (n == 0)
+        {
+            MIKTEX_FATAL_ERROR(MIKTEXTEXT("Incomplete job request."));
+        }
+        text.append(buf, n);
+    }
+    text.erase(text.find("\n\n"));
+    size_t start = 0;
+    while (start <= text.length())
+    {
+        size_t end = text.find('\n', start);
+        if (end == string::npos)
+        {
+            end = text.length();
+        }
+        string line = text.substr(start, end - start);
+        start = end + 1;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        size_t equalSign = line.find('=');
+        if (equalSign == string::npos)
+        {
+            MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Invalid job request."), "line", line);
+        }
+        string name = line.substr(0, equalSign);
+        string value = line.substr(equalSign + 1);
+        if (name == "directory")
+        {
+            request.workingDirectory = value;
+        }
+        else if (name == "output-directory")
+        {
+            request.outputDirectory = value;
+        }
+        else if (name == "aux-directory")
+        {
+            request.auxDirectory = value;
+        }
+        else if (name == "job-name")
+        {
+            request.jobName = value;
+        }
+        else if (name == "arg")
+        {
+            request.arguments.push_back(value);
+        }
+        else
+        {
+            MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Invalid job request."), "line", line);
+        }
+    }
+    if (request.arguments.empty())
+    {
+        MIKTEX_FATAL_ERROR(MIKTEXTEXT("The job request does not specify an input."));
+    }
+}
+
+#else
+
+JobServer::JobServer(const PathName& socketPath) :
+    socketPath(socketPath)
+{
+    MIKTEX_FATAL_ERROR(MIKTEXTEXT("The job server is not supported on this platform."));
+}
+
+JobServer::~JobServer()
+{
+}
+
+void JobServer::Close()
+{
+}
+
+bool JobServer::Serve(function<bool()> stopRequested, JobRequest& request)
+{
+    MIKTEX_UNEXPECTED();
+}
+
+void JobServer::ReapJobs(bool wait)
+{
+}
+
+void JobServer::ReadRequest(int connection, JobRequest& request)
+{
+}
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file jobserver.h
+ * @author Christian Schenk
+ * @brief Preforked job server
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+/// A job, as received from a client.
+///
+/// A request consists of `name=value` lines and is terminated by an empty
+/// line:
+///
+///     directory=/home/joe/thesis
+///     output-directory=build
+///     job-name=thesis
+///     arg=thesis.tex
+///
+/// `arg` may be repeated; the arguments make up the first input line.  The
+/// client then receives the terminal output of the job, followed by a line
+/// `exit-code=N`.
+struct JobRequest
+{
+    MiKTeX::Util::PathName workingDirectory;
+
+    std::string outputDirectory;
+
+    std::string auxDirectory;
+
+    std::string jobName;
+
+    std::vector<std::string> arguments;
+};
+
+/// Accepts jobs on a local socket and forks a process for each one of
+/// them.
+///
+/// The server is started when the engine is ready to do a job, i.e., after
+/// the memory dump file has been loaded.  The forked processes inherit the
+/// initialized engine.
+class JobServer
+{
+
+public:
+
+    explicit JobServer(const MiKTeX::Util::PathName& socketPath);
+
+    JobServer(const JobServer& other) = delete;
+    JobServer& operator=(const JobServer& other) = delete;
+
+    ~JobServer();
+
+    /// Serves jobs until `stopRequested` returns `true`.
+    /// @param stopRequested Gets called periodically.
+    /// @param[out] request The job which is to be done.
+    /// @return Returns `true` in a forked process which must do the job.
+    /// Returns `false` in the server process when the server has been
+    /// stopped.
+    bool Serve(std::function<bool()> stopRequested, JobRequest& request);
+
+private:
+
+    void Close();
+
+    void ReapJobs(bool wait);
+
+    void ReadRequest(int connection, JobRequest& request);
+
+    MiKTeX::Util::PathName socketPath;
+
+    int listener = -1;
+
+    // maps process IDs to client connections
+    std::unordered_map<int, int> jobs;
+};
+
+END_INTERNAL_NAMESPACE;
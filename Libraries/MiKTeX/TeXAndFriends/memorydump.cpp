@@ -0,0 +1,233 @@
+/**
+ * @file memorydump.cpp
+ * @author Christian Schenk
+ * @brief Compressed memory dump files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <zlib.h>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Session>
+#include <miktex/Core/Text>
+
+#include "internal.h"
+
+#include "memorydump.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+namespace
+{
+    const size_t CHUNK_SIZE = 1024 * 1024;
+
+    // number of decompressed chunks the decompressor may run ahead
+    const size_t MAX_PENDING_CHUNKS = 8;
+}
+
+CompressedMemoryDumpWriter::CompressedMemoryDumpWriter(FILE* file) :
+    file(file)
+{
+    CompressedMemoryDumpHeader header;
+    header.signature = CompressedMemoryDumpHeader::Signature;
+    header.version = CompressedMemoryDumpHeader::Version;
+    header.chunkSize = static_cast<uint32_t>(CHUNK_SIZE);
+    header.reserved = 0;
+    if (fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+    chunk.reserve(CHUNK_SIZE);
+}
+
+void CompressedMemoryDumpWriter::Write(const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        size_t n = min(size, CHUNK_SIZE - chunk.size());
+        chunk.insert(chunk.end(), bytes, bytes + n);
+        bytes += n;
+        size -= n;
+        if (chunk.size() == CHUNK_SIZE)
+        {
+            FlushChunk();
+        }
+    }
+}
+
+void CompressedMemoryDumpWriter::Finish()
+{
+    if (!chunk.empty())
+    {
+        FlushChunk();
+    }
+    CompressedMemoryDumpChunkHeader endOfChunks = { 0, 0 };
+    if (fwrite(&endOfChunks, sizeof(endOfChunks), 1, file) != 1)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+}
+
+void CompressedMemoryDumpWriter::FlushChunk()
+{
+    uLongf compressedSize = compressBound(static_cast<uLong>(chunk.size()));
+    compressed.resize(compressedSize);
+    int ret = compress2(compressed.data(), &compressedSize, chunk.data(), static_cast<uLong>(chunk.size()), Z_DEFAULT_COMPRESSION);
+    if (ret != Z_OK)
+    {
+        MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("The memory dump file could not be compressed."), "zlibError", std::to_string(ret));
+    }
+    CompressedMemoryDumpChunkHeader chunkHeader;
+    chunkHeader.uncompressedSize = static_cast<uint32_t>(chunk.size());
+    chunkHeader.compressedSize = static_cast<uint32_t>(compressedSize);
+    if (fwrite(&chunkHeader, sizeof(chunkHeader), 1, file) != 1 || fwrite(compressed.data(), 1, compressedSize, file) != compressedSize)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+    chunk.clear();
+}
+
+bool CompressedMemoryDumpReader::IsCompressedMemoryDump(const void* data, size_t size)
+{
+    CompressedMemoryDumpHeader header;
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    return header.signature == CompressedMemoryDumpHeader::Signature;
+}
+
+CompressedMemoryDumpReader::CompressedMemoryDumpReader(unique_ptr<MemoryMappedFile> mapping) :
+    mapping(std::move(mapping))
+{
+    CompressedMemoryDumpHeader header;
+    MIKTEX_ASSERT(IsCompressedMemoryDump(this->mapping->GetPtr(), this->mapping->GetSize()));
+    memcpy(&header, this->mapping->GetPtr(), sizeof(header));
+    if (header.version != CompressedMemoryDumpHeader::Version)
+    {
+        MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Unknown memory dump file version."), "path", this->mapping->GetName(), "versionFound", std::to_string(header.version), "versionExpected", std::to_string(CompressedMemoryDumpHeader::Version));
+    }
+    decompressor = thread(&CompressedMemoryDumpReader::Decompress, this);
+}
+
+CompressedMemoryDumpReader::~CompressedMemoryDumpReader()
+{
+    {
+        lock_guard<std::mutex> lockGuard(mutex);
+        cancelled = true;
+    }
+    condition.notify_all();
+    if (decompressor.joinable())
+    {
+        decompressor.join();
+    }
+}
+
+void CompressedMemoryDumpReader::Decompress()
+{
+    const uint8_t* data = static_cast<const uint8_t*>(mapping->GetPtr());
+    size_t size = mapping->GetSize();
+    CompressedMemoryDumpHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t pos = sizeof(header);
+    string errorMessage;
+    while (true)
+    {
+        CompressedMemoryDumpChunkHeader chunkHeader;
+        if (size - pos < sizeof(chunkHeader))
+        {
+            errorMessage = "truncated";
+            break;
+        }
+        memcpy(&chunkHeader, data + pos, sizeof(chunkHeader));
+        pos += sizeof(chunkHeader);
+        if (chunkHeader.uncompressedSize == 0)
+        {
+            break;
+        }
+        if (chunkHeader.compressedSize > size - pos || chunkHeader.uncompressedSize > header.chunkSize)
+        {
+            errorMessage = "invalid chunk header";
+            break;
+        }
+        vector<uint8_t> chunk(chunkHeader.uncompressedSize);
+        uLongf uncompressedSize = chunkHeader.uncompressedSize;
+        int ret = uncompress(chunk.data(), &uncompressedSize, data + pos, chunkHeader.compressedSize);
+        if (ret != Z_OK || uncompressedSize != chunkHeader.uncompressedSize)
+        {
+            errorMessage = "zlib error " + std::to_string(ret);
+            break;
+        }
+        pos += chunkHeader.compressedSize;
+        unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]() { return cancelled || chunks.size() < MAX_PENDING_CHUNKS; });
+        if (cancelled)
+        {
+            return;
+        }
+        chunks.push_back(std::move(chunk));
+        lock.unlock();
+        condition.notify_all();
+    }
+    {
+        lock_guard<std::mutex> lockGuard(mutex);
+        error = errorMessage;
+        done = true;
+    }
+    condition.notify_all();
+}
+
+bool CompressedMemoryDumpReader::NextChunk()
+{
+    unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this]() { return done || !chunks.empty(); });
+    if (chunks.empty())
+    {
+        if (!error.empty())
+        {
+            MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Bad format file."), "path", mapping->GetName(), "reason", error);
+        }
+        return false;
+    }
+    current = std::move(chunks.front());
+    chunks.pop_front();
+    currentPosition = 0;
+    lock.unlock();
+    condition.notify_all();
+    return true;
+}
+
+void CompressedMemoryDumpReader::Read(void* buf, size_t size)
+{
+    uint8_t* dest = static_cast<uint8_t*>(buf);
+    while (size > 0)
+    {
+        if (currentPosition == current.size() && !NextChunk())
+        {
+            MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Bad format file."), "path", mapping->GetName());
+        }
+        size_t n = min(size, current.size() - currentPosition);
+        memcpy(dest, current.data() + currentPosition, n);
+        currentPosition += n;
+        dest += n;
+        size -= n;
+    }
+}
+
+bool CompressedMemoryDumpReader::AtEnd()
+{
+    return currentPosition == current.size() && !NextChunk();
+}
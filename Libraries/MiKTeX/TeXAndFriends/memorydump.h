@@ -0,0 +1,138 @@
+/**
+ * @file memorydump.h
+ * @author Christian Schenk
+ * @brief Compressed memory dump files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <miktex/Core/MemoryMappedFile>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+// a compressed memory dump file starts with this header; it is followed
+// by chunks, each one introduced by a CompressedMemoryDumpChunkHeader;
+// an empty chunk marks the end
+struct CompressedMemoryDumpHeader
+{
+    static const std::uint32_t Signature = 0x5a464d4d; // 'MMFZ' (the x86 way)
+    static const std::uint32_t Version = 1;
+
+    std::uint32_t signature;
+
+    std::uint32_t version;
+
+    // max number of uncompressed bytes per chunk
+    std::uint32_t chunkSize;
+
+    std::uint32_t reserved;
+};
+
+struct CompressedMemoryDumpChunkHeader
+{
+    std::uint32_t uncompressedSize;
+
+    // size of the zlib stream which follows
+    std::uint32_t compressedSize;
+};
+
+/// Writes the container: the dumped data is collected and compressed one
+/// chunk at a time.
+class CompressedMemoryDumpWriter
+{
+
+public:
+
+    explicit CompressedMemoryDumpWriter(FILE* file);
+
+    void Write(const void* data, std::size_t size);
+
+    /// Writes the last chunk and the end marker.
+    void Finish();
+
+    FILE* GetFile() const
+    {
+        return file;
+    }
+
+private:
+
+    void FlushChunk();
+
+    FILE* file;
+
+    std::vector<std::uint8_t> chunk;
+
+    std::vector<std::uint8_t> compressed;
+};
+
+/// Reads the container: a background thread decompresses the chunks while
+/// the engine consumes them.
+class CompressedMemoryDumpReader
+{
+
+public:
+
+    static bool IsCompressedMemoryDump(const void* data, std::size_t size);
+
+    explicit CompressedMemoryDumpReader(std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mapping);
+
+    CompressedMemoryDumpReader(const CompressedMemoryDumpReader& other) = delete;
+    CompressedMemoryDumpReader& operator=(const CompressedMemoryDumpReader& other) = delete;
+
+    ~CompressedMemoryDumpReader();
+
+    void Read(void* buf, std::size_t size);
+
+    /// Tests whether all data has been consumed; waits for the next chunk,
+    /// if necessary.
+    bool AtEnd();
+
+private:
+
+    void Decompress();
+
+    bool NextChunk();
+
+    std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mapping;
+
+    std::vector<std::uint8_t> current;
+
+    std::size_t currentPosition = 0;
+
+    std::mutex mutex;
+
+    std::condition_variable condition;
+
+    // decompressed chunks which have not been consumed yet
+    std::deque<std::vector<std::uint8_t>> chunks;
+
+    bool done = false;
+
+    bool cancelled = false;
+
+    std::string error;
+
+    std::thread decompressor;
+};
+
+END_INTERNAL_NAMESPACE;
@@ -11,6 +11,7 @@
  * version 2 or any later version.
  */
 
+#include <fstream>
 #include <sstream>
 
 #include <fmt/format.h>
@@ -20,9 +21,15 @@
 
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Directory>
+#include <miktex/Core/Environment>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/StreamReader>
+#include <miktex/Core/StreamWriter>
 
+#include <miktex/Trace/Profiler>
 #include <miktex/Trace/Trace>
 
 #if defined(MIKTEX_TEXMF_SHARED)
@@ -42,6 +49,10 @@
 #include "miktex/TeXAndFriends/TeXMFApp.h"
 
 #include "internal.h"
+#include "arrayallocator.h"
+#include "jobcache.h"
+#include "jobserver.h"
+#include "memorydump.h"
 
 #include "miktex/texmfapp.defaults.h"
 
@@ -63,6 +74,7 @@ public:
     clock_t clockStart;
     bool enable8BitChars;
     bool timeStatistics;
+    bool memoryStatistics;
     bool parseFirstLine;
     bool showFileLineErrorMessages;
     bool haltOnError;
@@ -78,6 +90,22 @@ public:
     IErrorHandler* errorHandler = nullptr;
     ITeXMFMemoryHandler* memoryHandler = nullptr;
     UserParams userParams;
+    // the memory dump file which is being read through a mapping
+    FILE* mappedMemoryDumpFile = nullptr;
+    unique_ptr<MemoryMappedFile> memoryDumpFileMapping;
+    size_t memoryDumpFilePosition = 0;
+    unique_ptr<CompressedMemoryDumpReader> memoryDumpFileReader;
+    bool compressMemoryDump = false;
+    unique_ptr<CompressedMemoryDumpWriter> memoryDumpFileWriter;
+    PathName serverSocket;
+    unique_ptr<ArrayAllocator> arrayAllocator;
+    PathName profileFile;
+    // the memory dump file which is being undumped
+    FILE* undumpFile = nullptr;
+    unique_ptr<ProfileScope> undumpScope;
+    unique_ptr<ProfileScope> shipOutScope;
+    vector<string> commandLine;
+    unique_ptr<JobCache> jobCache;
 };
 
 TeXMFApp::TeXMFApp() :
@@ -147,6 +175,20 @@ void TeXMFApp::Init(vector<char*>& args)
     pimpl->setJobTime = false;
     pimpl->showFileLineErrorMessages = false;
     pimpl->timeStatistics = false;
+    pimpl->memoryStatistics = false;
+
+    pimpl->commandLine.clear();
+    for (const char* arg : args)
+    {
+        if (arg != nullptr)
+        {
+            pimpl->commandLine.push_back(arg);
+        }
+    }
+
+    // drivers like texify ask for the digests of the auxiliary files
+    string outputDigests;
+    EnableOutputDigests(Utils::GetEnvironmentString(MIKTEX_ENV_OUTPUT_DIGESTS, outputDigests) && !outputDigests.empty());
 }
 
 void TeXMFApp::Finalize()
@@ -160,6 +202,18 @@ void TeXMFApp::Finalize()
     pimpl->jobName = "";
     pimpl->features.Reset();
     pimpl->tcxFileName = "";
+    pimpl->mappedMemoryDumpFile = nullptr;
+    pimpl->memoryDumpFileReader = nullptr;
+    pimpl->memoryDumpFileMapping = nullptr;
+    pimpl->memoryDumpFileWriter = nullptr;
+    pimpl->serverSocket = "";
+    pimpl->arrayAllocator = nullptr;
+    pimpl->profileFile = "";
+    pimpl->undumpFile = nullptr;
+    pimpl->undumpScope = nullptr;
+    pimpl->shipOutScope = nullptr;
+    pimpl->commandLine.clear();
+    pimpl->jobCache = nullptr;
     WebAppInputLine::Finalize();
 }
 
@@ -179,34 +233,231 @@ void TeXMFApp::OnTeXMFStartJob()
     pimpl->parseFirstLine = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_PARSE_FIRST_LINE, ConfigValue(AmI(TeXEngine))).GetBool();
     pimpl->showFileLineErrorMessages = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_CSTYLEERRORS).GetBool();
     pimpl->clockStart = clock();
+    if (session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_MEMORY_STATISTICS, ConfigValue(false)).GetBool())
+    {
+        pimpl->memoryStatistics = true;
+    }
+}
+
+PathName TeXMFApp::GetJobFileName(const string& extension) const
+{
+    string fileName;
+    if (pimpl->jobName.length() > 2 && pimpl->jobName.front() == '"' && pimpl->jobName.back() == '"')
+    {
+        fileName = pimpl->jobName.substr(1, pimpl->jobName.length() - 2);
+    }
+    else
+    {
+        fileName = pimpl->jobName;
+    }
+    PathName path = GetAuxDirectory();
+    if (path.Empty())
+    {
+        path = GetOutputDirectory();
+    }
+    path /= fileName;
+    path.AppendExtension(extension);
+    return path;
 }
 
 void TeXMFApp::OnTeXMFFinishJob()
 {
     if (pimpl->recordFileNames)
     {
-        string fileName;
-        if (pimpl->jobName.length() > 2 && pimpl->jobName.front() == '"' && pimpl->jobName.back() == '"')
+        shared_ptr<Session> session = GetSession();
+        session->SetRecorderPath(GetJobFileName(".fls"));
+    }
+    WriteOutputDigests();
+    if (pimpl->jobCache != nullptr)
+    {
+        // spotless or warning_issued
+        if (GetInitFinalize()->history() <= 1)
         {
-            fileName = pimpl->jobName.substr(1, pimpl->jobName.length() - 2);
+            pimpl->jobCache->Store(GetSession()->GetFileInfoRecords());
         }
-        else
+        pimpl->jobCache = nullptr;
+    }
+    if (pimpl->timeStatistics)
+    {
+        TraceExecutionTime(pimpl->trace_time.get(), pimpl->clockStart);
+    }
+    if (pimpl->arrayAllocator != nullptr)
+    {
+        unique_ptr<TraceStream> trace_mem = TraceStream::Open(MIKTEX_TRACE_MEM);
+        if (pimpl->memoryStatistics || trace_mem->IsEnabled("libtexmf", TraceLevel::Info))
         {
-            fileName = pimpl->jobName;
+            WriteMemoryStatistics(trace_mem.get());
         }
-        shared_ptr<Session> session = GetSession();
-        PathName recorderPath = GetAuxDirectory();
-        if (recorderPath.Empty())
+    }
+    if (!pimpl->profileFile.Empty())
+    {
+        pimpl->shipOutScope = nullptr;
+        ofstream stream = File::CreateOutputStream(pimpl->profileFile);
+        Profiler::WriteChromeTrace(stream);
+        stream.close();
+    }
+}
+
+void TeXMFApp::RestoreCachedJob()
+{
+    string directory;
+    if (!Utils::GetEnvironmentString(MIKTEX_ENV_JOB_CACHE, directory) || directory.empty())
+    {
+        return;
+    }
+    if (pimpl->isInitProgram || !pimpl->serverSocket.Empty() || GetProgram()->GetArgC() < 2)
+    {
+        return;
+    }
+    // \today and \time must come out the same: the job clock must be fixed
+    string forceSourceDate;
+    string sourceDateEpoch;
+    if (!pimpl->setJobTime
+        && !(Utils::GetEnvironmentString("FORCE_SOURCE_DATE", forceSourceDate) && forceSourceDate == "1" && Utils::GetEnvironmentString("SOURCE_DATE_EPOCH", sourceDateEpoch)))
+    {
+        LogInfo("job cache not used: the job clock is not fixed");
+        return;
+    }
+    shared_ptr<Session> session = GetSession();
+    PathName exe = session->GetMyProgramFile(true);
+    PathName cwd;
+    cwd.SetToCurrentDirectory();
+    vector<string> keyFields = {
+        GetProgramName(),
+        exe.ToString(),
+        std::to_string(File::GetSize(exe)),
+        std::to_string(File::GetLastWriteTime(exe)),
+        cwd.ToString()
+    };
+    for (const char* name : { "SOURCE_DATE_EPOCH", "FORCE_SOURCE_DATE" })
+    {
+        string value;
+        Utils::GetEnvironmentString(name, value);
+        keyFields.push_back(fmt::format("{0}={1}", name, value));
+    }
+    keyFields.push_back(std::to_string(GetProgram()->GetStartUpTime()));
+    keyFields.insert(keyFields.end(), pimpl->commandLine.begin(), pimpl->commandLine.end());
+    pimpl->jobCache = make_unique<JobCache>(PathName(directory), keyFields);
+    // the recorder tells which files the job reads and writes
+    session->StartFileInfoRecorder();
+    vector<FileInfoRecord> records;
+    auto findFile = [session](const string& fileName, FileType fileType, PathName& path)
+    {
+        return session->FindFile(fileName, fileType, path);
+    };
+    if (!pimpl->jobCache->Restore(findFile, records))
+    {
+        return;
+    }
+    pimpl->jobCache = nullptr;
+    LogInfo("output files have been restored from the job cache");
+    if (!GetQuietFlag())
+    {
+        cout << T_("Output files have been restored from the job cache.") << endl;
+    }
+    if (pimpl->recordFileNames)
+    {
+        for (const FileInfoRecord& record : records)
         {
-            recorderPath = GetOutputDirectory();
+            session->RecordFileInfo(PathName(record.fileName), record.access);
+            PathName path(record.fileName);
+            if (record.access == FileAccess::Write && path.HasExtension(".log"))
+            {
+                session->SetRecorderPath(path.SetExtension(".fls"));
+            }
         }
-        recorderPath /= fileName;
-        recorderPath.AppendExtension(".fls");
-        session->SetRecorderPath(recorderPath);
     }
-    if (pimpl->timeStatistics)
+    throw 0;
+}
+
+void TeXMFApp::WriteOutputDigests() const
+{
+    vector<pair<PathName, MD5>> outputDigests = GetOutputDigests();
+    if (outputDigests.empty())
     {
-        TraceExecutionTime(pimpl->trace_time.get(), pimpl->clockStart);
+        return;
+    }
+    try
+    {
+        StreamWriter writer(GetJobFileName(".fdg"));
+        for (const auto& od : outputDigests)
+        {
+            writer.WriteLine(fmt::format("{0} {1}", od.second.ToString(), od.first.ToString()));
+        }
+        writer.Close();
+    }
+    catch (const MiKTeXException& e)
+    {
+        // without the digests, the driver compares the files itself
+        LogWarn(fmt::format("cannot write output digests: {0}", e.GetErrorMessage()));
+    }
+}
+
+void TeXMFApp::OnInputFileFound(const string& fileName, FileType fileType, const PathName& path)
+{
+    if (pimpl->jobCache != nullptr)
+    {
+        pimpl->jobCache->NoteFoundInputFile(fileName, fileType, path);
+    }
+}
+
+void TeXMFApp::OnInputFileNotFound(const PathName& fileName)
+{
+    if (pimpl->jobCache != nullptr)
+    {
+        pimpl->jobCache->NoteMissingInputFile(fileName.ToString(), GetInputFileType());
+    }
+}
+
+void TeXMFApp::OnOpenOutputFile(const PathName& path)
+{
+    if (pimpl->jobCache != nullptr)
+    {
+        pimpl->jobCache->NoteOutputFile(path);
+    }
+}
+
+void TeXMFApp::OnShellCommand() const
+{
+    if (pimpl->jobCache != nullptr)
+    {
+        pimpl->jobCache->Disable();
+    }
+}
+
+void TeXMFApp::OnStartShipOut()
+{
+    if (Profiler::IsEnabled())
+    {
+        pimpl->shipOutScope = make_unique<ProfileScope>("texmf", "ship out");
+    }
+}
+
+void TeXMFApp::OnFinishShipOut()
+{
+    pimpl->shipOutScope = nullptr;
+    GetSession()->FlushFileInfoRecorder();
+}
+
+void TeXMFApp::WriteMemoryStatistics(TraceStream* trace_mem) const
+{
+    string arrays;
+    for (const auto& a : pimpl->arrayAllocator->GetStatistics())
+    {
+        if (!arrays.empty())
+        {
+            arrays += ",";
+        }
+        arrays += fmt::format(R"({{"name":"{0}","reserved":{1},"maxSize":{2},"highWaterMark":{3},"reallocations":{4}}})", a.first, a.second.reserved, a.second.maxSize, a.second.highWaterMark, a.second.reallocations);
+    }
+    string json = fmt::format(R"({{"program":"{0}","arrays":[{1}]}})", GetProgramName(), arrays);
+    trace_mem->WriteLine("libtexmf", TraceLevel::Info, json);
+    if (pimpl->memoryStatistics)
+    {
+        PathName path = GetJobFileName(".mem.json");
+        StreamWriter writer(path);
+        writer.WriteLine(json);
+        writer.Close();
     }
 }
 
@@ -214,6 +465,7 @@ enum {
     OPT_AUX_DIRECTORY,
     OPT_BUF_SIZE,
     OPT_C_STYLE_ERRORS,
+    OPT_COMPRESS_DUMP,
     OPT_DISABLE_8BIT_CHARS,
     OPT_DONT_PARSE_FIRST_LINE,
     OPT_ENABLE_8BIT_CHARS,
@@ -229,14 +481,17 @@ enum {
     OPT_MAIN_MEMORY,
     OPT_MAX_PRINT_LINE,
     OPT_MAX_STRINGS,
+    OPT_MEMORY_STATISTICS,
     OPT_NO_C_STYLE_ERRORS,
     OPT_OUTPUT_DIRECTORY,
     OPT_PARAM_SIZE,
     OPT_PARSE_FIRST_LINE,
     OPT_POOL_FREE,
     OPT_POOL_SIZE,
+    OPT_PROFILE,
     OPT_QUIET,
     OPT_RECORDER,
+    OPT_SERVER,
     OPT_STACK_SIZE,
     OPT_STRICT,
     OPT_STRING_VACANCIES,
@@ -266,6 +521,7 @@ void TeXMFApp::AddOptions()
     AddOption("aux-directory", T_("Use DIR as the directory to write auxiliary files to."), FIRST_OPTION_VAL + pimpl->optBase + OPT_AUX_DIRECTORY, POPT_ARG_STRING, "DIR");
     AddOption("buf-size", fmt::format(T_("Set {0} to N."), "buf_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_BUF_SIZE, POPT_ARG_STRING, "N");
     AddOption("c-style-errors", T_("Enable file:line:error style messages."), FIRST_OPTION_VAL + pimpl->optBase + OPT_C_STYLE_ERRORS);
+    AddOption("compress-dump", T_("Compress the memory dump file (INI mode)."), FIRST_OPTION_VAL + pimpl->optBase + OPT_COMPRESS_DUMP);
     AddOption("dont-parse-first-line", T_("Do not parse the first line of the input line to look for a dump name and/or extra command-line options."), FIRST_OPTION_VAL + pimpl->optBase + OPT_DONT_PARSE_FIRST_LINE);
     AddOption("error-line", fmt::format(T_("Set {0} to N."), "error_line"), FIRST_OPTION_VAL + pimpl->optBase + OPT_ERROR_LINE, POPT_ARG_STRING, "N");
 
@@ -293,6 +549,7 @@ void TeXMFApp::AddOptions()
     AddOption("main-memory", fmt::format(T_("Set {0} to N."), "main_memory"), FIRST_OPTION_VAL + pimpl->optBase + OPT_MAIN_MEMORY, POPT_ARG_STRING, "N");
     AddOption("max-print-line", fmt::format(T_("Set {0} to N."), "max_print_line"), FIRST_OPTION_VAL + pimpl->optBase + OPT_MAX_PRINT_LINE, POPT_ARG_STRING, "N");
     AddOption("max-strings", fmt::format(T_("Set {0} to N."), "max_strings"), FIRST_OPTION_VAL + pimpl->optBase + OPT_MAX_STRINGS, POPT_ARG_STRING, "N");
+    AddOption("memory-statistics", T_("Write a memory usage report (JOBNAME.mem.json) at the end of the job."), FIRST_OPTION_VAL + pimpl->optBase + OPT_MEMORY_STATISTICS);
     AddOption("no-c-style-errors", T_("Disable file:line:error style messages."), FIRST_OPTION_VAL + pimpl->optBase + OPT_NO_C_STYLE_ERRORS);
     AddOption("output-directory", T_("Use DIR as the directory to write output files to."), FIRST_OPTION_VAL + pimpl->optBase + OPT_OUTPUT_DIRECTORY, POPT_ARG_STRING, "DIR");
     AddOption("param-size", fmt::format(T_("Set {0} to N."), "param_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_PARAM_SIZE, POPT_ARG_STRING, "N");
@@ -304,8 +561,15 @@ void TeXMFApp::AddOptions()
     }
 
     AddOption("pool-size", fmt::format(T_("Set {0} to N."), "pool_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_POOL_SIZE, POPT_ARG_STRING, "N");
+    AddOption("profile", T_("Write timing information in the Chrome tracing format to FILE at the end of the job."), FIRST_OPTION_VAL + pimpl->optBase + OPT_PROFILE, POPT_ARG_STRING, "FILE");
     AddOption("quiet", T_("Suppress all output (except errors)."), FIRST_OPTION_VAL + pimpl->optBase + OPT_QUIET);
     AddOption("recorder", T_("Turn on the file name recorder to leave a trace of the files opened for input and output in a file with extension .fls."), FIRST_OPTION_VAL + pimpl->optBase + OPT_RECORDER);
+#if defined(MIKTEX_UNIX)
+    if (IsFeatureEnabled(Feature::JobServer))
+    {
+        AddOption("server", T_("Load the memory dump file once and then serve jobs submitted to SOCKET."), FIRST_OPTION_VAL + pimpl->optBase + OPT_SERVER, POPT_ARG_STRING, "SOCKET");
+    }
+#endif
     AddOption("stack-size", fmt::format(T_("Set {0} to N."), "stack_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_STACK_SIZE, POPT_ARG_STRING, "N");
     AddOption("strict", T_("Disable MiKTeX extensions."), FIRST_OPTION_VAL + pimpl->optBase + OPT_STRICT, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN);
 
@@ -394,6 +658,10 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
         pimpl->showFileLineErrorMessages = true;
         break;
 
+    case OPT_COMPRESS_DUMP:
+        pimpl->compressMemoryDump = true;
+        break;
+
     case OPT_DONT_PARSE_FIRST_LINE:
         pimpl->parseFirstLine = false;
         break;
@@ -492,6 +760,10 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
         pimpl->userParams["max_strings"] = std::stoi(optArg);
         break;
 
+    case OPT_MEMORY_STATISTICS:
+        pimpl->memoryStatistics = true;
+        break;
+
     case OPT_TIME_STATISTICS:
         pimpl->timeStatistics = true;
         break;
@@ -540,6 +812,12 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
         pimpl->userParams["pool_size"] = std::stoi(optArg);
         break;
 
+    case OPT_PROFILE:
+        pimpl->profileFile = optArg;
+        pimpl->profileFile.MakeFullyQualified();
+        Profiler::Enable(true);
+        break;
+
     case OPT_QUIET:
         SetQuietFlag(true);
         break;
@@ -549,6 +827,11 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
         pimpl->recordFileNames = true;
         break;
 
+    case OPT_SERVER:
+        pimpl->serverSocket = optArg;
+        pimpl->serverSocket.MakeFullyQualified();
+        break;
+
     case OPT_STACK_SIZE:
         pimpl->userParams["stack_size"] = std::stoi(optArg);
         break;
@@ -658,6 +941,49 @@ void TeXMFApp::CheckFirstLine(const PathName& fileName)
     }
 }
 
+// Checks the files listed in the inputs file, which has been written by
+// makefmt: size and modification time first, the MD5 only if a file has been
+// touched.
+static bool AreMemoryDumpInputsUnchanged(const PathName& inputsFile, PathName& changedFile)
+{
+    try
+    {
+        StreamReader reader(inputsFile);
+        string line;
+        while (reader.ReadLine(line))
+        {
+            // MD5, size, modification time, path
+            size_t pos1 = line.find(' ');
+            size_t pos2 = pos1 == string::npos ? pos1 : line.find(' ', pos1 + 1);
+            size_t pos3 = pos2 == string::npos ? pos2 : line.find(' ', pos2 + 1);
+            if (pos3 == string::npos)
+            {
+                changedFile = inputsFile;
+                return false;
+            }
+            PathName path(line.substr(pos3 + 1));
+            if (!File::Exists(path) || File::GetSize(path) != std::stoull(line.substr(pos1 + 1, pos2 - pos1 - 1)))
+            {
+                changedFile = path;
+                return false;
+            }
+            if (static_cast<int64_t>(File::GetLastWriteTime(path)) != std::stoll(line.substr(pos2 + 1, pos3 - pos2 - 1))
+                && MD5::FromFile(path) != MD5::Parse(line.substr(0, pos1)))
+            {
+                changedFile = path;
+                return false;
+            }
+        }
+        reader.Close();
+    }
+    catch (const exception&)
+    {
+        changedFile = inputsFile;
+        return false;
+    }
+    return true;
+}
+
 bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void* pBuf, size_t size, bool renew)
 {
     MIKTEX_ASSERT(ppFile != nullptr);
@@ -667,6 +993,9 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
         MIKTEX_ASSERT_BUFFER(pBuf, size);
     }
 
+    // stopped when the engine closes the file
+    auto undumpScope = make_unique<ProfileScope>("texmf", "undump", fileName_.ToString());
+
     shared_ptr<Session> session = GetSession();
 
     PathName fileName(fileName_);
@@ -697,16 +1026,31 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
         MIKTEX_FATAL_ERROR_2(T_("The memory dump file could not be found."), "fileName", fileName.ToString());
     }
 
-#if 1
     if (!renew)
     {
-        time_t modificationTime = File::GetLastWriteTime(path);
-        time_t lastAdminMaintenance = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE, ConfigValue("0")).GetTimeT();
-        renew = lastAdminMaintenance > modificationTime;
-        if (!renew && !session->IsAdminMode())
+        PathName inputsFile(path);
+        inputsFile.AppendExtension(MIKTEX_FORMAT_INPUTS_FILE_SUFFIX);
+        if (File::Exists(inputsFile))
         {
-            time_t lastUserMaintenance = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue("0")).GetTimeT();
-            renew = lastUserMaintenance > modificationTime;
+            // renew only if one of the files which went into the memory
+            // dump file has changed
+            PathName changedFile;
+            renew = !AreMemoryDumpInputsUnchanged(inputsFile, changedFile);
+            if (renew)
+            {
+                LogInfo(fmt::format("{0} has changed since {1} was created", Q_(changedFile), Q_(path)));
+            }
+        }
+        else
+        {
+            time_t modificationTime = File::GetLastWriteTime(path);
+            time_t lastAdminMaintenance = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE, ConfigValue("0")).GetTimeT();
+            renew = lastAdminMaintenance > modificationTime;
+            if (!renew && !session->IsAdminMode())
+            {
+                time_t lastUserMaintenance = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue("0")).GetTimeT();
+                renew = lastUserMaintenance > modificationTime;
+            }
         }
         if (renew)
         {
@@ -714,25 +1058,139 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
             return OpenMemoryDumpFile(fileName_, ppFile, pBuf, size, true);
         }
     }
-#endif
 
     FileStream stream(session->OpenFile(path, FileMode::Open, FileAccess::Read, false));
 
+    session->PushAppName(dumpName);
+
+    pimpl->mappedMemoryDumpFile = nullptr;
+    pimpl->memoryDumpFileReader = nullptr;
+    pimpl->memoryDumpFileMapping = nullptr;
+    pimpl->memoryDumpFilePosition = 0;
+
+    // the mapping is read-only: the pages of the memory dump file are
+    // shared by all processes which load it
+    unique_ptr<MemoryMappedFile> mapping;
+    if (File::GetSize(path) > 0)
+    {
+        try
+        {
+            mapping.reset(MemoryMappedFile::Create());
+            mapping->Open(path, false);
+        }
+        catch (const MiKTeXException& e)
+        {
+            mapping = nullptr;
+            LogWarn(fmt::format("{0} could not be mapped: {1}", Q_(path), e.GetErrorMessage()));
+        }
+    }
+
+    if (mapping != nullptr && CompressedMemoryDumpReader::IsCompressedMemoryDump(mapping->GetPtr(), mapping->GetSize()))
+    {
+        pimpl->memoryDumpFileReader = make_unique<CompressedMemoryDumpReader>(std::move(mapping));
+        pimpl->mappedMemoryDumpFile = stream.GetFile();
+    }
+    else if (mapping != nullptr && session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_MAP_MEMORY_DUMP_FILES, ConfigValue(true)).GetBool())
+    {
+        pimpl->memoryDumpFileMapping = std::move(mapping);
+        pimpl->mappedMemoryDumpFile = stream.GetFile();
+    }
+
     if (pBuf != nullptr)
     {
-        if (stream.Read(pBuf, size) != size)
+        if (pimpl->mappedMemoryDumpFile != nullptr)
+        {
+            ReadMemoryDumpFile(stream.GetFile(), pBuf, size);
+        }
+        else if (stream.Read(pBuf, size) != size)
         {
             MIKTEX_UNEXPECTED();
         }
     }
 
-    session->PushAppName(dumpName);
-
     *ppFile = stream.Detach();
 
+    pimpl->undumpFile = *ppFile;
+    pimpl->undumpScope = std::move(undumpScope);
+
     return true;
 }
 
+void TeXMFApp::ReadMemoryDumpFile(FILE* file, void* buf, size_t size)
+{
+    if (file == nullptr || file != pimpl->mappedMemoryDumpFile)
+    {
+        if (fread(buf, 1, size, file) != size)
+        {
+            MIKTEX_FATAL_CRT_ERROR("fread");
+        }
+        return;
+    }
+    bool atEnd;
+    if (pimpl->memoryDumpFileReader != nullptr)
+    {
+        pimpl->memoryDumpFileReader->Read(buf, size);
+        atEnd = pimpl->memoryDumpFileReader->AtEnd();
+    }
+    else
+    {
+        size_t mappingSize = pimpl->memoryDumpFileMapping->GetSize();
+        if (size > mappingSize - pimpl->memoryDumpFilePosition)
+        {
+            MIKTEX_FATAL_ERROR(T_("Bad format file."));
+        }
+        memcpy(buf, static_cast<const uint8_t*>(pimpl->memoryDumpFileMapping->GetPtr()) + pimpl->memoryDumpFilePosition, size);
+        pimpl->memoryDumpFilePosition += size;
+        atEnd = pimpl->memoryDumpFilePosition == mappingSize;
+    }
+    if (atEnd)
+    {
+        // the engine might test for the end of the file
+        if (fseek(file, 0, SEEK_END) != 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("fseek");
+        }
+    }
+}
+
+void TeXMFApp::WriteMemoryDumpFile(FILE* file, const void* buf, size_t size)
+{
+    if (pimpl->compressMemoryDump && IsInitProgram())
+    {
+        if (pimpl->memoryDumpFileWriter == nullptr || pimpl->memoryDumpFileWriter->GetFile() != file)
+        {
+            pimpl->memoryDumpFileWriter = make_unique<CompressedMemoryDumpWriter>(file);
+        }
+        pimpl->memoryDumpFileWriter->Write(buf, size);
+        return;
+    }
+    if (fwrite(buf, 1, size, file) != size)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+}
+
+void TeXMFApp::CloseFileInternal(FILE* file)
+{
+    if (pimpl->memoryDumpFileWriter != nullptr && pimpl->memoryDumpFileWriter->GetFile() == file)
+    {
+        pimpl->memoryDumpFileWriter->Finish();
+        pimpl->memoryDumpFileWriter = nullptr;
+    }
+    if (file == pimpl->undumpFile)
+    {
+        pimpl->undumpFile = nullptr;
+        pimpl->undumpScope = nullptr;
+    }
+    if (file == pimpl->mappedMemoryDumpFile)
+    {
+        pimpl->mappedMemoryDumpFile = nullptr;
+        pimpl->memoryDumpFileReader = nullptr;
+        pimpl->memoryDumpFileMapping = nullptr;
+    }
+    WebAppInputLine::CloseFileInternal(file);
+}
+
 void TeXMFApp::ProcessCommandLineOptions()
 {
     if (StringUtil::Contains(GetInitProgramName(), Utils::GetExeName()))
@@ -757,6 +1215,54 @@ void TeXMFApp::ProcessCommandLineOptions()
     {
         CheckFirstLine(PathName(GetProgram()->GetArgV()[1]));
     }
+
+    RestoreCachedJob();
+}
+
+bool TeXMFApp::ServeJobs()
+{
+    if (pimpl->serverSocket.Empty())
+    {
+        return false;
+    }
+    JobRequest request;
+    {
+        JobServer server(pimpl->serverSocket);
+        LogInfo(fmt::format("serving jobs on {0}", pimpl->serverSocket.ToDisplayString()));
+        if (!server.Serve([this]() { return Cancelled() || GetErrorHandler()->interrupt() != 0; }, request))
+        {
+            LogInfo("job server has been stopped");
+            throw 0;
+        }
+    }
+    // this is a forked job process: do the job as if it had been given on
+    // the command line
+    pimpl->serverSocket = "";
+    if (!request.workingDirectory.Empty())
+    {
+        Directory::SetCurrent(request.workingDirectory);
+    }
+    if (!request.outputDirectory.empty())
+    {
+        ProcessOption(FIRST_OPTION_VAL + pimpl->optBase + OPT_OUTPUT_DIRECTORY, request.outputDirectory);
+    }
+    if (!request.auxDirectory.empty())
+    {
+        ProcessOption(FIRST_OPTION_VAL + pimpl->optBase + OPT_AUX_DIRECTORY, request.auxDirectory);
+    }
+    if (!request.jobName.empty())
+    {
+        ProcessOption(FIRST_OPTION_VAL + pimpl->optBase + OPT_JOB_NAME, request.jobName);
+    }
+    string forceSourceDate;
+    if (!pimpl->setJobTime && !(Utils::GetEnvironmentString("FORCE_SOURCE_DATE", forceSourceDate) && forceSourceDate == "1"))
+    {
+        GetProgram()->SetStartUpTime(time(nullptr), false);
+    }
+    pimpl->clockStart = clock();
+    GetProgram()->MakeCommandLine(request.arguments);
+    LogInfo(fmt::format("doing job in {0}", Directory::GetCurrent().ToDisplayString()));
+    return true;
 }
 
 bool TeXMFApp::IsVirgin() const
@@ -1090,6 +1596,25 @@ ITeXMFMemoryHandler* TeXMFApp::GetTeXMFMemoryHandler() const
     return pimpl->memoryHandler;
 }
 
+void* TeXMFApp::ReallocateArrayMemory(const string& arrayName, void* ptr, size_t size, const SourceLocation& sourceLocation)
+{
+    if (pimpl->arrayAllocator == nullptr)
+    {
+        pimpl->arrayAllocator = make_unique<ArrayAllocator>();
+    }
+    return pimpl->arrayAllocator->Reallocate(arrayName, ptr, size, sourceLocation);
+}
+
+void TeXMFApp::CheckArrayMemory(const void* ptr) const
+{
+    if (pimpl->arrayAllocator == nullptr)
+    {
+        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(ptr);
+        return;
+    }
+    pimpl->arrayAllocator->Check(ptr);
+}
+
 TeXMFApp::UserParams& TeXMFApp::GetUserParams() const
 {
     return pimpl->userParams;
@@ -1217,6 +1742,7 @@ void TeXMFApp::CheckPoolPointer(int poolptr, std::size_t len) const
 
 bool TeXMFApp::OpenFontFile(C4P::BufferedFile<unsigned char>* file, const string& fontName, FileType filetype, const char* generator)
 {
+    ProfileScope profileScope("texmf", "open font", fontName);
     shared_ptr<Session> session = MIKTEX_SESSION();
     PathName pathFont;
     if (!session->FindFile(fontName, filetype, pathFont))
@@ -1248,6 +1774,29 @@ bool TeXMFApp::OpenFontFile(C4P::BufferedFile<unsigned char>* file, const string
             MIKTEX_FATAL_ERROR_2(T_("The font file could not be found."), "fileName", fontName);
         }
     }
+    OnInputFileFound(fontName, filetype, pathFont);
+#if defined(MIKTEX_UNIX)
+    if ((filetype == FileType::TFM || filetype == FileType::OFM) && session->IsFontMetricCacheEnabled())
+    {
+        // the font metric file may come from the font metric cache: the
+        // engine reads it from memory
+        vector<unsigned char> data = session->ReadFontMetricFile(pathFont);
+        FILE* memoryFile = data.empty() ? nullptr : fmemopen(nullptr, data.size(), "w+b");
+        if (memoryFile != nullptr)
+        {
+            if (fwrite(data.data(), 1, data.size(), memoryFile) != data.size())
+            {
+                fclose(memoryFile);
+                MIKTEX_FATAL_CRT_ERROR("fwrite");
+            }
+            rewind(memoryFile);
+            // not owned by the session: closing the file must free the stream
+            file->Attach(memoryFile, false);
+            file->Read();
+            return true;
+        }
+    }
+#endif
     file->Attach(session->OpenFile(pathFont, FileMode::Open, FileAccess::Read, false), true);
     file->Read();
     return true;
@@ -0,0 +1,229 @@
+/**
+ * @file writebehind.cpp
+ * @author Christian Schenk
+ * @brief Write-behind output files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <cerrno>
+
+#if defined(MIKTEX_WINDOWS)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <miktex/Core/Session>
+
+#include "internal.h"
+
+#include "writebehind.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    // the engine waits, if more than this is waiting to be written
+    constexpr size_t BUFFER_CAPACITY = 64 * 1024 * 1024;
+}
+
+WriteBehindFile::WriteBehindFile(FILE* file, const PathName& path) :
+    file(file),
+    path(path)
+{
+    int fds[2];
+#if defined(MIKTEX_WINDOWS)
+    if (_pipe(fds, CHUNK_SIZE, _O_BINARY | _O_NOINHERIT) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("_pipe", "path", path.ToString());
+    }
+    engineFile = _fdopen(fds[1], "wb");
+#else
+    // shell commands must not inherit the pipe: the drainer would not see
+    // the end of the data
+#if defined(__APPLE__)
+    if (pipe(fds) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("pipe", "path", path.ToString());
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#else
+    if (pipe2(fds, O_CLOEXEC) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("pipe2", "path", path.ToString());
+    }
+#endif
+    engineFile = fdopen(fds[1], "wb");
+#endif
+    if (engineFile == nullptr)
+    {
+#if defined(MIKTEX_WINDOWS)
+        _close(fds[0]);
+        _close(fds[1]);
+#else
+        close(fds[0]);
+        close(fds[1]);
+#endif
+        MIKTEX_FATAL_CRT_ERROR_2("fdopen", "path", path.ToString());
+    }
+    readFd = fds[0];
+    setvbuf(engineFile, nullptr, _IOFBF, CHUNK_SIZE);
+    drainer = thread(&WriteBehindFile::Drain, this);
+    writer = thread(&WriteBehindFile::Write, this);
+}
+
+WriteBehindFile::~WriteBehindFile() noexcept
+{
+    try
+    {
+        Stop();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+void WriteBehindFile::Drain()
+{
+    vector<char> chunk(CHUNK_SIZE);
+    while (true)
+    {
+#if defined(MIKTEX_WINDOWS)
+        int n = _read(readFd, chunk.data(), static_cast<unsigned>(chunk.size()));
+#else
+        ssize_t n = read(readFd, chunk.data(), chunk.size());
+#endif
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        unique_lock<std::mutex> lock(mutex);
+        if (n <= 0)
+        {
+            if (n < 0 && error == nullptr)
+            {
+                try
+                {
+                    MIKTEX_FATAL_CRT_ERROR_2("read", "path", path.ToString());
+                }
+                catch (const exception&)
+                {
+                    error = current_exception();
+                }
+            }
+            endOfData = true;
+            changed.notify_all();
+            return;
+        }
+        changed.wait(lock, [this] { return bufferedBytes < BUFFER_CAPACITY; });
+        chunks.push_back(vector<char>(chunk.begin(), chunk.begin() + n));
+        bufferedBytes += n;
+        changed.notify_all();
+    }
+}
+
+void WriteBehindFile::Write()
+{
+    while (true)
+    {
+        vector<char> chunk;
+        bool failed;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return !chunks.empty() || endOfData; });
+            if (chunks.empty())
+            {
+                break;
+            }
+            chunk = std::move(chunks.front());
+            chunks.pop_front();
+            bufferedBytes -= chunk.size();
+            failed = error != nullptr;
+            changed.notify_all();
+        }
+        // after an error, the data is discarded, so that the engine does not
+        // wait forever
+        if (!failed && fwrite(chunk.data(), 1, chunk.size(), file) != chunk.size())
+        {
+            try
+            {
+                MIKTEX_FATAL_CRT_ERROR_2("fwrite", "path", path.ToString());
+            }
+            catch (const exception&)
+            {
+                lock_guard<std::mutex> lock(mutex);
+                error = current_exception();
+            }
+        }
+    }
+    if (fflush(file) != 0)
+    {
+        try
+        {
+            MIKTEX_FATAL_CRT_ERROR_2("fflush", "path", path.ToString());
+        }
+        catch (const exception&)
+        {
+            lock_guard<std::mutex> lock(mutex);
+            if (error == nullptr)
+            {
+                error = current_exception();
+            }
+        }
+    }
+}
+
+void WriteBehindFile::Stop()
+{
+    bool engineFileClosed = true;
+    if (engineFile != nullptr)
+    {
+        engineFileClosed = fclose(engineFile) == 0;
+        engineFile = nullptr;
+    }
+    if (drainer.joinable())
+    {
+        drainer.join();
+    }
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+    if (readFd >= 0)
+    {
+#if defined(MIKTEX_WINDOWS)
+        _close(readFd);
+#else
+        close(readFd);
+#endif
+        readFd = -1;
+    }
+    if (!engineFileClosed)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("fclose", "path", path.ToString());
+    }
+}
+
+FILE* WriteBehindFile::Finish()
+{
+    Stop();
+    if (error != nullptr)
+    {
+        rethrow_exception(error);
+    }
+    return file;
+}
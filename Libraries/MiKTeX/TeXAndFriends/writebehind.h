@@ -0,0 +1,94 @@
+/**
+ * @file writebehind.h
+ * @author Christian Schenk
+ * @brief Write-behind output files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+/// Decouples the engine from a slow output file.
+///
+/// The engine writes into a pipe.  One thread drains the pipe into memory,
+/// another thread writes the collected data to the output file.  The engine
+/// has to wait only if the output file lags behind by more than the buffer
+/// capacity.
+class WriteBehindFile
+{
+
+public:
+
+    /// Starts writing behind.
+    /// @param file The opened output file.
+    /// @param path The path of the output file (for error messages).
+    WriteBehindFile(FILE* file, const MiKTeX::Util::PathName& path);
+
+    WriteBehindFile(const WriteBehindFile& other) = delete;
+    WriteBehindFile& operator=(const WriteBehindFile& other) = delete;
+
+    ~WriteBehindFile() noexcept;
+
+    /// Gets the stream the engine writes into.
+    FILE* GetEngineFile() const
+    {
+        return engineFile;
+    }
+
+    /// Closes the engine stream and waits until all data has been written.
+    /// Throws, if the data could not be written.
+    /// @return Returns the output file, which is still open.
+    FILE* Finish();
+
+private:
+
+    void Drain();
+
+    void Write();
+
+    void Stop();
+
+    FILE* file;
+
+    MiKTeX::Util::PathName path;
+
+    FILE* engineFile = nullptr;
+
+    int readFd = -1;
+
+    std::mutex mutex;
+
+    std::condition_variable changed;
+
+    std::deque<std::vector<char>> chunks;
+
+    std::size_t bufferedBytes = 0;
+
+    bool endOfData = false;
+
+    std::exception_ptr error;
+
+    std::thread drainer;
+
+    std::thread writer;
+};
+
+END_INTERNAL_NAMESPACE;
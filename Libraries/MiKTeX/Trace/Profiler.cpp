@@ -0,0 +1,186 @@
+/* Profiler.cpp: collecting timed scopes
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#if defined(MIKTEX_TRACE_SHARED)
+#  define MIKTEXTRACEEXPORT MIKTEXDLLEXPORT
+#else
+#  define MIKTEXTRACEEXPORT
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#define DE9EF9059C8744B48A68345CD5A8A2C8
+#include <miktex/Trace/Profiler.h>
+
+using namespace MiKTeX::Trace;
+using namespace std;
+
+namespace
+{
+  // beyond this number of events only the summary is updated
+  const size_t MAX_EVENTS = 1000000;
+
+  struct Event
+  {
+    string category;
+    string name;
+    string detail;
+    int64_t start;
+    int64_t duration;
+    int thread;
+  };
+
+  struct Summary
+  {
+    size_t count = 0;
+    int64_t total = 0;
+    int64_t max = 0;
+  };
+
+  atomic_bool enabled(false);
+
+  const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+  mutex eventsMutex;
+
+  vector<Event> events;
+
+  map<pair<string, string>, Summary> summaries;
+
+  unordered_map<thread::id, int> threads;
+}
+
+static string Escape(const string& s)
+{
+  string result;
+  result.reserve(s.length());
+  for (char ch : s)
+  {
+    switch (ch)
+    {
+    case '"':
+      result += "\\\"";
+      break;
+    case '\\':
+      result += "\\\\";
+      break;
+    case '\n':
+      result += "\\n";
+      break;
+    case '\t':
+      result += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(ch) < 0x20)
+      {
+        result += fmt::format("\\u{:04x}", static_cast<unsigned>(ch));
+      }
+      else
+      {
+        result += ch;
+      }
+      break;
+    }
+  }
+  return result;
+}
+
+bool Profiler::IsEnabled()
+{
+  return enabled;
+}
+
+void Profiler::Enable(bool enable)
+{
+  enabled = enable;
+}
+
+int64_t Profiler::Now()
+{
+  return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Record(const string& category, const string& name, const string& detail, int64_t start, int64_t duration)
+{
+  if (!enabled)
+  {
+    return;
+  }
+  lock_guard<mutex> lockGuard(eventsMutex);
+  Summary& summary = summaries[make_pair(category, name)];
+  summary.count += 1;
+  summary.total += duration;
+  summary.max = std::max(summary.max, duration);
+  if (events.size() >= MAX_EVENTS)
+  {
+    return;
+  }
+  auto it = threads.find(this_thread::get_id());
+  if (it == threads.end())
+  {
+    it = threads.insert(make_pair(this_thread::get_id(), static_cast<int>(threads.size()) + 1)).first;
+  }
+  events.push_back(Event{ category, name, detail, start, duration, it->second });
+}
+
+void Profiler::WriteChromeTrace(ostream& stream)
+{
+  lock_guard<mutex> lockGuard(eventsMutex);
+  stream << "{\"traceEvents\":[";
+  bool first = true;
+  for (const Event& e : events)
+  {
+    stream << (first ? "\n" : ",\n");
+    first = false;
+    stream << fmt::format(R"({{"name":"{0}","cat":"{1}","ph":"X","pid":1,"tid":{2},"ts":{3},"dur":{4})", Escape(e.name), Escape(e.category), e.thread, e.start, e.duration);
+    if (!e.detail.empty())
+    {
+      stream << fmt::format(R"(,"args":{{"detail":"{0}"}})", Escape(e.detail));
+    }
+    stream << "}";
+  }
+  stream << "\n],\n\"displayTimeUnit\":\"ms\",\n\"summary\":[";
+  first = true;
+  for (const auto& s : summaries)
+  {
+    stream << (first ? "\n" : ",\n");
+    first = false;
+    stream << fmt::format(R"({{"cat":"{0}","name":"{1}","count":{2},"totalUs":{3},"maxUs":{4}}})", Escape(s.first.first), Escape(s.first.second), s.second.count, s.second.total, s.second.max);
+  }
+  stream << "\n]}\n";
+}
+
+void Profiler::Reset()
+{
+  lock_guard<mutex> lockGuard(eventsMutex);
+  events.clear();
+  summaries.clear();
+}
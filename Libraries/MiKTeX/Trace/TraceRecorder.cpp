@@ -0,0 +1,291 @@
+/* TraceRecorder.cpp: recording trace messages in a ring buffer
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#if defined(MIKTEX_TRACE_SHARED)
+#  define MIKTEXTRACEEXPORT MIKTEXDLLEXPORT
+#else
+#  define MIKTEXTRACEEXPORT
+#endif
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#if defined(_WIN32)
+#  include <io.h>
+#  include <sys/stat.h>
+#else
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define DE9EF9059C8744B48A68345CD5A8A2C8
+#include <miktex/Trace/TraceRecorder.h>
+
+using namespace MiKTeX::Trace;
+using namespace std;
+
+namespace
+{
+  const char DUMP_FILE_SIGNATURE[16] = "miktex-trace-1\n";
+
+  // a slot has a fixed size; longer names and messages get truncated
+  struct Slot
+  {
+    // 0: empty; 2n+1: record n is being written; 2n+2: record n is complete
+    atomic<uint64_t> sequence;
+    int64_t timestamp;
+    uint32_t thread;
+    uint8_t level;
+    uint8_t reserved;
+    uint16_t messageLength;
+    char streamName[32];
+    char facility[32];
+    char message[424];
+  };
+
+  static_assert(sizeof(Slot) == 512, "unexpected slot size");
+
+  struct DumpFileHeader
+  {
+    char signature[sizeof(DUMP_FILE_SIGNATURE)];
+    uint32_t slotSize;
+    uint32_t capacity;
+  };
+
+  // -1: not recording
+  atomic_int recordLevel(-1);
+
+  mutex startMutex;
+
+  // never freed: the ring buffer must survive static destruction, because
+  // it is dumped by an atexit handler
+  Slot* slots = nullptr;
+
+  size_t capacity = 0;
+
+  atomic<uint64_t> nextRecord(0);
+
+  // a fixed buffer, so that the signal handler does not allocate memory
+  char dumpFilePath[4096];
+
+  // prepared by Start(), so that the signal handler only has to write
+  DumpFileHeader dumpFileHeader;
+
+  typedef void (*SignalHandler)(int);
+
+  SignalHandler previousSigIntHandler = SIG_DFL;
+
+  SignalHandler previousSigTermHandler = SIG_DFL;
+
+  SignalHandler previousSigAbrtHandler = SIG_DFL;
+}
+
+static void CopyString(char* dest, size_t size, const string& s)
+{
+  size_t n = std::min(s.length(), size - 1);
+  memcpy(dest, s.c_str(), n);
+  dest[n] = 0;
+}
+
+// async-signal-safe: plain write() calls on a file descriptor
+static bool WriteAll(int fd, const void* data, size_t size)
+{
+  const char* p = static_cast<const char*>(data);
+  while (size > 0)
+  {
+#if defined(_WIN32)
+    int n = _write(fd, p, static_cast<unsigned>(std::min<size_t>(size, 1024 * 1024)));
+#else
+    ssize_t n = write(fd, p, size);
+#endif
+    if (n <= 0)
+    {
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+static void DumpAtExit()
+{
+  TraceRecorder::Dump();
+}
+
+static void OnSignal(int sig)
+{
+  TraceRecorder::Dump();
+  // chain to the handler which was installed before
+  SignalHandler previous = sig == SIGINT ? previousSigIntHandler : sig == SIGTERM ? previousSigTermHandler : previousSigAbrtHandler;
+  if (previous == SIG_IGN)
+  {
+    return;
+  }
+  if (previous != SIG_DFL && previous != SIG_ERR && previous != nullptr)
+  {
+    signal(sig, OnSignal);
+    previous(sig);
+    return;
+  }
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+static SignalHandler InstallSignalHandler(int sig)
+{
+  SignalHandler previous = signal(sig, OnSignal);
+  return previous == SIG_ERR ? SIG_DFL : previous;
+}
+
+void TraceRecorder::Start(const string& dumpFile, TraceLevel level, size_t capacity)
+{
+  lock_guard<mutex> lockGuard(startMutex);
+  if (dumpFile.length() >= sizeof(dumpFilePath))
+  {
+    throw invalid_argument("dump file path is too long");
+  }
+  CopyString(dumpFilePath, sizeof(dumpFilePath), dumpFile);
+  if (slots == nullptr)
+  {
+    ::capacity = std::max<size_t>(capacity, 1);
+    slots = new Slot[::capacity]();
+    memset(&dumpFileHeader, 0, sizeof(dumpFileHeader));
+    memcpy(dumpFileHeader.signature, DUMP_FILE_SIGNATURE, sizeof(dumpFileHeader.signature));
+    dumpFileHeader.slotSize = sizeof(Slot);
+    dumpFileHeader.capacity = static_cast<uint32_t>(::capacity);
+    atexit(DumpAtExit);
+    previousSigIntHandler = InstallSignalHandler(SIGINT);
+    previousSigTermHandler = InstallSignalHandler(SIGTERM);
+    previousSigAbrtHandler = InstallSignalHandler(SIGABRT);
+  }
+  recordLevel.store(static_cast<int>(level), memory_order_release);
+}
+
+bool TraceRecorder::IsRecording(TraceLevel level)
+{
+  return static_cast<int>(level) <= recordLevel.load(memory_order_acquire);
+}
+
+void TraceRecorder::Record(const string& streamName, const string& facility, TraceLevel level, const string& message)
+{
+  if (!IsRecording(level))
+  {
+    return;
+  }
+  uint64_t n = nextRecord.fetch_add(1, memory_order_relaxed);
+  Slot& slot = slots[n % ::capacity];
+  slot.sequence.store(2 * n + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  slot.timestamp = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+  slot.thread = static_cast<uint32_t>(hash<thread::id>()(this_thread::get_id()));
+  slot.level = static_cast<uint8_t>(level);
+  CopyString(slot.streamName, sizeof(slot.streamName), streamName);
+  CopyString(slot.facility, sizeof(slot.facility), facility);
+  slot.messageLength = static_cast<uint16_t>(std::min(message.length(), sizeof(slot.message)));
+  memcpy(slot.message, message.c_str(), slot.messageLength);
+  slot.sequence.store(2 * n + 2, memory_order_release);
+}
+
+void TraceRecorder::Dump()
+{
+  // also called by the signal handler: no locks, no exceptions
+  if (slots == nullptr)
+  {
+    return;
+  }
+  // no stdio: fopen() and fwrite() are not async-signal-safe
+#if defined(_WIN32)
+  int fd = _open(dumpFilePath, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  int fd = open(dumpFilePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+#endif
+  if (fd < 0)
+  {
+    return;
+  }
+  if (WriteAll(fd, &dumpFileHeader, sizeof(dumpFileHeader)))
+  {
+    WriteAll(fd, slots, sizeof(Slot) * ::capacity);
+  }
+#if defined(_WIN32)
+  _close(fd);
+#else
+  close(fd);
+#endif
+}
+
+vector<TraceRecorder::Entry> TraceRecorder::ReadDumpFile(const string& path)
+{
+  ifstream stream(path, ios_base::in | ios_base::binary);
+  if (!stream)
+  {
+    throw runtime_error(path + ": cannot open dump file");
+  }
+  DumpFileHeader header;
+  if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+    || memcmp(header.signature, DUMP_FILE_SIGNATURE, sizeof(header.signature)) != 0
+    || header.slotSize != sizeof(Slot))
+  {
+    throw runtime_error(path + ": not a trace dump file");
+  }
+  vector<pair<uint64_t, Entry>> entries;
+  Slot slot;
+  for (uint32_t idx = 0; idx < header.capacity && stream.read(reinterpret_cast<char*>(&slot), sizeof(slot)); ++idx)
+  {
+    uint64_t sequence = slot.sequence.load();
+    // skip empty slots and records which were being written
+    if (sequence == 0 || sequence % 2 != 0)
+    {
+      continue;
+    }
+    slot.streamName[sizeof(slot.streamName) - 1] = 0;
+    slot.facility[sizeof(slot.facility) - 1] = 0;
+    Entry entry;
+    entry.timestamp = slot.timestamp;
+    entry.thread = slot.thread;
+    entry.streamName = slot.streamName;
+    entry.facility = slot.facility;
+    entry.level = static_cast<TraceLevel>(std::min<uint8_t>(slot.level, static_cast<uint8_t>(TraceLevel::Debug)));
+    entry.message.assign(slot.message, std::min<size_t>(slot.messageLength, sizeof(slot.message)));
+    entries.push_back(make_pair(sequence, std::move(entry)));
+  }
+  sort(entries.begin(), entries.end(), [](const pair<uint64_t, Entry>& a, const pair<uint64_t, Entry>& b) { return a.first < b.first; });
+  vector<Entry> result;
+  result.reserve(entries.size());
+  for (auto& e : entries)
+  {
+    result.push_back(std::move(e.second));
+  }
+  return result;
+}
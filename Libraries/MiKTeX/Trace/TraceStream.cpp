@@ -1,6 +1,6 @@
 /* TaceStream.cpp: tracing
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Trace Library.
 
@@ -32,6 +32,7 @@
 #include <miktex/Util/Tokenizer>
 
 #define DE9EF9059C8744B48A68345CD5A8A2C8
+#include <miktex/Trace/TraceRecorder.h>
 #include <miktex/Trace/TraceStream.h>
 
 #if defined(MIKTEX_WINDOWS)
@@ -41,6 +42,7 @@
 #include <ctime>
 
 #include <algorithm>
+#include <atomic>
 #include <codecvt>
 #include <exception>
 #include <memory>
@@ -113,8 +115,12 @@ TraceStream::~TraceStream() noexcept
 struct TraceStreamInfo
 {
   string name;
+  // guarded by traceStreamsMutex
   vector<string> enabledFor;
-  TraceLevel level;
+  // cached: let IsEnabled() reject disabled levels without locking
+  atomic<TraceLevel> level{ defaultLevel };
+  // cached: enabledFor.empty()
+  atomic_bool allFacilities{ true };
   vector<TraceCallback*> callbacks;
 };
 
@@ -165,6 +171,9 @@ private:
 private:
   void Logger(const string& facility, TraceLevel level, const string& message);
 
+private:
+  bool IsEnabledByOptions(const string& facility, TraceLevel level);
+
 private:
   friend class TraceStream;
 
@@ -187,7 +196,11 @@ vector<string> TraceStreamImpl::options = defaultOptions;
 
 void TraceStreamImpl::Logger(const string& facility, TraceLevel level, const string& message)
 {
-  if (!IsEnabled(facility, level))
+  if (TraceRecorder::IsRecording(level))
+  {
+    TraceRecorder::Record(info->name, facility, level, message);
+  }
+  if (!IsEnabledByOptions(facility, level))
   {
     return;
   }
@@ -259,6 +272,11 @@ void TraceStream::SetOptions(const vector<string>& options)
       }
     }
   }
+
+  for (auto& kv : TraceStreamImpl::traceStreams)
+  {
+    kv.second->allFacilities = kv.second->enabledFor.empty();
+  }
 }
 
 void TraceStreamImpl::WriteLine(const string& facility, TraceLevel level, const string& text)
@@ -298,6 +316,7 @@ unique_ptr<TraceStream> TraceStream::Open(const string& name, TraceLevel level,
         }
       }
     }
+    traceStreamInfo->allFacilities = traceStreamInfo->enabledFor.empty();
     TraceStreamImpl::traceStreams[name] = traceStreamInfo;
   }
   return make_unique<TraceStreamImpl>(traceStreamInfo, callback);
@@ -323,8 +342,23 @@ void TraceStreamImpl::Close()
 
 bool TraceStreamImpl::IsEnabled(const string& facility, TraceLevel level)
 {
-  return (this->info->enabledFor.empty() || find(this->info->enabledFor.begin(), this->info->enabledFor.end(), facility) != this->info->enabledFor.end())
-    && level <= this->info->level;
+  return TraceRecorder::IsRecording(level) || IsEnabledByOptions(facility, level);
+}
+
+bool TraceStreamImpl::IsEnabledByOptions(const string& facility, TraceLevel level)
+{
+  // fast path: no lock is needed unless the level is enabled and the
+  // stream is restricted to some facilities
+  if (level > info->level.load(memory_order_relaxed))
+  {
+    return false;
+  }
+  if (info->allFacilities.load(memory_order_relaxed))
+  {
+    return true;
+  }
+  lock_guard<mutex> lockGuard(traceStreamsMutex);
+  return find(info->enabledFor.begin(), info->enabledFor.end(), facility) != info->enabledFor.end();
 }
 
 string TraceCallback::TraceMessage::ToString() const
@@ -0,0 +1,133 @@
+/* miktex/Trace/Profiler.h:                             -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(B27B850C775CF41D5839D475F607E3D9)
+#define B27B850C775CF41D5839D475F607E3D9
+
+#include "config.h"
+
+#include <cstdint>
+
+#include <exception>
+#include <ostream>
+#include <string>
+
+MIKTEX_TRACE_BEGIN_NAMESPACE;
+
+/// Collects timed scopes of the running process.
+///
+/// The profiler is disabled by default; recording a scope is then
+/// (almost) free.  The collected events can be written in the Chrome
+/// tracing format, which is understood by `chrome://tracing` and Perfetto.
+class Profiler
+{
+public:
+  Profiler() = delete;
+
+public:
+  static MIKTEXTRACECEEAPI(bool) IsEnabled();
+
+public:
+  static MIKTEXTRACECEEAPI(void) Enable(bool enable);
+
+  /// Gets the time (in microseconds) since the profiler was loaded.
+public:
+  static MIKTEXTRACECEEAPI(std::int64_t) Now();
+
+  /// Records a completed scope.
+  /// @param category The category (e.g., `core`).
+  /// @param name The name of the scope (e.g., `find file`).
+  /// @param detail An optional detail (e.g., the file name).
+  /// @param start Start time, as obtained by `Now()`.
+  /// @param duration Duration in microseconds.
+public:
+  static MIKTEXTRACECEEAPI(void) Record(const std::string& category, const std::string& name, const std::string& detail, std::int64_t start, std::int64_t duration);
+
+  /// Writes the recorded events and a summary (count, total and maximum
+  /// duration per scope name) as a Chrome trace.
+public:
+  static MIKTEXTRACECEEAPI(void) WriteChromeTrace(std::ostream& stream);
+
+  /// Discards the recorded events.
+public:
+  static MIKTEXTRACECEEAPI(void) Reset();
+};
+
+/// Records the lifetime of the object, if the profiler is enabled.
+class ProfileScope
+{
+public:
+  ProfileScope(const char* category, const char* name) :
+    ProfileScope(category, name, std::string())
+  {
+  }
+
+public:
+  ProfileScope(const char* category, const char* name, const std::string& detail) :
+    category(category),
+    name(name)
+  {
+    if (Profiler::IsEnabled())
+    {
+      this->detail = detail;
+      start = Profiler::Now();
+    }
+  }
+
+public:
+  ProfileScope(const ProfileScope& other) = delete;
+
+public:
+  ProfileScope& operator=(const ProfileScope& other) = delete;
+
+public:
+  ~ProfileScope()
+  {
+    try
+    {
+      if (start >= 0)
+      {
+        Profiler::Record(category, name, detail, start, Profiler::Now() - start);
+      }
+    }
+    catch (const std::exception&)
+    {
+    }
+  }
+
+private:
+  const char* category;
+
+private:
+  const char* name;
+
+private:
+  std::string detail;
+
+private:
+  std::int64_t start = -1;
+};
+
+MIKTEX_TRACE_END_NAMESPACE;
+
+#endif
@@ -0,0 +1,90 @@
+/* miktex/Trace/TraceRecorder.h:                        -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(E41F0A2C6B8D4E0F9C3A5B7D1E2F4A6C)
+#define E41F0A2C6B8D4E0F9C3A5B7D1E2F4A6C
+
+#include "config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "TraceCallback.h"
+
+MIKTEX_TRACE_BEGIN_NAMESPACE;
+
+/// Records trace messages in a fixed-size in-memory ring buffer.
+///
+/// Recording bypasses the trace callbacks: a message is copied (and
+/// truncated, if necessary) into the next slot of the ring buffer without
+/// taking a lock.  The ring buffer is written to a dump file when the
+/// process exits, when it is terminated by `SIGINT`, `SIGTERM` or `SIGABRT`,
+/// or when `Dump()` is called.
+class TraceRecorder
+{
+public:
+  TraceRecorder() = delete;
+
+  /// An entry read from a dump file.
+public:
+  struct Entry
+  {
+    /// Microseconds since the Unix epoch.
+    std::int64_t timestamp;
+    std::uint32_t thread;
+    std::string streamName;
+    std::string facility;
+    TraceLevel level;
+    std::string message;
+  };
+
+  /// Starts recording.
+  /// @param dumpFile The path to the dump file.
+  /// @param level Messages up to this level are recorded.
+  /// @param capacity The number of records kept in memory.
+public:
+  static MIKTEXTRACECEEAPI(void) Start(const std::string& dumpFile, TraceLevel level, std::size_t capacity);
+
+  /// Tests whether messages of the given level are recorded.
+public:
+  static MIKTEXTRACECEEAPI(bool) IsRecording(TraceLevel level);
+
+public:
+  static MIKTEXTRACECEEAPI(void) Record(const std::string& streamName, const std::string& facility, TraceLevel level, const std::string& message);
+
+  /// Writes the ring buffer to the dump file.
+public:
+  static MIKTEXTRACECEEAPI(void) Dump();
+
+  /// Reads a dump file.
+  /// @return Returns the entries in the order they were recorded.
+public:
+  static MIKTEXTRACECEEAPI(std::vector<Entry>) ReadDumpFile(const std::string& path);
+};
+
+MIKTEX_TRACE_END_NAMESPACE;
+
+#endif
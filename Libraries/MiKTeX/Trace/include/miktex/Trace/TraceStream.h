@@ -1,6 +1,6 @@
 /* miktex/Trace/TraceStream.h:                           -*- C++ -*-
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Trace Library.
 
@@ -78,4 +78,17 @@ public:
 
 MIKTEX_TRACE_END_NAMESPACE;
 
+/// Writes a line to a trace stream.  The text expression is evaluated only
+/// if the stream is enabled for the facility and the level, i.e., hot paths
+/// do not pay for formatting messages which get discarded.
+#define MIKTEX_TRACE_WRITE_LINE(traceStream, facility, level, text) \
+  do \
+  { \
+    MiKTeX::Trace::TraceStream& traceStream_ = *(traceStream); \
+    if (traceStream_.IsEnabled(facility, level)) \
+    { \
+      traceStream_.WriteLine(facility, level, text); \
+    } \
+  } while (false)
+
 #endif
@@ -16,8 +16,11 @@
 #include <fcntl.h>
 
 #include <cstdarg>
+#include <cstring>
+#include <cwchar>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -55,14 +58,92 @@ private:
     char errorMessage[2048];
 };
 
-MIKTEXSTATICFUNC(unique_ptr<wchar_t[]>) UTF8ToLengthExtendedPath(const char* utf8String, const char* function)
+// the size of the buffer on the stack: most strings (path names) fit
+constexpr size_t STACK_BUFFER_SIZE = MAX_PATH + 1;
+
+// a conversion result; used as a temporary in the argument list of the
+// wrapped function
+class WideCharBuffer
+{
+public:
+
+    wchar_t* Reserve(size_t n)
+    {
+        if (n <= STACK_BUFFER_SIZE)
+        {
+            return stackBuffer;
+        }
+        heapBuffer = make_unique<wchar_t[]>(n);
+        return heapBuffer.get();
+    }
+
+    const wchar_t* Get() const
+    {
+        return heapBuffer != nullptr ? heapBuffer.get() : stackBuffer;
+    }
+
+private:
+
+    wchar_t stackBuffer[STACK_BUFFER_SIZE];
+    unique_ptr<wchar_t[]> heapBuffer;
+};
+
+// the result of the conversion to a length-extended path name depends on the
+// current directory, if the path name is not fully qualified
+struct ExtendedPathCacheEntry
 {
+    string utf8;
+    wstring currentDirectory;
+    wstring extendedPath;
+};
+
+constexpr size_t EXTENDED_PATH_CACHE_SIZE = 64;
+
+thread_local ExtendedPathCacheEntry extendedPathCache[EXTENDED_PATH_CACHE_SIZE];
+
+MIKTEXSTATICFUNC(bool) IsFullyQualified(const char* path)
+{
+    return (PathNameUtil::IsDirectoryDelimiter(path[0]) && PathNameUtil::IsDirectoryDelimiter(path[1]) && path[2] != 0)
+        || (PathNameUtil::IsDosDriveLetter(path[0]) && PathNameUtil::IsDosVolumeDelimiter(path[1]) && PathNameUtil::IsDirectoryDelimiter(path[2]));
+}
+
+MIKTEXSTATICFUNC(const wchar_t*) UTF8ToLengthExtendedPath(WideCharBuffer&& buffer, const char* utf8String, const char* function)
+{
+    size_t length = strlen(utf8String);
+    bool fullyQualified = IsFullyQualified(utf8String);
+    wchar_t currentDirectory[STACK_BUFFER_SIZE];
+    // "C:foo.txt" is relative to the current directory of drive C:
+    bool cacheable = fullyQualified || !(length > 1 && PathNameUtil::IsDosVolumeDelimiter(utf8String[1]));
+    if (cacheable && !fullyQualified)
+    {
+        DWORD n = GetCurrentDirectoryW(STACK_BUFFER_SIZE, currentDirectory);
+        cacheable = n > 0 && n < STACK_BUFFER_SIZE;
+    }
     try
     {
-        wstring wch = PathNameUtil::ToLengthExtendedPathName(utf8String);
-        unique_ptr<wchar_t[]> buf(new wchar_t[wch.length() + 1]);
-        StringUtil::CopyCeeString(buf.get(), wch.length() + 1, wch.c_str());
-        return buf;
+        if (!cacheable)
+        {
+            wstring wch = PathNameUtil::ToLengthExtendedPathName(utf8String);
+            wmemcpy(buffer.Reserve(wch.length() + 1), wch.c_str(), wch.length() + 1);
+            return buffer.Get();
+        }
+        size_t h = 2166136261u;
+        for (size_t idx = 0; idx < length; ++idx)
+        {
+            h = (h ^ static_cast<unsigned char>(utf8String[idx])) * 16777619u;
+        }
+        ExtendedPathCacheEntry& entry = extendedPathCache[h % EXTENDED_PATH_CACHE_SIZE];
+        if (!(entry.utf8.length() == length
+            && memcmp(entry.utf8.c_str(), utf8String, length) == 0
+            && (fullyQualified ? entry.currentDirectory.empty() : entry.currentDirectory == currentDirectory)))
+        {
+            entry.extendedPath = PathNameUtil::ToLengthExtendedPathName(utf8String);
+            entry.utf8.assign(utf8String, length);
+            entry.currentDirectory.assign(fullyQualified ? L"" : currentDirectory);
+        }
+        // copy: the entry might be replaced while converting the next argument
+        wmemcpy(buffer.Reserve(entry.extendedPath.length() + 1), entry.extendedPath.c_str(), entry.extendedPath.length() + 1);
+        return buffer.Get();
     }
     catch (const exception&)
     {
@@ -70,20 +151,22 @@ MIKTEXSTATICFUNC(unique_ptr<wchar_t[]>) UTF8ToLengthExtendedPath(const char* utf
     }
 }
 
-
-MIKTEXSTATICFUNC(unique_ptr<wchar_t[]>) UTF8ToWideChar(const char* utf8String, const char* function)
+MIKTEXSTATICFUNC(const wchar_t*) UTF8ToWideChar(WideCharBuffer&& buffer, const char* utf8String, const char* function)
 {
-    try
+    int n = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8String, -1, buffer.Reserve(STACK_BUFFER_SIZE), static_cast<int>(STACK_BUFFER_SIZE));
+    if (n == 0 && GetLastError() == ERROR_INSUFFICIENT_BUFFER)
     {
-        wstring wch = StringUtil::UTF8ToWideChar(utf8String);
-        unique_ptr<wchar_t[]> buf(new wchar_t[wch.length() + 1]);
-        StringUtil::CopyCeeString(buf.get(), wch.length() + 1, wch.c_str());
-        return buf;
+        n = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8String, -1, nullptr, 0);
+        if (n > 0)
+        {
+            n = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8String, -1, buffer.Reserve(n), n);
+        }
     }
-    catch (const exception&)
+    if (n == 0)
     {
         throw utf8wraperror(function, utf8String);
     }
+    return buffer.Get();
 }
 
 MIKTEXSTATICFUNC(unique_ptr<char[]>) WideCharToUTF8(const wchar_t* wideCharString, const char* function)
@@ -101,8 +184,8 @@ MIKTEXSTATICFUNC(unique_ptr<char[]>) WideCharToUTF8(const wchar_t* wideCharStrin
     }
 };
 
-#define EXPATH_(x) UTF8ToLengthExtendedPath(x, __func__).get()
-#define UW_(x) UTF8ToWideChar(x, __func__).get()
+#define EXPATH_(x) UTF8ToLengthExtendedPath(WideCharBuffer(), x, __func__)
+#define UW_(x) UTF8ToWideChar(WideCharBuffer(), x, __func__)
 #define WU_(x) WideCharToUTF8(x, __func__).get()
 
 MIKTEXUTF8WRAPCEEAPI(FILE*) miktex_utf8_fopen(const char* path, const char* mode)
@@ -0,0 +1,189 @@
+/**
+ * @file AsciiCase.cpp
+ * @author Christian Schenk
+ * @brief ASCII case folding kernels
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Util Library.
+ *
+ * The MiKTeX Util Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIKTEX_UTIL_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIKTEX_UTIL_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIKTEX_UTIL_NEON 1
+#endif
+
+#define A7C88F5FBE5C45EB970B3796F331CD89
+#include "miktex/Util/config.h"
+
+#if defined(MIKTEX_UTIL_SHARED)
+#define MIKTEXUTILEXPORT MIKTEXDLLEXPORT
+#else
+#define MIKTEXUTILEXPORT
+#endif
+
+#include "miktex/Util/StringUtil.h"
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Util;
+
+// Bytes >= 0x80 (UTF-8 sequences) are never touched by the kernels below:
+// they are negative when compared as signed bytes and thus fall outside of
+// the 'A'..'Z' range.
+
+namespace
+{
+    inline unsigned char ToLowerAsciiChar(unsigned char ch)
+    {
+        return ch >= 'A' && ch <= 'Z' ? ch + ('a' - 'A') : ch;
+    }
+
+#if defined(MIKTEX_UTIL_AVX2)
+    inline __m256i ToLowerAscii32(__m256i v)
+    {
+        __m256i isUpper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+        return _mm256_or_si256(v, _mm256_and_si256(isUpper, _mm256_set1_epi8(0x20)));
+    }
+#endif
+
+#if defined(MIKTEX_UTIL_SSE2)
+    inline __m128i ToLowerAscii16(__m128i v)
+    {
+        __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        return _mm_or_si128(v, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+    }
+#endif
+
+#if defined(MIKTEX_UTIL_NEON)
+    inline uint8x16_t ToLowerAscii16(uint8x16_t v)
+    {
+        uint8x16_t isUpper = vandq_u8(vcgeq_u8(v, vdupq_n_u8('A')), vcleq_u8(v, vdupq_n_u8('Z')));
+        return vorrq_u8(v, vandq_u8(isUpper, vdupq_n_u8(0x20)));
+    }
+#endif
+}
+
+bool StringUtil::IsAscii(const char* s, size_t n)
+{
+    size_t i = 0;
+#if defined(MIKTEX_UTIL_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        acc = _mm_or_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+    }
+    if (_mm_movemask_epi8(acc) != 0)
+    {
+        return false;
+    }
+#elif defined(MIKTEX_UTIL_NEON)
+    uint8x16_t acc = vdupq_n_u8(0);
+    for (; i + 16 <= n; i += 16)
+    {
+        acc = vorrq_u8(acc, vld1q_u8(reinterpret_cast<const uint8_t*>(s + i)));
+    }
+    if (vmaxvq_u8(acc) >= 0x80)
+    {
+        return false;
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        if (static_cast<unsigned char>(s[i]) >= 0x80)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StringUtil::ToLowerAscii(char* dest, const char* source, size_t n)
+{
+    size_t i = 0;
+#if defined(MIKTEX_UTIL_AVX2)
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), ToLowerAscii32(v));
+    }
+#endif
+#if defined(MIKTEX_UTIL_SSE2)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), ToLowerAscii16(v));
+    }
+#elif defined(MIKTEX_UTIL_NEON)
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(source + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dest + i), ToLowerAscii16(v));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dest[i] = static_cast<char>(ToLowerAsciiChar(static_cast<unsigned char>(source[i])));
+    }
+}
+
+size_t StringUtil::MismatchIgnoreCaseAscii(const char* s1, const char* s2, size_t n)
+{
+    size_t i = 0;
+#if defined(MIKTEX_UTIL_AVX2)
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i v1 = ToLowerAscii32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s1 + i)));
+        __m256i v2 = ToLowerAscii32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s2 + i)));
+        if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v1, v2))) != 0xffffffffu)
+        {
+            break;
+        }
+    }
+#endif
+#if defined(MIKTEX_UTIL_SSE2)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v1 = ToLowerAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s1 + i)));
+        __m128i v2 = ToLowerAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s2 + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) != 0xffff)
+        {
+            break;
+        }
+    }
+#elif defined(MIKTEX_UTIL_NEON)
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t v1 = ToLowerAscii16(vld1q_u8(reinterpret_cast<const uint8_t*>(s1 + i)));
+        uint8x16_t v2 = ToLowerAscii16(vld1q_u8(reinterpret_cast<const uint8_t*>(s2 + i)));
+        if (vminvq_u8(vceqq_u8(v1, v2)) != 0xff)
+        {
+            break;
+        }
+    }
+#endif
+    // the scalar loop pinpoints the mismatch within the last block
+    for (; i < n; ++i)
+    {
+        if (ToLowerAsciiChar(static_cast<unsigned char>(s1[i])) != ToLowerAsciiChar(static_cast<unsigned char>(s2[i])))
+        {
+            return i;
+        }
+    }
+    return n;
+}
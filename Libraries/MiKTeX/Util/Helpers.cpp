@@ -11,6 +11,8 @@
  * 2 or any later version.
  */
 
+#include <cstring>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -27,14 +29,7 @@ BEGIN_INTERNAL_NAMESPACE;
 
 bool Helpers::IsPureAscii(const char* lpsz)
 {
-    for (; *lpsz != 0; ++lpsz)
-    {
-        if (static_cast<unsigned>(*lpsz) > 127)
-        {
-            return false;
-        }
-    }
-    return true;
+    return StringUtil::IsAscii(lpsz, strlen(lpsz));
 }
 
 const char* Helpers::GetFileNameExtension(const char* path)
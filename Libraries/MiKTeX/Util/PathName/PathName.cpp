@@ -15,6 +15,8 @@
 #include <direct.h>
 #endif
 
+#include <cstring>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -29,6 +31,7 @@
 
 #include "miktex/Util/PathName.h"
 #include "miktex/Util/PathNameParser.h"
+#include "miktex/Util/PathNameView.h"
 
 #include "internal.h"
 
@@ -39,26 +42,8 @@ using namespace std;
 
 using namespace MiKTeX::Util;
 
-int PathName::Compare(const PathName& path1_, const PathName& path2_)
+static int CompareFrom(const char* lpszPath1, const char* lpszPath2, int cmp)
 {
-    PathName path1(path1_);
-    PathName path2(path2_);
-#if defined(MIKTEX_WINDOWS)
-    path1.TransformForComparison();
-    path2.TransformForComparison();
-#endif
-    const char* lpszPath1 = path1.GetData();
-    const char* lpszPath2 = path2.GetData();
-
-    int ret;
-    int cmp;
-
-    while ((cmp = *lpszPath1 - *lpszPath2) == 0 && *lpszPath1 != 0)
-    {
-        ++lpszPath1;
-        ++lpszPath2;
-    }
-
     if (cmp != 0)
     {
         if (
@@ -71,18 +56,59 @@ int PathName::Compare(const PathName& path1_, const PathName& path2_)
 
     if (cmp < 0)
     {
-        ret = -1;
+        return -1;
     }
     else if (cmp > 0)
     {
-        ret = 1;
+        return 1;
     }
     else
     {
-        ret = 0;
+        return 0;
     }
+}
 
-    return ret;
+int PathNameView::Compare(PathNameView path1_, PathNameView path2_)
+{
+#if defined(MIKTEX_WINDOWS)
+    const char* lpszPath1_ = path1_.GetData();
+    const char* lpszPath2_ = path2_.GetData();
+    size_t len1 = path1_.GetLength();
+    size_t len2 = path2_.GetLength();
+    if (StringUtil::IsAscii(lpszPath1_, len1) && StringUtil::IsAscii(lpszPath2_, len2)
+        && memchr(lpszPath1_, PathNameUtil::DirectoryDelimiter, len1) == nullptr
+        && memchr(lpszPath2_, PathNameUtil::DirectoryDelimiter, len2) == nullptr)
+    {
+        // fast path: compare without making lower-case copies
+        size_t idx = StringUtil::MismatchIgnoreCaseAscii(lpszPath1_, lpszPath2_, std::min(len1, len2));
+        int cmp = Helpers::ToLowerAscii(lpszPath1_[idx]) - Helpers::ToLowerAscii(lpszPath2_[idx]);
+        return CompareFrom(lpszPath1_ + idx, lpszPath2_ + idx, cmp);
+    }
+    PathName path1(lpszPath1_);
+    PathName path2(lpszPath2_);
+    path1.TransformForComparison();
+    path2.TransformForComparison();
+    const char* lpszPath1 = path1.GetData();
+    const char* lpszPath2 = path2.GetData();
+#else
+    const char* lpszPath1 = path1_.GetData();
+    const char* lpszPath2 = path2_.GetData();
+#endif
+
+    int cmp;
+
+    while ((cmp = *lpszPath1 - *lpszPath2) == 0 && *lpszPath1 != 0)
+    {
+        ++lpszPath1;
+        ++lpszPath2;
+    }
+
+    return CompareFrom(lpszPath1, lpszPath2, cmp);
+}
+
+int PathName::Compare(const PathName& path1, const PathName& path2)
+{
+    return PathNameView::Compare(PathNameView(path1), PathNameView(path2));
 }
 
 int PathName::ComparePrefixes(const PathName& path1_, const PathName& path2_, size_t count)
@@ -241,11 +267,19 @@ PathName& PathName::Convert(ConvertPathNameOptions options)
 
     if (toUpper || toLower)
     {
-        if (Helpers::IsPureAscii(GetData()))
+        size_t len = GetLength();
+        if (StringUtil::IsAscii(GetData(), len))
         {
-            for (char* lpsz = GetData(); *lpsz != 0; ++lpsz)
+            if (toLower)
             {
-                *lpsz = toUpper ? Helpers::ToUpperAscii(*lpsz) : Helpers::ToLowerAscii(*lpsz);
+                StringUtil::ToLowerAscii(GetData(), GetData(), len);
+            }
+            else
+            {
+                for (char* lpsz = GetData(); *lpsz != 0; ++lpsz)
+                {
+                    *lpsz = Helpers::ToUpperAscii(*lpsz);
+                }
             }
         }
         else
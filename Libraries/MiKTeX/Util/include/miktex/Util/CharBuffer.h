@@ -18,6 +18,7 @@
 #include <cstddef>
 #include <cwchar>
 
+#include <algorithm>
 #include <string>
 
 #include "StringUtil.h"
@@ -42,7 +43,8 @@ public:
     {
         if (other.buffer == other.smallBuffer)
         {
-            memcpy(this->smallBuffer, other.smallBuffer, BUFSIZE);
+            // copy the used part only
+            memcpy(this->smallBuffer, other.smallBuffer, std::min<std::size_t>(other.GetLength() + 1, BUFSIZE) * sizeof(CharType));
             this->buffer = this->smallBuffer;
         }
         else
@@ -68,7 +70,7 @@ public:
             Reset();
             if (other.buffer == other.smallBuffer)
             {
-                memcpy(this->smallBuffer, other.smallBuffer, BUFSIZE);
+                memcpy(this->smallBuffer, other.smallBuffer, std::min<std::size_t>(other.GetLength() + 1, BUFSIZE) * sizeof(CharType));
                 this->buffer = this->smallBuffer;
             }
             else
@@ -134,8 +136,9 @@ public:
     {
         if (this != &other)
         {
-            Reserve(other.capacity);
-            memcpy(this->buffer, other.buffer, other.capacity * sizeof(CharType));
+            std::size_t n = std::min(other.GetLength() + 1, other.capacity);
+            Reserve(n);
+            memcpy(this->buffer, other.buffer, n * sizeof(CharType));
         }
     }
 
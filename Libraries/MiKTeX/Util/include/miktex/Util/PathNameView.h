@@ -0,0 +1,132 @@
+/**
+ * @file miktex/Util/PathNameView.h
+ * @author Christian Schenk
+ * @brief PathNameView class
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Util Library.
+ *
+ * The MiKTeX Util Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <miktex/Util/config.h>
+
+#include <cstddef>
+#include <cstring>
+
+#include <string>
+
+#include "PathName.h"
+#include "PathNameUtil.h"
+
+MIKTEX_UTIL_BEGIN_NAMESPACE;
+
+/// A non-owning reference to a null-terminated path name.
+///
+/// The referenced characters must outlive the view.  Views are cheap to copy
+/// and can be passed by value where a function only inspects a path name.
+class PathNameView
+{
+
+public:
+
+    PathNameView() = default;
+
+    PathNameView(const char* path) :
+        data(path),
+        length(std::strlen(path))
+    {
+    }
+
+    PathNameView(const std::string& path) :
+        data(path.c_str()),
+        length(path.length())
+    {
+    }
+
+    PathNameView(const PathName& path) :
+        data(path.GetData()),
+        length(path.GetLength())
+    {
+    }
+
+    // a view on a temporary would dangle
+    PathNameView(std::string&& path) = delete;
+    PathNameView(PathName&& path) = delete;
+
+    const char* GetData() const
+    {
+        return data;
+    }
+
+    std::size_t GetLength() const
+    {
+        return length;
+    }
+
+    bool Empty() const
+    {
+        return length == 0;
+    }
+
+    std::string ToString() const
+    {
+        return std::string(data, length);
+    }
+
+    PathName ToPathName() const
+    {
+        return PathName(data);
+    }
+
+    /// Gets the last component of the path name.
+    /// @return Returns a view on the file name part.
+    PathNameView GetFileName() const
+    {
+        std::size_t idx = length;
+        while (idx > 0 && !PathNameUtil::IsDirectoryDelimiter(data[idx - 1])
+#if defined(MIKTEX_WINDOWS)
+            && !PathNameUtil::IsDosVolumeDelimiter(data[idx - 1])
+#endif
+            )
+        {
+            --idx;
+        }
+        return PathNameView(data + idx, length - idx);
+    }
+
+    bool IsAbsolute() const
+    {
+        return PathNameUtil::IsAbsolutePath(data);
+    }
+
+    /// Compares two path names.  The rules are the same as for
+    /// PathName::Compare(), but the operands are not copied.
+    /// @param path1 The first path name.
+    /// @param path2 The second path name.
+    /// @return Returns -1, 0 or 1.
+    static MIKTEXUTILCEEAPI(int) Compare(PathNameView path1, PathNameView path2);
+
+    static bool Equals(PathNameView path1, PathNameView path2)
+    {
+        return Compare(path1, path2) == 0;
+    }
+
+private:
+
+    PathNameView(const char* data, std::size_t length) :
+        data(data),
+        length(length)
+    {
+    }
+
+    const char* data = "";
+
+    std::size_t length = 0;
+};
+
+MIKTEX_UTIL_END_NAMESPACE;
@@ -85,6 +85,22 @@ public:
     static MIKTEXUTILCEEAPI(std::wstring) UTF8ToWideChar(const std::string& utf8);
     static MIKTEXUTILCEEAPI(std::string) WideCharToUTF8(const std::wstring& wideChars);
 
+    /// Tests whether a byte sequence is pure ASCII.
+    static MIKTEXUTILCEEAPI(bool) IsAscii(const char* s, std::size_t n);
+
+    /// Copies `n` bytes and maps 'A'..'Z' to 'a'..'z'; other bytes (including
+    /// UTF-8 sequences) are copied unchanged.  `dest` may be equal to `source`.
+    static MIKTEXUTILCEEAPI(void) ToLowerAscii(char* dest, const char* source, std::size_t n);
+
+    /// Gets the index of the first byte which differs after ASCII case folding.
+    /// @return Returns `n`, if the byte sequences are equal.
+    static MIKTEXUTILCEEAPI(std::size_t) MismatchIgnoreCaseAscii(const char* s1, const char* s2, std::size_t n);
+
+    static bool EqualsIgnoreCaseAscii(const std::string& s1, const std::string& s2)
+    {
+        return s1.length() == s2.length() && MismatchIgnoreCaseAscii(s1.c_str(), s2.c_str(), s1.length()) == s1.length();
+    }
+
 #if defined(MIKTEX_WINDOWS)
     static MIKTEXUTILCEEAPI(std::string) AnsiToUTF8(const std::string& ansi);
 #endif
@@ -2535,7 +2535,12 @@ BEGIN
 
     if (num_cites > 1)
     BEGIN
+      make_sort_keys ();
       quick_sort (0, num_cites - 1);
+      free (sort_key_buf);
+      free (sort_key_start);
+      sort_key_buf = NULL;
+      sort_key_start = NULL;
     END
 
 #ifdef TRACE
@@ -44,6 +44,7 @@
 **          less_than
 **          lower_case
 **          macro_warn_print
+**          make_sort_keys
 **          make_string
 **          mark_error
 **          mark_fatal
@@ -3181,111 +3182,44 @@ END
  ***************************************************************************/
 Boolean_T         less_than (CiteNumber_T arg1, CiteNumber_T arg2)
 BEGIN
-  StrEntLoc_T		ptr1,
-			ptr2;
+  Integer_T		len1,
+			len2;
+  int			cmp;
   Boolean_T		less_than;
-#ifdef UTF_8
-/*
-We use ICU Collator ucol_strcollUTF8() to compare the Unicode in UTF-8.
-There is a command line option "-o", "--location" to set the rule of collation.
-*/
-  Integer_T lenk1, lenk2;
-  UBool u_cmp;
-  UErrorCode err1 = U_ZERO_ERROR;
-#if defined(MIKTEX)
-  const
-#endif
-  char *eos1, *eos2;
-  const char *ustr1, *ustr2;
-#else
-  Integer_T		char_ptr;
-  ASCIICode_T		char1,
-			char2;
-#endif
 
 #ifdef TRACE
   if (Flag_trace)
     TRACE_PR_LN3 ("Comparing entry %ld and %ld ...", arg1, arg2);
 #endif                      			/* TRACE */
-  ptr1 = (arg1 * num_ent_strs) + sort_key_num;
-  ptr2 = (arg2 * num_ent_strs) + sort_key_num;
-#ifdef UTF_8
-  ustr1 = (const char *)&ENTRY_STRS(ptr1, 0);
-  ustr2 = (const char *)&ENTRY_STRS(ptr2, 0);
-  eos1 = strchr(ustr1, END_OF_STRING);
-  eos2 = strchr(ustr2, END_OF_STRING);
-  lenk1 = eos1 ? eos1-ustr1 : strlen(ustr1);
-  lenk2 = eos2 ? eos2-ustr2 : strlen(ustr2);
-
-  u_cmp = ucol_strcollUTF8(u_coll, ustr1, lenk1, ustr2, lenk2, &err1);
-  if (!U_SUCCESS(err1))
+/*
+The sort.key$s have been turned into binary sort keys by |make_sort_keys|,
+so that the collation is not evaluated again for each comparison.
+*/
+  len1 = sort_key_start[arg1 + 1] - sort_key_start[arg1];
+  len2 = sort_key_start[arg2 + 1] - sort_key_start[arg2];
+  cmp = memcmp (&sort_key_buf[sort_key_start[arg1]],
+		&sort_key_buf[sort_key_start[arg2]],
+		(len1 < len2) ? len1 : len2);
+  if (cmp == 0)
   BEGIN
-	printf("Error in ucol_strcollUTF8.\n");
-#ifdef TRACE
-	if (Flag_trace)
-		TRACE_PR_LN ("Error in ucol_strcollUTF8");
-#endif                      			/* TRACE */
+    cmp = (len1 < len2) ? -1 : (len1 > len2);
   END
-
-  if (u_cmp==UCOL_EQUAL)
-      BEGIN
-        if (arg1 < arg2)
-        BEGIN
-	  COMPARE_RETURN (TRUE);
-	END
-        else if (arg1 > arg2)
-        BEGIN
-	  COMPARE_RETURN (FALSE);
-        END
-        else
-        BEGIN
-          CONFUSION ("Duplicate sort key");
-        END
-      END
-  less_than = u_cmp==UCOL_LESS;
-#else
-  char_ptr = 0;
-  LOOP
+  if (cmp == 0)
   BEGIN
-    char1 = ENTRY_STRS(ptr1, char_ptr);
-    char2 = ENTRY_STRS(ptr2, char_ptr);
-    if (char1 == END_OF_STRING)
+    if (arg1 < arg2)
     BEGIN
-      if (char2 == END_OF_STRING)
-      BEGIN
-        if (arg1 < arg2)
-        BEGIN
-	  COMPARE_RETURN (TRUE);
-	END
-        else if (arg1 > arg2)
-        BEGIN
-	  COMPARE_RETURN (FALSE);
-        END
-        else
-        BEGIN
-          CONFUSION ("Duplicate sort key");
-        END
-      END
-      else
-      BEGIN
-	COMPARE_RETURN (TRUE);
-      END
+      COMPARE_RETURN (TRUE);
     END
-    else if (char2 == END_OF_STRING)
+    else if (arg1 > arg2)
     BEGIN
       COMPARE_RETURN (FALSE);
     END
-    else if char_less_than(char1, char2)
-    BEGIN
-      COMPARE_RETURN (TRUE);
-    END
-    else if char_greater_than(char1, char2)
+    else
     BEGIN
-      COMPARE_RETURN (FALSE);
+      CONFUSION ("Duplicate sort key");
     END
-    INCR (char_ptr);
   END
-#endif
+  less_than = cmp < 0;
 Exit_Label:
 #ifdef TRACE
   if (Flag_trace)
@@ -3544,6 +3478,82 @@ END
 
 
 
+/*
+This function computes a binary sort key for the sort.key$ of each entry,
+before the entries are sorted.  Comparing two keys byte by byte gives the
+same result as comparing the sort.key$s: with ICU we use the Collator's
+ucol_getSortKey(), otherwise each character is replaced by its sorting
+weight (two bytes, high byte first).
+*/
+void          make_sort_keys (void)
+BEGIN
+  CiteNumber_T		cite;
+  StrEntLoc_T		ptr;
+  Integer_T		used,
+			cap;
+#ifdef UTF_8
+  const char		*ustr;
+  const char		*eos;
+  UChar			*buf16;
+  int32_t		ulen,
+			klen;
+#else
+  Integer_T		char_ptr;
+  ASCIICode_T		char1;
+#endif
+
+  sort_key_start = (Integer_T *) mymalloc ((unsigned long) sizeof (Integer_T)
+      * (unsigned long) (num_cites + 1), "sort_key_start");
+  cap = 2 * (Ent_Str_Size + 1) * num_cites;
+  sort_key_buf = (unsigned char *) mymalloc ((unsigned long) cap,
+      "sort_key_buf");
+  used = 0;
+#ifdef UTF_8
+  buf16 = (UChar *) mymalloc ((unsigned long) sizeof (UChar)
+      * (unsigned long) (Ent_Str_Size + 1), "buf16");
+#endif
+  for (cite = 0; cite < num_cites; cite++)
+  BEGIN
+    sort_key_start[cite] = used;
+    ptr = (cite * num_ent_strs) + sort_key_num;
+#ifdef UTF_8
+    ustr = (const char *)&ENTRY_STRS(ptr, 0);
+    eos = strchr(ustr, END_OF_STRING);
+    ulen = icu_toUChars (&ENTRY_STRS(ptr, 0), 0,
+			 eos ? eos - ustr : strlen(ustr),
+			 buf16, Ent_Str_Size + 1);
+    LOOP
+    BEGIN
+      klen = ucol_getSortKey (u_coll, buf16, ulen, &sort_key_buf[used],
+			      cap - used);
+      if (klen <= cap - used)
+      BEGIN
+	break;
+      END
+      cap = 2 * cap + klen;
+      sort_key_buf = (unsigned char *) myrealloc (sort_key_buf,
+	  (unsigned long) cap, "sort_key_buf");
+    END
+    used += klen;
+#else
+    char_ptr = 0;
+    while ((char1 = ENTRY_STRS(ptr, char_ptr)) != END_OF_STRING)
+    BEGIN
+      sort_key_buf[used++] = (unsigned char) (char_weight (char1) >> 8);
+      sort_key_buf[used++] = (unsigned char) char_weight (char1);
+      INCR (char_ptr);
+    END
+#endif
+  END
+  sort_key_start[num_cites] = used;
+#ifdef UTF_8
+  free (buf16);
+#endif
+END
+
+
+
+
 /***************************************************************************
  * WEB section number:	 54
  * ~~~~~~~~~~~~~~~~~~~
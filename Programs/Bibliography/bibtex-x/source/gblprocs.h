@@ -251,6 +251,7 @@ void Lower_case (BufType_T buf, BufPointer_T bf_ptr, BufPointer_T len)
 #endif
 
 void                    macro_warn_print (void);
+void                    make_sort_keys (void);
 StrNumber_T             make_string (void);
 void                    mark_error (void);
 void                    mark_fatal (void);
@@ -412,6 +413,7 @@ void                    x_is_cjk_string (void);
 **  ToLower
 **  char_less_than
 **  char_greater_than
+**  char_weight
 */
 #ifdef SUPPORT_8BIT
 
@@ -422,6 +424,7 @@ void                    x_is_cjk_string (void);
 
 #define  char_less_than(char1, char2)   (c8order[char1] < c8order[char2])
 #define  char_greater_than(char1, char2)   (c8order[char1] > c8order[char2])
+#define  char_weight(char1)   (c8order[char1])
 
 #else                           /* NOT SUPPORT_8BIT */
 
@@ -432,6 +435,7 @@ void                    x_is_cjk_string (void);
 
 #define  char_less_than(char1, char2)		(char1 < char2)
 #define  char_greater_than(char1, char2)         (char1 > char2)
+#define  char_weight(char1)			(char1)
 
 #endif                          /* SUPPORT_8BIT */
 
@@ -298,7 +298,9 @@ __EXTERN__ StrNumber_T                  s_t;
 __EXTERN__ StrNumber_T                  s_u;
 __EXTERN__ Integer8_T                   scan_result;
 __EXTERN__ CiteNumber_T                 sort_cite_ptr;
+__EXTERN__ unsigned char               *sort_key_buf;
 __EXTERN__ StrEntLoc_T                  sort_key_num;
+__EXTERN__ Integer_T                   *sort_key_start;
 __EXTERN__ Integer_T                    sp_brace_level;
 __EXTERN__ PoolPointer_T                sp_end;
 __EXTERN__ PoolPointer_T                sp_length;
@@ -0,0 +1,564 @@
+/* bibindex.cpp: cached index of a BibTeX database
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Process>
+
+#include "bibindex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace {
+  constexpr const char* BIB_INDEX_SIGNATURE = "miktex-bib-index-1";
+
+  bool IsWhite(unsigned char ch)
+  {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+  }
+
+  bool IsIdChar(unsigned char ch)
+  {
+    return ch != 0 && !IsWhite(ch) && strchr("\"#%'(),={}", ch) == nullptr;
+  }
+
+  string ToLower(string s)
+  {
+    // BibTeX folds ASCII letters only
+    for (char& ch : s)
+    {
+      if (ch >= 'A' && ch <= 'Z')
+      {
+        ch = ch - 'A' + 'a';
+      }
+    }
+    return s;
+  }
+
+  /* A BibScanner follows BibTeX's syntax closely enough to find the end
+     of a command or entry.  Whenever it is in doubt, the caller keeps
+     the text: reading an entry which is not cited costs BibTeX some
+     time, but leaving out a needed one would change the result. */
+
+  class BibScanner
+  {
+  public:
+    BibScanner(const vector<unsigned char>& text) :
+      text(text)
+    {
+    }
+
+  public:
+    bool AtEnd() const
+    {
+      return pos >= text.size();
+    }
+
+  public:
+    unsigned char Peek() const
+    {
+      return text[pos];
+    }
+
+  public:
+    void SkipWhite()
+    {
+      while (!AtEnd() && IsWhite(text[pos]))
+      {
+        ++pos;
+      }
+    }
+
+  public:
+    string ScanId()
+    {
+      size_t start = pos;
+      while (!AtEnd() && IsIdChar(text[pos]))
+      {
+        ++pos;
+      }
+      return Substring(start, pos);
+    }
+
+  public:
+    bool SkipBraced()
+    {
+      int depth = 0;
+      do
+      {
+        if (AtEnd())
+        {
+          return false;
+        }
+        unsigned char ch = text[pos++];
+        if (ch == '{')
+        {
+          ++depth;
+        }
+        else if (ch == '}')
+        {
+          --depth;
+        }
+      } while (depth > 0);
+      return true;
+    }
+
+  public:
+    bool SkipParenthesized()
+    {
+      ++pos;
+      int depth = 0;
+      bool quoted = false;
+      while (!AtEnd())
+      {
+        unsigned char ch = text[pos++];
+        if (ch == '{')
+        {
+          ++depth;
+        }
+        else if (ch == '}')
+        {
+          --depth;
+        }
+        else if (ch == '"' && depth == 0)
+        {
+          quoted = !quoted;
+        }
+        else if (ch == ')' && depth == 0 && !quoted)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+  public:
+    bool ParseEntry(unsigned char close, string& key, string& crossref, bool& crossrefIsMacro)
+    {
+      ++pos;
+      SkipWhite();
+      size_t start = pos;
+      while (!AtEnd() && text[pos] != ',' && text[pos] != close && !IsWhite(text[pos]))
+      {
+        ++pos;
+      }
+      key = ToLower(Substring(start, pos));
+      while (true)
+      {
+        SkipWhite();
+        if (AtEnd())
+        {
+          return false;
+        }
+        if (text[pos] == close)
+        {
+          ++pos;
+          return true;
+        }
+        if (text[pos] != ',')
+        {
+          return false;
+        }
+        ++pos;
+        SkipWhite();
+        if (AtEnd())
+        {
+          return false;
+        }
+        if (text[pos] == close)
+        {
+          ++pos;
+          return true;
+        }
+        string fieldName = ToLower(ScanId());
+        if (fieldName.empty())
+        {
+          return false;
+        }
+        SkipWhite();
+        if (AtEnd() || text[pos] != '=')
+        {
+          return false;
+        }
+        ++pos;
+        string value;
+        bool isMacro;
+        int tokens;
+        if (!ParseValue(value, isMacro, tokens))
+        {
+          return false;
+        }
+        if (fieldName == "crossref")
+        {
+          crossref = ToLower(value);
+          crossrefIsMacro = isMacro || tokens != 1;
+        }
+      }
+    }
+
+  private:
+    bool ParseValue(string& value, bool& isMacro, int& tokens)
+    {
+      isMacro = false;
+      tokens = 0;
+      while (true)
+      {
+        SkipWhite();
+        if (AtEnd())
+        {
+          return false;
+        }
+        size_t start = pos;
+        unsigned char ch = text[pos];
+        if (ch == '{')
+        {
+          if (!SkipBraced())
+          {
+            return false;
+          }
+          value = Substring(start + 1, pos - 1);
+        }
+        else if (ch == '"')
+        {
+          ++pos;
+          int depth = 0;
+          while (!AtEnd() && !(text[pos] == '"' && depth == 0))
+          {
+            if (text[pos] == '{')
+            {
+              ++depth;
+            }
+            else if (text[pos] == '}')
+            {
+              --depth;
+            }
+            ++pos;
+          }
+          if (AtEnd())
+          {
+            return false;
+          }
+          ++pos;
+          value = Substring(start + 1, pos - 1);
+        }
+        else if (ch >= '0' && ch <= '9')
+        {
+          while (!AtEnd() && text[pos] >= '0' && text[pos] <= '9')
+          {
+            ++pos;
+          }
+          value = Substring(start, pos);
+        }
+        else
+        {
+          if (ScanId().empty())
+          {
+            return false;
+          }
+          isMacro = true;
+        }
+        ++tokens;
+        SkipWhite();
+        if (AtEnd() || text[pos] != '#')
+        {
+          return true;
+        }
+        ++pos;
+      }
+    }
+
+  private:
+    string Substring(size_t start, size_t end) const
+    {
+      return string(reinterpret_cast<const char*>(text.data()) + start, end - start);
+    }
+
+  public:
+    size_t pos = 0;
+
+  private:
+    const vector<unsigned char>& text;
+  };
+}
+
+void BibIndex::Load(const PathName& bibFile, const PathName& indexFile)
+{
+  this->bibFile = bibFile;
+  bibSize = File::GetSize(bibFile);
+  bibLastWriteTime = File::GetLastWriteTime(bibFile);
+  if (Read(indexFile, true))
+  {
+    return;
+  }
+  // the time stamp has changed, but the contents may be the same
+  bibDigest = MD5::FromFile(bibFile);
+  if (Read(indexFile, false))
+  {
+    Write(indexFile);
+    return;
+  }
+  Build();
+  Write(indexFile);
+}
+
+void BibIndex::Build()
+{
+  vector<unsigned char> text = File::ReadAllBytes(bibFile);
+  MD5Builder md5Builder;
+  md5Builder.Update(text.data(), text.size());
+  bibDigest = md5Builder.Final();
+  chunks.clear();
+  entryCount = 0;
+  if (text.empty())
+  {
+    return;
+  }
+  BibScanner scanner(text);
+  size_t line = 1;
+  size_t lineCountedTo = 0;
+  const unsigned char* start = text.data();
+  while (true)
+  {
+    const unsigned char* at = static_cast<const unsigned char*>(memchr(start + scanner.pos, '@', text.size() - scanner.pos));
+    if (at == nullptr)
+    {
+      break;
+    }
+    Chunk chunk;
+    chunk.offset = at - start;
+    for (; lineCountedTo < chunk.offset; ++lineCountedTo)
+    {
+      if (text[lineCountedTo] == '\n')
+      {
+        ++line;
+      }
+    }
+    chunk.line = line;
+    scanner.pos = chunk.offset + 1;
+    scanner.SkipWhite();
+    string command = ToLower(scanner.ScanId());
+    if (command == "comment")
+    {
+      // BibTeX ignores the text after @comment up to the next @
+      continue;
+    }
+    bool ok = false;
+    if (!command.empty())
+    {
+      scanner.SkipWhite();
+    }
+    if (!command.empty() && !scanner.AtEnd() && (scanner.Peek() == '{' || scanner.Peek() == '('))
+    {
+      unsigned char open = scanner.Peek();
+      if (command == "string" || command == "preamble")
+      {
+        ok = open == '{' ? scanner.SkipBraced() : scanner.SkipParenthesized();
+      }
+      else
+      {
+        bool crossrefIsMacro = false;
+        ok = scanner.ParseEntry(open == '{' ? '}' : ')', chunk.key, chunk.crossref, crossrefIsMacro);
+        chunk.isEntry = ok && !crossrefIsMacro;
+      }
+    }
+    if (!ok)
+    {
+      // BibTeX will complain; keep everything up to the next @
+      const unsigned char* next = scanner.AtEnd() ? nullptr : static_cast<const unsigned char*>(memchr(start + scanner.pos, '@', text.size() - scanner.pos));
+      scanner.pos = next == nullptr ? text.size() : next - start;
+      chunk.isEntry = false;
+    }
+    chunk.length = scanner.pos - chunk.offset;
+    if (chunk.isEntry)
+    {
+      ++entryCount;
+    }
+    chunks.push_back(chunk);
+  }
+}
+
+bool BibIndex::Read(const PathName& indexFile, bool trustTimeStamp)
+{
+  if (!File::Exists(indexFile))
+  {
+    return false;
+  }
+  try
+  {
+    ifstream stream = File::CreateInputStream(indexFile);
+    string line;
+    if (!getline(stream, line) || line != BIB_INDEX_SIGNATURE)
+    {
+      return false;
+    }
+    size_t size;
+    time_t lastWriteTime;
+    string digest;
+    if (!getline(stream, line))
+    {
+      return false;
+    }
+    istringstream header(line);
+    if (!(header >> size >> lastWriteTime >> digest))
+    {
+      return false;
+    }
+    if (size != bibSize)
+    {
+      return false;
+    }
+    if (trustTimeStamp ? lastWriteTime != bibLastWriteTime : MD5::Parse(digest) != bibDigest)
+    {
+      return false;
+    }
+    vector<Chunk> newChunks;
+    size_t newEntryCount = 0;
+    // <kind> TAB <offset> TAB <length> TAB <line> TAB <key> TAB <crossref>
+    while (getline(stream, line))
+    {
+      istringstream fields(line);
+      string kind;
+      Chunk chunk;
+      if (!(fields >> kind >> chunk.offset >> chunk.length >> chunk.line) || fields.get() != '\t' || !getline(fields, chunk.key, '\t'))
+      {
+        return false;
+      }
+      getline(fields, chunk.crossref);
+      chunk.isEntry = kind == "e";
+      if (chunk.offset + chunk.length > bibSize)
+      {
+        return false;
+      }
+      if (chunk.isEntry)
+      {
+        ++newEntryCount;
+      }
+      newChunks.push_back(chunk);
+    }
+    chunks = std::move(newChunks);
+    entryCount = newEntryCount;
+    bibDigest = MD5::Parse(digest);
+    return true;
+  }
+  catch (const exception&)
+  {
+    return false;
+  }
+}
+
+void BibIndex::Write(const PathName& indexFile) const
+{
+  try
+  {
+    Directory::Create(indexFile.GetDirectoryName());
+    PathName newPath = indexFile;
+    newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+    ofstream stream = File::CreateOutputStream(newPath);
+    stream << BIB_INDEX_SIGNATURE << "\n";
+    stream << bibSize << " " << bibLastWriteTime << " " << bibDigest.ToString() << "\n";
+    for (const Chunk& chunk : chunks)
+    {
+      stream << (chunk.isEntry ? "e" : "c") << "\t" << chunk.offset << "\t" << chunk.length << "\t" << chunk.line << "\t" << chunk.key << "\t" << chunk.crossref << "\n";
+    }
+    stream.close();
+    File::Move(newPath, indexFile, { FileMoveOption::ReplaceExisting });
+  }
+  catch (const exception&)
+  {
+    // the index is an optimization: a lost index costs only time
+  }
+}
+
+size_t BibIndex::WriteSubset(const set<string>& citeKeys, const PathName& subsetFile) const
+{
+  multimap<string, size_t> entries;
+  for (size_t idx = 0; idx < chunks.size(); ++idx)
+  {
+    if (chunks[idx].isEntry)
+    {
+      entries.insert(make_pair(chunks[idx].key, idx));
+    }
+  }
+  vector<bool> keep(chunks.size(), false);
+  set<string> wanted(citeKeys);
+  vector<string> todo(citeKeys.begin(), citeKeys.end());
+  while (!todo.empty())
+  {
+    string key = todo.back();
+    todo.pop_back();
+    auto range = entries.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      keep[it->second] = true;
+      const string& crossref = chunks[it->second].crossref;
+      if (!crossref.empty() && wanted.insert(crossref).second)
+      {
+        todo.push_back(crossref);
+      }
+    }
+  }
+  size_t count = 0;
+  FileStream bibStream(File::Open(bibFile, FileMode::Open, FileAccess::Read, false));
+  Directory::Create(subsetFile.GetDirectoryName());
+  FileStream subsetStream(File::Open(subsetFile, FileMode::Create, FileAccess::Write, false));
+  vector<char> buf;
+  size_t line = 1;
+  for (size_t idx = 0; idx < chunks.size(); ++idx)
+  {
+    const Chunk& chunk = chunks[idx];
+    if (chunk.isEntry && !keep[idx])
+    {
+      continue;
+    }
+    for (; line < chunk.line; ++line)
+    {
+      subsetStream.Write("\n", 1);
+    }
+    buf.resize(chunk.length);
+    bibStream.Seek(static_cast<long>(chunk.offset), SeekOrigin::Begin);
+    if (bibStream.Read(buf.data(), buf.size()) != buf.size())
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    subsetStream.Write(buf.data(), buf.size());
+    line += std::count(buf.begin(), buf.end(), '\n');
+    if (chunk.isEntry)
+    {
+      ++count;
+    }
+  }
+  subsetStream.Write("\n", 1);
+  subsetStream.Close();
+  bibStream.Close();
+  return count;
+}
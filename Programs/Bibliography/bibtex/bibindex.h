@@ -0,0 +1,95 @@
+/* bibindex.h: cached index of a BibTeX database           -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/MD5>
+#include <miktex/Util/PathName>
+
+/* A BibIndex knows where the commands and entries of a .bib file
+   start and end.  It is kept in an index file and is rebuilt when the
+   .bib file has changed.
+
+   WriteSubset() writes a .bib file which contains all the @string and
+   @preamble commands, but only the entries needed for the given cite
+   keys (including cross-referenced entries).  The commands and entries
+   stay on their original lines, so that BibTeX's messages still refer
+   to the right line numbers. */
+
+class BibIndex
+{
+public:
+  void Load(const MiKTeX::Util::PathName& bibFile, const MiKTeX::Util::PathName& indexFile);
+
+public:
+  std::size_t WriteSubset(const std::set<std::string>& citeKeys, const MiKTeX::Util::PathName& subsetFile) const;
+
+public:
+  std::size_t GetEntryCount() const
+  {
+    return entryCount;
+  }
+
+private:
+  struct Chunk
+  {
+    // false: a command (or something unparsable) which is always kept
+    bool isEntry = false;
+    std::size_t offset = 0;
+    std::size_t length = 0;
+    std::size_t line = 0;
+    // lower-cased
+    std::string key;
+    std::string crossref;
+  };
+
+private:
+  void Build();
+
+private:
+  bool Read(const MiKTeX::Util::PathName& indexFile, bool trustTimeStamp);
+
+private:
+  void Write(const MiKTeX::Util::PathName& indexFile) const;
+
+private:
+  MiKTeX::Util::PathName bibFile;
+
+private:
+  std::size_t bibSize = 0;
+
+private:
+  std::time_t bibLastWriteTime = 0;
+
+private:
+  MiKTeX::Core::MD5 bibDigest;
+
+private:
+  std::vector<Chunk> chunks;
+
+private:
+  std::size_t entryCount = 0;
+};
@@ -23,8 +23,16 @@
 
 #include "miktex-bibtex-version.h"
 
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryDirectory>
 #include <miktex/TeXAndFriends/CharacterConverterImpl>
 #include <miktex/TeXAndFriends/InitFinalizeImpl>
 #include <miktex/TeXAndFriends/InputOutputImpl>
@@ -37,6 +45,8 @@
 
 #include "bibtex.h"
 
+#include "bibindex.h"
+
 namespace bibtex {
 #include <miktex/bibtex.defaults.h>
 }
@@ -96,6 +106,15 @@ private:
 private:
   MiKTeX::TeXAndFriends::InputOutputImpl<BIBTEXPROGCLASS> inputOutput{ BIBTEXPROG };
 
+private:
+  bool useBibIndex = false;
+
+private:
+  std::vector<MiKTeX::Util::PathName> bibFiles;
+
+private:
+  std::unique_ptr<MiKTeX::Core::TemporaryDirectory> bibSubsetDirectory;
+
 public:
   void Init(std::vector<char*>& args) override
   {
@@ -108,6 +127,7 @@ public:
     BIBTEXPROG.globstrsize = session->GetConfigValue(MIKTEX_CONFIG_SECTION_BIBTEX, "glob_str_size", MiKTeX::Configuration::ConfigValue(bibtex::bibtex::glob_str_size())).GetInt();
     BIBTEXPROG.maxstrings = session->GetConfigValue(MIKTEX_CONFIG_SECTION_BIBTEX, "max_strings", MiKTeX::Configuration::ConfigValue(bibtex::bibtex::max_strings())).GetInt();
     BIBTEXPROG.mincrossrefs = session->GetConfigValue(MIKTEX_CONFIG_SECTION_BIBTEX, "min_crossrefs", MiKTeX::Configuration::ConfigValue(bibtex::bibtex::min_crossrefs())).GetInt();
+    useBibIndex = session->GetConfigValue(MIKTEX_CONFIG_SECTION_BIBTEX, "bib_index", MiKTeX::Configuration::ConfigValue(bibtex::bibtex::bib_index())).GetInt() != 0;
     BIBTEXPROG.hashsize = BIBTEXPROG.maxstrings;
     const int HASH_SIZE_MIN = 5000;
     if (BIBTEXPROG.hashsize < HASH_SIZE_MIN)
@@ -115,8 +135,10 @@ public:
       BIBTEXPROG.hashsize = HASH_SIZE_MIN;
     }
     BIBTEXPROG.hashmax = BIBTEXPROG.hashsize + BIBTEXPROG.hashbase - 1;
-    BIBTEXPROG.endofdef = BIBTEXPROG.hashmax + 1;
-    BIBTEXPROG.undefined = BIBTEXPROG.hashmax + 1;
+    // the hash table grows: the special markers lie beyond any hash location
+    const int HASH_LOC_MAX = 9999999;
+    BIBTEXPROG.endofdef = HASH_LOC_MAX;
+    BIBTEXPROG.undefined = HASH_LOC_MAX;
     BIBTEXPROG.bufsize = BIBTEXPROG.bufsizedef;
     BIBTEXPROG.litstksize = BIBTEXPROG.litstksizedef;
     BIBTEXPROG.maxbibfiles = BIBTEXPROG.maxbibfilesdef;
@@ -158,6 +180,7 @@ public:
     PascalAllocate(BIBTEXPROG.typelist, BIBTEXPROG.maxcites);
     PascalAllocate(BIBTEXPROG.wizfunctions, BIBTEXPROG.wizfnspace);
     BIBTEXPROG.computehashprime();
+    PascalAllocate(BIBTEXPROG.hashhead, BIBTEXPROG.hashprime);
   }
   
 public:
@@ -177,6 +200,7 @@ public:
     Free(BIBTEXPROG.glbstrend);
     Free(BIBTEXPROG.glbstrptr);
     Free(BIBTEXPROG.globalstrs);
+    Free(BIBTEXPROG.hashhead);
     Free(BIBTEXPROG.hashilk);
     Free(BIBTEXPROG.hashnext);
     Free(BIBTEXPROG.hashtext);
@@ -192,11 +216,14 @@ public:
     Free(BIBTEXPROG.svbuffer);
     Free(BIBTEXPROG.typelist);
     Free(BIBTEXPROG.wizfunctions);
+    bibFiles.clear();
+    bibSubsetDirectory = nullptr;
     WebAppInputLine::Finalize();
   }
 
 #define OPT_MIN_CROSSREFS 1000
 #define OPT_QUIET 1001
+#define OPT_BIB_INDEX 1002
 
 public:
   void AddOptions() override
@@ -206,6 +233,7 @@ public:
     AddOption(MIKTEXTEXT("quiet\0Suppress all output (except errors)."), OPT_QUIET, POPT_ARG_NONE);
     AddOption("silent", "quiet");
     AddOption("terse", "quiet");
+    AddOption(MIKTEXTEXT("bib-index\0Read only the cited entries of the database files, using a cached index."), OPT_BIB_INDEX, POPT_ARG_NONE);
   }
   
 public:
@@ -232,6 +260,9 @@ public:
       case OPT_QUIET:
         SetQuietFlag(true);
         break;
+      case OPT_BIB_INDEX:
+        useBibIndex = true;
+        break;
       default:
         done = WebAppInputLine::ProcessOption(opt, optArg);
         break;
@@ -288,6 +319,66 @@ public:
 #endif
     return true;
   }
+
+public:
+  void RememberBibFile(int bibPtr)
+  {
+    if (bibFiles.size() <= static_cast<size_t>(bibPtr))
+    {
+      bibFiles.resize(bibPtr + 1);
+    }
+    bibFiles[bibPtr] = GetFoundFileFq();
+  }
+
+public:
+  template<class T> void UseBibIndex(T& f, int bibPtr)
+  {
+    if (!useBibIndex || BIBTEXPROG.allentries || static_cast<size_t>(bibPtr) >= bibFiles.size() || bibFiles[bibPtr].Empty())
+    {
+      return;
+    }
+    // the index is an optimization: if anything goes wrong, BibTeX reads the whole file
+    try
+    {
+      std::set<std::string> citeKeys;
+      for (int cite = 0; cite < BIBTEXPROG.numcites; ++cite)
+      {
+        int s = BIBTEXPROG.citelist[cite];
+        std::string key(reinterpret_cast<const char*>(&BIBTEXPROG.strpool[BIBTEXPROG.strstart[s]]), BIBTEXPROG.strstart[s + 1] - BIBTEXPROG.strstart[s]);
+        for (char& ch : key)
+        {
+          if (ch >= 'A' && ch <= 'Z')
+          {
+            ch = ch - 'A' + 'a';
+          }
+        }
+        citeKeys.insert(key);
+      }
+      const MiKTeX::Util::PathName& bibFile = bibFiles[bibPtr];
+      MiKTeX::Util::PathName indexFile = session->GetSpecialPath(MiKTeX::Core::SpecialPath::DataRoot) / MIKTEX_PATH_BIBTEX_INDEX_DIR / (MiKTeX::Core::MD5::FromChars(bibFile.ToString()).ToString() + ".idx");
+      BibIndex bibIndex;
+      bibIndex.Load(bibFile, indexFile);
+      if (bibSubsetDirectory == nullptr)
+      {
+        bibSubsetDirectory = MiKTeX::Core::TemporaryDirectory::Create();
+      }
+      MiKTeX::Util::PathName subsetFile = bibSubsetDirectory->GetPathName() / std::to_string(bibPtr) / bibFile.GetFileName();
+      size_t n = bibIndex.WriteSubset(citeKeys, subsetFile);
+      FILE* file = session->OpenFile(subsetFile, MiKTeX::Core::FileMode::Open, MiKTeX::Core::FileAccess::Read, true);
+      CloseFile(f);
+      f.Attach(file, true);
+#ifdef PASCAL_TEXT_IO
+      get(f);
+#endif
+      if (BIBTEXPROG.logfile != nullptr)
+      {
+        fprintf(BIBTEXPROG.logfile, "Database subset: %d of %d entries.\n", static_cast<int>(n), static_cast<int>(bibIndex.GetEntryCount()));
+      }
+    }
+    catch (const std::exception&)
+    {
+    }
+  }
 };
 
 extern BIBTEXAPPCLASS BIBTEXAPP;
@@ -317,6 +408,16 @@ template<class T> inline bool miktexopenbstfile(T& f)
   return BIBTEXAPP.OpenBstFile(f);
 }
 
+inline void miktexbibtexrememberbibfile(int bibPtr)
+{
+  BIBTEXAPP.RememberBibFile(bibPtr);
+}
+
+template<class T> inline void miktexbibtexusebibindex(T& f, int bibPtr)
+{
+  BIBTEXAPP.UseBibIndex(f, bibPtr);
+}
+
 inline bool miktexhasextension(const char* fileName, const char* extension)
 {
   return MiKTeX::Util::PathName(fileName).HasExtension(extension);
@@ -189,6 +189,8 @@ static gabc_style_bits styles;
 static bool generate_point_and_click;
 static bool clear_syllable_text;
 static bool has_protrusion;
+unsigned char nabc_state = 0;
+size_t nabc_lines = 0;
 
 /* punctum_inclinatum_orientation maintains the running punctum inclinatum
  * orientation in order to decide if the glyph needs to be cut when a punctum
@@ -257,6 +259,8 @@ static void initialize_variables(bool point_and_click)
     generate_point_and_click = point_and_click;
     clear_syllable_text = false;
     has_protrusion = false;
+    nabc_state = 0;
+    nabc_lines = 0;
 }
 
 /*
@@ -684,9 +688,6 @@ gregorio_score *gabc_read_score(FILE *f_in, bool point_and_click)
     return score;
 }
 
-unsigned char nabc_state = 0;
-size_t nabc_lines = 0;
-
 static void gabc_y_add_notes(char *notes, YYLTYPE loc) {
     if (nabc_state == 0) {
         if (!elements[voice]) {
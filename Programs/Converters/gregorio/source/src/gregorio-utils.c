@@ -42,6 +42,7 @@ static const char *copyright =
 #include "messages.h"
 #include "characters.h"
 #include "support.h"
+#include "sha1.h"
 #include "gabc/gabc.h"
 #include "vowel/vowel.h"
 
@@ -184,15 +185,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.\n\
 static void print_usage(char *name)
 {
     printf(_("Usage: %s [OPTION]... [-s | INPUT_FILE]\n\
+  or:  %s -b [OPTION]... INPUT_FILE...\n\
 \nEngrave Gregorian chant scores, convert a gabc file to GregorioTeX.\n\n\
 Options:\n\
   -o, --output-file FILE    write output to FILE,\n\
                             default is basename(INPUT_FILE).FORMAT\n\
   -S, --stdout              write output to stdout\n\
   -s, --stdin               read input from stdin\n\
+  -b, --batch               convert each INPUT_FILE to\n\
+                            basename(INPUT_FILE).FORMAT\n\
+  -u, --skip-unchanged      do not regenerate a gtex file whose score\n\
+                            has not changed\n\
   -l, --messages-file FILE  output messages to FILE (default: stderr)\n\
   -F, --output-format FORMAT\n\
-                            specify output format (default: gtex)\n"), name);
+                            specify output format (default: gtex)\n"), name, name);
 printf(_("  -f, --input-format FORMAT\n\
                             specify input format (default: gabc)\n\
   -p, --point-and-click     generate Lilypond point and click information\n\
@@ -311,13 +317,233 @@ static char *encode_point_and_click_filename(char *input_file_name)
     return result;
 }
 
+/* function that returns the default output file name of an input file */
+static char *get_default_output_filename(char *input_file_name,
+        gregorio_file_format output_format)
+{
+    char *output_basename;
+    char *output_file_name = NULL;
+
+    output_basename = get_base_filename(input_file_name);
+    switch (output_format) {
+    case GABC:
+        output_file_name = get_output_filename(output_basename, "gabc");
+        break;
+    case GTEX:
+        output_file_name = get_output_filename(output_basename, "gtex");
+        break;
+    case DUMP:
+        output_file_name = get_output_filename(output_basename, "dump");
+        break;
+    default:
+        /* not reachable unless there's a programming error */
+        /* LCOV_EXCL_START */
+        fprintf(stderr, "error: unsupported format");
+        gregorio_exit(1);
+        /* LCOV_EXCL_STOP */
+    }
+    free(output_basename);
+    return output_file_name;
+}
+
+/*
+ * Checks whether the gtex file has been generated from the same score: it
+ * must be complete and carry the digest of the input file, which is
+ * computed in the same way as in gabc_read_score, and the same
+ * point-and-click file name.
+ */
+static bool is_up_to_date(const char *input_file_name,
+        const char *output_file_name, const char *point_and_click_filename)
+{
+    static const char *const hex = "0123456789abcdef";
+    static const char begin_score[] = "\\GreBeginScore{";
+    static const char end_score[] = "\\GreEndScore ";
+    struct sha1_ctx digester;
+    unsigned char digest[SHA1_DIGEST_SIZE];
+    char expected[2 * SHA1_DIGEST_SIZE + 1];
+    char line[8192];
+    const char *p;
+    size_t n;
+    int i;
+    bool same_score = false;
+    bool complete = false;
+    FILE *file;
+
+    file = fopen(input_file_name, "r");
+    if (!file) {
+        return false;
+    }
+    sha1_init_ctx(&digester);
+    sha1_process_bytes(GREGORIO_VERSION, strlen(GREGORIO_VERSION), &digester);
+    while ((n = fread(line, 1, sizeof line, file)) > 0) {
+        sha1_process_bytes(line, n, &digester);
+    }
+    fclose(file);
+    sha1_finish_ctx(&digester, digest);
+    for (i = 0; i < SHA1_DIGEST_SIZE; ++i) {
+        expected[2 * i] = hex[(digest[i] >> 4) & 0x0FU];
+        expected[2 * i + 1] = hex[digest[i] & 0x0FU];
+    }
+    expected[2 * SHA1_DIGEST_SIZE] = '\0';
+
+    file = fopen(output_file_name, "r");
+    if (!file) {
+        return false;
+    }
+    if (!point_and_click_filename) {
+        point_and_click_filename = "";
+    }
+    while (fgets(line, sizeof line, file)) {
+        if (!strncmp(line, begin_score, sizeof begin_score - 1)) {
+            p = line + sizeof begin_score - 1;
+            if (strncmp(p, expected, 2 * SHA1_DIGEST_SIZE)
+                    || p[2 * SHA1_DIGEST_SIZE] != '}') {
+                break;
+            }
+            /* skip the heights and the flags */
+            p += 2 * SHA1_DIGEST_SIZE + 1;
+            for (i = 0; i < 4 && p && *p == '{'; ++i) {
+                p = strchr(p, '}');
+                if (p) {
+                    ++p;
+                }
+            }
+            n = strlen(point_and_click_filename);
+            same_score = i == 4 && p && *p == '{'
+                    && !strncmp(p + 1, point_and_click_filename, n)
+                    && p[n + 1] == '}';
+            if (!same_score) {
+                break;
+            }
+        } else if (same_score
+                && !strncmp(line, end_score, sizeof end_score - 1)) {
+            complete = true;
+            break;
+        }
+    }
+    fclose(file);
+    return same_score && complete;
+}
+
+/* reads the score from the input file and writes the output file */
+static void process_score(char *input_file_name, FILE *input_file,
+        char *output_file_name, FILE *output_file,
+        gregorio_file_format input_format, gregorio_file_format output_format,
+        bool point_and_click, bool skip_unchanged)
+{
+    char *point_and_click_filename = NULL;
+    gregorio_score *score = NULL;
+
+    if (!input_file && point_and_click) {
+        point_and_click_filename = encode_point_and_click_filename(
+                input_file_name);
+    }
+
+    if (skip_unchanged && !input_file && !output_file
+            && output_format == GTEX
+            && is_up_to_date(input_file_name, output_file_name,
+                point_and_click_filename)) {
+        gregorio_messagef("process_score", VERBOSITY_INFO, 0,
+                _("%s is up to date"), output_file_name);
+        if (point_and_click_filename) {
+            free(point_and_click_filename);
+        }
+        return;
+    }
+
+    if (!output_file) {
+        if (!input_file) {
+            check_input_clobber(input_file_name, output_file_name);
+        }
+        gregorio_check_file_access(write, output_file_name, ERROR,
+                gregorio_exit(1));
+        output_file = fopen(output_file_name, "wb");
+        if (!output_file) {
+            fprintf(stderr, "error: can't write in file %s", output_file_name);
+            gregorio_exit(1);
+        }
+    }
+
+    /* we always have input_file or input_file_name */
+    if (input_file) {
+        if (point_and_click) {
+            fprintf(stderr,
+                    "warning: disabling point-and-click since reading from stdin\n");
+        }
+    } else {
+        gregorio_check_file_access(read, input_file_name, ERROR,
+                gregorio_exit(1));
+        input_file = fopen(input_file_name, "r");
+        if (!input_file) {
+            fprintf(stderr, "error: can't open file %s for reading\n",
+                    input_file_name);
+            gregorio_exit(1);
+        }
+    }
+
+    switch (input_format) {
+    case GABC:
+        score = gabc_read_score(input_file, point_and_click);
+        break;
+    default:
+        /* not reachable unless there's a programming error */
+        /* LCOV_EXCL_START */
+        fprintf(stderr, "error : invalid input format\n");
+        fclose(input_file);
+        fclose(output_file);
+        gregorio_exit(1);
+        break;
+        /* LCOV_EXCL_STOP */
+    }
+
+    fclose(input_file);
+    if (score == NULL) {
+        /* score should never be NULL on return from gabc_read_score */
+        /* LCOV_EXCL_START */
+        fclose(output_file);
+        fprintf(stderr, "error in file parsing\n");
+        gregorio_exit(1);
+        /* LCOV_EXCL_STOP */
+    }
+
+    switch (output_format) {
+    case GABC:
+        gabc_write_score(output_file, score);
+        break;
+    case GTEX:
+        gregoriotex_write_score(output_file, score, point_and_click_filename);
+        break;
+    case DUMP:
+        dump_write_score(output_file, score);
+        break;
+    default:
+        /* not reachable unless there's a programming error */
+        /* LCOV_EXCL_START */
+        fprintf(stderr, "error : invalid output format\n");
+        gregorio_free_score(score);
+        fclose(output_file);
+        gregorio_exit(1);
+        break;
+        /* LCOV_EXCL_STOP */
+    }
+    fclose(output_file);
+    if (point_and_click_filename) {
+        free(point_and_click_filename);
+    }
+    gregorio_free_score(score);
+    /* the scanners start from scratch with the next score */
+    gregorio_vowel_tables_free();
+    gabc_score_determination_lex_destroy();
+    gabc_notes_determination_lex_destroy();
+    gregorio_vowel_rulefile_lex_destroy();
+}
+
 int main(int argc, char **argv)
 {
     int c;
 
     char *input_file_name = NULL;
     char *output_file_name = NULL;
-    char *output_basename = NULL;
     char *error_file_name = NULL;
     FILE *input_file = NULL;
     FILE *output_file = NULL;
@@ -327,7 +553,8 @@ int main(int argc, char **argv)
     gregorio_verbosity verb_mode = 0;
     bool deprecation_errors = false;
     bool point_and_click = false;
-    char *point_and_click_filename = NULL;
+    bool batch = false;
+    bool skip_unchanged = false;
     bool debug = false;
     bool must_print_short_usage = false;
     int option_index = 0;
@@ -346,8 +573,9 @@ int main(int argc, char **argv)
         {"deprecation-errors", 0, 0, 'D'},
         {"point-and-click", 0, 0, 'p'},
         {"debug", 0, 0, 'd'},
+        {"batch", 0, 0, 'b'},
+        {"skip-unchanged", 0, 0, 'u'},
     };
-    gregorio_score *score = NULL;
 
     gregorio_support_init("gregorio", argv[0]);
 
@@ -359,7 +587,7 @@ int main(int argc, char **argv)
     setlocale(LC_CTYPE, "C");
 
     while (1) {
-        c = getopt_long(argc, argv, "o:SF:l:f:shOLVvWDpd",
+        c = getopt_long(argc, argv, "o:SF:l:f:shOLVvWDpdbu",
                         long_options, &option_index);
         if (c == -1)
             break;
@@ -515,6 +743,24 @@ int main(int argc, char **argv)
             }
             debug = true;
             break;
+        case 'b':
+            if (batch) {
+                fprintf(stderr,
+                        "warning: batch option passed several times\n");
+                must_print_short_usage = true;
+                break;
+            }
+            batch = true;
+            break;
+        case 'u':
+            if (skip_unchanged) {
+                fprintf(stderr,
+                        "warning: skip-unchanged option passed several times\n");
+                must_print_short_usage = true;
+                break;
+            }
+            skip_unchanged = true;
+            break;
         case '?':
             must_print_short_usage = true;
             break;
@@ -528,7 +774,18 @@ int main(int argc, char **argv)
             /* LCOV_EXCL_STOP */
         }
     } /* end of while */
-    if (optind == argc) {
+    if (batch) {
+        if (output_file_name || output_file || input_file) {
+            fprintf(stderr, "error: can't use -o, -S or -s in batch mode\n");
+            print_short_usage(argv[0]);
+            gregorio_exit(1);
+        }
+        if (optind == argc) {
+            fprintf(stderr, "%s: missing file operand.\n", argv[0]);
+            print_short_usage(argv[0]);
+            gregorio_exit(1);
+        }
+    } else if (optind == argc) {
         if (!input_file) { /* input not undefined (could be stdin) */
             fprintf(stderr, "%s: missing file operand.\n", argv[0]);
             print_short_usage(argv[0]);
@@ -536,7 +793,6 @@ int main(int argc, char **argv)
         }
     } else {
         input_file_name = argv[optind++];
-        output_basename = get_base_filename(input_file_name);
         if (input_file) {
             fprintf(stderr,
                     "warning: can't read from both stdin and a file, reading from %s\n",
@@ -545,7 +801,7 @@ int main(int argc, char **argv)
             must_print_short_usage = true;
         }
     }
-    if (optind < argc) {
+    if (!batch && optind < argc) {
         must_print_short_usage = true;
         fprintf(stderr, "ignored arguments:");
         for (; optind < argc; ++optind) {
@@ -572,72 +828,6 @@ int main(int argc, char **argv)
 
     /* then we act... */
 
-    if (!output_file_name && !output_file) {
-        if (!output_basename) {
-            output_file = stdout;
-        } else {
-            switch (output_format) {
-            case GABC:
-                output_file_name =
-                    get_output_filename(output_basename, "gabc");
-                break;
-            case GTEX:
-                output_file_name =
-                    get_output_filename(output_basename, "gtex");
-                break;
-            case DUMP:
-                output_file_name =
-                    get_output_filename(output_basename, "dump");
-                break;
-            default:
-                /* not reachable unless there's a programming error */
-                /* LCOV_EXCL_START */
-                fprintf(stderr, "error: unsupported format");
-                print_short_usage(argv[0]);
-                gregorio_exit(1);
-                /* LCOV_EXCL_STOP */
-            }
-        }
-    }
-
-    if (output_basename) {
-        free(output_basename);
-    }
-
-    if (!output_file) {
-        if (!input_file) {
-            check_input_clobber(input_file_name, output_file_name);
-        }
-        gregorio_check_file_access(write, output_file_name, ERROR,
-                gregorio_exit(1));
-        output_file = fopen(output_file_name, "wb");
-        if (!output_file) {
-            fprintf(stderr, "error: can't write in file %s", output_file_name);
-            gregorio_exit(1);
-        }
-    }
-
-    /* we always have input_file or input_file_name */
-    if (input_file) {
-        if (point_and_click) {
-            fprintf(stderr,
-                    "warning: disabling point-and-click since reading from stdin\n");
-        }
-    } else {
-        gregorio_check_file_access(read, input_file_name, ERROR,
-                gregorio_exit(1));
-        input_file = fopen(input_file_name, "r");
-        if (!input_file) {
-            fprintf(stderr, "error: can't open file %s for reading\n",
-                    input_file_name);
-            gregorio_exit(1);
-        }
-        if (point_and_click) {
-            point_and_click_filename = encode_point_and_click_filename(
-                    input_file_name);
-        }
-    }
-
     if (!error_file_name) {
         error_file = stderr;
         gregorio_set_error_out(error_file);
@@ -659,60 +849,31 @@ int main(int argc, char **argv)
 
     gregorio_set_verbosity_mode(verb_mode);
 
-    switch (input_format) {
-    case GABC:
-        score = gabc_read_score(input_file, point_and_click);
-        break;
-    default:
-        /* not reachable unless there's a programming error */
-        /* LCOV_EXCL_START */
-        fprintf(stderr, "error : invalid input format\n");
-        fclose(input_file);
-        fclose(output_file);
-        gregorio_exit(1);
-        break;
-        /* LCOV_EXCL_STOP */
-    }
-
-    fclose(input_file);
-    if (score == NULL) {
-        /* score should never be NULL on return from gabc_read_score */
-        /* LCOV_EXCL_START */
-        fclose(output_file);
-        fprintf(stderr, "error in file parsing\n");
-        gregorio_exit(1);
-        /* LCOV_EXCL_STOP */
+    if (batch) {
+        /* the scores are converted one after the other in this process */
+        for (; optind < argc; ++optind) {
+            input_file_name = argv[optind];
+            output_file_name = get_default_output_filename(input_file_name,
+                    output_format);
+            process_score(input_file_name, NULL, output_file_name, NULL,
+                    input_format, output_format, point_and_click,
+                    skip_unchanged);
+            free(output_file_name);
+        }
+    } else {
+        if (!output_file_name && !output_file) {
+            if (!input_file_name) {
+                output_file = stdout;
+            } else {
+                output_file_name = get_default_output_filename(
+                        input_file_name, output_format);
+            }
+        }
+        process_score(input_file_name, input_file, output_file_name,
+                output_file, input_format, output_format, point_and_click,
+                skip_unchanged);
     }
 
-    switch (output_format) {
-    case GABC:
-        gabc_write_score(output_file, score);
-        break;
-    case GTEX:
-        gregoriotex_write_score(output_file, score, point_and_click_filename);
-        break;
-    case DUMP:
-        dump_write_score(output_file, score);
-        break;
-    default:
-        /* not reachable unless there's a programming error */
-        /* LCOV_EXCL_START */
-        fprintf(stderr, "error : invalid output format\n");
-        gregorio_free_score(score);
-        fclose(output_file);
-        gregorio_exit(1);
-        break;
-        /* LCOV_EXCL_STOP */
-    }
-    fclose(output_file);
-    if (point_and_click_filename) {
-        free(point_and_click_filename);
-    }
-    gregorio_free_score(score);
-    gregorio_vowel_tables_free();
-    gabc_score_determination_lex_destroy();
-    gabc_notes_determination_lex_destroy();
-    gregorio_vowel_rulefile_lex_destroy();
     if (error_file_name) {
         fclose(error_file);
     }
@@ -0,0 +1,298 @@
+/**
+ * @file miktex/t4ht.h
+ * @author Christian Schenk
+ * @brief MiKTeX t4ht picture runner
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+/* With -j<n> (and/or -C), the pictures of the .lg file are not converted
+   one after the other: they are collected and converted afterwards by up
+   to n conversion processes at the same time.  With -C, a picture is
+   taken from the cache if its page of the .idv file, the fonts and the
+   conversion script are unchanged.  Files which are included by
+   \special commands are not looked at. */
+
+struct MiKTeXPicture
+{
+    std::string idvFile;
+    long page = 0;
+    std::string outFile;
+    std::string key;
+    bool done = false;
+    int exitCode = 0;
+    std::vector<std::string> templates;
+    std::vector<std::string> commands;
+    std::vector<std::string> finishCommands;
+};
+
+static int miktex_picture_jobs = 1;
+static bool miktex_picture_cache = false;
+static std::vector<MiKTeXPicture> miktex_pictures;
+
+// -1: run the commands; 0/1: add them to the conversion/finish commands of
+// the last picture
+static int miktex_queue_mode = -1;
+static const char* miktex_script_command = "";
+
+inline bool miktex_pictures_enabled()
+{
+    return miktex_picture_jobs > 1 || miktex_picture_cache;
+}
+
+inline void miktex_begin_picture(const char* idvFile, const char* page, const char* outFile)
+{
+    MiKTeXPicture picture;
+    picture.idvFile = idvFile;
+    picture.page = std::atol(page);
+    picture.outFile = outFile;
+    miktex_pictures.push_back(picture);
+}
+
+inline void miktex_add_picture_command(bool finish, const char* commandTemplate, const char* command)
+{
+    MiKTeXPicture& picture = miktex_pictures.back();
+    if (finish)
+    {
+        picture.finishCommands.push_back(command);
+    }
+    else
+    {
+        picture.templates.push_back(commandTemplate);
+        picture.commands.push_back(command);
+    }
+}
+
+inline unsigned long miktex_get_dvi_four(const std::vector<unsigned char>& dvi, std::size_t pos)
+{
+    return (static_cast<unsigned long>(dvi[pos]) << 24) | (static_cast<unsigned long>(dvi[pos + 1]) << 16) | (static_cast<unsigned long>(dvi[pos + 2]) << 8) | dvi[pos + 3];
+}
+
+/* Adds page `pageNo` of a DVI file to the digest, together with the
+   preamble parameters and the font definitions of the postamble. */
+inline bool miktex_digest_dvi_page(const std::vector<unsigned char>& dvi, long pageNo, MiKTeX::Core::MD5Builder& md5Builder)
+{
+    const unsigned char PRE = 247;
+    const unsigned char BOP = 139;
+    const unsigned char POST = 248;
+    const unsigned char TRAILER = 223;
+    std::size_t idPos = dvi.size();
+    while (idPos > 0 && dvi[idPos - 1] == TRAILER)
+    {
+        --idPos;
+    }
+    if (idPos < 20 || dvi[0] != PRE)
+    {
+        return false;
+    }
+    // post_post q[4] id
+    std::size_t postPostPos = idPos - 6;
+    std::size_t postPos = miktex_get_dvi_four(dvi, postPostPos + 1);
+    if (postPos + 29 > postPostPos || dvi[postPos] != POST)
+    {
+        return false;
+    }
+    std::vector<std::size_t> bops;
+    unsigned long bop = miktex_get_dvi_four(dvi, postPos + 1);
+    while (bop != 0xffffffffUL && bop + 45 <= postPos && dvi[bop] == BOP && bops.size() < dvi.size() / 45)
+    {
+        bops.push_back(bop);
+        bop = miktex_get_dvi_four(dvi, bop + 41);
+    }
+    std::reverse(bops.begin(), bops.end());
+    if (pageNo < 1 || static_cast<std::size_t>(pageNo) > bops.size())
+    {
+        return false;
+    }
+    std::size_t start = bops[pageNo - 1] + 45;
+    std::size_t end = static_cast<std::size_t>(pageNo) < bops.size() ? bops[pageNo] : postPos;
+    md5Builder.Update(&dvi[1], 14);
+    md5Builder.Update(&dvi[postPos + 29], postPostPos - postPos - 29);
+    md5Builder.Update(&dvi[start], end - start);
+    return true;
+}
+
+inline MiKTeX::Util::PathName miktex_picture_cache_file(const MiKTeXPicture& picture)
+{
+    MiKTeX::Util::PathName path = MIKTEX_SESSION()->GetSpecialPath(MiKTeX::Configuration::SpecialPath::DataRoot) / MIKTEX_PATH_TEX4HT_CACHE_DIR / picture.key;
+    path.AppendExtension(MiKTeX::Util::PathName(picture.outFile).GetExtension());
+    return path;
+}
+
+inline void miktex_compute_picture_keys()
+{
+    std::map<std::string, std::vector<unsigned char>> idvFiles;
+    for (MiKTeXPicture& picture : miktex_pictures)
+    {
+        try
+        {
+            auto it = idvFiles.find(picture.idvFile);
+            if (it == idvFiles.end())
+            {
+                it = idvFiles.insert({ picture.idvFile, MiKTeX::Core::File::ReadAllBytes(MiKTeX::Util::PathName(picture.idvFile)) }).first;
+            }
+            MiKTeX::Core::MD5Builder md5Builder;
+            if (!miktex_digest_dvi_page(it->second, picture.page, md5Builder))
+            {
+                continue;
+            }
+            for (const std::string& t : picture.templates)
+            {
+                md5Builder.Update(t.c_str(), t.length() + 1);
+            }
+            picture.key = md5Builder.Final().ToString();
+        }
+        catch (const MiKTeX::Core::MiKTeXException&)
+        {
+            picture.key = "";
+        }
+    }
+}
+
+inline void miktex_run_pictures(bool systemYes, bool alwaysCallSys)
+{
+    if (miktex_pictures.empty())
+    {
+        return;
+    }
+    if (miktex_picture_cache)
+    {
+        miktex_compute_picture_keys();
+        for (MiKTeXPicture& picture : miktex_pictures)
+        {
+            if (picture.key.empty())
+            {
+                continue;
+            }
+            try
+            {
+                MiKTeX::Util::PathName cachedFile = miktex_picture_cache_file(picture);
+                if (MiKTeX::Core::File::Exists(cachedFile))
+                {
+                    MiKTeX::Core::File::Copy(cachedFile, MiKTeX::Util::PathName(picture.outFile));
+                    picture.done = true;
+                    std::printf("%s taken from the cache\n", picture.outFile.c_str());
+                }
+            }
+            catch (const MiKTeX::Core::MiKTeXException&)
+            {
+                picture.done = false;
+            }
+        }
+    }
+    // scripts which use the job name write to a common temporary file
+    std::size_t jobs = miktex_picture_jobs;
+    for (const MiKTeXPicture& picture : miktex_pictures)
+    {
+        for (const std::string& t : picture.templates)
+        {
+            if (t.find("%%4") != std::string::npos)
+            {
+                jobs = 1;
+            }
+        }
+    }
+    std::mutex outputMutex;
+    auto run = [&](const std::string& command)
+    {
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::printf("System call: %s\n", command.c_str());
+        }
+        int ret = systemYes ? miktex_system(command.c_str()) : -1;
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::printf("%sSystem return: %d\n", ret ? "--- Warning --- " : "", ret);
+        }
+        return alwaysCallSys ? 0 : ret;
+    };
+    std::atomic_size_t next(0);
+    auto worker = [&]()
+    {
+        std::size_t idx;
+        while ((idx = next++) < miktex_pictures.size())
+        {
+            MiKTeXPicture& picture = miktex_pictures[idx];
+            if (picture.done)
+            {
+                continue;
+            }
+            for (const std::string& command : picture.commands)
+            {
+                if ((picture.exitCode = run(command)) != 0)
+                {
+                    break;
+                }
+            }
+        }
+    };
+    std::vector<std::future<void>> workers;
+    for (std::size_t n = 0; n < std::min(jobs, miktex_pictures.size()); ++n)
+    {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    for (std::future<void>& f : workers)
+    {
+        f.get();
+    }
+    for (const MiKTeXPicture& picture : miktex_pictures)
+    {
+        if (picture.exitCode != 0)
+        {
+            continue;
+        }
+        if (miktex_picture_cache && !picture.done && !picture.key.empty())
+        {
+            try
+            {
+                MiKTeX::Util::PathName outFile(picture.outFile);
+                if (MiKTeX::Core::File::Exists(outFile))
+                {
+                    MiKTeX::Util::PathName cachedFile = miktex_picture_cache_file(picture);
+                    MiKTeX::Core::Directory::Create(cachedFile.GetDirectoryName());
+                    MiKTeX::Util::PathName newPath = cachedFile;
+                    newPath.AppendExtension("." + std::to_string(MiKTeX::Core::Process::GetCurrentProcess()->GetSystemId()));
+                    MiKTeX::Core::File::Copy(outFile, newPath);
+                    MiKTeX::Core::File::Move(newPath, cachedFile, { MiKTeX::Core::FileMoveOption::ReplaceExisting });
+                }
+            }
+            catch (const MiKTeX::Core::MiKTeXException&)
+            {
+                // the cache is an optimization: the picture has been made
+            }
+        }
+        for (const std::string& command : picture.finishCommands)
+        {
+            if (run(command) != 0)
+            {
+                break;
+            }
+        }
+    }
+    miktex_pictures.clear();
+}
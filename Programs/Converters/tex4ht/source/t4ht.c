@@ -112,6 +112,7 @@
 #endif
 #if defined(MIKTEX)
 # include <miktex/tex4ht.h>
+# include <miktex/t4ht.h>
 #endif
 
 #ifdef KPATHSEA
@@ -459,6 +460,10 @@ static const C_CHAR *warn_err_mssg[]={
 "  -d...  directory for output files       (default:  current)\n"
 "  -e...  location of tex4ht.env\n"
 "  -i     debugging info\n"
+#if defined(MIKTEX)
+"  -j...  convert up to ... pictures at the same time\n"
+"  -C     reuse cached pictures of unchanged pages\n"
+#endif
 "  -g     ignore errors in system calls\n"
 "  -m...  chmod ... of new output files (reused bitmaps excluded)\n"
 "  -p     don't convert pictures           (default:  convert)\n"
@@ -726,6 +731,9 @@ while( *p != '\0' ){
 
       if( (command[0] != '\0') && !system_return ){
          
+#if defined(MIKTEX)
+miktex_script_command = temp->command;
+#endif
 (IGNORED) call_sys(command);
 
  }
@@ -1188,6 +1196,14 @@ static void call_sys
 #endif
 {
    if( *command ){
+#if defined(MIKTEX)
+      if( miktex_queue_mode >= 0 ){
+         miktex_add_picture_command(miktex_queue_mode == 1,
+                                    miktex_script_command, command);
+         system_return = 0;
+         return;
+      }
+#endif
       (IGNORED) printf("System call: %s\n", command);
 #if defined(MIKTEX)
       system_return = system_yes ? miktex_system(command) : -1;
@@ -1629,6 +1645,9 @@ if( (int) strlen((char *)  argv[i] ) == 2 ){
 && (*(p+1) != 'b')
 && (*(p+1) != 'g')
 && (*(p+1) != 'Q')
+#if defined(MIKTEX)
+&& (*(p+1) != 'C')
+#endif
 
  )
      { if( ++i == argc ) bad_arg; }
@@ -1673,6 +1692,10 @@ lg_name++;
   case 'p':{ nopict = q-1;  break;}
   case 'Q':{ check_tex4ht_c_err = TRUE;  break;}
   case 'r':{ noreuse = q-1;  break;}
+#if defined(MIKTEX)
+  case 'C':{ miktex_picture_cache = true;  break;}
+  case 'j':{ miktex_picture_jobs = atoi(q);  break;}
+#endif
   case '.':{ Dotfield = q;  break;}
    default:{ bad_arg;  }
 }
@@ -2680,6 +2703,23 @@ empty_pic = empty_pic->next;
 if( !nopict && !skip ){
    
 filtered_dvigif_script = filterGifScript(dvigif_script, match[3]);
+#if defined(MIKTEX)
+if( miktex_pictures_enabled() ){
+  miktex_begin_picture(match[1], match[2], match[3]);
+  miktex_queue_mode = 0;
+  (void) execute_script(
+    filtered_dvigif_script,match[1],match[2],match[3],job_name);
+  miktex_queue_mode = 1;
+  if( dir && !bitmaps_no_dm ){
+    (void) execute_script(move_script,match[3],dir,".","");
+  }
+  if( ch_mod && !bitmaps_no_dm ){
+    (void) execute_script(chmod_script, ch_mod, dir?dir:"",match[3], "");
+  }
+  miktex_queue_mode = -1;
+  (void) free_script( filtered_dvigif_script );
+} else {
+#endif
 (void) execute_script(
   filtered_dvigif_script,match[1],match[2],match[3],job_name);
 (void) free_script( filtered_dvigif_script );
@@ -2689,6 +2729,9 @@ if( dir && !bitmaps_no_dm && !system_return ){
 if( ch_mod && !bitmaps_no_dm && !system_return ){
   (void) execute_script(chmod_script, ch_mod, dir?dir:"",match[3], "");
 }
+#if defined(MIKTEX)
+}
+#endif
 
 
 }
@@ -2719,7 +2762,11 @@ if( status ){
  }
       }
       if ( eoln_ch == EOF ){ break; }
-}  }
+}
+#if defined(MIKTEX)
+miktex_run_pictures(system_yes, always_call_sys);
+#endif
+}
 
 
    
@@ -21,8 +21,10 @@
 
 #if defined(__cplusplus)
 #include <cstdarg>
+#include <cstddef>
 #else
 #include <stdarg.h>
+#include <stddef.h>
 #endif
 
 #if defined(__cplusplus)
@@ -33,6 +35,11 @@ void miktex_log_error_va(const char* format, va_list args);
 void miktex_log_info_va(const char* format, va_list args);
 void miktex_log_warn_va(const char* format, va_list args);
 void miktex_read_config_files();
+int miktex_get_cached_pdf_box(const char* path, int page, const char* boxName, double* llx, double* lly, double* urx, double* ury, int* pdfVersion, int* pageCount);
+void miktex_set_cached_pdf_box(const char* path, int page, const char* boxName, double llx, double lly, double urx, double ury, int pdfVersion, int pageCount);
+unsigned char* miktex_read_font_metric_file(const char* path, size_t* size);
+const unsigned char* miktex_map_file(const char* path, size_t* size, void** handle);
+void miktex_unmap_file(void* handle);
 
 #if defined(__cplusplus)
 }
@@ -21,6 +21,7 @@
 
 #include <miktex/App/Application>
 #include <miktex/Util/PathName>
+#include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Session>
 #include <miktex/Util/StringUtil>
@@ -30,6 +31,8 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Util;
 using namespace std;
 
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 
 extern "C"
@@ -108,3 +111,75 @@ extern "C" void miktex_read_config_files()
     }
   }
 }
+
+extern "C" int miktex_get_cached_pdf_box(const char* path, int page, const char* boxName, double* llx, double* lly, double* urx, double* ury, int* pdfVersion, int* pageCount)
+{
+  PdfBoxInfo info;
+  if (!MIKTEX_SESSION()->TryGetPdfBoxInfo(PathName(path), page, boxName, info))
+  {
+    return 0;
+  }
+  *llx = info.llx;
+  *lly = info.lly;
+  *urx = info.urx;
+  *ury = info.ury;
+  *pdfVersion = info.pdfVersion;
+  *pageCount = info.pageCount;
+  return 1;
+}
+
+extern "C" void miktex_set_cached_pdf_box(const char* path, int page, const char* boxName, double llx, double lly, double urx, double ury, int pdfVersion, int pageCount)
+{
+  PdfBoxInfo info;
+  info.llx = llx;
+  info.lly = lly;
+  info.urx = urx;
+  info.ury = ury;
+  info.pdfVersion = pdfVersion;
+  info.pageCount = pageCount;
+  MIKTEX_SESSION()->SetPdfBoxInfo(PathName(path), page, boxName, info);
+}
+
+extern "C" unsigned char* miktex_read_font_metric_file(const char* path, size_t* size)
+{
+  vector<unsigned char> data;
+  try
+  {
+    data = MIKTEX_SESSION()->ReadFontMetricFile(PathName(path));
+  }
+  catch (const exception&)
+  {
+    return nullptr;
+  }
+  unsigned char* buf = static_cast<unsigned char*>(malloc(data.empty() ? 1 : data.size()));
+  if (buf == nullptr)
+  {
+    return nullptr;
+  }
+  memcpy(buf, data.data(), data.size());
+  *size = data.size();
+  return buf;
+}
+
+extern "C" const unsigned char* miktex_map_file(const char* path, size_t* size, void** handle)
+{
+  unique_ptr<MemoryMappedFile> mappedFile(MemoryMappedFile::Create());
+  try
+  {
+    mappedFile->Open(PathName(path), false, { MemoryMappedFileHint::SequentialAccess });
+  }
+  catch (const exception&)
+  {
+    return nullptr;
+  }
+  const unsigned char* ptr = static_cast<const unsigned char*>(mappedFile->GetPtr());
+  *size = mappedFile->GetSize();
+  *handle = mappedFile.release();
+  return ptr;
+}
+
+extern "C" void miktex_unmap_file(void* handle)
+{
+  unique_ptr<MemoryMappedFile> mappedFile(static_cast<MemoryMappedFile*>(handle));
+  mappedFile->Close();
+}
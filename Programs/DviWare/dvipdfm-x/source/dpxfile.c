@@ -951,29 +951,23 @@ dpx_create_temp_file (void)
   return  tmp;
 }
 
-char *
-dpx_create_fix_temp_file (const char *filename)
-{
 #define PREFIX "dvipdfm-x."
+
+/* Both the converted images and the cached stream data are kept in files
+ * named after an MD5 digest, so that dpx_delete_old_cache() finds them.
+ */
+static char *
+dpx_create_cache_file_name (const unsigned char *digest)
+{
   static char *dir = NULL;
-  static char *cwd = NULL;
   char *ret, *s;
   int i;
-  MD5_CONTEXT state;
-  unsigned char digest[MAX_KEY_LEN];
 #ifdef WIN32
   char *p;
 #endif
 
-  if (!dir) {
+  if (!dir)
       dir = dpx_get_tmpdir();
-      cwd = xgetcwd();
-  }
-
-  MD5_init(&state);
-  MD5_write(&state, (unsigned char *)cwd,      strlen(cwd));
-  MD5_write(&state, (unsigned const char *)filename, strlen(filename));
-  MD5_final(digest, &state);
 
   ret = NEW(strlen(dir)+1+strlen(PREFIX)+MAX_KEY_LEN*2 + 1, char);
   sprintf(ret, "%s/%s", dir, PREFIX);
@@ -995,10 +989,54 @@ dpx_create_fix_temp_file (const char *filename)
 #endif
   }
 #endif
+  return ret;
+}
+
+char *
+dpx_create_fix_temp_file (const char *filename)
+{
+  static char *cwd = NULL;
+  char *ret;
+  MD5_CONTEXT state;
+  unsigned char digest[MAX_KEY_LEN];
+
+  if (!cwd)
+      cwd = xgetcwd();
+
+  MD5_init(&state);
+  MD5_write(&state, (unsigned char *)cwd,      strlen(cwd));
+  MD5_write(&state, (unsigned const char *)filename, strlen(filename));
+  MD5_final(digest, &state);
+
+  ret = dpx_create_cache_file_name(digest);
   /* printf("dpx_create_fix_temp_file: %s\n", ret); */
   return ret;
 }
 
+/* Returns the name of the cache file for the given data. The tag tells
+ * what the cache file holds for the data, e.g. "FlateDecode/9" for the
+ * data compressed with level 9. The file is kept only if the image cache
+ * is enabled (dpx_conf.file.keep_cache == 1).
+ */
+char *
+dpx_create_data_cache_file (const char *tag, const unsigned char *data, size_t length)
+{
+  MD5_CONTEXT state;
+  unsigned char digest[MAX_KEY_LEN];
+
+  MD5_init(&state);
+  MD5_write(&state, (unsigned const char *)tag, strlen(tag) + 1);
+  while (length > 0) {
+    unsigned int chunk = length > 0x40000000 ? 0x40000000 : (unsigned int) length;
+    MD5_write(&state, data, chunk);
+    data   += chunk;
+    length -= chunk;
+  }
+  MD5_final(digest, &state);
+
+  return dpx_create_cache_file_name(digest);
+}
+
 static int
 dpx_clear_cache_filter (const struct dirent *ent) {
     int plen = strlen(PREFIX);
@@ -61,6 +61,8 @@ extern int   dpx_file_apply_filter (const char *cmdtmpl,
                                    int version);
 extern char *dpx_create_temp_file  (void);
 extern char *dpx_create_fix_temp_file (const char *filename);
+extern char *dpx_create_data_cache_file (const char *tag,
+                                         const unsigned char *data, size_t length);
 extern void  dpx_delete_old_cache  (int life);
 extern void  dpx_delete_temp_file  (char *tmp, int force); /* tmp freed here */
 
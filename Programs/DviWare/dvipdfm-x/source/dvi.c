@@ -40,6 +40,9 @@
 #if defined(MIKTEX_WINDOWS)
 #include <miktex/unxemu.h>
 #endif
+#if defined(MIKTEX)
+#include <miktex/dvipdfm-x.h>
+#endif
 #include "system.h"
 #include "mem.h"
 #include "error.h"
@@ -237,10 +240,51 @@ static unsigned char* dvi_page_buffer;
 static unsigned int   dvi_page_buf_size;
 static unsigned int   dvi_page_buf_index;
 
+#if defined(MIKTEX)
+/* A named DVI file is mapped into memory: pages are scanned without
+ * going through stdio.  The postamble and the font definitions are
+ * still read through dvi_file.
+ */
+static const unsigned char *dvi_map = NULL;
+static size_t dvi_map_size = 0;
+static size_t dvi_map_pos = 0;
+static void *dvi_map_handle = NULL;
+
+#define DVI_MAPPED(file) (dvi_map != NULL && (file) == dvi_file)
+
+static void read_mapped_bytes (unsigned char *buf, unsigned int count)
+{
+  if (count > dvi_map_size - dvi_map_pos)
+    ERROR ("File ended prematurely\n");
+  memcpy(buf, dvi_map + dvi_map_pos, count);
+  dvi_map_pos += count;
+}
+
+/* hand over to the stdio functions and back */
+static void sync_dvi_file (void)
+{
+  if (dvi_map)
+    xseek_absolute (dvi_file, (int32_t)dvi_map_pos, "DVI");
+}
+
+static void sync_dvi_map (void)
+{
+  if (dvi_map)
+    dvi_map_pos = tell_position(dvi_file);
+}
+#endif
+
 /* functions to read numbers from the dvi file and store them in dvi_page_buffer */
 static int get_and_buffer_unsigned_byte (FILE *file)
 {
   int ch;
+#if defined(MIKTEX)
+  if (DVI_MAPPED(file)) {
+    if (dvi_map_pos >= dvi_map_size)
+      ERROR ("File ended prematurely\n");
+    ch = dvi_map[dvi_map_pos++];
+  } else
+#endif
   if ((ch = fgetc (file)) < 0)
     ERROR ("File ended prematurely\n");
   if (dvi_page_buf_index >= dvi_page_buf_size) {
@@ -264,6 +308,11 @@ static void get_and_buffer_bytes(FILE *file, unsigned int count)
     dvi_page_buf_size = dvi_page_buf_index + count + DVI_PAGE_BUF_CHUNK;
     dvi_page_buffer = RENEW(dvi_page_buffer, dvi_page_buf_size, unsigned char);
   }
+#if defined(MIKTEX)
+  if (DVI_MAPPED(file))
+    read_mapped_bytes(dvi_page_buffer + dvi_page_buf_index, count);
+  else
+#endif
   if (fread(dvi_page_buffer + dvi_page_buf_index, 1, count, file) != count)
     ERROR ("File ended prematurely\n");
   dvi_page_buf_index += count;
@@ -2352,6 +2401,9 @@ dvi_init (char *dvi_filename, double mag)
       ungetc(ch, dvi_file);
   } else {
     char *p, *saved_orig_name;
+#if defined(MIKTEX)
+    const char *opened_name = dvi_filename;
+#endif
     dvi_file = NULL;
     saved_orig_name = xstrdup(dvi_filename);
     p = strrchr(dvi_filename, '.');
@@ -2365,8 +2417,16 @@ dvi_init (char *dvi_filename, double mag)
         dvi_file = MFOPEN(dvi_filename, FOPEN_RBIN_MODE);
       }
     }
-    if (!dvi_file)
+    if (!dvi_file) {
       dvi_file = MFOPEN(saved_orig_name, FOPEN_RBIN_MODE);
+#if defined(MIKTEX)
+      opened_name = saved_orig_name;
+#endif
+    }
+#if defined(MIKTEX)
+    if (dvi_file)
+      dvi_map = miktex_map_file(opened_name, &dvi_map_size, &dvi_map_handle);
+#endif
     free(saved_orig_name);
 
     if (!dvi_file) {
@@ -2410,6 +2470,13 @@ dvi_close (void)
    */
 
   /* Do some house cleaning */
+#if defined(MIKTEX)
+  if (dvi_map) {
+    miktex_unmap_file(dvi_map_handle);
+    dvi_map = NULL;
+    dvi_map_handle = NULL;
+  }
+#endif
   MFCLOSE(dvi_file);
   dvi_file = NULL;
 
@@ -2774,6 +2841,11 @@ dvi_scan_specials (int page_no,
       ERROR("Invalid page number: %u", page_no);
     offset = page_loc[page_no];
 
+#if defined(MIKTEX)
+    if (dvi_map)
+      dvi_map_pos = offset;
+    else
+#endif
     xseek_absolute (fp, offset, "DVI");
   }
   
@@ -2797,6 +2869,11 @@ dvi_scan_specials (int page_no,
         dvi_page_buffer = RENEW(dvi_page_buffer, dvi_page_buf_size, unsigned char);
       }
 #define buf ((char*)(dvi_page_buffer + dvi_page_buf_index))
+#if defined(MIKTEX)
+      if (DVI_MAPPED(fp))
+        read_mapped_bytes((unsigned char*)buf, size);
+      else
+#endif
       if (fread(buf, sizeof(char), size, fp) != size)
         ERROR("Reading DVI file failed!");
       if (scan_special(page_width, page_height, x_offset, y_offset, landscape,
@@ -2843,7 +2920,13 @@ dvi_scan_specials (int page_no,
       break;
 
     case FNT_DEF1: case FNT_DEF2: case FNT_DEF3: case FNT_DEF4:
+#if defined(MIKTEX)
+      sync_dvi_file();
+#endif
       do_fntdef(get_unsigned_num(fp, opcode-FNT_DEF1));
+#if defined(MIKTEX)
+      sync_dvi_map();
+#endif
       break;
     case XDV_GLYPHS:
       need_XeTeX(opcode);
@@ -2861,7 +2944,13 @@ dvi_scan_specials (int page_no,
       break;
     case XDV_NATIVE_FONT_DEF:
       need_XeTeX(opcode);
+#if defined(MIKTEX)
+      sync_dvi_file();
+#endif
       do_native_font_def(get_signed_quad(dvi_file));
+#if defined(MIKTEX)
+      sync_dvi_map();
+#endif
       break;
     case BEGIN_REFLECT:
     case END_REFLECT:
@@ -2880,6 +2969,9 @@ dvi_scan_specials (int page_no,
       }
       /* else fall through to error case */
     default: /* case PRE: case POST_POST: and others */
+#if defined(MIKTEX)
+      sync_dvi_file();
+#endif
       ERROR("Unexpected opcode %d at pos=0x%x", opcode, tell_position(fp));
       break;
     }
@@ -1049,7 +1049,9 @@ extern __declspec(dllexport) int DLLPROC (int argc, char *argv[]);
 #endif /* !LIBDPX */
 
 #if defined(MIKTEX)
-#if defined(MIKTEX)
+#if defined(MIKTEX_DVIPDFMX_SHARED)
+#  define main MIKTEXDLLEXPORT MIKTEXCEECALL MiKTeX_DVIPDFMX
+#elif defined(MIKTEX)
 #  define main MIKTEXCEECALL Main
 #else
 #  define main Main
@@ -39,6 +39,7 @@
 #include "pdflimits.h"
 #include "pdfencrypt.h"
 #include "pdfparse.h"
+#include "dpxfile.h"
 
 #ifdef HAVE_ZLIB
 #include <zlib.h>
@@ -2179,6 +2180,72 @@ filter_create_predictor_dict (int predictor, int32_t columns,
   return  parms;
 }
 
+#ifdef HAVE_ZLIB
+/*
+ * If the image cache is enabled (-I option), the compressed data of large
+ * streams is kept in the cache directory, too.  Fonts and images that did
+ * not change since the last run need not be compressed again then.
+ */
+#define STREAM_CACHE_MIN_LENGTH 16384
+
+static char *
+stream_cache_file (pdf_out *p, const unsigned char *data, size_t length)
+{
+  char tag[32];
+
+  if (dpx_conf.file.keep_cache != 1 || length < STREAM_CACHE_MIN_LENGTH)
+    return NULL;
+  sprintf(tag, "FlateDecode/%d", p->options.compression.level);
+  return dpx_create_data_cache_file(tag, data, length);
+}
+
+static unsigned char *
+stream_cache_read (const char *cache_file, uLong *length)
+{
+  FILE          *fp;
+  long           size;
+  unsigned char *data = NULL;
+
+  fp = MFOPEN(cache_file, FOPEN_RBIN_MODE);
+  if (!fp)
+    return NULL;
+  if (fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) > 0 &&
+      fseek(fp, 0, SEEK_SET) == 0) {
+    data = NEW(size, unsigned char);
+    if (fread(data, 1, size, fp) == (size_t) size)
+      *length = size;
+    else {
+      RELEASE(data);
+      data = NULL;
+    }
+  }
+  MFCLOSE(fp);
+
+  return data;
+}
+
+static void
+stream_cache_write (const char *cache_file, const unsigned char *data, uLong length)
+{
+  FILE *fp;
+  char *temp;
+  int   error;
+
+  /* Write to a temporary file first so that a concurrent run never
+   * reads an incomplete cache file. */
+  temp = NEW(strlen(cache_file) + 5, char);
+  sprintf(temp, "%s.tmp", cache_file);
+  fp = MFOPEN(temp, FOPEN_WBIN_MODE);
+  if (fp) {
+    error = fwrite(data, 1, length, fp) != length;
+    error = (MFCLOSE(fp) != 0) || error;
+    if (error || rename(temp, cache_file) != 0)
+      remove(temp);
+  }
+  RELEASE(temp);
+}
+#endif /* HAVE_ZLIB */
+
 static void
 write_stream (pdf_out *p, pdf_stream *stream)
 {
@@ -2194,14 +2261,12 @@ write_stream (pdf_out *p, pdf_stream *stream)
   ASSERT(p);
 
   /*
-   * Always work from a copy of the stream. All filters read from
-   * "filtered" and leave their result in "filtered".
+   * All filters read from "filtered" and leave their result in a newly
+   * allocated buffer which replaces "filtered". The stream data itself
+   * is never modified, so it is not copied: "filtered" starts out
+   * pointing to it and is released only after it has been replaced.
    */
-#if 0
-  filtered = NEW(stream->stream_length + 1, unsigned char);
-#endif
-  filtered = NEW(stream->stream_length, unsigned char);
-  memcpy(filtered, stream->stream, stream->stream_length);
+  filtered = stream->stream;
   filtered_length = stream->stream_length;
 
   /* PDF/A requires Metadata to be not filtered. */
@@ -2219,6 +2284,7 @@ write_stream (pdf_out *p, pdf_stream *stream)
       (stream->_flags & STREAM_COMPRESS) &&
       p->options.compression.level > 0) {
     pdf_obj *filters;
+    char    *cache_file;
 
     /* First apply predictor filter if requested. */
     if ( p->options.compression.use_predictor &&
@@ -2258,7 +2324,8 @@ write_stream (pdf_out *p, pdf_stream *stream)
         break;
       }
       if (parms && filtered2) {
-        RELEASE(filtered);
+        if (filtered != stream->stream)
+          RELEASE(filtered);
         filtered = filtered2;
         filtered_length = length2;
         pdf_add_dict(stream->dict, pdf_new_name("DecodeParms"), parms);
@@ -2267,8 +2334,6 @@ write_stream (pdf_out *p, pdf_stream *stream)
 
     filters = pdf_lookup_dict(stream->dict, "Filter");
 
-    buffer_length = filtered_length + filtered_length/1000 + 14;
-    buffer = NEW(buffer_length, unsigned char);
     {
       pdf_obj *filter_name = pdf_new_name("FlateDecode");
 
@@ -2285,18 +2350,29 @@ write_stream (pdf_out *p, pdf_stream *stream)
          */
         pdf_add_dict(stream->dict, pdf_new_name("Filter"), filter_name);
     }
+    cache_file = stream_cache_file(p, filtered, filtered_length);
+    buffer = cache_file ? stream_cache_read(cache_file, &buffer_length) : NULL;
+    if (!buffer) {
+      buffer_length = filtered_length + filtered_length/1000 + 14;
+      buffer = NEW(buffer_length, unsigned char);
 #ifdef HAVE_ZLIB_COMPRESS2    
-    if (compress2(buffer, &buffer_length, filtered,
-        filtered_length, p->options.compression.level)) {
-      ERROR("Zlib error");
-    }
+      if (compress2(buffer, &buffer_length, filtered,
+          filtered_length, p->options.compression.level)) {
+        ERROR("Zlib error");
+      }
 #else 
-    if (compress(buffer, &buffer_length, filtered,
-        filtered_length)) {
-      ERROR ("Zlib error");
-    }
+      if (compress(buffer, &buffer_length, filtered,
+          filtered_length)) {
+        ERROR ("Zlib error");
+      }
 #endif /* HAVE_ZLIB_COMPRESS2 */
-    RELEASE(filtered);
+      if (cache_file)
+        stream_cache_write(cache_file, buffer, buffer_length);
+    }
+    if (cache_file)
+      RELEASE(cache_file);
+    if (filtered != stream->stream)
+      RELEASE(filtered);
     p->output.compression_saved +=
       filtered_length - buffer_length
         - (filters ? strlen("/FlateDecode "): strlen("/Filter/FlateDecode\n"));
@@ -2311,7 +2387,8 @@ write_stream (pdf_out *p, pdf_stream *stream)
     unsigned char *cipher = NULL;
     size_t         cipher_len = 0;
     pdf_encrypt_data(p->sec_data, filtered, filtered_length, &cipher, &cipher_len);
-    RELEASE(filtered);
+    if (filtered != stream->stream)
+      RELEASE(filtered);
     filtered        = cipher;
     filtered_length = cipher_len;
   }
@@ -2338,7 +2415,8 @@ write_stream (pdf_out *p, pdf_stream *stream)
 
   if (filtered_length > 0)
     pdf_out_str(p, filtered, filtered_length);
-  RELEASE(filtered);
+  if (filtered != stream->stream)
+    RELEASE(filtered);
 
   /*
    * This stream length "object" gets reset every time write_stream is
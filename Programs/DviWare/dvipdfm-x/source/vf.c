@@ -40,6 +40,10 @@
 
 #include "dvicodes.h"
 
+#if defined(MIKTEX)
+#include <miktex/dvipdfm-x.h>
+#endif
+
 #define VF_ALLOC_SIZE  16u
 
 #define VF_ID 202
@@ -70,6 +74,76 @@ struct vf
 struct vf *vf_fonts = NULL;
 int num_vf_fonts = 0, max_vf_fonts = 0;
 
+#if defined(MIKTEX)
+/* VF files are read through the font metric cache of the session and
+ * parsed in memory */
+struct vf_buf
+{
+  const unsigned char *ptr, *end;
+};
+
+static void buf_need (struct vf_buf *vf_data, uint32_t count)
+{
+  if (count > (uint32_t)(vf_data->end - vf_data->ptr))
+    ERROR ("VF file ended prematurely.");
+}
+
+static unsigned int buf_unsigned_byte (struct vf_buf *vf_data)
+{
+  buf_need (vf_data, 1);
+  return *vf_data->ptr++;
+}
+
+static uint32_t buf_unsigned_num (struct vf_buf *vf_data, unsigned char num)
+{
+  uint32_t val;
+  buf_need (vf_data, num + 1);
+  val = *vf_data->ptr++;
+  switch (num) {
+  case 3: val = (val << 8) | *vf_data->ptr++;
+  case 2: val = (val << 8) | *vf_data->ptr++;
+  case 1: val = (val << 8) | *vf_data->ptr++;
+  default: break;
+  }
+  return val;
+}
+
+static uint32_t buf_positive_quad (struct vf_buf *vf_data, const char *name)
+{
+  uint32_t val = buf_unsigned_num (vf_data, 3);
+  if (val > 0x7fffffffU)
+    ERROR ("Bad VF: negative %s: %d", name, (int32_t)val);
+  return val;
+}
+
+static void buf_read_bytes (struct vf_buf *vf_data, void *dest, uint32_t count)
+{
+  buf_need (vf_data, count);
+  if (dest)
+    memcpy (dest, vf_data->ptr, count);
+  vf_data->ptr += count;
+}
+
+static void read_header(struct vf_buf *vf_data, int thisfont) 
+{
+  /* Check for usual signature */
+  if (buf_unsigned_byte (vf_data) == PRE &&
+      buf_unsigned_byte (vf_data) == VF_ID) {
+
+    /* If here, assume it's a legitimate vf file */
+
+    /* skip comment */
+    buf_read_bytes (vf_data, NULL, buf_unsigned_byte (vf_data));
+
+    /* Skip checksum */
+    buf_read_bytes (vf_data, NULL, 4);
+    
+    vf_fonts[thisfont].design_size = buf_positive_quad(vf_data, "design_size");
+  } else { /* Try to fail gracefully and return an error to caller */
+    fprintf (stderr, "VF file may be corrupt\n");
+  }
+}
+#else
 static void read_header(FILE *vf_file, int thisfont) 
 {
   /* Check for usual signature */
@@ -89,7 +163,7 @@ static void read_header(FILE *vf_file, int thisfont)
     fprintf (stderr, "VF file may be corrupt\n");
   }
 }
-
+#endif
 
 static void resize_vf_fonts(int size)
 {
@@ -122,6 +196,105 @@ static void resize_one_vf_font (struct vf *a_vf, unsigned size)
   }
 }
 
+#if defined(MIKTEX)
+static void read_a_char_def(struct vf_buf *vf_data, int thisfont, uint32_t pkt_len,
+			    uint32_t ch)
+{
+  unsigned char *pkt;
+  /* Resize and initialize character arrays if necessary */
+  if (ch >= vf_fonts[thisfont].num_chars) {
+    resize_one_vf_font (vf_fonts+thisfont, ch+1);
+  }
+  if (pkt_len > 0) {
+    buf_need (vf_data, pkt_len);
+    pkt = NEW (pkt_len, unsigned char);
+    buf_read_bytes (vf_data, pkt, pkt_len);
+    (vf_fonts[thisfont].ch_pkt)[ch] = pkt;
+  }
+  (vf_fonts[thisfont].pkt_len)[ch] = pkt_len;
+  return;
+}
+
+static void read_a_font_def(struct vf_buf *vf_data, int32_t font_id, int thisfont)
+{
+  struct font_def *dev_font;
+  int dir_length, name_length;
+  if (vf_fonts[thisfont].num_dev_fonts >=
+      vf_fonts[thisfont].max_dev_fonts) {
+    vf_fonts[thisfont].max_dev_fonts += VF_ALLOC_SIZE;
+    vf_fonts[thisfont].dev_fonts = RENEW
+      (vf_fonts[thisfont].dev_fonts,
+       vf_fonts[thisfont].max_dev_fonts,
+       struct font_def);
+  }
+  dev_font = vf_fonts[thisfont].dev_fonts+
+    vf_fonts[thisfont].num_dev_fonts;
+  dev_font -> font_id = font_id;
+  dev_font -> checksum = buf_unsigned_num (vf_data, 3);
+  dev_font -> size = buf_positive_quad (vf_data, "font_size");
+  dev_font -> design_size = buf_positive_quad (vf_data, "font_design_size");
+  dir_length = buf_unsigned_byte (vf_data);
+  name_length = buf_unsigned_byte (vf_data);
+  dev_font -> directory = NEW (dir_length+1, char);
+  dev_font -> name = NEW (name_length+1, char);
+  buf_read_bytes (vf_data, dev_font -> directory, dir_length);
+  buf_read_bytes (vf_data, dev_font -> name, name_length);
+  (dev_font -> directory)[dir_length] = 0;
+  (dev_font -> name)[name_length] = 0;
+  vf_fonts[thisfont].num_dev_fonts += 1;
+  dev_font->tfm_id = tfm_open (dev_font -> name, 1); /* must exist */
+  dev_font->dev_id =
+    dvi_locate_font (dev_font->name, 
+		     sqxfw (vf_fonts[thisfont].ptsize,
+			    dev_font->size));
+  return;
+}
+
+static void process_vf_file (struct vf_buf *vf_data, int thisfont)
+{
+  int eof = 0, code;
+  int32_t font_id;
+  while (!eof) {
+    code = buf_unsigned_byte (vf_data);
+    switch (code) {
+    case FNT_DEF1: case FNT_DEF2: case FNT_DEF3: case FNT_DEF4:
+      font_id = buf_unsigned_num (vf_data, code-FNT_DEF1);
+      read_a_font_def (vf_data, font_id, thisfont);
+      break;
+    default:
+      if (code < 242) {
+	/* For a short packet, code is the pkt_len */
+	uint32_t ch = buf_unsigned_byte (vf_data);
+	/* Skip over TFM width since we already know it */
+	buf_read_bytes (vf_data, NULL, 3);
+	read_a_char_def (vf_data, thisfont, code, ch);
+	break;
+      }
+      if (code == 242) {
+	uint32_t pkt_len = buf_positive_quad (vf_data, "pkt_len");
+	uint32_t ch = buf_unsigned_num (vf_data, 3);
+	/* Skip over TFM width since we already know it */
+	buf_read_bytes (vf_data, NULL, 4);
+	if (ch < 0x1000000U)
+	  read_a_char_def (vf_data, thisfont, pkt_len, ch);
+	else {
+	  fprintf (stderr, "char=%u\n", ch);
+	  ERROR ("Long character (>24 bits) in VF file.\nI can't handle long characters!\n");
+	}
+	break;
+      }
+      if (code == POST) {
+	eof = 1;
+	break;
+      }
+      fprintf (stderr, "Quitting on code=%d\n", code);
+      eof = 1;
+      break;
+    }
+  }
+  return;
+}
+#else
 static void read_a_char_def(FILE *vf_file, int thisfont, uint32_t pkt_len,
 			    uint32_t ch)
 {
@@ -228,6 +401,7 @@ static void process_vf_file (FILE *vf_file, int thisfont)
   }
   return;
 }
+#endif
 
 /* Unfortunately, the following code isn't smart enough
    to load the vf only once for multiple point sizes. 
@@ -242,7 +416,13 @@ int vf_locate_font (const char *tex_name, spt_t ptsize)
 {
   int thisfont = -1, i;
   char *full_vf_file_name;
+#if defined(MIKTEX)
+  unsigned char *vf_bytes = NULL;
+  size_t vf_size = 0;
+  struct vf_buf vf_data;
+#else
   FILE *vf_file;
+#endif
   /* Has this name and ptsize already been loaded as a VF? */
   for (i=0; i<num_vf_fonts; i++) {
     if (!strcmp (vf_fonts[i].tex_name, tex_name) &&
@@ -261,8 +441,15 @@ int vf_locate_font (const char *tex_name, spt_t ptsize)
 					  kpse_ovf_format,
 					  1);
     }
+#if defined(MIKTEX)
+    if (full_vf_file_name &&
+	(vf_bytes = miktex_read_font_metric_file (full_vf_file_name, &vf_size)) != NULL) {
+      vf_data.ptr = vf_bytes;
+      vf_data.end = vf_bytes + vf_size;
+#else
     if (full_vf_file_name &&
 	(vf_file = MFOPEN (full_vf_file_name, FOPEN_RBIN_MODE)) != NULL) {
+#endif
       if (dpx_conf.verbose_level == 1)
 	fprintf (stderr, "(VF:%s", tex_name);
       if (dpx_conf.verbose_level > 1)
@@ -279,11 +466,20 @@ int vf_locate_font (const char *tex_name, spt_t ptsize)
 	vf_fonts[thisfont].ch_pkt = NULL;
 	vf_fonts[thisfont].pkt_len = NULL;
       }
+#if defined(MIKTEX)
+      read_header(&vf_data, thisfont);
+      process_vf_file (&vf_data, thisfont);
+#else
       read_header(vf_file, thisfont);
       process_vf_file (vf_file, thisfont);
+#endif
       if (dpx_conf.verbose_level > 0)
 	fprintf (stderr, ")");
+#if defined(MIKTEX)
+      RELEASE (vf_bytes);
+#else
       MFCLOSE (vf_file);
+#endif
     }
     if (full_vf_file_name)
       RELEASE(full_vf_file_name);
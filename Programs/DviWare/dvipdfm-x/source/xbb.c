@@ -48,6 +48,9 @@
 #include <miktex/unxemu.h>
 #include <getopt.h>
 #endif
+#if defined(MIKTEX)
+#include <miktex/dvipdfm-x.h>
+#endif
 
 static enum pdf_page_boundary PageBox = pdf_page_boundary__auto;
 
@@ -257,6 +260,17 @@ static void do_pdf (FILE *fp, char *filename)
   pdf_rect bbox;
   pdf_tmatrix matrix;
   pdf_coord   p1, p2, p3, p4;
+#if defined(MIKTEX)
+  char box_name[32];
+  int  version;
+
+  sprintf(box_name, "xbb/%d", (int) PageBox);
+  if (miktex_get_cached_pdf_box(filename, page_no, box_name, &bbox.llx, &bbox.lly,
+                                &bbox.urx, &bbox.ury, &version, &count)) {
+    write_xbb(filename, bbox.llx, bbox.lly, bbox.urx, bbox.ury, version, count);
+    return;
+  }
+#endif
 
   pf = pdf_open(filename, fp);
   if (!pf) {
@@ -290,6 +304,11 @@ static void do_pdf (FILE *fp, char *filename)
   bbox.urx = max4(p1.x, p2.x, p3.x, p4.x);
   bbox.ury = max4(p1.y, p2.y, p3.y, p4.y);
 
+#if defined(MIKTEX)
+  miktex_set_cached_pdf_box(filename, page_no, box_name, bbox.llx, bbox.lly,
+                            bbox.urx, bbox.ury, pdf_file_get_version(pf), count);
+#endif
+
   write_xbb(filename, bbox.llx, bbox.lly, bbox.urx, bbox.ury,
             pdf_file_get_version(pf), count);
 }
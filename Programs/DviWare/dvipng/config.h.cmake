@@ -105,6 +105,9 @@
 /* Define to 1 if you have the `pow' function. */
 #cmakedefine HAVE_POW 1
 
+/* Define to 1 if you have the <pthread.h> header file. */
+#cmakedefine HAVE_PTHREAD_H 1
+
 /* Define to 1 if you have the `putenv' function. */
 #cmakedefine HAVE_PUTENV 1
 
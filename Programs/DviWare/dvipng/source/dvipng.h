@@ -344,6 +344,7 @@ void      CreateImage(pixels width, pixels height);
 void      DestroyImage(void);
 void      DrawCommand(unsigned char*, void* /* dvi/vf */);
 void      DrawPages(void);
+void      FlushImage(void);
 void      WriteImage(char*, int);
 void      LoadPK(int32_t, register struct char_entry *);
 int32_t   SetChar(int32_t);
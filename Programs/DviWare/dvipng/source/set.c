@@ -35,6 +35,71 @@
 #define gdImagePngEx(i,f,z)                  gdImagePng(i,f)
 #endif
 
+#if defined(MIKTEX_WINDOWS) || defined(HAVE_PTHREAD_H)
+# define WRITER_THREAD
+# ifndef MIKTEX_WINDOWS
+#  include <pthread.h>
+# endif
+#endif
+
+/* A finished page and the file it goes to. With WRITER_THREAD, the
+   PNG (or GIF) encoding runs in a second thread, so that compressing
+   one page overlaps with drawing the next. */
+struct write_job {
+  gdImagePtr imagep;
+  FILE*      outfp;
+};
+static struct write_job writer_job;
+
+#ifdef WRITER_THREAD
+static bool writer_busy=false;
+# ifdef MIKTEX_WINDOWS
+static HANDLE writer_thread;
+# else
+static pthread_t writer_thread;
+# endif
+#endif
+
+static void EncodeImage(struct write_job* job)
+{
+#ifdef HAVE_GDIMAGEGIF
+  if (option_flags & GIF_OUTPUT)
+    gdImageGif(job->imagep,job->outfp);
+  else
+#endif
+    gdImagePngEx(job->imagep,job->outfp,compression);
+  fclose(job->outfp);
+#ifdef WRITER_THREAD
+  gdImageDestroy(job->imagep);
+#endif
+}
+
+#ifdef WRITER_THREAD
+# ifdef MIKTEX_WINDOWS
+static DWORD WINAPI WriterMain(LPVOID job)
+{
+  EncodeImage((struct write_job*)job);
+  return 0;
+}
+# else
+static void* WriterMain(void* job)
+{
+  EncodeImage((struct write_job*)job);
+  return NULL;
+}
+# endif
+
+static bool StartWriter(void)
+{
+# ifdef MIKTEX_WINDOWS
+  writer_thread=CreateThread(NULL,0,WriterMain,&writer_job,0,NULL);
+  return writer_thread!=NULL;
+# else
+  return pthread_create(&writer_thread,NULL,WriterMain,&writer_job)==0;
+# endif
+}
+#endif
+
 /* Persistent color cache. Index is ink thickness,
    0=no ink, 127=total coverage */
 static int ColorCache[gdAlphaMax+1];
@@ -163,17 +228,41 @@ void WriteImage(char *pngname, int pagenum)
 #endif
   if ((outfp = fopen(pngname,"wb")) == NULL)
       Fatal("cannot open output file %s",pngname);
-#ifdef HAVE_GDIMAGEGIF
-  if (option_flags & GIF_OUTPUT)
-    gdImageGif(page_imagep,outfp);
+#ifdef WRITER_THREAD
+  /* Encode in the background while the next page is being drawn. The
+     image now belongs to the writer, CreateImage makes a new one. */
+  FlushImage();
+  writer_job.imagep=page_imagep;
+  writer_job.outfp=outfp;
+  page_imagep=NULL;
+  if (StartWriter())
+    writer_busy=true;
   else
+    EncodeImage(&writer_job);
+#else
+  writer_job.imagep=page_imagep;
+  writer_job.outfp=outfp;
+  EncodeImage(&writer_job);
+  DestroyImage();
 #endif
-    gdImagePngEx(page_imagep,outfp,compression);
-  fclose(outfp);
   DEBUG_PRINT(DEBUG_DVI,("\n  WROTE:   \t%s\n",pngname));
   if (freeme)
     free(freeme);
-  DestroyImage();
+}
+
+void FlushImage(void)
+{
+#ifdef WRITER_THREAD
+  if (writer_busy) {
+# ifdef MIKTEX_WINDOWS
+    WaitForSingleObject(writer_thread,INFINITE);
+    CloseHandle(writer_thread);
+# else
+    pthread_join(writer_thread,NULL);
+# endif
+    writer_busy=false;
+  }
+#endif
 }
 
 void DestroyImage(void)
@@ -15,6 +15,12 @@
  *   The external declarations:
  */
 #include "protos.h"
+#if defined(MIKTEX)
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Process>
+#endif
 
 static unsigned char dummyend[8] = { 252 };
 
@@ -430,6 +436,96 @@ static void addGlyph(const char *glyphName) {
 }
 #endif
 
+#if defined(MIKTEX)
+/*
+ *   With -MiKTeX:fontcache, partially downloaded Type 1 fonts are kept
+ *   in the MiKTeX cache directory, so that the same subset of a font is
+ *   not computed again in the next run.  A subset is identified by the
+ *   contents of the font file, the characters and extra glyphs used, and
+ *   everything else which affects the output of t1_subset_2().
+ */
+static PathName
+miktex_font_cache_file(const char *fontfile, unsigned char *grid, PathName &fontpath)
+{
+   std::shared_ptr<Session> session = MIKTEX_SESSION();
+   if (!session->FindFile(fontfile, FileType::TYPE1, fontpath))
+      return PathName();
+   MD5Builder md5Builder;
+   MD5 fontDigest = MD5::FromFile(fontpath);
+   md5Builder.Update(fontDigest.data(), fontDigest.size());
+   md5Builder.Update(grid, 256);
+   if (extraGlyphs)
+      md5Builder.Update(extraGlyphs, strlen(extraGlyphs));
+   md5Builder.Update(&shiftlowchars, sizeof(shiftlowchars));
+   md5Builder.Update(BANNER, strlen(BANNER));
+   PathName cachefile = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_DVIPS_CACHE_DIR / md5Builder.Final().ToString();
+   cachefile.AppendExtension(".pfa");
+   return cachefile;
+}
+
+static void
+miktex_copy_to_bitfile(const PathName &path)
+{
+   char buf[16384];
+   size_t n;
+   FILE *f = File::Open(path, FileMode::Open, FileAccess::Read, false);
+   while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      fwrite(buf, 1, n, bitfile);
+   fclose(f);
+}
+
+static boolean
+miktex_cached_subset(char *fontfile, unsigned char *grid)
+{
+   PathName fontpath;
+   PathName cachefile;
+   PathName newpath;
+   FILE *f = 0;
+   FILE *out = bitfile;
+   boolean ok;
+
+   try {
+      cachefile = miktex_font_cache_file(fontfile, grid, fontpath);
+      if (!cachefile.Empty() && File::Exists(cachefile)) {
+         miktex_copy_to_bitfile(cachefile);
+         if (realnameoffile)
+            free(realnameoffile);
+         realnameoffile = xstrdup(fontpath.GetData());
+         return 1;
+      }
+      if (!cachefile.Empty()) {
+         Directory::Create(cachefile.GetDirectoryName());
+         newpath = cachefile;
+         newpath.AppendExtension("." + std::to_string(Process::GetCurrentProcess()->GetSystemId()));
+         f = File::Open(newpath, FileMode::Create, FileAccess::Write, false);
+      }
+   } catch (const MiKTeXException &) {
+      /* the cache is an optimization: fall back to computing the subset */
+      f = 0;
+   }
+   if (f == 0)
+      return t1_subset_2(fontfile, grid, extraGlyphs);
+   bitfile = f;
+   try {
+      ok = t1_subset_2(fontfile, grid, extraGlyphs);
+   } catch (...) {
+      bitfile = out;
+      fclose(f);
+      File::Delete(newpath);
+      throw;
+   }
+   bitfile = out;
+   fclose(f);
+   miktex_copy_to_bitfile(newpath);
+   try {
+      File::Move(newpath, cachefile, {FileMoveOption::ReplaceExisting});
+   } catch (const MiKTeXException &) {
+      File::Delete(newpath);
+   }
+   return ok;
+}
+#endif
+
 /*
  *   Download a PostScript font, using partial font downloading if
  *   necessary.
@@ -527,7 +623,12 @@ downpsfont(charusetype *p, charusetype *all)
         if (! disablecomments)
            fprintf(bitfile, "%%%%BeginFont: %s\n",  rf->PSname);
 #ifdef DOWNLOAD_USING_PDFTEX
+#if defined(MIKTEX)
+        if (miktex_font_cache ? !miktex_cached_subset(rf->Fontfile, grid)
+                              : !t1_subset_2(rf->Fontfile, grid, extraGlyphs))
+#else
         if (!t1_subset_2(rf->Fontfile, grid, extraGlyphs))
+#endif
 #else
         if(FontPart(bitfile, rf->Fontfile, rf->Vectfile) < 0)
 #endif
@@ -253,6 +253,7 @@ int miktex_no_rules = 0;
 int miktex_no_landscape = 0;
 int miktex_pedantic = 0;
 int miktex_allow_all_paths = 0;
+int miktex_font_cache = 0;
 #endif
 #ifdef HPS
 Boolean HPS_FLAG = 0;
@@ -1159,6 +1160,11 @@ case 'M':
     miktex_allow_all_paths = 1;
     break;
   }
+  if (strcmp(p, "iKTeX:fontcache") == 0)
+  {
+    miktex_font_cache = 1;
+    break;
+  }
 }
 #endif
                dontmakefont = (*p != '0');
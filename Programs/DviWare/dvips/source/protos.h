@@ -389,6 +389,7 @@ extern int miktex_no_rules;
 extern int miktex_no_landscape;
 extern int miktex_pedantic;
 extern int miktex_allow_all_paths;
+extern int miktex_font_cache;
 #endif
 
 /* global variables from flib.c */
@@ -356,6 +356,16 @@ void DVIToSVG::embedFonts (XMLElement *svgElement) {
 	auto &usedCharsMap = FontManager::instance().getUsedChars();
 	collect_chars(usedCharsMap);
 
+	// run Metafont for all fonts whose GF files are going to be needed
+	vector<const PhysicalFont*> mfFonts;
+	for (const auto &fontchar : usedCharsMap) {
+		if (auto ph_font = font_cast<const PhysicalFont*>(fontchar.first)) {
+			if (ph_font->type() == PhysicalFont::Type::MF && (TRACE_MODE != 0 || ph_font->hasUncachedGlyphs(fontchar.second)))
+				mfFonts.push_back(ph_font);
+		}
+	}
+	PhysicalFont::createGFs(mfFonts);
+
 	GlyphTracerMessages messages;
 	unordered_set<const Font*> tracedFonts;  // collect unique fonts already traced
 	for (const auto &fontchar : usedCharsMap) {
@@ -22,9 +22,12 @@
 #include <config.h>
 #endif
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <exception>
 #include <set>
 #include <sstream>
+#include <thread>
 #include "CMap.hpp"
 #include "FileFinder.hpp"
 #include "FileSystem.hpp"
@@ -165,7 +168,7 @@ bool PhysicalFont::EXACT_BBOX = false;
 bool PhysicalFont::KEEP_TEMP_FILES = false;
 string PhysicalFont::CACHE_PATH;
 double PhysicalFont::METAFONT_MAG = 4;
-FontCache PhysicalFont::_cache;
+unordered_map<string, FontCache> PhysicalFont::_caches;
 
 
 unique_ptr<Font> PhysicalFont::create (const string &name, uint32_t checksum, double dsize, double ssize, PhysicalFont::Type type) {
@@ -340,11 +343,8 @@ int PhysicalFont::charIndexByName(const string &charname) const {
 bool PhysicalFont::getGlyph (int c, GraphicsPath<int32_t> &glyph, GFGlyphTracer::Callback *callback) const {
 	if (type() == Type::MF) {
 		const Glyph *cached_glyph=nullptr;
-		if (!CACHE_PATH.empty()) {
-			_cache.write(CACHE_PATH);
-			_cache.read(name(), CACHE_PATH);
-			cached_glyph = _cache.getGlyph(c);
-		}
+		if (!CACHE_PATH.empty())
+			cached_glyph = glyphCache().getGlyph(c);
 		if (cached_glyph) {
 			glyph = *cached_glyph;
 			return true;
@@ -359,7 +359,7 @@ bool PhysicalFont::getGlyph (int c, GraphicsPath<int32_t> &glyph, GFGlyphTracer:
 					tracer.executeChar(c);
 					glyph.closeOpenSubPaths();
 					if (!CACHE_PATH.empty())
-						_cache.setGlyph(c, glyph);
+						glyphCache().setGlyph(c, glyph);
 					return true;
 				}
 				catch (GFException &e) {
@@ -382,11 +382,12 @@ bool PhysicalFont::getGlyph (int c, GraphicsPath<int32_t> &glyph, GFGlyphTracer:
 }
 
 
+static set<string> failed_fonts;  ///< names of the fonts Metafont failed to create
+
 /** Creates a GF file for this font object.
  *  @param[out] gfname name of the generated GF font file
  *  @return true on success */
 bool PhysicalFont::createGF (string &gfname) const {
-	static set<string> failed_fonts;
 	if (failed_fonts.find(name()) == failed_fonts.end()) {
 		SignalHandler::instance().check();
 		gfname = FileSystem::tmpdir()+name()+".gf";
@@ -402,6 +403,80 @@ bool PhysicalFont::createGF (string &gfname) const {
 }
 
 
+/** Creates the GF files of several fonts. Metafont is run for several fonts at once.
+ *  Fonts whose GF file can't be created are reported, and createGF() doesn't try
+ *  again to create them.
+ *  @param[in] fonts the fonts whose GF files are needed */
+void PhysicalFont::createGFs (const vector<const PhysicalFont*> &fonts) {
+	vector<string> names;
+	for (const PhysicalFont *font : fonts) {
+		if (font->type() == Type::MF && failed_fonts.find(font->name()) == failed_fonts.end()
+			 && find(names.begin(), names.end(), font->name()) == names.end())
+			names.push_back(font->name());
+	}
+	if (names.size() < 2)
+		return;  // nothing to run concurrently
+	SignalHandler::instance().check();
+	string dir = FileSystem::tmpdir();
+	vector<char> ok(names.size());
+	vector<exception_ptr> errors(names.size());
+	atomic<size_t> next{0};
+	auto run = [&]() {
+		size_t i;
+		while ((i = next++) < names.size()) {
+			try {
+				MetafontWrapper mf(names[i], dir);
+				ok[i] = mf.make("ljfour", METAFONT_MAG) && mf.success();
+			}
+			catch (...) {
+				errors[i] = current_exception();
+			}
+		}
+	};
+	size_t numThreads = min(size_t(max(thread::hardware_concurrency(), 1u)), names.size());
+	vector<thread> threads;
+	for (size_t i=1; i < numThreads; i++)
+		threads.emplace_back(run);
+	run();
+	for (thread &t : threads)
+		t.join();
+	for (size_t i=0; i < names.size(); i++) {
+		if (errors[i])
+			rethrow_exception(errors[i]);
+		if (!ok[i]) {
+			failed_fonts.insert(names[i]);
+			Message::wstream(true) << "failed to create " << names[i] << ".gf\n";
+		}
+	}
+}
+
+
+/** Returns true if the glyph cache of this font lacks one of the given characters,
+ *  i.e. the GF file of the font is needed. */
+bool PhysicalFont::hasUncachedGlyphs (const set<int> &chars) const {
+	if (type() != Type::MF)
+		return false;
+	if (CACHE_PATH.empty())
+		return !chars.empty();
+	FontCache &cache = glyphCache();
+	for (int c : chars) {
+		if (!cache.getGlyph(c))
+			return true;
+	}
+	return false;
+}
+
+
+/** Returns the glyph cache of this font. The cache file is read only once, when the
+ *  cache is accessed for the first time, and the cache stays in memory so that fonts
+ *  used alternately on the pages don't require reloading their cache files. */
+FontCache& PhysicalFont::glyphCache () const {
+	FontCache &cache = _caches[name()];
+	cache.read(name(), CACHE_PATH);
+	return cache;
+}
+
+
 /** Traces all glyphs of the current font and stores them in the cache. If caching is disabled, nothing happens.
  *  @param[in] includeCached if true, glyphs already cached are traced again
  *  @param[in] cb optional callback methods called by the tracer
@@ -413,22 +488,58 @@ int PhysicalFont::traceAllGlyphs (bool includeCached, GFGlyphTracer::Callback *c
 			int fchar = metrics->firstChar();
 			int lchar = metrics->lastChar();
 			string gfname;
-			Glyph glyph;
 			if (createGF(gfname)) {
-				_cache.read(name(), CACHE_PATH);
-				double ds = getMetrics() ? getMetrics()->getDesignSize() : 1;
-				GFGlyphTracer tracer(gfname, unitsPerEm()/ds, cb);
-				tracer.setGlyph(glyph);
+				FontCache &cache = glyphCache();
+				vector<int> chars;
 				for (int i=fchar; i <= lchar; i++) {
-					if (includeCached || !_cache.getGlyph(i)) {
-						glyph.clear();
-						tracer.executeChar(i);
-						glyph.closeOpenSubPaths();
-						_cache.setGlyph(i, glyph);
-						++count;
+					if (includeCached || !cache.getGlyph(i))
+						chars.push_back(i);
+				}
+				// The glyphs are independent of each other: they are traced concurrently,
+				// each thread using a tracer of its own. The callback is not thread-safe,
+				// it's called afterwards in character order.
+				double upp = unitsPerEm()/metrics->getDesignSize();
+				vector<Glyph> glyphs(chars.size());
+				vector<char> traced(chars.size());
+				vector<exception_ptr> errors(chars.size());
+				atomic<size_t> next{0};
+				auto trace = [&]() {
+					GFGlyphTracer tracer(gfname, upp);
+					size_t i;
+					while ((i = next++) < chars.size()) {
+						try {
+							tracer.setGlyph(glyphs[i]);
+							traced[i] = tracer.executeChar(chars[i]);
+							glyphs[i].closeOpenSubPaths();
+						}
+						catch (...) {
+							errors[i] = current_exception();
+						}
+					}
+				};
+				size_t numThreads = min(size_t(max(thread::hardware_concurrency(), 1u)), chars.size());
+				vector<thread> threads;
+				for (size_t i=1; i < numThreads; i++)
+					threads.emplace_back(trace);
+				trace();
+				for (thread &t : threads)
+					t.join();
+				if (cb)
+					cb->setFont(gfname);
+				for (size_t i=0; i < chars.size(); i++) {
+					if (errors[i])
+						rethrow_exception(errors[i]);
+					if (cb) {
+						cb->beginChar(chars[i]);
+						if (traced[i])
+							cb->endChar(chars[i]);
+						else
+							cb->emptyChar(chars[i]);
 					}
+					cache.setGlyph(chars[i], glyphs[i]);
+					++count;
 				}
-				_cache.write(CACHE_PATH);
+				cache.write(CACHE_PATH);
 			}
 		}
 	}
@@ -498,8 +609,11 @@ PhysicalFontImpl::PhysicalFontImpl (const string &name, int fontindex, uint32_t
 
 
 PhysicalFontImpl::~PhysicalFontImpl () {
-	if (!CACHE_PATH.empty())
-		_cache.write(CACHE_PATH);
+	if (!CACHE_PATH.empty()) {
+		auto it = _caches.find(name());
+		if (it != _caches.end())
+			it->second.write(CACHE_PATH);
+	}
 	if (!KEEP_TEMP_FILES)
 		tidy();
 }
@@ -22,6 +22,7 @@
 #define FONT_HPP
 
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -135,6 +136,8 @@ class PhysicalFont : public virtual Font {
 		virtual int ascent () const;
 		virtual int descent () const;
 		virtual int traceAllGlyphs (bool includeCached, GFGlyphTracer::Callback *cb) const;
+		bool hasUncachedGlyphs (const std::set<int> &chars) const;
+		static void createGFs (const std::vector<const PhysicalFont*> &fonts);
 		virtual int collectCharMapIDs (std::vector<CharMapID> &charmapIDs) const;
 		virtual CharMapID getCharMapID () const =0;
 		virtual void setCharMapID (const CharMapID &id) {}
@@ -146,6 +149,7 @@ class PhysicalFont : public virtual Font {
 
 	protected:
 		bool createGF (std::string &gfname) const;
+		FontCache& glyphCache () const;
 
 	public:
 		static bool EXACT_BBOX;
@@ -154,7 +158,7 @@ class PhysicalFont : public virtual Font {
 		static double METAFONT_MAG;    ///< magnification factor for Metafont calls
 
 	protected:
-		static FontCache _cache;
+		static std::unordered_map<std::string, FontCache> _caches;  ///< glyph caches of all fonts used so far
 };
 
 
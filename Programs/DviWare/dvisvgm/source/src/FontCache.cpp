@@ -75,7 +75,7 @@ const Glyph* FontCache::getGlyph (int c) const {
 
 
 /** Writes the current cache data to a file (only if anything changed after
- *  the last call of read()).
+ *  the last call of read() or write()).
  *  @param[in] fontname name of current font
  *  @param[in] dir directory where the cache file should go
  *  @return true if writing was successful */
@@ -157,7 +157,7 @@ struct WriteActions : Glyph::IterationActions {
 
 
 /** Writes the current cache data to a stream (only if anything changed after
- *  the last call of read()).
+ *  the last call of read() or write()).
  *  @param[in] fontname name of current font
  *  @param[in] os output stream
  *  @return true if writing was successful */
@@ -185,6 +185,7 @@ bool FontCache::write (const string &fontname, ostream &os) const {
 	auto digest = hashfunc.digestBytes();
 	sw.writeBytes(digest);  // insert checksum
 	os.seekp(0, ios::end);
+	_changed = false;
 	return true;
 }
 
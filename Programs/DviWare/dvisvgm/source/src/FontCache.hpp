@@ -58,7 +58,7 @@ class FontCache {
 		static const uint8_t FORMAT_VERSION;
 		std::string _fontname;
 		std::map<int, Glyph> _glyphs;
-		bool _changed=false;
+		mutable bool _changed=false;
 };
 
 #endif
@@ -23,6 +23,7 @@
 #endif
 #include <cctype>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include "FileSystem.hpp"
 #include "FileFinder.hpp"
@@ -40,6 +41,9 @@
 
 using namespace std;
 
+/** Serializes file lookups and messages: Metafont can be run for several fonts at once. */
+static mutex mf_mutex;
+
 
 MetafontWrapper::MetafontWrapper (string fname, string dir)
 	: _fontname(std::move(fname)), _dir(std::move(dir))
@@ -59,6 +63,7 @@ MetafontWrapper::MetafontWrapper (string fname, string dir)
  *  @param[in] mag magnification factor
  *  @return true on success */
 bool MetafontWrapper::call (const string &mode, double mag) {
+	unique_lock<mutex> lock(mf_mutex);
 	if (!FileFinder::instance().lookup(_fontname+".mf"))
 		return false;     // mf file not available => no need to call the "slow" Metafont
 	FileSystem::remove(_fontname+".gf");
@@ -67,6 +72,7 @@ bool MetafontWrapper::call (const string &mode, double mag) {
 	MiKTeX::Core::ProcessOutput<50000> processOutput;
 	int exitCode;
 	Message::mstream(false, Message::MC_STATE) << "\nrunning Metafont for " << _fontname << '\n';
+	lock.unlock();
 	MiKTeX::Core::Process::Run(MiKTeX::Util::PathName(MIKTEX_MF_EXE), {
 	  "\\mode="s + mode + ";"s,
 	  "mode_setup;"s,
@@ -105,6 +111,7 @@ bool MetafontWrapper::call (const string &mode, double mag) {
 		"batchmode;"                     // don't halt on errors and don't print informational messages
 		"input " << _fontname << "\"";   // load font description
 	Message::mstream(false, Message::MC_STATE) << "\nrunning Metafont for " << _fontname << '\n';
+	lock.unlock();
 	Process mf_process(mfName, oss.str());
 	string mf_messages;
 	mf_process.run(_dir, &mf_messages);
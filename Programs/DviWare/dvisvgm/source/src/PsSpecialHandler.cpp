@@ -141,21 +141,24 @@ void PsSpecialHandler::enterBodySection () {
 }
 
 
-/** Move PS graphic position to current DVI location. */
-void PsSpecialHandler::moveToDVIPos () {
+/** Move PS graphic position to current DVI location.
+ *  @param[in] flush if false, the Ghostscript output isn't flushed because further code follows immediately */
+void PsSpecialHandler::moveToDVIPos (bool flush) {
 	if (_actions) {
 		const double x = _actions->getX();
 		const double y = _actions->getY();
 		ostringstream oss;
 		oss << '\n' << x << ' ' << y << " moveto ";
-		_psi.execute(oss.str());
+		_psi.execute(oss.str(), flush);
 		_currentpoint = DPair(x, y);
 	}
 }
 
 
 /** Executes a PS snippet and optionally synchronizes the DVI cursor position
- *  with the current PS point.
+ *  with the current PS point. The Ghostscript output is not flushed after the
+ *  snippet. This is left to the code sent next ("querypos" or "@endspecial")
+ *  in order to save a round trip per special.
  *  @param[in] is  stream to read the PS code from
  *  @param[in] updatePos if true, move the DVI drawing position to the current PS point */
 void PsSpecialHandler::executeAndSync (istream &is, bool updatePos) {
@@ -167,7 +170,7 @@ void PsSpecialHandler::executeAndSync (istream &is, bool updatePos) {
 		oss << '\n' << r << ' ' << g << ' ' << b << " setrgbcolor ";
 		_psi.execute(oss.str(), false);
 	}
-	_psi.execute(is);
+	_psi.execute(is, false);
 	if (updatePos) {
 		// retrieve current PS position (stored in _currentpoint)
 		_psi.execute("\nquerypos ");
@@ -219,8 +222,8 @@ bool PsSpecialHandler::process (const string &prefix, istream &is, SpecialAction
 
 	if (prefix == "\"" || prefix == "pst:") {
 		// read and execute literal PostScript code (isolated by a wrapping save/restore pair)
-		moveToDVIPos();
-		_psi.execute("\n@beginspecial @setspecial ");
+		moveToDVIPos(false);
+		_psi.execute("\n@beginspecial @setspecial ", false);
 		executeAndSync(is, false);
 		_psi.execute("\n@endspecial ");
 	}
@@ -259,13 +262,13 @@ bool PsSpecialHandler::process (const string &prefix, istream &is, SpecialAction
 				code += char(is.get());
 
 			if (code == "[begin]" || code == "[nobreak]") {
-				moveToDVIPos();
+				moveToDVIPos(false);
 				executeAndSync(is, true);
 			}
 			else {
 				// no move to DVI position here
 				if (code != "[end]") // PS array?
-					_psi.execute(code);
+					_psi.execute(code, false);
 				executeAndSync(is, true);
 			}
 		}
@@ -277,7 +280,7 @@ bool PsSpecialHandler::process (const string &prefix, istream &is, SpecialAction
 	else { // ps: ... or PST: ...
 		if (_actions)
 			_actions->finishLine();
-		moveToDVIPos();
+		moveToDVIPos(false);
 		StreamInputReader in(is);
 		if (in.check(" plotfile ")) { // ps: plotfile fname
 			string fname = in.getString();
@@ -112,7 +112,7 @@ class PsSpecialHandler : public SpecialHandler, protected PSActions {
 	protected:
 		void initialize ();
 		void initgraphics ();
-		void moveToDVIPos ();
+		void moveToDVIPos (bool flush=true);
 		void executeAndSync (std::istream &is, bool updatePos);
 		void processHeaderFile (const char *fname);
 		void imgfile (FileType type, const std::string &fname, const std::map<std::string,std::string> &attr);
@@ -61,7 +61,7 @@ class ZLibOutputBuffer : public std::streambuf {
 		 *  @return true if buffer is ready for writing */
 		bool open (std::streambuf *sink, ZLibCompressionFormat format, int zipLevel) {
 			if (sink) {
-				_inbuf.reserve(4096);
+				_inbuf.resize(4096);
 				_zbuf.resize(4096);
 				_zstream.zalloc = Z_NULL;
 				_zstream.zfree = Z_NULL;
@@ -71,6 +71,7 @@ class ZLibOutputBuffer : public std::streambuf {
 					throw ZLibException("failed to initialize deflate compression");
 				_sink = sink;
 				_opened = true;
+				resetPutArea();
 			}
 			return _opened;
 		}
@@ -81,14 +82,16 @@ class ZLibOutputBuffer : public std::streambuf {
 			close(true);
 		}
 
+		/** Called if the put area is full. Compresses the buffered data and
+		 *  adds the given character to the emptied put area. */
 		int_type overflow (int_type c) override {
 			if (c == traits_type::eof()) {
 				close();
 			}
-			else {
-				if (_inbuf.size() == _inbuf.capacity())
-					flush(Z_NO_FLUSH);
-				_inbuf.push_back(static_cast<unsigned char>(c));
+			else if (_opened) {
+				flush(Z_NO_FLUSH);
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
 			}
 			return c;
 		}
@@ -105,7 +108,7 @@ class ZLibOutputBuffer : public std::streambuf {
 		 *  @throws ZLibException if compression failed */
 		void flush (int flushmode) {
 			if (_opened) {
-				_zstream.avail_in = static_cast<uInt>(_inbuf.size());
+				_zstream.avail_in = static_cast<uInt>(pptr()-pbase());
 				_zstream.next_in = _inbuf.data();
 				do {
 					_zstream.avail_out = static_cast<uInt>(_zbuf.size());
@@ -118,8 +121,16 @@ class ZLibOutputBuffer : public std::streambuf {
 					auto have = _zbuf.size()-_zstream.avail_out;
 					_sink->sputn(reinterpret_cast<char*>(_zbuf.data()), have);
 				} while (_zstream.avail_out == 0);
+				resetPutArea();
 			}
-			_inbuf.clear();
+		}
+
+		/** Lets the put area span the entire input buffer. The characters written
+		 *  to the stream are then copied there directly without calling overflow()
+		 *  for each of them. */
+		void resetPutArea () {
+			char *buf = reinterpret_cast<char*>(_inbuf.data());
+			setp(buf, buf+_inbuf.size());
 		}
 
 		/** Closes the buffer so that further output doesn't reach the sink.
@@ -131,6 +142,7 @@ class ZLibOutputBuffer : public std::streambuf {
 				deflateEnd(&_zstream);
 				_sink = nullptr;
 				_opened = false;
+				setp(nullptr, nullptr);
 			}
 		}
 
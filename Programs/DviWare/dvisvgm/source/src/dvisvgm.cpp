@@ -21,10 +21,12 @@
 #include <config.h>
 #include <algorithm>
 #include <clipper.hpp>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <potracelib.h>
 #include <sstream>
+#include <thread>
 #include <vector>
 #include <zlib.h>
 #include "CommandLine.hpp"
@@ -39,9 +41,11 @@
 #include "HashFunction.hpp"
 #include "HyperlinkManager.hpp"
 #include "Message.hpp"
+#include "PageRanges.hpp"
 #include "PageSize.hpp"
 #include "PDFHandler.hpp"
 #include "PDFToSVG.hpp"
+#include "Process.hpp"
 #include "PSInterpreter.hpp"
 #include "PsSpecialHandler.hpp"
 #include "SignalHandler.hpp"
@@ -461,6 +465,100 @@ static void convert_file (size_t fnameIndex, const CommandLine &cmdline) {
 		}
 	}
 }
+
+
+/** Returns a page range string (e.g. "1-3,5") describing the given sorted page numbers. */
+static string page_range_string (vector<int>::const_iterator first, vector<int>::const_iterator last) {
+	ostringstream oss;
+	while (first != last) {
+		auto rangeEnd = first+1;
+		while (rangeEnd != last && *rangeEnd == *(rangeEnd-1)+1)
+			++rangeEnd;
+		if (oss.tellp() > 0)
+			oss << ',';
+		oss << *first;
+		if (*(rangeEnd-1) != *first)
+			oss << '-' << *(rangeEnd-1);
+		first = rangeEnd;
+	}
+	return oss.str();
+}
+
+
+/** Converts the selected pages of a DVI file in several dvisvgm processes running
+ *  in parallel. The pages are split into contiguous chunks, one per process, and each
+ *  process gets the original command-line arguments followed by --page and --jobs=1.
+ *  Since the names of the SVG files depend on the total number of pages of the DVI file
+ *  only, they are the same as in a sequential run. The messages of the processes are
+ *  printed in page order after all processes have finished.
+ *  @return false if the pages can't be converted in parallel */
+static bool convert_pages_in_parallel (int argc, char **argv, const CommandLine &cmdline) {
+	int numJobs = cmdline.jobsOpt.value();
+	if (numJobs < 2 || cmdline.epsOpt.given() || cmdline.pdfOpt.given() || cmdline.stdoutOpt.given()
+			|| cmdline.stdinOpt.given() || cmdline.singleDashGiven() || cmdline.filenames().empty())
+		return false;
+	if (cmdline.pageHashesOpt.given()) {
+		DVIToSVG::PAGE_HASH_SETTINGS.setParameters(cmdline.pageHashesOpt.value());
+		if (DVIToSVG::PAGE_HASH_SETTINGS.isSet(DVIToSVG::HashSettings::P_LIST))
+			return false;
+	}
+	string inputfile = ensure_suffix(cmdline.filenames()[0], "dvi");
+	SourceInput srcin(inputfile);
+	if (!srcin.getInputStream(true))
+		throw MessageException("can't open file '" + srcin.getMessageFileName() + "' for reading");
+	DVIReader dviReader(srcin.getInputStream());
+	PageRanges ranges;
+	if (!ranges.parse(cmdline.pageOpt.value(), dviReader.numberOfPages()))
+		return false;  // let the sequential conversion report the error
+	vector<int> pages;
+	for (const auto &range : ranges) {
+		for (int i=range.first; i <= range.second; i++)
+			pages.push_back(i);
+	}
+	numJobs = min(numJobs, int(pages.size()));
+	if (numJobs < 2)
+		return false;
+
+	double start_time = System::time();
+	string paramstr;
+	for (int i=1; i < argc; i++)
+		paramstr += string(" \"") + argv[i] + "\"";
+	struct Job {
+		string pages;
+		string messages;
+		bool success=false;
+		exception_ptr error;
+	};
+	vector<Job> jobs(numJobs);
+	vector<thread> threads;
+	for (int i=0; i < numJobs; i++) {
+		Job &job = jobs[i];
+		job.pages = page_range_string(pages.begin()+i*pages.size()/numJobs, pages.begin()+(i+1)*pages.size()/numJobs);
+		threads.emplace_back([&job, &paramstr, argv]() {
+			try {
+				Process process(argv[0], paramstr + " --page=" + job.pages + " --jobs=1");
+				job.success = process.run(&job.messages, Process::PF_STDERR);
+			}
+			catch (...) {
+				job.error = current_exception();
+			}
+		});
+	}
+	for (thread &t : threads)
+		t.join();
+	for (const Job &job : jobs) {
+		cerr << job.messages;
+		if (job.error)
+			rethrow_exception(job.error);
+		if (!job.success)
+			throw MessageException("conversion of page(s) " + job.pages + " failed");
+	}
+	pair<int,int> pageinfo(int(pages.size()), int(dviReader.numberOfPages()));
+	timer_message(start_time, &pageinfo);
+	return true;
+}
+
+
 #if defined(MIKTEX)
 int MIKTEXCEECALL Main(int argc, char **argv) {
 #else
@@ -502,9 +600,11 @@ int main (int argc, char *argv[]) {
 			throw MessageException("no input file given");
 
 		SignalHandler::instance().start();
-		size_t numFiles = cmdline.epsOpt.given() ? cmdline.filenames().size() : 1;
-		for (size_t i=0; i < numFiles; i++)
-			convert_file(i, cmdline);
+		if (!convert_pages_in_parallel(argc, argv, cmdline)) {
+			size_t numFiles = cmdline.epsOpt.given() ? cmdline.filenames().size() : 1;
+			for (size_t i=0; i < numFiles; i++)
+				convert_file(i, cmdline);
+		}
 	}
 	catch (DVIException &e) {
 		Message::estream() << "\nDVI error: " << e.what() << '\n';
@@ -1408,9 +1408,34 @@ void PDFDocumentView::paintEvent(QPaintEvent *event)
   if (_armedTool)
     _armedTool->paintEvent(event);
 
+  cancelOffscreenRendering();
+
   emit updated();
 }
 
+void PDFDocumentView::cancelOffscreenRendering()
+{
+  if (!_pdf_scene)
+    return;
+  QSharedPointer<Backend::Document> doc(_pdf_scene->document().toStrongRef());
+  if (!doc)
+    return;
+
+  // Pages within one viewport of the visible area are kept so that scrolling
+  // back and forth does not restart their rendering
+  QRectF keepRect = mapToScene(viewport()->rect()).boundingRect();
+  keepRect.adjust(-keepRect.width(), -keepRect.height(), keepRect.width(), keepRect.height());
+  QSet<const QObject *> keep;
+  foreach(QGraphicsItem * item, _pdf_scene->pages(QPolygonF(keepRect)))
+    keep.insert(static_cast<PDFPageGraphicsItem *>(item));
+
+  // Render requests are only made by PDFPageGraphicsItems (see
+  // PDFPageGraphicsItem::paint())
+  doc->processingThread().cancelRequests([&keep](const Backend::PageProcessingRequest & request) {
+    return (request.type() == Backend::PageProcessingRequest::PageRendering && request.listener && !keep.contains(request.listener));
+  });
+}
+
 void PDFDocumentView::keyPressEvent(QKeyEvent *event)
 {
   // FIXME: No moving while tools are active?
@@ -173,6 +173,9 @@ protected:
   void changeEvent(QEvent * event) override;
   void resizeEvent(QResizeEvent * event) override;
 
+  // Drop pending render requests of pages that are far from the viewport
+  void cancelOffscreenRendering();
+
   // Maybe this will become public later on
   // Ownership of tool is transferred to PDFDocumentView
   void registerTool(std::unique_ptr<DocumentTool::AbstractTool> tool);
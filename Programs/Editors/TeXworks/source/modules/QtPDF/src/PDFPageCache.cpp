@@ -87,18 +87,42 @@ void PDFPageCache::removeDocumentTiles(const Document *doc)
   }
 }
 
-void PDFPageCache::markOutdated(const Document * doc)
+void PDFPageCache::markOutdated(const Document * doc, const QSet<size_type> & unchangedPages /* = {} */)
 {
   QWriteLocker l(&_lock);
 
   const auto keys = m_cache.keys();
   for (const PDFPageTile & tile : keys) {
-    if (tile.doc == doc) {
+    if (tile.doc == doc && !unchangedPages.contains(tile.page_num)) {
       m_cache[tile]->status = OUTDATED;
     }
   }
 }
 
+void PDFPageCache::resetPlaceholder(const PDFPageTile & tile)
+{
+  QWriteLocker l(&_lock);
+
+  CachedTileData * data = m_cache.object(tile);
+  if (data && data->status == PLACEHOLDER) {
+    data->status = OUTDATED;
+  }
+}
+
+QSet<PDFPageCache::size_type> PDFPageCache::cachedPages(const Document * doc) const
+{
+  QReadLocker l(&_lock);
+
+  QSet<size_type> retVal;
+  const auto keys = m_cache.keys();
+  for (const PDFPageTile & tile : keys) {
+    if (tile.doc == doc) {
+      retVal.insert(tile.page_num);
+    }
+  }
+  return retVal;
+}
+
 } // namespace Backend
 
 } // namespace QtPDF
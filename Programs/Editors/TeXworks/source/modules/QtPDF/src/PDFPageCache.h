@@ -20,6 +20,7 @@
 #include <QCache>
 #include <QMap>
 #include <QReadWriteLock>
+#include <QSet>
 #include <QSharedPointer>
 #include <QWriteLocker>
 
@@ -53,8 +54,13 @@ public:
 
   void clear() { QWriteLocker l(&_lock); m_cache.clear(); }
   void removeDocumentTiles(const Document *doc);
-  // Mark all tiles outdated
-  void markOutdated(const Document *doc);
+  // Mark all tiles outdated, except those of the pages in `unchangedPages`
+  void markOutdated(const Document *doc, const QSet<size_type> & unchangedPages = {});
+  // Returns the indices of the pages of `doc` that have tiles in the cache
+  QSet<size_type> cachedPages(const Document *doc) const;
+  // Mark the tile outdated if it is a placeholder, i.e., if it is not going to
+  // be rendered after all
+  void resetPlaceholder(const PDFPageTile & tile);
 
   QList<PDFPageTile> tiles() const { QReadLocker locker(&_lock); return m_cache.keys(); }
 protected:
@@ -166,6 +166,21 @@ void PDFPageProcessingThread::clearWorkStack()
   _mutex.unlock();
 }
 
+void PDFPageProcessingThread::cancelRequests(const std::function<bool(const PageProcessingRequest &)> & predicate)
+{
+  QMutexLocker locker(&_mutex);
+
+  for (int i = _workStack.size() - 1; i >= 0; --i) {
+    PageProcessingRequest * workItem = _workStack[i];
+    if (!workItem || !predicate(*workItem))
+      continue;
+    Q_ASSERT(workItem->thread() == QCoreApplication::instance()->thread());
+    workItem->cancel();
+    workItem->deleteLater();
+    _workStack.remove(i);
+  }
+}
+
 
 // Asynchronous Page Operations
 // ----------------------------
@@ -206,19 +221,23 @@ const QEvent::Type PDFLinksLoadedEvent::LinksLoadedEvent = static_cast<QEvent::T
 
 bool PageProcessingRenderPageRequest::execute()
 {
-  // TODO: Aborting renders doesn't really work right now---the backend knows
-  // nothing about the PDF scenes.
-  //
-  // Idea: Perhaps allow page render requests to provide a pointer to a function
-  // that returns a `bool` value indicating if the request is still valid? Then
-  // the `PDFPageGraphicsItem` could have a function that indicates if the item
-  // is anywhere near a viewport.
+  // NB: Requests for pages that have been scrolled out of view are canceled by
+  // the PDFDocumentView (see PDFDocumentView::cancelOffscreenRendering())
   QImage rendered_page = page->renderToImage(xres, yres, render_box, cache);
   QCoreApplication::postEvent(listener, new PDFPageRenderedEvent(xres, yres, render_box, rendered_page));
 
   return true;
 }
 
+void PageProcessingRenderPageRequest::cancel()
+{
+  // The tile was marked as placeholder when this request was made; without
+  // resetting it, it would never be requested again
+  Document * doc = page->document();
+  if (cache && doc)
+    doc->pageCache().resetPlaceholder(PDFPageTile(xres, yres, render_box, doc, page->pageNum()));
+}
+
 bool PageProcessingLoadLinksRequest::execute()
 {
   QCoreApplication::postEvent(listener, new PDFLinksLoadedEvent(page->loadLinks()));
@@ -25,6 +25,8 @@
 #include <QThread>
 #include <QWaitCondition>
 
+#include <functional>
+
 namespace QtPDF {
 namespace Backend {
 
@@ -42,6 +44,8 @@ protected:
   // Should perform whatever processing it is designed to do
   // Returns true if finished successfully, false otherwise
   virtual bool execute() = 0;
+  // Called instead of execute() if the request is canceled
+  virtual void cancel() { }
 
 public:
   enum Type { PageRendering, LoadLinks };
@@ -79,6 +83,7 @@ public:
 
 protected:
   bool execute() override;
+  void cancel() override;
 
   double xres, yres;
   QRect render_box;
@@ -169,6 +174,10 @@ public:
   // finish. However, that lock is held by the caller of clearWorkStack().
   void clearWorkStack();
 
+  // drop the remaining processing requests for which `predicate` returns
+  // true; unlike clearWorkStack(), this does not wait for the current item
+  void cancelRequests(const std::function<bool(const PageProcessingRequest &)> & predicate);
+
 protected:
   void run() override;
 
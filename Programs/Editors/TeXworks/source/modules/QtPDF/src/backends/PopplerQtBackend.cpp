@@ -16,6 +16,7 @@
 #include "PDFBackend.h"
 
 #include <QBitArray>
+#include <QCryptographicHash>
 
 #if !defined(MIKTEX)
 #if defined(HAVE_POPPLER_XPDF_HEADERS) && defined(Q_OS_DARWIN)
@@ -194,15 +195,79 @@ void Document::reload()
 
   QWriteLocker docLocker(_docLock.data());
 
+  // Only pages that have tiles in the cache are worth checking for changes;
+  // all others need to be rendered anyway
+  const QSet<size_type> cachedPages = _pageCache.cachedPages(this);
+  for (const size_type i : cachedPages) {
+    if (!_pageDigests.contains(i))
+      _pageDigests.insert(i, pageDigest(i));
+  }
+
   clearPages();
-  _pageCache.markOutdated(this);
 
   load(_fileName);
 
+  QSet<size_type> unchangedPages;
+  QHash<size_type, QByteArray> newDigests;
+  for (const size_type i : cachedPages) {
+    const QByteArray digest = pageDigest(i);
+    if (digest.isEmpty())
+      continue;
+    if (_pageDigests.value(i) == digest)
+      unchangedPages.insert(i);
+    newDigests.insert(i, digest);
+  }
+  _pageDigests = newDigests;
+  _pageCache.markOutdated(this, unchangedPages);
+
   // TODO: possibly unlock the new document again if it was previously unlocked
   // and the password is still the same
 }
 
+QByteArray Document::pageDigest(size_type at) const
+{
+  using poppler_size_type = decltype(_poppler_doc->numPages());
+
+  if (!_poppler_doc || _isLocked() || at < 0 || at >= _poppler_doc->numPages())
+    return {};
+
+  QMutexLocker l(_poppler_docLock);
+  std::unique_ptr<::Poppler::Page> page(_poppler_doc->page(static_cast<poppler_size_type>(at)));
+  if (!page)
+    return {};
+
+  // Poppler does not give access to the content streams, so the page is
+  // identified by its geometry, its text (with positions), and a low
+  // resolution rendering (which also covers graphics and images)
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  const QSizeF size = page->pageSizeF();
+  hash.addData(QByteArray::number(size.width()) + ' ' + QByteArray::number(size.height()) + ' ' + QByteArray::number(static_cast<int>(page->orientation())));
+  const std::vector< std::unique_ptr<::Poppler::TextBox> > textBoxes = [&]() {
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    const QList<::Poppler::TextBox*> popplerList = page->textList();
+    std::vector< std::unique_ptr<::Poppler::TextBox> > rv;
+    rv.reserve(static_cast<decltype(rv)::size_type>(popplerList.size()));
+    for (::Poppler::TextBox* box : popplerList) {
+      rv.emplace_back(box);
+    }
+    return rv;
+#else
+    return page->textList();
+#endif
+  }();
+  for (const std::unique_ptr<::Poppler::TextBox> & box : textBoxes) {
+    if (!box)
+      continue;
+    const QRectF r = box->boundingBox();
+    hash.addData(box->text().toUtf8());
+    hash.addData(QByteArray::number(r.x()) + ' ' + QByteArray::number(r.y()) + ' ' + QByteArray::number(r.width()) + ' ' + QByteArray::number(r.height()));
+  }
+  const QImage thumbnail = page->renderToImage(18, 18);
+  for (int y = 0; y < thumbnail.height(); ++y)
+    hash.addData(reinterpret_cast<const char *>(thumbnail.constScanLine(y)), static_cast<int>(thumbnail.bytesPerLine()));
+  return hash.result();
+}
+
 void Document::parseDocument()
 {
   QWriteLocker docLocker(_docLock.data());
@@ -59,6 +59,9 @@ protected:
   // result.
   mutable QList<PDFFontInfo> _fonts;
   mutable bool _fontsLoaded{false};
+  // Digests of the pages that have been rendered; they are used to keep the
+  // rendered tiles of pages that did not change when reloading
+  QHash<size_type, QByteArray> _pageDigests;
 
   bool load(const QString & filename);
 
@@ -88,6 +91,7 @@ public:
   void setPaperColor(const QColor & color) override;
 private:
   void parseDocument();
+  QByteArray pageDigest(size_type at) const;
 };
 
 
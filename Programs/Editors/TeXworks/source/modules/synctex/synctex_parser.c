@@ -532,6 +532,9 @@ DEFINE_SYNCTEX_TREE_GETSETRESET(target)
  */
 #   define SYNCTEX_BUFFER_MIN_SIZE 32
 #   define SYNCTEX_BUFFER_SIZE 32768
+/*  zlib reads the file in 8KB chunks by default, which makes large
+ *  .synctex.gz files slow to parse. Give it a bigger input buffer. */
+#   define SYNCTEX_GZ_BUFFER_SIZE 262144
 
 #if SYNCTEX_BUFFER_SIZE >= UINT_MAX
 #   error BAD BUFFER SIZE(1)
@@ -678,6 +681,10 @@ static synctex_open_s __synctex_open_v2(const char * output, synctex_io_mode_t i
             quoteless_synctex_name = NULL;
         }
     }
+#   if defined(ZLIB_VERNUM) && ZLIB_VERNUM >= 0x1240
+    /*  Must be called before the first read. */
+    gzbuffer(open.file,SYNCTEX_GZ_BUFFER_SIZE);
+#   endif
     /*  The operation is successful, return the arguments by value.    */
     open.status = SYNCTEX_STATUS_OK;
     return open;
@@ -36,6 +36,7 @@
 #endif
 #include <QDockWidget>
 #include <QFileDialog>
+#include <QFutureWatcher>
 #include <QInputDialog>
 #include <QLabel>
 #include <QList>
@@ -53,6 +54,7 @@
 #include <QToolTip>
 #include <QUrl>
 #include <QVector>
+#include <QtConcurrent>
 #include <cmath>
 
 
@@ -156,6 +158,7 @@ void PDFDocumentWindow::init()
 	connect(pdfWidget, &QtPDF::PDFDocumentWidget::changedPage, this, &PDFDocumentWindow::updateStatusBar);
 	connect(pdfWidget, &QtPDF::PDFDocumentWidget::changedZoom, this, &PDFDocumentWindow::updateStatusBar);
 	connect(pdfWidget, &QtPDF::PDFDocumentWidget::changedDocument, this, &PDFDocumentWindow::changedDocument);
+	connect(&_syncWatcher, &QFutureWatcher< std::shared_ptr<TWSyncTeXSynchronizer> >::finished, this, &PDFDocumentWindow::syncDataLoaded);
 	// NB: Using a queued connection ensures the signal has to pass through the
 	// event loop. If searching effectively blocks the GUI for a while (e.g., by
 	// spawning too many threads), this ensures that the highlighting processing
@@ -554,14 +557,30 @@ void PDFDocumentWindow::reload()
 
 void PDFDocumentWindow::loadSyncData()
 {
-	_synchronizer = std::unique_ptr<TWSyncTeXSynchronizer>(new TWSyncTeXSynchronizer(curFile, [](const QString & filename) {
-			const TeXDocumentWindow * win = TeXDocumentWindow::openDocument(filename, false, false);
-			return (win ? win->textDoc() : nullptr);
-		}, [](const QString & filename) {
-			PDFDocumentWindow * pdfWin = PDFDocumentWindow::findDocument(filename);
-			return (pdfWin && pdfWin->widget() ? pdfWin->widget()->document().toStrongRef() : QSharedPointer<QtPDF::Backend::Document>());
-		}
-	));
+	// Parsing the .synctex(.gz) file can take a while for large documents, so
+	// it is done in a worker thread; the loaders are only called (in the GUI
+	// thread) when synchronizing
+	const QString pdfFile = curFile;
+	_syncWatcher.setFuture(QtConcurrent::run([pdfFile]() {
+		return std::make_shared<TWSyncTeXSynchronizer>(pdfFile, [](const QString & filename) {
+				const TeXDocumentWindow * win = TeXDocumentWindow::openDocument(filename, false, false);
+				return (win ? win->textDoc() : nullptr);
+			}, [](const QString & filename) {
+				PDFDocumentWindow * pdfWin = PDFDocumentWindow::findDocument(filename);
+				return (pdfWin && pdfWin->widget() ? pdfWin->widget()->document().toStrongRef() : QSharedPointer<QtPDF::Backend::Document>());
+			}
+		);
+	}));
+}
+
+void PDFDocumentWindow::syncDataLoaded()
+{
+	// A newer request may already be running (e.g., if the file was reloaded
+	// twice in quick succession); its result will follow
+	if (_syncWatcher.isRunning() || _syncWatcher.isCanceled())
+		return;
+	_synchronizer = _syncWatcher.result();
+	_syncWatcher.setFuture(QFuture< std::shared_ptr<TWSyncTeXSynchronizer> >());
 	if (!_synchronizer)
 		statusBar()->showMessage(tr("Error initializing SyncTeX"), kStatusMessageDuration);
 	else if (!_synchronizer->isValid())
@@ -570,6 +589,16 @@ void PDFDocumentWindow::loadSyncData()
 		statusBar()->showMessage(tr("SyncTeX: \"%1\"").arg(_synchronizer->syncTeXFilename()), kStatusMessageDuration);
 }
 
+void PDFDocumentWindow::waitForSyncData()
+{
+	// Synchronizing must not use the data of the previous run; a default
+	// constructed (i.e., adopted) future counts as canceled
+	if (!_syncWatcher.isCanceled()) {
+		_syncWatcher.waitForFinished();
+		syncDataLoaded();
+	}
+}
+
 void PDFDocumentWindow::syncClick(size_type pageIndex, const QPointF& pos)
 {
 	Tw::Settings settings;
@@ -591,6 +620,7 @@ void PDFDocumentWindow::syncClick(size_type pageIndex, const QPointF& pos)
 
 void PDFDocumentWindow::syncRange(const size_type pageIndex, const QPointF & start, const QPointF & end, const TWSynchronizer::Resolution resolution)
 {
+	waitForSyncData();
 	if (!_synchronizer)
 		return;
 
@@ -678,6 +708,7 @@ void PDFDocumentWindow::syncRange(const size_type pageIndex, const QPointF & sta
 
 void PDFDocumentWindow::syncFromSource(const QString& sourceFile, int lineNo, int col, bool activatePreview)
 {
+	waitForSyncData();
 	if (!_synchronizer)
 		return;
 
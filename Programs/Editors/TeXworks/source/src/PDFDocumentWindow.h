@@ -32,6 +32,7 @@
 
 #include <QButtonGroup>
 #include <QCursor>
+#include <QFutureWatcher>
 #include <QImage>
 #include <QList>
 #include <QMouseEvent>
@@ -150,6 +151,8 @@ private:
 	void loadFile(const QString &fileName);
 	void setCurrentFile(const QString &fileName);
 	void loadSyncData();
+	void syncDataLoaded();
+	void waitForSyncData();
 	void saveRecentFileInfo();
 
 	QString getMainSourceFilename() const;
@@ -180,7 +183,8 @@ private:
 
 	static QList<PDFDocumentWindow*> docList;
 
-	std::unique_ptr<TWSyncTeXSynchronizer> _synchronizer;
+	std::shared_ptr<TWSyncTeXSynchronizer> _synchronizer;
+	QFutureWatcher< std::shared_ptr<TWSyncTeXSynchronizer> > _syncWatcher;
 #if defined(MIKTEX)
         QAction* actionAbout_MiKTeX;
 #endif
@@ -71,6 +71,11 @@ void TeXHighlighter::highlightBlock(const QString &text)
 	QString::size_type charPos = 0;
 	if (highlightIndex >= 0 && highlightIndex < syntaxRules->count()) {
 		QList<HighlightingRule>& highlightingRules = (*syntaxRules)[highlightIndex].rules;
+		// The next match of each rule. A rule only needs to be matched again
+		// once the character index has moved past the start of its match (if
+		// a rule did not match at all, it won't match further on, either).
+		QVector<QRegularExpressionMatch> matches(highlightingRules.size());
+		QVector<bool> matched(highlightingRules.size(), false);
 		// Go through the whole text...
 		while (charPos < text.length()) {
 			// ... and find the highlight pattern that matches closest to the
@@ -80,7 +85,11 @@ void TeXHighlighter::highlightBlock(const QString &text)
 			QRegularExpressionMatch firstMatch;
 			for (int i = 0; i < highlightingRules.size(); ++i) {
 				HighlightingRule &rule = highlightingRules[i];
-				QRegularExpressionMatch m = rule.pattern.match(text, charPos);
+				if (!matched[i] || (matches[i].hasMatch() && matches[i].capturedStart() < charPos)) {
+					matches[i] = rule.pattern.match(text, charPos);
+					matched[i] = true;
+				}
+				const QRegularExpressionMatch & m = matches[i];
 				if (m.capturedStart() >= 0 && m.capturedStart() < firstIndex) {
 					firstIndex = m.capturedStart();
 					firstMatch = m;
@@ -109,13 +118,20 @@ void TeXHighlighter::highlightBlock(const QString &text)
 		texDoc->removeTags(currentBlock().position(), currentBlock().length());
 		if (isTagging) {
 			QString::size_type index = 0;
+			// See above
+			QVector<QRegularExpressionMatch> matches(tagPatterns->count());
+			QVector<bool> matched(tagPatterns->count(), false);
 			while (index < text.length()) {
 				QString::size_type firstIndex{std::numeric_limits<QString::size_type>::max()}, len{0};
 				TagPattern* firstPatt = nullptr;
 				QRegularExpressionMatch firstMatch;
 				for (int i = 0; i < tagPatterns->count(); ++i) {
 					TagPattern& patt = (*tagPatterns)[i];
-					QRegularExpressionMatch m = patt.pattern.match(text, index);
+					if (!matched[i] || (matches[i].hasMatch() && matches[i].capturedStart() < index)) {
+						matches[i] = patt.pattern.match(text, index);
+						matched[i] = true;
+					}
+					const QRegularExpressionMatch & m = matches[i];
 					if (m.capturedStart() >= 0 && m.capturedStart() < firstIndex) {
 						firstIndex = m.capturedStart();
 						firstMatch = m;
@@ -243,8 +259,11 @@ void TeXHighlighter::loadPatterns()
 				else
 					rule.spellCheck = false;
 				rule.pattern = QRegularExpression(parts[2]);
-				if (rule.pattern.isValid())
+				if (rule.pattern.isValid()) {
+					// compile now rather than on the first keystroke
+					rule.pattern.optimize();
 					spec.rules.append(rule);
+				}
 			}
 			if (spec.rules.count() > 0)
 				syntaxRules->append(spec);
@@ -271,8 +290,10 @@ void TeXHighlighter::loadPatterns()
 				patt.level = parts[0].toUInt(&ok);
 				if (ok) {
 					patt.pattern = QRegularExpression(parts[1]);
-					if (patt.pattern.isValid())
+					if (patt.pattern.isValid()) {
+						patt.pattern.optimize();
 						tagPatterns->append(patt);
+					}
 				}
 			}
 		}
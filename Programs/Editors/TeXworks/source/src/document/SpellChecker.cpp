@@ -169,7 +169,12 @@ SpellChecker::Dictionary::~Dictionary()
 
 bool SpellChecker::Dictionary::isWordCorrect(const QString & word) const
 {
-	return (Hunspell_spell(_hunhandle, _codec->fromUnicode(word).data()) != 0);
+	QHash<QString, bool>::const_iterator it = _verdicts.constFind(word);
+	if (it != _verdicts.constEnd())
+		return it.value();
+	bool correct = (Hunspell_spell(_hunhandle, _codec->fromUnicode(word).data()) != 0);
+	_verdicts.insert(word, correct);
+	return correct;
 }
 
 QList<QString> SpellChecker::Dictionary::suggestionsForWord(const QString & word) const
@@ -191,6 +196,7 @@ void SpellChecker::Dictionary::ignoreWord(const QString & word)
 {
 	// note that this is not persistent after quitting TW
 	Hunspell_add(_hunhandle, _codec->fromUnicode(word).data());
+	_verdicts.insert(word, true);
 }
 
 } // namespace Document
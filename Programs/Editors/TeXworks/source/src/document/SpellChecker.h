@@ -45,6 +45,9 @@ public:
 		QString _language;
 		Hunhandle * _hunhandle;
 		QTextCodec * _codec;
+		// Hunspell's verdicts; a document contains far fewer distinct words
+		// than words, and every edit of a line checks all of its words again
+		mutable QHash<QString, bool> _verdicts;
 
 		Dictionary(const QString & language, Hunhandle * hunhandle);
 	public:
@@ -0,0 +1,143 @@
+/**
+ * @file miktex/otftotfm.cpp
+ * @author Christian Schenk
+ * @brief MiKTeX otftotfm batch mode
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cstdio>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+#include "otftotfm.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+struct BatchJob
+{
+  vector<string> options;
+  string output;
+  string errorMessage;
+  bool ok = false;
+};
+
+static vector<BatchJob> ReadBatchFile(const char* batchFileName)
+{
+  vector<BatchJob> batchJobs;
+  ifstream stream(batchFileName);
+  if (!stream)
+  {
+    MIKTEX_FATAL_ERROR_2("The batch file could not be opened.", "path", batchFileName);
+  }
+  string line;
+  while (getline(stream, line))
+  {
+    istringstream words(line);
+    BatchJob batchJob;
+    string word;
+    while (words >> word && word[0] != '#')
+    {
+      batchJob.options.push_back(word);
+    }
+    if (!batchJob.options.empty())
+    {
+      batchJobs.push_back(batchJob);
+    }
+  }
+  return batchJobs;
+}
+
+static void RunJob(const PathName& otftotfmExe, int argc, char** argv, BatchJob& batchJob)
+{
+  ProcessStartInfo startInfo(otftotfmExe);
+  startInfo.Arguments.assign(argv, argv + argc);
+  startInfo.Arguments.insert(startInfo.Arguments.end(), batchJob.options.begin(), batchJob.options.end());
+  startInfo.Arguments.push_back("--no-batch");
+  // stdout gets the map lines; messages go to stderr as usual
+  startInfo.RedirectStandardOutput = true;
+  unique_ptr<Process> process = Process::Start(startInfo);
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), process->get_StandardOutput())) > 0)
+  {
+    batchJob.output.append(buf, n);
+  }
+  process->WaitForExit();
+  batchJob.ok = process->get_ExitStatus() == ProcessExitStatus::Exited && process->get_ExitCode() == 0;
+  process->Close();
+}
+
+int miktex_otftotfm_run_batch(int argc, char** argv, const char* batchFileName, int jobs)
+{
+  vector<BatchJob> batchJobs;
+  PathName otftotfmExe;
+  try
+  {
+    batchJobs = ReadBatchFile(batchFileName);
+    otftotfmExe = MIKTEX_SESSION()->GetMyProgramFile(true);
+  }
+  catch (const MiKTeXException& ex)
+  {
+    fprintf(stderr, "otftotfm: %s\n", ex.GetErrorMessage().c_str());
+    return 1;
+  }
+  atomic_size_t next(0);
+  auto worker = [&]()
+  {
+    size_t idx;
+    while ((idx = next++) < batchJobs.size())
+    {
+      try
+      {
+        RunJob(otftotfmExe, argc, argv, batchJobs[idx]);
+      }
+      catch (const MiKTeXException& ex)
+      {
+        batchJobs[idx].errorMessage = ex.GetErrorMessage();
+      }
+    }
+  };
+  vector<future<void>> workers;
+  for (size_t n = 0; n < min(static_cast<size_t>(max(jobs, 1)), batchJobs.size()); ++n)
+  {
+    workers.push_back(async(launch::async, worker));
+  }
+  for (future<void>& f : workers)
+  {
+    f.get();
+  }
+  int exitCode = 0;
+  for (const BatchJob& batchJob : batchJobs)
+  {
+    fputs(batchJob.output.c_str(), stdout);
+    if (!batchJob.errorMessage.empty())
+    {
+      fprintf(stderr, "otftotfm: %s\n", batchJob.errorMessage.c_str());
+    }
+    if (!batchJob.ok)
+    {
+      exitCode = 1;
+    }
+  }
+  return exitCode;
+}
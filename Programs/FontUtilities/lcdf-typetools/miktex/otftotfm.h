@@ -0,0 +1,20 @@
+/**
+ * @file miktex/otftotfm.h
+ * @author Christian Schenk
+ * @brief MiKTeX otftotfm batch mode
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+/// Runs the jobs of a batch file.
+/// Each line of the batch file holds the options of one job; they are
+/// appended to the command-line options. Up to `jobs` jobs run at a time; their
+/// standard output is written in the order of the batch file.
+/// @return Returns the exit code.
+int miktex_otftotfm_run_batch(int argc, char** argv, const char* batchFileName, int jobs);
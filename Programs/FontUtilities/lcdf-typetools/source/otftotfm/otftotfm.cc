@@ -16,6 +16,7 @@
 #endif
 #if defined(MIKTEX)
 #include <miktex/Core/c/api.h>
+#include "miktex/otftotfm.h"
 #endif
 #ifdef WIN32
 # define _USE_MATH_DEFINES
@@ -129,6 +130,10 @@ using namespace Efont;
 #define TFM_OPT                 362
 #define MAP_FILE_OPT            363
 #define OUTPUT_ENCODING_OPT     364
+#if defined(MIKTEX)
+#define BATCH_OPT               370
+#define JOBS_OPT                371
+#endif
 
 #define DIR_OPTS                380
 #define ENCODING_DIR_OPT        (DIR_OPTS + O_ENCODING)
@@ -235,6 +240,10 @@ static Clp_Option options[] = {
     { "force", 0, FORCE_OPT, 0, Clp_Negate },
     { "verbose", 'V', VERBOSE_OPT, 0, Clp_Negate },
     { "kpathsea-debug", 0, KPATHSEA_DEBUG_OPT, Clp_ValInt, 0 },
+#if defined(MIKTEX)
+    { "batch", 0, BATCH_OPT, Clp_ValString, Clp_Negate },
+    { "jobs", 0, JOBS_OPT, Clp_ValInt, 0 },
+#endif
 
     { "help", 'h', HELP_OPT, 0, 0 },
     { "version", 0, VERSION_OPT, 0, 0 },
@@ -302,6 +311,10 @@ bool verbose = false;
 bool no_create = false;
 bool quiet = false;
 bool force = false;
+#if defined(MIKTEX)
+static String miktex_batch_file;
+static int miktex_jobs = 1;
+#endif
 
 static String otf_data;
 
@@ -412,6 +425,11 @@ Other options:\n\
 #if HAVE_KPATHSEA
 "      --kpathsea-debug=MASK    Set path searching debug flags to MASK.\n"
 #endif
+#if defined(MIKTEX)
+"      --batch=FILE             Run a job for each line of FILE; a line holds\n\
+                               the options of the job.\n\
+      --jobs=N                 Run up to N batch jobs at a time [1].\n"
+#endif
 "  -h, --help                   Print this message and exit.\n\
   -q, --quiet                  Do not generate any error messages.\n\
       --version                Print version number and exit.\n\
@@ -2251,6 +2269,16 @@ main(int argc, char *argv[])
             force = !clp->negated;
             break;
 
+#if defined(MIKTEX)
+          case BATCH_OPT:
+            miktex_batch_file = (clp->negated ? String() : String(clp->vstr));
+            break;
+
+          case JOBS_OPT:
+            miktex_jobs = clp->val.i;
+            break;
+#endif
+
           case KPATHSEA_DEBUG_OPT:
 #if HAVE_KPATHSEA
             kpsei_set_debug_flags(clp->val.u);
@@ -2322,6 +2350,14 @@ particular purpose.\n");
     // set up file names
     if (!input_file)
         usage_error(errh, "no font filename provided");
+#if defined(MIKTEX)
+    // the font's map file and the TDS are updated without locking, so
+    // automatic mode jobs run one after the other
+    if (miktex_batch_file) {
+        Clp_DeleteParser(clp);
+        return miktex_otftotfm_run_batch(argc, argv, miktex_batch_file.c_str(), automatic ? 1 : miktex_jobs);
+    }
+#endif
     if (encoding_file == "-")
         encoding_file = "";
 
@@ -72,7 +72,7 @@ strip_equal(char *s, char *os, char *p)
   Convert a TrueType font to TeX's PK format.\n\
 \n\
 -q                  suppress informational output\n\
--n                  only use `.pk' as extension\n\
+-n                  only use `.pk' as extension (one <dpi> only)\n\
 -t                  test for <font> (returns 0 on success)\n\
 --help              print this message and exit\n\
 --version           print version number and exit\n\
@@ -83,7 +83,7 @@ Report bugs to " PACKAGE_BUGREPORT ".\n\
 static void
 usage(void)
 {
-  fputs("Usage: ttf2pk [-q] [-n] <font> <dpi>\n", stdout);
+  fputs("Usage: ttf2pk [-q] [-n] <font> <dpi> [<dpi>...]\n", stdout);
   fputs("       ttf2pk -t [-q] <font>\n", stdout);
   fputs(USAGE, stdout);
   exit(0);
@@ -311,7 +311,9 @@ main(int argc, char** argv)
   char *pk_filename, *tfm_filename, *enc_filename;
   char *map_filename = NULL;
   char *real_ttfname, *real_map_filename;
-  int dpi = 0, ptsize;
+  int *dpis = NULL;
+  int n_dpis = 0, k;
+  int ptsize;
   Boolean hinting = True;
   Boolean quiet = False;
   Boolean no_dpi = False;
@@ -360,16 +362,27 @@ main(int argc, char** argv)
       oops("Need exactly one parameter for `-t' option.\n"
            "Try `ttf2pk --help' for more information.");
   }
-  else if (argc != 3)
-    oops("Need at most two arguments.\n"
+  else if (argc < 3)
+    oops("Need at least two arguments.\n"
          "Try `ttf2pk --help' for more information.");
 
   if (!quiet)
     printf("This is %s\n", ident);
 
+  /*
+   *   Several resolutions are rendered from the same opened font, so that
+   *   the map files, the TFM file, and the font are read only once.
+   */
   if (!testing)
-    if ((dpi = atoi(argv[2])) <= 50)
-      oops("dpi value must be larger than 50.");
+  {
+    n_dpis = argc - 2;
+    if (no_dpi && n_dpis > 1)
+      oops("`-n' cannot be used with more than one dpi value.");
+    dpis = (int *)mymalloc(n_dpis * sizeof (int));
+    for (k = 0; k < n_dpis; k++)
+      if ((dpis[k] = atoi(argv[k + 2])) <= 50)
+        oops("dpi value must be larger than 50.");
+  }
 
   fontname = argv[1];
   fontname_len = strlen(fontname);
@@ -634,18 +647,11 @@ font_found:
   tfm_filename = newstring(fontname);
   TFMopen(&tfm_filename);
 
-  pk_filename = mymalloc(fontname_len + 10);
-  if (no_dpi)
-    sprintf(pk_filename, "%s.pk", fontname);
-  else
-    sprintf(pk_filename, "%s.%dpk", fontname, dpi);
-  PKopen(pk_filename, fontname, dpi);
-
   font.ttfname = newstring(font.ttfname);
   real_ttfname = TeX_search_ttf_file(&(font.ttfname));
   if (!real_ttfname)
     oops("Cannot find `%s'.", font.ttfname);
-  TTFopen(real_ttfname, &font, dpi, ptsize, quiet);
+  TTFopen(real_ttfname, &font, dpis[0], ptsize, quiet);
 
   enc_filename = newstring(enc_filename);
   enc = readencoding(&enc_filename, &font, True);
@@ -688,35 +694,49 @@ font_found:
       enc = TTFget_first_glyphs(&font, inenc_array);
   }
 
-  for (i = 0; i <= 0xFF; i++)
+  pk_filename = mymalloc(fontname_len + 16);
+
+  for (k = 0; k < n_dpis; k++)
   {
-    byte *bitmap;
-    int w, h, hoff, voff;
+    if (k > 0)
+      TTFsetdpi(dpis[k], quiet);
 
+    if (no_dpi)
+      sprintf(pk_filename, "%s.pk", fontname);
+    else
+      sprintf(pk_filename, "%s.%dpk", fontname, dpis[k]);
+    PKopen(pk_filename, fontname, dpis[k]);
 
-    if ((code = inenc_array[i]) >= 0)
+    for (i = 0; i <= 0xFF; i++)
     {
-      if (!quiet)
+      byte *bitmap;
+      int w, h, hoff, voff;
+
+
+      if ((code = inenc_array[i]) >= 0)
       {
-        printf("Processing glyph %3ld   %s index 0x%04lx  %s\n",
-               (long)i, (code >= 0x1000000) ? "glyph" : "code",
-               (code & 0xFFFFFF), enc ? enc->vec[i] : "");
-        fflush(stdout);
-      }
+        if (!quiet)
+        {
+          printf("Processing glyph %3ld   %s index 0x%04lx  %s\n",
+                 (long)i, (code >= 0x1000000) ? "glyph" : "code",
+                 (code & 0xFFFFFF), enc ? enc->vec[i] : "");
+          fflush(stdout);
+        }
 
-      if (TTFprocess(&font, code,
-                     &bitmap, &w, &h, &hoff, &voff, hinting, quiet))
-        PKputglyph(i,
-                   -hoff, -voff, w - hoff, h - voff,
-                   w, h, bitmap);
-      else
-        warning("Cannot render glyph with %s index 0x%lx.",
-                (code >= 0x1000000) ? "glyph" : "code",
-                (code & 0xFFFFFF));
+        if (TTFprocess(&font, code,
+                       &bitmap, &w, &h, &hoff, &voff, hinting, quiet))
+          PKputglyph(i,
+                     -hoff, -voff, w - hoff, h - voff,
+                     w, h, bitmap);
+        else
+          warning("Cannot render glyph with %s index 0x%lx.",
+                  (code >= 0x1000000) ? "glyph" : "code",
+                  (code & 0xFFFFFF));
+      }
     }
-  }
 
-  PKclose();
+    PKclose();
+  }
   exit(0);      /* for safety reasons */
   return 0;     /* never reached */
 }
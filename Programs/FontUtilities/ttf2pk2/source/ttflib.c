@@ -135,6 +135,27 @@ TTFopen(char *filename, Font *fnt, int new_dpi, int new_ptsize, Boolean quiet)
 }
 
 
+/*
+ *   Switches the opened font to another resolution.
+ */
+
+void
+TTFsetdpi(int new_dpi, Boolean quiet)
+{
+  FT_Error error;
+
+
+  dpi = new_dpi;
+  ppem = (dpi * ptsize + 36) / 72;
+
+  if (!quiet)
+    printf("dpi = %d, ptsize = %d, ppem = %d\n\n", dpi, ptsize, ppem);
+
+  if ((error = FT_Set_Char_Size(face, ptsize * 64, ptsize * 64, dpi, dpi)))
+    oops("Cannot set character size (error code = 0x%x).", error);
+}
+
+
 static FT_Error
 LoadTrueTypeChar(Font *fnt,
                  int idx,
@@ -15,6 +15,7 @@
 
 void TTFopen(char *filename, Font *fnt, int new_dpi, int new_ptsize, 
              Boolean quiet);
+void TTFsetdpi(int new_dpi, Boolean quiet);
 
 Boolean TTFprocess(Font *fnt, long Code, byte **bitmap,
                    int *width, int *height, int *hoff, int *voff,
@@ -31,6 +31,8 @@
 
 #include "patgen.h"
 
+#include "wordcounter.h"
+
 extern PATGENPROGCLASS PATGENPROG;
 
 class PATGENAPPCLASS :
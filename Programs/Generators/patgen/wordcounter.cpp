@@ -0,0 +1,278 @@
+/* wordcounter.cpp: counting patterns on several threads
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "patgen-miktex.h"
+
+using namespace std;
+
+// the procedures hyphenate, change_dots and do_word of PATGEN, working on
+// a copy of the word; the pattern trie is not changed during a pass
+
+namespace {
+  constexpr size_t WORD_SIZE = extent<decltype(PATGENPROGCLASS::word)>::value;
+
+  constexpr size_t BATCH_SIZE = 64 * 1024;
+
+  // values of the dots: see the section "Dictionary processing routines"
+  constexpr int ERR_HYF = 1;
+  constexpr int IS_HYF = 2;
+  constexpr int FOUND_HYF = 3;
+
+  struct Word
+  {
+    int wlen;
+    unsigned char word[WORD_SIZE];
+    unsigned char dots[WORD_SIZE];
+    unsigned char dotw[WORD_SIZE];
+  };
+
+  struct Pattern
+  {
+    string letters;
+    int good = 0;
+    int bad = 0;
+  };
+
+  struct Shard
+  {
+    int goodCount = 0;
+    int badCount = 0;
+    int missCount = 0;
+    unordered_map<string, size_t> index;
+    vector<Pattern> patterns;
+  };
+
+  vector<Word> words;
+
+  vector<Shard> shards;
+
+  vector<const Pattern*> merged;
+
+  unsigned threadCount()
+  {
+    return max<unsigned>(1, thread::hardware_concurrency());
+  }
+
+  void Hyphenate(const Word& w, int trieRoot, int maxVal, int hval[], bool noMore[])
+  {
+    const int patLen = PATGENPROG.patlen;
+    const int patDot = PATGENPROG.patdot;
+    const int hyphLevel = PATGENPROG.hyphlevel;
+    for (int spos = w.wlen - PATGENPROG.hyfmax; spos >= 0; --spos)
+    {
+      noMore[spos] = false;
+      hval[spos] = 0;
+      int fpos = spos + 1;
+      int t = trieRoot + w.word[fpos];
+      do
+      {
+        for (int h = PATGENPROG.trier[t]; h > 0; h = PATGENPROG.ops[h].op)
+        {
+          int dpos = spos + PATGENPROG.ops[h].dot;
+          int v = PATGENPROG.ops[h].val;
+          if (v < maxVal && hval[dpos] < v)
+          {
+            hval[dpos] = v;
+          }
+          if (v >= hyphLevel && fpos - patLen <= dpos - patDot && dpos - patDot <= spos)
+          {
+            noMore[dpos] = true;
+          }
+        }
+        t = PATGENPROG.triel[t];
+        if (t == 0)
+        {
+          break;
+        }
+        fpos += 1;
+        t += w.word[fpos];
+      } while (PATGENPROG.triec[t] == w.word[fpos]);
+    }
+  }
+
+  void CountWords(Shard& shard, size_t begin, size_t end, int trieRoot, int maxVal)
+  {
+    const int hyfMin = PATGENPROG.hyfmin;
+    const int hyfMax = PATGENPROG.hyfmax;
+    const int dotMin = PATGENPROG.dotmin;
+    const int dotMax = PATGENPROG.dotmax;
+    const int dotLen = PATGENPROG.dotlen;
+    const int patLen = PATGENPROG.patlen;
+    const int patDot = PATGENPROG.patdot;
+    const int goodDot = PATGENPROG.gooddot;
+    const int badDot = PATGENPROG.baddot;
+    int hval[WORD_SIZE] = {};
+    bool noMore[WORD_SIZE] = {};
+    string letters;
+    for (size_t idx = begin; idx < end; ++idx)
+    {
+      Word& w = words[idx];
+      Hyphenate(w, trieRoot, maxVal, hval, noMore);
+      for (int dpos = w.wlen - hyfMax; dpos >= hyfMin; --dpos)
+      {
+        if (hval[dpos] % 2 == 1)
+        {
+          w.dots[dpos] += 1;
+        }
+        if (w.dots[dpos] == FOUND_HYF)
+        {
+          shard.goodCount += w.dotw[dpos];
+        }
+        else if (w.dots[dpos] == ERR_HYF)
+        {
+          shard.badCount += w.dotw[dpos];
+        }
+        else if (w.dots[dpos] == IS_HYF)
+        {
+          shard.missCount += w.dotw[dpos];
+        }
+      }
+      if (w.wlen < dotLen)
+      {
+        continue;
+      }
+      for (int dpos = w.wlen - dotMax; dpos >= dotMin; --dpos)
+      {
+        if (noMore[dpos])
+        {
+          continue;
+        }
+        bool goodp;
+        if (w.dots[dpos] == goodDot)
+        {
+          goodp = true;
+        }
+        else if (w.dots[dpos] == badDot)
+        {
+          goodp = false;
+        }
+        else
+        {
+          continue;
+        }
+        int spos = dpos - patDot;
+        letters.assign(reinterpret_cast<const char*>(&w.word[spos + 1]), patLen);
+        auto it = shard.index.find(letters);
+        if (it == shard.index.end())
+        {
+          it = shard.index.emplace(letters, shard.patterns.size()).first;
+          shard.patterns.push_back(Pattern{ letters });
+        }
+        Pattern& pattern = shard.patterns[it->second];
+        if (goodp)
+        {
+          pattern.good += w.dotw[dpos];
+        }
+        else
+        {
+          pattern.bad += w.dotw[dpos];
+        }
+      }
+    }
+  }
+}
+
+bool miktexparallelcountp()
+{
+  return threadCount() > 1;
+}
+
+void miktexclearwords()
+{
+  words.clear();
+  shards.clear();
+  merged.clear();
+}
+
+void miktexaddword()
+{
+  Word w;
+  w.wlen = PATGENPROG.wlen;
+  for (int pos = 1; pos <= w.wlen; ++pos)
+  {
+    w.word[pos] = static_cast<unsigned char>(PATGENPROG.word[pos]);
+    w.dots[pos] = static_cast<unsigned char>(PATGENPROG.dots[pos]);
+    w.dotw[pos] = static_cast<unsigned char>(PATGENPROG.dotw[pos]);
+  }
+  words.push_back(w);
+}
+
+bool miktexbatchfull()
+{
+  return words.size() >= BATCH_SIZE;
+}
+
+void miktexcountwords(int trieRoot, int maxVal)
+{
+  size_t count = min<size_t>(threadCount(), max<size_t>(1, words.size()));
+  shards.assign(count, Shard());
+  vector<thread> threads;
+  // contiguous slices: merged in order, the patterns appear in the
+  // order of a serial pass
+  for (size_t n = 1; n < count; ++n)
+  {
+    threads.push_back(thread(CountWords, ref(shards[n]), n * words.size() / count, (n + 1) * words.size() / count, trieRoot, maxVal));
+  }
+  CountWords(shards[0], 0, words.size() / count, trieRoot, maxVal);
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  for (const Shard& shard : shards)
+  {
+    PATGENPROG.goodcount += shard.goodCount;
+    PATGENPROG.badcount += shard.badCount;
+    PATGENPROG.misscount += shard.missCount;
+    for (const Pattern& pattern : shard.patterns)
+    {
+      merged.push_back(&pattern);
+    }
+  }
+}
+
+int miktexpatterncount()
+{
+  return static_cast<int>(merged.size());
+}
+
+void miktexgetpattern(int n)
+{
+  const string& letters = merged[n - 1]->letters;
+  for (size_t pos = 0; pos < letters.length(); ++pos)
+  {
+    PATGENPROG.word[pos + 1] = static_cast<unsigned char>(letters[pos]);
+  }
+}
+
+int miktexpatterngood(int n)
+{
+  return merged[n - 1]->good;
+}
+
+int miktexpatternbad(int n)
+{
+  return merged[n - 1]->bad;
+}
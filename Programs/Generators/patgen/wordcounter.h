@@ -0,0 +1,46 @@
+/* wordcounter.h: counting patterns on several threads
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+// true, if the counting pass is worth distributing
+bool miktexparallelcountp();
+
+// discards the words and counts of the current batch
+void miktexclearwords();
+
+// appends the word that has just been read (word, dots, dotw, wlen)
+void miktexaddword();
+
+bool miktexbatchfull();
+
+// hyphenates the words of the batch and counts the patterns; adds to
+// good_count, bad_count and miss_count
+void miktexcountwords(int trieRoot, int maxVal);
+
+// number of counted patterns; a pattern appears once per thread
+int miktexpatterncount();
+
+// copies pattern n (1-based) to word[1..pat_len]; the patterns of the
+// first thread come first, each thread's in the order of first occurrence
+void miktexgetpattern(int n);
+
+int miktexpatterngood(int n);
+
+int miktexpatternbad(int n);
@@ -13,6 +13,25 @@
 #include "asy-first.h"
 #include "asy.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <regex>
+#include <set>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
 namespace gl
 {
     void updateHandler(int);
@@ -44,4 +63,248 @@ void RequestHandler()
     }
 }
 
+namespace
+{
+    std::string ReadText(const PathName& path)
+    {
+        std::vector<unsigned char> bytes = File::ReadAllBytes(path);
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    // Adds the text of an .asy file and of the local modules it imports to
+    // the digest.  Returns false, if the file reads data files or images:
+    // its output cannot be cached then.
+    bool AddSource(MD5Builder& md5Builder, const PathName& path, std::set<PathName>& visited)
+    {
+        if (!visited.insert(path).second)
+        {
+            return true;
+        }
+        std::string text = ReadText(path);
+        md5Builder.Update(text.c_str(), text.length());
+        static const std::regex external(R"(\b(input|graphic)\s*\()");
+        if (std::regex_search(text, external))
+        {
+            return false;
+        }
+        static const std::regex import(R"(\b(import|access|include|from)\s+"?([A-Za-z0-9_./-]+)"?)");
+        for (std::sregex_iterator it(text.begin(), text.end(), import); it != std::sregex_iterator(); ++it)
+        {
+            // modules which are not found next to the file come with Asymptote
+            PathName dir = path.GetDirectoryName();
+            PathName module = dir.Empty() ? PathName((*it)[2].str()) : dir / (*it)[2].str();
+            if (!File::Exists(module))
+            {
+                module.AppendExtension(".asy");
+            }
+            if (File::Exists(module) && !AddSource(md5Builder, module, visited))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    PathName GetCacheDirectory(const std::string& digest)
+    {
+        return MIKTEX_SESSION()->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_ASY_CACHE_DIR / digest;
+    }
+}
+
+OutputCache::OutputCache(const std::string& fileName, const std::vector<std::string>& options, const std::string& version)
+{
+    PathName path(fileName);
+    if (!path.HasExtension(".asy"))
+    {
+        path.AppendExtension(".asy");
+    }
+    stem = path.GetFileNameWithoutExtension().ToString();
+    try
+    {
+        if (!File::Exists(path))
+        {
+            return;
+        }
+        MD5Builder md5Builder;
+        std::set<PathName> visited;
+        if (!AddSource(md5Builder, path, visited))
+        {
+            return;
+        }
+        for (const std::string& opt : options)
+        {
+            md5Builder.Update(opt.c_str(), opt.length() + 1);
+        }
+        md5Builder.Update(version.c_str(), version.length());
+        digest = md5Builder.Final().ToString();
+        cacheable = true;
+    }
+    catch (const MiKTeXException&)
+    {
+        cacheable = false;
+    }
+}
+
+bool OutputCache::Fetch()
+{
+    if (!cacheable)
+    {
+        return false;
+    }
+    try
+    {
+        PathName cacheDir = GetCacheDirectory(digest);
+        PathName indexFile = cacheDir / "files";
+        if (!File::Exists(indexFile))
+        {
+            return false;
+        }
+        std::string index = ReadText(indexFile);
+        std::size_t start = 0;
+        std::size_t end;
+        while ((end = index.find('\n', start)) != std::string::npos)
+        {
+            std::string name = index.substr(start, end - start);
+            File::Copy(cacheDir / name, PathName(name));
+            start = end + 1;
+        }
+        return true;
+    }
+    catch (const MiKTeXException&)
+    {
+        // process the file as usual
+        return false;
+    }
+}
+
+std::map<std::string, OutputCache::FileState> OutputCache::GetCandidates()
+{
+    std::map<std::string, FileState> result;
+    std::unique_ptr<DirectoryLister> lister = DirectoryLister::Open(PathName().SetToCurrentDirectory(), (stem + "*").c_str());
+    DirectoryEntry2 entry;
+    while (lister->GetNext(entry))
+    {
+        if (entry.isDirectory || PathName(entry.name).HasExtension(".asy"))
+        {
+            continue;
+        }
+        result[entry.name] = FileState{ File::GetLastWriteTime(PathName(entry.name)), entry.size };
+    }
+    return result;
+}
+
+void OutputCache::Prepare()
+{
+    if (!cacheable)
+    {
+        return;
+    }
+    try
+    {
+        before = GetCandidates();
+    }
+    catch (const MiKTeXException&)
+    {
+        cacheable = false;
+    }
+}
+
+void OutputCache::Store()
+{
+    if (!cacheable)
+    {
+        return;
+    }
+    try
+    {
+        std::string index;
+        PathName cacheDir = GetCacheDirectory(digest);
+        for (const auto& candidate : GetCandidates())
+        {
+            auto it = before.find(candidate.first);
+            if (it != before.end() && it->second.lastWriteTime == candidate.second.lastWriteTime && it->second.size == candidate.second.size)
+            {
+                continue;
+            }
+            if (index.empty())
+            {
+                Directory::Create(cacheDir);
+            }
+            File::Copy(PathName(candidate.first), cacheDir / candidate.first);
+            index += candidate.first;
+            index += '\n';
+        }
+        if (index.empty())
+        {
+            return;
+        }
+        // the index is written last: a cache entry without it is incomplete
+        PathName indexFile = cacheDir / "files";
+        PathName newIndexFile = indexFile;
+        newIndexFile.AppendExtension("." + std::to_string(Process::GetCurrentProcess()->GetSystemId()));
+        File::WriteBytes(newIndexFile, std::vector<unsigned char>(index.begin(), index.end()));
+        File::Move(newIndexFile, indexFile, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const MiKTeXException&)
+    {
+        // the cache is an optimization: the output files have been written
+    }
+}
+
+std::vector<std::string> GetOptions(int argc, char** argv, const std::vector<std::string>& fileNames)
+{
+    std::vector<std::string> options;
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        std::string arg = argv[idx];
+        // these do not change the output
+        if (arg == "-cache" || arg == "-nocache" || arg.compare(0, 6, "-jobs=") == 0)
+        {
+            continue;
+        }
+        if (arg == "-jobs")
+        {
+            ++idx;
+            continue;
+        }
+        if (std::find(fileNames.begin(), fileNames.end(), arg) == fileNames.end())
+        {
+            options.push_back(arg);
+        }
+    }
+    return options;
+}
+
+bool RunJobs(int argc, char** argv, const std::vector<std::string>& fileNames, int jobs, bool useCache)
+{
+    PathName asyExe = MIKTEX_SESSION()->GetMyProgramFile(true);
+    std::vector<std::string> options = GetOptions(argc, argv, fileNames);
+    std::size_t nProcesses = std::min(fileNames.size(), static_cast<std::size_t>(jobs));
+    std::vector<ProcessStartInfo> startInfos;
+    for (std::size_t idx = 0; idx < nProcesses; ++idx)
+    {
+        ProcessStartInfo startInfo(asyExe);
+        startInfo.Arguments.push_back(argv[0]);
+        startInfo.Arguments.insert(startInfo.Arguments.end(), options.begin(), options.end());
+        startInfo.Arguments.push_back(useCache ? "-cache" : "-nocache");
+        startInfo.Arguments.push_back("-jobs");
+        startInfo.Arguments.push_back("1");
+        for (std::size_t fileIdx = idx; fileIdx < fileNames.size(); fileIdx += nProcesses)
+        {
+            startInfo.Arguments.push_back(fileNames[fileIdx]);
+        }
+        startInfos.push_back(startInfo);
+    }
+    bool ok = true;
+    for (const ProcessRunResult& result : Process::RunAll(startInfos, nProcesses))
+    {
+        fputs(result.output.c_str(), stdout);
+        if (result.exitStatus != ProcessExitStatus::Exited || result.exitCode != 0)
+        {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
 MIKTEX_END_NS;
@@ -15,6 +15,11 @@
 #include "asy-first.h"
 
 #include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
 
 MIKTEX_BEGIN_NS;
 
@@ -25,4 +30,50 @@ extern std::atomic_bool updateRequested;
 
 void RequestHandler();
 
+// Output files of an .asy file, kept in the cache and keyed by the
+// digest of the file (and of the local modules it imports), the command
+// line options and the Asymptote version.
+class OutputCache
+{
+public:
+    OutputCache(const std::string& fileName, const std::vector<std::string>& options, const std::string& version);
+
+public:
+    // Copies the cached output files into the current directory.
+    bool Fetch();
+
+public:
+    // Remembers the files of the current directory which could become
+    // output files.
+    void Prepare();
+
+public:
+    // Puts the new or changed output files into the cache.
+    void Store();
+
+private:
+    struct FileState
+    {
+        std::time_t lastWriteTime;
+        std::size_t size;
+    };
+
+private:
+    std::map<std::string, FileState> GetCandidates();
+
+private:
+    bool cacheable = false;
+    std::string digest;
+    std::string stem;
+    std::map<std::string, FileState> before;
+};
+
+// Gets the command line arguments which are no file names, leaving out
+// -cache and -jobs.
+std::vector<std::string> GetOptions(int argc, char** argv, const std::vector<std::string>& fileNames);
+
+// Deals the files out to `jobs` asy processes.  Returns false, if one of
+// them failed.
+bool RunJobs(int argc, char** argv, const std::vector<std::string>& fileNames, int jobs, bool useCache);
+
 MIKTEX_END_NS;
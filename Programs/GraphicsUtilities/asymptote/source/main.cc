@@ -217,6 +217,28 @@ void *asymain(void *A)
         if(inpipe < 0) break;
       }
     } else {
+#if defined(MIKTEX)
+      std::vector<std::string> fileNames;
+      for(int ind=0; ind < n; ind++)
+        fileNames.push_back(getArg(ind));
+      std::vector<std::string> options=
+        MiKTeX::Aymptote::GetOptions(args->argc,args->argv,fileNames);
+      bool useCache=getSetting<bool>("cache");
+      int jobs=intcast(getSetting<Int>("jobs"));
+      if(jobs > 1 && n > 1) {
+        std::vector<std::string> misses;
+        for(const std::string& name : fileNames) {
+          if(!useCache ||
+             !MiKTeX::Aymptote::OutputCache(name,options,VERSION).Fetch())
+            misses.push_back(name);
+        }
+        if(!misses.empty() &&
+           !MiKTeX::Aymptote::RunJobs(args->argc,args->argv,misses,jobs,
+                                      useCache))
+          em.statusError();
+        n=0;
+      }
+#endif
       for(int ind=0; ind < n; ind++) {
         string name=(getArg(ind));
         string prefix=stripExt(name);
@@ -224,8 +246,20 @@ void *asymain(void *A)
           interact::uptodate=false;
           runString("import v3d; defaultfilename=\""+stripDir(prefix)+
                     "\"; importv3d(\""+name+"\");");
-        } else
+        } else {
+#if defined(MIKTEX)
+          if(useCache) {
+            MiKTeX::Aymptote::OutputCache cache(getArg(ind),options,VERSION);
+            if(!cache.Fetch()) {
+              cache.Prepare();
+              processFile(name,n > 1);
+              if(em.processStatus())
+                cache.Store();
+            }
+          } else
+#endif
           processFile(name,n > 1);
+        }
         try {
           if(ind < n-1)
             setOptions(args->argc,args->argv);
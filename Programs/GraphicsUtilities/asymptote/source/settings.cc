@@ -1466,6 +1466,12 @@ void initSettings() {
 
   addOption(new boolSetting("wait", 0,
                             "Wait for child processes to finish before exiting"));
+#if defined(MIKTEX)
+  addOption(new boolSetting("cache", 0,
+                            "Reuse the output of unchanged files"));
+  addOption(new IntSetting("jobs", 0, "n",
+                           "Process up to n files at the same time",1));
+#endif
   addOption(new IntSetting("inpipe", 0, "n","Input pipe",-1));
   addOption(new IntSetting("outpipe", 0, "n","Output pipe",-1));
   addOption(new boolSetting("exitonEOF", 0, "Exit interactive mode on EOF",
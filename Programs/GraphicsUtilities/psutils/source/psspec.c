@@ -129,9 +129,11 @@ static const char *prologue[] = { /* PStoPS procset */
    NULL
    };
 
-void pstops(int modulo, int pps, int nobind, PageSpec *specs, double draw) {
+void pstops(int modulo, int pps, int nobind, PageSpec *specs, double draw, PageRange *pagerange) {
 
   scanpages(NULL);
+  if (pagerange)
+    selectpages(pagerange, 0, 0, 0);
   pstops_write(modulo, pps, nobind, specs, draw, NULL);
 }
 
@@ -173,7 +175,7 @@ void pstops_write(int modulo, int pps, int nobind, PageSpec *specs, double draw,
 	    actualpg = maxpage-thispg-modulo+ps->pageno;
 	 else
 	    actualpg = thispg+ps->pageno;
-	 if (actualpg < pages)
+	 if (actualpg < pages && !blankpage(actualpg))
 	    seekpage(actualpg);
 	 if (!add_last) {	/* page label contains original pages */
 	    PageSpec *np = ps;
@@ -230,7 +232,7 @@ void pstops_write(int modulo, int pps, int nobind, PageSpec *specs, double draw,
 	 }
 	 if (add_next)
 	    writestring("/PStoPSenablepage false def\n");
-	 if (actualpg < pages) {
+	 if (actualpg < pages && !blankpage(actualpg)) {
 	    writepagesetup();
 	    writestring("PStoPSxform concat\n");
 	    writepagebody(actualpg);
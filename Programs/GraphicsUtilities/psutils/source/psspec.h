@@ -30,6 +30,6 @@ extern double parsedouble(char **sp);
 extern double parsedimen(char **sp);
 extern double singledimen(char *str);
 extern void pstops(int modulo, int pps, int nobind, PageSpec *specs,
-		   double draw);
+		   double draw, PageRange *pagerange);
 extern void pstops_write(int modulo, int pps, int nobind, PageSpec *specs,
                          double draw, off_t *ignorelist);
@@ -16,7 +16,7 @@
 #include "psutil.h"
 #include "psspec.h"
 
-const char *syntax = "[-q] [-b] [-wWIDTH] [-hHEIGHT] [-dLWIDTH] [-pPAPER] PAGESPECS [INFILE [OUTFILE]]\n";
+const char *syntax = "[-q] [-b] [-wWIDTH] [-hHEIGHT] [-dLWIDTH] [-pPAPER] [-sPAGES] PAGESPECS [INFILE [OUTFILE]]\n";
 
 const char *argerr_message = "%page specification error:\n"
   "  pagespecs = [modulo:]spec\n"
@@ -103,6 +103,7 @@ int
 main(int argc, char *argv[])
 {
    PageSpec *specs = NULL;
+   PageRange *pagerange = NULL;
    int nobinding = 0;
    double draw = 0;
    int opt;
@@ -114,7 +115,7 @@ main(int argc, char *argv[])
 
    verbose = 1;
 
-   while((opt = getopt(argc, argv, "qd::bw:h:p:v0123456789")) != EOF) {
+   while((opt = getopt(argc, argv, "qd::bw:h:p:s:v0123456789")) != EOF) {
      switch(opt) {
      case 'q':	/* quiet */
        verbose = 0;
@@ -138,6 +139,9 @@ main(int argc, char *argv[])
        if (!paper_size(optarg, &width, &height))
          die("paper size '%s' not recognised", optarg);
        break;
+     case 's':	/* select pages first, as psselect does */
+       pagerange = addrange(optarg, pagerange);
+       break;
      case 'v':	/* version */
        usage();
      case '0':
@@ -205,7 +209,7 @@ main(int argc, char *argv[])
    if ((infile=seekable(infile))==NULL)
       die("can't seek input");
 
-   pstops(modulo, pagesperspec, nobinding, specs, draw);
+   pstops(modulo, pagesperspec, nobinding, specs, draw, pagerange);
 
    return 0;
 }
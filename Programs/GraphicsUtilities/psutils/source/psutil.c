@@ -17,6 +17,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdio.h>
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
 
 #include "progname.h"
 #include "xvasprintf.h"
@@ -24,6 +30,10 @@
 
 #define iscomment(x,y) (strncmp(x,y,strlen(y)) == 0)
 
+/* input from a pipe is held in memory up to this size; larger input is
+   spooled to a temporary file */
+#define SPOOL_LIMIT (64*1024*1024)
+
 int pages;
 int verbose;
 FILE *infile;
@@ -41,6 +51,14 @@ static off_t endprocset = 0;
 static int outputpage = 0;
 static int maxpages = 100;
 static off_t *pageptr;
+static int scannedpages = 0;
+static int *pagemap = NULL;		/* selected pages, -1 is an empty page */
+
+/* the input is mapped into memory if possible; otherwise it is read through
+   infile */
+static const char *inbuf = NULL;
+static off_t insize = 0;
+static off_t inpos = 0;
 
 _Noreturn void usage(void)
 {
@@ -97,7 +115,56 @@ int paper_size(const char *paper_name, double *width, double *height)
 }
 #endif /* not used for TeXLive */
 
-/* Make a file seekable, using temporary files if necessary */
+/* Map a regular file into memory */
+static int mapfile(FILE *fp)
+{
+#if defined(_WIN32)
+  HANDLE file = (HANDLE) _get_osfhandle(fileno(fp));
+  HANDLE mapping;
+  LARGE_INTEGER size;
+
+  if (file == INVALID_HANDLE_VALUE || GetFileType(file) != FILE_TYPE_DISK ||
+      !GetFileSizeEx(file, &size))
+    return (0);
+  if (size.QuadPart == 0) {
+    inbuf = "";
+    insize = 0;
+    return (1);
+  }
+  if ((ULONGLONG) size.QuadPart > (SIZE_T) -1)
+    return (0);
+  if ((mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL)
+    return (0);
+  inbuf = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (inbuf == NULL)
+    return (0);
+  insize = size.QuadPart;
+  return (1);
+#else
+  struct stat st;
+  void *p;
+
+  if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode))
+    return (0);
+  if (st.st_size == 0) {
+    inbuf = "";
+    insize = 0;
+    return (1);
+  }
+  if ((unsigned long long) st.st_size > (size_t) -1)
+    return (0);
+  p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+  if (p == MAP_FAILED)
+    return (0);
+  inbuf = (const char *) p;
+  insize = st.st_size;
+  return (1);
+#endif
+}
+
+/* Make a file seekable: regular files are mapped into memory, pipes are read
+   into memory, or spooled to a temporary file if they are too large */
 FILE *seekable(FILE *fp)
 {
   FILE *ft;
@@ -105,13 +172,47 @@ FILE *seekable(FILE *fp)
   char *p;
   char buffer[BUFSIZ] ;
   off_t fpos;
+  char *mem;
+  size_t len = 0, cap = BUFSIZ;
+
+  if (mapfile(fp))
+    return (fp);
 
   if ((fpos = ftello(fp)) >= 0)
     if (!fseeko(fp, (off_t) 0, SEEK_END) && !fseeko(fp, fpos, SEEK_SET))
       return (fp);
 
-  if ((ft = tmpfile()) == NULL)
+  if ((mem = (char *)malloc(cap)) == NULL)
+    return (NULL);
+  while ((r = fread(mem + len, sizeof(char), cap - len, fp)) > 0) {
+    len += r;
+    if (len == cap) {
+      if (cap >= SPOOL_LIMIT)
+	break;
+      cap *= 2;
+      if ((p = (char *)realloc(mem, cap)) == NULL) {
+	free(mem);
+	return (NULL);
+      }
+      mem = p;
+    }
+  }
+
+  if (feof(fp)) {
+    inbuf = mem;
+    insize = len;
+    return (fp);
+  }
+  if (ferror(fp)) {
+    free(mem);
     return (NULL);
+  }
+
+  if ((ft = tmpfile()) == NULL || fwrite(mem, sizeof(char), len, ft) < len) {
+    free(mem);
+    return (NULL);
+  }
+  free(mem);
 
   while ((r = fread(p = buffer, sizeof(char), BUFSIZ, fp)) > 0) {
     do {
@@ -127,18 +228,54 @@ FILE *seekable(FILE *fp)
 
   /* discard the input file, and rewind the temporary */
   (void) fclose(fp);
-  if (fseeko(ft, (off_t) 0, SEEK_SET) != 0)
+  if (fflush(ft) != 0 || fseeko(ft, (off_t) 0, SEEK_SET) != 0)
     return (NULL) ;
+  (void) mapfile(ft);
 
   return (ft);
 }
 
+/* Input routines. These read from the mapped input, if there is one */
+static off_t intell(void)
+{
+  return (inbuf ? inpos : ftello(infile));
+}
+
+static void inseek(off_t pos)
+{
+  if (inbuf)
+    inpos = pos;
+  else
+    fseeko(infile, pos, SEEK_SET);
+}
+
+/* read a line like fgets */
+static char *ingets(char *s, int size)
+{
+  const char *p;
+  int n = 0;
+
+  if (!inbuf)
+    return (fgets(s, size, infile));
+  if (inpos >= insize)
+    return (NULL);
+  p = inbuf + inpos;
+  while (n < size - 1 && inpos + n < insize) {
+    s[n] = p[n];
+    if (s[n++] == '\n')
+      break;
+  }
+  s[n] = '\0';
+  inpos += n;
+  return (s);
+}
+
 
 /* copy input file from current position upto new position to output file,
  * ignoring the lines starting at something ignorelist points to */
 static int fcopy(off_t upto, off_t *ignorelist)
 {
-  off_t here = ftello(infile);
+  off_t here = intell();
   off_t bytes_left;
 
   if (ignorelist != NULL) {
@@ -147,16 +284,27 @@ static int fcopy(off_t upto, off_t *ignorelist)
 
     while (*ignorelist > 0 && *ignorelist < upto) {
       int r = fcopy(*ignorelist, NULL);
-      if (!r || fgets(buffer, BUFSIZ, infile) == NULL)
+      if (!r || ingets(buffer, BUFSIZ) == NULL)
 	return 0;
       ignorelist++;
-      here = ftello(infile);
+      here = intell();
       while (*ignorelist > 0 && *ignorelist < here)
 	ignorelist++;
     }
   }
   bytes_left = upto - here;
 
+  if (inbuf) {			/* write straight from the mapped input */
+    if (bytes_left > 0) {
+      if (upto > insize ||
+	  fwrite(inbuf + here, 1, (size_t) bytes_left, outfile) < (size_t) bytes_left)
+	return (0);
+      inpos = upto;
+      bytes += bytes_left;
+    }
+    return (1);
+  }
+
   while (bytes_left > 0) {
     size_t rw_result;
     const size_t numtocopy = (bytes_left > BUFSIZ) ? BUFSIZ : bytes_left;
@@ -183,8 +331,8 @@ void scanpages(off_t *sizeheaders)
    if ((pageptr = (off_t *)malloc(sizeof(off_t)*maxpages)) == NULL)
       die("out of memory");
    pages = 0;
-   fseeko(infile, (off_t) 0, SEEK_SET);
-   while (record = ftello(infile), fgets(buffer, BUFSIZ, infile) != NULL)
+   inseek((off_t) 0);
+   while (record = intell(), ingets(buffer, BUFSIZ) != NULL)
       if (*buffer == '%') {
 	 if (buffer[1] == '%') {
 	    if (nesting == 0 && iscomment(comment, "Page:")) {
@@ -218,7 +366,7 @@ void scanpages(off_t *sizeheaders)
 	    } else if (headerpos == 0 && iscomment(comment, "Pages:"))
 	       pagescmt = record;
 	    else if (headerpos == 0 && iscomment(comment, "EndComments"))
-	       headerpos = ftello(infile);
+	       headerpos = intell();
 	    else if (iscomment(comment, "BeginDocument") ||
 		     iscomment(comment, "BeginBinary") ||
 		     iscomment(comment, "BeginFile"))
@@ -230,32 +378,171 @@ void scanpages(off_t *sizeheaders)
 	    else if (nesting == 0 && iscomment(comment, "EndSetup"))
 	       endsetup = record;
 	    else if (nesting == 0 && iscomment(comment, "BeginProlog"))
-	       headerpos = ftello(infile);
+	       headerpos = intell();
 	    else if (nesting == 0 &&
 		       iscomment(comment, "BeginProcSet: PStoPS"))
 	       beginprocset = record;
 	    else if (beginprocset && !endprocset &&
 		     iscomment(comment, "EndProcSet"))
-	       endprocset = ftello(infile);
+	       endprocset = intell();
 	    else if (nesting == 0 && (iscomment(comment, "Trailer") ||
 				      iscomment(comment, "EOF"))) {
-	       fseeko(infile, record, SEEK_SET);
+	       inseek(record);
 	       break;
 	    }
 	 } else if (headerpos == 0 && buffer[1] != '!')
 	    headerpos = record;
       } else if (headerpos == 0)
 	 headerpos = record;
-   pageptr[pages] = ftello(infile);
+   pageptr[pages] = intell();
    if (endsetup == 0 || endsetup > pageptr[0])
       endsetup = pageptr[0];
+   scannedpages = pages;
+}
+
+static PageRange *makerange(int beg, int end, PageRange *next)
+{
+   PageRange *new;
+   if ((new = (PageRange *)malloc(sizeof(PageRange))) == NULL)
+      die("out of memory");
+   new->first = beg;
+   new->last = end;
+   new->next = next;
+   return (new);
+}
+
+/* parse a page range list, adding the ranges in front of rp */
+PageRange *addrange(char *str, PageRange *rp)
+{
+   int first=0;
+   int sign;
+
+   if(!str) return NULL;
+
+   sign = (*str == '_' && ++str) ? -1 : 1;
+   if (isdigit((unsigned char)*str)) {
+      first = sign*atoi(str);
+      while (isdigit((unsigned char)*str)) str++;
+   }
+   switch (*str) {
+   case '\0':
+      if (first || sign < 0)
+	 return (makerange(first, first, rp));
+      break;
+   case ',':
+      if (first || sign < 0)
+	 return (addrange(str+1, makerange(first, first, rp)));
+      break;
+   case '-':
+   case ':':
+      str++;
+      sign = (*str == '_' && ++str) ? -1 : 1;
+      if (!first)
+	 first = 1;
+      if (isdigit((unsigned char)*str)) {
+	 int last = sign*atoi(str);
+	 while (isdigit((unsigned char)*str)) str++;
+	 if (*str == '\0')
+	   return (makerange(first, last, rp));
+	 if (*str == ',')
+	   return (addrange(str+1, makerange(first, last, rp)));
+      } else if (*str == '\0')
+	 return (makerange(first, -1, rp));
+      else if (*str == ',')
+	 return (addrange(str+1, makerange(first, -1, rp)));
+   default: /* Avoid a compiler warning */
+     break;
+   }
+   die("invalid page range");
+   return (PageRange *)0 ;
+}
+
+/* select pages after scanpages(); the selected pages are numbered from 0 to
+ * pages-1, page 0 of a range is an empty page */
+void selectpages(PageRange *pagerange, int even, int odd, int reverse)
+{
+   int currentpg, maxpage = 0;
+   int pass;
+   int all = !(odd || even);	/* all pages in range if odd or even not set */
+
+   /* add default page range */
+   if (!pagerange)
+      pagerange = makerange(1, -1, NULL);
+
+   /* reverse page list if not reversing pages (list constructed bottom up) */
+   if (!reverse) {
+      PageRange *revlist = NULL;
+      PageRange *next = NULL;
+      while (pagerange) {
+	 next = pagerange->next;
+	 pagerange->next = revlist;
+	 revlist = pagerange;
+	 pagerange = next;
+      }
+      pagerange = revlist;
+   } else { /* swap start & end if reversing */
+      PageRange *r;
+      for (r = pagerange; r; r = r->next) {
+         int temp = r->last;
+         r->last = r->first;
+         r->first = temp;
+      }
+   }
+
+   { /* adjust for end-relative pageranges */
+      PageRange *r;
+      for (r = pagerange; r; r = r->next) {
+	 if (r->first < 0) {
+	    r->first += scannedpages + 1;
+	    if (r->first < 1)
+	       r->first = 1;
+	 }
+	 if (r->last < 0) {
+	    r->last += scannedpages + 1;
+	    if (r->last < 1)
+	       r->last = 1;
+	 }
+      }
+   }
+
+   /* count pages on first pass, select pages on second pass */
+   for (pass = 0; pass < 2; pass++) {
+      PageRange *r;
+      if (pass) {
+	 free(pagemap);
+	 if ((pagemap = (int *)malloc(sizeof(int)*(maxpage+1))) == NULL)
+	    die("out of memory");
+	 maxpage = 0;
+      }
+      for (r = pagerange; r; r = r->next) {
+	 int step = r->last < r->first ? -1 : 1;
+	 for (currentpg = r->first; ; currentpg += step) {
+	    if (currentpg == 0 ||
+		(currentpg <= scannedpages &&
+		 ((currentpg&1) ? (odd || all) : (even || all)))) {
+	       if (pass)
+		  pagemap[maxpage] = currentpg-1;
+	       maxpage++;
+	    }
+	    if (currentpg == r->last)
+	       break;
+	 }
+      }
+   }
+   pages = maxpage;
+}
+
+/* test whether a selected page is an empty page */
+int blankpage(int p)
+{
+   return (pagemap != NULL && pagemap[p] < 0);
 }
 
 /* seek a particular page */
 void seekpage(int p)
 {
-   fseeko(infile, pageptr[p], SEEK_SET);
-   if (fgets(buffer, BUFSIZ, infile) != NULL &&
+   inseek(pageptr[pagemap ? pagemap[p] : p]);
+   if (ingets(buffer, BUFSIZ) != NULL &&
        iscomment(buffer, "%%Page:")) {
       char *start, *end;
       for (start = buffer+7; isspace((unsigned char)*start); start++);
@@ -306,7 +593,7 @@ void writepagesetup(void)
    char buffer[BUFSIZ];
    if (beginprocset) {
       for (;;) {
-	 if (fgets(buffer, BUFSIZ, infile) == NULL)
+	 if (ingets(buffer, BUFSIZ) == NULL)
 	    die("I/O error reading page setup %d", outputpage);
 	 if (!strncmp(buffer, "PStoPSxform", 11))
 	    break;
@@ -320,15 +607,19 @@ void writepagesetup(void)
 /* write the body of a page */
 void writepagebody(int p)
 {
-   if (!fcopy(pageptr[p+1], NULL))
+   if (!fcopy(pageptr[(pagemap ? pagemap[p] : p)+1], NULL))
       die("I/O error writing page %d", outputpage);
 }
 
 /* write a whole page */
 void writepage(int p)
 {
+   if (blankpage(p)) {
+      writeemptypage();
+      return;
+   }
    seekpage(p);
-   writepageheader(pagelabel, p+1);
+   writepageheader(pagelabel, (pagemap ? pagemap[p] : p)+1);
    writepagebody(p);
 }
 
@@ -340,9 +631,9 @@ void writeheader(int p, off_t *ignore)
 
 void writeheadermedia(int p, off_t *ignore, double width, double height)
 {
-    fseeko(infile, (off_t) 0, SEEK_SET);
+   inseek((off_t) 0);
    if (pagescmt) {
-      if (!fcopy(pagescmt, ignore) || fgets(buffer, BUFSIZ, infile) == NULL)
+      if (!fcopy(pagescmt, ignore) || ingets(buffer, BUFSIZ) == NULL)
 	 die("I/O error in header");
       if (width > -1 && height > -1) {
          sprintf(buffer, "%%%%DocumentMedia: plain %d %d 0 () ()\n", (int) width, (int) height);
@@ -363,7 +654,7 @@ int writepartprolog(void)
    if (beginprocset && !fcopy(beginprocset, NULL))
       die("I/O error in prologue");
    if (endprocset)
-      fseeko(infile, endprocset, SEEK_SET);
+      inseek(endprocset);
    writeprolog();
    return !beginprocset;
 }
@@ -385,8 +676,8 @@ void writesetup(void)
 /* write trailer */
 void writetrailer(void)
 {
-   fseeko(infile, pageptr[pages], SEEK_SET);
-   while (fgets(buffer, BUFSIZ, infile) != NULL) {
+   inseek(pageptr[scannedpages]);
+   while (ingets(buffer, BUFSIZ) != NULL) {
       writestring(buffer);
    }
    if (verbose)
@@ -16,6 +16,11 @@
 #include <fcntl.h>
 #endif
 
+typedef struct pgrange {
+   int first, last;
+   struct pgrange *next;
+} PageRange ;
+
 /* Definitions for functions found in psutil.c */
 extern void usage(void);
 extern void die(const char *format, ...);
@@ -35,6 +40,9 @@ extern void writesetup(void);
 extern void writetrailer(void);
 extern void writeemptypage(void);
 extern void scanpages(off_t *sizeheaders);
+extern PageRange *addrange(char *str, PageRange *rp);
+extern void selectpages(PageRange *pagerange, int even, int odd, int reverse);
+extern int blankpage(int p);
 extern void writestring(const char *s);
 
 /* These variables are exported to the client program */
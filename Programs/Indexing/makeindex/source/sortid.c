@@ -34,11 +34,37 @@
 
 static	long	idx_gc;
 
-static int check_mixsym (const char *x, const char *y);
+/*
+ * The parts of a key field which do not change while sorting: its
+ * group type, and, where possible, a string which strcmp() orders the
+ * same way as compare_string() orders the field itself (the strxfrm()
+ * form for locale sorting, the lower-cased form otherwise).  These are
+ * computed once per entry instead of once per comparison.  The
+ * comparisons themselves (and thus the order in which qqsort() visits
+ * the entries, and which entries get marked as duplicates) do not
+ * change.
+ */
+typedef struct
+{
+    const char *str;
+    int     group;
+    char   *key;
+}	SORT_FIELD;
+
+typedef struct
+{
+    FIELD_PTR field;
+    SORT_FIELD sf[FIELD_MAX];
+    SORT_FIELD af[FIELD_MAX];
+}	SORT_KEY, *SORT_KEY_PTR;
+
+static void make_sort_field (SORT_FIELD *sfd, const char *str);
+static int check_mixsym (const SORT_FIELD *x, const SORT_FIELD *y);
 static int compare (const void *va, const void *vb);
-static int compare_one (const char *x, const char *y);
+static int compare_one (const SORT_FIELD *x, const SORT_FIELD *y);
 static int compare_page (const FIELD_PTR *a, const FIELD_PTR *b);
 static int compare_string (const unsigned char *a, const unsigned char *b);
+static int compare_key (const SORT_FIELD *x, const SORT_FIELD *y);
 static int new_strcmp (const unsigned char *a, const unsigned char *b,
            int option);
 
@@ -48,30 +74,88 @@ sort_idx(void)
 #ifdef HAVE_SETLOCALE
     char *prev_locale;
 #endif
+    SORT_KEY *keys;
+    SORT_KEY_PTR *key_ptr;
+    int     i;
+    int     j;
 
     MESSAGE("Sorting entries...");
 #ifdef HAVE_SETLOCALE
     prev_locale = setlocale(LC_COLLATE, NULL);
     setlocale(LC_COLLATE, "");
 #endif
+    if (((keys = (SORT_KEY *) calloc(idx_gt, sizeof(SORT_KEY))) == NULL) ||
+	((key_ptr = (SORT_KEY_PTR *) calloc(idx_gt, sizeof(SORT_KEY_PTR))) == NULL))
+	FATAL("Not enough core...abort.\n");
+    for (i = 0; i < idx_gt; i++) {
+	keys[i].field = idx_key[i];
+	for (j = 0; j < FIELD_MAX; j++) {
+	    make_sort_field(&keys[i].sf[j], idx_key[i]->sf[j]);
+	    make_sort_field(&keys[i].af[j], idx_key[i]->af[j]);
+	}
+	key_ptr[i] = &keys[i];
+    }
     idx_dc = 0;
     idx_gc = 0L;
-    qqsort(idx_key, (size_t)idx_gt, sizeof(FIELD_PTR), compare);
+    qqsort(key_ptr, (size_t)idx_gt, sizeof(SORT_KEY_PTR), compare);
+    for (i = 0; i < idx_gt; i++) {
+	idx_key[i] = key_ptr[i]->field;
+	for (j = 0; j < FIELD_MAX; j++) {
+	    if (keys[i].sf[j].key != NULL)
+		free(keys[i].sf[j].key);
+	    if (keys[i].af[j].key != NULL)
+		free(keys[i].af[j].key);
+	}
+    }
+    free(key_ptr);
+    free(keys);
 #ifdef HAVE_SETLOCALE
     setlocale(LC_COLLATE, prev_locale);
 #endif
     MESSAGE1("done (%ld comparisons).\n", idx_gc);
 }
 
+static void
+make_sort_field(SORT_FIELD *sfd, const char *str)
+{
+    size_t  n;
+    size_t  i;
+
+    sfd->str = str;
+    sfd->key = NULL;
+    if (str[0] == NUL) {
+	sfd->group = ALPHA;
+	return;
+    }
+    sfd->group = group_type(str);
+    if (sfd->group >= 0)
+	return;
+    if (locale_sort) {
+	/* strcmp() on strxfrm() forms orders like strcoll() */
+	n = strxfrm(NULL, str, 0);
+	if ((sfd->key = (char *) malloc(n + 1)) == NULL)
+	    FATAL("Not enough core...abort.\n");
+	(void) strxfrm(sfd->key, str, n + 1);
+    } else if ((sfd->group == ALPHA) && !letter_ordering) {
+	/* letter ordering skips blanks while comparing; keep it as is */
+	n = strlen(str);
+	if ((sfd->key = (char *) malloc(n + 1)) == NULL)
+	    FATAL("Not enough core...abort.\n");
+	for (i = 0; i < n; i++)
+	    sfd->key[i] = (char) TOLOWER((unsigned char) str[i]);
+	sfd->key[n] = NUL;
+    }
+}
+
 static int
 compare(const void *va, const void *vb)
 {
 #if defined(MIKTEX)
-    const FIELD_PTR *a = (FIELD_PTR*)va;
-    const FIELD_PTR *b = (FIELD_PTR*)vb;
+    const SORT_KEY_PTR *a = (SORT_KEY_PTR*)va;
+    const SORT_KEY_PTR *b = (SORT_KEY_PTR*)vb;
 #else
-    const FIELD_PTR *a = va;
-    const FIELD_PTR *b = vb;
+    const SORT_KEY_PTR *a = va;
+    const SORT_KEY_PTR *b = vb;
 #endif
     int     i;
     int     dif;
@@ -81,37 +165,37 @@ compare(const void *va, const void *vb)
 
     for (i = 0; i < FIELD_MAX; i++) {
 	/* compare the sort fields */
-	if ((dif = compare_one((*a)->sf[i], (*b)->sf[i])) != 0)
+	if ((dif = compare_one(&(*a)->sf[i], &(*b)->sf[i])) != 0)
 	    break;
 
 	/* compare the actual fields */
-	if ((dif = compare_one((*a)->af[i], (*b)->af[i])) != 0)
+	if ((dif = compare_one(&(*a)->af[i], &(*b)->af[i])) != 0)
 	    break;
     }
 
     /* both key aggregates are identical, compare page numbers */
     if (i == FIELD_MAX)
-	dif = compare_page(a, b);
+	dif = compare_page(&(*a)->field, &(*b)->field);
     return (dif);
 }
 
 static int
-compare_one(const char *x, const char *y)
+compare_one(const SORT_FIELD *x, const SORT_FIELD *y)
 {
     int     m;
     int     n;
 
-    if ((x[0] == NUL) && (y[0] == NUL))
+    if ((x->str[0] == NUL) && (y->str[0] == NUL))
 	return (0);
 
-    if (x[0] == NUL)
+    if (x->str[0] == NUL)
 	return (-1);
 
-    if (y[0] == NUL)
+    if (y->str[0] == NUL)
 	return (1);
 
-    m = group_type(x);
-    n = group_type(y);
+    m = x->group;
+    n = y->group;
 
     /* both pure digits */
     if ((m >= 0) && (n >= 0))
@@ -144,17 +228,17 @@ compare_one(const char *x, const char *y)
 	return (1);
 
     /* strings with a leading letter, the ALPHA type */
-    return (compare_string((const unsigned char*)x, (const unsigned char*)y));
+    return (compare_key(x, y));
 }
 
 static int
-check_mixsym(const char *x, const char *y)
+check_mixsym(const SORT_FIELD *x, const SORT_FIELD *y)
 {
     int     m;
     int     n;
 
-    m = ISDIGIT(x[0]);
-    n = ISDIGIT(y[0]);
+    m = ISDIGIT(x->str[0]);
+    n = ISDIGIT(y->str[0]);
 
     if (m && !n)
 	return (1);
@@ -162,7 +246,28 @@ check_mixsym(const char *x, const char *y)
     if (!m && n)
 	return (-1);
 
-    return (locale_sort ? strcoll(x, y) : strcmp(x, y));
+    return (locale_sort ? strcmp(x->key, y->key) : strcmp(x->str, y->str));
+}
+
+static int
+compare_key(const SORT_FIELD *x, const SORT_FIELD *y)
+{
+    int     dif;
+
+    if ((x->key == NULL) || (y->key == NULL))
+	return (compare_string((const unsigned char*)x->str,
+			       (const unsigned char*)y->str));
+    if (locale_sort)
+	return (strcmp(x->key, y->key));
+
+    /* same as the case-folded loop in compare_string() */
+    if ((dif = strcmp(x->key, y->key)) != 0)
+	return (dif);
+    if (german_sort)
+	return (new_strcmp((const unsigned char*)x->str,
+			   (const unsigned char*)y->str, GERMAN));
+    else
+	return (strcmp(x->str, y->str));
 }
 
 
@@ -2,6 +2,7 @@
 #include "version.h"
 #include <kpathsea/tex-file.h>
 #include <kpathsea/variable.h>
+#include <time.h>
 
 #include "kana.h"
 #include "hanzi.h"
@@ -24,6 +25,7 @@ int main(int argc, char **argv)
 {
 	int i,j,k,cc=0,startpagenum=-1,ecount=0,chkopt=1;
 	const char *envbuff;
+	clock_t start;
 	UVersionInfo icuVersion;
 	char icu_version[U_MAX_VERSION_STRING_LENGTH] = "";
 
@@ -319,18 +321,20 @@ int main(int argc, char **argv)
 	verb_printf(efp,"Sorting index.");
 
 	scount=0;
+	start=clock();
 	wsort(ind,lines);
 
-	verb_printf(efp,"...done(%d comparisons).\n",scount);
+	verb_printf(efp,"...done(%d comparisons, %.2f s).\n",scount,(double)(clock()-start)/CLOCKS_PER_SEC);
 
 /*   sort pages   */
 
 	verb_printf(efp,"Sorting pages.");
 
 	scount=0;
+	start=clock();
 	pagesort(ind,lines);
 
-	verb_printf(efp,"...done(%d comparisons).\n",scount);
+	verb_printf(efp,"...done(%d comparisons, %.2f s).\n",scount,(double)(clock()-start)/CLOCKS_PER_SEC);
 
 /*   get last page   */
 
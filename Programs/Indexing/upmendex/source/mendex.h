@@ -39,6 +39,9 @@ struct index {
 	UChar *idx[3];
 	struct page *p;
 	int lnum;
+	int ord[3];		/* character group of dic[] (used while sorting) */
+	char *dkey[3];		/* ICU sort key of dic[] (used while sorting) */
+	char *ikey[3];		/* ICU sort key of idx[] (used while sorting) */
 };
 
 #define INITIALLENGTH 10
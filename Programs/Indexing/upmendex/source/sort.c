@@ -24,6 +24,8 @@
 int sym,nmbr,ltn,kana,hngl,hnz,cyr,grk,dvng,thai,arab,hbrw;
 
 static int wcomp(const void *p, const void *q);
+static int kcomp(const void *p, const void *q);
+static char *sort_key(const UChar *str);
 static int pcomp(const void *p, const void *q);
 static int ordering(UChar *c);
 static int get_charset_juncture(UChar *str);
@@ -91,7 +93,7 @@ void init_icu_collator()
 /*   sort index   */
 void wsort(struct index *ind, int num)
 {
-	int i,order;
+	int i,j,order;
 
 	for (order=1,i=0;;i++) {
 		switch (character_order[i]) {
@@ -172,7 +174,93 @@ BREAK:
 	if (arab==0) arab=order++;
 	if (hbrw==0) hbrw=order++;
 
-	qsort(ind,num,sizeof(struct index),wcomp);
+	if (priority!=0) {
+		qsort(ind,num,sizeof(struct index),wcomp);
+		return;
+	}
+
+/*   without priority, the collation of a word does not depend on
+     the other word: compute the keys once per entry, not once per
+     comparison   */
+	for (i=0;i<num;i++) {
+		for (j=0;j<3;j++) {
+			ind[i].ord[j]=0;
+			ind[i].dkey[j]=ind[i].ikey[j]=NULL;
+			if (j>=ind[i].words) continue;
+			if (ind[i].dic[j][0]!=L'\0') ind[i].ord[j]=ordering(ind[i].dic[j]);
+			ind[i].dkey[j]=sort_key(ind[i].dic[j]);
+			ind[i].ikey[j]=sort_key(ind[i].idx[j]);
+		}
+	}
+	qsort(ind,num,sizeof(struct index),kcomp);
+	for (i=0;i<num;i++) {
+		for (j=0;j<3;j++) {
+			free(ind[i].dkey[j]);
+			free(ind[i].ikey[j]);
+			ind[i].dkey[j]=ind[i].ikey[j]=NULL;
+		}
+	}
+}
+
+/*   ICU sort key: strcmp() on two keys agrees with ucol_strcoll()   */
+static char *sort_key(const UChar *str)
+{
+	uint8_t *key;
+	int32_t len, size=64;
+
+	key=xmalloc(size);
+	len=ucol_getSortKey(icu_collator, str, -1, key, size);
+	if (len>size) {
+		free(key);
+		size=len;
+		key=xmalloc(size);
+		ucol_getSortKey(icu_collator, str, -1, key, size);
+	}
+	return (char *)key;
+}
+
+/*   compare for sorting index, using the keys computed by wsort()   */
+static int kcomp(const void *p, const void *q)
+{
+	int j, cmp;
+	const struct index *index1 = p, *index2 = q;
+
+	scount++;
+
+	for (j=0;j<3;j++) {
+
+/*   check level   */
+		if (((*index1).words==j)&&((*index2).words!=j)) return -1;
+		else if (((*index1).words!=j)&&((*index2).words==j)) return 1;
+		if ((*index1).words==j) return 0;
+
+		if (((*index1).dic[j][0]!=L'\0')||((*index2).dic[j][0]!=L'\0')) {
+
+/*   index1 is shorter   */
+			if ((*index1).dic[j][0]==L'\0') return -1;
+
+/*   index2 is shorter   */
+			if ((*index2).dic[j][0]==L'\0') return 1;
+
+/*   compare group   */
+			if ((*index1).ord[j]<(*index2).ord[j]) return -1;
+			if ((*index1).ord[j]>(*index2).ord[j]) return 1;
+
+/*   simple compare   */
+			cmp=strcmp((*index1).dkey[j],(*index2).dkey[j]);
+			if (cmp<0) return -1;
+			else if (cmp>0) return 1;
+		}
+
+/*   compare index   */
+		cmp=strcmp((*index1).ikey[j],(*index2).ikey[j]);
+		if (cmp<0) return -1;
+		else if (cmp>0) return 1;
+		cmp=u_strcmp((*index1).idx[j],(*index2).idx[j]);
+		if (cmp<0) return -1;
+		else if (cmp>0) return 1;
+	}
+	return 0;
 }
 
 /*   compare for sorting index   */
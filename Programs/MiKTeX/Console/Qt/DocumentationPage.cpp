@@ -26,6 +26,7 @@
 #include <QWidget>
 
 #include <miktex/Core/AutoResource>
+#include <miktex/Core/File>
 #include <miktex/Core/Paths>
 #include <miktex/UI/Qt/ErrorDialog>
 #include <miktex/UI/Qt/UpdateDialog>
@@ -120,12 +121,12 @@ void DocumentationPage::UpdateActions()
         }
         for (QModelIndexList::const_iterator it = selectedRows.begin(); it != selectedRows.end() && enableInstall && enableOpenDocumentDirectory; ++it)
         {
-            PackageInfo packageInfo;
-            if (!documentationModel->TryGetPackageInfo(documentationProxyModel->mapToSource(*it), packageInfo))
+            PackageDocumentation packageDocumentation;
+            if (!documentationModel->TryGetPackageDocumentation(documentationProxyModel->mapToSource(*it), packageDocumentation))
             {
                 MIKTEX_UNEXPECTED();
             }
-            if (packageInfo.IsInstalled())
+            if (packageDocumentation.isInstalled)
             {
                 enableInstall = false;
             }
@@ -145,12 +146,12 @@ void DocumentationPage::UpdateActions()
             }
             else
             {
-                PackageInfo packageInfo;
-                if (!documentationModel->TryGetPackageInfo(documentationProxyModel->mapToSource(selectedRows[0]), packageInfo))
+                PackageDocumentation packageDocumentation;
+                if (!documentationModel->TryGetPackageDocumentation(documentationProxyModel->mapToSource(selectedRows[0]), packageDocumentation))
                 {
                     MIKTEX_UNEXPECTED();
                 }
-                enableView = packageInfo.IsInstalled();
+                enableView = packageDocumentation.isInstalled;
             }
         }
         ui->actionViewDocument->setEnabled(enableView);
@@ -196,14 +197,14 @@ void DocumentationPage::InstallDocumentation()
     vector<string> toBeInstalled;
     for (const QModelIndex& ind : ui->treeViewDocumentation->selectionModel()->selectedRows())
     {
-      PackageInfo packageInfo;
-      if (!documentationModel->TryGetPackageInfo(documentationProxyModel->mapToSource(ind), packageInfo))
+      PackageDocumentation packageDocumentation;
+      if (!documentationModel->TryGetPackageDocumentation(documentationProxyModel->mapToSource(ind), packageDocumentation))
       {
         MIKTEX_UNEXPECTED();
       }
-      else if (!packageInfo.IsInstalled())
+      else if (!packageDocumentation.isInstalled)
       {
-        toBeInstalled.push_back(packageInfo.id);
+        toBeInstalled.push_back(packageDocumentation.packageId);
       }
     }
     QString message =
@@ -227,23 +228,20 @@ void DocumentationPage::InstallDocumentation()
   }
 }
 
-bool SkipPrefix(const string& str, const char* prefix, string& result)
+PathName DocumentationPage::LocateDocument(const DocumentationFile& file)
 {
-  size_t n = strlen(prefix);
-  if (str.compare(0, n, prefix) != 0)
-  {
-    return false;
-  }
-  result = str.c_str() + n;
-  return true;
-}
-
-bool SkipTeXMFPrefix(const string& str, string& result)
-{
-  return SkipPrefix(str, "texmf/", result)
-    || SkipPrefix(str, "texmf\\", result)
-    || SkipPrefix(str, "./texmf/", result)
-    || SkipPrefix(str, ".\\texmf\\", result);
+    // the index knows where installed documents are
+    if (!file.path.Empty() && File::Exists(file.path))
+    {
+        return file.path;
+    }
+    LocateOptions locateOptions;
+    locateOptions.callback = this;
+    if (auto locateResult = session->Locate(file.fileName, locateOptions); !locateResult.pathNames.empty())
+    {
+        return locateResult.pathNames[0];
+    }
+    return PathName();
 }
 
 void DocumentationPage::ViewDocument()
@@ -257,23 +255,15 @@ void DocumentationPage::ViewDocument()
     {
         QApplication::setOverrideCursor(Qt::WaitCursor);
         MIKTEX_AUTO(QApplication::restoreOverrideCursor());
-        PackageInfo packageInfo;
-        if (!documentationModel->TryGetPackageInfo(documentationProxyModel->mapToSource(selectedRows[0]), packageInfo))
+        PackageDocumentation packageDocumentation;
+        if (!documentationModel->TryGetPackageDocumentation(documentationProxyModel->mapToSource(selectedRows[0]), packageDocumentation))
         {
             MIKTEX_UNEXPECTED();
         }
-        MIKTEX_ASSERT(!packageInfo.docFiles.empty());
-        string fileName = packageInfo.docFiles[0];
-        string file;
-        if (!SkipTeXMFPrefix(fileName, file))
+        MIKTEX_ASSERT(!packageDocumentation.files.empty());
+        if (PathName path = LocateDocument(packageDocumentation.files[0]); !path.Empty())
         {
-            return;
-        }
-        LocateOptions locateOptions;
-        locateOptions.callback = this;
-        if (auto locateResult = session->Locate(file, locateOptions); !locateResult.pathNames.empty())
-        {
-            QDesktopServices::openUrl(QUrl::fromLocalFile(QString::fromUtf8(locateResult.pathNames[0].GetData())));
+            QDesktopServices::openUrl(QUrl::fromLocalFile(QString::fromUtf8(path.GetData())));
         }
     }
     catch (const MiKTeXException& e)
@@ -294,23 +284,15 @@ void DocumentationPage::OpenDocumentationDirectory()
         MIKTEX_AUTO(QApplication::restoreOverrideCursor());
         for (const QModelIndex& index : ui->treeViewDocumentation->selectionModel()->selectedRows())
         {
-            PackageInfo packageInfo;
-            if (!documentationModel->TryGetPackageInfo(documentationProxyModel->mapToSource(index), packageInfo))
+            PackageDocumentation packageDocumentation;
+            if (!documentationModel->TryGetPackageDocumentation(documentationProxyModel->mapToSource(index), packageDocumentation))
             {
                 MIKTEX_UNEXPECTED();
             }
-            MIKTEX_ASSERT(!packageInfo.docFiles.empty());
-            string fileName = packageInfo.docFiles[0];
-            string file;
-            if (!SkipTeXMFPrefix(fileName, file))
-            {
-                continue;
-            }
-            LocateOptions locateOptions;
-            locateOptions.callback = this;
-            if (auto locateResult = session->Locate(file, locateOptions); !locateResult.pathNames.empty())
+            MIKTEX_ASSERT(!packageDocumentation.files.empty());
+            if (PathName path = LocateDocument(packageDocumentation.files[0]); !path.Empty())
             {
-                QDesktopServices::openUrl(QUrl::fromLocalFile(QString::fromUtf8(locateResult.pathNames[0].GetDirectoryName().GetData())));
+                QDesktopServices::openUrl(QUrl::fromLocalFile(QString::fromUtf8(path.GetDirectoryName().GetData())));
             }
         }
     }
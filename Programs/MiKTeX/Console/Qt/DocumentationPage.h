@@ -74,6 +74,9 @@ private slots:
 private slots:
     void OpenDocumentationDirectory();
 
+private:
+    MiKTeX::Util::PathName LocateDocument(const MiKTeX::Packages::DocumentationFile& file);
+
 private:
     bool InstallPackage(const std::string& packageId, const MiKTeX::Util::PathName& trigger, MiKTeX::Util::PathName& installRoot) override;
 
@@ -50,25 +50,25 @@ bool DocumentationProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex&
     }
     DocumentationTableModel* documentationTableModel = dynamic_cast<DocumentationTableModel*>(sourceModel());
     MIKTEX_ASSERT(documentationTableModel != nullptr);
-    PackageInfo packageInfo;
-    if (!documentationTableModel->TryGetPackageInfo(sourceModel()->index(sourceRow, 0, sourceParent), packageInfo))
+    PackageDocumentation packageDocumentation;
+    if (!documentationTableModel->TryGetPackageDocumentation(sourceModel()->index(sourceRow, 0, sourceParent), packageDocumentation))
     {
         return false;
     }
     bool accept = false;
     if (!accept)
     {
-        accept = packageInfo.id.find(filterText) != string::npos;
+        accept = packageDocumentation.packageId.find(filterText) != string::npos;
     }
     if (!accept)
     {
-        accept = packageInfo.title.find(filterText) != string::npos;
+        accept = packageDocumentation.title.find(filterText) != string::npos;
     }
     if (!accept)
     {
-        for (const string& f : packageInfo.docFiles)
+        for (const DocumentationFile& f : packageDocumentation.files)
         {
-            accept = PathName::Match(filterText.c_str(), PathName(f).RemoveDirectorySpec());
+            accept = PathName::Match(filterText.c_str(), PathName(f.fileName).RemoveDirectorySpec());
             if (accept)
             {
                 break;
@@ -42,10 +42,10 @@ struct DocumentSorter
     {
         preferredNames[0] = packageId;
     }
-    bool operator() (const std::string& l, const std::string& r)
+    bool operator() (const DocumentationFile& l, const DocumentationFile& r)
     {
-        MiKTeX::Util::PathName left(l);
-        MiKTeX::Util::PathName right(r);
+        MiKTeX::Util::PathName left(l.fileName);
+        MiKTeX::Util::PathName right(r.fileName);
         auto leftExt = left.GetExtension();
         auto rightExt = right.GetExtension();
         for (const auto& e : preferredExtensions)
@@ -117,27 +117,27 @@ QVariant DocumentationTableModel::data(const QModelIndex& index, int role) const
 
     if (role == Qt::DisplayRole)
     {
-        PackageInfo packageInfo;
-        if (TryGetPackageInfo(index, packageInfo))
+        PackageDocumentation packageDocumentation;
+        if (TryGetPackageDocumentation(index, packageDocumentation))
         {
             switch (index.column())
             {
             case 0:
-                return QString::fromUtf8(packageInfo.id.c_str());
+                return QString::fromUtf8(packageDocumentation.packageId.c_str());
             case 1:
-                if (!packageInfo.docFiles.empty())
+                if (!packageDocumentation.files.empty())
                 {
-                    return QString::fromUtf8(PathName(packageInfo.docFiles[0]).GetFileName().GetData());
+                    return QString::fromUtf8(PathName(packageDocumentation.files[0].fileName).GetFileName().GetData());
                 }
                 break;
             case 2:
-                if (packageInfo.IsInstalled())
+                if (packageDocumentation.isInstalled)
                 {
                     return QString::fromUtf8(u8"\u2713");
                 }
                 break;
             case 3:
-                return QString::fromUtf8(packageInfo.title.c_str());
+                return QString::fromUtf8(packageDocumentation.title.c_str());
             }
         }
     }
@@ -169,32 +169,28 @@ void DocumentationTableModel::Reload()
     beginResetModel();
     MIKTEX_AUTO(endResetModel());
     packages.clear();
+    // the package database is loaded only if the documentation index is out
+    // of date
     packageManager->UnloadDatabase();
-    unique_ptr<PackageIterator> iter(packageManager->CreateIterator());
-    PackageInfo packageInfo;
     int row = 0;
-    while (iter->GetNext(packageInfo))
+    for (PackageDocumentation& packageDocumentation : packageManager->GetDocumentationIndex())
     {
-        if (!packageInfo.IsPureContainer() && packageInfo.docFiles.size() > 0)
-        {
-            std::sort(packageInfo.docFiles.begin(), packageInfo.docFiles.end(), DocumentSorter(packageInfo.id));
-            packages[row] = packageInfo;
-            ++row;
-        }
+        std::sort(packageDocumentation.files.begin(), packageDocumentation.files.end(), DocumentSorter(packageDocumentation.packageId));
+        packages[row] = std::move(packageDocumentation);
+        ++row;
     }
-    iter->Dispose();
 }
 
-bool DocumentationTableModel::TryGetPackageInfo(const QModelIndex& index, PackageInfo& packageInfo) const
+bool DocumentationTableModel::TryGetPackageDocumentation(const QModelIndex& index, PackageDocumentation& packageDocumentation) const
 {
-    map<int, PackageInfo>::const_iterator it = packages.find(index.row());
+    map<int, PackageDocumentation>::const_iterator it = packages.find(index.row());
     if (it == packages.end())
     {
         return false;
     }
     else
     {
-        packageInfo = it->second;
+        packageDocumentation = it->second;
         return true;
     }
 }
@@ -51,16 +51,16 @@ public:
 	void Reload();
 
 public:
-	bool TryGetPackageInfo(const QModelIndex& index, MiKTeX::Packages::PackageInfo& packageInfo) const;
+	bool TryGetPackageDocumentation(const QModelIndex& index, MiKTeX::Packages::PackageDocumentation& packageDocumentation) const;
 
 private:
 	std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
 
 private:
-	std::map<int, MiKTeX::Packages::PackageInfo> packages;
+	std::map<int, MiKTeX::Packages::PackageDocumentation> packages;
 
 public:
-	const std::map<int, MiKTeX::Packages::PackageInfo>& GetData() const
+	const std::map<int, MiKTeX::Packages::PackageDocumentation>& GetData() const
 	{
 		return packages;
 	}
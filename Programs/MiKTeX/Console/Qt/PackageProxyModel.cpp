@@ -19,6 +19,8 @@
    Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
    USA. */
 
+#include <QThread>
+
 #include <miktex/PackageManager/PackageManager>
 #include <miktex/Util/PathName>
 
@@ -31,51 +33,183 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Packages;
 using namespace MiKTeX::Util;
 
+void PackageFilterWorker::Process()
+{
+  if (index == nullptr)
+  {
+    shared_ptr<PackageSearchIndex> newIndex = make_shared<PackageSearchIndex>();
+    newIndex->packages = packages;
+    for (int row = 0; row < packages->size(); ++row)
+    {
+      for (const string& f : (*packages)[row].runFiles)
+      {
+        vector<int>& rows = newIndex->runFiles[PathName(f).RemoveDirectorySpec().TransformForComparison().ToString()];
+        if (rows.empty() || rows.back() != row)
+        {
+          rows.push_back(row);
+        }
+      }
+    }
+    index = newIndex;
+  }
+  accepted = make_shared<vector<bool>>(packages->size(), false);
+  nameMatches = make_shared<vector<int>>();
+  auto matchName = [this](int row) {
+    const PackageInfo& packageInfo = (*packages)[row];
+    return packageInfo.id.find(filter) != string::npos || packageInfo.title.find(filter) != string::npos;
+  };
+  if (candidates != nullptr)
+  {
+    for (int row : *candidates)
+    {
+      if (matchName(row))
+      {
+        nameMatches->push_back(row);
+      }
+    }
+  }
+  else
+  {
+    for (int row = 0; row < packages->size(); ++row)
+    {
+      if (matchName(row))
+      {
+        nameMatches->push_back(row);
+      }
+    }
+  }
+  for (int row : *nameMatches)
+  {
+    (*accepted)[row] = true;
+  }
+  if (filter.find_first_of("*?") == string::npos)
+  {
+    auto it = index->runFiles.find(PathName(filter).TransformForComparison().ToString());
+    if (it != index->runFiles.end())
+    {
+      for (int row : it->second)
+      {
+        (*accepted)[row] = true;
+      }
+    }
+  }
+  else
+  {
+    for (int row = 0; row < packages->size(); ++row)
+    {
+      if ((*accepted)[row])
+      {
+        continue;
+      }
+      for (const string& f : (*packages)[row].runFiles)
+      {
+        if (PathName::Match(filter, PathName(f).RemoveDirectorySpec()))
+        {
+          (*accepted)[row] = true;
+          break;
+        }
+      }
+    }
+  }
+  emit OnFinish();
+}
+
 PackageProxyModel::PackageProxyModel(QObject* parent) :
   QSortFilterProxyModel(parent)
 {
 }
 
-void PackageProxyModel::SetFilter(const string& filter)
+void PackageProxyModel::setSourceModel(QAbstractItemModel* sourceModel)
 {
-  this->filterText = filter;
-  invalidateFilter();
+  QSortFilterProxyModel::setSourceModel(sourceModel);
+  (void)connect(sourceModel, &QAbstractItemModel::modelReset, this, &PackageProxyModel::OnSourceModelReset);
 }
 
-bool PackageProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+void PackageProxyModel::OnSourceModelReset()
 {
-  if (filterText.empty())
+  index = nullptr;
+  if (!requestedFilterText.empty())
   {
-    return true;
+    SetFilter(requestedFilterText);
   }
-  PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
-  MIKTEX_ASSERT(packageTableModel != nullptr);
-  PackageInfo packageInfo;
-  if (!packageTableModel->TryGetPackageInfo(sourceModel()->index(sourceRow, 0, sourceParent), packageInfo))
+}
+
+void PackageProxyModel::SetFilter(const string& filter)
+{
+  generation++;
+  requestedFilterText = filter;
+  if (filter.empty())
   {
-    return false;
+    filterText = filter;
+    filteredPackages = nullptr;
+    nameMatches = nullptr;
+    accepted = nullptr;
+    invalidateFilter();
+    return;
   }
-  bool accept = false;
-  if (!accept)
+  PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
+  MIKTEX_ASSERT(packageTableModel != nullptr);
+  shared_ptr<const vector<PackageInfo>> packages = packageTableModel->GetPackages();
+  shared_ptr<const vector<int>> candidates;
+  if (nameMatches != nullptr && filteredPackages == packages && filter.find(filterText) != string::npos)
   {
-    accept = packageInfo.id.find(filterText) != string::npos;
+    candidates = nameMatches;
   }
-  if (!accept)
+  QThread* thread = new QThread;
+  PackageFilterWorker* worker = new PackageFilterWorker(generation, filter, index != nullptr && index->packages == packages ? index : nullptr, packages, candidates);
+  worker->moveToThread(thread);
+  (void)connect(thread, SIGNAL(started()), worker, SLOT(Process()));
+  (void)connect(worker, &PackageFilterWorker::OnFinish, this, [this, worker, packageTableModel]() {
+    if (worker->packages == packageTableModel->GetPackages())
+    {
+      index = worker->index;
+    }
+    if (worker->generation == generation)
+    {
+      filterText = worker->filter;
+      filteredPackages = worker->packages;
+      nameMatches = worker->nameMatches;
+      accepted = worker->accepted;
+      invalidateFilter();
+    }
+    worker->deleteLater();
+  });
+  (void)connect(worker, SIGNAL(OnFinish()), thread, SLOT(quit()));
+  (void)connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+  thread->start();
+}
+
+bool PackageProxyModel::Matches(const PackageInfo& packageInfo, const string& filter)
+{
+  if (packageInfo.id.find(filter) != string::npos || packageInfo.title.find(filter) != string::npos)
   {
-    accept = packageInfo.title.find(filterText) != string::npos;
+    return true;
   }
-  if (!accept)
+  for (const string& f : packageInfo.runFiles)
   {
-    for (const string& f : packageInfo.runFiles)
+    if (PathName::Match(filter, PathName(f).RemoveDirectorySpec()))
     {
-      accept = PathName::Match(filterText.c_str(), PathName(f).RemoveDirectorySpec());
-      if (accept)
-      {
-        break;
-      }
+      return true;
     }
   }
-  return accept;
+  return false;
+}
+
+bool PackageProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+{
+  if (filterText.empty())
+  {
+    return true;
+  }
+  PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
+  MIKTEX_ASSERT(packageTableModel != nullptr);
+  if (accepted != nullptr && filteredPackages == packageTableModel->GetPackages())
+  {
+    return (*accepted)[sourceRow];
+  }
+  // the model has been reloaded: match until the new result is available
+  const PackageInfo* packageInfo = packageTableModel->GetPackageInfo(sourceRow);
+  return packageInfo != nullptr && Matches(*packageInfo, filterText);
 }
 
 bool PackageProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const
@@ -83,15 +217,14 @@ bool PackageProxyModel::lessThan(const QModelIndex& left, const QModelIndex& rig
   MIKTEX_ASSERT(left.column() == right.column());
   PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
   MIKTEX_ASSERT(packageTableModel != nullptr);
-  PackageInfo packageInfoLeft;
-  PackageInfo packageInfoRight;
-  if (packageTableModel->TryGetPackageInfo(sourceModel()->index(left.row(), 0, left.parent()), packageInfoLeft)
-    && packageTableModel->TryGetPackageInfo(sourceModel()->index(right.row(), 0, right.parent()), packageInfoRight))
+  const PackageInfo* packageInfoLeft = packageTableModel->GetPackageInfo(left.row());
+  const PackageInfo* packageInfoRight = packageTableModel->GetPackageInfo(right.row());
+  if (packageInfoLeft != nullptr && packageInfoRight != nullptr)
   {
     switch (left.column())
     {
     case 2:
-      return packageInfoLeft.GetSize() < packageInfoRight.GetSize();
+      return packageInfoLeft->GetSize() < packageInfoRight->GetSize();
     default:
       break;
     }
@@ -24,8 +24,69 @@
 #if !defined(E7AF14B9D04F41D48C47DDB1A55839A8)
 #define E7AF14B9D04F41D48C47DDB1A55839A8
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include <QSortFilterProxyModel>
 
+#include <miktex/PackageManager/PackageManager>
+
+/// Maps run-time file names to rows of the package table.
+struct PackageSearchIndex
+{
+  std::shared_ptr<const std::vector<MiKTeX::Packages::PackageInfo>> packages;
+  std::unordered_map<std::string, std::vector<int>> runFiles;
+};
+
+/// Filters the package table on a background thread.
+class PackageFilterWorker :
+  public QObject
+{
+private:
+  Q_OBJECT;
+
+public:
+  PackageFilterWorker(unsigned generation, const std::string& filter, std::shared_ptr<const PackageSearchIndex> index, std::shared_ptr<const std::vector<MiKTeX::Packages::PackageInfo>> packages, std::shared_ptr<const std::vector<int>> candidates) :
+    generation(generation),
+    filter(filter),
+    index(index),
+    packages(packages),
+    candidates(candidates)
+  {
+  }
+
+public slots:
+  void Process();
+
+signals:
+  void OnFinish();
+
+public:
+  unsigned generation;
+
+public:
+  std::string filter;
+
+public:
+  std::shared_ptr<const PackageSearchIndex> index;
+
+public:
+  std::shared_ptr<const std::vector<MiKTeX::Packages::PackageInfo>> packages;
+
+  // rows whose name or title contain a previous filter text, which is
+  // contained in the new filter text
+public:
+  std::shared_ptr<const std::vector<int>> candidates;
+
+public:
+  std::shared_ptr<std::vector<int>> nameMatches;
+
+public:
+  std::shared_ptr<std::vector<bool>> accepted;
+};
+
 class PackageProxyModel :
   public QSortFilterProxyModel
 {
@@ -35,17 +96,47 @@ private:
 public:
   PackageProxyModel(QObject* parent = nullptr);
 
+public:
+  void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+  /// Starts filtering in the background; the view is updated when the
+  /// result is available.
 public:
   void SetFilter(const std::string& filter);
 
+public:
+  static bool Matches(const MiKTeX::Packages::PackageInfo& packageInfo, const std::string& filter);
+
 protected:
   bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
 
 protected:
   bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
-  
+
+private:
+  void OnSourceModelReset();
+
+private:
+  unsigned generation = 0;
+
+private:
+  std::string requestedFilterText;
+
+  // the filter text of the current result
 private:
   std::string filterText;
+
+private:
+  std::shared_ptr<const PackageSearchIndex> index;
+
+private:
+  std::shared_ptr<const std::vector<MiKTeX::Packages::PackageInfo>> filteredPackages;
+
+private:
+  std::shared_ptr<const std::vector<int>> nameMatches;
+
+private:
+  std::shared_ptr<const std::vector<bool>> accepted;
 };
 
 #endif
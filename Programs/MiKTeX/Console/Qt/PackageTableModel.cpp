@@ -43,7 +43,7 @@ PackageTableModel::PackageTableModel(std::shared_ptr<MiKTeX::Packages::PackageMa
 
 int PackageTableModel::rowCount(const QModelIndex& parent) const
 {
-  return parent.isValid() ? 0 : packages.size();
+  return parent.isValid() ? 0 : packages->size();
 }
 
 int PackageTableModel::columnCount(const QModelIndex& parent) const
@@ -53,65 +53,66 @@ int PackageTableModel::columnCount(const QModelIndex& parent) const
 
 QVariant PackageTableModel::data(const QModelIndex& index, int role) const
 {
-  if (!(index.isValid() && index.row() >= 0 && index.row() < packages.size()))
+  const PackageInfo* pPackageInfo = index.isValid() ? GetPackageInfo(index.row()) : nullptr;
+  if (pPackageInfo == nullptr)
   {
     return QVariant();
   }
+  const PackageInfo& packageInfo = *pPackageInfo;
 
   if (role == Qt::DisplayRole)
   {
-    PackageInfo packageInfo;
-    if (TryGetPackageInfo(index, packageInfo))
+    switch (index.column())
     {
-      switch (index.column())
+    case 0:
+      return QString::fromUtf8(packageInfo.id.c_str());
+    case 1:
+      if (containerPaths[index.row()].isNull())
       {
-      case 0:
-        return QString::fromUtf8(packageInfo.id.c_str());
-      case 1:
-        return QString::fromUtf8(packageManager->GetContainerPath(packageInfo.id, true).c_str());
-      case 2:
+        containerPaths[index.row()] = QString::fromUtf8(packageManager->GetContainerPath(packageInfo.id, true).c_str());
+      }
+      return containerPaths[index.row()];
+    case 2:
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-        return QLocale::system().formattedDataSize(packageInfo.GetSize());
+      return QLocale::system().formattedDataSize(packageInfo.GetSize());
 #else
-        return static_cast<qlonglong>(packageInfo.GetSize());
+      return static_cast<qlonglong>(packageInfo.GetSize());
 #endif
-      case 3:
-        return QDateTime::fromSecsSinceEpoch(packageInfo.timePackaged).date();
-      case 4:
-        if (packageInfo.IsInstalled())
-        {
-          return QDateTime::fromSecsSinceEpoch(packageInfo.GetTimeInstalled()).date();
-        }
-        break;
-      case 5:
-        if (packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
-        {
-          return tr("Admin") + ", " + tr("User");
-        }
-        else if (packageInfo.IsInstalled(ConfigurationScope::Common))
-        {
-          return session->IsSharedSetup() ? tr("Admin") : tr("User");
-        }
-        else if (packageInfo.IsInstalled(ConfigurationScope::User))
-        {
-          return tr("User");
-        }
-        break;
-      case 6:
-        return QString::fromUtf8(packageInfo.title.c_str());
-      case 7:
-        if (!packageInfo.runFiles.empty())
-        {
-          return QString("%1 +%2").arg(QString::fromUtf8(PathName(packageInfo.runFiles[0]).GetFileName().GetData())).arg(packageInfo.runFiles.size());
-        }
-        break;
+    case 3:
+      return QDateTime::fromSecsSinceEpoch(packageInfo.timePackaged).date();
+    case 4:
+      if (packageInfo.IsInstalled())
+      {
+        return QDateTime::fromSecsSinceEpoch(packageInfo.GetTimeInstalled()).date();
+      }
+      break;
+    case 5:
+      if (packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
+      {
+        return tr("Admin") + ", " + tr("User");
       }
+      else if (packageInfo.IsInstalled(ConfigurationScope::Common))
+      {
+        return session->IsSharedSetup() ? tr("Admin") : tr("User");
+      }
+      else if (packageInfo.IsInstalled(ConfigurationScope::User))
+      {
+        return tr("User");
+      }
+      break;
+    case 6:
+      return QString::fromUtf8(packageInfo.title.c_str());
+    case 7:
+      if (!packageInfo.runFiles.empty())
+      {
+        return QString("%1 +%2").arg(QString::fromUtf8(PathName(packageInfo.runFiles[0]).GetFileName().GetData())).arg(packageInfo.runFiles.size());
+      }
+      break;
     }
   }
   else if (role == Qt::ForegroundRole)
   {
-    PackageInfo packageInfo;
-    if (TryGetPackageInfo(index, packageInfo) && packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
+    if (packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
     {
       return QColor("red");
     }
@@ -151,32 +152,30 @@ void PackageTableModel::Reload()
 {
   beginResetModel();
   MIKTEX_AUTO(endResetModel());
-  packages.clear();  
   packageManager->UnloadDatabase();
   unique_ptr<PackageIterator> iter(packageManager->CreateIterator());
+  // background threads may still use the old rows
+  shared_ptr<vector<PackageInfo>> newPackages = make_shared<vector<PackageInfo>>();
   PackageInfo packageInfo;
-  int row = 0;
   while (iter->GetNext(packageInfo))
   {
     if (!packageInfo.IsPureContainer())
     {
-      packages[row] = packageInfo;
-      ++row;
+      newPackages->push_back(std::move(packageInfo));
     }
   }
   iter->Dispose();
+  packages = newPackages;
+  containerPaths.assign(packages->size(), QString());
 }
 
 bool PackageTableModel::TryGetPackageInfo(const QModelIndex& index, PackageInfo& packageInfo) const
 {
-  map<int, PackageInfo>::const_iterator it = packages.find(index.row());
-  if (it == packages.end())
+  const PackageInfo* pPackageInfo = GetPackageInfo(index.row());
+  if (pPackageInfo == nullptr)
   {
     return false;
   }
-  else
-  {
-    packageInfo = it->second;
-    return true;
-  }
+  packageInfo = *pPackageInfo;
+  return true;
 }
@@ -24,7 +24,11 @@
 #if !defined(A767D31C530F42158B96C0AF14BBF92B)
 #define A767D31C530F42158B96C0AF14BBF92B
 
+#include <memory>
+#include <vector>
+
 #include <QAbstractTableModel>
+#include <QString>
 
 #include <miktex/PackageManager/PackageManager>
 #include <miktex/Core/Session>
@@ -56,18 +60,31 @@ public:
 public:
   bool TryGetPackageInfo(const QModelIndex& index, MiKTeX::Packages::PackageInfo& packageInfo) const;
 
-private:
-  std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
-
-private:
-  std::map<int, MiKTeX::Packages::PackageInfo> packages;
+  /// Gets the package info of a row without copying it.
+public:
+  const MiKTeX::Packages::PackageInfo* GetPackageInfo(int row) const
+  {
+    return row >= 0 && row < packages->size() ? &(*packages)[row] : nullptr;
+  }
 
+  /// Gets the rows; the vector is not modified, i.e., it can be used by
+  /// background threads.
 public:
-  const std::map<int, MiKTeX::Packages::PackageInfo>& GetData() const
+  std::shared_ptr<const std::vector<MiKTeX::Packages::PackageInfo>> GetPackages() const
   {
     return packages;
   }
 
+private:
+  std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
+
+private:
+  std::shared_ptr<const std::vector<MiKTeX::Packages::PackageInfo>> packages = std::make_shared<std::vector<MiKTeX::Packages::PackageInfo>>();
+
+  // looked up when the row is shown for the first time
+private:
+  mutable std::vector<QString> containerPaths;
+
 private:
   std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
 };
@@ -1,6 +1,6 @@
 /* DviDoc.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of Yap.
 
@@ -26,6 +26,7 @@
 #include "ErrorDialog.h"
 #include "MainFrame.h"
 #include "ProgressDialog.h"
+#include "TileCache.h"
 
 #include "DviDoc.h"
 
@@ -58,6 +59,7 @@ DviDoc::~DviDoc()
   {
     MIKTEX_ASSERT(pDviSave == nullptr);
     MIKTEX_ASSERT(!isPrintContext);
+    tileCache = nullptr;
     if (pDvi != nullptr)
     {
       delete pDvi;
@@ -103,12 +105,31 @@ DviPage* DviDoc::GetLoadedPage(int pageIdx)
   return pDvi->GetLoadedPage(pageIdx);
 }
 
+TileCache* DviDoc::GetTileCache()
+{
+  MIKTEX_ASSERT(!isPrintContext);
+  if (tileCache == nullptr)
+  {
+    tileCache = make_unique<TileCache>(this);
+  }
+  return tileCache.get();
+}
+
+void DviDoc::ClearTileCache()
+{
+  if (tileCache != nullptr)
+  {
+    tileCache->Clear();
+  }
+}
+
 void DviDoc::BeginDviPrinting(const CDC* pPrinterDC)
 {
   UNUSED_ALWAYS(pPrinterDC);
   MIKTEX_ASSERT(!isPrintContext);
   MIKTEX_ASSERT(pDviSave == nullptr);
   MIKTEX_ASSERT(pDvi != nullptr);
+  ClearTileCache();
   isPrintContext = true;
   pDviSave = pDvi;
   pDvi = nullptr;
@@ -129,6 +150,7 @@ void DviDoc::EndDviPrinting()
 {
   MIKTEX_ASSERT(isPrintContext);
   MIKTEX_ASSERT(this->pDvi != nullptr);
+  ClearTileCache();
   isPrintContext = false;
   Dvi* pDvi = this->pDvi;
   this->pDvi = pDviSave;
@@ -166,6 +188,7 @@ void DviDoc::CreateDocument(const char* lpszPathName)
 void DviDoc::Reread()
 {
   MIKTEX_ASSERT(!isPrintContext);
+  ClearTileCache();
   Dvi* pDvi = this->pDvi;
   this->pDvi = nullptr;
   fileStatus = DVIFILE_NOT_LOADED;
@@ -176,6 +199,22 @@ void DviDoc::Reread()
   CreateDocument(TU_(GetPathName()));
 }
 
+void DviDoc::Refresh()
+{
+  MIKTEX_ASSERT(!isPrintContext);
+  if (pDvi == nullptr || !File::Exists(PathName(GetPathName())))
+  {
+    Reread();
+    return;
+  }
+  // rescan the DVI file: unchanged pages are kept, but tiles are not
+  ClearTileCache();
+  fileStatus = DVIFILE_NOT_LOADED;
+  modificationTime = File::GetLastWriteTime(PathName(GetPathName()));
+  pDvi->Scan();
+  fileStatus = DVIFILE_LOADED;
+}
+
 CSize DviDoc::GetPaperSize()
 const
 {
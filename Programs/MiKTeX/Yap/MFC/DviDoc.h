@@ -1,6 +1,6 @@
 /* DviDoc.h:                                            -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of Yap.
 
@@ -21,6 +21,7 @@
 #pragma once
 
 class ProgressDialog;
+class TileCache;
 
 class DviDoc :
   public CDocument,
@@ -104,6 +105,12 @@ public:
 public:
   DviPage* GetLoadedPage(int pageIdx);
 
+public:
+  TileCache* GetTileCache();
+
+public:
+  void ClearTileCache();
+
 public:
   int GetMaxPageNum() const;
 
@@ -141,6 +148,9 @@ public:
 public:
   void Reread();
 
+public:
+  void Refresh();
+
 private:
   void CreateDocument(const char* lpszPathName);
 
@@ -212,6 +222,9 @@ private:
 private:
   Dvi* pDviSave = nullptr;
 
+private:
+  unique_ptr<TileCache> tileCache;
+
 private:
   int displayShrinkFactor;
 
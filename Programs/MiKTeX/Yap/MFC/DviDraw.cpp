@@ -113,6 +113,11 @@ DviDraw::~DviDraw()
 #define USE_STRETCHDIBITS 0
 
 void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
+{
+  DrawDviBitmaps(pDC, pDoc, pPage, pDoc->GetShrinkFactor());
+}
+
+void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage, int shrinkFactor)
 {
   ASSERT_VALID(pDC);
   ASSERT_VALID(pDoc);
@@ -138,9 +143,9 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
   foreback fb;
   fb.fore = RGB(0, 0, 0);
   fb.back = RGB(255, 255, 255);
-  fb.numcolors = (pDoc->GetShrinkFactor() == 1 ? 2 : 16);
+  fb.numcolors = (shrinkFactor == 1 ? 2 : 16);
 
-  if (pDoc->GetShrinkFactor() > 1)
+  if (shrinkFactor > 1)
   {
     // select standard b/w palette
     HPALETTE hPalOld = SelectPalette(pDC->GetSafeHdc(), foregroundPalettes[fb], TRUE);
@@ -155,10 +160,10 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
   }
 
   // process all bitmaps
-  size_t nBitmaps = pPage->GetNumberOfDviBitmaps(pDoc->GetShrinkFactor());
+  size_t nBitmaps = pPage->GetNumberOfDviBitmaps(shrinkFactor);
   for (size_t idx = 0; idx < nBitmaps; ++idx)
   {
-    const DviBitmap& dvibm = pPage->GetDviBitmap(pDoc->GetShrinkFactor(), static_cast<int>(idx));
+    const DviBitmap& dvibm = pPage->GetDviBitmap(shrinkFactor, static_cast<int>(idx));
 
     CRect rectBitmap(dvibm.x, dvibm.y, dvibm.x + dvibm.width - 1, dvibm.y + dvibm.height - 1);
 
@@ -169,14 +174,14 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
     }
 
     // select palette for current bitmap
-    if (pDoc->GetShrinkFactor() > 1 && (dvibm.foregroundColor != fb.fore || dvibm.backgroundColor != fb.back))
+    if (shrinkFactor > 1 && (dvibm.foregroundColor != fb.fore || dvibm.backgroundColor != fb.back))
     {
       fb.fore = dvibm.foregroundColor;
       fb.back = dvibm.backgroundColor;
       HPALETTE hPal;
       if (foregroundPalettes.find(fb) == foregroundPalettes.end())
       {
-        hPal = CreateDviBitmapPalette(fb.fore, fb.back, pDoc->GetShrinkFactor() == 1 ? 2 : 16);
+        hPal = CreateDviBitmapPalette(fb.fore, fb.back, shrinkFactor == 1 ? 2 : 16);
         foregroundPalettes[fb] = hPal;
       }
       else
@@ -208,10 +213,10 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
       MakeBitmapInfo(dvibm.width, dvibm.height, (pDoc->IsPrintContext()
         ? pDoc->GetPrinterResolution()
         : (pDoc->GetDisplayResolution()
-          / pDoc->GetDisplayShrinkFactor())), dvibm.bytesPerLine, pDoc);
+          / shrinkFactor)), dvibm.bytesPerLine, shrinkFactor);
 
     // set printer colors
-    if (pDoc->GetShrinkFactor() == 1)
+    if (shrinkFactor == 1)
     {
       pBitmapInfo->bmiColors[0].rgbRed = GetRValue(fb.back);
       pBitmapInfo->bmiColors[0].rgbGreen = GetGValue(fb.back);
@@ -225,7 +230,7 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 
 #if USE_STRETCHDIBITS
     int n =
-      StretchDIBits(pDC->GetSafeHdc(), dvibm.x, dvibm.y, dvibm.width, dvibm.height, 0, 0, dvibm.width, dvibm.height, reinterpret_cast<const void*>(dvibm.pPixels), pBitmapInfo, (pDoc->GetShrinkFactor() == 1
+      StretchDIBits(pDC->GetSafeHdc(), dvibm.x, dvibm.y, dvibm.width, dvibm.height, 0, 0, dvibm.width, dvibm.height, reinterpret_cast<const void*>(dvibm.pPixels), pBitmapInfo, (shrinkFactor == 1
         ? DIB_RGB_COLORS
         : DIB_PAL_COLORS), SRCCOPY);
     if (n != dvibm.height)
@@ -242,7 +247,7 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 #endif
 
 #if USE_BITBLT
-    HBITMAP hBitmap = CreateDIBitmap(pDC->GetSafeHdc(), &pBitmapInfo->bmiHeader, CBM_INIT, reinterpret_cast<const void*>(dvibm.pixels), pBitmapInfo, pDoc->GetShrinkFactor() == 1 ? DIB_RGB_COLORS : DIB_PAL_COLORS);
+    HBITMAP hBitmap = CreateDIBitmap(pDC->GetSafeHdc(), &pBitmapInfo->bmiHeader, CBM_INIT, reinterpret_cast<const void*>(dvibm.pixels), pBitmapInfo, shrinkFactor == 1 ? DIB_RGB_COLORS : DIB_PAL_COLORS);
     if (hBitmap == nullptr)
     {
       MIKTEX_UNEXPECTED();
@@ -279,6 +284,11 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 }
 
 void DviDraw::DrawDibChunks(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
+{
+  DrawDibChunks(pDC, pDoc, pPage, pDoc->GetShrinkFactor());
+}
+
+void DviDraw::DrawDibChunks(CDC* pDC, DviDoc* pDoc, DviPage* pPage, int shrinkFactor)
 {
   ASSERT_VALID(pDC);
   ASSERT_VALID(pDoc);
@@ -302,10 +312,10 @@ void DviDraw::DrawDibChunks(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 #endif
 
   // process all DIB chunks
-  size_t nChunks = pPage->GetNumberOfDibChunks(pDoc->GetShrinkFactor());
+  size_t nChunks = pPage->GetNumberOfDibChunks(shrinkFactor);
   for (size_t idx = 0; idx < nChunks; ++idx)
   {
-    const DibChunk& chunk = *pPage->GetDibChunk(pDoc->GetShrinkFactor(), static_cast<int>(idx));
+    const DibChunk& chunk = *pPage->GetDibChunk(shrinkFactor, static_cast<int>(idx));
 
     const BITMAPINFO* pBitmapInfo = chunk.GetBitmapInfo();
 
@@ -374,9 +384,9 @@ void DviDraw::DrawDibChunks(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 #endif
 }
 
-LPBITMAPINFO DviDraw::MakeBitmapInfo(size_t width, size_t height, size_t dpi, size_t bytesPerLine, DviDoc* pDoc)
+LPBITMAPINFO DviDraw::MakeBitmapInfo(size_t width, size_t height, size_t dpi, size_t bytesPerLine, int shrinkFactor)
 {
-  int mode = pDoc->GetShrinkFactor() == 1 ? DVIVIEW_PRINTER : DVIVIEW_DISPLAY;
+  int mode = shrinkFactor == 1 ? DVIVIEW_PRINTER : DVIVIEW_DISPLAY;
   LPBITMAPINFO pBitmapInfo = reinterpret_cast<LPBITMAPINFO>(bitmapInfoTable[mode]);
   pBitmapInfo->bmiHeader.biWidth = static_cast<LONG>(width);
   pBitmapInfo->bmiHeader.biHeight = static_cast<LONG>(height);
@@ -461,6 +471,11 @@ HPALETTE DviDraw::CreateDviBitmapPalette(COLORREF foreColor, COLORREF backColor,
 #define USE_FILLRECT 1
 
 void DviDraw::DrawRules(CDC* pDC, bool blackBoards, DviDoc* pDoc, DviPage* pPage)
+{
+  DrawRules(pDC, blackBoards, pDoc, pPage, pDoc->GetShrinkFactor());
+}
+
+void DviDraw::DrawRules(CDC* pDC, bool blackBoards, DviDoc* pDoc, DviPage* pPage, int shrinkFactor)
 {
   UNUSED_ALWAYS(pDoc);
 
@@ -478,7 +493,7 @@ void DviDraw::DrawRules(CDC* pDC, bool blackBoards, DviDoc* pDoc, DviPage* pPage
     {
       continue;
     }
-    CRect rectRule(pRule->GetLeft(pDoc->GetShrinkFactor()), pRule->GetTop(pDoc->GetShrinkFactor()), pRule->GetRight(pDoc->GetShrinkFactor()) + 1, pRule->GetBottom(pDoc->GetShrinkFactor()) + 1);
+    CRect rectRule(pRule->GetLeft(shrinkFactor), pRule->GetTop(shrinkFactor), pRule->GetRight(shrinkFactor) + 1, pRule->GetBottom(shrinkFactor) + 1);
 #if USE_FILLSOLIDRECT
     pDC->FillSolidRect(&rectRule, pRule->GetBackgroundColor());
 #endif
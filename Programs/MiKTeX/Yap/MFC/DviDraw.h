@@ -50,12 +50,21 @@ protected:
 protected:
   virtual ~DviDraw();
 
+protected:
+  void DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage, int shrinkFactor);
+
 protected:
   void DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage);
 
+protected:
+  void DrawDibChunks(CDC* pDC, DviDoc* pDoc, DviPage* pPage, int shrinkFactor);
+
 protected:
   void DrawDibChunks(CDC* pDC, DviDoc* pDoc, DviPage* pPage);
 
+protected:
+  void DrawRules(CDC* pDC, bool blackBoards, DviDoc* pDoc, DviPage* pPage, int shrinkFactor);
+
 protected:
   void DrawRules(CDC* pDC, bool blackBoards, DviDoc* pDoc, DviPage* pPage);
 
@@ -66,7 +75,7 @@ private:
   HPALETTE CreateDviBitmapPalette(COLORREF foreColor, COLORREF backColor, size_t nColors);
 
 private:
-  BITMAPINFO* MakeBitmapInfo(size_t width, size_t height, size_t dpi, size_t bytesPerLine, DviDoc* pDoc);
+  BITMAPINFO* MakeBitmapInfo(size_t width, size_t height, size_t dpi, size_t bytesPerLine, int shrinkFactor);
 
 protected:
   map<foreback, HPALETTE> foregroundPalettes;
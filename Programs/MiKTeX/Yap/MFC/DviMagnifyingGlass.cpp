@@ -26,6 +26,7 @@
 
 #include "DviDoc.h"
 #include "DviView.h"
+#include "TileCache.h"
 
 #include "DviMagnifyingGlass.h"
 
@@ -92,8 +93,6 @@ void DviMagnifyingGlass::OnPaint()
 
     MIKTEX_ASSERT(shrinkFactor > 0);
 
-    AutoRestoreDisplayShrinkFactor autoRestorShrinkFactor(pDviDoc, pDviDoc->SetDisplayShrinkFactor(shrinkFactor));
-
     CPaintDC dc(this);
 
     CDC dcMem;
@@ -128,12 +127,17 @@ void DviMagnifyingGlass::OnPaint()
 
     dcMem.SetViewportOrg(CPoint(-(x / shrinkFactor) + sizeWindow.cx / 2, -(y / shrinkFactor) + sizeWindow.cy / 2));
 
+    // the glass moves with the mouse: the surrounding tiles are rendered
+    // in the background
+    CRect rectGlass(CPoint(x / shrinkFactor - sizeWindow.cx / 2, y / shrinkFactor - sizeWindow.cy / 2), sizeWindow);
+    CRect rectAround(rectGlass);
+    rectAround.InflateRect(sizeWindow);
+
     try
     {
-      DrawRules(&dcMem, true, pDviDoc, pPage);
-      DrawDviBitmaps(&dcMem, pDviDoc, pPage);
-      DrawDibChunks(&dcMem, pDviDoc, pPage);
-      DrawRules(&dcMem, false, pDviDoc, pPage);
+      TileCache* tileCache = pDviDoc->GetTileCache();
+      tileCache->Draw(&dcMem, pPage, pageIdx, shrinkFactor, rectGlass);
+      tileCache->Prefetch(pageIdx, shrinkFactor, rectAround);
     }
     catch (const exception&)
     {
@@ -1,6 +1,6 @@
 /* DviView.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of Yap.
 
@@ -1707,7 +1707,7 @@ void DviView::OnViewRefresh()
     DviDoc* pDoc = GetDocument();
     ASSERT_VALID(pDoc);
     int pageIdx = curPageIdx;
-    pDoc->Reread();
+    pDoc->Refresh();
     if (pageIdx < pDoc->GetPageCount())
     {
       curPageIdx = pageIdx;
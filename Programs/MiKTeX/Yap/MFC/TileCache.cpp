@@ -0,0 +1,299 @@
+/**
+ * @file TileCache.cpp
+ * @author Christian Schenk
+ * @brief Cache of rendered page tiles
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of Yap.
+ *
+ * Yap is licensed under GNU General Public License version 2 or any later
+ * version.
+ */
+
+#include "StdAfx.h"
+
+#include "yap.h"
+
+#include "DviDoc.h"
+
+#include "TileCache.h"
+
+// edge length of a tile (pixels)
+constexpr int TILE_SIZE = 256;
+
+// 256 32-bit tiles take 64 MB
+constexpr size_t MAX_TILES = 256;
+
+// floor division: tiles also cover content left of and above the page origin
+static int TileIndex(int coordinate)
+{
+  return coordinate >= 0 ? coordinate / TILE_SIZE : -((-coordinate + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+TileCache::TileCache(DviDoc* pDviDoc) :
+  pDviDoc(pDviDoc)
+{
+  worker = thread(&TileCache::WorkerThread, this);
+}
+
+TileCache::~TileCache()
+{
+  try
+  {
+    {
+      lock_guard<mutex> lock(mux);
+      stop = true;
+    }
+    requestAvailable.notify_all();
+    if (worker.joinable())
+    {
+      worker.join();
+    }
+    for (auto& kv : tiles)
+    {
+      DeleteObject(kv.second.hBitmap);
+    }
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+CRect TileCache::GetTileRect(const Key& key)
+{
+  return CRect(key.column * TILE_SIZE, key.row * TILE_SIZE, (key.column + 1) * TILE_SIZE, (key.row + 1) * TILE_SIZE);
+}
+
+void TileCache::Draw(CDC* pDC, DviPage* pPage, int pageIdx, int shrinkFactor, const CRect& rect)
+{
+  if (rect.IsRectEmpty())
+  {
+    return;
+  }
+  CDC dcMem;
+  if (!dcMem.CreateCompatibleDC(pDC))
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  Evict();
+  for (int row = TileIndex(rect.top); row <= TileIndex(rect.bottom - 1); ++row)
+  {
+    for (int column = TileIndex(rect.left); column <= TileIndex(rect.right - 1); ++column)
+    {
+      Key key{ pageIdx, shrinkFactor, column, row };
+      CRect rectTile = GetTileRect(key);
+      HBITMAP hBitmap = nullptr;
+      {
+        lock_guard<mutex> lock(mux);
+        auto it = tiles.find(key);
+        if (it != tiles.end())
+        {
+          it->second.lastUse = ++clock;
+          hBitmap = it->second.hBitmap;
+        }
+      }
+      if (hBitmap == nullptr)
+      {
+        hBitmap = Insert(key, foregroundRenderer.Render(pDviDoc, pPage, shrinkFactor, rectTile));
+      }
+      // tiles are evicted and cleared on this thread only: the bitmap stays
+      // valid
+      HGDIOBJ hOldBitmap = SelectObject(dcMem.GetSafeHdc(), hBitmap);
+      if (hOldBitmap == nullptr)
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      BOOL done = pDC->BitBlt(rectTile.left, rectTile.top, TILE_SIZE, TILE_SIZE, &dcMem, 0, 0, SRCAND);
+      SelectObject(dcMem.GetSafeHdc(), hOldBitmap);
+      if (!done)
+      {
+        MIKTEX_FATAL_WINDOWS_ERROR("BitBlt");
+      }
+    }
+  }
+}
+
+void TileCache::Prefetch(int pageIdx, int shrinkFactor, const CRect& rect)
+{
+  if (rect.IsRectEmpty() || pageIdx < 0 || pageIdx >= pDviDoc->GetPageCount())
+  {
+    return;
+  }
+  bool queuedAny = false;
+  {
+    lock_guard<mutex> lock(mux);
+    for (int row = TileIndex(rect.top); row <= TileIndex(rect.bottom - 1); ++row)
+    {
+      for (int column = TileIndex(rect.left); column <= TileIndex(rect.right - 1); ++column)
+      {
+        Key key{ pageIdx, shrinkFactor, column, row };
+        if (tiles.find(key) == tiles.end() && queued.insert(key).second)
+        {
+          requests.push_back(key);
+          queuedAny = true;
+        }
+      }
+    }
+  }
+  if (queuedAny)
+  {
+    requestAvailable.notify_one();
+  }
+}
+
+void TileCache::Clear()
+{
+  unique_lock<mutex> lock(mux);
+  requests.clear();
+  queued.clear();
+  renderingDone.wait(lock, [this]() { return !rendering; });
+  for (auto& kv : tiles)
+  {
+    DeleteObject(kv.second.hBitmap);
+  }
+  tiles.clear();
+}
+
+HBITMAP TileCache::Insert(const Key& key, HBITMAP hBitmap)
+{
+  lock_guard<mutex> lock(mux);
+  queued.erase(key);
+  Tile& tile = tiles[key];
+  if (tile.hBitmap != nullptr)
+  {
+    // rendered twice: the existing bitmap might be in use
+    DeleteObject(hBitmap);
+  }
+  else
+  {
+    tile.hBitmap = hBitmap;
+  }
+  tile.lastUse = ++clock;
+  return tile.hBitmap;
+}
+
+void TileCache::Evict()
+{
+  lock_guard<mutex> lock(mux);
+  while (tiles.size() > MAX_TILES)
+  {
+    auto victim = std::min_element(tiles.begin(), tiles.end(), [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+    DeleteObject(victim->second.hBitmap);
+    tiles.erase(victim);
+  }
+}
+
+void TileCache::WorkerThread()
+{
+  // the palettes of the foreground renderer belong to the UI thread
+  Renderer renderer;
+  while (true)
+  {
+    Key key;
+    {
+      unique_lock<mutex> lock(mux);
+      requestAvailable.wait(lock, [this]() { return stop || !requests.empty(); });
+      if (stop)
+      {
+        return;
+      }
+      key = requests.front();
+      requests.pop_front();
+      if (tiles.find(key) != tiles.end())
+      {
+        queued.erase(key);
+        continue;
+      }
+      rendering = true;
+    }
+    HBITMAP hBitmap = nullptr;
+    try
+    {
+      DviPage* pPage = pDviDoc->GetLoadedPage(key.pageIdx);
+      if (pPage != nullptr)
+      {
+        AutoUnlockPage autoUnlockPage(pPage);
+        hBitmap = renderer.Render(pDviDoc, pPage, key.shrinkFactor, GetTileRect(key));
+      }
+    }
+    catch (const exception&)
+    {
+      // the tile will be rendered on demand
+    }
+    // inserted before Clear() can proceed: no tile outlives its DVI object
+    if (hBitmap != nullptr)
+    {
+      Insert(key, hBitmap);
+    }
+    {
+      lock_guard<mutex> lock(mux);
+      queued.erase(key);
+      rendering = false;
+    }
+    renderingDone.notify_all();
+  }
+}
+
+HBITMAP TileCache::Renderer::Render(DviDoc* pDviDoc, DviPage* pPage, int shrinkFactor, const CRect& rectTile)
+{
+  if (gamma != g_pYapConfig->gamma)
+  {
+    gamma = g_pYapConfig->gamma;
+    InitializeDviBitmapPalettes();
+  }
+
+  BITMAPINFO bitmapInfo;
+  ZeroMemory(&bitmapInfo, sizeof(bitmapInfo));
+  bitmapInfo.bmiHeader.biSize = sizeof(bitmapInfo.bmiHeader);
+  bitmapInfo.bmiHeader.biWidth = TILE_SIZE;
+  bitmapInfo.bmiHeader.biHeight = -TILE_SIZE;
+  bitmapInfo.bmiHeader.biPlanes = 1;
+  bitmapInfo.bmiHeader.biBitCount = 32;
+  bitmapInfo.bmiHeader.biCompression = BI_RGB;
+  void* pBits = nullptr;
+  HBITMAP hBitmap = CreateDIBSection(nullptr, &bitmapInfo, DIB_RGB_COLORS, &pBits, nullptr, 0);
+  if (hBitmap == nullptr)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR("CreateDIBSection");
+  }
+
+  try
+  {
+    CDC dcMem;
+    if (!dcMem.CreateCompatibleDC(nullptr))
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    HGDIOBJ hOldBitmap = SelectObject(dcMem.GetSafeHdc(), hBitmap);
+    if (hOldBitmap == nullptr)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    try
+    {
+      if (!dcMem.PatBlt(0, 0, TILE_SIZE, TILE_SIZE, WHITENESS))
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      dcMem.SetViewportOrg(-rectTile.TopLeft());
+      DrawRules(&dcMem, true, pDviDoc, pPage, shrinkFactor);
+      DrawDviBitmaps(&dcMem, pDviDoc, pPage, shrinkFactor);
+      DrawDibChunks(&dcMem, pDviDoc, pPage, shrinkFactor);
+      DrawRules(&dcMem, false, pDviDoc, pPage, shrinkFactor);
+    }
+    catch (const exception&)
+    {
+      SelectObject(dcMem.GetSafeHdc(), hOldBitmap);
+      throw;
+    }
+    SelectObject(dcMem.GetSafeHdc(), hOldBitmap);
+  }
+  catch (const exception&)
+  {
+    DeleteObject(hBitmap);
+    throw;
+  }
+
+  return hBitmap;
+}
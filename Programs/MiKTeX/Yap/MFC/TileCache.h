@@ -0,0 +1,144 @@
+/**
+ * @file TileCache.h
+ * @author Christian Schenk
+ * @brief Cache of rendered page tiles
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of Yap.
+ *
+ * Yap is licensed under GNU General Public License version 2 or any later
+ * version.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "DviDraw.h"
+
+class DviDoc;
+
+/// Caches the raster layer (rules, glyphs and DIB chunks) of DVI pages as
+/// bitmap tiles, keyed by page and shrink factor.
+///
+/// Missing tiles are rendered on the calling thread.  Tiles which are
+/// likely to be needed next (the neighbourhood of the visible region) are
+/// rendered on a background thread.  Tiles are combined with the
+/// destination by SRCAND: white tile pixels leave the paper and the
+/// graphics inclusions untouched.
+class TileCache
+{
+public:
+  TileCache(DviDoc* pDviDoc);
+
+public:
+  TileCache(const TileCache& other) = delete;
+
+public:
+  TileCache& operator=(const TileCache& other) = delete;
+
+public:
+  ~TileCache();
+
+  /// Draws a region of a locked page.
+  /// @param pDC The destination; the viewport origin is the page origin.
+  /// @param rect The region in page coordinates.
+public:
+  void Draw(CDC* pDC, DviPage* pPage, int pageIdx, int shrinkFactor, const CRect& rect);
+
+  /// Queues the tiles of a page region for background rendering.
+public:
+  void Prefetch(int pageIdx, int shrinkFactor, const CRect& rect);
+
+  /// Waits for the background renderer and discards all tiles.  Must be
+  /// called before the DVI object is deleted or its pages are changed.
+public:
+  void Clear();
+
+private:
+  struct Key
+  {
+    int pageIdx;
+    int shrinkFactor;
+    int column;
+    int row;
+    bool operator<(const Key& other) const
+    {
+      return pageIdx != other.pageIdx ? pageIdx < other.pageIdx
+        : shrinkFactor != other.shrinkFactor ? shrinkFactor < other.shrinkFactor
+        : column != other.column ? column < other.column
+        : row < other.row;
+    }
+  };
+
+private:
+  struct Tile
+  {
+    HBITMAP hBitmap = nullptr;
+    unsigned long long lastUse = 0;
+  };
+
+  /// Renders tiles; each thread needs its own palettes.
+private:
+  class Renderer :
+    public DviDraw
+  {
+  public:
+    HBITMAP Render(DviDoc* pDviDoc, DviPage* pPage, int shrinkFactor, const CRect& rectTile);
+  };
+
+private:
+  static CRect GetTileRect(const Key& key);
+
+  /// Adds a rendered tile; returns the cached bitmap.
+private:
+  HBITMAP Insert(const Key& key, HBITMAP hBitmap);
+
+  /// Deletes the least recently used tiles.  UI thread only.
+private:
+  void Evict();
+
+private:
+  void WorkerThread();
+
+private:
+  unsigned long long clock = 0;
+
+private:
+  DviDoc* pDviDoc;
+
+private:
+  Renderer foregroundRenderer;
+
+private:
+  std::mutex mux;
+
+private:
+  std::set<Key> queued;
+
+private:
+  std::deque<Key> requests;
+
+private:
+  bool rendering = false;
+
+private:
+  std::condition_variable renderingDone;
+
+private:
+  std::condition_variable requestAvailable;
+
+private:
+  bool stop = false;
+
+private:
+  std::map<Key, Tile> tiles;
+
+private:
+  std::thread worker;
+};
@@ -25,6 +25,7 @@
 #include "DviView.h"
 #include "ErrorDialog.h"
 #include "MainFrame.h"
+#include "TileCache.h"
 
 void DviView::OnDraw(CDC* pDC)
 {
@@ -72,6 +73,10 @@ void DviView::OnDraw(CDC* pDC)
     {
       gamma = g_pYapConfig->gamma;
       InitializeDviBitmapPalettes();
+      if (!pDoc->IsPrintContext())
+      {
+        pDoc->ClearTileCache();
+      }
     }
 
     // select default glyph palette
@@ -146,6 +151,14 @@ void DviView::OnDraw(CDC* pDC)
       // draw the page
       DrawPage(pDC, pageIdx);
     }
+
+    // the top of the next page
+    if (!pDoc->IsPrintContext())
+    {
+      CRect rectClient;
+      GetClientRect(&rectClient);
+      pDoc->GetTileCache()->Prefetch(pageIdx2 + 1, pDoc->GetShrinkFactor(), CRect(0, 0, sizePage.cx, std::min<int>(sizePage.cy, rectClient.Height())));
+    }
   }
 
   catch (const DrawingCancelledException &)
@@ -210,17 +223,43 @@ void DviView::DrawPage(CDC* pDC, int pageIdx)
     RenderGraphicsInclusions(pDC, pPage);
   }
 
-  // draw background rules
-  DrawRules(pDC, true, pDoc, pPage);
+  if (pDoc->IsPrintContext())
+  {
+    // draw background rules
+    DrawRules(pDC, true, pDoc, pPage);
 
-  // draw DVI bitmaps
-  DrawDviBitmaps(pDC, pDoc, pPage);
+    // draw DVI bitmaps
+    DrawDviBitmaps(pDC, pDoc, pPage);
 
-  // draw DIB chunks
-  DrawDibChunks(pDC, pDoc, pPage);
+    // draw DIB chunks
+    DrawDibChunks(pDC, pDoc, pPage);
 
-  // draw foreground rules
-  DrawRules(pDC, false, pDoc, pPage);
+    // draw foreground rules
+    DrawRules(pDC, false, pDoc, pPage);
+  }
+  else
+  {
+    // draw rules, DVI bitmaps and DIB chunks from cached tiles
+    CRect rectPage(CPoint(0, 0), pDoc->GetPaperSize());
+    CRect rectClip;
+    if (pDC->GetClipBox(&rectClip) == ERROR)
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR("GetClipBox");
+    }
+    CRect rectVisible;
+    if (rectVisible.IntersectRect(rectClip, rectPage))
+    {
+      TileCache* tileCache = pDoc->GetTileCache();
+      tileCache->Draw(pDC, pPage, pageIdx, pDoc->GetShrinkFactor(), rectVisible);
+      // the next scroll step in either direction
+      CRect rectNext(rectVisible);
+      rectNext.InflateRect(0, rectVisible.Height());
+      if (rectNext.IntersectRect(rectNext, rectPage))
+      {
+        tileCache->Prefetch(pageIdx, pDoc->GetShrinkFactor(), rectNext);
+      }
+    }
+  }
 
   // interpret non-graphics specials
   DrawSpecials(pDC, 3, pPage, pageIdx);
@@ -0,0 +1,266 @@
+/**
+ * @file Benchmark.cpp
+ * @author Christian Schenk
+ * @brief Benchmark harness
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX benchmark suite.
+ *
+ * The MiKTeX benchmark suite is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <nlohmann/json.hpp>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Utils>
+#include <miktex/Wrappers/PoptWrapper>
+
+#include "Benchmark.h"
+
+using namespace std;
+
+using namespace nlohmann;
+
+using namespace MiKTeX::Benchmarks;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+enum Option
+{
+    OPT_AAA = 1,
+    OPT_BASELINE,
+    OPT_FILTER,
+    OPT_OUTPUT,
+    OPT_REPETITIONS,
+    OPT_TOLERANCE,
+    OPT_WORK_DIRECTORY,
+};
+
+static const struct poptOption options[] =
+{
+    {
+        "baseline", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_BASELINE,
+        "Compare the results with those in FILE.",
+        "FILE"
+    },
+    {
+        "filter", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_FILTER,
+        "Run only the benchmarks whose names contain TEXT.",
+        "TEXT"
+    },
+    {
+        "output", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_OUTPUT,
+        "Write the results to FILE.",
+        "FILE"
+    },
+    {
+        "repetitions", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_REPETITIONS,
+        "Run each benchmark N times (default: 10).",
+        "N"
+    },
+    {
+        "tolerance", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_TOLERANCE,
+        "Tolerate a slowdown of PERCENT compared with the baseline (default: 10).",
+        "PERCENT"
+    },
+    {
+        "work-directory", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_WORK_DIRECTORY,
+        "Create the benchmark files in DIR.",
+        "DIR"
+    },
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+bool BenchmarkRunner::ParseCommandLine(int argc, const char** argv)
+{
+    PoptWrapper popt(argc, argv, options);
+    popt.SetOtherOptionHelp("[OPTION...] [ARG...]");
+    int option;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+        string optArg = popt.GetOptArg();
+        switch (option)
+        {
+        case OPT_BASELINE:
+            baseline = optArg;
+            break;
+        case OPT_FILTER:
+            filter = optArg;
+            break;
+        case OPT_OUTPUT:
+            output = optArg;
+            break;
+        case OPT_REPETITIONS:
+            repetitions = std::max(stoul(optArg), 1ul);
+            break;
+        case OPT_TOLERANCE:
+            tolerance = stod(optArg);
+            break;
+        case OPT_WORK_DIRECTORY:
+            workDirectory = optArg;
+            break;
+        }
+    }
+    if (option != -1)
+    {
+        cerr << fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)) << endl;
+        return false;
+    }
+    arguments = popt.GetLeftovers();
+    if (workDirectory.Empty())
+    {
+        workDirectory.SetToCurrentDirectory();
+        workDirectory /= fmt::format("{0}-benchmarks", suiteName);
+    }
+    workDirectory.MakeFullyQualified();
+    Directory::Create(workDirectory);
+    return true;
+}
+
+bool BenchmarkRunner::IsSelected(const string& name) const
+{
+    return filter.empty() || name.find(filter) != string::npos;
+}
+
+void BenchmarkRunner::Run(const string& name, function<void()> setup, function<void()> run)
+{
+    if (!IsSelected(name))
+    {
+        return;
+    }
+    vector<double> samples;
+    samples.reserve(repetitions);
+    for (size_t idx = 0; idx <= repetitions; ++idx)
+    {
+        if (setup)
+        {
+            setup();
+        }
+        auto start = chrono::steady_clock::now();
+        run();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        // the first run warms up caches
+        if (idx > 0)
+        {
+            samples.push_back(elapsed.count());
+        }
+    }
+    sort(samples.begin(), samples.end());
+    BenchmarkResult result;
+    result.name = name;
+    result.repetitions = samples.size();
+    result.min = samples.front();
+    result.max = samples.back();
+    size_t mid = samples.size() / 2;
+    result.median = samples.size() % 2 == 0 ? (samples[mid - 1] + samples[mid]) / 2 : samples[mid];
+    result.mean = accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    double sumOfSquares = 0;
+    for (double s : samples)
+    {
+        sumOfSquares += (s - result.mean) * (s - result.mean);
+    }
+    result.stddev = sqrt(sumOfSquares / samples.size());
+    cout << fmt::format("{0:<40} median {1:>10.3f} ms  min {2:>10.3f} ms  max {3:>10.3f} ms", name, result.median, result.min, result.max) << endl;
+    results.push_back(result);
+}
+
+void BenchmarkRunner::WriteResults(const PathName& path) const
+{
+    json j_results = json::array();
+    for (const BenchmarkResult& r : results)
+    {
+        j_results.push_back({
+            {"name", r.name},
+            {"unit", "ms"},
+            {"repetitions", r.repetitions},
+            {"min", r.min},
+            {"median", r.median},
+            {"mean", r.mean},
+            {"max", r.max},
+            {"stddev", r.stddev}
+        });
+    }
+    char timestamp[32];
+    time_t now = time(nullptr);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    json j = {
+        {"suite", suiteName},
+        {"miktexVersion", Utils::GetMiKTeXVersionString()},
+        {"timestamp", timestamp},
+        {"results", j_results}
+    };
+    ofstream stream = File::CreateOutputStream(path);
+    stream << j.dump(2) << "\n";
+    stream.close();
+}
+
+bool BenchmarkRunner::CompareWithBaseline(const PathName& path) const
+{
+    ifstream stream = File::CreateInputStream(path);
+    json j = json::parse(stream);
+    unordered_map<string, double> baselineMedians;
+    for (const json& j_result : j["results"])
+    {
+        baselineMedians[j_result["name"].get<string>()] = j_result["median"].get<double>();
+    }
+    bool ok = true;
+    for (const BenchmarkResult& r : results)
+    {
+        auto it = baselineMedians.find(r.name);
+        if (it == baselineMedians.end() || it->second <= 0)
+        {
+            continue;
+        }
+        double change = (r.median - it->second) / it->second * 100;
+        if (change > tolerance)
+        {
+            cout << fmt::format("REGRESSION: {0}: {1:.3f} ms -> {2:.3f} ms ({3:+.1f}%)", r.name, it->second, r.median, change) << endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int BenchmarkRunner::Finish()
+{
+    if (!output.Empty())
+    {
+        WriteResults(output);
+    }
+    if (!baseline.Empty() && !CompareWithBaseline(baseline))
+    {
+        return 1;
+    }
+    return 0;
+}
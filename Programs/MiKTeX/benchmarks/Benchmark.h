@@ -0,0 +1,113 @@
+/**
+ * @file Benchmark.h
+ * @author Christian Schenk
+ * @brief Benchmark harness
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX benchmark suite.
+ *
+ * The MiKTeX benchmark suite is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+namespace MiKTeX
+{
+    namespace Benchmarks
+    {
+        struct BenchmarkResult
+        {
+            std::string name;
+            std::size_t repetitions = 0;
+            double min = 0;
+            double median = 0;
+            double mean = 0;
+            double max = 0;
+            double stddev = 0;
+        };
+
+        /// Runs benchmarks and reports the wall clock time in milliseconds.
+        ///
+        /// Each benchmark is run once to warm up caches, then it is run
+        /// `--repetitions` times. The results are printed, and written as
+        /// JSON, if `--output` is given. If `--baseline` is given, the
+        /// medians are compared with the baseline results: the suite fails,
+        /// if a median exceeds its baseline by more than `--tolerance`
+        /// percent.
+        class BenchmarkRunner
+        {
+
+        public:
+
+            BenchmarkRunner(const std::string& suiteName) :
+                suiteName(suiteName)
+            {
+            }
+
+            /// Parses the command-line.
+            /// @return Returns `false`, if the program should exit.
+            bool ParseCommandLine(int argc, const char** argv);
+
+            /// Runs a benchmark.
+            /// @param name The name of the benchmark.
+            /// @param setup Called before each run; not measured.
+            /// @param run The code to be measured.
+            void Run(const std::string& name, std::function<void()> setup, std::function<void()> run);
+
+            void Run(const std::string& name, std::function<void()> run)
+            {
+                Run(name, nullptr, run);
+            }
+
+            /// Writes the results and compares them with the baseline.
+            /// @return Returns the exit code of the program.
+            int Finish();
+
+            const std::vector<std::string>& GetArguments() const
+            {
+                return arguments;
+            }
+
+            const MiKTeX::Util::PathName& GetWorkDirectory() const
+            {
+                return workDirectory;
+            }
+
+        private:
+
+            bool IsSelected(const std::string& name) const;
+
+            void WriteResults(const MiKTeX::Util::PathName& path) const;
+
+            bool CompareWithBaseline(const MiKTeX::Util::PathName& path) const;
+
+            std::vector<std::string> arguments;
+
+            MiKTeX::Util::PathName baseline;
+
+            std::string filter;
+
+            MiKTeX::Util::PathName output;
+
+            std::size_t repetitions = 10;
+
+            std::vector<BenchmarkResult> results;
+
+            std::string suiteName;
+
+            double tolerance = 10;
+
+            MiKTeX::Util::PathName workDirectory;
+        };
+    }
+}
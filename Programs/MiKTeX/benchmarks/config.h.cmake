@@ -0,0 +1,19 @@
+/**
+ * @file config.h
+ * @author Christian Schenk
+ * @brief Benchmark configuration (created from config.h.cmake)
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX benchmark suite.
+ *
+ * The MiKTeX benchmark suite is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#pragma once
+
+#define CORPUS_DIR "@CMAKE_CURRENT_SOURCE_DIR@/corpus"
+
+#define DATAROOT "@dataroot@"
+#define INSTALLROOT "@installroot@"
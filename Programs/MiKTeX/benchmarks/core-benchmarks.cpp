@@ -0,0 +1,341 @@
+/**
+ * @file core-benchmarks.cpp
+ * @author Christian Schenk
+ * @brief Benchmarks for the file name database, the file search, the
+ * configuration file parser and the archive extractor
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX benchmark suite.
+ *
+ * The MiKTeX benchmark suite is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <lzma.h>
+
+#include <miktex/Core/Cfg>
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Session>
+#include <miktex/Core/Utils>
+#include <miktex/Extractor/Extractor>
+#include <miktex/Util/PathName>
+
+#include "Benchmark.h"
+
+using namespace std;
+
+using namespace MiKTeX::Benchmarks;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Extractor;
+using namespace MiKTeX::Util;
+
+// the synthetic TEXMF tree: changing one of these values invalidates
+// existing baselines
+constexpr int PACKAGE_COUNT = 400;
+constexpr int FILES_PER_PACKAGE = 25;
+constexpr int LOOKUP_COUNT = 1000;
+constexpr int CFG_SECTION_COUNT = 2000;
+constexpr int CFG_VALUES_PER_SECTION = 20;
+constexpr int ARCHIVE_FILE_COUNT = 500;
+constexpr size_t ARCHIVE_FILE_SIZE = 16 * 1024;
+
+static const char* const FILE_NAME_EXTENSIONS[] = { ".sty", ".cls", ".tex", ".tfm", ".def" };
+
+static string PackageName(int pkg)
+{
+    return fmt::format("pkg{0:04}", pkg);
+}
+
+static string FileName(int pkg, int file)
+{
+    return fmt::format("{0}-{1:02}{2}", PackageName(pkg), file, FILE_NAME_EXTENSIONS[file % (sizeof(FILE_NAME_EXTENSIONS) / sizeof(FILE_NAME_EXTENSIONS[0]))]);
+}
+
+// creates the synthetic TEXMF tree, unless it exists
+static void MakeTexmfTree(const PathName& root)
+{
+    PathName stamp = root / "tree-complete";
+    if (File::Exists(stamp))
+    {
+        return;
+    }
+    for (int pkg = 0; pkg < PACKAGE_COUNT; ++pkg)
+    {
+        PathName dir = root / "tex" / "latex" / PackageName(pkg) / "base";
+        Directory::Create(dir);
+        for (int file = 0; file < FILES_PER_PACKAGE; ++file)
+        {
+            File::WriteBytes(dir / FileName(pkg, file), { '%', '\n' });
+        }
+    }
+    File::WriteBytes(stamp, {});
+}
+
+static PathName MakeLargeIni(const PathName& dir)
+{
+    PathName path = dir / "large.ini";
+    if (File::Exists(path))
+    {
+        return path;
+    }
+    string text;
+    for (int section = 0; section < CFG_SECTION_COUNT; ++section)
+    {
+        text += fmt::format("[section{0}]\n", section);
+        for (int value = 0; value < CFG_VALUES_PER_SECTION; ++value)
+        {
+            text += fmt::format("value{0}=The quick brown fox jumps over the lazy dog {1}\n", value, section * CFG_VALUES_PER_SECTION + value);
+        }
+        text += "list[]=first\nlist[]=second\n\n";
+    }
+    File::WriteBytes(path, vector<unsigned char>(text.begin(), text.end()));
+    return path;
+}
+
+// the line-by-line way of parsing, which Cfg::Read() is compared with
+static size_t ReadIniLineByLine(const PathName& path)
+{
+    unordered_map<string, unordered_map<string, vector<string>>> keys;
+    ifstream reader = File::CreateInputStream(path);
+    string lookupKeyName;
+    for (string line; std::getline(reader, line); )
+    {
+        size_t first = line.find_first_not_of(" \t\r\n");
+        line = first == string::npos ? string() : line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
+        if (line.empty() || line[0] == ';')
+        {
+            continue;
+        }
+        if (line[0] == '[')
+        {
+            lookupKeyName = Utils::MakeLower(line.substr(1, line.find(']') - 1));
+            continue;
+        }
+        size_t posEqual = line.find('=');
+        if (posEqual == string::npos)
+        {
+            continue;
+        }
+        keys[lookupKeyName][Utils::MakeLower(line.substr(0, posEqual))].push_back(line.substr(posEqual + 1));
+    }
+    return keys.size();
+}
+
+static void AppendTarHeader(vector<unsigned char>& tar, const string& name, size_t size)
+{
+    unsigned char header[512];
+    memset(header, 0, sizeof(header));
+    auto field = [&header](size_t offset, size_t length, const string& value)
+    {
+        memcpy(header + offset, value.c_str(), std::min(length, value.length()));
+    };
+    field(0, 100, name);
+    field(100, 8, "0000644");
+    field(108, 8, "0000000");
+    field(116, 8, "0000000");
+    field(124, 12, fmt::format("{0:011o}", size));
+    field(136, 12, fmt::format("{0:011o}", 0));
+    field(148, 8, "        ");
+    header[156] = '0';
+    field(257, 6, "ustar");
+    field(263, 2, "00");
+    unsigned checkSum = 0;
+    for (unsigned char ch : header)
+    {
+        checkSum += ch;
+    }
+    field(148, 8, fmt::format("{0:06o}", checkSum));
+    header[154] = 0;
+    tar.insert(tar.end(), header, header + sizeof(header));
+}
+
+// creates a .tar.xz archive, unless it exists
+static PathName MakeArchive(const PathName& dir)
+{
+    PathName path = dir / "archive.tar.xz";
+    if (File::Exists(path))
+    {
+        return path;
+    }
+    vector<unsigned char> tar;
+    for (int file = 0; file < ARCHIVE_FILE_COUNT; ++file)
+    {
+        AppendTarHeader(tar, fmt::format("texmf/tex/latex/archive/file{0:04}.tex", file), ARCHIVE_FILE_SIZE);
+        // compressible, but not trivially compressible
+        for (size_t idx = 0; idx < ARCHIVE_FILE_SIZE; ++idx)
+        {
+            tar.push_back(static_cast<unsigned char>("\\relax %\n"[(idx * 7 + file) % 9]));
+        }
+    }
+    tar.insert(tar.end(), 1024, 0);
+    vector<unsigned char> xz(lzma_stream_buffer_bound(tar.size()));
+    size_t xzSize = 0;
+    if (lzma_easy_buffer_encode(6, LZMA_CHECK_CRC64, nullptr, tar.data(), tar.size(), xz.data(), &xzSize, xz.size()) != LZMA_OK)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    xz.resize(xzSize);
+    File::WriteBytes(path, xz);
+    return path;
+}
+
+static void RunBenchmarks(BenchmarkRunner& runner, shared_ptr<Session> session)
+{
+    PathName installRoot = session->GetSpecialPath(SpecialPath::InstallRoot);
+    MakeTexmfTree(installRoot);
+    unsigned rootIdx = session->DeriveTEXMFRoot(installRoot);
+    PathName fndbPath = session->GetFilenameDatabasePathName(rootIdx);
+    string pathPattern = fmt::format("{0}/tex//", installRoot.ToString());
+
+    vector<string> hits;
+    vector<string> misses;
+    for (int idx = 0; idx < LOOKUP_COUNT; ++idx)
+    {
+        // a fixed stride visits all packages in the same order on every run
+        int pkg = (idx * 7919) % PACKAGE_COUNT;
+        hits.push_back(FileName(pkg, idx % FILES_PER_PACKAGE));
+        misses.push_back(fmt::format("missing{0:04}.sty", idx));
+    }
+
+    runner.Run("fndb/create", [&]()
+    {
+        Fndb::Create(fndbPath, installRoot, nullptr);
+    });
+
+    runner.Run("fndb/load", [&]()
+    {
+        session->UnloadFilenameDatabase();
+    }, [&]()
+    {
+        vector<Fndb::Record> result;
+        Fndb::Search(PathName(hits[0]), pathPattern, false, result);
+    });
+
+    runner.Run("fndb/search-hit", [&]()
+    {
+        vector<Fndb::Record> result;
+        for (const string& fileName : hits)
+        {
+            result.clear();
+            Fndb::Search(PathName(fileName), pathPattern, false, result);
+        }
+    });
+
+    runner.Run("fndb/search-miss", [&]()
+    {
+        vector<Fndb::Record> result;
+        for (const string& fileName : misses)
+        {
+            result.clear();
+            Fndb::Search(PathName(fileName), pathPattern, false, result);
+        }
+    });
+
+    runner.Run("findfile/hit", [&]()
+    {
+        PathName path;
+        for (const string& fileName : hits)
+        {
+            session->FindFile(fileName, "%R/tex//", path);
+        }
+    });
+
+    runner.Run("findfile/miss", [&]()
+    {
+        PathName path;
+        for (const string& fileName : misses)
+        {
+            session->FindFile(fileName, "%R/tex//", path);
+        }
+    });
+
+    PathName workDirectory = runner.GetWorkDirectory();
+
+    PathName largeIni = MakeLargeIni(workDirectory);
+    runner.Run("cfg/read", [&]()
+    {
+        unique_ptr<Cfg> cfg = Cfg::Create();
+        cfg->Read(largeIni);
+    });
+
+    runner.Run("cfg/read-stream", [&]()
+    {
+        ifstream reader = File::CreateInputStream(largeIni);
+        unique_ptr<Cfg> cfg = Cfg::Create();
+        cfg->Read(reader);
+    });
+
+    runner.Run("cfg/read-line-by-line", [&]()
+    {
+        ReadIniLineByLine(largeIni);
+    });
+
+    PathName archive = MakeArchive(workDirectory);
+    PathName destDir = workDirectory / "extracted";
+    runner.Run("extract/tar-xz", [&]()
+    {
+        if (Directory::Exists(destDir))
+        {
+            Directory::Delete(destDir, true);
+        }
+    }, [&]()
+    {
+        Extractor::CreateExtractor(ArchiveFileType::TarXz)->Extract(archive, destDir, true);
+    });
+
+    // the files exist already: the extractor compares instead of writing
+    runner.Run("extract/tar-xz-unchanged", [&]()
+    {
+        Extractor::CreateExtractor(ArchiveFileType::TarXz)->Extract(archive, destDir, true);
+    });
+}
+
+int main(int argc, const char** argv)
+{
+    try
+    {
+        Session::InitInfo initInfo(argv[0]);
+        StartupConfig startupConfig;
+        startupConfig.userDataRoot = DATAROOT;
+        startupConfig.userInstallRoot = INSTALLROOT;
+        initInfo.SetStartupConfig(startupConfig);
+        shared_ptr<Session> session = Session::Create(initInfo);
+        BenchmarkRunner runner("core");
+        if (!runner.ParseCommandLine(argc, argv))
+        {
+            return 1;
+        }
+        RunBenchmarks(runner, session);
+        int exitCode = runner.Finish();
+        session->Close();
+        return exitCode;
+    }
+    catch (const MiKTeXException& e)
+    {
+        Utils::PrintException(e);
+        return 1;
+    }
+    catch (const exception& e)
+    {
+        Utils::PrintException(e);
+        return 1;
+    }
+}
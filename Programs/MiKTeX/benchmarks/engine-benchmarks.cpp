@@ -0,0 +1,140 @@
+/**
+ * @file engine-benchmarks.cpp
+ * @author Christian Schenk
+ * @brief Benchmarks for the format loader and for pdfLaTeX runs on a fixed
+ * corpus
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX benchmark suite.
+ *
+ * The MiKTeX benchmark suite is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/FileType>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Core/Utils>
+#include <miktex/Util/PathName>
+
+#include "Benchmark.h"
+
+using namespace std;
+
+using namespace MiKTeX::Benchmarks;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+#define T_(x) MIKTEXTEXT(x)
+
+class ProcessOutputTrash :
+    public IRunProcessCallback
+{
+
+public:
+
+    bool MIKTEXTHISCALL OnProcessOutput(const void*, size_t) override
+    {
+        return true;
+    }
+};
+
+static void RunEngine(const PathName& engine, const vector<string>& arguments, const PathName& outputDirectory)
+{
+    vector<string> args{ engine.GetFileNameWithoutExtension().ToString() };
+    // no on-the-fly package installation while measuring
+    args.push_back("--disable-installer");
+    args.push_back("--interaction=batchmode");
+    args.push_back("--halt-on-error");
+    args.push_back("--output-directory=" + outputDirectory.ToString());
+    args.insert(args.end(), arguments.begin(), arguments.end());
+    ProcessOutputTrash trash;
+    int exitCode;
+    Process::Run(engine, args, &trash, &exitCode, outputDirectory.GetData());
+    if (exitCode != 0)
+    {
+        MIKTEX_FATAL_ERROR_2(T_("The engine run failed."), "engine", engine.ToString(), "exitCode", std::to_string(exitCode));
+    }
+}
+
+static void RunBenchmarks(BenchmarkRunner& runner, shared_ptr<Session> session)
+{
+    PathName pdflatex;
+    if (!session->FindFile("pdflatex", FileType::EXE, pdflatex))
+    {
+        MIKTEX_FATAL_ERROR_2(T_("The engine could not be found."), "engine", "pdflatex");
+    }
+
+    PathName outputDirectory = runner.GetWorkDirectory() / "output";
+    auto cleanOutputDirectory = [&]()
+    {
+        if (Directory::Exists(outputDirectory))
+        {
+            Directory::Delete(outputDirectory, true);
+        }
+        Directory::Create(outputDirectory);
+    };
+
+    // an empty job: the run time is dominated by loading the format file
+    runner.Run("format/undump-pdflatex", cleanOutputDirectory, [&]()
+    {
+        RunEngine(pdflatex, { "\\csname @@end\\endcsname" }, outputDirectory);
+    });
+
+    vector<PathName> corpus;
+    for (const string& arg : runner.GetArguments())
+    {
+        corpus.push_back(PathName(arg));
+    }
+    if (corpus.empty())
+    {
+        for (const char* name : { "article.tex", "math.tex", "tables.tex" })
+        {
+            corpus.push_back(PathName(CORPUS_DIR) / name);
+        }
+    }
+    for (PathName& file : corpus)
+    {
+        file.MakeFullyQualified();
+        runner.Run("pdflatex/" + file.GetFileNameWithoutExtension().ToString(), cleanOutputDirectory, [&]()
+        {
+            RunEngine(pdflatex, { file.ToString() }, outputDirectory);
+        });
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    try
+    {
+        shared_ptr<Session> session = Session::Create(Session::InitInfo(argv[0]));
+        BenchmarkRunner runner("engine");
+        if (!runner.ParseCommandLine(argc, argv))
+        {
+            return 1;
+        }
+        RunBenchmarks(runner, session);
+        int exitCode = runner.Finish();
+        session->Close();
+        return exitCode;
+    }
+    catch (const MiKTeXException& e)
+    {
+        Utils::PrintException(e);
+        return 1;
+    }
+    catch (const exception& e)
+    {
+        Utils::PrintException(e);
+        return 1;
+    }
+}
@@ -35,8 +35,11 @@
 #include <miktex/App/Application>
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/Directory>
 #include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
@@ -91,6 +94,10 @@ private:
     bool GetLine(string &line);
     bool IsSafeGhostscriptOption(const string &o);
     int ReadDosBinary4();
+    MD5 GetCacheKey(const PathName &inputFile, const PathName &gsExe, const vector<string> &gsExtra) const;
+    PathName GetCachedFile(const MD5 &cacheKey) const;
+    void ResolvePdfVersion();
+    void StoreCachedFile(const MD5 &cacheKey, const PathName &outFile);
     unordered_map<string, string> ParsePdfConfigFiles() const;
     void CorrectBoundingBox(double llx, double lly, double urx, double ury);
     void EnsureFontIsAvailable(const string &fontName);
@@ -123,6 +130,7 @@ private:
     bool printOnly = false;
     bool runAsFilter = false;
     bool runGhostscript = true;
+    bool useCache = true;
     map<string, regex> safeGhostscriptOptions = {
         {
             {"AlignToPixels", regex(R"rgx(^0|1$)rgx")},
@@ -230,6 +238,7 @@ enum Option
 {
     OPT_AAA = 1000,
     OPT_ANTIALIASING,
+    OPT_CACHE,
     OPT_COMPRESS,
     OPT_DEBUG,
     OPT_ENLARGE,
@@ -239,6 +248,7 @@ enum Option
     OPT_GSOPT,
     OPT_HIRES,
     OPT_NOANTIALIASING,
+    OPT_NOCACHE,
     OPT_NOCOMPRESS,
     OPT_NODEBUG,
     OPT_NOEXACT,
@@ -257,6 +267,7 @@ enum Option
 struct poptOption EpsToPdfApp::aoption[] = {
 
     {"antialias", 0, POPT_ARG_NONE, nullptr, OPT_ANTIALIASING, T_("Enable anti-aliasing of bitmaps."), nullptr},
+    {"cache", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr, OPT_CACHE, T_("Reuse the results of earlier conversions."), nullptr},
     {"compress", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr, OPT_COMPRESS, T_("Enable PDF compression."), nullptr},
     {"debug", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr, OPT_DEBUG, T_("Write trace messages."), nullptr},
     {"enlarge", 0, POPT_ARG_STRING, nullptr, OPT_ENLARGE, T_("Enlarge bounding box by N PostScript points."), "N"},
@@ -266,6 +277,7 @@ struct poptOption EpsToPdfApp::aoption[] = {
     {"gsopt", 0, POPT_ARG_STRING, nullptr, OPT_GSOPT, T_("Add OPTIONS to the Ghostscript command-line."), T_("OPTIONS")},
     {"hires", 0, POPT_ARG_NONE, nullptr, OPT_HIRES, T_("Scan the EPS file for %%HiResBoundingBox."), nullptr},
     {"noantialias", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr, OPT_NOANTIALIASING, T_("Disable anti-aliasing of bitmaps."), nullptr},
+    {"nocache", 0, POPT_ARG_NONE, nullptr, OPT_NOCACHE, T_("Do not reuse the results of earlier conversions."), nullptr},
     {"nocompress", 0, POPT_ARG_NONE, nullptr, OPT_NOCOMPRESS, T_("Disable PDF compression."), nullptr},
     {"nodebug", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr, OPT_NODEBUG, T_("Do not print debug information."), nullptr},
     {"noexact", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr, OPT_NOEXACT, T_("Do not scan the EPS file for %%ExactBoundingBox."), nullptr},
@@ -631,15 +643,6 @@ void EpsToPdfApp::PrepareOutput(bool runAsFilter, bool runGhostscript, const Pat
         gsOptions.push_back("-dSubsetFonts="s + "true");
         gsOptions.push_back("-dEmbedAllFonts="s + "true");
 #endif
-        if (pdfVersion.empty())
-        {
-            auto cfg = ParsePdfConfigFiles();
-            auto minver = cfg["pdf_minorversion"];
-            if (!minver.empty())
-            {
-                pdfVersion = "1."s + minver;
-            }
-        }
         if (!pdfVersion.empty())
         {
             gsOptions.push_back("-dCompatibilityLevel="s + pdfVersion);
@@ -687,6 +690,63 @@ void EpsToPdfApp::PrepareOutput(bool runAsFilter, bool runGhostscript, const Pat
     }
 }
 
+void EpsToPdfApp::ResolvePdfVersion()
+{
+    if (pdfVersion.empty())
+    {
+        auto cfg = ParsePdfConfigFiles();
+        auto minver = cfg["pdf_minorversion"];
+        if (!minver.empty())
+        {
+            pdfVersion = "1."s + minver;
+        }
+    }
+}
+
+MD5 EpsToPdfApp::GetCacheKey(const PathName &inputFile, const PathName &gsExe, const vector<string> &gsExtra) const
+{
+    // everything which goes into the PDF file: the EPS file, the
+    // bounding box treatment, the Ghostscript options and the
+    // Ghostscript executable
+    MD5Builder md5Builder;
+    MD5 epsDigest = MD5::FromFile(inputFile);
+    md5Builder.Update(epsDigest.data(), epsDigest.size());
+    string settings = fmt::format("{0}\n{1}\n{2}\n{3}\n{4}\n{5}\n",
+        boundingBoxName,
+        enlarge,
+        pdfVersion,
+        CommandLineBuilder(gsExtra).ToString(),
+        gsExe.ToString(),
+        File::GetLastWriteTime(gsExe));
+    md5Builder.Update(settings.c_str(), settings.length());
+    return md5Builder.Final();
+}
+
+PathName EpsToPdfApp::GetCachedFile(const MD5 &cacheKey) const
+{
+    PathName path = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_EPSTOPDF_CACHE_DIR / cacheKey.ToString();
+    path.AppendExtension(".pdf");
+    return path;
+}
+
+void EpsToPdfApp::StoreCachedFile(const MD5 &cacheKey, const PathName &outFile)
+{
+    try
+    {
+        PathName cachedFile = GetCachedFile(cacheKey);
+        Directory::Create(cachedFile.GetDirectoryName());
+        PathName newPath = cachedFile;
+        newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        File::Copy(outFile, newPath);
+        File::Move(newPath, cachedFile, {FileMoveOption::ReplaceExisting});
+    }
+    catch (const MiKTeXException &e)
+    {
+        // the cache is an optimization: a lost cache entry costs only time
+        MyTrace(fmt::format(T_("could not cache the result: {0}"), e.GetErrorMessage()));
+    }
+}
+
 bool EpsToPdfApp::IsSafeGhostscriptOption(const string &o)
 {
     smatch m;
@@ -733,6 +793,9 @@ void EpsToPdfApp::Run(int argc, const char **argv)
         case OPT_ANTIALIASING:
             antiAliasing = true;
             break;
+        case OPT_CACHE:
+            useCache = true;
+            break;
         case OPT_COMPRESS:
             doCompress = true;
             break;
@@ -760,6 +823,9 @@ void EpsToPdfApp::Run(int argc, const char **argv)
         case OPT_NOANTIALIASING:
             antiAliasing = false;
             break;
+        case OPT_NOCACHE:
+            useCache = false;
+            break;
         case OPT_NOCOMPRESS:
             doCompress = false;
             break;
@@ -955,6 +1021,24 @@ void EpsToPdfApp::Run(int argc, const char **argv)
     if (runGhostscript)
     {
         gsExe = session->GetGhostscript(nullptr);
+        ResolvePdfVersion();
+    }
+
+    // the PDF file depends on nothing but the inputs of the cache key:
+    // an earlier conversion can be reused
+    MD5 cacheKey;
+    bool cacheable = useCache && runGhostscript && !runAsFilter && !printOnly;
+    if (cacheable)
+    {
+        cacheKey = GetCacheKey(inputFile, gsExe, gsOptions);
+        PathName cachedFile = GetCachedFile(cacheKey);
+        if (File::Exists(cachedFile))
+        {
+            Verbose(fmt::format(T_("Using the result of an earlier conversion ({0})..."), Q_(cachedFile)));
+            File::Copy(cachedFile, outFile);
+            Finalize2(0);
+            return;
+        }
     }
 
     PrepareInput(runAsFilter, inputFile);
@@ -1001,6 +1085,11 @@ void EpsToPdfApp::Run(int argc, const char **argv)
         }
     }
 
+    if (cacheable)
+    {
+        StoreCachedFile(cacheKey, outFile);
+    }
+
     Finalize2(0);
 }
 
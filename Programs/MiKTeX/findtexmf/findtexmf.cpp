@@ -25,6 +25,7 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <iomanip>
@@ -47,6 +48,8 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <nlohmann/json.hpp>
+
 using namespace MiKTeX::App;
 using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
@@ -77,9 +80,27 @@ private:
 private:
   void PrintSearchPath(const char* lpszSearchPath);
 
+private:
+  FileType GetFileType(const string& fileTypeName);
+
+private:
+  bool Find(const string& fileName, FileType fileType, PathName& path);
+
+private:
+  void PrintResult(const string& fileName, FileType fileType, bool found, const PathName& path);
+
+private:
+  int RunBatch();
+
 public:
   int Run(int argc, const char** argv);
 
+private:
+  bool batch = false;
+
+private:
+  bool json = false;
+
 private:
   bool mustExist = false;
 
@@ -92,6 +113,12 @@ private:
 private:
   shared_ptr<Session> session;
 
+private:
+  unordered_map<string, FileType> fileTypes;
+
+private:
+  unordered_map<string, PathName> foundFiles;
+
 private:
   static const struct poptOption aoption[];
 };
@@ -100,9 +127,11 @@ enum Option
 {
   OPT_AAA = 256,
   OPT_ALIAS,
+  OPT_BATCH,
   OPT_EXPAND_PATH,
   OPT_EXPAND_VAR,
   OPT_FILE_TYPE,
+  OPT_JSON,
   OPT_LIST_FILE_TYPES,
   OPT_MUST_EXIST,
   OPT_SHOW_PATH,
@@ -121,6 +150,14 @@ const struct poptOption FindTeXMF::aoption[] =
     T_("APP")
   },
 
+  {
+    "batch", 0,
+    POPT_ARG_NONE | POPT_ARGFLAG_ONEDASH, nullptr,
+    OPT_BATCH,
+    T_("Read the queries from standard input: one file name per line, optionally followed by a tab character and a file type."),
+    nullptr
+  },
+
   {
     "engine", 0,
     POPT_ARG_STRING | POPT_ARGFLAG_ONEDASH | POPT_ARGFLAG_DOC_HIDDEN, nullptr,
@@ -137,6 +174,14 @@ const struct poptOption FindTeXMF::aoption[] =
     T_("FILETYPE"),
   },
 
+  {
+    "json", 0,
+    POPT_ARG_NONE | POPT_ARGFLAG_ONEDASH, nullptr,
+    OPT_JSON,
+    T_("Print one JSON object per query."),
+    nullptr
+  },
+
   {
     "list-file-types", 0,
     POPT_ARG_NONE | POPT_ARGFLAG_ONEDASH, nullptr,
@@ -238,6 +283,110 @@ void FindTeXMF::PrintSearchPath(const char* lpszSearchPath)
   cout << endl;
 }
 
+FileType FindTeXMF::GetFileType(const string& fileTypeName)
+{
+  auto it = fileTypes.find(fileTypeName);
+  if (it == fileTypes.end())
+  {
+    it = fileTypes.insert({ fileTypeName, session->DeriveFileType(PathName(fileTypeName)) }).first;
+  }
+  return it->second;
+}
+
+bool FindTeXMF::Find(const string& fileName, FileType fileType, PathName& path)
+{
+  if (fileType == FileType::None)
+  {
+    fileType = session->DeriveFileType(PathName(fileName));
+    if (fileType == FileType::None)
+    {
+      fileType = FileType::TEX;
+    }
+  }
+  // dependency scanners ask for the same files over and over again
+  string key = fmt::format("{0}\t{1}", static_cast<int>(fileType), fileName);
+  auto it = foundFiles.find(key);
+  if (it != foundFiles.end())
+  {
+    path = it->second;
+    return true;
+  }
+  if (!session->FindFile(fileName, fileType, path))
+  {
+    return false;
+  }
+  foundFiles[key] = path;
+  return true;
+}
+
+void FindTeXMF::PrintResult(const string& fileName, FileType fileType, bool found, const PathName& path)
+{
+  if (json)
+  {
+    nlohmann::json j = {
+      {"name", fileName},
+      {"found", found}
+    };
+    if (fileType != FileType::None)
+    {
+      j["fileType"] = session->GetFileTypeInfo(fileType).fileTypeString;
+    }
+    if (found)
+    {
+      j["path"] = path.ToString();
+    }
+    cout << j.dump() << endl;
+  }
+  else if (found)
+  {
+    cout << path << endl;
+  }
+  else if (batch)
+  {
+    // keep the output lines in step with the input lines
+    cout << endl;
+  }
+}
+
+int FindTeXMF::RunBatch()
+{
+  int exitCode = EXIT_SUCCESS;
+  string line;
+  while (getline(cin, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    if (line.empty())
+    {
+      continue;
+    }
+    string fileName = line;
+    FileType filetype = fileType;
+    size_t tab = line.find('\t');
+    if (tab != string::npos)
+    {
+      fileName = line.substr(0, tab);
+      filetype = GetFileType(line.substr(tab + 1));
+      if (filetype == FileType::None)
+      {
+        exitCode = EXIT_FAILURE;
+        PrintResult(fileName, filetype, false, PathName());
+        continue;
+      }
+    }
+    PathName path;
+    bool found = Find(fileName, filetype, path);
+    if (!found)
+    {
+      exitCode = EXIT_FAILURE;
+    }
+    PrintResult(fileName, filetype, found, path);
+  }
+  return exitCode;
+}
+
 int FindTeXMF::Run(int argc, const char** argv)
 {
   session = GetSession();
@@ -258,6 +407,11 @@ int FindTeXMF::Run(int argc, const char** argv)
       session->PushAppName(optArg);
       break;
 
+    case OPT_BATCH:
+
+      batch = true;
+      break;
+
     case OPT_EXPAND_VAR:
 
       cout << session->Expand(optArg, { ExpandOption::Values }, nullptr) << endl;
@@ -279,6 +433,11 @@ int FindTeXMF::Run(int argc, const char** argv)
       }
       break;
 
+    case OPT_JSON:
+
+      json = true;
+      break;
+
     case OPT_LIST_FILE_TYPES:
 
       ListFileTypes();
@@ -336,6 +495,15 @@ int FindTeXMF::Run(int argc, const char** argv)
 
   vector<string> leftovers = popt.GetLeftovers();
 
+  if (batch)
+  {
+    if (!leftovers.empty())
+    {
+      FatalError(T_("File names cannot be given in batch mode."));
+    }
+    return RunBatch();
+  }
+
   if (leftovers.empty())
   {
     if (!needArg)
@@ -353,19 +521,10 @@ int FindTeXMF::Run(int argc, const char** argv)
   for (const string& fileName : leftovers)
   {
     PathName path;
-    FileType filetype = fileType;
-    if (filetype == FileType::None)
-    {
-      filetype = session->DeriveFileType(PathName(fileName));
-      if (filetype == FileType::None)
-      {
-        filetype = FileType::TEX;
-      }
-    }
-    bool found = session->FindFile(fileName, filetype, path);
+    bool found = Find(fileName, fileType, path);
+    PrintResult(fileName, fileType, found, path);
     if (found)
     {
-      cout << path << endl;
       if (start)
       {
 #if defined(MIKTEX_WINDOWS)
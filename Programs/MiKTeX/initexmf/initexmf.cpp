@@ -204,10 +204,10 @@ private:
   void RunOneMiKTeXUtility(const vector<string>& arguments);
 
 private:
-  void MakeFormatFiles(const vector<string>& formats);
+  void MakeFormatFiles(const vector<string>& formats, const string& jobs);
 
 private:
-  void MakeFormatFilesByName(const vector<string>& formatsByName, const string& engine);
+  void MakeFormatFilesByName(const vector<string>& formatsByName, const string& engine, const string& jobs);
 
 private:
   void MakeMaps(bool force);
@@ -419,6 +419,7 @@ enum Option
   OPT_ENABLE_INSTALLER,
   OPT_ENGINE,
   OPT_FORCE,
+  OPT_JOBS,
   OPT_LIST_MODES,
   OPT_MKLANGS,
   OPT_MKLINKS,
@@ -762,31 +763,35 @@ void IniTeXMFApp::SetTeXMFRootDirectories(RegisterRootDirectoriesOptionSet optio
   }
 }
 
-void IniTeXMFApp::MakeFormatFiles(const vector<string>& formats)
+void IniTeXMFApp::MakeFormatFiles(const vector<string>& formats, const string& jobs)
 {
-  if (formats.empty())
+  vector<string> args{ "formats", "build" };
+  if (!jobs.empty())
   {
-    RunOneMiKTeXUtility({ "formats", "build" });
-    return;
-  }
-  for (const string& fmt : formats)
-  {
-    RunOneMiKTeXUtility({ "formats", "build", fmt });
+    args.insert(args.end(), { "--jobs", jobs });
   }
+  args.insert(args.end(), formats.begin(), formats.end());
+  RunOneMiKTeXUtility(args);
 }
 
-void IniTeXMFApp::MakeFormatFilesByName(const vector<string>& formatsByName, const string& engine)
+void IniTeXMFApp::MakeFormatFilesByName(const vector<string>& formatsByName, const string& engine, const string& jobs)
 {
-  // ASSUME: format key and name are the same
-  for (const string& name : formatsByName)
+  if (formatsByName.empty())
   {
-    vector<string> args{ "formats", "build", name };
-    if (!engine.empty())
-    {
-      args.insert(args.end(), { "--engine", engine });
-    }
-    RunOneMiKTeXUtility(args);
+    return;
   }
+  vector<string> args{ "formats", "build" };
+  if (!engine.empty())
+  {
+    args.insert(args.end(), { "--engine", engine });
+  }
+  if (!jobs.empty())
+  {
+    args.insert(args.end(), { "--jobs", jobs });
+  }
+  // ASSUME: format key and name are the same
+  args.insert(args.end(), formatsByName.begin(), formatsByName.end());
+  RunOneMiKTeXUtility(args);
 }
 
 void IniTeXMFApp::RegisterRoots(const vector<PathName>& roots, bool other, bool reg)
@@ -1185,6 +1190,7 @@ void IniTeXMFApp::Run(int argc, const char* argv[])
   vector<PathName> unregisterRoots;
   string defaultPaperSize;
   string engine;
+  string jobs;
   string portableRoot;
 
   bool optClean = false;
@@ -1283,6 +1289,11 @@ void IniTeXMFApp::Run(int argc, const char* argv[])
       optForce = true;
       break;
 
+    case OPT_JOBS:
+
+      jobs = optArg;
+      break;
+
     case OPT_COMMON_INSTALL:
 
       startupConfig.commonInstallRoot = optArg;
@@ -1508,12 +1519,12 @@ void IniTeXMFApp::Run(int argc, const char* argv[])
 
   if (optDump)
   {
-    MakeFormatFiles(formats);
+    MakeFormatFiles(formats, jobs);
   }
 
   if (optDumpByName)
   {
-    MakeFormatFilesByName(formatsByName, engine);
+    MakeFormatFilesByName(formatsByName, engine, jobs);
   }
 
   if (optModifyPath)
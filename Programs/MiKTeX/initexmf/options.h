@@ -136,6 +136,14 @@ const struct poptOption IniTeXMFApp::options[] = {
     nullptr
   },
 
+  {
+    "jobs", 0,
+    POPT_ARG_STRING | POPT_ARGFLAG_DOC_HIDDEN, nullptr,
+    OPT_JOBS,
+    nullptr,
+    nullptr
+  },
+
   {
     "list-formats", 0,
     POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr,
@@ -16,6 +16,9 @@
 #include "makefmt-version.h"
 
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/MD5>
+#include <miktex/Core/StreamReader>
+#include <miktex/Core/StreamWriter>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Util/Tokenizer>
 
@@ -130,6 +133,7 @@ private:
     void InstallPdftexConfigTeX() const;
     void ParsePdfConfigFile(const PathName& cfgFile, PdfConfigValues& values) const;
     void Usage() override;
+    void WriteInputsFile(const PathName& flsFile, const PathName& workingDirectory, const PathName& inputsFile);
 
     void SetEngine(const char* engine)
     {
@@ -378,6 +382,44 @@ void MakeFmt::InstallPdftexConfigTeX() const
     session->ConfigureFile(PathName(MIKTEX_PATH_PDFTEXCONFIG_TEX), &pdfConfigValues);
 }
 
+void MakeFmt::WriteInputsFile(const PathName& flsFile, const PathName& workingDirectory, const PathName& inputsFile)
+{
+    vector<PathName> inputs;
+    PathName engineExe;
+    if (session->FindFile(GetEngineExeName(), FileType::EXE, engineExe))
+    {
+        // a new engine might not be able to load the format file
+        inputs.push_back(engineExe);
+    }
+    StreamReader reader(flsFile);
+    string line;
+    while (reader.ReadLine(line))
+    {
+        if (line.compare(0, 6, "INPUT ") != 0)
+        {
+            continue;
+        }
+        PathName input(line.substr(6));
+        // files in the working directory are gone when the format file is loaded
+        if (!input.IsAbsolute() || Utils::IsParentDirectoryOf(workingDirectory, input) || !File::Exists(input))
+        {
+            continue;
+        }
+        if (find(inputs.begin(), inputs.end(), input) == inputs.end())
+        {
+            inputs.push_back(input);
+        }
+    }
+    reader.Close();
+    // one line per file: MD5, size, modification time, path
+    StreamWriter writer(inputsFile);
+    for (const PathName& input : inputs)
+    {
+        writer.WriteLine(fmt::format("{0} {1} {2} {3}", MD5::FromFile(input).ToString(), File::GetSize(input), static_cast<int64_t>(File::GetLastWriteTime(input)), input.ToString()));
+    }
+    writer.Close();
+}
+
 void MakeFmt::Run(int argc, const char** argv)
 {
     // get options and file name
@@ -450,6 +492,7 @@ void MakeFmt::Run(int argc, const char** argv)
             arguments.push_back("--alias=" + destinationName.ToString());
         }
         arguments.push_back("--job-name=" + destinationName.ToString());
+        arguments.push_back("--recorder");
         if (!jobTime.empty())
         {
             arguments.push_back("--job-time=" + jobTime);
@@ -500,6 +543,24 @@ void MakeFmt::Run(int argc, const char** argv)
 
     // install format file
     Install(wrkDir->GetPathName() / formatFile.ToString(), pathDest);
+
+    // install the list of files which went into the format file; the engine
+    // uses this list to decide whether the format file is out of date
+    PathName flsFile = wrkDir->GetPathName() / destinationName.ToString();
+    flsFile.AppendExtension(".fls");
+    PathName inputsDest(pathDest);
+    inputsDest.AppendExtension(MIKTEX_FORMAT_INPUTS_FILE_SUFFIX);
+    if (File::Exists(flsFile))
+    {
+        PathName inputsFile = wrkDir->GetPathName() / formatFile.ToString();
+        inputsFile.AppendExtension(MIKTEX_FORMAT_INPUTS_FILE_SUFFIX);
+        WriteInputsFile(flsFile, wrkDir->GetPathName(), inputsFile);
+        Install(inputsFile, inputsDest);
+    }
+    else if (!printOnly && File::Exists(inputsDest))
+    {
+        File::Delete(inputsDest, { FileDeleteOption::UpdateFndb });
+    }
 }
 
 #if defined(_UNICODE)
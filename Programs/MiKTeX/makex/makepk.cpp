@@ -15,6 +15,9 @@
 
 #include "makepk-version.h"
 
+#include <algorithm>
+#include <thread>
+
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Util/Tokenizer>
@@ -31,6 +34,8 @@ log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("makepk"));
 
 #define OPT_MAP_FILE 1
 #define OPT_FORCE 2
+#define OPT_BATCH 3
+#define OPT_JOBS 4
 
 class MakePk :
     public MakeUtility
@@ -49,6 +54,8 @@ private:
     void CheckOptions(int* baseDpi, int dpi, const string& mode);
     void CreateDestinationDirectory() override;
     void ExtraPS2PKOptions(const DvipsFontMapEntry& mapEntry, vector<string>& arguments);
+    void MakeFont();
+    void MakeFonts(const PathName& batchFile);
     void MakePKFilename(const char* name, int bdpi, int dpi, PathName& result);
     void RunGSF2PK(const DvipsFontMapEntry& mapEntry, const char* pkName, int dpi, const PathName& workingDirectory);
     void RunPS2PK(const DvipsFontMapEntry& mapEntry, const char* pkName, int dpi, const PathName& workingDirectory);
@@ -57,9 +64,13 @@ private:
     BEGIN_OPTION_MAP(MakePk)
         OPTION_ENTRY(OPT_MAP_FILE, mapFiles.push_back(optArg))
         OPTION_ENTRY_TRUE(OPT_FORCE, overwriteExisting)
+        OPTION_ENTRY(OPT_BATCH, batchFile = optArg)
+        OPTION_ENTRY(OPT_JOBS, jobs = std::stoi(optArg))
     END_OPTION_MAP();
 
     bool overwriteExisting = false;
+    PathName batchFile;
+    int jobs = 1;
     bool modeless;
     int dpi;
     int bdpi;
@@ -72,6 +83,7 @@ void MakePk::Usage()
 {
     OUT__
         << T_("Usage:") << " " << Utils::GetExeName() << " " << T_("[OPTION]... name dpi bdpi magnification [MODE]") << "\n"
+        << "       " << Utils::GetExeName() << " " << T_("[OPTION]... --batch=FILE") << "\n"
         << "\n"
         << T_("This program makes a PK font.") << "\n"
         << "\n"
@@ -84,12 +96,17 @@ void MakePk::Usage()
         << T_("You can specify 0 as BDPI. In that case, BDPI is calculated from") << "\n"
         << T_("the MODE.") << "\n"
         << "\n"
+        << T_("In batch mode, FILE contains one font per line, given as") << "\n"
+        << T_("'name dpi bdpi magnification [MODE]'.") << "\n"
+        << "\n"
         << T_("Options:") << "\n"
         << "--debug, -d " << T_("Print debugging information.") << "\n"
         << "--disable-installer " << T_("Disable the package installer.") << "\n"
         << "--enable-installer " << T_("Enable the package installer.") << "\n"
+        << "--batch=FILE " << T_("Make the PK fonts listed in FILE.") << "\n"
         << "--force " << T_("Make PK font, even if it exists already.") << "\n"
         << "--help, -h " << T_("Print this help screen and exit.") << "\n"
+        << "--jobs=N " << T_("Make up to N PK fonts at a time (batch mode).") << "\n"
         << "--map-file=FILE " << T_("Consult additional map file.") << "\n"
         << "--print-only, -n " << T_("Print what commands would be executed.") << "\n"
         << "--verbose, -v " << T_("Print information on what is being done.") << "\n"
@@ -100,7 +117,9 @@ namespace {
     const struct option aLongOptions[] =
     {
       COMMON_OPTIONS,
+      {"batch",                required_argument,      nullptr,      OPT_BATCH},
       {"force",                no_argument,            nullptr,      OPT_FORCE},
+      {"jobs",                 required_argument,      nullptr,      OPT_JOBS},
       {"map-file",             required_argument,      nullptr,      OPT_MAP_FILE},
       {nullptr,                no_argument,            nullptr,      0}
     };
@@ -342,23 +361,8 @@ bool MakePk::FindFontMapping(const char* texFontName, const char* mapFileName, D
         return false;
     }
 
-    // open the map file
-    ifstream stream = File::CreateInputStream(mapFile);
-
-    // try to find the font mapping
-    bool found = false;
-    string line;
-    while (!found && std::getline(stream, line))
-    {
-        if (Utils::ParseDvipsFontMapLine(line, mapEntry) && mapEntry.texName == texFontName)
-        {
-            found = true;
-        }
-    }
-
-    stream.close();
-
-    return found;
+    // look up the font mapping via the index of the map file
+    return Utils::FindDvipsFontMapEntry(mapFile, texFontName, mapEntry);
 }
 
 bool MakePk::SearchPostScriptFont(const char* texFontName, DvipsFontMapEntry& mapEntry)
@@ -399,6 +403,15 @@ void MakePk::Run(int argc, const char** argv)
     // get command line options and arguments
     int optionIndex = 0;
     GetOptions(argc, argv, aLongOptions, optionIndex);
+    if (!batchFile.Empty())
+    {
+        if (optionIndex != argc)
+        {
+            FatalError(T_("Invalid command-line."));
+        }
+        MakeFonts(batchFile);
+        return;
+    }
     if (argc - optionIndex < 4 || argc - optionIndex > 5)
     {
         FatalError(T_("Invalid command-line."));
@@ -411,7 +424,154 @@ void MakePk::Run(int argc, const char** argv)
     {
         mfMode = argv[optionIndex++];
     }
+    MakeFont();
+}
+
+void MakePk::MakeFonts(const PathName& batchFile)
+{
+    vector<string> lines;
+    ifstream stream = File::CreateInputStream(batchFile);
+    for (string line; std::getline(stream, line); )
+    {
+        Tokenizer tok(line, " \t\r\n");
+        if (tok && (*tok)[0] != '%' && (*tok)[0] != '#')
+        {
+            lines.push_back(line);
+        }
+    }
+    stream.close();
+
+    if (jobs <= 0)
+    {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
 
+    size_t failures = 0;
+    size_t total = 0;
+
+    if (jobs == 1 || lines.size() <= 1)
+    {
+        // one process: the session, the METAFONT modes and the font
+        // maps are set up only once
+        total = lines.size();
+        for (const string& line : lines)
+        {
+            vector<string> args;
+            for (Tokenizer tok(line, " \t\r\n"); tok; ++tok)
+            {
+                args.push_back(*tok);
+            }
+            if (args.size() < 4 || args.size() > 5)
+            {
+                Warning(fmt::format(T_("Invalid batch line: {0}"), line));
+                ++failures;
+                continue;
+            }
+            name = args[0];
+            dpi = std::stoi(args[1]);
+            bdpi = std::stoi(args[2]);
+            magnification = args[3];
+            mfMode = args.size() > 4 ? args[4] : "";
+            try
+            {
+                MakeFont();
+            }
+            catch (const MiKTeXException& e)
+            {
+                Sorry("makepk", e);
+                ++failures;
+            }
+            catch (int)
+            {
+                ++failures;
+            }
+        }
+    }
+    else
+    {
+        // deal the fonts out to JOBS batch processes
+        PathName makepkExe;
+        if (!session->FindFile(MIKTEX_MAKEPK_EXE, FileType::EXE, makepkExe))
+        {
+            FatalError(fmt::format(T_("The application file {0} could not be found."), Q_(MIKTEX_MAKEPK_EXE)));
+        }
+        unique_ptr<TemporaryDirectory> wrkDir = TemporaryDirectory::Create();
+        vector<ProcessStartInfo> startInfos;
+        size_t nProcesses = std::min(lines.size(), static_cast<size_t>(jobs));
+        total = nProcesses;
+        for (size_t idx = 0; idx < nProcesses; ++idx)
+        {
+            PathName chunkFile = wrkDir->GetPathName() / fmt::format("batch-{0}.txt", idx);
+            ofstream chunk = File::CreateOutputStream(chunkFile);
+            for (size_t lineIdx = idx; lineIdx < lines.size(); lineIdx += nProcesses)
+            {
+                chunk << lines[lineIdx] << "\n";
+            }
+            chunk.close();
+            ProcessStartInfo startInfo(makepkExe);
+            startInfo.Arguments = { MIKTEX_MAKEPK_EXE, "--miktex-disable-maintenance", "--miktex-disable-diagnose" };
+            if (session->IsAdminMode())
+            {
+                startInfo.Arguments.push_back("--admin");
+            }
+            switch (GetEnableInstaller())
+            {
+            case MiKTeX::Configuration::TriState::False:
+                startInfo.Arguments.push_back("--disable-installer");
+                break;
+            case MiKTeX::Configuration::TriState::True:
+                startInfo.Arguments.push_back("--enable-installer");
+                break;
+            default:
+                break;
+            }
+            if (debug)
+            {
+                startInfo.Arguments.push_back("--debug");
+            }
+            if (verbose)
+            {
+                startInfo.Arguments.push_back("--verbose");
+            }
+            if (quiet)
+            {
+                startInfo.Arguments.push_back("--quiet");
+            }
+            if (printOnly)
+            {
+                startInfo.Arguments.push_back("--print-only");
+            }
+            if (overwriteExisting)
+            {
+                startInfo.Arguments.push_back("--force");
+            }
+            for (const string& mapFile : mapFiles)
+            {
+                startInfo.Arguments.push_back("--map-file=" + mapFile);
+            }
+            startInfo.Arguments.push_back("--jobs=1");
+            startInfo.Arguments.push_back("--batch=" + chunkFile.ToString());
+            startInfos.push_back(startInfo);
+        }
+        vector<ProcessRunResult> results = Process::RunAll(startInfos, nProcesses);
+        for (const ProcessRunResult& result : results)
+        {
+            OUT__ << result.output;
+            if (result.exitStatus != ProcessExitStatus::Exited || result.exitCode != 0)
+            {
+                ++failures;
+            }
+        }
+    }
+
+    if (failures > 0)
+    {
+        FatalError(fmt::format(T_("{0} of {1} batch job(s) failed."), failures, total));
+    }
+}
+
+void MakePk::MakeFont()
+{
     Verbose(fmt::format(T_("Trying to make PK font {0} at {1} DPI..."), Q_(name), dpi));
 
     // make a mode name if none was specified
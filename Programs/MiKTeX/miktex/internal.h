@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Internal definitions
  *
- * @copyright Copyright © 2021-2022 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -33,6 +33,8 @@ namespace OneMiKTeXUtility
     {
     public:
         virtual void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments) = 0;
+        // saves the output as <outputName>.out in the log directory
+        virtual void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments, const std::string& outputName) = 0;
     };
 
     class MIKTEXNOVTABLE Program
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Main program
  *
- * @copyright Copyright © 2021-2023 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -17,6 +17,7 @@
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -72,6 +73,8 @@
 #include "topics/links/topic.h"
 #include "topics/packages/topic.h"
 #include "topics/repositories/topic.h"
+#include "topics/session/topic.h"
+#include "topics/trace/topic.h"
 
 #if defined(MIKTEX_WINDOWS)
 #include "topics/filetypes/topic.h"
@@ -114,6 +117,8 @@ private:
         RegisterTopic(OneMiKTeXUtility::Topics::Links::Create());
         RegisterTopic(OneMiKTeXUtility::Topics::Packages::Create());
         RegisterTopic(OneMiKTeXUtility::Topics::Repositories::Create());
+        RegisterTopic(OneMiKTeXUtility::Topics::Session::Create());
+        RegisterTopic(OneMiKTeXUtility::Topics::Trace::Create());
 #if defined(MIKTEX_WINDOWS)
         RegisterTopic(OneMiKTeXUtility::Topics::FileTypes::Create());
 #endif
@@ -242,6 +247,7 @@ private:
     void LogTraceMessage(const MiKTeX::Trace::TraceCallback::TraceMessage& traceMessage);
 
     void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments) override;
+    void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments, const std::string& outputName) override;
 
     std::vector<std::string> args;
     OneMiKTeXUtility::ApplicationContext ctx;
@@ -251,6 +257,7 @@ private:
     std::shared_ptr<MiKTeX::Packages::PackageInstaller> packageInstaller;
     std::vector<MiKTeX::Trace::TraceCallback::TraceMessage> pendingTraceMessages;
     bool quiet = false;
+    std::mutex runProcessMutex;
     std::shared_ptr<MiKTeX::Core::Session> session;
     std::map<std::string, std::unique_ptr<OneMiKTeXUtility::Topics::Topic>> topics;
     int verbosityLevel = 0;
@@ -418,6 +425,27 @@ void MiKTeXApp::RunProcess(const PathName& fileName, const vector<string>& argum
     }
 }
 
+void MiKTeXApp::RunProcess(const PathName& fileName, const vector<string>& arguments, const string& outputName)
+{
+    ProcessOutput<4096> output;
+    int exitCode;
+    MiKTeXException miktexException;
+    bool succeeded = Process::Run(fileName, arguments, &output, &exitCode, &miktexException, nullptr) && exitCode == 0;
+    // the output is kept, also on success; sub-processes may be run
+    // concurrently
+    lock_guard<mutex> lockGuard(this->runProcessMutex);
+    PathName outfile = this->session->GetSpecialPath(SpecialPath::LogDirectory) / outputName;
+    outfile.AppendExtension(".out");
+    File::WriteBytes(outfile, output.GetStandardOutput());
+    MIKTEX_ASSERT(isLog4cxxConfigured);
+    if (!succeeded)
+    {
+        LOG4CXX_ERROR(logger, "sub-process error output has been saved to '" << outfile.ToDisplayString() << "'");
+        throw miktexException;
+    }
+    LOG4CXX_INFO(logger, "sub-process output has been saved to '" << outfile.ToDisplayString() << "'");
+}
+
 void MiKTeXApp::Verbose(int level, const string& s)
 {
     if (level >= 4)
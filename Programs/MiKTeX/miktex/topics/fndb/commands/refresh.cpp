@@ -51,7 +51,7 @@ namespace
 
         std::string Synopsis() override
         {
-            return "refresh";
+            return "refresh [--full]";
         }
     };
 }
@@ -73,7 +73,7 @@ unique_ptr<Command> Commands::Refresh()
     return make_unique<RefreshCommand>();
 }
 
-void RefreshFilenameDatabase(ApplicationContext& ctx, const PathName& root)
+void RefreshFilenameDatabase(ApplicationContext& ctx, const PathName& root, bool full)
 {
     if (!ctx.session->UnloadFilenameDatabase())
     {
@@ -89,16 +89,32 @@ void RefreshFilenameDatabase(ApplicationContext& ctx, const PathName& root)
     {
         ctx.ui->Verbose(1, fmt::format(T_("Creating FNDB for user root directory ({0})..."), Q_(root.ToDisplayString())));
     }
-    Fndb::Create(fndbPath, root, nullptr);
+    if (full)
+    {
+        Fndb::Create(fndbPath, root, nullptr);
+    }
+    else
+    {
+        // rescans only directories which have changed since the last run
+        Fndb::Refresh(root, nullptr);
+    }
 }
 
 enum Option
 {
     OPT_AAA = 1,
+    OPT_FULL,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "full", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_FULL,
+        T_("Rescan all directories."),
+        nullptr
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -108,8 +124,15 @@ int RefreshCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
     auto argv = MakeArgv(arguments);
     PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
     int option;
+    bool optFull = false;
     while ((option = popt.GetNextOpt()) >= 0)
     {
+        switch (option)
+        {
+        case OPT_FULL:
+            optFull = true;
+            break;
+        }
     }
     if (option != -1)
     {
@@ -126,7 +149,7 @@ int RefreshCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
         {
             if (ctx.session->IsCommonRootDirectory(r))
             {
-                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r));
+                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r), optFull);
             }
             else
             {
@@ -137,7 +160,7 @@ int RefreshCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
         {
             if (!ctx.session->IsCommonRootDirectory(r) || ctx.session->IsMiKTeXPortable())
             {
-                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r));
+                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r), optFull);
             }
             else
             {
@@ -0,0 +1,146 @@
+/**
+ * @file topics/fndb/commands/seed.cpp
+ * @author Christian Schenk
+ * @brief fndb seed
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+#include <miktex/Wrappers/PoptWrapper>
+
+#include "internal.h"
+
+#include "commands.h"
+
+namespace
+{
+    class SeedCommand :
+        public OneMiKTeXUtility::Topics::Command
+    {
+        std::string Description() override
+        {
+            return T_("Install a prebuilt file name database for the installation directory");
+        }
+
+        int MIKTEXTHISCALL Execute(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& arguments) override;
+
+        std::string Name() override
+        {
+            return "seed";
+        }
+
+        std::string Synopsis() override
+        {
+            return "seed [--save] <file>";
+        }
+    };
+}
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+using namespace OneMiKTeXUtility;
+using namespace OneMiKTeXUtility::Topics;
+using namespace OneMiKTeXUtility::Topics::FNDB;
+
+unique_ptr<Command> Commands::Seed()
+{
+    return make_unique<SeedCommand>();
+}
+
+enum Option
+{
+    OPT_AAA = 1,
+    OPT_SAVE,
+};
+
+static const struct poptOption options[] =
+{
+    {
+        "save", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_SAVE,
+        T_("Save the file name database of the installation directory instead."),
+        nullptr
+    },
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+int SeedCommand::Execute(ApplicationContext& ctx, const vector<string>& arguments)
+{
+    auto argv = MakeArgv(arguments);
+    PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
+    int option;
+    bool optSave = false;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+        switch (option)
+        {
+        case OPT_SAVE:
+            optSave = true;
+            break;
+        }
+    }
+    if (option != -1)
+    {
+        ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
+    }
+    auto leftOvers = popt.GetLeftovers();
+    if (leftOvers.size() != 1)
+    {
+        ctx.ui->IncorrectUsage(T_("expected one <file> argument"));
+    }
+    PathName path(leftOvers[0]);
+    PathName installRoot = ctx.session->GetSpecialPath(SpecialPath::InstallRoot);
+    PathName fndbPath = ctx.session->GetFilenameDatabasePathName(ctx.session->DeriveTEXMFRoot(installRoot));
+    if (optSave)
+    {
+        PathName changeFile = fndbPath;
+        changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+        if (!File::Exists(fndbPath) || File::Exists(changeFile))
+        {
+            ctx.ui->FatalError(T_("the file name database of the installation directory is not up-to-date"));
+        }
+        ctx.ui->Verbose(1, fmt::format(T_("Saving {0}..."), Q_(fndbPath.ToDisplayString())));
+        File::Copy(fndbPath, path);
+        return 0;
+    }
+    if (!File::Exists(path))
+    {
+        ctx.ui->FatalError(fmt::format(T_("{0}: file does not exist"), Q_(path.ToDisplayString())));
+    }
+    if (!ctx.session->UnloadFilenameDatabase())
+    {
+        ctx.ui->FatalError(T_("the file name database could not be unloaded"));
+    }
+    ctx.ui->Verbose(1, fmt::format(T_("Seeding FNDB for installation directory ({0})..."), Q_(installRoot.ToDisplayString())));
+    if (!Fndb::Seed(path, installRoot))
+    {
+        ctx.ui->Warning(fmt::format(T_("{0} does not match the installation directory"), Q_(path.ToDisplayString())));
+        return 1;
+    }
+    return 0;
+}
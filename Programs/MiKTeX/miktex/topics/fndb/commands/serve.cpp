@@ -0,0 +1,351 @@
+/**
+ * @file topics/fndb/commands/serve.cpp
+ * @author Christian Schenk
+ * @brief fndb serve
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/FileSystemWatcher>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/LockFile>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+#include <miktex/Wrappers/PoptWrapper>
+
+#include "internal.h"
+
+#include "commands.h"
+
+namespace
+{
+    class ServeCommand :
+        public OneMiKTeXUtility::Topics::Command
+    {
+        std::string Description() override
+        {
+            return T_("Keep the file name databases up-to-date while files are added and removed");
+        }
+
+        int MIKTEXTHISCALL Execute(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& arguments) override;
+
+        std::string Name() override
+        {
+            return "serve";
+        }
+
+        std::string Synopsis() override
+        {
+            return "serve";
+        }
+    };
+
+    /// Applies file system changes to the file name databases.
+    ///
+    /// Added and removed files go into the FNDB change files, which the
+    /// clients are watching: they replay the new entries without remapping
+    /// the whole database.  Only a removed directory causes a refresh, which
+    /// rescans the changed directories only.
+    class FndbService :
+        public MiKTeX::Core::FileSystemWatcherCallback
+    {
+    public:
+
+        FndbService(OneMiKTeXUtility::ApplicationContext& ctx) :
+            ctx(ctx)
+        {
+        }
+
+        void Run();
+
+        void MIKTEXTHISCALL OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override
+        {
+            std::lock_guard<std::mutex> lockGuard(eventMutex);
+            events.push_back(ev);
+        }
+
+    private:
+
+        void Watch(const MiKTeX::Util::PathName& directory, std::unordered_map<std::string, MiKTeX::Util::PathName>* files);
+
+        void CheckWatches(MiKTeX::Core::LockFile& lockFile);
+
+        void ProcessEvents();
+
+        static std::string MakeKey(const MiKTeX::Util::PathName& path)
+        {
+            MiKTeX::Util::PathName key(path);
+            key.TransformForComparison();
+            return key.ToString();
+        }
+
+        OneMiKTeXUtility::ApplicationContext& ctx;
+
+        std::unique_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
+
+        std::mutex eventMutex;
+
+        std::deque<MiKTeX::Core::FileSystemChangeEvent> events;
+
+        // the root directories being served
+        std::unordered_set<unsigned> roots;
+
+        std::unordered_set<std::string> watchedDirectories;
+
+        // the FNDB files live here: their changes are our own doing
+        std::unordered_set<std::string> ignoredDirectories;
+    };
+}
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+using namespace OneMiKTeXUtility;
+using namespace OneMiKTeXUtility::Topics;
+using namespace OneMiKTeXUtility::Topics::FNDB;
+
+unique_ptr<Command> Commands::Serve()
+{
+    return make_unique<ServeCommand>();
+}
+
+void FndbService::Watch(const PathName& directory, unordered_map<string, PathName>* files)
+{
+    vector<PathName> stack{ directory };
+    while (!stack.empty())
+    {
+        PathName dir = stack.back();
+        stack.pop_back();
+        string key = MakeKey(dir);
+        if (ignoredDirectories.find(key) != ignoredDirectories.end() || !watchedDirectories.insert(key).second)
+        {
+            continue;
+        }
+        // watch first: files created while the directory is read are noticed
+        fsWatcher->AddDirectories({ dir });
+        DirectoryListing listing;
+        try
+        {
+            DirectoryLister::ReadAll(dir, (int)DirectoryLister::Options::None, listing);
+        }
+        catch (const exception&)
+        {
+            // the directory has been removed in the meantime
+            continue;
+        }
+        for (size_t idx = 0; idx < listing.GetCount(); ++idx)
+        {
+            PathName path = dir / listing.GetName(idx);
+            if (listing.IsDirectory(idx))
+            {
+                stack.push_back(path);
+            }
+            else if (files != nullptr)
+            {
+                (*files)[MakeKey(path)] = path;
+            }
+        }
+    }
+}
+
+void FndbService::CheckWatches(LockFile& lockFile)
+{
+    if (fsWatcher->IsWatchingAll())
+    {
+        return;
+    }
+    // the sessions trust the FNDB as long as we hold the lock: changes in
+    // unwatched directories would go unnoticed
+    fsWatcher->Stop();
+    fsWatcher->Unsubscribe(this);
+    lockFile.Unlock();
+    ctx.ui->FatalError(T_("not all directories can be watched (the inotify watch limit may have been reached)"));
+}
+
+void FndbService::ProcessEvents()
+{
+    deque<FileSystemChangeEvent> batch;
+    {
+        lock_guard<mutex> lockGuard(eventMutex);
+        batch.swap(events);
+    }
+    if (batch.empty())
+    {
+        return;
+    }
+    // the files which might have changed, per root directory
+    map<unsigned, unordered_map<string, PathName>> touched;
+    unordered_set<unsigned> toBeRefreshed;
+    for (const FileSystemChangeEvent& ev : batch)
+    {
+        if (ev.action == FileSystemChangeAction::Modified || ignoredDirectories.find(MakeKey(ev.fileName.GetDirectoryName())) != ignoredDirectories.end())
+        {
+            continue;
+        }
+        unsigned r = ctx.session->TryDeriveTEXMFRoot(ev.fileName);
+        if (roots.find(r) == roots.end())
+        {
+            continue;
+        }
+        if (ev.action == FileSystemChangeAction::Added && Directory::Exists(ev.fileName))
+        {
+            Watch(ev.fileName, &touched[r]);
+        }
+        else if (ev.action == FileSystemChangeAction::Removed && watchedDirectories.erase(MakeKey(ev.fileName)) > 0)
+        {
+            // the FNDB does not tell which files were in the directory
+            toBeRefreshed.insert(r);
+        }
+        else
+        {
+            touched[r][MakeKey(ev.fileName)] = ev.fileName;
+        }
+    }
+    for (const auto& root : touched)
+    {
+        if (toBeRefreshed.find(root.first) != toBeRefreshed.end())
+        {
+            continue;
+        }
+        // the final state counts: a file may have come and gone
+        vector<Fndb::Record> added;
+        vector<PathName> removed;
+        for (const auto& file : root.second)
+        {
+            bool exists = File::Exists(file.second);
+            if (exists != Fndb::FileExists(file.second))
+            {
+                if (exists)
+                {
+                    added.push_back({ file.second, "" });
+                }
+                else
+                {
+                    removed.push_back(file.second);
+                }
+            }
+        }
+        if (!added.empty())
+        {
+            ctx.ui->Verbose(1, fmt::format(T_("adding {0} file(s) to the FNDB of {1}"), added.size(), Q_(ctx.session->GetRootDirectoryPath(root.first).ToDisplayString())));
+            Fndb::Add(added);
+        }
+        if (!removed.empty())
+        {
+            ctx.ui->Verbose(1, fmt::format(T_("removing {0} file(s) from the FNDB of {1}"), removed.size(), Q_(ctx.session->GetRootDirectoryPath(root.first).ToDisplayString())));
+            Fndb::Remove(removed);
+        }
+    }
+    for (unsigned r : toBeRefreshed)
+    {
+        ctx.ui->Verbose(1, fmt::format(T_("refreshing the FNDB of {0}"), Q_(ctx.session->GetRootDirectoryPath(r).ToDisplayString())));
+        Fndb::Refresh(ctx.session->GetRootDirectoryPath(r), nullptr);
+    }
+}
+
+void FndbService::Run()
+{
+    PathName lockPath = ctx.session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FNDB_SERVICE_LOCK;
+    Directory::Create(lockPath.GetDirectoryName());
+    unique_ptr<LockFile> lockFile = LockFile::Create(lockPath);
+    if (!lockFile->TryLock(0ms))
+    {
+        ctx.ui->FatalError(T_("the FNDB service is already running"));
+    }
+    fsWatcher = FileSystemWatcher::Create();
+    fsWatcher->Subscribe(this);
+    unsigned nRoots = ctx.session->GetNumberOfTEXMFRoots();
+    for (unsigned r = 0; r < nRoots; ++r)
+    {
+        // the same rule as in fndb refresh
+        if (ctx.session->IsOtherRootDirectory(r)
+            || (ctx.session->IsAdminMode() && !ctx.session->IsCommonRootDirectory(r))
+            || (!ctx.session->IsAdminMode() && ctx.session->IsCommonRootDirectory(r) && !ctx.session->IsMiKTeXPortable()))
+        {
+            continue;
+        }
+        if (!Directory::Exists(ctx.session->GetRootDirectoryPath(r)))
+        {
+            continue;
+        }
+        roots.insert(r);
+        ignoredDirectories.insert(MakeKey(ctx.session->GetFilenameDatabasePathName(r).GetDirectoryName()));
+    }
+    ignoredDirectories.insert(MakeKey(lockPath.GetDirectoryName()));
+    for (unsigned r : roots)
+    {
+        PathName rootPath = ctx.session->GetRootDirectoryPath(r);
+        ctx.ui->Verbose(1, fmt::format(T_("Serving FNDB for root directory ({0})..."), Q_(rootPath.ToDisplayString())));
+        Watch(rootPath, nullptr);
+    }
+    CheckWatches(*lockFile);
+    fsWatcher->Start();
+    // catch up with the changes made before the watches were in place
+    for (unsigned r : roots)
+    {
+        Fndb::Refresh(ctx.session->GetRootDirectoryPath(r), nullptr);
+    }
+    while (!ctx.program->Canceled())
+    {
+        this_thread::sleep_for(200ms);
+        ProcessEvents();
+        CheckWatches(*lockFile);
+    }
+    fsWatcher->Stop();
+    fsWatcher->Unsubscribe(this);
+    lockFile->Unlock();
+}
+
+static const struct poptOption options[] =
+{
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+int ServeCommand::Execute(ApplicationContext& ctx, const vector<string>& arguments)
+{
+    auto argv = MakeArgv(arguments);
+    PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
+    int option;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+    }
+    if (option != -1)
+    {
+        ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
+    }
+    if (!popt.GetLeftovers().empty())
+    {
+        ctx.ui->IncorrectUsage(T_("unexpected command arguments"));
+    }
+    FndbService service(ctx);
+    service.Run();
+    return 0;
+}
@@ -41,6 +41,8 @@ namespace
         {
             this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Refresh());
             this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Remove());
+            this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Seed());
+            this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Serve());
         }
     };
 }
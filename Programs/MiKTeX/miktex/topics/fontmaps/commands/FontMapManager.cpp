@@ -22,15 +22,20 @@
 
 #include <config.h>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <set>
+#include <sstream>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
 #include <miktex/Core/Fndb>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
@@ -46,6 +51,8 @@
 
 #include "FontMapManager.h"
 
+#include "miktex-version.h"
+
 #define BOOLSTR(b) ((b) ? "true" : "false")
 
 using namespace std;
@@ -527,36 +534,46 @@ PathName FontMapManager::FontMapDirectory(const string& relPath)
     return path;
 }
 
-void FontMapManager::WriteDvipsFontMapFile(const PathName& path, const set<DvipsFontMapEntry>& fontMapEntries1, const set<DvipsFontMapEntry>& fontMapEntries2, const set<DvipsFontMapEntry>& fontMapEntries3, const set<DvipsFontMapEntry>& fontMapEntries4)
+void FontMapManager::WriteFileIfChanged(const PathName& path, const string& contents)
 {
+    // an unchanged file keeps its time stamp, so that programs which cache the
+    // contents of the file do not have to read it again
+    if (File::Exists(path))
+    {
+        vector<unsigned char> oldContents = File::ReadAllBytes(path);
+        if (oldContents.size() == contents.size() && equal(oldContents.begin(), oldContents.end(), contents.begin()))
+        {
+            Verbose(2, fmt::format(T_("{0} is unchanged"), Q_(path)));
+            return;
+        }
+    }
     Verbose(fmt::format(T_("Writing {0}..."), Q_(path)));
     // TODO: backup old file
-    ofstream writer = File::CreateOutputStream(path, ios_base::binary);
+    File::WriteBytes(path, vector<unsigned char>(contents.begin(), contents.end()));
+    if (!Fndb::FileExists(path))
+    {
+        Fndb::Add({ {path} });
+    }
+}
+
+void FontMapManager::WriteDvipsFontMapFile(const PathName& path, const set<DvipsFontMapEntry>& fontMapEntries1, const set<DvipsFontMapEntry>& fontMapEntries2, const set<DvipsFontMapEntry>& fontMapEntries3, const set<DvipsFontMapEntry>& fontMapEntries4)
+{
+    ostringstream writer;
     WriteHeader(writer, path);
     set<DvipsFontMapEntry> fontMapEntries = fontMapEntries1;
     fontMapEntries.insert(fontMapEntries2.begin(), fontMapEntries2.end());
     fontMapEntries.insert(fontMapEntries3.begin(), fontMapEntries3.end());
     fontMapEntries.insert(fontMapEntries4.begin(), fontMapEntries4.end());
     WriteDvipsFontMap(writer, fontMapEntries);
-    writer.close();
-    if (!Fndb::FileExists(path))
-    {
-        Fndb::Add({ {path} });
-    }
+    WriteFileIfChanged(path, writer.str());
 }
 
 void FontMapManager::WriteDvipdfmxFontMapFile(const PathName& path, const set<DvipdfmxFontMapEntry>& fontMapEntries)
 {
-    Verbose(fmt::format(T_("Writing {0}..."), Q_(path)));
-    // TODO: backup old file
-    ofstream writer = File::CreateOutputStream(path, ios_base::binary);
+    ostringstream writer;
     WriteHeader(writer, path);
     WriteDvipdfmxFontMap(writer, fontMapEntries);
-    writer.close();
-    if (!Fndb::FileExists(path))
-    {
-        Fndb::Add({ {path} });
-    }
+    WriteFileIfChanged(path, writer.str());
 }
 
 void FontMapManager::ParseDvipsFontMapFile(const PathName& path, set<DvipsFontMapEntry>& fontMapEntries)
@@ -964,6 +981,11 @@ set<DvipsFontMapEntry> FontMapManager::DvipdfmxToDvips(const set<DvipdfmxFontMap
 
 void FontMapManager::CopyFile(const PathName& pathSrc, const PathName& pathDest)
 {
+    if (File::Exists(pathDest) && File::GetSize(pathSrc) == File::GetSize(pathDest) && File::ReadAllBytes(pathSrc) == File::ReadAllBytes(pathDest))
+    {
+        Verbose(2, fmt::format(T_("{0} is unchanged"), Q_(pathDest)));
+        return;
+    }
     Verbose(fmt::format(T_("Copying {0}"), Q_(pathSrc)));
     Verbose(fmt::format(T_("     to {0}..."), Q_(pathDest)));
     File::Copy(pathSrc, pathDest);
@@ -1037,33 +1059,82 @@ void FontMapManager::BuildFontconfigCache(bool force)
     arguments.push_back("--miktex-disable-maintenance");
     arguments.push_back("--miktex-disable-diagnose");
 #endif
+
+    // fontconfig caches per directory: make the caches of the font
+    // directories in parallel, skipping directories which have not changed
+    // since their cache was made
+    vector<PathName> jobDirectories;
+    for (const PathName& fontDirectory : GetFontconfigDirectories())
+    {
+        if (!Directory::Exists(fontDirectory))
+        {
+            continue;
+        }
+        vector<PathName> subDirectories;
+        unique_ptr<DirectoryLister> lister = DirectoryLister::Open(fontDirectory, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
+        DirectoryEntry entry;
+        while (lister->GetNext(entry))
+        {
+            subDirectories.push_back(fontDirectory / entry.name);
+        }
+        lister->Close();
+        if (subDirectories.empty())
+        {
+            subDirectories.push_back(fontDirectory);
+        }
+        for (const PathName& dir : subDirectories)
+        {
+            if (!force && IsFontconfigCacheUpToDate(dir))
+            {
+                Verbose(2, fmt::format(T_("fontconfig cache of {0} is up-to-date"), Q_(dir)));
+                continue;
+            }
+            jobDirectories.push_back(dir);
+        }
+    }
+    if (jobDirectories.size() > 1)
+    {
+        vector<ProcessStartInfo> startInfos;
+        for (const PathName& dir : jobDirectories)
+        {
+            ProcessStartInfo startInfo(fcCacheExe);
+            startInfo.Arguments = arguments;
+            startInfo.Arguments.push_back(dir.ToString());
+            startInfos.push_back(startInfo);
+            this->ctx->logger->LogInfo(fmt::format("running: {0}", CommandLineBuilder(startInfo.Arguments).ToString()));
+        }
+        vector<ProcessRunResult> results = Process::RunAll(startInfos, max(thread::hardware_concurrency(), 1u));
+        for (size_t idx = 0; idx < results.size(); ++idx)
+        {
+            OnProcessOutput(results[idx].output.c_str(), results[idx].output.length());
+            if (results[idx].exitStatus != ProcessExitStatus::Exited || results[idx].exitCode != 0)
+            {
+                this->ctx->ui->FatalError(fmt::format(T_("{0} failed on {1}."), fcCacheExe.GetFileNameWithoutExtension().ToString(), Q_(jobDirectories[idx])));
+            }
+        }
+        // the remaining run finds the caches of the subdirectories valid:
+        // don't force it to make them again
+        arguments.erase(std::remove(arguments.begin(), arguments.end(), "--force"), arguments.end());
+    }
+
     this->ctx->logger->LogInfo(fmt::format("running: {0}", CommandLineBuilder(arguments).ToString()));
     Process::Run(fcCacheExe, arguments, this);
+
+    for (const PathName& dir : jobDirectories)
+    {
+        PathName stampFile = GetFontconfigStampFile(dir);
+        Directory::Create(stampFile.GetDirectoryName());
+        File::WriteBytes(stampFile, {});
+    }
 }
 
-void FontMapManager::CreateFontconfigLocalfontsConf()
+vector<PathName> FontMapManager::GetFontconfigDirectories()
 {
-    PathName configFile(this->ctx->session->GetSpecialPath(SpecialPath::ConfigRoot));
-    configFile /= MIKTEX_PATH_FONTCONFIG_LOCALFONTS_FILE;
-    StreamWriter writer(configFile);
-    writer.WriteLine("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
-    writer.WriteLine();
-    writer.WriteLine("<!--");
-    writer.WriteLine(T_("  DO NOT EDIT THIS FILE! It will be replaced when MiKTeX is updated."));
-#if !defined(USE_SYSTEM_FONTCONFIG)
-    writer.WriteLine(fmt::format(T_("  Instead, edit the configuration file {0}."), MIKTEX_LOCALFONTS2_CONF));
-#endif
-    writer.WriteLine("-->");
-    writer.WriteLine();
-    writer.WriteLine("<fontconfig>");
-#if !defined(USE_SYSTEM_FONTCONFIG)
-    writer.WriteLine(fmt::format("<include>{}</include>", MIKTEX_LOCALFONTS2_CONF));
-#endif
-    vector<string> paths;
+    vector<PathName> paths;
 #if !defined(USE_SYSTEM_FONTCONFIG)
     for (const string& path : this->ctx->session->GetFontDirectories())
     {
-        paths.push_back(path);
+        paths.push_back(PathName(path));
     }
 #endif
     for (unsigned r = 0; r < this->ctx->session->GetNumberOfTEXMFRoots(); ++r)
@@ -1075,13 +1146,79 @@ void FontMapManager::CreateFontconfigLocalfontsConf()
             path /= dir;
             if (Directory::Exists(path))
             {
-                paths.push_back(path.GetData());
+                paths.push_back(path);
             }
         }
     }
-    for (const string& path : paths)
+    return paths;
+}
+
+PathName FontMapManager::GetFontconfigStampFile(const PathName& fontDirectory)
+{
+    PathName path = this->ctx->session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FONTMAPS_CACHE_DIR / "fontconfig";
+    path /= MD5::FromChars(fontDirectory.ToString()).ToString();
+    path.AppendExtension(".stamp");
+    return path;
+}
+
+bool FontMapManager::IsFontconfigCacheUpToDate(const PathName& fontDirectory)
+{
+    // like fontconfig, look at the time stamps of the directories: adding or
+    // removing a font file changes the time stamp of its directory
+    PathName stampFile = GetFontconfigStampFile(fontDirectory);
+    if (!File::Exists(stampFile))
+    {
+        return false;
+    }
+    try
+    {
+        time_t stampTime = File::GetLastWriteTime(stampFile);
+        vector<PathName> directories{ fontDirectory };
+        while (!directories.empty())
+        {
+            PathName dir = directories.back();
+            directories.pop_back();
+            if (File::GetLastWriteTime(dir) >= stampTime)
+            {
+                return false;
+            }
+            unique_ptr<DirectoryLister> lister = DirectoryLister::Open(dir, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
+            DirectoryEntry entry;
+            while (lister->GetNext(entry))
+            {
+                directories.push_back(dir / entry.name);
+            }
+            lister->Close();
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+        return false;
+    }
+    return true;
+}
+
+void FontMapManager::CreateFontconfigLocalfontsConf()
+{
+    PathName configFile(this->ctx->session->GetSpecialPath(SpecialPath::ConfigRoot));
+    configFile /= MIKTEX_PATH_FONTCONFIG_LOCALFONTS_FILE;
+    StreamWriter writer(configFile);
+    writer.WriteLine("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+    writer.WriteLine();
+    writer.WriteLine("<!--");
+    writer.WriteLine(T_("  DO NOT EDIT THIS FILE! It will be replaced when MiKTeX is updated."));
+#if !defined(USE_SYSTEM_FONTCONFIG)
+    writer.WriteLine(fmt::format(T_("  Instead, edit the configuration file {0}."), MIKTEX_LOCALFONTS2_CONF));
+#endif
+    writer.WriteLine("-->");
+    writer.WriteLine();
+    writer.WriteLine("<fontconfig>");
+#if !defined(USE_SYSTEM_FONTCONFIG)
+    writer.WriteLine(fmt::format("<include>{}</include>", MIKTEX_LOCALFONTS2_CONF));
+#endif
+    for (const PathName& path : GetFontconfigDirectories())
     {
-        writer.WriteLine(fmt::format("<dir>{}</dir>", path));
+        writer.WriteLine(fmt::format("<dir>{}</dir>", path.GetData()));
     }
     writer.WriteLine("</fontconfig>");
     writer.Close();
@@ -1144,10 +1281,93 @@ set<DvipsFontMapEntry> GeneratePdfTeXFontMap(const set<DvipsFontMapEntry>& trans
     return result;
 }
 
+MD5 FontMapManager::GetInputDigest()
+{
+    MD5Builder md5Builder;
+    auto update = [&md5Builder](const string& s)
+    {
+        md5Builder.Update(s.c_str(), s.length() + 1);
+    };
+    update(MIKTEX_COMPONENT_VERSION_STR);
+    update(outputDirectory);
+    for (const auto& kv : optionDefaults)
+    {
+        update(kv.first);
+        update(this->Option(kv.first));
+    }
+    // a source map file is identified by its location, its size and its time
+    // stamp
+    auto updateMapFile = [&](const string& fileName)
+    {
+        update(fileName);
+        PathName path;
+        if (LocateFontMapFile(fileName, path, false))
+        {
+            update(path.ToString());
+            update(std::to_string(File::GetSize(path)));
+            update(std::to_string(File::GetLastWriteTime(path)));
+        }
+    };
+    for (const string& fileName : { "dvips35.map", "pdftex35.map", "ps2pk35.map" })
+    {
+        updateMapFile(fileName);
+    }
+    for (const set<string>* fileNames : { &this->config.mixedMapFiles, &this->config.mapFiles, &this->config.kanjiMapFiles })
+    {
+        update("");
+        for (const string& fileName : *fileNames)
+        {
+            updateMapFile(fileName);
+        }
+    }
+    return md5Builder.Final();
+}
+
+PathName FontMapManager::GetInputDigestFile()
+{
+    PathName path = this->ctx->session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FONTMAPS_CACHE_DIR;
+    path /= outputDirectory.empty() ? "fontmaps" : MD5::FromChars(outputDirectory).ToString();
+    path.AppendExtension(".md5");
+    return path;
+}
+
+bool FontMapManager::IsUpToDate(const MD5& inputDigest)
+{
+    PathName inputDigestFile = GetInputDigestFile();
+    if (!File::Exists(inputDigestFile))
+    {
+        return false;
+    }
+    vector<unsigned char> oldDigest = File::ReadAllBytes(inputDigestFile);
+    if (string(oldDigest.begin(), oldDigest.end()) != inputDigest.ToString())
+    {
+        return false;
+    }
+    for (const PathName& path : {
+        FontMapDirectory("dvipdfmx") / "kanjix.map",
+        FontMapDirectory("dvips") / "psfonts.map",
+        FontMapDirectory("pdftex") / "pdftex.map" })
+    {
+        if (!File::Exists(path))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void FontMapManager::WriteMapFiles(bool force, const string& outputDirectory)
 {
     this->outputDirectory = outputDirectory;
 
+    MD5 inputDigest = GetInputDigest();
+    if (!force && IsUpToDate(inputDigest))
+    {
+        Verbose(T_("The font map files are up to date."));
+        BuildFontconfigCache(force);
+        return;
+    }
+
     set<DvipsFontMapEntry> dvips35;
     ReadDvipsFontMapFile("dvips35.map", dvips35, true);
 
@@ -1182,5 +1402,17 @@ void FontMapManager::WriteMapFiles(bool force, const string& outputDirectory)
 
     SymlinkOrCopyFiles();
 
+    // programs which look up single fonts (e.g., makepk) use the index of the map file
+    for (const PathName& mapFile : { FontMapDirectory("dvips") / "ps2pk.map", FontMapDirectory("dvips") / "psfonts.map", FontMapDirectory("pdftex") / "pdftex.map" })
+    {
+        Verbose(2, fmt::format(T_("Indexing {0}..."), Q_(mapFile)));
+        Utils::MakeDvipsFontMapIndex(mapFile);
+    }
+
+    PathName inputDigestFile = GetInputDigestFile();
+    Directory::Create(inputDigestFile.GetDirectoryName());
+    string inputDigestString = inputDigest.ToString();
+    File::WriteBytes(inputDigestFile, vector<unsigned char>(inputDigestString.begin(), inputDigestString.end()));
+
     BuildFontconfigCache(force);
 }
@@ -23,7 +23,9 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <vector>
 
+#include <miktex/Core/MD5>
 #include <miktex/Core/Utils>
 
 #include <miktex/Util/PathName>
@@ -107,6 +109,14 @@ private:
 
     void WriteDvipdfmxFontMapFile(const MiKTeX::Util::PathName& path, const std::set<DvipdfmxFontMapEntry>& fontMapEntries);
 
+    void WriteFileIfChanged(const MiKTeX::Util::PathName& path, const std::string& contents);
+
+    MiKTeX::Core::MD5 GetInputDigest();
+
+    MiKTeX::Util::PathName GetInputDigestFile();
+
+    bool IsUpToDate(const MiKTeX::Core::MD5& inputDigest);
+
     std::set<MiKTeX::Core::DvipsFontMapEntry> CatDvipsFontMaps(const std::set<std::string>& fileNames);
 
     std::set<DvipdfmxFontMapEntry> CatDvipdfmxFontMaps(const std::set<std::string>& fileNames);
@@ -125,6 +135,12 @@ private:
 
     void BuildFontconfigCache(bool force);
 
+    std::vector<MiKTeX::Util::PathName> GetFontconfigDirectories();
+
+    MiKTeX::Util::PathName GetFontconfigStampFile(const MiKTeX::Util::PathName& fontDirectory);
+
+    bool IsFontconfigCacheUpToDate(const MiKTeX::Util::PathName& fontDirectory);
+
     void CreateFontconfigLocalfontsConf();
 
     void Verbose(int level, const std::string& s)
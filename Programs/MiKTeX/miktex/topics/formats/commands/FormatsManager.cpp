@@ -13,7 +13,14 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <fmt/format.h>
@@ -41,7 +48,7 @@ void FormatsManager::Init(ApplicationContext& ctx)
     this->ctx = &ctx;
 }
 
-void FormatsManager::Build(const string& formatKey)
+void FormatsManager::Build(const string& formatKey, bool compress)
 {
     if (find(this->formatsMade.begin(), this->formatsMade.end(), formatKey) != this->formatsMade.end())
     {
@@ -52,6 +59,138 @@ void FormatsManager::Build(const string& formatKey)
 
     this->ctx->ui->Verbose(0, fmt::format(T_("Building format '{0}' with engine '{1}'..."), formatInfo.key, formatInfo.compiler));
 
+    if (!formatInfo.preloaded.empty())
+    {
+        if (PathName::Equals(PathName(formatInfo.preloaded), PathName(formatKey)))
+        {
+            this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), formatKey));
+        }
+        // RECURSION
+        this->Build(formatInfo.preloaded, compress);
+    }
+
+    this->RunJob(this->MakeJob(formatInfo, compress));
+
+    this->formatsMade.push_back(formatKey);
+}
+
+void FormatsManager::Build(const vector<string>& formatKeys, bool compress, unsigned jobs)
+{
+    if (jobs <= 1)
+    {
+        for (const auto& key : formatKeys)
+        {
+            this->Build(key, compress);
+        }
+        return;
+    }
+
+    // collect the requested formats and the formats they preload; the
+    // session is not used by the worker threads
+    vector<FormatInfo> pending;
+    map<string, Job> jobMap;
+    for (const auto& formatKey : formatKeys)
+    {
+        string key = formatKey;
+        while (!key.empty()
+            && jobMap.find(key) == jobMap.end()
+            && find(this->formatsMade.begin(), this->formatsMade.end(), key) == this->formatsMade.end())
+        {
+            auto formatInfo = this->Format(key);
+            if (!formatInfo.preloaded.empty() && PathName::Equals(PathName(formatInfo.preloaded), PathName(key)))
+            {
+                this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), key));
+            }
+            jobMap[key] = this->MakeJob(formatInfo, compress);
+            pending.push_back(formatInfo);
+            key = formatInfo.preloaded;
+        }
+    }
+
+    set<string> done(this->formatsMade.begin(), this->formatsMade.end());
+    unsigned running = 0;
+    exception_ptr failure;
+    mutex mtx;
+    condition_variable cv;
+
+    auto isReady = [&done](const FormatInfo& formatInfo)
+    {
+        return formatInfo.preloaded.empty() || done.find(formatInfo.preloaded) != done.end();
+    };
+
+    auto worker = [&]()
+    {
+        unique_lock<mutex> lock(mtx);
+        while (failure == nullptr)
+        {
+            auto it = find_if(pending.begin(), pending.end(), isReady);
+            if (it == pending.end())
+            {
+                if (running == 0)
+                {
+                    break;
+                }
+                cv.wait(lock);
+                continue;
+            }
+            FormatInfo formatInfo = *it;
+            pending.erase(it);
+            running += 1;
+            this->ctx->ui->Verbose(0, fmt::format(T_("Building format '{0}' with engine '{1}'..."), formatInfo.key, formatInfo.compiler));
+            const Job& job = jobMap[formatInfo.key];
+            lock.unlock();
+            exception_ptr jobFailure;
+            try
+            {
+                this->RunJob(job);
+            }
+            catch (...)
+            {
+                jobFailure = current_exception();
+            }
+            lock.lock();
+            running -= 1;
+            if (jobFailure != nullptr)
+            {
+                // do not start new jobs; running jobs are allowed to finish
+                if (failure == nullptr)
+                {
+                    failure = jobFailure;
+                }
+            }
+            else
+            {
+                done.insert(formatInfo.key);
+                this->formatsMade.push_back(formatInfo.key);
+            }
+            cv.notify_all();
+        }
+        cv.notify_all();
+    };
+
+    vector<thread> threads;
+    for (unsigned idx = 0; idx < min(jobs, static_cast<unsigned>(pending.size())); ++idx)
+    {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (failure != nullptr)
+    {
+        rethrow_exception(failure);
+    }
+
+    if (!pending.empty())
+    {
+        this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), pending.front().key));
+    }
+}
+
+FormatsManager::Job FormatsManager::MakeJob(const FormatInfo& formatInfo, bool compress)
+{
     string maker;
 
     vector<string> arguments;
@@ -70,12 +209,6 @@ void FormatsManager::Build(const string& formatKey)
 
     if (!formatInfo.preloaded.empty())
     {
-        if (PathName::Equals(PathName(formatInfo.preloaded), PathName(formatKey)))
-        {
-            this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), formatKey));
-        }
-        // RECURSION
-        this->Build(formatInfo.preloaded);
         arguments.push_back("--preload="s + formatInfo.preloaded);
     }
 
@@ -91,52 +224,59 @@ void FormatsManager::Build(const string& formatKey)
         arguments.push_back("--engine-option="s + a);
     }
 
-    this->RunMakeTeX(maker, arguments);
-
-    this->formatsMade.push_back(formatKey);
-}
+    // LuaTeX and HiTeX have their own format file handling
+    if (compress && formatInfo.compiler != "luatex" && formatInfo.compiler != "luahbtex" && formatInfo.compiler != "hitex")
+    {
+        arguments.push_back("--engine-option=--compress-dump");
+    }
 
-void FormatsManager::RunMakeTeX(const string& makeProg, const vector<string>& arguments)
-{
-    PathName exe;
+    Job job;
 
-    if (!this->ctx->session->FindFile(makeProg, FileType::EXE, exe))
+    if (!this->ctx->session->FindFile(maker, FileType::EXE, job.exe))
     {
-        this->ctx->ui->FatalError(fmt::format(T_("{0}: not found"), Q_(makeProg)));
+        this->ctx->ui->FatalError(fmt::format(T_("{0}: not found"), Q_(maker)));
     }
 
-    vector<string> xArguments{ makeProg };
+    job.arguments.push_back(maker);
 
-    xArguments.insert(xArguments.end(), arguments.begin(), arguments.end());
+    job.arguments.insert(job.arguments.end(), arguments.begin(), arguments.end());
 
     if (ctx->ui->VerbosityLevel() > 0)
     {
-        xArguments.push_back("--verbose");
+        job.arguments.push_back("--verbose");
     }
 
     if (this->ctx->ui->BeingQuiet())
     {
-        xArguments.push_back("--quiet");
+        job.arguments.push_back("--quiet");
     }
 
     if (this->ctx->session->IsAdminMode())
     {
-        xArguments.push_back("--admin");
+        job.arguments.push_back("--admin");
     }
 
     if (this->ctx->installer->IsInstallerEnabled())
     {
-        xArguments.push_back("--enable-installer");
+        job.arguments.push_back("--enable-installer");
     }
     else if (this->ctx->installer->IsInstallerDisabled())
     {
-        xArguments.push_back("--disable-installer");
+        job.arguments.push_back("--disable-installer");
     }
 
-    xArguments.push_back("--miktex-disable-maintenance");
-    xArguments.push_back("--miktex-disable-diagnose");
+    job.arguments.push_back("--miktex-disable-maintenance");
+    job.arguments.push_back("--miktex-disable-diagnose");
+
+    // each format gets its own log file, also when jobs run concurrently
+    job.outputName = job.exe.GetFileNameWithoutExtension().ToString() + "-" + formatInfo.key;
 
-    this->ctx->processRunner->RunProcess(exe, xArguments);
+    return job;
+}
+
+void FormatsManager::RunJob(const Job& job)
+{
+    this->ctx->processRunner->RunProcess(job.exe, job.arguments, job.outputName);
 }
 
 vector<FormatInfo> FormatsManager::Formats()
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Build TeX format files
  *
- * @copyright Copyright © 2002-2022 Christian Schenk
+ * @copyright Copyright © 2002-2024 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include <miktex/Core/Session>
+#include <miktex/Util/PathName>
 
 #include "internal.h"
 
@@ -24,12 +25,21 @@ public:
 
     MiKTeX::Core::FormatInfo Format(const std::string& formatKey);
     std::vector<MiKTeX::Core::FormatInfo> Formats();
-    void Build(const std::string& formatKey);
+    void Build(const std::string& formatKey, bool compress);
+    void Build(const std::vector<std::string>& formatKeys, bool compress, unsigned jobs);
     void Init(OneMiKTeXUtility::ApplicationContext& ctx);
 
 private:
 
-    void RunMakeTeX(const std::string& makeProg, const std::vector<std::string>& arguments);
+    struct Job
+    {
+        MiKTeX::Util::PathName exe;
+        std::vector<std::string> arguments;
+        std::string outputName;
+    };
+
+    Job MakeJob(const MiKTeX::Core::FormatInfo& formatInfo, bool compress);
+    void RunJob(const Job& job);
 
     OneMiKTeXUtility::ApplicationContext* ctx;
     std::vector<std::string> formatsMade;
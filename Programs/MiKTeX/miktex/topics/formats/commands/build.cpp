@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief formats build
  *
- * @copyright Copyright © 2021-2022 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -13,6 +13,8 @@
 
 #include <config.h>
 
+#include <cstdlib>
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -47,7 +49,7 @@ namespace
 
         std::string Synopsis() override
         {
-            return "build [--engine <engine>] [<key>]";
+            return "build [--compress] [--engine <engine>] [--jobs <n>] [<key>...]";
         }
     };
 }
@@ -68,11 +70,20 @@ unique_ptr<Command> Commands::Build()
 enum Option
 {
     OPT_AAA = 1,
+    OPT_COMPRESS,
     OPT_ENGINE,
+    OPT_JOBS,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "compress", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_COMPRESS,
+        T_("Compress the format files."),
+        nullptr
+    },
     {
         "engine", 0,
         POPT_ARG_STRING, nullptr,
@@ -80,6 +91,13 @@ static const struct poptOption options[] =
         T_("Engine to be used."),
         T_("ENGINE")
     },
+    {
+        "jobs", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_JOBS,
+        T_("Build up to N format files at the same time."),
+        T_("N")
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -90,13 +108,28 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
     PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
     int option;
     string engine;
+    bool compress = false;
+    unsigned jobs = 1;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
         {
+        case OPT_COMPRESS:
+            compress = true;
+            break;
         case OPT_ENGINE:
             engine = popt.GetOptArg();
             break;
+        case OPT_JOBS:
+        {
+            int n = std::atoi(popt.GetOptArg().c_str());
+            if (n < 1)
+            {
+                ctx.ui->IncorrectUsage(T_("the number of jobs must be positive"));
+            }
+            jobs = static_cast<unsigned>(n);
+            break;
+        }
         }
     }
     if (option != -1)
@@ -104,12 +137,9 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
         ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
     }
     auto leftOvers = popt.GetLeftovers();
-    if (leftOvers.size() > 1)
-    {
-        ctx.ui->IncorrectUsage(T_("too many arguments"));
-    }
     FormatsManager mgr;
     mgr.Init(ctx);
+    vector<string> formatKeys;
     if (leftOvers.empty())
     {
         for (auto& f : mgr.Formats())
@@ -118,21 +148,24 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
             {
                 continue;
             }
-            mgr.Build(f.key);
+            formatKeys.push_back(f.key);
         }
     }
     else
     {
-        string key = leftOvers[0];
-        if (!engine.empty())
+        for (const auto& key : leftOvers)
         {
-            auto formatInfo = mgr.Format(key);
-            if (engine != formatInfo.compiler)
+            if (!engine.empty())
             {
-                ctx.ui->FatalError(fmt::format(T_("{0}: cannot be built by {1}"), key, engine));
+                auto formatInfo = mgr.Format(key);
+                if (engine != formatInfo.compiler)
+                {
+                    ctx.ui->FatalError(fmt::format(T_("{0}: cannot be built by {1}"), key, engine));
+                }
             }
+            formatKeys.push_back(key);
         }
-        mgr.Build(key);
     }
+    mgr.Build(formatKeys, compress, jobs);
     return 0;
 }
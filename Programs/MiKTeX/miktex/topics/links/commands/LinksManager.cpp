@@ -13,7 +13,12 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -22,6 +27,7 @@
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Cfg>
 #include <miktex/Core/Directory>
+#include <miktex/Core/Fndb>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Utils>
 #include <miktex/Util/PathName>
@@ -85,10 +91,14 @@ void LinksManager::ManageLinks(LinkCategoryOptions linkCategories, bool uninstal
     Directory::Create(pathBinDir);
   }
 
+  vector<LinkJob> jobs;
+
   for (const FileLink& fileLink : CollectLinks(linkCategories))
   {
-    ManageLink(fileLink, supportsHardLinks, uninstall, force);
+    ManageLink(fileLink, supportsHardLinks, uninstall, force, jobs);
   }
+
+  RunLinkJobs(jobs);
 }
 
 #if defined(MIKTEX_UNIX)
@@ -130,7 +140,7 @@ void LinksManager::MakeFilesExecutable()
 }
 #endif
 
-void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite)
+void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite, vector<LinkJob>& jobs)
 {
     LinkType linkType = fileLink.linkType;
     if (linkType == LinkType::Hard && !supportsHardLinks)
@@ -139,13 +149,32 @@ void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks,
     }
     for (const string& linkName : fileLink.linkNames)
     {
+        if (!isRemoveRequested)
+        {
+            // some names are used for more than one target (e.g., eptex): as
+            // if the links were created one after another, the first one
+            // wins, unless existing links are overwritten
+            auto planned = find_if(jobs.begin(), jobs.end(), [&linkName](const LinkJob& job) { return job.linkName == PathName(linkName); });
+            if (planned != jobs.end())
+            {
+                if (!allowOverwrite)
+                {
+                    continue;
+                }
+                jobs.erase(planned);
+            }
+        }
         FileExistsOptionSet fileExistsOptions;
 #if defined(MIKTEX_UNIX)
         fileExistsOptions += FileExistsOption::SymbolicLink;
 #endif
         if (File::Exists(PathName(linkName), fileExistsOptions))
         {
-            if (!isRemoveRequested && (!allowOverwrite || (linkType == LinkType::Copy && File::Equals(PathName(fileLink.target), PathName(linkName)))))
+            // a link which already refers to the target is left alone
+            if (!isRemoveRequested
+                && (!allowOverwrite
+                    || File::IsSameFile(PathName(fileLink.target), PathName(linkName))
+                    || (linkType == LinkType::Copy && File::Equals(PathName(fileLink.target), PathName(linkName)))))
             {
                 continue;
             }
@@ -192,16 +221,16 @@ void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks,
                 target = fileLink.target.c_str();
             }
             this->ctx->ui->Verbose(2, fmt::format(T_("Creating symbolic link: {0} -> {1}..."), Q_(PathName(linkName).ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
-            File::CreateLink(PathName(target), PathName(linkName), { CreateLinkOption::UpdateFndb, CreateLinkOption::Symbolic });
+            jobs.push_back(LinkJob{ linkType, PathName(target), PathName(linkName) });
             break;
         }
         case LinkType::Hard:
             this->ctx->ui->Verbose(2, fmt::format(T_("Creating hard link: {0} -> {1}..."), Q_(PathName(linkName).ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
-            File::CreateLink(PathName(fileLink.target), PathName(linkName), { CreateLinkOption::UpdateFndb });
+            jobs.push_back(LinkJob{ linkType, PathName(fileLink.target), PathName(linkName) });
             break;
         case LinkType::Copy:
             this->ctx->ui->Verbose(2, fmt::format(T_("Copying: {0} -> {1}..."), Q_(PathName(linkName).ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
-            File::Copy(PathName(fileLink.target), PathName(linkName), { FileCopyOption::PreserveMode, FileCopyOption::UpdateFndb });
+            jobs.push_back(LinkJob{ linkType, PathName(fileLink.target), PathName(linkName) });
             break;
         default:
             MIKTEX_UNEXPECTED();
@@ -209,6 +238,115 @@ void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks,
     }
 }
 
+void LinksManager::RunLinkJobs(const vector<LinkJob>& jobs)
+{
+    struct Outcome
+    {
+        bool done = false;
+        LinkType linkType = LinkType::Copy;
+    };
+
+    // the links are independent of each other: they are created
+    // concurrently, which pays off when executables have to be copied
+    vector<Outcome> outcomes(jobs.size());
+    atomic<size_t> nextJob(0);
+    exception_ptr failure;
+    mutex mtx;
+
+    auto worker = [&]()
+    {
+        for (size_t idx = nextJob++; idx < jobs.size(); idx = nextJob++)
+        {
+            {
+                lock_guard<mutex> lock(mtx);
+                if (failure != nullptr)
+                {
+                    return;
+                }
+            }
+            try
+            {
+                outcomes[idx].linkType = RunLinkJob(jobs[idx]);
+                outcomes[idx].done = true;
+            }
+            catch (...)
+            {
+                lock_guard<mutex> lock(mtx);
+                if (failure == nullptr)
+                {
+                    failure = current_exception();
+                }
+                return;
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned idx = 0; idx < min(max(thread::hardware_concurrency(), 1u), static_cast<unsigned>(jobs.size())); ++idx)
+    {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    // the session is not used by the worker threads: the file name database
+    // is updated in one go
+    vector<Fndb::Record> records;
+    for (size_t idx = 0; idx < jobs.size(); ++idx)
+    {
+        if (!outcomes[idx].done)
+        {
+            continue;
+        }
+        if (outcomes[idx].linkType != jobs[idx].linkType)
+        {
+            this->ctx->ui->Verbose(2, fmt::format(T_("{0}: hard link could not be created; copied instead"), Q_(jobs[idx].linkName.ToDisplayString())));
+        }
+        if (this->ctx->session->TryDeriveTEXMFRoot(jobs[idx].linkName) != INVALID_ROOT_INDEX && !Fndb::FileExists(jobs[idx].linkName))
+        {
+            records.push_back({ jobs[idx].linkName });
+        }
+    }
+    if (!records.empty())
+    {
+        Fndb::Add(records);
+    }
+
+    if (failure != nullptr)
+    {
+        rethrow_exception(failure);
+    }
+}
+
+LinkType LinksManager::RunLinkJob(const LinkJob& job)
+{
+    switch (job.linkType)
+    {
+    case LinkType::Symbolic:
+        File::CreateLink(job.target, job.linkName, { CreateLinkOption::Symbolic });
+        return LinkType::Symbolic;
+    case LinkType::Hard:
+        try
+        {
+            File::CreateLink(job.target, job.linkName, {});
+            return LinkType::Hard;
+        }
+        catch (const MiKTeXException&)
+        {
+            // e.g., the target lives on another volume
+        }
+        File::Copy(job.target, job.linkName, { FileCopyOption::PreserveMode });
+        return LinkType::Copy;
+    case LinkType::Copy:
+        File::Copy(job.target, job.linkName, { FileCopyOption::PreserveMode });
+        return LinkType::Copy;
+    default:
+        MIKTEX_UNEXPECTED();
+    }
+}
+
 vector<FileLink> LinksManager::CollectLinks(LinkCategoryOptions linkCategories)
 {
   vector<FileLink> result;
@@ -400,6 +538,7 @@ const vector<FileLink> LinksManager::miktexFileLinks =
   { MIKTEX_PK2BM_EXE, { "pk2bm" } },
   { MIKTEX_PLTOTF_EXE, { "pltotf" } },
   { MIKTEX_PMXAB_EXE, { "pmxab" } },
+  { MIKTEX_PREFIX "pmxbatch" MIKTEX_EXE_FILE_SUFFIX, { "pmxbatch" } },
   { MIKTEX_POOLTYPE_EXE, { "pooltype" } },
   { MIKTEX_PREPMX_EXE, { "prepmx" } },
   { MIKTEX_PS2PK_EXE, { "ps2pk" } },
@@ -16,6 +16,7 @@
 #include <vector>
 
 #include <miktex/Util/OptionSet>
+#include <miktex/Util/PathName>
 
 #include "internal.h"
 
@@ -84,11 +85,22 @@ public:
 
 private:
 
+    struct LinkJob
+    {
+        LinkType linkType;
+        MiKTeX::Util::PathName target;
+        MiKTeX::Util::PathName linkName;
+    };
+
     std::vector<FileLink> CollectLinks(LinkCategoryOptions linkCategories);
 
     void ManageLinks(LinkCategoryOptions linkCategories, bool uninstall, bool force);
 
-    void ManageLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite);
+    void ManageLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite, std::vector<LinkJob>& jobs);
+
+    void RunLinkJobs(const std::vector<LinkJob>& jobs);
+
+    static LinkType RunLinkJob(const LinkJob& job);
 
 #if defined(MIKTEX_UNIX)
     void MakeFilesExecutable();
@@ -14,16 +14,22 @@
 #include <config.h>
 
 #include <memory>
+#include <queue>
+#include <regex>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/File>
 #include <miktex/Core/Session>
+#include <miktex/Core/StreamReader>
 #include <miktex/PackageManager/PackageManager>
 #include <miktex/Util/PathName>
+#include <miktex/Util/StringUtil>
 #include <miktex/Wrappers/PoptWrapper>
 
 #include "internal.h"
@@ -51,9 +57,11 @@ namespace
 
         std::string Synopsis() override
         {
-            return "require [--package-id-file <file>] [--repository <repository>] <package-id>...";
+            return "require [--package-id-file <file>] [--repository <repository>] [--scan <file>] <package-id>...";
         }
 
+        std::vector<std::string> Scan(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<MiKTeX::Util::PathName>& documents);
+
         void Require(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& requiredPackages, const std::string& repository);
     };
 }
@@ -79,6 +87,7 @@ enum Option
     OPT_AAA = 1,
     OPT_PACKAGE_ID_FILE,
     OPT_REPOSITORY,
+    OPT_SCAN,
 };
 
 static const struct poptOption options[] =
@@ -97,6 +106,13 @@ static const struct poptOption options[] =
         T_("Use the specified location as the package repository.  The location can be either a fully qualified path name (a local package repository) or an URL (a remote package repository)."),
         T_("LOCATION")
     },
+    {
+        "scan", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_SCAN,
+        T_("Require the packages which are loaded by the LaTeX document FILE."),
+        "FILE"
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -108,6 +124,7 @@ int RequireCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
     int option;
     string repository;
     vector<string> requiredPackages;
+    vector<PathName> documents;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
@@ -117,6 +134,10 @@ int RequireCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
             break;
         case OPT_REPOSITORY:
             repository = popt.GetOptArg();
+            break;
+        case OPT_SCAN:
+            documents.push_back(PathName(popt.GetOptArg()));
+            break;
         }
     }
     if (option != -1)
@@ -125,6 +146,15 @@ int RequireCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
     }
     auto leftOvers = popt.GetLeftovers();
     requiredPackages.insert(requiredPackages.end(), leftOvers.begin(), leftOvers.end());
+    if (!documents.empty())
+    {
+        vector<string> scannedPackages = Scan(ctx, documents);
+        if (requiredPackages.empty() && scannedPackages.empty())
+        {
+            return 0;
+        }
+        requiredPackages.insert(requiredPackages.end(), scannedPackages.begin(), scannedPackages.end());
+    }
     if (requiredPackages.empty())
     {
         ctx.ui->FatalError(T_("missing package ID"));
@@ -133,6 +163,119 @@ int RequireCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
     return 0;
 }
 
+static string StripComments(const string& line)
+{
+    for (size_t pos = 0; pos < line.length(); ++pos)
+    {
+        if (line[pos] == '\\')
+        {
+            ++pos;
+        }
+        else if (line[pos] == '%')
+        {
+            return line.substr(0, pos);
+        }
+    }
+    return line;
+}
+
+vector<string> RequireCommand::Scan(ApplicationContext& ctx, const vector<PathName>& documents)
+{
+    // \usepackage[options]{name1,name2}
+    static const regex loadCommand(R"(\\(documentclass|LoadClass|LoadClassWithOptions|usepackage|RequirePackage|RequirePackageWithOptions)\s*(\[[^\]]*\])?\s*\{([^}]*)\})");
+    set<string> fileNames;
+    set<string> scanned;
+    queue<PathName> toBeScanned;
+    for (const PathName& document : documents)
+    {
+        toBeScanned.push(document);
+    }
+    while (!toBeScanned.empty())
+    {
+        PathName document = toBeScanned.front();
+        toBeScanned.pop();
+        if (!scanned.insert(document.ToString()).second)
+        {
+            continue;
+        }
+        ctx.ui->Verbose(1, fmt::format(T_("scanning {0}"), Q_(document)));
+        // the file is read as a whole: arguments may span lines
+        string text;
+        StreamReader reader(document);
+        string line;
+        while (reader.ReadLine(line))
+        {
+            text += StripComments(line);
+            text += ' ';
+        }
+        reader.Close();
+        for (sregex_iterator it(text.begin(), text.end(), loadCommand); it != sregex_iterator(); ++it)
+        {
+            string command = (*it)[1];
+            string extension = command.find("Class") != string::npos || command == "documentclass" ? ".cls" : ".sty";
+            for (const string& name : StringUtil::Split((*it)[3], ','))
+            {
+                string trimmed = name;
+                trimmed.erase(0, trimmed.find_first_not_of(" \t"));
+                trimmed.erase(trimmed.find_last_not_of(" \t") + 1);
+                if (trimmed.empty())
+                {
+                    continue;
+                }
+                PathName fileName(trimmed + extension);
+                // a class or style file next to the document is scanned, too
+                PathName local = document.GetDirectoryName() / fileName.ToString();
+                if (File::Exists(local))
+                {
+                    toBeScanned.push(local);
+                }
+                else
+                {
+                    fileNames.insert(fileName.ToString());
+                }
+            }
+        }
+    }
+    if (fileNames.empty())
+    {
+        return {};
+    }
+
+    // map the file names to package IDs
+    unordered_map<string, string> packages;
+    auto packageIterator = ctx.packageManager->CreateIterator();
+    PackageInfo packageInfo;
+    while (packageIterator->GetNext(packageInfo))
+    {
+        if (packageInfo.IsPureContainer())
+        {
+            continue;
+        }
+        for (const string& runFile : packageInfo.runFiles)
+        {
+            string fileName = PathName(runFile).GetFileName().ToString();
+            if (fileNames.find(fileName) != fileNames.end())
+            {
+                packages.emplace(fileName, packageInfo.id);
+            }
+        }
+    }
+    packageIterator->Dispose();
+    set<string> result;
+    for (const string& fileName : fileNames)
+    {
+        auto it = packages.find(fileName);
+        if (it == packages.end())
+        {
+            ctx.ui->Verbose(1, fmt::format(T_("{0}: not provided by any package"), fileName));
+            continue;
+        }
+        ctx.ui->Verbose(1, fmt::format(T_("{0}: provided by package {1}"), fileName, it->second));
+        result.insert(it->second);
+    }
+    return vector<string>(result.begin(), result.end());
+}
+
 void RequireCommand::Require(ApplicationContext& ctx, const vector<string>& requiredPackages, const string& repository)
 {
     vector<string> toBeInstalled;
@@ -144,6 +287,12 @@ void RequireCommand::Require(ApplicationContext& ctx, const vector<string>& requ
             toBeInstalled.push_back(packageID);
         }
     }
+    if (toBeInstalled.empty())
+    {
+        return;
+    }
+    // dependencies are resolved by the installer: all packages are
+    // installed in one transaction
     MyPackageInstallerCallback cb;
     auto packageInstaller = ctx.packageManager->CreateInstaller({ &cb, true, true });
     if (!repository.empty())
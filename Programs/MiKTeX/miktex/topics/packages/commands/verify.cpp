@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief packages verify
  *
- * @copyright Copyright © 2022 Christian Schenk
+ * @copyright Copyright © 2022-2024 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -135,15 +135,12 @@ void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVe
             }
         }
     }
-    bool ok = true;
-    for (const string& packageID : toBeVerified)
+    vector<string> damagedPackages = ctx.packageManager->VerifyInstalledPackages(toBeVerified);
+    for (const string& packageID : damagedPackages)
     {
-        if (!ctx.packageManager->TryVerifyInstalledPackage(packageID))
-        {
-            ctx.ui->Verbose(0, fmt::format(T_("{0}: this package needs to be reinstalled."), packageID));
-            ok = false;
-        }
+        ctx.ui->Verbose(0, fmt::format(T_("{0}: this package needs to be reinstalled."), packageID));
     }
+    bool ok = damagedPackages.empty();
     if (ok)
     {
         if (verifyAll)
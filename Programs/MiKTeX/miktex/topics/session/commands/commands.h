@@ -0,0 +1,23 @@
+/**
+ * @file topics/session/commands/commands.h
+ * @author Christian Schenk
+ * @brief session commands
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <memory>
+
+#include "internal.h"
+
+#include "topics/Command.h"
+
+namespace OneMiKTeXUtility::Topics::Session::Commands
+{
+    std::unique_ptr<OneMiKTeXUtility::Topics::Command> Serve();
+}
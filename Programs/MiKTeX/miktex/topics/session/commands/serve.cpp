@@ -0,0 +1,93 @@
+/**
+ * @file topics/session/commands/serve.cpp
+ * @author Christian Schenk
+ * @brief session serve
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/SessionService>
+#include <miktex/Wrappers/PoptWrapper>
+
+#include "internal.h"
+
+#include "commands.h"
+
+namespace
+{
+    class ServeCommand :
+        public OneMiKTeXUtility::Topics::Command
+    {
+        std::string Description() override
+        {
+            return T_("Answer file searches and configuration lookups of other MiKTeX programs");
+        }
+
+        int MIKTEXTHISCALL Execute(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& arguments) override;
+
+        std::string Name() override
+        {
+            return "serve";
+        }
+
+        std::string Synopsis() override
+        {
+            return "serve";
+        }
+    };
+}
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Wrappers;
+
+using namespace OneMiKTeXUtility;
+using namespace OneMiKTeXUtility::Topics;
+using namespace OneMiKTeXUtility::Topics::Session;
+
+unique_ptr<Command> Commands::Serve()
+{
+    return make_unique<ServeCommand>();
+}
+
+static const struct poptOption options[] =
+{
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+int ServeCommand::Execute(ApplicationContext& ctx, const vector<string>& arguments)
+{
+    auto argv = MakeArgv(arguments);
+    PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
+    int option;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+    }
+    if (option != -1)
+    {
+        ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
+    }
+    if (!popt.GetLeftovers().empty())
+    {
+        ctx.ui->IncorrectUsage(T_("unexpected command arguments"));
+    }
+    ctx.ui->Verbose(1, T_("Serving MiKTeX sessions..."));
+    SessionService::Run([&ctx]() { return ctx.program->Canceled(); });
+    return 0;
+}
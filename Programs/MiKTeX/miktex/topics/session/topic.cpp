@@ -0,0 +1,50 @@
+/**
+ * @file topics/session/topic.cpp
+ * @author Christian Schenk
+ * @brief session topic
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <string>
+#include <memory>
+
+#include "internal.h"
+
+#include "commands/commands.h"
+
+#include "topic.h"
+
+namespace
+{
+    class SessionTopic :
+        public OneMiKTeXUtility::Topics::TopicBase
+    {
+        std::string Description() override
+        {
+            return T_("Commands for sharing lookups between MiKTeX sessions");
+        }
+
+        std::string Name() override
+        {
+            return "session";
+        }
+
+        void RegisterCommands() override
+        {
+            this->RegisterCommand(OneMiKTeXUtility::Topics::Session::Commands::Serve());
+        }
+    };
+}
+
+std::unique_ptr<OneMiKTeXUtility::Topics::Topic> OneMiKTeXUtility::Topics::Session::Create()
+{
+    return std::make_unique<SessionTopic>();
+}
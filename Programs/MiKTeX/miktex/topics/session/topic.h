@@ -0,0 +1,23 @@
+/**
+ * @file topics/session/topic.h
+ * @author Christian Schenk
+ * @brief session topic
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <memory>
+
+#include "internal.h"
+
+#include "topics/Topic.h"
+
+namespace OneMiKTeXUtility::Topics::Session
+{
+    std::unique_ptr<Topics::Topic> Create();
+}
@@ -0,0 +1,145 @@
+/**
+ * @file topics/trace/commands/dump.cpp
+ * @author Christian Schenk
+ * @brief trace dump
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/File>
+#include <miktex/Trace/TraceRecorder>
+#include <miktex/Util/PathName>
+#include <miktex/Wrappers/PoptWrapper>
+
+#include "internal.h"
+
+#include "commands.h"
+
+namespace
+{
+    class DumpCommand :
+        public OneMiKTeXUtility::Topics::Command
+    {
+        std::string Description() override
+        {
+            return T_("Print the trace messages of a trace recorder dump file");
+        }
+
+        int MIKTEXTHISCALL Execute(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& arguments) override;
+
+        std::string Name() override
+        {
+            return "dump";
+        }
+
+        std::string Synopsis() override
+        {
+            return "dump [--template <template>] <file>";
+        }
+
+        const std::string defaultTemplate = "{time:.6f} {thread:08x} {stream}:{facility} {message}";
+    };
+}
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+using namespace OneMiKTeXUtility;
+using namespace OneMiKTeXUtility::Topics;
+
+unique_ptr<Command> Topics::Trace::Commands::Dump()
+{
+    return make_unique<DumpCommand>();
+}
+
+enum Option
+{
+    OPT_AAA = 1,
+    OPT_TEMPLATE,
+};
+
+static const struct poptOption options[] =
+{
+    {
+        "template", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_TEMPLATE,
+        T_("Specify the output template."),
+        "TEMPLATE"
+    },
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+int DumpCommand::Execute(ApplicationContext& ctx, const vector<string>& arguments)
+{
+    auto argv = MakeArgv(arguments);
+    PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
+    int option;
+    string outputTemplate = this->defaultTemplate;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+        switch (option)
+        {
+        case OPT_TEMPLATE:
+            outputTemplate = Unescape(popt.GetOptArg());
+            break;
+        }
+    }
+    if (option != -1)
+    {
+        ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
+    }
+    auto leftOvers = popt.GetLeftovers();
+    if (leftOvers.size() != 1)
+    {
+        ctx.ui->IncorrectUsage(T_("expected one <file> argument"));
+    }
+    PathName path(leftOvers[0]);
+    if (!File::Exists(path))
+    {
+        ctx.ui->FatalError(fmt::format(T_("{0}: file does not exist"), Q_(path.ToDisplayString())));
+    }
+    vector<TraceRecorder::Entry> entries;
+    try
+    {
+        entries = TraceRecorder::ReadDumpFile(path.ToString());
+    }
+    catch (const exception& e)
+    {
+        ctx.ui->FatalError(e.what());
+    }
+    for (const TraceRecorder::Entry& entry : entries)
+    {
+        // seconds since the first recorded message
+        double time = (entry.timestamp - entries.front().timestamp) / 1000000.0;
+        ctx.ui->Output(fmt::format(outputTemplate,
+            fmt::arg("facility", entry.facility),
+            fmt::arg("message", TraceCallback::TraceMessage(entry.streamName, entry.facility, entry.level, entry.message).ToString()),
+            fmt::arg("stream", entry.streamName),
+            fmt::arg("thread", entry.thread),
+            fmt::arg("time", time),
+            fmt::arg("timestamp", entry.timestamp)
+        ));
+    }
+    return 0;
+}
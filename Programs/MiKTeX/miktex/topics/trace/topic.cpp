@@ -0,0 +1,50 @@
+/**
+ * @file topics/trace/topic.cpp
+ * @author Christian Schenk
+ * @brief trace topic
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <string>
+#include <memory>
+
+#include "internal.h"
+
+#include "commands/commands.h"
+
+#include "topic.h"
+
+namespace
+{
+    class TraceTopic :
+        public OneMiKTeXUtility::Topics::TopicBase
+    {
+        std::string Description() override
+        {
+            return T_("Commands for inspecting recorded trace messages");
+        }
+
+        std::string Name() override
+        {
+            return "trace";
+        }
+
+        void RegisterCommands() override
+        {
+            this->RegisterCommand(OneMiKTeXUtility::Topics::Trace::Commands::Dump());
+        }
+    };
+}
+
+std::unique_ptr<OneMiKTeXUtility::Topics::Topic> OneMiKTeXUtility::Topics::Trace::Create()
+{
+    return std::make_unique<TraceTopic>();
+}
@@ -84,12 +84,6 @@ private:
 private:
   void Warning(const string& msg);
 
-private:
-  bool SkipPrefix(const string& str, const char* lpszPrefix, string& result);
-
-private:
-  bool SkipTeXMFPrefix(const string& str, string& result);
-
 private:
   void FindDocFilesByPackage(const string& packageName, map<string, vector<string>>& filesByExtension);
 
@@ -193,47 +187,29 @@ void MiKTeXHelp::Warning(const string& msg)
   cerr << msg << endl;
 }
 
-bool MiKTeXHelp::SkipPrefix(const string& str, const char* prefix, string& result)
-{
-  size_t n = strlen(prefix);
-  if (str.compare(0, n, prefix) != 0)
-  {
-    return false;
-  }
-  result = str.c_str() + n;
-  return true;
-}
-
-bool MiKTeXHelp::SkipTeXMFPrefix(const string& str, string& result)
-{
-  return SkipPrefix(str, "texmf/", result)
-    || SkipPrefix(str, "texmf\\", result)
-    || SkipPrefix(str, "./texmf/", result)
-    || SkipPrefix(str, ".\\texmf\\", result);
-}
-
 void MiKTeXHelp::FindDocFilesByPackage(const string& packageName, map<string, vector<string>>& filesByExtension)
 {
-  PackageInfo pi;
+  // the documentation index knows where the files are installed
+  PackageDocumentation packageDocumentation;
   string searchPath = MIKTEX_PATH_TEXMF_PLACEHOLDER;
-  if (!pManager->TryGetPackageInfo(packageName + "__doc", pi))
+  if (!pManager->TryGetPackageDocumentation(packageName + "__doc", packageDocumentation))
   {
-    if (!pManager->TryGetPackageInfo(packageName, pi))
+    if (!pManager->TryGetPackageDocumentation(packageName, packageDocumentation))
     {
       return;
     }
     searchPath = MIKTEX_PATH_TEXMF_PLACEHOLDER_NO_MPM;
   }
-  for (const string& fileName : pi.docFiles)
+  for (const DocumentationFile& file : packageDocumentation.files)
   {
-    string extension = PathName(fileName).GetExtension();
-    string file;
-    PathName path;
-    if (SkipTeXMFPrefix(fileName, file) && session->FindFile(file, searchPath, path))
+    PathName path = file.path;
+    // not installed in the installation directory: the files can be
+    // somewhere else (or installed on demand)
+    if (path.Empty() && !session->FindFile(file.fileName, searchPath, path))
     {
-      vector<string>& files = filesByExtension[extension];
-      files.push_back(path.ToString());
+      continue;
     }
+    filesByExtension[path.GetExtension()].push_back(path.ToString());
   }
 }
 
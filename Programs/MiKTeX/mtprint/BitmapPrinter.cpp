@@ -27,6 +27,12 @@
 
 #include "BitmapPrinter.h"
 
+// the pipe is read in blocks of this size
+const size_t READ_BLOCK_SIZE = 1024 * 1024;
+
+// Ghostscript may be ahead by this many bytes (about a page at 600 dpi)
+const size_t MAX_BUFFERED_BYTES = 128 * 1024 * 1024;
+
 BitmapPrinter::BitmapPrinter(const PRINTINFO & printInfo, bool printNothing) :
   Printer(printInfo, printNothing)
 {
@@ -93,7 +99,76 @@ void BitmapPrinter::OnNewChunk(shared_ptr<DibChunk> pChunk)
 
 size_t BitmapPrinter::Read(void * pBuf, size_t size)
 {
-  return stream.Read(pBuf, size);
+  size_t total = 0;
+  while (total < size)
+  {
+    unique_lock<mutex> lock(mux);
+    blockAvailable.wait(lock, [this]() { return !blocks.empty() || endOfStream || readError != nullptr; });
+    if (blocks.empty())
+    {
+      if (readError != nullptr)
+      {
+        rethrow_exception(readError);
+      }
+      break;
+    }
+    vector<char> & block = blocks.front();
+    size_t n = (std::min)(size - total, block.size() - blockOffset);
+    memcpy(reinterpret_cast<char*>(pBuf) + total, block.data() + blockOffset, n);
+    total += n;
+    blockOffset += n;
+    if (blockOffset == block.size())
+    {
+      bufferedBytes -= block.size();
+      blocks.pop_front();
+      blockOffset = 0;
+      lock.unlock();
+      spaceAvailable.notify_one();
+    }
+  }
+  return total;
+}
+
+void BitmapPrinter::ReaderThread()
+{
+  try
+  {
+    while (true)
+    {
+      vector<char> block(READ_BLOCK_SIZE);
+      size_t n = stream.Read(block.data(), block.size());
+      unique_lock<mutex> lock(mux);
+      if (n == 0 || stopReader)
+      {
+        endOfStream = true;
+        break;
+      }
+      block.resize(n);
+      bufferedBytes += n;
+      blocks.push_back(std::move(block));
+      blockAvailable.notify_one();
+      spaceAvailable.wait(lock, [this]() { return bufferedBytes < MAX_BUFFERED_BYTES || stopReader; });
+    }
+  }
+  catch (const exception &)
+  {
+    lock_guard<mutex> lock(mux);
+    readError = current_exception();
+  }
+  blockAvailable.notify_one();
+}
+
+void BitmapPrinter::StopReader()
+{
+  {
+    lock_guard<mutex> lock(mux);
+    stopReader = true;
+  }
+  spaceAvailable.notify_one();
+  if (reader.joinable())
+  {
+    reader.join();
+  }
 }
 
 void BitmapPrinter::Print(FILE * pfileDibStream)
@@ -101,6 +176,7 @@ void BitmapPrinter::Print(FILE * pfileDibStream)
   stream.Attach(pfileDibStream);
   try
   {
+    reader = thread(&BitmapPrinter::ReaderThread, this);
     unique_ptr<DibChunker> pChunker(DibChunker::Create());
     const size_t CHUNK_SIZE = 1024 * 64;
     try
@@ -115,9 +191,11 @@ void BitmapPrinter::Print(FILE * pfileDibStream)
     }
     catch (const exception &)
     {
+      StopReader();
       Finalize();
       throw;
     }
+    StopReader();
     Finalize();
   }
   catch (const exception &)
@@ -41,6 +41,12 @@ public:
 private:
   void PrintChunk(const DibChunk & chunk);
 
+private:
+  void ReaderThread();
+
+private:
+  void StopReader();
+
 private:
   int offsetX;
 
@@ -49,4 +55,36 @@ private:
 
 private:
   FileStream stream;
+
+  // read-ahead: Ghostscript renders the next page while this one is being
+  // spooled
+private:
+  deque<vector<char>> blocks;
+
+private:
+  size_t blockOffset = 0;
+
+private:
+  size_t bufferedBytes = 0;
+
+private:
+  bool endOfStream = false;
+
+private:
+  exception_ptr readError;
+
+private:
+  mutex mux;
+
+private:
+  thread reader;
+
+private:
+  bool stopReader = false;
+
+private:
+  condition_variable blockAvailable;
+
+private:
+  condition_variable spaceAvailable;
 };
@@ -25,7 +25,9 @@
 
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "mcd-version.h"
@@ -39,6 +41,7 @@
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
 #include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
@@ -76,14 +79,6 @@ vector<string> DEFAULT_TRACE_OPTIONS = {
     TraceStream::MakeOption(PROGRAM_NAME, "", TraceLevel::Trace),
 };
 
-void CopyFiles(const vector<string>& fileNames, const PathName& destDir)
-{
-    for (const string& fileName : fileNames)
-    {
-        File::Copy(PathName(fileName), destDir / fileName);
-    }
-}
-
 vector<char> ReadFile(const PathName& fileName)
 {
     size_t fileSize = File::GetSize(fileName);
@@ -123,6 +118,99 @@ bool Contains(const PathName& fileName, const char* text)
     return *p == 0;
 }
 
+string GetBraceArgument(const string& line)
+{
+    size_t start = line.find('{');
+    size_t end = line.rfind('}');
+    if (start == string::npos || end == string::npos || end < start)
+    {
+        return "";
+    }
+    return line.substr(start + 1, end - start - 1);
+}
+
+// digest the lines of an .aux file BibTeX reads; \@input'ed .aux files
+// are read, too
+void CollectBibTeXInputs(const PathName& auxName, MD5Builder& md5Builder, vector<string>& bibFiles, vector<string>& bstFiles, int level)
+{
+    if (level > 10 || !File::Exists(auxName))
+    {
+        return;
+    }
+    StreamReader reader(auxName);
+    string line;
+    while (reader.ReadLine(line))
+    {
+        bool isInput = IsPrefixOf("\\@input", line);
+        bool isBibData = IsPrefixOf("\\bibdata", line);
+        bool isBibStyle = IsPrefixOf("\\bibstyle", line);
+        if (!(isInput || isBibData || isBibStyle || IsPrefixOf("\\citation", line)))
+        {
+            continue;
+        }
+        md5Builder.Update(line.c_str(), line.length());
+        md5Builder.Update("\n", 1);
+        if (isInput)
+        {
+            CollectBibTeXInputs(PathName(GetBraceArgument(line)), md5Builder, bibFiles, bstFiles, level + 1);
+        }
+        else if (isBibData)
+        {
+            for (const string& bib : StringUtil::Split(GetBraceArgument(line), ','))
+            {
+                bibFiles.push_back(bib);
+            }
+        }
+        else if (isBibStyle)
+        {
+            bstFiles.push_back(GetBraceArgument(line));
+        }
+    }
+    reader.Close();
+}
+
+// digest the preamble of a LaTeX document; returns false, if there is no
+// \begin{document}
+bool CollectPreamble(const PathName& fileName, MD5Builder& md5Builder)
+{
+    StreamReader reader(fileName);
+    string line;
+    bool found = false;
+    while (!found && reader.ReadLine(line))
+    {
+        found = line.find("\\begin{document}") != string::npos;
+        md5Builder.Update(line.c_str(), line.length());
+        md5Builder.Update("\n", 1);
+    }
+    reader.Close();
+    return found;
+}
+
+// get the input files recorded in a .fls file, except the main input file;
+// the base format is covered by its time stamp
+vector<PathName> GetRecordedInputFiles(const PathName& flsFile, const PathName& mainInputFile)
+{
+    vector<PathName> inputFiles;
+    StreamReader reader(flsFile);
+    string line;
+    while (reader.ReadLine(line))
+    {
+        if (line.compare(0, 6, "INPUT ") != 0)
+        {
+            continue;
+        }
+        PathName path(line.substr(6));
+        path.MakeFullyQualified();
+        if (path == mainInputFile || path.HasExtension(".fmt") || std::find(inputFiles.begin(), inputFiles.end(), path) != inputFiles.end())
+        {
+            continue;
+        }
+        inputFiles.push_back(path);
+    }
+    reader.Close();
+    return inputFiles;
+}
+
 string FlattenStringVector(const vector<string>& vec, char sep)
 {
     string str = "";
@@ -296,6 +384,9 @@ void Driver::Initialize(McdApp* app, Options* options, const char* fileName)
     inputName = givenFileName;
     inputName.RemoveDirectorySpec();
 
+    // let the TeX engine record the digests of the files it writes
+    Utils::SetEnvironmentString(MIKTEX_ENV_OUTPUT_DIGESTS, "1");
+
     // create a super-temp directory
     tempDirectory = TemporaryDirectory::Create();
 
@@ -313,12 +404,6 @@ void Driver::Initialize(McdApp* app, Options* options, const char* fileName)
     app->MyTrace(fmt::format(T_("extra directory: {}"), Q_(extraDirectory)));
 #endif
 
-    // create aux directory
-    auxDirectory = tempDirectory->GetPathName() / "_aux";
-    Directory::Create(auxDirectory);
-    auxDirectory.ConvertToUnix();
-    app->MyTrace(fmt::format(T_("aux directory: {}"), Q_(auxDirectory)));
-
     // If the user explicitly specified the language, use that. Otherwise, if
     // the first line is \input texinfo, assume it's texinfo.  Otherwise, guess
     // from the file extension.
@@ -540,9 +625,56 @@ void Driver::InsertCommands()
 
 /* _________________________________________________________________________
 
-   Driver::RunBibTeX
+   Driver::InputsChanged
+
+   Remember the input digest of a tool run.  Running a tool again on the same
+   inputs would produce the same output: the run can be skipped.
+   _________________________________________________________________________ */
+
+bool Driver::InputsChanged(const string& key, const MD5& inputDigest)
+{
+    auto it = toolInputDigests.find(key);
+    if (it != toolInputDigests.end() && it->second == inputDigest)
+    {
+        app->Verbose(fmt::format(T_("inputs of {} have not changed; skipping..."), key));
+        return false;
+    }
+    toolInputDigests[key] = inputDigest;
+    return true;
+}
+
+MD5 Driver::GetBibTeXInputDigest(const PathName& auxName)
+{
+    MD5Builder md5Builder;
+    vector<string> bibFiles;
+    vector<string> bstFiles;
+    CollectBibTeXInputs(auxName, md5Builder, bibFiles, bstFiles, 0);
+    for (const string& bib : bibFiles)
+    {
+        PathName path;
+        if (session->FindFile(bib, FileType::BIB, path))
+        {
+            MD5 md5 = MD5::FromFile(path);
+            md5Builder.Update(md5.data(), md5.size());
+        }
+    }
+    for (const string& bst : bstFiles)
+    {
+        PathName path;
+        if (session->FindFile(bst, FileType::BST, path))
+        {
+            MD5 md5 = MD5::FromFile(path);
+            md5Builder.Update(md5.data(), md5.size());
+        }
+    }
+    return md5Builder.Final();
+}
+
+/* _________________________________________________________________________
+
+   Driver::AddBibTeXRuns
 
-   Run bibtex on current file:
+   Prepare to run bibtex on current file:
    - If its input (AUX) exists.
    - If AUX contains both '\bibdata' and '\bibstyle'.
    - If some citations are missing (LOG contains 'Citation') or the LOG
@@ -556,9 +688,12 @@ void Driver::InsertCommands()
    that have changed.  Because there can be several AUX (if there are
    \include's), but a single LOG, looking for missing citations in LOG is
    easier, though we take the risk to match false messages.
+
+   BibTeX isn't run again on the same inputs (citations, databases and style):
+   a citation which is still undefined will not be defined by another run.
    _________________________________________________________________________ */
 
-void Driver::RunBibTeX()
+void Driver::AddBibTeXRuns(vector<ToolRun>& toolRuns)
 {
     PathName pathExe;
 
@@ -572,8 +707,6 @@ void Driver::RunBibTeX()
     PathName auxName(jobName);
     auxName.AppendExtension(".aux");
 
-    int exitCode;
-
 #if defined(SF464378__CHAPTERBIB)
     if ((File::Exists(auxName) && File::Exists(logName) && Contains(logName, &options->regex_chapterbib) && (Contains(logName, &options->regex_citation_undefined) || Contains(logName, &options->regex_no_file_bbl))))
     {
@@ -598,6 +731,11 @@ void Driver::RunBibTeX()
                 continue;
             }
 
+            if (!InputsChanged(subAuxName.ToString(), GetBibTeXInputDigest(subAuxName)))
+            {
+                continue;
+            }
+
             PathName subDir;
 
             if (strchr(subAuxNameNoExt.GetData(), PathNameUtil::UnixDirectoryDelimiter) != 0)
@@ -613,21 +751,12 @@ void Driver::RunBibTeX()
                 subAuxNameNoExt.RemoveDirectorySpec();
             }
 
-            vector<string> args{ options->bibtexProgram };
-
-            args.push_back(subAuxNameNoExt.ToString());
-
-            app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(args).ToString()));
-
-            exitCode = 0;
-
-            ProcessOutputTrash trash;
-
-            Process::Run(pathExe, args, (options->quiet ? &trash : nullptr), &exitCode, subDir.Empty() ? nullptr : subDir.GetData());
-            if (exitCode != 0)
-            {
-                MIKTEX_FATAL_ERROR(T_("BibTeX failed for some reason."));
-            }
+            ToolRun toolRun;
+            toolRun.startInfo.FileName = pathExe.ToString();
+            toolRun.startInfo.Arguments = { options->bibtexProgram, subAuxNameNoExt.ToString() };
+            toolRun.startInfo.WorkingDirectory = subDir.ToString();
+            toolRun.failureMessage = T_("BibTeX failed for some reason.");
+            toolRuns.push_back(toolRun);
         }
     }
 #endif // SF464378__CHAPTERBIB
@@ -637,33 +766,34 @@ void Driver::RunBibTeX()
         return;
     }
 
-    vector<string> args{ options->bibtexProgram };
-
-    args.push_back(jobName.ToString());
-
-    app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(args).ToString()));
-
-    ProcessOutputTrash trash;
-
-    Process::Run(pathExe, args, (options->quiet ? &trash : nullptr), &exitCode, nullptr);
-
-    if (exitCode != 0)
+    if (!InputsChanged(auxName.ToString(), GetBibTeXInputDigest(auxName)))
     {
-        MIKTEX_FATAL_ERROR(T_("BibTeX failed for some reason."));
+        return;
     }
+
+    ToolRun toolRun;
+    toolRun.startInfo.FileName = pathExe.ToString();
+    toolRun.startInfo.Arguments = { options->bibtexProgram, jobName.ToString() };
+    toolRun.failureMessage = T_("BibTeX failed for some reason.");
+    toolRuns.push_back(toolRun);
 }
 
 /* _________________________________________________________________________
 
-   Driver::RunIndexGenerator
+   Driver::AddIndexGeneratorRuns
+
+   Prepare to run texindex (or makeindex) on current index files.  If they
+   already exist, and after running TeX a first time the index files don't
+   change, then there's no reason to run TeX again.  But we won't know that if
+   the index files are out of date or nonexistent.
 
-   Run texindex (or makeindex) on current index files.  If they already exist,
-   and after running TeX a first time the index files don't change, then there's
-   no reason to run TeX again.  But we won't know that if the index files are
-   out of date or nonexistent.
+   texindex sorts each index file on its own: every index gets a run of its
+   own.  makeindex merges its input files into one index.
+
+   The index generator isn't run again on unchanged index files.
    _________________________________________________________________________ */
 
-void Driver::RunIndexGenerator(const vector<string>& idxFiles)
+void Driver::AddIndexGeneratorRuns(const vector<string>& idxFiles, vector<ToolRun>& toolRuns)
 {
 #if defined(WITH_TEXINFO)
     const string indexGenerator = macroLanguage == MacroLanguage::Texinfo
@@ -673,6 +803,21 @@ void Driver::RunIndexGenerator(const vector<string>& idxFiles)
     const string indexGenerator = options->makeindexProgram;
 #endif
 
+    vector<vector<string>> runInputs;
+#if defined(WITH_TEXINFO)
+    if (macroLanguage == MacroLanguage::Texinfo)
+    {
+        for (const string& idx : idxFiles)
+        {
+            runInputs.push_back({ idx });
+        }
+    }
+    else
+#endif
+    {
+        runInputs.push_back(idxFiles);
+    }
+
     PathName pathExe;
 
     if (!session->FindFile(indexGenerator, FileType::EXE, pathExe))
@@ -680,22 +825,93 @@ void Driver::RunIndexGenerator(const vector<string>& idxFiles)
         FatalUtilityError(indexGenerator);
     }
 
-    vector<string> args{ indexGenerator };
+    for (const vector<string>& inputs : runInputs)
+    {
+        MD5Builder md5Builder;
+        for (const string& opt : options->makeindexOptions)
+        {
+            md5Builder.Update(opt.c_str(), opt.length() + 1);
+            PathName style;
+            if (PathName(opt).HasExtension(".ist") && session->FindFile(opt, FileType::IST, style))
+            {
+                MD5 md5 = MD5::FromFile(style);
+                md5Builder.Update(md5.data(), md5.size());
+            }
+        }
+        for (const string& idx : inputs)
+        {
+            md5Builder.Update(idx.c_str(), idx.length() + 1);
+            MD5 md5 = MD5::FromFile(PathName(idx));
+            md5Builder.Update(md5.data(), md5.size());
+        }
+        if (!InputsChanged(fmt::format("{} {}", indexGenerator, FlattenStringVector(inputs, ' ')), md5Builder.Final()))
+        {
+            continue;
+        }
+
+        ToolRun toolRun;
+        toolRun.startInfo.FileName = pathExe.ToString();
+        toolRun.startInfo.Arguments = { indexGenerator };
+        toolRun.startInfo.Arguments.insert(toolRun.startInfo.Arguments.end(), options->makeindexOptions.begin(), options->makeindexOptions.end());
+        toolRun.startInfo.Arguments.insert(toolRun.startInfo.Arguments.end(), inputs.begin(), inputs.end());
+        toolRun.failureMessage = T_("MakeIndex failed for some reason.");
+        toolRuns.push_back(toolRun);
+    }
+}
+
+/* _________________________________________________________________________
 
-    args.insert(args.end(), options->makeindexOptions.begin(), options->makeindexOptions.end());
-    args.insert(args.end(), idxFiles.begin(), idxFiles.end());
+   Driver::RunTools
 
-    ProcessOutputTrash trash;
+   Run BibTeX and the index generators.  They read the files written by TeX,
+   but not the files written by each other: with --jobs=N, up to N of them run
+   at the same time.  The output of concurrent runs is collected and printed
+   in order.
+   _________________________________________________________________________ */
 
-    int exitCode = 0;
+void Driver::RunTools(const vector<ToolRun>& toolRuns)
+{
+    for (const ToolRun& toolRun : toolRuns)
+    {
+        app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(toolRun.startInfo.Arguments).ToString()));
+    }
 
-    app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(args).ToString()));
+    if (options->jobs <= 1 || toolRuns.size() <= 1)
+    {
+        for (const ToolRun& toolRun : toolRuns)
+        {
+            app->CheckCancel();
+            int exitCode = 0;
+            ProcessOutputTrash trash;
+            const ProcessStartInfo& startInfo = toolRun.startInfo;
+            Process::Run(PathName(startInfo.FileName), startInfo.Arguments, (options->quiet ? &trash : nullptr), &exitCode, startInfo.WorkingDirectory.empty() ? nullptr : startInfo.WorkingDirectory.c_str());
+            if (exitCode != 0)
+            {
+                MIKTEX_FATAL_ERROR(toolRun.failureMessage);
+            }
+        }
+        return;
+    }
+
+    vector<ProcessStartInfo> startInfos;
+    for (const ToolRun& toolRun : toolRuns)
+    {
+        startInfos.push_back(toolRun.startInfo);
+    }
 
-    Process::Run(pathExe, args, (options->quiet ? &trash : nullptr), &exitCode, nullptr);
+    vector<ProcessRunResult> results = Process::RunAll(startInfos, options->jobs);
 
-    if (exitCode != 0)
+    for (size_t idx = 0; idx < results.size(); ++idx)
     {
-        MIKTEX_FATAL_ERROR(T_("MakeIndex failed for some reason."));
+        if (!options->quiet)
+        {
+            cout << results[idx].output;
+            cout.flush();
+        }
+        if (results[idx].exitStatus != ProcessExitStatus::Exited || results[idx].exitCode != 0)
+        {
+            MIKTEX_FATAL_ERROR(toolRuns[idx].failureMessage);
+        }
     }
 }
 
@@ -782,7 +998,190 @@ PathName Driver::GetTeXEnginePath(string& exeName)
     return pathExe;
 }
 
-void Driver::RunTeX()
+/* _________________________________________________________________________
+
+   Driver::PrefetchPackages
+
+   Install the packages which are required by the document in one go,
+   instead of one at a time from inside the TeX engine.
+   _________________________________________________________________________ */
+
+void Driver::PrefetchPackages()
+{
+    PathName pathExe;
+    if (!session->FindFile("miktex", FileType::EXE, pathExe))
+    {
+        FatalUtilityError("miktex");
+    }
+    app->Verbose(T_("installing the packages required by the document..."));
+    ProcessOutputTrash trash;
+    int exitCode;
+    Process::Run(pathExe, vector<string>{"miktex", "packages", "require", "--scan", pathInputFile.ToString()}, (options->quiet ? &trash : nullptr), &exitCode, nullptr);
+    if (exitCode != 0)
+    {
+        // the TeX engine will ask for the missing packages
+        app->Verbose(T_("the required packages could not be installed"));
+    }
+}
+
+/* _________________________________________________________________________
+
+   Driver::PreparePreambleFormat
+
+   Dump a job-specific format holding the preamble of the document (with the
+   help of mylatexformat).  The format and the digest of the preamble are kept
+   in the start directory, along with the digests of all the files which
+   have been read while dumping (as recorded in the .fls file).  A later
+   texify run reuses the format as long as the preamble, the files read by
+   the preamble, the engine and the base format have not changed.
+   _________________________________________________________________________ */
+
+void Driver::PreparePreambleFormat()
+{
+    string exeName;
+    PathName pathExe = GetTeXEnginePath(exeName);
+
+    MD5Builder md5Builder;
+    if (!CollectPreamble(pathInputFile, md5Builder))
+    {
+        app->Verbose(T_("no \\begin{document} found; not dumping the preamble"));
+        return;
+    }
+    md5Builder.Update(exeName.c_str(), exeName.length());
+    for (const string& opt : options->texOptions)
+    {
+        md5Builder.Update(opt.c_str(), opt.length());
+    }
+    PathName baseFormat;
+    if (session->FindFile(exeName + ".fmt", FileType::FMT, baseFormat))
+    {
+        string stamp = std::to_string(File::GetLastWriteTime(baseFormat));
+        md5Builder.Update(stamp.c_str(), stamp.length());
+    }
+    MD5 preambleDigest = md5Builder.Final();
+
+    string dumpName = jobName.ToString() + "-preamble";
+    PathName fmtPath(options->startDirectory / dumpName);
+    fmtPath.AppendExtension(".fmt");
+    PathName digestPath(options->startDirectory / dumpName);
+    digestPath.AppendExtension(".md5");
+
+    if (File::Exists(fmtPath) && File::Exists(digestPath))
+    {
+        StreamReader reader(digestPath);
+        string line;
+        bool upToDate = reader.ReadLine(line) && line == preambleDigest.ToString();
+        vector<PathName> inputFiles;
+        vector<MD5> inputDigests;
+        while (upToDate && reader.ReadLine(line))
+        {
+            if (line.length() < 34 || line[32] != ' ')
+            {
+                upToDate = false;
+                break;
+            }
+            PathName path(line.substr(33));
+            if (!File::Exists(path))
+            {
+                app->Verbose(fmt::format(T_("{} has been removed"), Q_(path)));
+                upToDate = false;
+                break;
+            }
+            inputDigests.push_back(MD5::Parse(line.substr(0, 32)));
+            inputFiles.push_back(path);
+        }
+        reader.Close();
+        if (upToDate)
+        {
+            vector<MD5> digests = MD5::FromFiles(inputFiles, std::max<size_t>(1, thread::hardware_concurrency()));
+            for (size_t idx = 0; upToDate && idx < inputFiles.size(); ++idx)
+            {
+                if (digests[idx] != inputDigests[idx])
+                {
+                    app->Verbose(fmt::format(T_("{} has been modified"), Q_(inputFiles[idx])));
+                    upToDate = false;
+                }
+            }
+        }
+        if (upToDate)
+        {
+            app->Verbose(fmt::format(T_("preamble has not changed; using {}"), Q_(fmtPath)));
+            preambleFormat = fmtPath;
+            return;
+        }
+    }
+
+    vector<string> args{
+        pathExe.GetFileNameWithoutExtension().ToString(),
+        "--initialize",
+        "--job-name="s + dumpName,
+        "--interaction=batchmode",
+        "--recorder",
+        "&"s + exeName,
+        "mylatexformat.ltx",
+        pathInputFile.ToString()
+    };
+
+    app->Verbose(fmt::format(T_("dumping the preamble: {}..."), CommandLineBuilder(args).ToString()));
+
+    int exitCode = 0;
+    Process::Run(pathExe, args, nullptr, &exitCode, nullptr);
+    PathName dumpFile(dumpName);
+    dumpFile.AppendExtension(".fmt");
+    if (exitCode != 0 || !File::Exists(dumpFile))
+    {
+        app->Warning(T_("The preamble could not be dumped (see log file). Running without a preamble format."));
+        return;
+    }
+    if (options->clean)
+    {
+        File::Copy(dumpFile, fmtPath);
+    }
+    preambleFormat = fmtPath;
+    PathName flsFile(dumpName);
+    flsFile.AppendExtension(".fls");
+    if (!File::Exists(flsFile))
+    {
+        // without the list of input files, the format cannot be reused
+        app->Verbose(fmt::format(T_("{} not found; the preamble format will not be reused"), Q_(flsFile)));
+        if (File::Exists(digestPath))
+        {
+            File::Delete(digestPath);
+        }
+        return;
+    }
+    PathName fqInputFile(pathInputFile);
+    fqInputFile.MakeFullyQualified();
+    vector<PathName> inputFiles = GetRecordedInputFiles(flsFile, fqInputFile);
+    vector<MD5> digests = MD5::FromFiles(inputFiles, std::max<size_t>(1, thread::hardware_concurrency()));
+    StreamWriter writer(digestPath);
+    writer.WriteLine(preambleDigest.ToString());
+    for (size_t idx = 0; idx < inputFiles.size(); ++idx)
+    {
+        writer.WriteLine(fmt::format("{} {}", digests[idx].ToString(), inputFiles[idx].ToString()));
+    }
+    writer.Close();
+}
+
+/* _________________________________________________________________________
+
+   Driver::UseDraftPasses
+
+   pdfTeX in draft mode does everything but write the PDF file: images
+   are neither read nor decoded, and nothing gets compressed.  The
+   intermediate passes only have to bring the xref files up to date, so
+   they can run in draft mode.
+   _________________________________________________________________________ */
+
+bool Driver::UseDraftPasses()
+{
+    return options->draftPasses
+        && options->outputType == OutputType::PDF
+        && options->engine != Engine::XeTeX
+        && options->engine != Engine::LuaTeX;
+}
+
+void Driver::RunTeX(bool draft)
 {
     string exeName;
     PathName pathExe = GetTeXEnginePath(exeName);
@@ -808,6 +1207,11 @@ void Driver::RunTeX()
     }
 #endif
 
+    if (!preambleFormat.Empty())
+    {
+        args.push_back("--undump="s + preambleFormat.ToString());
+    }
+
     if (options->synctex != SyncTeXOption::Disabled)
     {
         args.push_back("--synctex="s + (options->synctex == SyncTeXOption::Compressed ? "1" : "-1"));
@@ -821,6 +1225,10 @@ void Driver::RunTeX()
     {
         args.push_back("--interaction="s + "scrollmode");
     }
+    if (draft)
+    {
+        args.push_back("--draftmode");
+    }
     args.insert(args.end(), options->texOptions.begin(), options->texOptions.end());
 #if 0
     if (options->traceStreams.length() > 0)
@@ -832,6 +1240,15 @@ void Driver::RunTeX()
 
     app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(args).ToString()));
 
+    // digests of a previous run must not be taken for those of this run
+    outputDigests.clear();
+    PathName digestsName(jobName);
+    digestsName.AppendExtension(".fdg");
+    if (File::Exists(digestsName))
+    {
+        File::Delete(digestsName);
+    }
+
     int exitCode = 0;
     Process::Run(pathExe, args, nullptr, &exitCode, nullptr);
     if (exitCode != 0)
@@ -851,6 +1268,8 @@ void Driver::RunTeX()
         }
         MIKTEX_FATAL_ERROR(T_("TeX engine failed for some reason (see log file)."));
     }
+
+    ReadOutputDigests();
 }
 
 /* _________________________________________________________________________
@@ -890,12 +1309,12 @@ bool Driver::Ready()
     // difference.
     for (const string& aux : auxFiles)
     {
-        PathName auxFile(auxDirectory / aux);
         app->Verbose(fmt::format(T_("comparing xref file {}..."), Q_(aux)));
         // We only need to keep comparing until we find one that differs,
         // because we'll have to run texindex & tex again no matter how many
         // more there might be.
-        if (!File::Equals(PathName(aux), auxFile))
+        auto it = previousAuxDigests.find(aux);
+        if (it == previousAuxDigests.end() || it->second != GetAuxDigest(aux))
         {
             app->Verbose(fmt::format(T_("xref file {} differed..."), Q_(aux)));
             return false;
@@ -905,6 +1324,48 @@ bool Driver::Ready()
     return true;
 }
 
+/* _________________________________________________________________________
+
+   Driver::ReadOutputDigests
+
+   Read the digests which the TeX engine has recorded for the files it has
+   written (the .fdg file).  Engines which do not record digests leave no
+   such file; then the xref files are digested here.
+   _________________________________________________________________________ */
+
+void Driver::ReadOutputDigests()
+{
+    PathName digestsName(jobName);
+    digestsName.AppendExtension(".fdg");
+    if (!File::Exists(digestsName))
+    {
+        return;
+    }
+    StreamReader reader(digestsName);
+    string line;
+    while (reader.ReadLine(line))
+    {
+        size_t pos = line.find(' ');
+        if (pos == string::npos)
+        {
+            continue;
+        }
+        outputDigests[line.substr(pos + 1)] = MD5::Parse(line.substr(0, pos));
+    }
+    reader.Close();
+    app->MyTrace(fmt::format(T_("{} output digests recorded by the TeX engine"), outputDigests.size()));
+}
+
+MD5 Driver::GetAuxDigest(const string& aux)
+{
+    auto it = outputDigests.find(aux);
+    if (it != outputDigests.end())
+    {
+        return it->second;
+    }
+    return MD5::FromFile(PathName(aux));
+}
+
 void Driver::InstallOutputFile()
 {
     const char* ext = options->outputType == OutputType::PDF ? ".pdf" : ".dvi";
@@ -1061,30 +1522,59 @@ void Driver::Run()
         Directory::SetCurrent(workingDirectory);
     }
 
+    if (options->prefetchPackages && macroLanguage == MacroLanguage::LaTeX)
+    {
+        PrefetchPackages();
+    }
+
+    if (options->dumpPreamble && macroLanguage == MacroLanguage::LaTeX)
+    {
+        PreparePreambleFormat();
+    }
+
+    bool draft = UseDraftPasses();
+    bool outputWritten = false;
+
     for (int i = 0; i < options->maxIterations; ++i)
     {
         app->CheckCancel();
         vector<string> idxFiles;
         GetAuxFiles(previousAuxFiles, &idxFiles);
+        previousAuxDigests.clear();
         if (!previousAuxFiles.empty())
         {
-            app->Verbose(fmt::format(T_("backing up xref files: {}"), FlattenStringVector(previousAuxFiles, ' ')));
-            CopyFiles(previousAuxFiles, auxDirectory);
+            app->Verbose(fmt::format(T_("remembering xref files: {}"), FlattenStringVector(previousAuxFiles, ' ')));
+            for (const string& aux : previousAuxFiles)
+            {
+                previousAuxDigests[aux] = GetAuxDigest(aux);
+            }
         }
-        RunBibTeX();
+        vector<ToolRun> toolRuns;
+        AddBibTeXRuns(toolRuns);
         if (idxFiles.size() > 0)
         {
-            app->CheckCancel();
-            RunIndexGenerator(idxFiles);
+            AddIndexGeneratorRuns(idxFiles, toolRuns);
         }
         app->CheckCancel();
-        RunTeX();
+        RunTools(toolRuns);
+        app->CheckCancel();
+        RunTeX(draft);
+        outputWritten = !draft;
         if (Ready())
         {
             break;
         }
     }
 
+    // The xref files are up to date, but the last pass did not write the
+    // output file.
+    if (!outputWritten)
+    {
+        app->CheckCancel();
+        app->Verbose(T_("running the final pass..."));
+        RunTeX();
+    }
+
     // If we were in clean mode, compilation was in a tmp directory. Copy the
     // DVI (or PDF) file into the directory where the compilation has been done.
     // (The temp dir is about to get removed anyway.)  We also return to the
@@ -1111,14 +1601,18 @@ enum CommandLineOptions
     OPT_BATCH,
     OPT_CLEAN,
     OPT_DEBUG,
+    OPT_DRAFT_PASSES,
+    OPT_DUMP_PREAMBLE,
     OPT_ENGINE,
     OPT_EXPAND,
     OPT_INCLUDE,
+    OPT_JOBS,
     OPT_JOB_NAME,
     OPT_LANGUAGE,
     OPT_MAX_ITER,
     OPT_MKIDX_OPTION,
     OPT_PDF,
+    OPT_PREFETCH_PACKAGES,
     OPT_QUIET,
     OPT_RUN_VIEWER,
 #if defined(SUPPORT_OPT_SRC_SPECIALS)
@@ -1298,6 +1792,36 @@ const struct poptOption optionTable[] = {
 
     // --- now the MiKTeX extensions
 
+    {
+        "draft-passes",
+        0,
+        POPT_ARG_NONE,
+        nullptr,
+        OPT_DRAFT_PASSES,
+        T_("Run the intermediate pdfTeX passes in draft mode and write the PDF file only on the final pass."),
+        nullptr,
+    },
+
+    {
+        "dump-preamble",
+        0,
+        POPT_ARG_NONE,
+        nullptr,
+        OPT_DUMP_PREAMBLE,
+        T_("Dump the LaTeX preamble into a job-specific format and reuse it while the preamble does not change."),
+        nullptr,
+    },
+
+    {
+        "jobs",
+        0,
+        POPT_ARG_STRING,
+        nullptr,
+        OPT_JOBS,
+        T_("Run up to N BibTeX/index generator processes at the same time."),
+        "N",
+    },
+
     {
         "max-iterations",
         0,
@@ -1340,6 +1864,16 @@ const struct poptOption optionTable[] = {
     },
 #endif
 
+    {
+        "prefetch-packages",
+        0,
+        POPT_ARG_NONE,
+        nullptr,
+        OPT_PREFETCH_PACKAGES,
+        T_("Install the packages required by the document before the first run."),
+        nullptr,
+    },
+
     {
         "synctex",
         0,
@@ -1538,6 +2072,18 @@ void McdApp::Run(int argc, const char** argv)
         case OPT_RUN_VIEWER:
             options.runViewer = true;
             break;
+        case OPT_DRAFT_PASSES:
+            options.draftPasses = true;
+            break;
+        case OPT_DUMP_PREAMBLE:
+            options.dumpPreamble = true;
+            break;
+        case OPT_PREFETCH_PACKAGES:
+            options.prefetchPackages = true;
+            break;
+        case OPT_JOBS:
+            options.jobs = std::stoi(optArg);
+            break;
         case OPT_MAX_ITER:
             options.maxIterations = std::stoi(optArg);
             break;
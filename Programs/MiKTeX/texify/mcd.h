@@ -11,6 +11,7 @@
  * or any later version.
  */
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,6 +19,7 @@
 #include <cstring>
 
 #include <miktex/App/Application>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Quoter>
 #include <miktex/Core/Process>
 #include <miktex/Util/PathName>
@@ -154,6 +156,10 @@ public:
     bool runViewer = false;
     SyncTeXOption synctex = SyncTeXOption::Disabled;
     int maxIterations = 5;
+    int jobs = 1;
+    bool dumpPreamble = false;
+    bool draftPasses = false;
+    bool prefetchPackages = false;
     std::vector<std::string> includeDirectories;
     std::string jobName;
     MacroLanguage macroLanguage = MacroLanguage::None;
@@ -292,6 +298,12 @@ protected:
 
 private:
 
+    struct ToolRun
+    {
+        MiKTeX::Core::ProcessStartInfo startInfo;
+        std::string failureMessage;
+    };
+
     void FatalUtilityError(const std::string& name)
     {
         app->FatalError(fmt::format("A required utility could not be found. Utility name: {}.", name));
@@ -302,12 +314,20 @@ private:
     void ExpandMacros();
     void InsertCommands();
     bool RunMakeinfo(const MiKTeX::Util::PathName& pathFrom, const MiKTeX::Util::PathName& pathTo);
-    void RunBibTeX();
+    bool InputsChanged(const std::string& key, const MiKTeX::Core::MD5& inputDigest);
+    MiKTeX::Core::MD5 GetBibTeXInputDigest(const MiKTeX::Util::PathName& auxName);
+    void AddBibTeXRuns(std::vector<ToolRun>& toolRuns);
     MiKTeX::Util::PathName GetTeXEnginePath(std::string& exeName);
-    void RunTeX();
-    void RunIndexGenerator(const std::vector<std::string>& idxFiles);
+    void PreparePreambleFormat();
+    void PrefetchPackages();
+    bool UseDraftPasses();
+    void RunTeX(bool draft = false);
+    void AddIndexGeneratorRuns(const std::vector<std::string>& idxFiles, std::vector<ToolRun>& toolRuns);
+    void RunTools(const std::vector<ToolRun>& toolRuns);
     void RunViewer();
     bool Ready();
+    void ReadOutputDigests();
+    MiKTeX::Core::MD5 GetAuxDigest(const std::string& aux);
     void InstallOutputFile();
     void GetAuxFiles(std::vector<std::string>& auxFiles, std::vector<std::string>* idxFiles = nullptr);
     void GetAuxFiles(const MiKTeX::Util::PathName& baseName, const char* extension, std::vector<std::string>& auxFiles);
@@ -321,9 +341,15 @@ private:
     MiKTeX::Util::PathName inputName;
     MiKTeX::Util::PathName jobName;
     MiKTeX::Util::PathName workingDirectory;
-    MiKTeX::Util::PathName auxDirectory;
     MiKTeX::Util::PathName pathInputFile;
     std::vector<std::string> previousAuxFiles;
+    std::map<std::string, MiKTeX::Core::MD5> previousAuxDigests;
+    // file => digest recorded by the TeX engine when it wrote the file
+    std::map<std::string, MiKTeX::Core::MD5> outputDigests;
+    // tool (input) => digest of the inputs of the last run
+    std::map<std::string, MiKTeX::Core::MD5> toolInputDigests;
+    // job-specific format holding the dumped preamble
+    MiKTeX::Util::PathName preambleFormat;
     McdApp* app = nullptr;
     Options* options = nullptr;
 #if defined(WITH_TEXINFO)
@@ -0,0 +1,330 @@
+/**
+ * @file pmxbatch.cpp
+ * @author Christian Schenk
+ * @brief Converting many M-Tx/PMX files at once
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "pmx-version.h"
+
+#include <miktex/App/Application>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+#include <miktex/Core/Quoter>
+#include <miktex/Core/TemporaryDirectory>
+#include <miktex/Core/Utils>
+#include <miktex/Util/PathName>
+#include <miktex/Util/StringUtil>
+#include <miktex/Wrappers/PoptWrapper>
+
+#if defined(MIKTEX_WINDOWS)
+#include <miktex/Core/win/ConsoleCodePageSwitcher>
+#endif
+
+using namespace MiKTeX::App;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+using namespace std;
+
+#define T_(x) MIKTEXTEXT(x)
+
+#define Q_(x) MiKTeX::Core::Quoter<char>(x).GetData()
+
+const char* const TheNameOfTheGame = T_("MiKTeX PMX Batch Utility");
+
+class PmxBatch :
+  public Application
+{
+public:
+  int Run(int argc, const char** argv);
+
+private:
+  struct Piece
+  {
+    PathName inputFile;
+    bool isMtx = false;
+    bool failed = false;
+    std::unique_ptr<TemporaryDirectory> workingDirectory;
+  };
+
+private:
+  void RunStage(const char* exeName, vector<Piece*>& pieces, const vector<ProcessStartInfo>& startInfos);
+
+private:
+  void MakePmxFiles(vector<Piece>& pieces);
+
+private:
+  void MakeTeXFiles(vector<Piece>& pieces);
+
+private:
+  MIKTEXNORETURN void Error(const string& msg);
+
+private:
+  unsigned jobs = max(thread::hardware_concurrency(), 1u);
+
+private:
+  bool verbose = false;
+
+private:
+  static struct poptOption aoption[];
+};
+
+enum Option
+{
+  OPT_AAA = 1000,
+  OPT_JOBS,
+  OPT_VERBOSE,
+  OPT_VERSION
+};
+
+struct poptOption PmxBatch::aoption[] = {
+
+  {
+    "jobs", 'j',
+    POPT_ARG_STRING, nullptr,
+    OPT_JOBS,
+    T_("The number of files to be converted simultaneously."),
+    T_("N")
+  },
+
+  {
+    "verbose", 0,
+    POPT_ARG_NONE, nullptr,
+    OPT_VERBOSE,
+    T_("Turn on verbose output mode."),
+    nullptr
+  },
+
+  {
+    "version", 0,
+    POPT_ARG_NONE, nullptr,
+    OPT_VERSION,
+    T_("Show version information and exit."),
+    nullptr
+  },
+
+  POPT_AUTOHELP
+  POPT_TABLEEND
+};
+
+MIKTEXNORETURN void PmxBatch::Error(const string& msg)
+{
+  cerr << "pmxbatch: " << msg << endl;
+  throw 1;
+}
+
+void PmxBatch::RunStage(const char* exeName, vector<Piece*>& pieces, const vector<ProcessStartInfo>& startInfos)
+{
+  if (startInfos.empty())
+  {
+    return;
+  }
+  vector<ProcessRunResult> results = Process::RunAll(startInfos, jobs);
+  for (size_t idx = 0; idx < results.size(); ++idx)
+  {
+    if (verbose || results[idx].exitStatus != ProcessExitStatus::Exited || results[idx].exitCode != 0)
+    {
+      cout << results[idx].output;
+    }
+    if (results[idx].exitStatus != ProcessExitStatus::Exited || results[idx].exitCode != 0)
+    {
+      cerr << fmt::format(T_("pmxbatch: {0} failed on {1}"), PathName(exeName).GetFileNameWithoutExtension().ToString(), Q_(pieces[idx]->inputFile)) << endl;
+      pieces[idx]->failed = true;
+    }
+  }
+}
+
+// prepmx only writes NAME.pmx: the files can be converted in their own
+// directories, which is where M-Tx looks for included files
+void PmxBatch::MakePmxFiles(vector<Piece>& pieces)
+{
+  vector<Piece*> stagePieces;
+  vector<ProcessStartInfo> startInfos;
+  for (Piece& piece : pieces)
+  {
+    if (!piece.isMtx)
+    {
+      continue;
+    }
+    ProcessStartInfo startInfo(PathName(MIKTEX_PREPMX_EXE));
+    startInfo.Arguments = { "prepmx", piece.inputFile.GetFileNameWithoutExtension().ToString() };
+    startInfo.WorkingDirectory = piece.inputFile.GetDirectoryName().ToString();
+    startInfos.push_back(startInfo);
+    stagePieces.push_back(&piece);
+  }
+  RunStage(MIKTEX_PREPMX_EXE, stagePieces, startInfos);
+}
+
+// pmxab writes pmxaerr.dat and scratch files into the current directory:
+// each file gets a private working directory
+void PmxBatch::MakeTeXFiles(vector<Piece>& pieces)
+{
+  vector<Piece*> stagePieces;
+  vector<ProcessStartInfo> startInfos;
+  for (Piece& piece : pieces)
+  {
+    if (piece.failed)
+    {
+      continue;
+    }
+    PathName pmxFile = piece.inputFile;
+    pmxFile.SetExtension(".pmx");
+    piece.workingDirectory = TemporaryDirectory::Create();
+    File::Copy(pmxFile, piece.workingDirectory->GetPathName() / pmxFile.GetFileName().ToString());
+    ProcessStartInfo startInfo(PathName(MIKTEX_PMXAB_EXE));
+    startInfo.Arguments = { "pmxab", pmxFile.GetFileNameWithoutExtension().ToString() };
+    startInfo.WorkingDirectory = piece.workingDirectory->GetPathName().ToString();
+    startInfos.push_back(startInfo);
+    stagePieces.push_back(&piece);
+  }
+  RunStage(MIKTEX_PMXAB_EXE, stagePieces, startInfos);
+  for (Piece* piece : stagePieces)
+  {
+    if (!piece->failed)
+    {
+      PathName texFile = piece->inputFile;
+      texFile.SetExtension(".tex");
+      File::Copy(piece->workingDirectory->GetPathName() / texFile.GetFileName().ToString(), texFile);
+    }
+    piece->workingDirectory = nullptr;
+  }
+}
+
+int PmxBatch::Run(int argc, const char** argv)
+{
+  PoptWrapper popt(argc, argv, aoption);
+  popt.SetOtherOptionHelp(T_("FILE..."));
+
+  int option;
+
+  Session::InitInfo initInfo(argv[0]);
+
+  while ((option = popt.GetNextOpt()) >= 0)
+  {
+    string optArg = popt.GetOptArg();
+    switch (option)
+    {
+    case OPT_JOBS:
+      jobs = max(std::stoi(optArg), 1);
+      break;
+    case OPT_VERBOSE:
+      verbose = true;
+      break;
+    case OPT_VERSION:
+      cout
+        << Utils::MakeProgramVersionString(TheNameOfTheGame, VersionNumber(MIKTEX_COMPONENT_VERSION_STR)) << endl
+        << endl
+        << "Copyright (C) 2024 Christian Schenk" << endl
+        << "This is free software; see the source for copying conditions.  There is NO" << endl
+        << "warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE." << endl;
+      return 0;
+    }
+  }
+
+  if (option != -1)
+  {
+    Error(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
+  }
+
+  Init(initInfo);
+
+  vector<string> leftovers = popt.GetLeftovers();
+
+  if (leftovers.empty())
+  {
+    Error(fmt::format("Nothing to do?\nTry '{0} --help' for more information.", argv[0]));
+  }
+
+  vector<Piece> pieces(leftovers.size());
+  for (size_t idx = 0; idx < leftovers.size(); ++idx)
+  {
+    PathName inputFile(leftovers[idx]);
+    inputFile.MakeFullyQualified();
+    if (!inputFile.HasExtension(".mtx") && !inputFile.HasExtension(".pmx"))
+    {
+      Error(fmt::format(T_("{0}: not an M-Tx or PMX file"), Q_(leftovers[idx])));
+    }
+    if (!File::Exists(inputFile))
+    {
+      Error(fmt::format(T_("{0}: file not found"), Q_(leftovers[idx])));
+    }
+    pieces[idx].inputFile = inputFile;
+    pieces[idx].isMtx = inputFile.HasExtension(".mtx");
+  }
+
+  MakePmxFiles(pieces);
+  MakeTeXFiles(pieces);
+
+  Finalize();
+
+  return any_of(pieces.begin(), pieces.end(), [](const Piece& piece) { return piece.failed; }) ? 1 : 0;
+}
+
+#if defined(_UNICODE)
+#  define MAIN wmain
+#  define MAINCHAR wchar_t
+#else
+#  define MAIN main
+#  define MAINCHAR char
+#endif
+
+int MAIN(int argc, MAINCHAR* argv[])
+{
+#if defined(MIKTEX_WINDOWS)
+  ConsoleCodePageSwitcher cpSwitcher;
+#endif
+  PmxBatch app;
+  try
+  {
+    vector<string> utf8args;
+    utf8args.reserve(argc);
+    vector<const char*> newargv;
+    newargv.reserve(argc + 1);
+    for (int idx = 0; idx < argc; ++idx)
+    {
+#if defined(_UNICODE)
+      utf8args.push_back(StringUtil::WideCharToUTF8(argv[idx]));
+#elif defined(MIKTEX_WINDOWS)
+      utf8args.push_back(StringUtil::AnsiToUTF8(argv[idx]));
+#else
+      utf8args.push_back(argv[idx]);
+#endif
+      newargv.push_back(utf8args[idx].c_str());
+    }
+    newargv.push_back(nullptr);
+    return app.Run(argc, &newargv[0]);
+  }
+  catch (const MiKTeXException& e)
+  {
+    app.Sorry(TheNameOfTheGame, e);
+    return 1;
+  }
+  catch (const exception& e)
+  {
+    app.Sorry(TheNameOfTheGame, e);
+    return 1;
+  }
+  catch (int exitCode)
+  {
+    return exitCode;
+  }
+}
@@ -55,6 +55,7 @@ public:
         SetTeXMFMemoryHandler(&memoryHandler);
         TeXApp::Init(args);
         EnableFeature(MiKTeX::TeXAndFriends::Feature::EightBitChars);
+        EnableFeature(MiKTeX::TeXAndFriends::Feature::JobServer);
         EnableFeature(MiKTeX::TeXAndFriends::Feature::TCX);
     }
 
@@ -33,6 +33,10 @@ set(miktex_tex_change_files
     ${MIKTEX_TEX_FINISH_CH}
 )
 
+if(WITH_TEX_PREFETCH)
+    list(APPEND miktex_tex_change_files ${MIKTEX_TEX_PREFETCH_CH})
+endif()
+
 add_custom_command(
     OUTPUT
         ${CMAKE_CURRENT_BINARY_DIR}/etex-1.web
@@ -0,0 +1,130 @@
+/**
+ * @file miktex/hideflate.cpp
+ * @author Christian Schenk
+ * @brief Multi-threaded compression of HINT sections
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include "hideflate.h"
+
+using namespace std;
+
+// each block is deflated on its own; the preceding 32 KB are used as the
+// dictionary, so the compression ratio is about the same as with one stream
+constexpr size_t BLOCK_SIZE = 1024 * 1024;
+constexpr size_t DICTIONARY_SIZE = 32 * 1024;
+
+struct Block
+{
+    vector<unsigned char> deflated;
+    uLong adler;
+    bool ok = false;
+};
+
+static void DeflateBlock(const unsigned char* data, size_t size, size_t idx, size_t blockCount, Block& block)
+{
+    size_t start = idx * BLOCK_SIZE;
+    size_t length = std::min(BLOCK_SIZE, size - start);
+    bool last = idx + 1 == blockCount;
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // raw deflate: the blocks are joined to one zlib stream
+    if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return;
+    }
+    if (start > 0)
+    {
+        size_t dictionaryLength = std::min(DICTIONARY_SIZE, start);
+        deflateSetDictionary(&z, data + start - dictionaryLength, static_cast<uInt>(dictionaryLength));
+    }
+    // a sync flush appends up to 10 bytes
+    block.deflated.resize(deflateBound(&z, static_cast<uLong>(length)) + 16);
+    z.next_in = const_cast<unsigned char*>(data + start);
+    z.avail_in = static_cast<uInt>(length);
+    z.next_out = block.deflated.data();
+    z.avail_out = static_cast<uInt>(block.deflated.size());
+    // all blocks but the last end on a byte boundary and are not final
+    int ret = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+    block.ok = (last ? ret == Z_STREAM_END : ret == Z_OK && z.avail_out > 0) && z.avail_in == 0;
+    block.deflated.resize(z.total_out);
+    deflateEnd(&z);
+    block.adler = adler32(adler32(0, nullptr, 0), data + start, static_cast<uInt>(length));
+}
+
+size_t miktex_hint_deflate(const unsigned char* data, size_t size, unsigned char* out, size_t outSize)
+{
+    size_t blockCount = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (blockCount == 0)
+    {
+        return 0;
+    }
+    vector<Block> blocks(blockCount);
+    atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t idx = next++; idx < blockCount; idx = next++)
+        {
+            DeflateBlock(data, size, idx, blockCount, blocks[idx]);
+        }
+    };
+    size_t threadCount = std::max<size_t>(1, std::min<size_t>(thread::hardware_concurrency(), blockCount));
+    vector<thread> threads;
+    for (size_t n = 1; n < threadCount; ++n)
+    {
+        threads.push_back(thread(worker));
+    }
+    worker();
+    for (thread& t : threads)
+    {
+        t.join();
+    }
+
+    // zlib header for the default compression level
+    const unsigned char header[] = { 0x78, 0x9c };
+    size_t total = sizeof(header) + 4;
+    for (const Block& block : blocks)
+    {
+        if (!block.ok)
+        {
+            return 0;
+        }
+        total += block.deflated.size();
+    }
+    if (total > outSize)
+    {
+        return 0;
+    }
+    unsigned char* pos = out;
+    memcpy(pos, header, sizeof(header));
+    pos += sizeof(header);
+    uLong adler = blocks[0].adler;
+    for (size_t idx = 0; idx < blockCount; ++idx)
+    {
+        memcpy(pos, blocks[idx].deflated.data(), blocks[idx].deflated.size());
+        pos += blocks[idx].deflated.size();
+        if (idx > 0)
+        {
+            adler = adler32_combine(adler, blocks[idx].adler, static_cast<z_off_t>(std::min(BLOCK_SIZE, size - idx * BLOCK_SIZE)));
+        }
+    }
+    *pos++ = static_cast<unsigned char>(adler >> 24);
+    *pos++ = static_cast<unsigned char>(adler >> 16);
+    *pos++ = static_cast<unsigned char>(adler >> 8);
+    *pos++ = static_cast<unsigned char>(adler);
+    return pos - out;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file miktex/hideflate.h
+ * @author Christian Schenk
+ * @brief Multi-threaded compression of HINT sections
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* sections smaller than this are compressed on the calling thread */
+#define MIKTEX_HINT_PARALLEL_DEFLATE_MIN (2 * 1024 * 1024)
+
+/* Compresses data into a single zlib stream; blocks are deflated in
+   parallel. Returns the compressed size or 0, if the output buffer is too
+   small or zlib fails. */
+size_t miktex_hint_deflate(const unsigned char* data, size_t size, unsigned char* out, size_t outSize);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -7332,6 +7332,22 @@ static void hcompress(uint16_t n)
   int i;
   if (dir[n].size==0)   { dir[n].xsize=0;@+ return; @+}
   DBG(DBGCOMPRESS,"Compressing section %d of size 0x%x\n",n, dir[n].size);
+#if defined(MIKTEX)
+  if (dir[n].size>=MIKTEX_HINT_PARALLEL_DEFLATE_MIN)
+  { size_t s;
+    ALLOCATE(buffer,dir[n].size+MAX_TAG_DISTANCE,uint8_t);
+    s=miktex_hint_deflate(dir[n].buffer,dir[n].size,buffer,dir[n].size+MAX_TAG_DISTANCE);
+    if (s==0)
+      QUIT("Compression of section %d failed",n);
+    DBG(DBGCOMPRESS,@["Compressed 0x%x byte to " SIZE_F " byte\n"@],@|dir[n].size,s);
+    free(dir[n].buffer);
+    dir[n].buffer=buffer;
+    dir[n].bsize=dir[n].size+MAX_TAG_DISTANCE;
+    dir[n].xsize=dir[n].size;
+    dir[n].size=(uint32_t)s;
+    return;
+  }
+#endif
   z.zalloc = (alloc_func)0;@+
   z.zfree = (free_func)0;@+
   z.opaque = (voidpf)0;
@@ -11095,6 +11111,9 @@ extern int hcompress_depth(int n, int c);
 #include "hierror.h"
 #include "hiformat.h"
 #include "hiput.h"
+#if defined(MIKTEX)
+#include "miktex/hideflate.h"
+#endif
 
 @<common variables@>@;
 @<shared put variables@>@;
@@ -11214,6 +11233,9 @@ extern int yylex(void);
 #include "hierror.h"
 #include "hiformat.h"
 #include "hiput.h"
+#if defined(MIKTEX)
+#include "miktex/hideflate.h"
+#endif
 
 @<enable bison debugging@>@;
 #include "hiparser.h"
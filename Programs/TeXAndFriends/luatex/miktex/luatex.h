@@ -31,18 +31,22 @@ int miktex_emulate__shell_cmd_is_allowed(const char* commandLine, char** safeCom
 int miktex_emulate__spawn_command(const char* fileName, char* const* argv, char* const* env);
 void miktex_enable_installer(int onOff);
 const char* miktex_get_aux_directory();
+char* miktex_hyphenation_cache_file(const void* patterns, size_t size, const char* formatTag);
 void miktex_invoke_editor(const char* filename, int lineno);
 int miktex_is_fully_qualified_path(const char* path);
 int miktex_is_output_file(const char* path);
 int miktex_is_pipe(FILE* file);
+char* miktex_lua_bytecode_cache_file(const char* fileName, const char* engineTag);
 int miktex_open_format_file(const char* fileName, FILE** ppFile, int renew);
 FILE* miktex_open_output_file(const char* fileName);
 void miktex_print_banner(FILE* file, const char* name, const char* version);
+void* miktex_read_cache_file(const char* cacheFile, size_t* size);
 void miktex_set_aux_directory(const char* path);
 void miktex_show_library_versions();
 #if defined(MIKTEX_WINDOWS)
 char* miktex_wchar_to_utf8(const wchar_t* w);
 #endif
+void miktex_write_cache_file(const char* cacheFile, const void* data, size_t size);
 
 #if defined(__cplusplus)
 }
@@ -10,7 +10,9 @@
  * notice is preserved.
  */
 
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -19,7 +21,9 @@
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Directory>
+#include <miktex/Core/File>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
 #include <miktex/KPSE/Emulation>
@@ -402,3 +406,86 @@ void miktex_print_banner(FILE* file, const char* name, const char* version)
 {
     fputs(GetBanner(name, version).c_str(), file);
 }
+
+char* miktex_lua_bytecode_cache_file(const char* fileName, const char* engineTag)
+{
+    try
+    {
+        shared_ptr<Session> session = Application::GetApplication()->GetSession();
+        PathName path(fileName);
+        path.MakeFullyQualified();
+        // a changed source file or a different Lua yields a different key
+        string key = fmt::format("{0}\n{1}\n{2}\n{3}\n", path.ToString(), File::GetLastWriteTime(path), File::GetSize(path), engineTag);
+        MD5Builder md5Builder;
+        md5Builder.Update(key.c_str(), key.length());
+        PathName cacheFile = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_LUA_BYTECODE_CACHE_DIR / md5Builder.Final().ToString();
+        cacheFile.AppendExtension(".luc");
+        return xstrdup(cacheFile.GetData());
+    }
+    catch (const MiKTeXException&)
+    {
+        return nullptr;
+    }
+}
+
+char* miktex_hyphenation_cache_file(const void* patterns, size_t size, const char* formatTag)
+{
+    try
+    {
+        shared_ptr<Session> session = Application::GetApplication()->GetSession();
+        // the patterns themselves are the key: a format file and a pattern
+        // file with the same patterns share the entry
+        MD5Builder md5Builder;
+        md5Builder.Update(formatTag, strlen(formatTag));
+        md5Builder.Update(patterns, size);
+        PathName cacheFile = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_HYPHENATION_CACHE_DIR / md5Builder.Final().ToString();
+        cacheFile.AppendExtension(".hyd");
+        return xstrdup(cacheFile.GetData());
+    }
+    catch (const MiKTeXException&)
+    {
+        return nullptr;
+    }
+}
+
+void* miktex_read_cache_file(const char* cacheFile, size_t* size)
+{
+    try
+    {
+        if (!File::Exists(PathName(cacheFile)))
+        {
+            return nullptr;
+        }
+        vector<unsigned char> bytes = File::ReadAllBytes(PathName(cacheFile));
+        if (bytes.empty())
+        {
+            return nullptr;
+        }
+        void* data = xmalloc(bytes.size());
+        memcpy(data, bytes.data(), bytes.size());
+        *size = bytes.size();
+        return data;
+    }
+    catch (const MiKTeXException&)
+    {
+        return nullptr;
+    }
+}
+
+void miktex_write_cache_file(const char* cacheFile, const void* data, size_t size)
+{
+    try
+    {
+        PathName path(cacheFile);
+        Directory::Create(path.GetDirectoryName());
+        PathName newPath = path;
+        newPath.AppendExtension(fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId()));
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        File::WriteBytes(newPath, vector<unsigned char>(bytes, bytes + size));
+        File::Move(newPath, path, {FileMoveOption::ReplaceExisting});
+    }
+    catch (const MiKTeXException&)
+    {
+        // the cache is an optimization
+    }
+}
@@ -368,7 +368,7 @@ int lua_glyph_not_found_callback(internal_font_number f, int c)
         }
         lua_pushinteger(Luas, f);
         lua_pushinteger(Luas, c);
-        if ((i=lua_pcall(Luas, 2, 1, 0)) != 0) {
+        if ((i=callback_pcall(Luas, callback_id, 2, 1)) != 0) {
             formatted_warning   ("glyph not found", "error: %s", lua_tostring(Luas, -1));
             lua_settop(Luas, top);
             luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
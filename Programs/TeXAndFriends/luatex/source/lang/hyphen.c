@@ -560,6 +560,216 @@ void hnj_free_serialize(unsigned char *c)
 
 */
 
+#if defined(MIKTEX)
+
+/*tex
+
+    Building the state machine is the expensive part of loading patterns, and
+    it is done in every run: the patterns of a format are loaded when the format
+    is undumped. The state machine is therefore kept in the user cache, keyed by
+    the patterns. Only the first load into an empty dictionary is cached; small
+    sets of patterns are not worth a file.
+
+*/
+
+#define HNJ_CACHE_FORMAT "hyphen-states-1"
+#define HNJ_CACHE_MIN_SIZE 4096
+
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} hnj_cache_buffer;
+
+static void hnj_cache_put(hnj_cache_buffer *b, const void *p, size_t sz)
+{
+    if (b->size + sz > b->capacity) {
+        b->capacity = (b->size + sz) * 2;
+        b->data = xrealloc(b->data, b->capacity);
+    }
+    memcpy(b->data + b->size, p, sz);
+    b->size += sz;
+}
+
+static void hnj_cache_put_int(hnj_cache_buffer *b, int n)
+{
+    hnj_cache_put(b, &n, sizeof(n));
+}
+
+static void hnj_cache_put_string(hnj_cache_buffer *b, const char *s)
+{
+    if (s == NULL) {
+        hnj_cache_put_int(b, -1);
+    } else {
+        int l = (int) strlen(s);
+        hnj_cache_put_int(b, l);
+        hnj_cache_put(b, s, (size_t) l);
+    }
+}
+
+static void hnj_hyphen_store_cache(HyphenDict * dict, const char *cachefile)
+{
+    hnj_cache_buffer b = { NULL, 0, 0 };
+    int i, num_patterns = 0;
+    HashEntry *e;
+    for (i = 0; i < HASH_SIZE; i++) {
+        for (e = dict->patterns->entries[i]; e; e = e->next) {
+            num_patterns++;
+        }
+    }
+    hnj_cache_put_int(&b, dict->num_states);
+    hnj_cache_put_int(&b, dict->pat_length);
+    hnj_cache_put_int(&b, num_patterns);
+    for (i = 0; i < dict->num_states; i++) {
+        HyphenState *hstate = &dict->states[i];
+        hnj_cache_put_int(&b, hstate->fallback_state);
+        hnj_cache_put_int(&b, hstate->num_trans);
+        hnj_cache_put_string(&b, hstate->match);
+        if (hstate->num_trans > 0) {
+            hnj_cache_put(&b, hstate->trans, (size_t) hstate->num_trans * sizeof(HyphenTrans));
+        }
+    }
+    /*tex In chain order, so that |hnj_serialize| yields the same string. */
+    for (i = 0; i < HASH_SIZE; i++) {
+        for (e = dict->patterns->entries[i]; e; e = e->next) {
+            hnj_cache_put_string(&b, (const char *) e->key);
+            hnj_cache_put_string(&b, e->u.hyppat);
+        }
+    }
+    miktex_write_cache_file(cachefile, b.data, b.size);
+    free(b.data);
+}
+
+static int hnj_cache_get(const unsigned char **cur, const unsigned char *end, void *p, size_t sz)
+{
+    if ((size_t) (end - *cur) < sz) {
+        return 0;
+    }
+    memcpy(p, *cur, sz);
+    *cur += sz;
+    return 1;
+}
+
+static int hnj_cache_get_string(const unsigned char **cur, const unsigned char *end, char **s)
+{
+    int l;
+    if (!hnj_cache_get(cur, end, &l, sizeof(l))) {
+        return 0;
+    }
+    if (l == -1) {
+        *s = NULL;
+        return 1;
+    }
+    if (l < 0 || (size_t) (end - *cur) < (size_t) l) {
+        return 0;
+    }
+    *s = hnj_malloc(l + 1);
+    memcpy(*s, *cur, (size_t) l);
+    (*s)[l] = 0;
+    *cur += l;
+    return 1;
+}
+
+static int hnj_hyphen_load_cache(HyphenDict * dict, const char *cachefile)
+{
+    size_t size = 0;
+    unsigned char *data = miktex_read_cache_file(cachefile, &size);
+    const unsigned char *cur, *end;
+    int num_states, pat_length, num_patterns, capacity, i, j;
+    HashEntry **tails;
+    if (data == NULL) {
+        return 0;
+    }
+    cur = data;
+    end = data + size;
+    if (!hnj_cache_get(&cur, end, &num_states, sizeof(int))
+        || !hnj_cache_get(&cur, end, &pat_length, sizeof(int))
+        || !hnj_cache_get(&cur, end, &num_patterns, sizeof(int))
+        || num_states < 1 || pat_length < 0 || num_patterns < 0) {
+        free(data);
+        return 0;
+    }
+    /*tex The states grow in powers of two, see |hnj_get_state|. */
+    for (capacity = 1; capacity < num_states; capacity <<= 1) {
+    }
+    clear_dict(dict);
+    init_dict(dict);
+    dict->states = hnj_realloc(dict->states, capacity * (int) sizeof(HyphenState));
+    for (i = 0; i < num_states; i++) {
+        dict->states[i].match = NULL;
+        dict->states[i].fallback_state = -1;
+        dict->states[i].num_trans = 0;
+        dict->states[i].trans = NULL;
+    }
+    dict->num_states = num_states;
+    for (i = 0; i < num_states; i++) {
+        HyphenState *hstate = &dict->states[i];
+        int fallback_state, num_trans;
+        if (!hnj_cache_get(&cur, end, &fallback_state, sizeof(int))
+            || !hnj_cache_get(&cur, end, &num_trans, sizeof(int))
+            || fallback_state < -1 || fallback_state >= num_states
+            || num_trans < 0 || (size_t) num_trans > (size_t) (end - cur) / sizeof(HyphenTrans)
+            || !hnj_cache_get_string(&cur, end, &hstate->match)) {
+            goto bad;
+        }
+        hstate->fallback_state = fallback_state;
+        if (num_trans > 0) {
+            hstate->trans = hnj_malloc(num_trans * (int) sizeof(HyphenTrans));
+            hstate->num_trans = num_trans;
+            if (!hnj_cache_get(&cur, end, hstate->trans, (size_t) num_trans * sizeof(HyphenTrans))) {
+                goto bad;
+            }
+            for (j = 0; j < num_trans; j++) {
+                if (hstate->trans[j].new_state < 0 || hstate->trans[j].new_state >= num_states) {
+                    goto bad;
+                }
+            }
+        }
+    }
+    tails = xmalloc(HASH_SIZE * sizeof(HashEntry *));
+    memset(tails, 0, HASH_SIZE * sizeof(HashEntry *));
+    for (i = 0; i < num_patterns; i++) {
+        char *key, *hyppat;
+        HashEntry *e;
+        int k;
+        if (!hnj_cache_get_string(&cur, end, &key)) {
+            free(tails);
+            goto bad;
+        }
+        if (key == NULL || !hnj_cache_get_string(&cur, end, &hyppat)) {
+            if (key != NULL) {
+                hnj_free(key);
+            }
+            free(tails);
+            goto bad;
+        }
+        k = (int) (hnj_string_hash((unsigned char *) key) % HASH_SIZE);
+        e = hnj_malloc(sizeof(HashEntry));
+        e->next = NULL;
+        e->key = (unsigned char *) key;
+        e->u.hyppat = hyppat;
+        if (tails[k] == NULL) {
+            dict->patterns->entries[k] = e;
+        } else {
+            tails[k]->next = e;
+        }
+        tails[k] = e;
+    }
+    free(tails);
+    if (cur != end) {
+        goto bad;
+    }
+    dict->pat_length = pat_length;
+    free(data);
+    return 1;
+  bad:
+    free(data);
+    hnj_hyphen_clear(dict);
+    return 0;
+}
+
+#endif
+
 void hnj_hyphen_load(HyphenDict * dict, const unsigned char *f)
 {
     int state_num, last_state;
@@ -574,6 +784,19 @@ void hnj_hyphen_load(HyphenDict * dict, const unsigned char *f)
     const unsigned char *begin = f;
     unsigned char *pat;
     char *org;
+#if defined(MIKTEX)
+    char *cachefile = NULL;
+    if (dict->num_states == 1 && dict->pat_length == 0) {
+        size_t size = strlen((const char *) f);
+        if (size >= HNJ_CACHE_MIN_SIZE) {
+            cachefile = miktex_hyphenation_cache_file(f, size, HNJ_CACHE_FORMAT);
+        }
+        if (cachefile != NULL && hnj_hyphen_load_cache(dict, cachefile)) {
+            free(cachefile);
+            return;
+        }
+    }
+#endif
     while ((format = next_pattern(&l, &f)) != NULL) {
         int i, j, e1;
         if (l>=255) {
@@ -705,6 +928,12 @@ void hnj_hyphen_load(HyphenDict * dict, const unsigned char *f)
         }
     }
     clear_state_hash(&dict->state_num);
+#if defined(MIKTEX)
+    if (cachefile != NULL) {
+        hnj_hyphen_store_cache(dict, cachefile);
+        free(cachefile);
+    }
+#endif
 }
 
 extern halfword insert_syllable_discretionary(halfword t, lang_variables * lan);
@@ -1185,7 +1185,7 @@ void new_hyphenation(halfword head, halfword tail)
         }
         nodelist_to_lua(Luas, head);
         nodelist_to_lua(Luas, tail);
-        if ((i=lua_pcall(Luas, 2, 0, 0)) != 0) {
+        if ((i=callback_pcall(Luas, callback_id, 2, 0)) != 0) {
             formatted_warning("hyphenation","bad specification: %s",lua_tostring(Luas, -1));
             lua_settop(Luas, top);
             luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
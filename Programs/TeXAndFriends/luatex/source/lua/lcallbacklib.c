@@ -28,6 +28,42 @@ int function_callback_count = 0;
 
 int callback_set[total_callbacks] = { 0 };
 
+/*tex
+
+    A registered function is also referenced from the registry directly, so
+    that |get_callback| needs one lookup instead of two. The reference is
+    replaced when the callback is registered again. We also count the calls
+    per callback and sum up the time spent in them (including nested
+    callbacks), see |status.getcallbackstatistics|.
+
+*/
+
+static int callback_refs[total_callbacks] = { 0 };
+
+int callback_calls[total_callbacks] = { 0 };
+long long callback_micros[total_callbacks] = { 0 };
+
+static long long callback_clock(void)
+{
+    int seconds, micros;
+    get_seconds_and_micros(&seconds, &micros);
+    return (long long) seconds * 1000000 + micros;
+}
+
+int callback_pcall(lua_State * L, int i, int narg, int nres)
+{
+    int ret;
+    long long start = callback_clock();
+    ret = lua_pcall(L, narg, nres, 0);
+    callback_micros[i] += callback_clock() - start;
+    return ret;
+}
+
+const char *callback_name(int i)
+{
+    return callbacknames[i];
+}
+
 /* See also callback_callback_type in luatexcallbackids.h: they must have the same order ! */
 
 static const char *const callbacknames[] = {
@@ -228,11 +264,19 @@ int run_saved_callback(int r, const char *name, const char *values, ...)
 
 boolean get_callback(lua_State * L, int i)
 {
+    if (callback_refs[i] > 0) {
+        luaL_checkstack(L, 1, "out of stack space");
+        lua_rawgeti(L, LUA_REGISTRYINDEX, callback_refs[i]);
+        callback_count++;
+        callback_calls[i]++;
+        return true;
+    }
     luaL_checkstack(L, 2, "out of stack space");
     lua_rawgeti(L, LUA_REGISTRYINDEX, callback_callbacks_id);
     lua_rawgeti(L, -1, i);
     if (lua_isfunction(L, -1)) {
         callback_count++;
+        callback_calls[i]++;
         return true;
     } else {
         return false;
@@ -246,7 +290,9 @@ int run_and_save_callback(int i, const char *values, ...)
     int stacktop = lua_gettop(Luas);
     va_start(args, values);
     if (get_callback(Luas, i)) {
+        long long start = callback_clock();
         ret = do_run_callback(1, values, args);
+        callback_micros[i] += callback_clock() - start;
     }
     va_end(args);
     if (ret > 0) {
@@ -263,7 +309,9 @@ int run_callback(int i, const char *values, ...)
     int stacktop = lua_gettop(Luas);
     va_start(args, values);
     if (get_callback(Luas, i)) {
+        long long start = callback_clock();
         ret = do_run_callback(0, values, args);
+        callback_micros[i] += callback_clock() - start;
     }
     va_end(args);
     lua_settop(Luas, stacktop);
@@ -547,6 +595,15 @@ static int callback_register(lua_State * L)
     } else {
         callback_set[cb] = 0;
     }
+    if (callback_refs[cb] > 0) {
+        luaL_unref(L, LUA_REGISTRYINDEX, callback_refs[cb]);
+        callback_refs[cb] = 0;
+    }
+    if (t2 == LUA_TFUNCTION) {
+        luaL_checkstack(L, 1, "out of stack space");
+        lua_pushvalue(L, 2);
+        callback_refs[cb] = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
     luaL_checkstack(L, 2, "out of stack space");
     lua_rawgeti(L, LUA_REGISTRYINDEX, callback_callbacks_id);   /* push the table */
     lua_pushvalue(L, 2);        /* the function or nil */
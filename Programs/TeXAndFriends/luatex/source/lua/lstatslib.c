@@ -519,6 +519,24 @@ static int resetmessages(lua_State * L)
     return 0;
 }
 
+static int getcallbackstatistics(lua_State * L)
+{
+    int i;
+    luaL_checkstack(L, 3, "out of stack space");
+    lua_newtable(L);
+    for (i = 1; i < total_callbacks; i++) {
+        if (callback_calls[i] > 0) {
+            lua_createtable(L, 0, 2);
+            lua_pushinteger(L, callback_calls[i]);
+            lua_setfield(L, -2, "count");
+            lua_pushnumber(L, (double) callback_micros[i] / 1000000.0);
+            lua_setfield(L, -2, "time");
+            lua_setfield(L, -2, callback_name(i));
+        }
+    }
+    return 1;
+}
+
 static int setexitcode(lua_State * L) {
     defaultexitcode = luaL_checkinteger(L,1);
     return 0;
@@ -526,6 +544,7 @@ static int setexitcode(lua_State * L) {
 
 static const struct luaL_Reg statslib[] = {
     {"list", statslist},
+    {"getcallbackstatistics", getcallbackstatistics},
     {"resetmessages", resetmessages},
     {"setexitcode", setexitcode},
     {NULL, NULL}                /* sentinel */
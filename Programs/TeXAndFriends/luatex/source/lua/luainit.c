@@ -855,6 +855,77 @@ static const char *luatex_kpse_find_aux(lua_State *L, const char *name,
 
 static int lua_loader_function = 0;
 
+#if defined(MIKTEX)
+/*tex
+
+    Modules found by the kpse searcher are compiled once; the bytecode is kept in
+    the user cache, keyed by path, modification time, size and the \LUA\ in use.
+    Bytecode of another \LUA\ is rejected by the undumper, so a stale entry only
+    means that the source is compiled again.
+
+*/
+
+#if defined(LUAJIT_VERSION)
+#  define MIKTEX_LUA_ENGINE_TAG LUAJIT_VERSION
+#  define miktex_lua_dump(L,w,d) lua_dump(L,w,d)
+#else
+#  define MIKTEX_LUA_ENGINE_TAG LUA_RELEASE
+#  define miktex_lua_dump(L,w,d) lua_dump(L,w,d,0)
+#endif
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} bytecode_buffer;
+
+static int bytecode_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    bytecode_buffer *b = (bytecode_buffer *) ud;
+    (void) L;
+    if (b->size + sz > b->capacity) {
+        b->capacity = (b->size + sz) * 2;
+        b->data = xrealloc(b->data, b->capacity);
+    }
+    memcpy(b->data + b->size, p, sz);
+    b->size += sz;
+    return 0;
+}
+
+static int luatex_load_lua_module(lua_State *L, const char *filename)
+{
+    char *cachefile = miktex_lua_bytecode_cache_file(filename, MIKTEX_LUA_ENGINE_TAG);
+    size_t size = 0;
+    void *data;
+    int status;
+    if (cachefile == NULL) {
+        return luaL_loadfile(L, filename);
+    }
+    data = miktex_read_cache_file(cachefile, &size);
+    if (data != NULL) {
+        lua_pushfstring(L, "@%s", filename);
+        status = luaL_loadbufferx(L, (const char *) data, size, lua_tostring(L, -1), "b");
+        free(data);
+        lua_remove(L, -2);
+        if (status == 0) {
+            free(cachefile);
+            return 0;
+        }
+        lua_pop(L, 1);
+    }
+    status = luaL_loadfile(L, filename);
+    if (status == 0) {
+        bytecode_buffer b = { NULL, 0, 0 };
+        if (miktex_lua_dump(L, bytecode_writer, &b) == 0 && b.size > 0) {
+            miktex_write_cache_file(cachefile, b.data, b.size);
+        }
+        free(b.data);
+    }
+    free(cachefile);
+    return status;
+}
+#endif
+
 static int luatex_kpse_lua_find(lua_State * L)
 {
     const char *filename;
@@ -872,7 +943,11 @@ static int luatex_kpse_lua_find(lua_State * L)
         return 1;
     }
     recorder_record_input(filename);
+#if defined(MIKTEX)
+    if (luatex_load_lua_module(L, filename) != 0) {
+#else
     if (luaL_loadfile(L, filename) != 0) {
+#endif
         luaL_error(L, "error loading module %s from file %s:\n\t%s",
             lua_tostring(L, 1), filename, lua_tostring(L, -1));
     }
@@ -38,7 +38,7 @@ void lua_node_filter_s(int filterid, int extrainfo)
         return;
     }
     lua_push_string_by_index(Luas,extrainfo);
-    if ((i=lua_pcall(Luas, 1, 0, 0)) != 0) {
+    if ((i=callback_pcall(Luas, callback_id, 1, 0)) != 0) {
         formatted_warning("node filter","error: %s", lua_tostring(Luas, -1));
         lua_settop(Luas, s_top);
         luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
@@ -69,7 +69,7 @@ void lua_node_filter(int filterid, int extrainfo, halfword head_node, halfword *
     /*tex the action */
     nodelist_to_lua(Luas, start_node);
     lua_push_group_code(Luas,extrainfo);
-    if ((i=lua_pcall(Luas, 2, 1, 0)) != 0) {
+    if ((i=callback_pcall(Luas, callback_id, 2, 1)) != 0) {
         formatted_warning("node filter", "error: %s\n", lua_tostring(Luas, -1));
         lua_settop(Luas, s_top);
         luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
@@ -134,7 +134,7 @@ int lua_linebreak_callback(int is_broken, halfword head_node, halfword * new_hea
     alink(vlink(head_node)) = null ;
     nodelist_to_lua(Luas, vlink(head_node));
     lua_pushboolean(Luas, is_broken);
-    if ((i=lua_pcall(Luas, 2, 1, 0)) != 0) {
+    if ((i=callback_pcall(Luas, callback_id, 2, 1)) != 0) {
         formatted_warning("linebreak", "error: %s", lua_tostring(Luas, -1));
         lua_settop(Luas, s_top);
         luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
@@ -174,7 +174,7 @@ int lua_appendtovlist_callback(halfword box, int location, halfword prev_depth,
     lua_push_string_by_index(Luas,location);
     lua_pushinteger(Luas, (int) prev_depth);
     lua_pushboolean(Luas, is_mirrored);
-    if ((i=lua_pcall(Luas, 4, 2, 0)) != 0) {
+    if ((i=callback_pcall(Luas, callback_id, 4, 2)) != 0) {
         formatted_warning("append to vlist","error: %s", lua_tostring(Luas, -1));
         lua_settop(Luas, s_top);
         luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
@@ -226,7 +226,7 @@ halfword lua_hpack_filter(halfword head_node, scaled size, int pack_type, int ex
     } else {
         lua_pushnil(Luas);
     }
-    if ((i=lua_pcall(Luas, 6, 1, 0)) != 0) {
+    if ((i=callback_pcall(Luas, callback_id, 6, 1)) != 0) {
         formatted_warning("hpack filter", "error: %s\n", lua_tostring(Luas, -1));
         lua_settop(Luas, s_top);
         luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
@@ -287,7 +287,7 @@ halfword lua_vpack_filter(halfword head_node, scaled size, int pack_type, scaled
     } else {
         lua_pushnil(Luas);
     }
-    if ((i=lua_pcall(Luas, 7, 1, 0)) != 0) {
+    if ((i=callback_pcall(Luas, callback_id, 7, 1)) != 0) {
         formatted_warning("vpack filter", "error: %s", lua_tostring(Luas, -1));
         lua_settop(Luas, s_top);
         luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
@@ -225,6 +225,10 @@ extern int direct_callback_count;
 extern int late_callback_count;
 extern int function_callback_count;
 
+extern int callback_calls[];
+extern long long callback_micros[];
+extern const char *callback_name(int i);
+
 extern const char *luatex_banner;
 extern const char *engine_name;
 
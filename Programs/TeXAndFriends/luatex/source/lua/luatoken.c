@@ -510,7 +510,7 @@ static void do_get_token_lua(int callback_id)
             lua_pop(Luas, 2);
             break;
         }
-        if (lua_pcall(Luas, 0, 1, 0) != 0) {
+        if (callback_pcall(Luas, callback_id, 0, 1) != 0) {
             tex_error(lua_tostring(Luas, -1), NULL);
             lua_pop(Luas, 2);
             break;
@@ -336,6 +336,7 @@ scaled divide_scaled_n(double s, double m, double d);
 #  include "luatexcallbackids.h"
 
 extern boolean get_callback(lua_State * L, int i);
+extern int callback_pcall(lua_State * L, int i, int narg, int nres);
 
 /* Additions to texmfmp.h for pdfTeX */
 
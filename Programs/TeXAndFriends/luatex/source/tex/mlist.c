@@ -1874,7 +1874,7 @@ void run_mlist_to_hlist(halfword p, boolean penalties, int mstyle)
         nodelist_to_lua(Luas, p);
         lua_push_math_style_name(Luas, mstyle);
         lua_pushboolean(Luas, penalties);
-        if ((i=lua_pcall(Luas, 3, 1, 0)) != 0) {
+        if ((i=callback_pcall(Luas, callback_id, 3, 1)) != 0) {
             formatted_warning("mlist to hlist","error: %s",lua_tostring(Luas, -1));
             lua_settop(Luas, sfix);
             luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
@@ -4820,7 +4820,7 @@ halfword make_local_par_node(int mode)
             nodelist_to_lua(Luas, p);
             lua_push_local_par_mode(Luas,mode)
             /*tex 2 arg, 0 result */
-            i = lua_pcall(Luas, 2, 0, 0);
+            i = callback_pcall(Luas, callback_id, 2, 0);
             if (i != 0) {
                 lua_gc(Luas, LUA_GCCOLLECT, 0);
                 Luas = luatex_error(Luas, (i == LUA_ERRRUN ? 0 : 1));
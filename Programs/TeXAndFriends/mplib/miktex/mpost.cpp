@@ -10,13 +10,23 @@
  * notice is preserved.
  */
 
+#include <algorithm>
+#include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/App/Application>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+#include <miktex/Core/StreamReader>
+#include <miktex/Core/StreamWriter>
 #include <miktex/Core/Utils>
 
 #include "mpost.h"
@@ -24,6 +34,7 @@
 using namespace std;
 
 using namespace MiKTeX::App;
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Util;
 
@@ -61,3 +72,157 @@ int miktex_emulate__do_spawn(void* mpx, const char* fileName, char* const* argv)
         return -1;
     }
 }
+
+// The key is made of the TeX file which mpto has extracted from the .mp
+// file: all btex..etex labels plus mptexpre.tex.  The "% line N file"
+// comments are skipped, so that editing the figures does not
+// invalidate the cached .mpx file.  The files read by the TeX run
+// (format, TFM files, files \input by verbatimtex) are not part of
+// the key: they are recorded together with their digests in a
+// companion .inputs file, which must still match when the cached
+// .mpx file is fetched.
+static PathName GetMpxCacheFile(const char* texFile, const char* mainCmd, const char* banner)
+{
+    MD5Builder md5Builder;
+    string settings = fmt::format("{0}\n{1}\n", mainCmd, banner);
+    md5Builder.Update(settings.c_str(), settings.length());
+    ifstream stream = File::CreateInputStream(PathName(texFile));
+    const string lineComment = "% line ";
+    for (string line; std::getline(stream, line); )
+    {
+        string::size_type pos = line.find(lineComment);
+        if (pos == 0)
+        {
+            continue;
+        }
+        if (pos != string::npos && line.compare(0, pos, "\\mpxshipout") == 0)
+        {
+            line.erase(pos);
+        }
+        line += '\n';
+        md5Builder.Update(line.c_str(), line.length());
+    }
+    PathName path = MIKTEX_SESSION()->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_MPX_CACHE_DIR / md5Builder.Final().ToString();
+    path.AppendExtension(".mpx");
+    return path;
+}
+
+static PathName GetInputsFile(const PathName& cachedFile)
+{
+    PathName path = cachedFile;
+    path.SetExtension(".inputs");
+    return path;
+}
+
+// Returns false, if the TeX run has read a file from the working
+// directory: such a file belongs to the project and must not leak
+// into the global cache.
+static bool GetRecordedInputFiles(const PathName& flsFile, const PathName& texFile, vector<PathName>& inputFiles)
+{
+    PathName cwd;
+    cwd.SetToCurrentDirectory();
+    StreamReader reader(flsFile);
+    string line;
+    while (reader.ReadLine(line))
+    {
+        if (line.compare(0, 6, "INPUT ") != 0)
+        {
+            continue;
+        }
+        PathName path(line.substr(6));
+        if (path == texFile)
+        {
+            continue;
+        }
+        if (!path.IsFullyQualified() || Utils::IsParentDirectoryOf(cwd, path))
+        {
+            return false;
+        }
+        if (std::find(inputFiles.begin(), inputFiles.end(), path) == inputFiles.end())
+        {
+            inputFiles.push_back(path);
+        }
+    }
+    reader.Close();
+    return true;
+}
+
+static bool InputsUnchanged(const PathName& inputsFile)
+{
+    PathName cwd;
+    cwd.SetToCurrentDirectory();
+    vector<PathName> inputFiles;
+    vector<MD5> inputDigests;
+    StreamReader reader(inputsFile);
+    string line;
+    while (reader.ReadLine(line))
+    {
+        if (line.length() < 34 || line[32] != ' ')
+        {
+            return false;
+        }
+        PathName path(line.substr(33));
+        // a file in the working directory would shadow the recorded file
+        if (!File::Exists(path) || File::Exists(cwd / path.GetFileName()))
+        {
+            return false;
+        }
+        inputDigests.push_back(MD5::Parse(line.substr(0, 32)));
+        inputFiles.push_back(path);
+    }
+    reader.Close();
+    return MD5::FromFiles(inputFiles, std::max<size_t>(1, thread::hardware_concurrency())) == inputDigests;
+}
+
+int miktex_mpx_cache_fetch(const char* texFile, const char* mainCmd, const char* banner, const char* mpxFile)
+{
+    try
+    {
+        PathName cachedFile = GetMpxCacheFile(texFile, mainCmd, banner);
+        PathName inputsFile = GetInputsFile(cachedFile);
+        if (!File::Exists(cachedFile) || !File::Exists(inputsFile) || !InputsUnchanged(inputsFile))
+        {
+            return 0;
+        }
+        File::Copy(cachedFile, PathName(mpxFile), { FileCopyOption::ReplaceExisting });
+        return 1;
+    }
+    catch (const MiKTeXException&)
+    {
+        return 0;
+    }
+}
+
+void miktex_mpx_cache_store(const char* texFile, const char* mainCmd, const char* banner, const char* mpxFile, const char* flsFile)
+{
+    try
+    {
+        vector<PathName> inputFiles;
+        if (!File::Exists(PathName(flsFile)) || !GetRecordedInputFiles(PathName(flsFile), PathName(texFile), inputFiles))
+        {
+            return;
+        }
+        vector<MD5> digests = MD5::FromFiles(inputFiles, std::max<size_t>(1, thread::hardware_concurrency()));
+        PathName cachedFile = GetMpxCacheFile(texFile, mainCmd, banner);
+        PathName inputsFile = GetInputsFile(cachedFile);
+        Directory::Create(cachedFile.GetDirectoryName());
+        string suffix = fmt::format(".{0}", Process::GetCurrentProcess()->GetSystemId());
+        PathName newInputsFile = inputsFile;
+        newInputsFile.AppendExtension(suffix);
+        StreamWriter writer(newInputsFile);
+        for (size_t idx = 0; idx < inputFiles.size(); ++idx)
+        {
+            writer.WriteLine(fmt::format("{} {}", digests[idx].ToString(), inputFiles[idx].ToString()));
+        }
+        writer.Close();
+        PathName newPath = cachedFile;
+        newPath.AppendExtension(suffix);
+        File::Copy(PathName(mpxFile), newPath);
+        File::Move(newInputsFile, inputsFile, { FileMoveOption::ReplaceExisting });
+        File::Move(newPath, cachedFile, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const MiKTeXException&)
+    {
+        // the cache is an optimization: the .mpx file has been made anyway
+    }
+}
@@ -19,6 +19,8 @@ extern "C" {
 #endif
 
 int miktex_emulate__do_spawn(void* mpx, const char* fileName, char* const* argv);
+int miktex_mpx_cache_fetch(const char* texFile, const char* mainCmd, const char* banner, const char* mpxFile);
+void miktex_mpx_cache_store(const char* texFile, const char* mainCmd, const char* banner, const char* mpxFile, const char* flsFile);
 void miktex_print_banner(FILE* file, const char* name, const char* version);
 void miktex_show_library_versions();
 
@@ -4209,6 +4209,15 @@ int mpx_makempx (mpx_options *mpxopt) {
     @<Run |mpto| on the mp file@>;
     if (mpxopt->cmd==NULL)
       goto DONE;
+#if defined(MIKTEX)
+    if (mpx->mode == mpx_tex_mode && !mpx->debug &&
+        miktex_mpx_cache_fetch(mpx->tex, mpxopt->cmd, mpx->banner, mpx->mpxname)) {
+      mpx_fclose(mpx,mpx->errfile);
+      remove(MPXLOG);
+      mpx_erasetmp(mpx);
+      goto DONE;
+    }
+#endif
     if (mpx->mode == mpx_tex_mode) {
       @<Run |TeX| and set up |infile| or abort@>;
       if (mpx_dvitomp(mpx, infile)) {
@@ -4230,6 +4239,13 @@ int mpx_makempx (mpx_options *mpxopt) {
       }
     }
     mpx_fclose(mpx,mpx->mpxfile);
+#if defined(MIKTEX)
+    if (mpx->mode == mpx_tex_mode && !mpx->debug && mpx->history == mpx_spotless) {
+      char fls[15];
+      TMPNAME_EXT(fls, ".fls");
+      miktex_mpx_cache_store(mpx->tex, mpxopt->cmd, mpx->banner, mpx->mpxname, fls);
+    }
+#endif
     if (!mpx->debug)
       mpx_fclose(mpx,mpx->errfile);
     if (!mpx->debug) {
@@ -4302,7 +4318,13 @@ that to the command line.
 @<Run |TeX| and set ...@>=
 {
   char log[15];
+#if defined(MIKTEX)
+  /* the recorded input files are checked by the .mpx cache */
+  mpx->maincmd = xrealloc(mpx->maincmd,strlen(mpx->maincmd)+strlen(" --recorder")+strlen(mpx->tex)+2,1);
+  strcat(mpx->maincmd, " --recorder");
+#else
   mpx->maincmd = xrealloc(mpx->maincmd,strlen(mpx->maincmd)+strlen(mpx->tex)+2,1);
+#endif
   strcat(mpx->maincmd, " ");
   strcat(mpx->maincmd, mpx->tex);
   cmdlength = split_command(mpx->maincmd, cmdline);
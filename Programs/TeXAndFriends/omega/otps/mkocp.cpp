@@ -18,15 +18,25 @@
    USA. */
 
 #include <cstdio>
+#include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/Directory>
 #include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
 #include <miktex/Core/FileType>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
 #include <miktex/Core/Process>
 #include <miktex/Core/Session>
 #include <miktex/Core/Utils>
@@ -46,6 +56,110 @@ using namespace MiKTeX::Util;
 #  define tcerr cerr
 #endif
 
+/* _________________________________________________________________________
+
+   CompileAll
+
+   Compiles OTP files into the OCP directory of the data root; used by
+   the package installer.  Each OCP is accompanied by the MD5 of its
+   source (OCPFILE.md5): an OCP whose source did not change is not
+   compiled again.
+   _________________________________________________________________________ */
+
+static int CompileAll(shared_ptr<Session> pSession, const PathName & otp2ocp, const vector<PathName> & otpFiles)
+{
+  PathName outputDirectory = pSession->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_OCP_DIR / "miktex";
+  Directory::Create(outputDirectory);
+
+  vector<MD5> digests = MD5::FromFiles(otpFiles, thread::hardware_concurrency());
+
+  vector<size_t> toBeCompiled;
+  for (size_t idx = 0; idx < otpFiles.size(); ++idx)
+  {
+    PathName ocp = outputDirectory / otpFiles[idx].GetFileNameWithoutExtension().ToString();
+    ocp.AppendExtension(".ocp");
+    PathName digestFile(ocp);
+    digestFile.AppendExtension(".md5");
+    if (File::Exists(ocp) && File::Exists(digestFile))
+    {
+      vector<unsigned char> bytes = File::ReadAllBytes(digestFile);
+      if (string(bytes.begin(), bytes.end()) == digests[idx].ToString())
+      {
+        continue;
+      }
+    }
+    toBeCompiled.push_back(idx);
+  }
+
+  // otp2ocp is not CPU-bound for long: one process per core
+  atomic<size_t> next(0);
+  mutex mux;
+  vector<Fndb::Record> created;
+  int exitCode = 0;
+  auto worker = [&]()
+  {
+    for (size_t n = next++; n < toBeCompiled.size(); n = next++)
+    {
+      const PathName & otp = otpFiles[toBeCompiled[n]];
+      string name = otp.GetFileNameWithoutExtension().ToString();
+      PathName ocp = outputDirectory / name;
+      ocp.AppendExtension(".ocp");
+      PathName digestFile(ocp);
+      digestFile.AppendExtension(".md5");
+      // otp2ocp appends .ocp to the temporary name
+      string tempName = name + "-" + std::to_string(n) + ".tmp";
+      PathName tempOcp = outputDirectory / tempName;
+      tempOcp.AppendExtension(".ocp");
+      int otp2ocpExitCode = 1;
+      try
+      {
+        if (Process::Run(otp2ocp, { otp2ocp.GetFileNameWithoutExtension().ToString(), otp.ToString(), tempName }, nullptr, &otp2ocpExitCode, nullptr, outputDirectory.GetData()) && otp2ocpExitCode == 0)
+        {
+          bool existed = File::Exists(ocp);
+          File::Move(tempOcp, ocp, { FileMoveOption::ReplaceExisting });
+          string digest = digests[toBeCompiled[n]].ToString();
+          File::WriteBytes(digestFile, vector<unsigned char>(digest.begin(), digest.end()));
+          lock_guard<mutex> lock(mux);
+          if (!existed)
+          {
+            created.push_back({ ocp, "" });
+          }
+          continue;
+        }
+      }
+      catch (const MiKTeXException & e)
+      {
+        lock_guard<mutex> lock(mux);
+        Utils::PrintException(e);
+      }
+      if (File::Exists(tempOcp))
+      {
+        File::Delete(tempOcp, { FileDeleteOption::TryHard });
+      }
+      lock_guard<mutex> lock(mux);
+      tcerr << T_("mkocp: ") << otp.ToString() << T_(" could not be compiled.") << endl;
+      exitCode = 1;
+    }
+  };
+  size_t threadCount = std::max<size_t>(1, std::min<size_t>(thread::hardware_concurrency(), toBeCompiled.size()));
+  vector<thread> threads;
+  for (size_t n = 1; n < threadCount; ++n)
+  {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for (thread & t : threads)
+  {
+    t.join();
+  }
+
+  if (!created.empty())
+  {
+    Fndb::Add(created);
+  }
+  return exitCode;
+}
+
 /* _________________________________________________________________________
 
    main
@@ -68,9 +182,11 @@ int main(int argc, char ** argv)
     Session::InitInfo initInfo;
     initInfo.SetProgramInvocationName(argv[0]);
     pSession = Session::Create(initInfo);
-    if (argc != 2)
+    bool batch = argc > 1 && string(argv[1]) == "--batch";
+    if (batch ? argc < 3 : argc != 2)
     {
       tcerr << T_("Usage: mkocp OCPFILE") << endl;
+      tcerr << T_("       mkocp --batch OTPFILE...") << endl;
       throw 1;
     }
     PathName otp2ocp;
@@ -79,6 +195,10 @@ int main(int argc, char ** argv)
       tcerr << T_("mkocp: otp2ocp executable could not be found.") << endl;
       throw 1;
     }
+    if (batch)
+    {
+      return CompileAll(pSession, otp2ocp, vector<PathName>(argv + 2, argv + argc));
+    }
     PathName argv1(argv[1]);
     PathName outputName;
     if (PathName::Equals(PathName(argv1.GetExtension()), PathName(".ocp")))
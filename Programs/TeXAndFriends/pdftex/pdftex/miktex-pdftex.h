@@ -196,6 +196,7 @@ public:
     enum {
         OPT_DRAFTMODE = 10000,
         OPT_OUTPUT_FORMAT,
+        OPT_ZIP_THREADS,
     };
 
     void AddOptions() override
@@ -203,6 +204,7 @@ public:
         ETeXApp::AddOptions();
         AddOption("draftmode", T_("Switch on draft mode (generates no output)."), OPT_DRAFTMODE);
         AddOption("output-format", T_("Set the output format."), OPT_OUTPUT_FORMAT, POPT_ARG_STRING, "FORMAT");
+        AddOption("zip-threads", T_("Compress large streams with N threads."), OPT_ZIP_THREADS, POPT_ARG_STRING, "N");
     }
 
     bool ProcessOption(int opt, const std::string& optArg) override
@@ -229,6 +231,13 @@ public:
                 FatalError(T_("Unknown output format value."));
             }
             break;
+        case OPT_ZIP_THREADS:
+            zipThreads = std::stoi(optArg);
+            if (zipThreads < 1)
+            {
+                FatalError(T_("Invalid number of zip threads."));
+            }
+            break;
         default:
             done = ETeXApp::ProcessOption(opt, optArg);
             break;
@@ -302,6 +311,11 @@ public:
 
     void GetLibraryVersions(std::vector<MiKTeX::Core::LibraryVersion>& versions) const override;
 
+    int GetZipThreads() const
+    {
+        return zipThreads;
+    }
+
 #if defined(MIKTEX_WINDOWS)
     unsigned long GetHelpId() const override
     {
@@ -329,6 +343,7 @@ private:
     MemoryHandlerImpl memoryHandler{ PDFTEXPROG, *this };
     MiKTeX::TeXAndFriends::StringHandlerImpl<PDFTEXPROGCLASS> stringHandler{ PDFTEXPROG };
     std::unique_ptr<MiKTeX::Locale::Translator> translator;
+    int zipThreads = 1;
 
     static MiKTeX::Resources::ResourceRepository* resources;
 };
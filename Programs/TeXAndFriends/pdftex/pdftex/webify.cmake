@@ -47,6 +47,10 @@ set(miktex_tex_change_files
     ${MIKTEX_TEX_FINISH_CH}
 )
 
+if(WITH_TEX_PREFETCH)
+    list(APPEND miktex_tex_change_files ${MIKTEX_TEX_PREFETCH_CH})
+endif()
+
 list(APPEND web_files ${projdir}/source/pdftex.web)
 
 add_custom_command(
@@ -88,6 +88,9 @@ extern fm_entry *lookup_fontmap(char *);
 extern void epdf_check_mem(void);
 extern void epdf_delete(void);
 extern int read_pdf_info(char *, char *, int, int, int, int, int);
+#if defined(MIKTEX)
+extern void *epdf_open_document(char *);
+#endif
 
 /* utils.c */
 extern char *convertStringToPDFString(const char *in, int len);
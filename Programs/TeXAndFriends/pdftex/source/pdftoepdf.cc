@@ -32,6 +32,10 @@ extern "C" {
 #if !defined(MIKTEX)
 }
 #endif
+#if defined(MIKTEX)
+#include <string>
+#include <miktex/Core/Session>
+#endif
 
 #include <stdlib.h>
 #include <math.h>
@@ -718,6 +722,79 @@ static PDFRectangle *get_pagebox(Page * page, int pagebox_spec)
 }
 
 
+#if defined(MIKTEX)
+static void set_epdf_box(double x1, double y1, double x2, double y2)
+{
+    if (x2 > x1) {
+        epdf_orig_x = x1;
+        epdf_width = x2 - x1;
+    } else {
+        epdf_orig_x = x2;
+        epdf_width = x1 - x2;
+    }
+    if (y2 > y1) {
+        epdf_orig_y = y1;
+        epdf_height = y2 - y1;
+    } else {
+        epdf_orig_y = y2;
+        epdf_height = y1 - y2;
+    }
+}
+
+static void check_pdf_version(float pdf_version_found, int major_pdf_version_wanted,
+                              int minor_pdf_version_wanted, int pdf_inclusion_errorlevel)
+{
+    float pdf_version_wanted = major_pdf_version_wanted + (minor_pdf_version_wanted * 0.1);
+    if (pdf_version_found > pdf_version_wanted + 0.01) {
+        char msg[] =
+            "PDF inclusion: found PDF version <%.1f>, but at most version <%.1f> allowed";
+        if (pdf_inclusion_errorlevel > 0) {
+            pdftex_fail(msg, pdf_version_found, pdf_version_wanted);
+        } else if (pdf_inclusion_errorlevel < 0) {
+            ; /* do nothing */
+        } else { /* = 0, give warning */
+            pdftex_warn(msg, pdf_version_found, pdf_version_wanted);
+        }
+    }
+}
+
+// Takes the information about a page from the PDF box cache.  The PDF file
+// is not opened: epdf_doc is NULL until the image is written.
+
+static bool read_cached_pdf_info(char *image_name, int page_num, int pagebox_spec,
+                                 int major_pdf_version_wanted, int minor_pdf_version_wanted,
+                                 int pdf_inclusion_errorlevel)
+{
+    MiKTeX::Core::PdfBoxInfo info;
+    if (!MIKTEX_SESSION()->TryGetPdfBoxInfo(image_name, page_num, "pdftex/" + std::to_string(pagebox_spec), info)
+        || page_num > info.pageCount) {
+        return false;
+    }
+    check_pdf_version(info.pdfVersion / 10.0, major_pdf_version_wanted, minor_pdf_version_wanted, pdf_inclusion_errorlevel);
+    epdf_num_pages = info.pageCount;
+    set_epdf_box(info.llx, info.lly, info.urx, info.ury);
+    epdf_rotate = info.rotate;
+    epdf_has_page_group = info.hasPageGroup ? 1 : 0;
+    epdf_doc = NULL;
+    return true;
+}
+
+// Opens the PDF file of an image whose information has been taken from
+// the cache.
+
+void *epdf_open_document(char *image_name)
+{
+    if (!isInit) {
+        globalParams = new GlobalParams();
+        globalParams->setErrQuiet(gFalse);
+        isInit = gTrue;
+    }
+    PdfDocument *pdf_doc = find_add_document(image_name);
+    pdf_doc->xref = pdf_doc->doc->getXRef();
+    return pdf_doc;
+}
+#endif
+
 // Reads various information about the PDF and sets it up for later inclusion.
 // This will fail if the PDF version of the PDF is higher than
 // minor_pdf_version_wanted or page_name is given and can not be found.
@@ -733,6 +810,14 @@ read_pdf_info(char *image_name, char *page_name, int page_num,
     Page *page;
     PDFRectangle *pagebox;
     float pdf_version_found, pdf_version_wanted;
+#if defined(MIKTEX)
+    // a named destination has to be looked up in the PDF file
+    if (page_name == NULL && page_num > 0
+        && read_cached_pdf_info(image_name, page_num, pagebox_spec, major_pdf_version_wanted,
+                                minor_pdf_version_wanted, pdf_inclusion_errorlevel)) {
+        return page_num;
+    }
+#endif
     // initialize
     if (!isInit) {
         globalParams = new GlobalParams();
@@ -813,6 +898,18 @@ read_pdf_info(char *image_name, char *page_name, int page_num,
         epdf_has_page_group = 0;    // no page group present
 
     pdf_doc->xref = pdf_doc->doc->getXRef();
+#if defined(MIKTEX)
+    MiKTeX::Core::PdfBoxInfo info;
+    info.llx = pagebox->x1;
+    info.lly = pagebox->y1;
+    info.urx = pagebox->x2;
+    info.ury = pagebox->y2;
+    info.rotate = (int) epdf_rotate;
+    info.pageCount = epdf_num_pages;
+    info.pdfVersion = (int) (pdf_version_found * 10 + 0.5);
+    info.hasPageGroup = epdf_has_page_group == 1;
+    MIKTEX_SESSION()->SetPdfBoxInfo(image_name, page_num, "pdftex/" + std::to_string(pagebox_spec), info);
+#endif
     return page_num;
 }
 
@@ -1073,6 +1170,11 @@ void write_epdf(void)
 void epdf_delete()
 {
     PdfDocument *pdf_doc = (PdfDocument *) epdf_doc;
+#if defined(MIKTEX)
+    // the image has not been written
+    if (pdf_doc == NULL)
+        return;
+#endif
     xref = pdf_doc->xref;
     if (pdf_doc->occurences < 0) {
         delete_document(pdf_doc);
@@ -369,6 +369,10 @@ extern void ttf_free(void);
 /* writezip.c */
 extern void writezip(boolean);
 extern void zip_free(void);
+#if defined(MIKTEX)
+extern void zip_cache_begin(void);
+extern void zip_cache_end(void);
+#endif
 
 /* avlstuff.c */
 extern int comp_int_entry(const void *, const void *, void *);
@@ -386,6 +386,10 @@ void writeimage(integer img)
         write_jbig2(img);
         break;
     case IMAGE_TYPE_PDF:
+#if defined(MIKTEX)
+        if (pdf_ptr(img)->doc == NULL)
+            pdf_ptr(img)->doc = epdf_open_document(img_name(img));
+#endif
         epdf_doc = pdf_ptr(img)->doc;
         epdf_selected_page = pdf_ptr(img)->selected_page;
         epdf_page_box = pdf_ptr(img)->page_box;
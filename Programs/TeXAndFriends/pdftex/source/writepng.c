@@ -641,6 +641,9 @@ void write_png(integer img)
             if (png_get_valid(png_ptr(img), png_info(img), PNG_INFO_sPLT))
                 tex_printf(" sPLT");
         }
+#if defined(MIKTEX)
+        zip_cache_begin();
+#endif
         switch (png_get_color_type(png_ptr(img), png_info(img))) {
         case PNG_COLOR_TYPE_PALETTE:
             write_png_palette(img);
@@ -669,6 +672,9 @@ void write_png(integer img)
             pdftex_fail("unsupported type of color_type <%i>",
                         png_get_color_type(png_ptr(img), png_info(img)));
         }
+#if defined(MIKTEX)
+        zip_cache_end();
+#endif
     }
     pdfflush();
     write_additional_png_objects();
@@ -21,6 +21,16 @@ with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "zlib.h"
 #if defined(MIKTEX)
 #define assert MIKTEX_ASSERT
+#include <algorithm>
+#include <future>
+#include <vector>
+#include <fmt/format.h>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
 #else
 #include <assert.h>
 #endif
@@ -34,7 +44,269 @@ with this program.  If not, see <http://www.gnu.org/licenses/>.
 static char *zipbuf = NULL;
 static z_stream c_stream;       /* compression stream */
 
+#if defined(MIKTEX)
+/* While the zip cache is active, the data of a stream is collected
+   instead of being compressed.  At the end of the stream, the compressed
+   data is taken from the cache, if there is an entry for the digest of the
+   data and the compression level; otherwise it is compressed and stored.
+   writepng.c uses this for the images it has to re-encode, so that the
+   same PNG files are not compressed again on every run. */
+
+#define ZIP_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+static boolean zip_cache_active = false;
+static boolean zip_cache_bypass = false;
+static std::vector<unsigned char> zip_cache_data;
+static std::vector<unsigned char> *zip_capture = NULL;
+
+static void zip_deflate(Bytef * data, uInt size, boolean finish);
+static void zip_compress(Bytef * data, uInt size, boolean finish);
+
+/* With --zip-threads=N, large streams are cut into blocks which are
+   compressed by N threads at the same time (as pigz does it).  Each block
+   is a raw deflate stream primed with the last 32K of the preceding data
+   and ended by a sync flush, so that the blocks, written in order, make up
+   one zlib stream.  Streams smaller than two blocks are compressed as
+   usual. */
+
+#define ZIP_BLOCK_SIZE (128 * 1024)
+#define ZIP_WINDOW_SIZE 32768
+
+struct zip_block
+{
+    int err = Z_OK;
+    std::vector<unsigned char> out;
+};
+
+static std::vector<unsigned char> zip_par_data; /* window + pending input */
+static size_t zip_par_window = 0;
+static boolean zip_par_started = false;
+static uLong zip_par_adler = 0;
+static C4P::C4P_longinteger zip_par_written = 0;
+
+static void zip_emit(const unsigned char *data, size_t size)
+{
+    if (size == 0)
+        return;
+    if (zip_capture != NULL)
+        zip_capture->insert(zip_capture->end(), data, data + size);
+    pdfgone += xfwrite(data, 1, size, pdffile);
+    pdflastbyte = data[size - 1];
+    zip_par_written += size;
+    pdfstreamlength = zip_par_written;
+}
+
+static zip_block zip_deflate_block(const unsigned char *dict, size_t dict_size,
+                                   const unsigned char *data, size_t size,
+                                   int level, bool last)
+{
+    zip_block block;
+    z_stream s;
+    s.zalloc = (alloc_func) 0;
+    s.zfree = (free_func) 0;
+    s.opaque = (voidpf) 0;
+    block.err = deflateInit2(&s, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (block.err != Z_OK)
+        return block;
+    if (dict_size > 0)
+        block.err = deflateSetDictionary(&s, dict, (uInt) dict_size);
+    if (block.err == Z_OK) {
+        /* room for the sync flush marker, too */
+        block.out.resize(deflateBound(&s, (uLong) size) + 16);
+        s.next_in = (Bytef *) data;
+        s.avail_in = (uInt) size;
+        s.next_out = block.out.data();
+        s.avail_out = (uInt) block.out.size();
+        block.err = deflate(&s, last ? Z_FINISH : Z_SYNC_FLUSH);
+        if (block.err == (last ? Z_STREAM_END : Z_OK) && s.avail_in == 0 && s.avail_out > 0) {
+            block.err = Z_OK;
+            block.out.resize(s.total_out);
+        } else if (block.err == Z_OK || block.err == Z_STREAM_END)
+            block.err = Z_BUF_ERROR;
+    }
+    deflateEnd(&s);
+    return block;
+}
+
+/* compress and write the pending input; unless finish is set, only whole
+   blocks are done */
+static void zip_par_flush(boolean finish)
+{
+    int level = getpdfcompresslevel();
+    size_t threads = PDFTEXAPP.GetZipThreads();
+    if (!zip_par_started) {
+        /* the zlib header, as deflate() would write it */
+        int level_flags = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+        unsigned header = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8 | level_flags << 6;
+        header += 31 - header % 31;
+        unsigned char bytes[2] = { (unsigned char) (header >> 8), (unsigned char) (header & 0xff) };
+        zip_par_written = 0;
+        zip_par_adler = adler32(0, Z_NULL, 0);
+        zip_emit(bytes, 2);
+        zip_par_started = true;
+    }
+    size_t pos = zip_par_window;
+    bool finished = false;
+    while (pos < zip_par_data.size()) {
+        std::vector<std::future<zip_block>> blocks;
+        for (size_t i = 0; i < threads && pos < zip_par_data.size(); ++i) {
+            size_t size = std::min<size_t>(ZIP_BLOCK_SIZE, zip_par_data.size() - pos);
+            if (size < ZIP_BLOCK_SIZE && !finish)
+                break;
+            bool last = finish && pos + size == zip_par_data.size();
+            size_t dict_size = std::min<size_t>(pos, ZIP_WINDOW_SIZE);
+            const unsigned char *data = zip_par_data.data() + pos;
+            blocks.push_back(std::async(std::launch::async, zip_deflate_block, data - dict_size, dict_size, data, size, level, last));
+            pos += size;
+            finished = last;
+        }
+        if (blocks.empty())
+            break;
+        for (std::future<zip_block> &f : blocks) {
+            zip_block block = f.get();
+            check_err(block.err, "deflate");
+            zip_emit(block.out.data(), block.out.size());
+        }
+    }
+    zip_par_adler = adler32(zip_par_adler, zip_par_data.data() + zip_par_window, (uInt) (pos - zip_par_window));
+    if (finish) {
+        if (!finished) {
+            /* everything has been flushed: end with an empty final block */
+            zip_block block = zip_deflate_block(NULL, 0, zip_par_data.data() + pos, 0, level, true);
+            check_err(block.err, "deflate");
+            zip_emit(block.out.data(), block.out.size());
+        }
+        unsigned char trailer[4] = {
+            (unsigned char) (zip_par_adler >> 24), (unsigned char) (zip_par_adler >> 16),
+            (unsigned char) (zip_par_adler >> 8), (unsigned char) zip_par_adler
+        };
+        zip_emit(trailer, 4);
+        xfflush(pdffile);
+        zip_par_data.clear();
+        zip_par_window = 0;
+        zip_par_started = false;
+        return;
+    }
+    /* keep the window for the next block */
+    size_t keep = std::min<size_t>(pos, ZIP_WINDOW_SIZE);
+    zip_par_data.erase(zip_par_data.begin(), zip_par_data.begin() + (pos - keep));
+    zip_par_window = keep;
+}
+
+static void zip_parallel(Bytef * data, uInt size, boolean finish)
+{
+    size_t threads = PDFTEXAPP.GetZipThreads();
+    zip_par_data.insert(zip_par_data.end(), data, data + size);
+    size_t pending = zip_par_data.size() - zip_par_window;
+    if (!finish) {
+        if (pending >= threads * ZIP_BLOCK_SIZE)
+            zip_par_flush(false);
+        return;
+    }
+    if (!zip_par_started && pending < 2 * ZIP_BLOCK_SIZE) {
+        /* not worth it */
+        zip_deflate(zip_par_data.data(), (uInt) zip_par_data.size(), true);
+        zip_par_data.clear();
+        return;
+    }
+    zip_par_flush(true);
+}
+
+static void zip_compress(Bytef * data, uInt size, boolean finish)
+{
+    if (PDFTEXAPP.GetZipThreads() > 1)
+        zip_parallel(data, size, finish);
+    else
+        zip_deflate(data, size, finish);
+}
+
+void zip_cache_begin(void)
+{
+    zip_cache_active = true;
+    zip_cache_bypass = false;
+    zip_cache_data.clear();
+}
+
+void zip_cache_end(void)
+{
+    zip_cache_active = false;
+    zip_cache_bypass = false;
+    zip_cache_data.clear();
+    zip_cache_data.shrink_to_fit();
+}
+
+static MiKTeX::Util::PathName zip_cache_file(int level)
+{
+    MiKTeX::Core::MD5Builder md5Builder;
+    md5Builder.Update(zip_cache_data.data(), zip_cache_data.size());
+    std::string levelString = fmt::format("/{0}", level);
+    md5Builder.Update(levelString.c_str(), levelString.length());
+    MiKTeX::Util::PathName path = MIKTEX_SESSION()->GetSpecialPath(MiKTeX::Configuration::SpecialPath::DataRoot)
+        / MIKTEX_PATH_PDFTEX_CACHE_DIR / md5Builder.Final().ToString();
+    path.AppendExtension(".z");
+    return path;
+}
+
+static void zip_cache_write(boolean finish)
+{
+    MiKTeX::Util::PathName cachedFile;
+    std::vector<unsigned char> compressed;
+    zip_cache_data.insert(zip_cache_data.end(), pdfbuf, pdfbuf + pdfptr);
+    if (!finish) {
+        if (zip_cache_data.size() > ZIP_CACHE_MAX_SIZE) {
+            /* too large to be kept in memory: compress as usual */
+            zip_cache_bypass = true;
+            zip_compress(zip_cache_data.data(), (uInt) zip_cache_data.size(), false);
+            zip_cache_data.clear();
+        }
+        return;
+    }
+    try {
+        cachedFile = zip_cache_file(getpdfcompresslevel());
+        if (MiKTeX::Core::File::Exists(cachedFile))
+            compressed = MiKTeX::Core::File::ReadAllBytes(cachedFile);
+    } catch (const MiKTeX::Core::MiKTeXException &) {
+        compressed.clear();
+    }
+    if (!compressed.empty()) {
+        pdfgone += xfwrite(compressed.data(), 1, compressed.size(), pdffile);
+        pdflastbyte = compressed.back();
+        xfflush(pdffile);
+        pdfstreamlength = compressed.size();
+    } else {
+        zip_capture = &compressed;
+        zip_compress(zip_cache_data.data(), (uInt) zip_cache_data.size(), true);
+        zip_capture = NULL;
+        if (!cachedFile.Empty()) {
+            try {
+                MiKTeX::Core::Directory::Create(cachedFile.GetDirectoryName());
+                MiKTeX::Util::PathName newPath = cachedFile;
+                newPath.AppendExtension(fmt::format(".{0}", MiKTeX::Core::Process::GetCurrentProcess()->GetSystemId()));
+                MiKTeX::Core::File::WriteBytes(newPath, compressed);
+                MiKTeX::Core::File::Move(newPath, cachedFile, { MiKTeX::Core::FileMoveOption::ReplaceExisting });
+            } catch (const MiKTeX::Core::MiKTeXException &) {
+                /* the cache is an optimization: the stream has been written */
+            }
+        }
+    }
+    zip_cache_data.clear();
+}
+
 void writezip(boolean finish)
+{
+    if (zip_cache_active && !zip_cache_bypass) {
+        zip_cache_write(finish);
+        return;
+    }
+    zip_compress(pdfbuf, pdfptr, finish);
+    if (finish)
+        zip_cache_bypass = false;
+}
+
+static void zip_deflate(Bytef * data, uInt size, boolean finish)
+#else
+void writezip(boolean finish)
+#endif
 {
     int err;
     static int level_old = 0;
@@ -63,10 +335,19 @@ void writezip(boolean finish)
         c_stream.avail_out = ZIP_BUF_SIZE;
     }
     assert(zipbuf != NULL);
+#if defined(MIKTEX)
+    c_stream.next_in = data;
+    c_stream.avail_in = size;
+#else
     c_stream.next_in = pdfbuf;
     c_stream.avail_in = pdfptr;
+#endif
     for (;;) {
         if (c_stream.avail_out == 0) {
+#if defined(MIKTEX)
+            if (zip_capture != NULL)
+                zip_capture->insert(zip_capture->end(), zipbuf, zipbuf + ZIP_BUF_SIZE);
+#endif
             pdfgone += xfwrite(zipbuf, 1, ZIP_BUF_SIZE, pdffile);
             pdflastbyte = zipbuf[ZIP_BUF_SIZE - 1];     /* not needed */
             c_stream.next_out = (Bytef *) zipbuf;
@@ -81,6 +362,10 @@ void writezip(boolean finish)
     }
     if (finish) {
         if (c_stream.avail_out < ZIP_BUF_SIZE) {        /* at least one byte has been output */
+#if defined(MIKTEX)
+            if (zip_capture != NULL)
+                zip_capture->insert(zip_capture->end(), zipbuf, zipbuf + ZIP_BUF_SIZE - c_stream.avail_out);
+#endif
             pdfgone +=
                 xfwrite(zipbuf, 1, ZIP_BUF_SIZE - c_stream.avail_out, pdffile);
             pdflastbyte = zipbuf[ZIP_BUF_SIZE - c_stream.avail_out - 1];
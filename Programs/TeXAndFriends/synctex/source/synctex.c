@@ -507,6 +507,7 @@ static struct {
     (SYNCTEX_NO_GZ||((synctex_ctxt.options)&2)!=0)
 #   define SYNCTEX_WITH_FORMS (((synctex_ctxt.options)&4)!=0)
 #   define SYNCTEX_H_COMPRESS (((synctex_ctxt.options)&8)!=0)
+#   define SYNCTEX_FAST_GZ (((synctex_ctxt.options)&16)!=0)
 
 static inline void _synctex_read_command_line_option(void) {
 #   if SYNCTEX_DEBUG
@@ -760,8 +761,16 @@ static void *synctex_dot_open(void)
                 SYNCTEX_FILE = fopen(the_busy_name, FOPEN_W_MODE);
                 synctex_ctxt.fprintf = (synctex_fprintf_t) (&fprintf);
             } else {
-                SYNCTEX_FILE = gzopen(the_busy_name, FOPEN_WBIN_MODE);
+                /*  With |synctex_options&16|, trade some file size for
+                 *  speed: the fastest deflate level and a larger buffer,
+                 *  so that zlib compresses less often during shipout. */
+                SYNCTEX_FILE = gzopen(the_busy_name, SYNCTEX_FAST_GZ ? "wb1" : FOPEN_WBIN_MODE);
                 synctex_ctxt.fprintf = (synctex_fprintf_t) (&gzprintf);
+#   if defined(ZLIB_VERNUM) && ZLIB_VERNUM >= 0x1240
+                if (SYNCTEX_FILE && SYNCTEX_FAST_GZ) {
+                    gzbuffer((gzFile)SYNCTEX_FILE, 262144);
+                }
+#   endif
             }
 #   if SYNCTEX_DEBUG
             printf("\nwarning: Synchronize DEBUG: synctex_dot_open 2\n");
@@ -153,6 +153,10 @@ public:
       {
         dvipdfmxArgs.push_back(argv[idx]);
       }
+#if defined(WITH_BUILTIN_DVIPDFMX)
+      extern bool builtinOutputDriver;
+      builtinOutputDriver = false;
+#endif
       break;
     }
     case OPT_PAPERSIZE:
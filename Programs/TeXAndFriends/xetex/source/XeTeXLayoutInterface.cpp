@@ -58,6 +58,43 @@ authorization from the copyright holders.
 #endif
 #include "XeTeXFontMgr.h"
 
+#if defined(MIKTEX)
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+#include <miktex/Trace/TraceStream>
+
+/*******************************************************************/
+/* Shaping cache: the same words are shaped again and again with   */
+/* the same engine (font instance, features, script and language)  */
+/*******************************************************************/
+
+struct ShapedRun
+{
+    hb_segment_properties_t props;
+    std::vector<hb_glyph_info_t> infos;
+    std::vector<hb_glyph_position_t> positions;
+};
+
+struct ShapingCache
+{
+    // key: direction flag, offset, count and the UTF-16 text
+    typedef std::list<std::pair<std::u16string, ShapedRun>> LruList;
+    LruList lru;
+    std::unordered_map<std::u16string, LruList::iterator> index;
+};
+
+// longer runs (whole paragraphs) are unlikely to recur
+static const int32_t SHAPING_CACHE_MAX_TEXT = 64;
+static const size_t SHAPING_CACHE_CAPACITY = 4096;
+
+static unsigned long sShapingCacheHits = 0;
+static unsigned long sShapingCacheMisses = 0;
+#endif
+
 struct XeTeXLayoutEngine_rec
 {
     XeTeXFontInst*  font;
@@ -73,6 +110,9 @@ struct XeTeXLayoutEngine_rec
     float           slant;
     float           embolden;
     hb_buffer_t*    hbBuffer;
+#if defined(MIKTEX)
+    ShapingCache*   shapingCache;
+#endif
 };
 
 /*******************************************************************/
@@ -107,6 +147,12 @@ cacheGlyphBBox(uint16_t fontID, uint16_t glyphID, const GlyphBBox* bbox)
 void
 terminatefontmanager()
 {
+#if defined(MIKTEX)
+    if (sShapingCacheHits + sShapingCacheMisses > 0) {
+        std::unique_ptr<MiKTeX::Trace::TraceStream> traceStream = MiKTeX::Trace::TraceStream::Open(MIKTEX_TRACE_FONTINFO);
+        traceStream->WriteLine("xetex", fmt::format("shaping cache: {0} hits, {1} misses", sShapingCacheHits, sShapingCacheMisses));
+    }
+#endif
     XeTeXFontMgr::Terminate();
 }
 
@@ -645,6 +691,9 @@ createLayoutEngine(PlatformFontRef fontRef, XeTeXFont font, hb_tag_t script, cha
     result->slant = slant;
     result->embolden = embolden;
     result->hbBuffer = hb_buffer_create();
+#if defined(MIKTEX)
+    result->shapingCache = new ShapingCache;
+#endif
 
     // For Graphite fonts treat the language as BCP 47 tag, for OpenType we
     // treat it as a OT language tag for backward compatibility with pre-0.9999
@@ -663,6 +712,9 @@ void
 deleteLayoutEngine(XeTeXLayoutEngine engine)
 {
     hb_buffer_destroy(engine->hbBuffer);
+#if defined(MIKTEX)
+    delete engine->shapingCache;
+#endif
     delete engine->font;
     free(engine->shaper);
 }
@@ -705,6 +757,35 @@ layoutChars(XeTeXLayoutEngine engine, uint16_t chars[], int32_t offset, int32_t
 
     script = hb_ot_tag_to_script (engine->script);
 
+#if defined(MIKTEX)
+    std::u16string key;
+    if (max <= SHAPING_CACHE_MAX_TEXT && engine->shaper != NULL) {
+        key.reserve(max + 3);
+        key.push_back((char16_t) direction);
+        key.push_back((char16_t) offset);
+        key.push_back((char16_t) count);
+        key.append((const char16_t *) chars, max);
+        ShapingCache* cache = engine->shapingCache;
+        auto it = cache->index.find(key);
+        if (it != cache->index.end()) {
+            sShapingCacheHits++;
+            cache->lru.splice(cache->lru.begin(), cache->lru, it->second);
+            const ShapedRun& run = it->second->second;
+            int glyphCount = (int) run.infos.size();
+            hb_buffer_reset(engine->hbBuffer);
+            hb_buffer_set_segment_properties(engine->hbBuffer, &run.props);
+            hb_buffer_pre_allocate(engine->hbBuffer, glyphCount);
+            for (int i = 0; i < glyphCount; i++)
+                hb_buffer_add(engine->hbBuffer, run.infos[i].codepoint, run.infos[i].cluster);
+            hb_buffer_set_content_type(engine->hbBuffer, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+            memcpy(hb_buffer_get_glyph_infos(engine->hbBuffer, NULL), run.infos.data(), glyphCount * sizeof(hb_glyph_info_t));
+            memcpy(hb_buffer_get_glyph_positions(engine->hbBuffer, NULL), run.positions.data(), glyphCount * sizeof(hb_glyph_position_t));
+            return glyphCount;
+        }
+        sShapingCacheMisses++;
+    }
+#endif
+
     hb_buffer_reset(engine->hbBuffer);
 
 #if !HB_VERSION_ATLEAST(2,5,0)
@@ -759,6 +840,24 @@ layoutChars(XeTeXLayoutEngine engine, uint16_t chars[], int32_t offset, int32_t
 
     int glyphCount = hb_buffer_get_length(engine->hbBuffer);
 
+#if defined(MIKTEX)
+    if (!key.empty()) {
+        ShapingCache* cache = engine->shapingCache;
+        if (cache->lru.size() >= SHAPING_CACHE_CAPACITY) {
+            cache->index.erase(cache->lru.back().first);
+            cache->lru.pop_back();
+        }
+        cache->lru.emplace_front(key, ShapedRun());
+        ShapedRun& run = cache->lru.front().second;
+        hb_buffer_get_segment_properties(engine->hbBuffer, &run.props);
+        hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(engine->hbBuffer, NULL);
+        hb_glyph_position_t* positions = hb_buffer_get_glyph_positions(engine->hbBuffer, NULL);
+        run.infos.assign(infos, infos + glyphCount);
+        run.positions.assign(positions, positions + glyphCount);
+        cache->index[key] = cache->lru.begin();
+    }
+#endif
+
 #ifdef DEBUG
     char buf[1024];
     unsigned int consumed;
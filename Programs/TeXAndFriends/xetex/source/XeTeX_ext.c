@@ -66,8 +66,10 @@ authorization from the copyright holders.
 #define C4PEXTERN extern
 #include "miktex-xetex.h"
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/File>
 #include <miktex/Core/FileType>
 #include <miktex/Core/Process>
+#include <miktex/Core/TemporaryFile>
 #include <unistd.h>
 #else
 #define EXTERN extern
@@ -175,6 +177,12 @@ std::vector<std::string> dvipdfmxArgs = {
   "-E"
 };
 std::unique_ptr<MiKTeX::Core::Process> dvipdfmxProcess;
+#if defined(WITH_BUILTIN_DVIPDFMX)
+extern "C" MIKTEXDLLIMPORT int MIKTEXCEECALL MiKTeX_DVIPDFMX(int argc, char** argv);
+bool builtinOutputDriver = true;
+std::unique_ptr<MiKTeX::Core::TemporaryFile> xdvFile;
+MiKTeX::Util::PathName pdfPath;
+#endif
 #else
 const char *outputdriver = "xdvipdfmx -q -E"; /* default to portable xdvipdfmx driver */
 #endif
@@ -2742,6 +2750,18 @@ boolean open_dvi_output(C4P::FileRoot& dviFile)
     }
     return done;
   }
+#if defined(WITH_BUILTIN_DVIPDFMX)
+  else if (builtinOutputDriver)
+  {
+    // dvipdfmx needs the postamble, i.e., it reads the XDV file when it is
+    // complete
+    xdvFile = MiKTeX::Core::TemporaryFile::Create();
+    dviFile.Attach(MiKTeX::Core::File::Open(xdvFile->GetPathName(), MiKTeX::Core::FileMode::Create, MiKTeX::Core::FileAccess::Write, false), true);
+    pdfPath = MiKTeX::TeXAndFriends::WebAppInputLine::GetWebAppInputLine()->GetOutputDirectory() / MiKTeX::TeXAndFriends::WebAppInputLine::GetWebAppInputLine()->GetNameOfFile().ToString();
+    MiKTeX::TeXAndFriends::WebAppInputLine::GetWebAppInputLine()->SetNameOfFile(pdfPath);
+    return 1;
+  }
+#endif
   else
   {
     MiKTeX::Util::PathName dvipdfmx;
@@ -2888,6 +2908,33 @@ int dviclose(C4P::FileRoot& dviFile)
     MiKTeX::TeXAndFriends::WebAppInputLine::GetWebAppInputLine()->CloseFile(dviFile);
     return 0;
   }
+#if defined(WITH_BUILTIN_DVIPDFMX)
+  else if (xdvFile != nullptr)
+  {
+    fclose(dviFile);
+    dviFile.Attach(nullptr, true);
+    std::vector<std::string> args;
+    args.push_back(dvipdfmxExecutable);
+    args.insert(args.end(), dvipdfmxArgs.begin(), dvipdfmxArgs.end());
+    args.push_back("-o");
+    args.push_back(pdfPath.ToString());
+    if (papersize != nullptr)
+    {
+      args.push_back("-p");
+      args.push_back(papersize);
+    }
+    args.push_back(xdvFile->GetPathName().ToString());
+    std::vector<char*> argv;
+    for (std::string& arg : args)
+    {
+      argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+    int ret = MiKTeX_DVIPDFMX(static_cast<int>(args.size()), &argv[0]);
+    xdvFile = nullptr;
+    return ret;
+  }
+#endif
   else
   {
     fclose(dviFile);
@@ -176,6 +176,9 @@ extern const char *papersize;
 #if defined(MIKTEX)
 extern std::string dvipdfmxExecutable;
 extern std::vector<std::string> dvipdfmxArgs;
+#if defined(WITH_BUILTIN_DVIPDFMX)
+extern bool builtinOutputDriver;
+#endif
 #else
 extern const char *outputdriver;
 #endif
@@ -49,6 +49,11 @@ extern "C" {
 
 #include "XeTeX_ext.h"
 
+#if defined(MIKTEX)
+#include <string>
+#include <miktex/Core/Session>
+#endif
+
 /* use our own fmin function because it seems to be missing on certain platforms */
 inline double
 my_fmin(double x, double y)
@@ -56,8 +61,27 @@ my_fmin(double x, double y)
 	return (x < y) ? x : y;
 }
 
+#if defined(MIKTEX)
+static void
+box_from_rect(const pprect* r, ppint RotAngle, realrect* box)
+{
+	if (RotAngle == 90 || RotAngle == 270) {
+		box->wd = 72.27 / 72 * fabs(r->ry - r->ly);
+		box->ht = 72.27 / 72 * fabs(r->rx - r->lx);
+	} else {
+		box->wd = 72.27 / 72 * fabs(r->rx - r->lx);
+		box->ht = 72.27 / 72 * fabs(r->ry - r->ly);
+	}
+	box->x  = 72.27 / 72 * my_fmin(r->lx, r->rx);
+	box->y  = 72.27 / 72 * my_fmin(r->ly, r->ry);
+}
+
+static int
+pdf_get_rect_uncached(char* filename, int page_num, int pdf_box, realrect* box, MiKTeX::Core::PdfBoxInfo& info)
+#else
 int
 pdf_get_rect(char* filename, int page_num, int pdf_box, realrect* box)
+#endif
 	/* return the box converted to TeX points */
 {
 	ppdoc*	doc = ppdoc_load(filename);
@@ -132,6 +156,14 @@ pdf_get_rect(char* filename, int page_num, int pdf_box, realrect* box)
 	RotAngle = RotAngle % 360;
 	if (RotAngle < 0)
 		RotAngle += 360;
+#if defined(MIKTEX)
+	info.llx = r->lx;
+	info.lly = r->ly;
+	info.urx = r->rx;
+	info.ury = r->ry;
+	info.rotate = (int)RotAngle;
+	info.pageCount = pages;
+#endif
 	if (RotAngle == 90 || RotAngle == 270) {
 		box->wd = 72.27 / 72 * fabs(r->ry - r->ly);
 		box->ht = 72.27 / 72 * fabs(r->rx - r->lx);
@@ -147,10 +179,43 @@ pdf_get_rect(char* filename, int page_num, int pdf_box, realrect* box)
 	return 0;
 }
 
+#if defined(MIKTEX)
+/* the box and the rotation of the page are all we need: with a cached box,
+   the PDF file is not parsed again */
+int
+pdf_get_rect(char* filename, int page_num, int pdf_box, realrect* box)
+{
+	std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
+	std::string boxName = "xetex/" + std::to_string(pdf_box);
+	MiKTeX::Core::PdfBoxInfo info;
+	if (session->TryGetPdfBoxInfo(filename, page_num, boxName, info)) {
+		pprect Rect;
+		Rect.lx = info.llx;
+		Rect.ly = info.lly;
+		Rect.rx = info.urx;
+		Rect.ry = info.ury;
+		box_from_rect(&Rect, info.rotate, box);
+		return 0;
+	}
+	int err = pdf_get_rect_uncached(filename, page_num, pdf_box, box, info);
+	if (err == 0) {
+		session->SetPdfBoxInfo(filename, page_num, boxName, info);
+	}
+	return err;
+}
+#endif
+
 int
 pdf_count_pages(char* filename)
 {
 	int	pages = 0;
+#if defined(MIKTEX)
+	std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
+	MiKTeX::Core::PdfBoxInfo info;
+	if (session->TryGetPdfBoxInfo(filename, 0, "xetex/pages", info)) {
+		return info.pageCount;
+	}
+#endif
 	ppdoc*	doc = ppdoc_load(filename);
 
 	if (!doc) {
@@ -159,6 +224,10 @@ pdf_count_pages(char* filename)
 
 	pages = ppdoc_page_count(doc);
 	if (doc) ppdoc_free(doc);
+#if defined(MIKTEX)
+	info.pageCount = pages;
+	session->SetPdfBoxInfo(filename, 0, "xetex/pages", info);
+#endif
 
 	return pages;
 }
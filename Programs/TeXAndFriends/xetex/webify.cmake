@@ -48,6 +48,10 @@ set(miktex_tex_change_files
     ${MIKTEX_TEX_FINISH_CH}
 )
 
+if(WITH_TEX_PREFETCH)
+    list(APPEND miktex_tex_change_files ${MIKTEX_TEX_PREFETCH_CH})
+endif()
+
 list(APPEND web_files ${CMAKE_CURRENT_SOURCE_DIR}/source/xetex.web)
 
 add_custom_command(
@@ -0,0 +1,89 @@
+/**
+ * @file miktex/chktex.cpp
+ * @author Christian Schenk
+ * @brief MiKTeX ChkTeX job runner
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+#include "chktex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+// each process gets a contiguous run of files, so that writing the outputs
+// one after the other gives the same order as checking the files in turn;
+// more runs than processes keep the processes busy if the files differ in
+// size
+constexpr size_t RUNS_PER_JOB = 4;
+
+int miktex_chktex_run_jobs(int argc, char** argv, int firstFile, int jobs, FILE* outputFile)
+{
+  try
+  {
+    PathName chktexExe = MIKTEX_SESSION()->GetMyProgramFile(true);
+    size_t nFiles = argc - firstFile;
+    size_t nRuns = min(nFiles, jobs * RUNS_PER_JOB);
+    vector<ProcessStartInfo> startInfos;
+    size_t fileIdx = firstFile;
+    for (size_t run = 0; run < nRuns; ++run)
+    {
+      ProcessStartInfo startInfo(chktexExe);
+      startInfo.Arguments.push_back(argv[0]);
+      for (int idx = 1; idx < firstFile; ++idx)
+      {
+        if (idx + 1 < firstFile || strcmp(argv[idx], "--") != 0)
+        {
+          startInfo.Arguments.push_back(argv[idx]);
+        }
+      }
+      // the last --jobs wins
+      startInfo.Arguments.push_back("--quiet");
+      startInfo.Arguments.push_back("--jobs=1");
+      startInfo.Arguments.push_back("--");
+      size_t end = fileIdx + nFiles / nRuns + (run < nFiles % nRuns ? 1 : 0);
+      for (; fileIdx < end; ++fileIdx)
+      {
+        startInfo.Arguments.push_back(argv[fileIdx]);
+      }
+      startInfos.push_back(startInfo);
+    }
+    int exitCode = EXIT_SUCCESS;
+    for (const ProcessRunResult& result : Process::RunAll(startInfos, jobs))
+    {
+      fputs(result.output.c_str(), outputFile);
+      if (result.exitStatus != ProcessExitStatus::Exited)
+      {
+        exitCode = EXIT_FAILURE;
+      }
+      else if (result.exitCode != EXIT_SUCCESS)
+      {
+        exitCode = result.exitCode;
+      }
+    }
+    return exitCode;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    fprintf(stderr, "chktex: %s\n", ex.GetErrorMessage().c_str());
+    return EXIT_FAILURE;
+  }
+}
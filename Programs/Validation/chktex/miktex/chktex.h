@@ -0,0 +1,28 @@
+/**
+ * @file miktex/chktex.h
+ * @author Christian Schenk
+ * @brief MiKTeX ChkTeX job runner
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Checks argv[firstFile..argc-1] with up to `jobs` chktex processes at a
+   time and writes their reports to `outputFile`, in the order of the
+   files.  Returns the exit code. */
+int miktex_chktex_run_jobs(int argc, char** argv, int firstFile, int jobs, FILE* outputFile);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -38,6 +38,9 @@
 #include "FindErrs.h"
 #include "Resource.h"
 #include <string.h>
+#if defined(MIKTEX)
+#include "miktex/chktex.h"
+#endif
 
 #undef MSG
 #define MSG(num, type, inuse, ctxt, text) {(enum ErrNum)num, type, inuse, ctxt, text},
@@ -179,6 +182,10 @@ static const char *HelpText =
     "Miscellaneous switches:\n"
     "~~~~~~~~~~~~~~~~~~~~~~~\n"
     "    -W  --version   : Version information\n"
+#if defined(MIKTEX)
+    "    -j  --jobs      : Check the files with up to <n> processes at a\n"
+    "                      time. The report is in the order of the files.\n"
+#endif
     "\n"
     "----------------------------------------------------------------------\n"
     "If no LaTeX files are specified on the command line, we will read from\n"
@@ -207,6 +214,10 @@ enum Quote Quote;
 
 enum CmdSpace CmdSpace;
 
+#if defined(MIKTEX)
+static long Jobs = 1;
+#endif
+
 char VerbNormal[] = "%k %n in %f line %l: %m\n" "%r%s%t\n" "%u\n";
 
 #define DEF(type, name, value)  type name = value
@@ -484,6 +495,15 @@ int main(int argc, char **argv)
             if (TabSize && isdigit((unsigned char)*TabSize))
                 Tab = strtol(TabSize, NULL, 10);
 
+#if defined(MIKTEX)
+            /* The reports of the processes are collected on stdout. */
+            if (Jobs > 1 && !UsingStdIn && argc - CurArg > 1 && !*OutputName)
+            {
+                if (OpenOut())
+                    retval = miktex_chktex_run_jobs(argc, argv, CurArg, (int) Jobs, OutputFile);
+            }
+            else
+#endif
             if (OpenOut())
             {
                 for (;;)
@@ -855,6 +875,9 @@ static int ParseArgs(int argc, char **argv)
         {"tictoc", optional_argument, 0L, 't'},
         {"headererr", optional_argument, 0L, 'H'},
         {"version", no_argument, 0L, 'W'},
+#if defined(MIKTEX)
+        {"jobs", required_argument, 0L, 'j'},
+#endif
 
         {0L, 0L, 0L, 0L}
     };
@@ -878,7 +901,11 @@ static int ParseArgs(int argc, char **argv)
 
     while (!ArgErr &&
            ((c = getopt_long((int) argc, argv,
+#if defined(MIKTEX)
+                             "b::d:e:f:g::hH::I::ij:l:m:n:Lo:p:qrs:S:t::v::V::w:Wx::",
+#else
                              "b::d:e:f:g::hH::I::il:m:n:Lo:p:qrs:S:t::v::V::w:Wx::",
+#endif
                              long_options, &option_index)) != EOF))
     {
         while (c)
@@ -1053,6 +1080,13 @@ static int ParseArgs(int argc, char **argv)
             case 'H':
                 nextc = ParseBoolArg(&HeadErrOut, &optarg);
                 break;
+#if defined(MIKTEX)
+            case 'j':
+                nextc = ParseNumArg(&Jobs, 1, &optarg);
+                if (Jobs < 1)
+                    Jobs = 1;
+                break;
+#endif
             case 'W':
                 printf("%s", Banner);
                 exit(EXIT_SUCCESS);
@@ -25,14 +25,18 @@ set(MIKTEX_CONFIG_VALUE_ALLOW_UNRESTRICTED_SUPER_USER "AllowUnrestrictedSuperUse
 set(MIKTEX_CONFIG_VALUE_ALLOWUNSAFEINPUTFILES "AllowUnsafeInputFiles")
 set(MIKTEX_CONFIG_VALUE_ALLOWUNSAFEOUTPUTFILES "AllowUnsafeOutputFiles")
 set(MIKTEX_CONFIG_VALUE_ALTEXTENSIONS "AltExtensions[]")
+set(MIKTEX_CONFIG_VALUE_ARCHIVE_CACHE_DIRECTORY "ArchiveCacheDirectory")
 set(MIKTEX_CONFIG_VALUE_AUTOADMIN "AutoAdmin")
 set(MIKTEX_CONFIG_VALUE_AUTOINSTALL "AutoInstall")
+set(MIKTEX_CONFIG_VALUE_BACKGROUND_MAINTENANCE "BackgroundMaintenance")
+set(MIKTEX_CONFIG_VALUE_CACHE_FILE_DIGESTS "CacheFileDigests")
 set(MIKTEX_CONFIG_VALUE_COMMONLINKTARGETDIRECTORY "CommonLinkTargetDirectory")
 set(MIKTEX_CONFIG_VALUE_COMMONLOGDIRECTORY "CommonLogDirectory")
 set(MIKTEX_CONFIG_VALUE_COMMON_CONFIG "CommonConfig")
 set(MIKTEX_CONFIG_VALUE_COMMON_DATA "CommonData")
 set(MIKTEX_CONFIG_VALUE_COMMON_INSTALL "CommonInstall")
 set(MIKTEX_CONFIG_VALUE_COMMON_ROOTS "CommonRoots")
+set(MIKTEX_CONFIG_VALUE_CONCURRENT_DOWNLOADS "ConcurrentDownloads")
 set(MIKTEX_CONFIG_VALUE_CONFIG "Config")
 set(MIKTEX_CONFIG_VALUE_CREATEAUXDIRECTORY "CreateAuxDirectory")
 set(MIKTEX_CONFIG_VALUE_CREATEOUTPUTDIRECTORY "CreateOutputDirectory")
@@ -41,6 +45,10 @@ set(MIKTEX_CONFIG_VALUE_DESTDIR "DestDir")
 set(MIKTEX_CONFIG_VALUE_EDITOR "Editor")
 set(MIKTEX_CONFIG_VALUE_ENVVARS "EnvVars[]")
 set(MIKTEX_CONFIG_VALUE_EXTENSIONS "Extensions[]")
+set(MIKTEX_CONFIG_VALUE_EXTRACT_WHILE_DOWNLOADING "ExtractWhileDownloading")
+set(MIKTEX_CONFIG_VALUE_FIND_FILE_CACHE "FindFileCache")
+set(MIKTEX_CONFIG_VALUE_FNDB_THREADS "FndbThreads")
+set(MIKTEX_CONFIG_VALUE_FONT_METRIC_CACHE "FontMetricCache")
 set(MIKTEX_CONFIG_VALUE_FORCE_LOCAL_SERVER "ForceLocalServer")
 set(MIKTEX_CONFIG_VALUE_GUESS_INPUT_KANJI_ENCODING "GuessInputKanjiEncoding")
 set(MIKTEX_CONFIG_VALUE_GUI_FRAMEWORK "GUIFramework")
@@ -55,12 +63,16 @@ set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE "LastUserUpdate")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_CHECK "LastUserUpdateCheck")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_DB  "LastUserUpdateDb")
 set(MIKTEX_CONFIG_VALUE_LOCAL_REPOSITORY "LocalRepository")
+set(MIKTEX_CONFIG_VALUE_MAINTENANCE_CHECK_INTERVAL "MaintenanceCheckInterval")
+set(MIKTEX_CONFIG_VALUE_MAP_MEMORY_DUMP_FILES "MapMemoryDumpFiles")
+set(MIKTEX_CONFIG_VALUE_MEMORY_STATISTICS "MemoryStatistics")
 set(MIKTEX_CONFIG_VALUE_MIKTEXDIRECT_ROOT "MiKTeXDirectRoot")
 set(MIKTEX_CONFIG_VALUE_NO_REGISTRY "NoRegistry")
 set(MIKTEX_CONFIG_VALUE_OTHER_COMMON_ROOTS "OtherCommonRoots")
 set(MIKTEX_CONFIG_VALUE_OTHER_USER_ROOTS "OtherUserRoots")
 set(MIKTEX_CONFIG_VALUE_PARSE_FIRST_LINE "ParseFirstLine")
 set(MIKTEX_CONFIG_VALUE_PATHS "Paths[]")
+set(MIKTEX_CONFIG_VALUE_PDF_BOX_CACHE "PdfBoxCache")
 set(MIKTEX_CONFIG_VALUE_PK_FN_TEMPLATE "PKFnTemplate")
 set(MIKTEX_CONFIG_VALUE_PREFER_MIKTEX_GHOSTSCRIPT "PreferMiKTeXGhostscript")
 set(MIKTEX_CONFIG_VALUE_PROXY_AUTH_REQ "ProxyAuthReq")
@@ -74,9 +86,11 @@ set(MIKTEX_CONFIG_VALUE_REPOSITORY_RELEASE_STATE "RepositoryReleaseState")
 set(MIKTEX_CONFIG_VALUE_REPOSITORY_TYPE "RepositoryType")
 set(MIKTEX_CONFIG_VALUE_SHARED_SETUP "SharedSetup")
 set(MIKTEX_CONFIG_VALUE_SHELLCOMMANDMODE "ShellCommandMode")
+set(MIKTEX_CONFIG_VALUE_SNAPSHOT_VERSION "SnapshotVersion")
 set(MIKTEX_CONFIG_VALUE_STARTUP_FILE "StartupFile")
 set(MIKTEX_CONFIG_VALUE_TEMPDIR "TempDir")
 set(MIKTEX_CONFIG_VALUE_TRACE "Trace")
+set(MIKTEX_CONFIG_VALUE_TRUST_FNDB "TrustFndb")
 set(MIKTEX_CONFIG_VALUE_UI_LANGUAGES "UILanguages[]")
 set(MIKTEX_CONFIG_VALUE_USERINFO_FILE "UserInfoFile")
 set(MIKTEX_CONFIG_VALUE_USERLINKTARGETDIRECTORY "UserLinkTargetDirectory")
@@ -86,4 +100,6 @@ set(MIKTEX_CONFIG_VALUE_USER_DATA "UserData")
 set(MIKTEX_CONFIG_VALUE_USER_INSTALL "UserInstall")
 set(MIKTEX_CONFIG_VALUE_USER_ROOTS "UserRoots")
 set(MIKTEX_CONFIG_VALUE_USE_PROXY "UseProxy")
+set(MIKTEX_CONFIG_VALUE_USE_SESSION_SERVICE "UseSessionService")
 set(MIKTEX_CONFIG_VALUE_VERSION "Version")
+set(MIKTEX_CONFIG_VALUE_WRITE_BEHIND_OUTPUT "WriteBehindOutput")
@@ -50,6 +50,7 @@ define_library(core)
 define_library(curl)
 define_library(dib)
 define_library(dvi)
+define_library(dvipdfmx)
 define_library(egl_registry)
 define_library(expat)
 define_library(extractor)
@@ -17,6 +17,7 @@ set(MIKTEX_REL_AXOHELP_DIR              "Programs/Converters/axohelp")
 set(MIKTEX_REL_BIBARTS_DIR              "Programs/Bibliography/bibarts")
 set(MIKTEX_REL_BIBTEX_DIR               "Programs/Bibliography/bibtex")
 set(MIKTEX_REL_BIBTEXX_DIR              "Programs/Bibliography/bibtex-x")
+set(MIKTEX_REL_BENCHMARKS_DIR           "Programs/MiKTeX/benchmarks")
 set(MIKTEX_REL_BUILD_TOOLS_ETC_DIR      "BuildUtilities/etc")
 set(MIKTEX_REL_BZIP2_DIR                "Libraries/3rd/bzip2")
 set(MIKTEX_REL_C4P_DIR                  "BuildUtilities/c4p")
@@ -218,6 +219,7 @@ set(MIKTEX_TEX_FINISH_CH        "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/mikte
 set(MIKTEX_TEX_HASH_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-hash.ch")
 set(MIKTEX_TEX_HYPH_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-hyph.ch")
 set(MIKTEX_TEX_POOL_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-pool.ch")
+set(MIKTEX_TEX_PREFETCH_CH      "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-prefetch.ch")
 set(MIKTEX_TEX_QUIET_CH         "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-quiet.ch")
 set(MIKTEX_TEX_SRC_CH           "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-src.ch")
 set(MIKTEX_TEX_STAT_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-stat.ch")